@@ -3,7 +3,9 @@
 //==============================================================================
 
 #include <stdio.h>
+#include <stdlib.h>
 #include <string.h>
+#include <stdatomic.h>
 
 #include <esp_log.h>
 #include <esp_timer.h>
@@ -15,6 +17,7 @@
 #include <freertos/queue.h>
 
 #include "hdw-btn.h"
+#include "trace.h"
 
 //==============================================================================
 // Defines
@@ -23,6 +26,21 @@
 /// The number of samples kept in history to debounce buttons
 #define DEBOUNCE_HIST_LEN 5
 
+/// How often the touchpad is sampled, in microseconds
+#define TOUCH_SAMPLE_PERIOD_US 5000
+
+/// The number of touch events which can be queued. Must be a power of two
+#define TOUCH_QUEUE_LEN 32
+
+/// The filter strength used until setTouchFilter() is called
+#define TOUCH_FILTER_DEFAULT 2
+
+/// Angle changes larger than this, in degrees, skip the filter so fast swipes don't lag
+#define TOUCH_FILTER_SNAP_PHI 45
+
+/// Radius changes larger than this skip the filter so fast swipes don't lag
+#define TOUCH_FILTER_SNAP_R 256
+
 //==============================================================================
 // Structs
 //==============================================================================
@@ -54,10 +72,35 @@ static int numTouchPads;
 static touch_pad_t* touchPads;
 // Used in getBaseTouchVals() to get zeroed touch sensor values
 static int32_t* baseOffsets = NULL;
+/// Whether baseOffsets has been set from a valid reading yet
+static bool baseOffsetsSet = false;
 
 /// Timer handle used to periodically poll buttons
 static gptimer_handle_t btnTimer = NULL;
 
+/// Timer handle used to periodically sample the touchpad
+static esp_timer_handle_t touchTimer = NULL;
+
+/// Touch events written by touchSampleCb() and read by checkTouchQueue(). The producer only writes touchQueueHead
+static touchEvt_t touchQueue[TOUCH_QUEUE_LEN];
+/// The number of touch events ever written to touchQueue
+static atomic_uint touchQueueHead;
+/// The number of touch events ever read from touchQueue
+static atomic_uint touchQueueTail;
+
+/// The most recent filtered touch sample, read by getTouchJoystick()
+static touchEvt_t touchLatest;
+/// Odd while touchLatest is being written, incremented by two for each new sample
+static atomic_uint touchLatestSeq;
+/// The value of touchLatestSeq when getTouchJoystick() last returned a touch, so each sample is marked consumed once
+static unsigned int touchConsumedSeq = 0;
+
+/// How strongly touch samples are smoothed, see setTouchFilter()
+static volatile uint8_t touchFilterStrength = TOUCH_FILTER_DEFAULT;
+
+/// The time of the earliest input event consumed since takeInputConsumedTime() was last called, or 0
+static uint32_t inputConsumedTime = 0;
+
 //==============================================================================
 // Prototypes
 //==============================================================================
@@ -70,6 +113,10 @@ static void initTouchSensor(touch_pad_t* _touchPads, uint8_t _numTouchPads, floa
 
 static int getTouchRawValues(uint32_t* rawValues, int maxPads);
 static int getBaseTouchVals(int32_t* data, int count);
+static int computeTouchCentroid(int32_t* phi, int32_t* r, int32_t* intensity);
+static void filterTouchSample(touchEvt_t* filtered, const touchEvt_t* sample, int32_t* state);
+static void touchSampleCb(void* arg);
+static void markInputConsumed(uint32_t time);
 
 //==============================================================================
 // Functions
@@ -98,6 +145,10 @@ void initButtons(gpio_num_t* pushButtons, uint8_t numPushButtons, touch_pad_t* t
  */
 void deinitButtons(void)
 {
+    ESP_ERROR_CHECK(esp_timer_stop(touchTimer));
+    ESP_ERROR_CHECK(esp_timer_delete(touchTimer));
+    touchTimer = NULL;
+
     ESP_ERROR_CHECK(gptimer_stop(btnTimer));
     ESP_ERROR_CHECK(gptimer_disable(btnTimer));
 
@@ -110,6 +161,8 @@ void deinitButtons(void)
     vQueueDelete(btn_evt_queue);
     heap_caps_free(touchPads);
     heap_caps_free(baseOffsets);
+    baseOffsets    = NULL;
+    baseOffsetsSet = false;
 }
 
 /**
@@ -137,6 +190,7 @@ bool checkButtonQueue(buttonEvt_t* evt)
             evt->down   = (buttonStates > oldButtonStates);
             evt->state  = buttonStates;
             evt->time   = gpio_evt.time;
+            markInputConsumed(evt->time);
 
             // Debug print
             // ESP_LOGE("BTN", "Bit 0x%02x was %s, buttonStates is %02x",
@@ -152,6 +206,83 @@ bool checkButtonQueue(buttonEvt_t* evt)
     return false;
 }
 
+/**
+ * @brief Service the queue of touch events sampled in the background
+ * This only returns a single event, even if there are multiple in the queue
+ * This function may be called multiple times in a row to completely empty the queue
+ *
+ * @param evt If an event occurred, return it through this argument
+ * @return true if an event occurred, false if nothing happened
+ */
+bool checkTouchQueue(touchEvt_t* evt)
+{
+    unsigned int tail = atomic_load_explicit(&touchQueueTail, memory_order_relaxed);
+    if (tail == atomic_load_explicit(&touchQueueHead, memory_order_acquire))
+    {
+        // Nothing happened
+        return false;
+    }
+
+    *evt = touchQueue[tail % TOUCH_QUEUE_LEN];
+    atomic_store_explicit(&touchQueueTail, tail + 1, memory_order_release);
+    markInputConsumed(evt->time);
+    TRACE_INSTANT(TRACE_TOUCH, evt->phi);
+    return true;
+}
+
+/**
+ * @brief Discard all queued touch events. The system calls this when switching Swadge modes, so a mode doesn't receive
+ * events queued before it started. If the queue filled while nobody read it, newer events were dropped, so a mode which
+ * stops reading the queue for a while should call this before reading it again.
+ */
+void flushTouchQueue(void)
+{
+    // Only the consumer writes the tail, so it's safe to skip to the head
+    atomic_store_explicit(&touchQueueTail, atomic_load_explicit(&touchQueueHead, memory_order_acquire),
+                          memory_order_release);
+}
+
+/**
+ * @brief Set how strongly touch samples are smoothed before they are reported
+ *
+ * Each sample moves the reported touch 1/(2^strength) of the way toward the measured touch. Large jumps, like the start
+ * of a fast swipe, are reported immediately regardless of strength.
+ *
+ * @param strength 0 to report raw samples, up to 4 for the most smoothing
+ */
+void setTouchFilter(uint8_t strength)
+{
+    touchFilterStrength = (strength > 4) ? 4 : strength;
+}
+
+/**
+ * @brief Get and clear the time of the earliest button or touch event consumed since this was last called
+ *
+ * This is used to measure the latency from input to the display
+ *
+ * @return The time of the event, in us since boot, or 0 if no events were consumed
+ */
+uint32_t takeInputConsumedTime(void)
+{
+    uint32_t time     = inputConsumedTime;
+    inputConsumedTime = 0;
+    return time;
+}
+
+/**
+ * @brief Remember the time of a consumed input event, if it's the earliest since takeInputConsumedTime()
+ *
+ * @param time The time of the event, in us since boot
+ */
+static void markInputConsumed(uint32_t time)
+{
+    if (0 == inputConsumedTime)
+    {
+        // Zero means nothing was consumed
+        inputConsumedTime = time ? time : 1;
+    }
+}
+
 //==============================================================================
 // Pushbutton Functions
 //==============================================================================
@@ -277,6 +408,7 @@ static bool IRAM_ATTR btn_timer_isr_cb(gptimer_handle_t timer, const gptimer_ala
 
         // Queue this state from the ISR
         xQueueSendFromISR(btn_evt_queue, &tEvt, &high_task_awoken);
+        TRACE_INSTANT(TRACE_BTN_ISR, evt);
     }
     // return whether we need to yield at the end of ISR
     return high_task_awoken == pdTRUE;
@@ -379,7 +511,21 @@ static void initTouchSensor(touch_pad_t* _touchPads, uint8_t _numTouchPads, floa
                  (uint32_t)(touch_value * touchPadSensitivity));
     }
 
-    getTouchJoystick(0, 0, 0);
+    /* Prime the baseline, which is tracked per-sample */
+    baseOffsets = heap_caps_calloc(numTouchPads, sizeof(baseOffsets[0]), MALLOC_CAP_8BIT);
+    int32_t unused[numTouchPads];
+    getBaseTouchVals(unused, numTouchPads);
+
+    /* Sample the touchpad in the background */
+    const esp_timer_create_args_t touchTimerArgs = {
+        .callback              = touchSampleCb,
+        .arg                   = NULL,
+        .dispatch_method       = ESP_TIMER_TASK,
+        .name                  = "touch",
+        .skip_unhandled_events = true,
+    };
+    ESP_ERROR_CHECK(esp_timer_create(&touchTimerArgs, &touchTimer));
+    ESP_ERROR_CHECK(esp_timer_start_periodic(touchTimer, TOUCH_SAMPLE_PERIOD_US));
 }
 
 /**
@@ -435,10 +581,10 @@ int getBaseTouchVals(int32_t* data, int count)
         count = numTouchPads;
     }
 
-    // curVals is valid.
-    if (NULL == baseOffsets)
+    // curVals is valid. Start the baseline from the first valid reading
+    if (!baseOffsetsSet)
     {
-        baseOffsets = heap_caps_malloc(sizeof(baseOffsets[0]) * numTouchPads, MALLOC_CAP_8BIT);
+        baseOffsetsSet = true;
         for (int i = 0; i < numTouchPads; i++)
         {
             baseOffsets[i] = curVals[i] << 8;
@@ -473,7 +619,9 @@ int getBaseTouchVals(int32_t* data, int count)
 
 /**
  * @brief Get high-level touch input, an analog input.
- * NOTE: You must have touch callbacks enabled to use this.
+ *
+ * This returns the most recent filtered sample taken in the background, so it is cheap to call any number of times.
+ * Use checkTouchQueue() to receive every sample instead.
  *
  * @param[out] phi the angle of the touch. Where 0 is right, 320 is up, 640 is left and 960 is down.
  * @param[out] r is how far from center you are.  511 is on the outside edge, 0 is on the inside.
@@ -481,6 +629,153 @@ int getBaseTouchVals(int32_t* data, int count)
  * @return true if touched (joystick), false if not touched (no centroid)
  */
 int getTouchJoystick(int32_t* phi, int32_t* r, int32_t* intensity)
+{
+    touchEvt_t sample;
+    unsigned int seq;
+
+    // Retry if the sampler wrote a new sample while this was copying it
+    do
+    {
+        seq = atomic_load_explicit(&touchLatestSeq, memory_order_acquire);
+        if (seq & 1)
+        {
+            continue;
+        }
+        sample = touchLatest;
+        atomic_thread_fence(memory_order_acquire);
+    } while ((seq & 1) || seq != atomic_load_explicit(&touchLatestSeq, memory_order_relaxed));
+
+    if (!sample.touched)
+    {
+        return 0;
+    }
+
+    // Count each new sample once for the input latency
+    if (seq != touchConsumedSeq)
+    {
+        touchConsumedSeq = seq;
+        markInputConsumed(sample.time);
+    }
+
+    if (phi)
+    {
+        *phi = sample.phi;
+    }
+    if (r)
+    {
+        *r = sample.r;
+    }
+    if (intensity)
+    {
+        *intensity = sample.intensity;
+    }
+    return 1;
+}
+
+/**
+ * @brief Timer callback which samples the touchpad, filters the sample, and publishes it
+ *
+ * @param arg unused
+ */
+static void touchSampleCb(void* arg)
+{
+    static touchEvt_t filtered  = {0};
+    static int32_t filterState[3];
+
+    touchEvt_t sample = {
+        .time = esp_timer_get_time(),
+    };
+    sample.touched = computeTouchCentroid(&sample.phi, &sample.r, &sample.intensity);
+
+    touchEvt_t prior = filtered;
+    filterTouchSample(&filtered, &sample, filterState);
+
+    // Publish the latest sample for getTouchJoystick()
+    unsigned int seq = atomic_load_explicit(&touchLatestSeq, memory_order_relaxed);
+    atomic_store_explicit(&touchLatestSeq, seq + 1, memory_order_relaxed);
+    atomic_thread_fence(memory_order_release);
+    touchLatest = filtered;
+    atomic_store_explicit(&touchLatestSeq, seq + 2, memory_order_release);
+
+    // Queue changes for checkTouchQueue()
+    if (prior.touched != filtered.touched
+        || (filtered.touched && (prior.phi != filtered.phi || prior.r != filtered.r)))
+    {
+        unsigned int head = atomic_load_explicit(&touchQueueHead, memory_order_relaxed);
+        if (head - atomic_load_explicit(&touchQueueTail, memory_order_acquire) < TOUCH_QUEUE_LEN)
+        {
+            touchQueue[head % TOUCH_QUEUE_LEN] = filtered;
+            atomic_store_explicit(&touchQueueHead, head + 1, memory_order_release);
+        }
+        // Otherwise nobody is reading the queue, so drop the event
+    }
+}
+
+/**
+ * @brief Smooth a touch sample with an exponential moving average, skipping the filter for large jumps
+ *
+ * @param[in,out] filtered The last filtered sample, updated with the new one
+ * @param sample The new raw sample
+ * @param[in,out] state The filtered phi, r, and intensity with 8 fractional bits
+ */
+static void filterTouchSample(touchEvt_t* filtered, const touchEvt_t* sample, int32_t* state)
+{
+    uint8_t strength = touchFilterStrength;
+
+    int32_t dPhi = (sample->phi << 8) - state[0];
+    int32_t dR   = (sample->r << 8) - state[1];
+
+    // Take the short way around the circle
+    if (dPhi > (180 << 8))
+    {
+        dPhi -= (360 << 8);
+    }
+    else if (dPhi < -(180 << 8))
+    {
+        dPhi += (360 << 8);
+    }
+
+    if (!sample->touched || !filtered->touched || abs(dPhi) > (TOUCH_FILTER_SNAP_PHI << 8)
+        || abs(dR) > (TOUCH_FILTER_SNAP_R << 8))
+    {
+        // New touches, releases, and big jumps aren't smoothed
+        strength = 0;
+    }
+
+    state[0] += dPhi >> strength;
+    state[1] += dR >> strength;
+    state[2] += ((sample->intensity << 8) - state[2]) >> strength;
+
+    // Keep the angle in range
+    if (state[0] < 0)
+    {
+        state[0] += (360 << 8);
+    }
+    else if (state[0] >= (360 << 8))
+    {
+        state[0] -= (360 << 8);
+    }
+
+    filtered->touched   = sample->touched;
+    filtered->time      = sample->time;
+    filtered->phi       = (state[0] + 128) >> 8;
+    filtered->r         = (state[1] + 128) >> 8;
+    filtered->intensity = (state[2] + 128) >> 8;
+    if (filtered->phi >= 360)
+    {
+        filtered->phi -= 360;
+    }
+}
+
+/**
+ * @brief Read the touchpad and find the centroid of the touch
+ *
+ * @param[out] phi the angle of the touch
+ * @param[out] r is how far from center you are
+ * @param[out] intensity is how hard the user is pressing.
+ * @return true if touched (joystick), false if not touched (no centroid)
+ */
+static int computeTouchCentroid(int32_t* phi, int32_t* r, int32_t* intensity)
 {
 #define TOUCH_CENTER 2
     const uint8_t ringZones[] = {3, 0, 1, 4, 5};
@@ -37,10 +37,17 @@
  *
  * \section tpad_design Touch-pad Design Philosophy
  *
- * Unlike push-buttons, the touch-pads are treated as a single circular area (not discrete touch areas) and are not
- * polled. Events like touches are not queued to be processed later. The individual Swadge mode must poll the current
- * touch state with getTouchJoystick(). The touch state reports the polar coordinates of the touch (angle and radius) as
- * well as the intensity of the touch.
+ * The touch-pads are treated as a single circular area (not discrete touch areas). Like push-buttons, they are sampled
+ * in the background, every ::TOUCH_SAMPLE_PERIOD_US by an esp_timer rather than an interrupt, since reading the touch
+ * sensor isn't safe in an ISR. Each sample's centroid is computed once and smoothed by a filter, set with
+ * setTouchFilter(), which doesn't smooth the start of a touch or large jumps so that fast swipes aren't delayed.
+ *
+ * The latest sample can be read with getTouchJoystick() any number of times per frame. Samples which changed are also
+ * queued, with a timestamp, to be received with checkTouchQueue(). The queue is a lock-free single-producer,
+ * single-consumer ring, so the sampler never waits on the Swadge mode. If the queue isn't being read, new events are
+ * dropped when it fills, so the events received later start with stale ones, up to the queue's length old. The queue is
+ * flushed when switching Swadge modes, and flushTouchQueue() may be called to flush it before reading it again. The
+ * touch state reports the polar coordinates of the touch (angle and radius) as well as the intensity of the touch.
  *
  * Touch-pad areas are set up and read with <a
  * href="https://docs.espressif.com/projects/esp-idf/en/v5.2.3/esp32s2/api-reference/peripherals/touch_pad.html">Touch
@@ -53,7 +60,8 @@
  * You do need to call checkButtonQueueWrapper() and should do so in a while-loop to receive all events since the last
  * check. This should be done in the Swadge mode's main function.
  *
- * You may call getTouchJoystick() to get the analog touch position. This is independent of checkButtonQueueWrapper().
+ * You may call getTouchJoystick() to get the analog touch position, or call checkTouchQueue() in a while-loop to
+ * receive every touch sample since the last check. These are independent of checkButtonQueueWrapper().
  * Three utility functions are provided to interpret touch data different ways.
  * - getTouchJoystickZones() is available to translate the analog touches into a four, five, eight, or nine-way virtual
  * directional pad.
@@ -121,10 +129,26 @@ typedef struct
     uint32_t time;      ///!< The time of this event, in us since boot
 } buttonEvt_t;
 
+/**
+ * @brief A filtered, timestamped touchpad sample
+ */
+typedef struct
+{
+    bool touched;      //!< True if the touchpad is touched. If false, the other values are zero
+    int32_t phi;       //!< The angle of the touch, as reported by getTouchJoystick()
+    int32_t r;         //!< The distance of the touch from the center, as reported by getTouchJoystick()
+    int32_t intensity; //!< How hard the touchpad is pressed, as reported by getTouchJoystick()
+    uint32_t time;     //!< The time of this sample, in us since boot
+} touchEvt_t;
+
 void initButtons(gpio_num_t* pushButtons, uint8_t numPushButtons, touch_pad_t* touchPads, uint8_t numTouchPads);
 void deinitButtons(void);
 bool checkButtonQueue(buttonEvt_t*);
 
 int getTouchJoystick(int32_t* phi, int32_t* r, int32_t* intensity);
+bool checkTouchQueue(touchEvt_t* evt);
+void flushTouchQueue(void);
+void setTouchFilter(uint8_t strength);
+uint32_t takeInputConsumedTime(void);
 
 #endif
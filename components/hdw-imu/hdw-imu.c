@@ -3,7 +3,10 @@
 //==============================================================================
 
 #include <esp_log.h>
+#include <esp_timer.h>
 #include <math.h>
+#include <stdatomic.h>
+#include <stdio.h>
 #include <string.h>
 #include "driver/gpio.h"
 #include "rom/gpio.h"
@@ -16,6 +19,7 @@
 #include "hdw-imu.h"
 #include "hdw-nvs.h"
 #include "quaternions.h"
+#include "imu_fusion.h"
 
 #define DSCL_OUTPUT                             \
     {                                           \
@@ -91,12 +95,45 @@ typedef enum __attribute__((packed))
 #define LSM6DSL_ADDRESS 0x6a
 #define QMC6308_ADDRESS 0x2c
 
+/// How often the FIFO is emptied and fused, in microseconds. The FIFO fills at 208 Hz
+#define IMU_SAMPLE_PERIOD_US 10000
+
+/// The prefix for every line of raw FIFO samples, so they can be separated from other serial output
+#define IMU_DUMP_PREFIX "IMU "
+
+//==============================================================================
+// Structs
+//==============================================================================
+
+/// @brief The latest fused sample, published by accelSampleCb()
+typedef struct
+{
+    float quat[4];       ///< The rotation, wxyz
+    float accelUp[3];    ///< The last normalized "up" vector from the accelerometer (NOT FUSED)
+    int16_t orient[3];   ///< The fused "up" vector from the device's point of view, scaled by 256
+    int16_t accelRaw[3]; ///< accelUp, scaled by 256
+} imuSnapshot_t;
+
 //==============================================================================
 // Variables
 //==============================================================================
 
 LSM6DSLData LSM6DSL;
 
+/// The fixed point fusion, only touched by the sampling task while it runs
+static imuFusionFixed_t fusion;
+
+/// Timer handle used to periodically empty the FIFO and fuse the samples
+static esp_timer_handle_t imuTimer = NULL;
+
+/// The most recent fused sample, read by the getters
+static imuSnapshot_t imuLatest;
+/// Odd while imuLatest is being written, incremented by two for each new sample
+static atomic_uint imuLatestSeq;
+
+/// Set by the sampling task when calibration finishes, so accelIntegrate() can save it to NVS
+static atomic_bool calFinished;
+
 //==============================================================================
 // Static Function Prototypes
 //==============================================================================
@@ -115,6 +152,14 @@ static esp_err_t GeneralSet(int dev, int reg, int val);
 static esp_err_t LSM6DSLSet(int reg, int val);
 static int GeneralI2CGet(int device, int reg, uint8_t* data, int data_len);
 static int ReadLSM6DSL(uint8_t* data, int data_len);
+static void accelCalibrateSample(const int16_t* euler_deltas);
+static esp_err_t accelReadAndFuse(void);
+#if defined(CONFIG_IMU_FIFO_DUMP)
+static void accelDumpSample(const int16_t* sample);
+#endif
+static void accelPublish(void);
+static void accelReadLatest(imuSnapshot_t* latest);
+static void accelSampleCb(void* arg);
 
 //==============================================================================
 // Utility Functions
@@ -218,7 +263,7 @@ static int ReadLSM6DSL(uint8_t* data, int data_len)
         SendStop();
         LSM6DSLSet(LSM6DSL_FIFO_CTRL5, (0b0101 << 3) | 0b000); // Disable fifo
         LSM6DSLSet(LSM6DSL_FIFO_CTRL5, (0b0101 << 3) | 0b110); // 208 Hz ODR
-        LSM6DSL.sampCount = 0;
+        fusion.sampCount = 0;
         return 0;
     }
 
@@ -249,6 +294,230 @@ static int ReadLSM6DSL(uint8_t* data, int data_len)
     return fifolen;
 }
 
+/**
+ * @brief Feed one gyro sample to the calibration, which converges on the gyro's bias while the IMU sits still
+ *
+ * @param euler_deltas The gyro's XYZ from the FIFO
+ */
+static void accelCalibrateSample(const int16_t* euler_deltas)
+{
+    LSM6DSLData* ld = &LSM6DSL;
+
+    float fScale          = IMU_GYRO_SCALE;
+    float fEulerScales[3] = {-fScale, fScale, -fScale};
+
+    float fEulers[3]
+        = {euler_deltas[0] * fEulerScales[0], euler_deltas[1] * fEulerScales[1], euler_deltas[2] * fEulerScales[2]};
+
+    float diff[3] = {fEulers[0] - ld->fvAverage[0], fEulers[1] - ld->fvAverage[1], fEulers[2] - ld->fvAverage[2]};
+
+    float diffsq[3] = {(diff[0] < 0) ? -diff[0] : diff[0], (diff[1] < 0) ? -diff[1] : diff[1],
+                       (diff[2] < 0) ? -diff[2] : diff[2]};
+
+    diffsq[0] *= 1000.0;
+    diffsq[1] *= 1000.0;
+    diffsq[2] *= 1000.0;
+
+    ld->fvDeviation[0] -= 0.004;
+    ld->fvDeviation[1] -= 0.004;
+    ld->fvDeviation[2] -= 0.004;
+
+    if (ld->fvDeviation[0] < diffsq[0])
+        ld->fvDeviation[0] = diffsq[0];
+    if (ld->fvDeviation[1] < diffsq[1])
+        ld->fvDeviation[1] = diffsq[1];
+    if (ld->fvDeviation[2] < diffsq[2])
+        ld->fvDeviation[2] = diffsq[2];
+
+    if (ld->fvDeviation[0] > 0.8)
+        ld->fvDeviation[0] = 0.8;
+    if (ld->fvDeviation[1] > 0.8)
+        ld->fvDeviation[1] = 0.8;
+    if (ld->fvDeviation[2] > 0.8)
+        ld->fvDeviation[2] = 0.8;
+
+    diff[0] *= mathsqrtf(ld->fvDeviation[0]) * 0.5;
+    diff[1] *= mathsqrtf(ld->fvDeviation[1]) * 0.5;
+    diff[2] *= mathsqrtf(ld->fvDeviation[2]) * 0.5;
+
+    ld->fvAverage[0] += diff[0];
+    ld->fvAverage[1] += diff[1];
+    ld->fvAverage[2] += diff[2];
+
+    // Compute the running RMS error.
+    float fvEuler = accelGetStdDevInCal();
+
+    if (fvEuler < 0.00015f)
+    {
+        ld->fvBias[0] = -ld->fvAverage[0];
+        ld->fvBias[1] = -ld->fvAverage[1];
+        ld->fvBias[2] = -ld->fvAverage[2];
+        imuFusionFixedSetBias(&fusion, ld->fvBias);
+
+        // Writing flash would stall the timer task, so accelIntegrate() saves the bias
+        atomic_store(&calFinished, true);
+
+        ld->performCal     = 0;
+        ld->fvDeviation[0] = 0;
+        ld->fvDeviation[0] = 1;
+        ld->fvDeviation[0] = 2;
+    }
+}
+
+/**
+ * @brief Read all pending samples in the IMU and fuse them
+ *
+ * @return ESP_OK if successful, or nonzero if error.
+ */
+static esp_err_t accelReadAndFuse(void)
+{
+    LSM6DSLData* ld = &LSM6DSL;
+
+    int16_t data[6 * 16];
+
+    int readr = ReadLSM6DSL((uint8_t*)data, sizeof(data));
+    if (readr < 0)
+        return readr;
+    int samp;
+    int16_t* cdata = data;
+
+    uint32_t start = getCycleCount();
+
+    // Round down
+    readr = (readr / 6) * 6;
+
+    // [0] = +X axis coming out right of controller.
+    // [1] = +Y axis, pointing straight up out of controller, out where the USB port is.
+    // [2] = +Z axis, pointing up from the face of the controller.
+
+    ld->lastreadr = readr;
+
+    for (samp = 0; samp < readr; samp += 6)
+    {
+        // We can sum rotations to understand the amount of counts in a full circle.
+        // Note: this is actually more of a debug mechanism.
+        ld->gyroaccum[0] += cdata[0];
+        ld->gyroaccum[1] += cdata[1];
+        ld->gyroaccum[2] += cdata[2];
+
+        if (ld->performCal)
+        {
+            accelCalibrateSample(cdata);
+        }
+
+#if defined(CONFIG_IMU_FIFO_DUMP)
+        accelDumpSample(cdata);
+#endif
+
+        imuFusionFixedStep(&fusion, cdata);
+        cdata += 6;
+    }
+
+    if (samp)
+    {
+        ld->gyrolast[0]  = cdata[-6];
+        ld->gyrolast[1]  = cdata[-5];
+        ld->gyrolast[2]  = cdata[-4];
+        ld->accellast[0] = cdata[-3];
+        ld->accellast[1] = cdata[-2];
+        ld->accellast[2] = cdata[-1];
+
+        ld->sampCount       = fusion.sampCount;
+        ld->fCorrectLast[0] = fusion.correctLast[0] * (1.0f / IMU_Q30_ONE);
+        ld->fCorrectLast[1] = fusion.correctLast[1] * (1.0f / IMU_Q30_ONE);
+        ld->fCorrectLast[2] = fusion.correctLast[2] * (1.0f / IMU_Q30_ONE);
+
+        accelPublish();
+    }
+
+    ld->computetime = getCycleCount() - start;
+
+    return ESP_OK;
+}
+
+#if defined(CONFIG_IMU_FIFO_DUMP)
+/**
+ * @brief Print one raw sample from the FIFO over serial, as the hex of its twelve little endian bytes.
+ *
+ * To get a dump for the emulator's \c --imu-replay option, capture the serial output, keep only these lines, remove the
+ * prefix and convert the hex to binary, e.g. <tt>grep '^IMU ' log.txt | cut -c5- | xxd -r -p > imu.bin</tt>
+ *
+ * @param sample Six words from the FIFO, the gyro's XYZ and then the accelerometer's XYZ
+ */
+static void accelDumpSample(const int16_t* sample)
+{
+    static const char hexChars[] = "0123456789abcdef";
+
+    const uint8_t* bytes = (const uint8_t*)sample;
+    char line[2 * 6 * sizeof(int16_t) + 1];
+    for (int i = 0; i < 6 * sizeof(int16_t); i++)
+    {
+        line[2 * i]     = hexChars[bytes[i] >> 4];
+        line[2 * i + 1] = hexChars[bytes[i] & 0x0F];
+    }
+    line[sizeof(line) - 1] = '\0';
+
+    printf(IMU_DUMP_PREFIX "%s\n", line);
+}
+#endif
+
+/**
+ * @brief Publish the state of the fusion for the getters
+ */
+static void accelPublish(void)
+{
+    imuSnapshot_t latest;
+    imuFusionFixedGetQuat(&fusion, latest.quat);
+
+    int32_t orient[3];
+    imuFusionFixedGetOrient(&fusion, orient);
+    for (int i = 0; i < 3; i++)
+    {
+        // Scale Q2.30 to 256, rounding towards zero like a float cast
+        latest.orient[i]   = orient[i] / (1 << 22);
+        latest.accelRaw[i] = fusion.accelUp[i] / (1 << 22);
+        latest.accelUp[i]  = fusion.accelUp[i] * (1.0f / IMU_Q30_ONE);
+    }
+
+    unsigned int seq = atomic_load_explicit(&imuLatestSeq, memory_order_relaxed);
+    atomic_store_explicit(&imuLatestSeq, seq + 1, memory_order_relaxed);
+    atomic_thread_fence(memory_order_release);
+    imuLatest = latest;
+    atomic_store_explicit(&imuLatestSeq, seq + 2, memory_order_release);
+}
+
+/**
+ * @brief Copy the most recently published sample
+ *
+ * @param latest The sample is written here
+ */
+static void accelReadLatest(imuSnapshot_t* latest)
+{
+    unsigned int seq;
+
+    // Retry if the sampler published a new sample while this was copying it
+    do
+    {
+        seq = atomic_load_explicit(&imuLatestSeq, memory_order_acquire);
+        if (seq & 1)
+        {
+            continue;
+        }
+        *latest = imuLatest;
+        atomic_thread_fence(memory_order_acquire);
+    } while ((seq & 1) || seq != atomic_load_explicit(&imuLatestSeq, memory_order_relaxed));
+}
+
+/**
+ * @brief Timer callback which empties the IMU's FIFO and fuses the samples
+ *
+ * @param arg unused
+ */
+static void accelSampleCb(void* arg)
+{
+    accelReadAndFuse();
+}
+
 //==============================================================================
 // Functions
 //==============================================================================
@@ -266,6 +535,10 @@ esp_err_t initAccelerometer(gpio_num_t sda, gpio_num_t scl, gpio_pullup_t pullup
 {
     int i;
     int retry = 0;
+
+    // Don't sample in the background while the bus is reset
+    deInitAccelerometer();
+
 do_retry:
 
     gpio_config_t gsetup = {
@@ -329,7 +602,7 @@ do_retry:
     for (i = 0; i < 2; i++)
     {
         vTaskDelay(1);
-        int check = accelIntegrate();
+        int check = accelReadAndFuse();
         if (check != ESP_OK)
         {
             ESP_LOGI("accel", "Init Fault Retry");
@@ -341,279 +614,75 @@ do_retry:
         ESP_LOGI("accel", "Check %d", check);
     }
 
+    // Empty the FIFO and fuse in the background from now on
+    const esp_timer_create_args_t imuTimerArgs = {
+        .callback              = accelSampleCb,
+        .arg                   = NULL,
+        .dispatch_method       = ESP_TIMER_TASK,
+        .name                  = "imu",
+        .skip_unhandled_events = true,
+    };
+    ESP_ERROR_CHECK(esp_timer_create(&imuTimerArgs, &imuTimer));
+    ESP_ERROR_CHECK(esp_timer_start_periodic(imuTimer, IMU_SAMPLE_PERIOD_US));
+
     ESP_LOGI("accel", "Init Ok");
     return ESP_OK;
 }
 
 /**
- * @brief Deinit the accelerometer (nothing to do)
+ * @brief Deinit the accelerometer, which stops sampling it in the background
  *
  * @return ESP_OK
  */
 esp_err_t deInitAccelerometer(void)
 {
+    if (imuTimer)
+    {
+        esp_timer_stop(imuTimer);
+        esp_timer_delete(imuTimer);
+        imuTimer = NULL;
+    }
     return ESP_OK;
 }
 
 /**
- * @brief Read all pending samples in IMU and perform a sensor fusion pass
+ * @brief Copy the latest sample fused in the background into ::LSM6DSL, and save a finished calibration.
  *
- * @return ESP_OK if successful, or nonzero if error.
+ * The IMU is read and fused on a timer, so this is cheap. The getters don't need it to be called.
+ *
+ * @return ESP_OK if successful, or ESP_ERR_INVALID_STATE if the IMU isn't running.
  */
 esp_err_t accelIntegrate()
 {
-    LSM6DSLData* ld = &LSM6DSL;
-
-    int16_t data[6 * 16];
-
-    // Get temperature sensor (in case we ever want to use it)
-    // int r = GeneralI2CGet(LSM6DSL_ADDRESS, 0x20, (uint8_t*)data, 2);
-    // if (r < 0)
-    //    return r;
-    // if (r == 2)
-    //    ld->temp = data[0];
-    int readr = ReadLSM6DSL((uint8_t*)data, sizeof(data));
-    if (readr < 0)
-        return readr;
-    int samp;
-    int16_t* cdata = data;
-
-    uint32_t start = getCycleCount();
-
-    // Round down
-    readr = (readr / 6) * 6;
-
-    // STEP 0:  Decide your coordinate frame.
-
-    // [0] = +X axis coming out right of controller.
-    // [1] = +Y axis, pointing straight up out of controller, out where the USB port is.
-    // [2] = +Z axis, pointing up from the face of the controller.
-
-    ld->lastreadr = readr;
-
-    for (samp = 0; samp < readr; samp += 6)
+    if (NULL == imuTimer)
     {
-        // Extract data from IMU
-        int16_t* euler_deltas = cdata; // Euler angles, from gyro.
-        int16_t* accel_data   = cdata + 3;
-
-        // ESP_LOGI( "_", "%2d%3d%4d%4d%4d%5d%5d%5d", samp, readr, euler_deltas[0], euler_deltas[1], euler_deltas[2],
-        // accel_data[0], accel_data[1], accel_data[2] );
-
-        // Manual cal, used only for Steps 2..8
-        //    euler_deltas[0] -= 12;
-        //    euler_deltas[1] += 22;
-        //    euler_deltas[2] += 4;
-
-        // We can sum rotations to understand the amount of counts in a full circle.
-        // Note: this is actually more of a debug mechanism.
-        ld->gyroaccum[0] += euler_deltas[0];
-        ld->gyroaccum[1] += euler_deltas[1];
-        ld->gyroaccum[2] += euler_deltas[2];
-
-        // STEP 1:  Visually inspect the gyro values.
-        // STEP 2:  Integrate the gyro values, verify they are correct.
-
-        // 2000 dps full-scale
-        // 32768 is full-scale
-        // 208 SPS
-        // convert to radians. ( 2000.0f / 32768.0f / 208.0f * 2.0 * 3.14159f / 180.0f );
-        // Measured = 560,000 counts per scale (Measured by looking at sum)
-        // Testing -> 3.14159 * 2.0 / 566000;
-        float fFudge = 0.5625; // XXX TODO: Investigate.
-        float fScale = (2000.0f / 32768.0f / 208.0f * 2.0 * 3.14159f / 180.0f) * fFudge;
-
-        // STEP 3:  Integrate gyro values into a quaternion.
-        // This step is validated by working with just one axis at a time
-        // then apply a coordinate frame to ld->fqQuat and validate that it is
-        // correct.
-        float fEulerScales[3] = {-fScale, fScale, -fScale};
-
-        float fEulers[3]
-            = {euler_deltas[0] * fEulerScales[0], euler_deltas[1] * fEulerScales[1], euler_deltas[2] * fEulerScales[2]};
-
-        // Used for calibration
-        if (ld->performCal)
-        {
-            float diff[3]
-                = {fEulers[0] - ld->fvAverage[0], fEulers[1] - ld->fvAverage[1], fEulers[2] - ld->fvAverage[2]};
-
-            float diffsq[3] = {(diff[0] < 0) ? -diff[0] : diff[0], (diff[1] < 0) ? -diff[1] : diff[1],
-                               (diff[2] < 0) ? -diff[2] : diff[2]};
-
-            diffsq[0] *= 1000.0;
-            diffsq[1] *= 1000.0;
-            diffsq[2] *= 1000.0;
-
-            ld->fvDeviation[0] -= 0.004;
-            ld->fvDeviation[1] -= 0.004;
-            ld->fvDeviation[2] -= 0.004;
-
-            if (ld->fvDeviation[0] < diffsq[0])
-                ld->fvDeviation[0] = diffsq[0];
-            if (ld->fvDeviation[1] < diffsq[1])
-                ld->fvDeviation[1] = diffsq[1];
-            if (ld->fvDeviation[2] < diffsq[2])
-                ld->fvDeviation[2] = diffsq[2];
-
-            if (ld->fvDeviation[0] > 0.8)
-                ld->fvDeviation[0] = 0.8;
-            if (ld->fvDeviation[1] > 0.8)
-                ld->fvDeviation[1] = 0.8;
-            if (ld->fvDeviation[2] > 0.8)
-                ld->fvDeviation[2] = 0.8;
-
-            diff[0] *= mathsqrtf(ld->fvDeviation[0]) * 0.5;
-            diff[1] *= mathsqrtf(ld->fvDeviation[1]) * 0.5;
-            diff[2] *= mathsqrtf(ld->fvDeviation[2]) * 0.5;
-
-            ld->fvAverage[0] += diff[0];
-            ld->fvAverage[1] += diff[1];
-            ld->fvAverage[2] += diff[2];
-
-            // Compute the running RMS error.
-            float fvEuler = accelGetStdDevInCal();
-
-            if (fvEuler < 0.00015f)
-            {
-                ld->fvBias[0] = -ld->fvAverage[0];
-                ld->fvBias[1] = -ld->fvAverage[1];
-                ld->fvBias[2] = -ld->fvAverage[2];
-                struct fiunion
-                {
-                    union
-                    {
-                        int32_t i;
-                        float f;
-                    } u;
-                };
-                struct fiunion x, y, z;
-                x.u.f = ld->fvBias[0];
-                y.u.f = ld->fvBias[1];
-                z.u.f = ld->fvBias[2];
-                writeNvs32("gyrocalx", x.u.i);
-                writeNvs32("gyrocaly", y.u.i);
-                writeNvs32("gyrocalz", z.u.i);
-
-                ld->performCal     = 0;
-                ld->fvDeviation[0] = 0;
-                ld->fvDeviation[0] = 1;
-                ld->fvDeviation[0] = 2;
-            }
-        }
-
-        fEulers[0] += ld->fvBias[0];
-        fEulers[1] += ld->fvBias[1];
-        fEulers[2] += ld->fvBias[2];
-
-        mathEulerToQuat(ld->fqQuatLast, fEulers);
-        mathQuatApply(ld->fqQuat, ld->fqQuat, ld->fqQuatLast);
-
-        // STEP 4: Validate yor values by doing 4 90 degree turns
-        //  across multiple axes.
-        // i.e. rotate controller down, clockwise from top, up, counter-clockwise.
-        // while investigating quaternion.  It should return to identity.
-
-        // STEP 6: Determine our "error" based on accelerometer.
-        // NOTE: This step could be done on the inner loop if you want, and done over
-        // every accelerometer cycle, or it can be done on the outside, every few cycles.
-        // all that realy matters is that it is done periodically.
-
-        // STEP 6A: Examine vectors.  Generally speaking, we want an "up" vector, not a gravity vector.
-        // this is "up" in the controller's point of view.
-        float accel_up[3] = {-accel_data[0], accel_data[1], -accel_data[2]};
-
-        float accel_inverse_mag
-            = rsqrtf(accel_up[0] * accel_up[0] + accel_up[1] * accel_up[1] + accel_up[2] * accel_up[2]);
-        accel_up[0] *= accel_inverse_mag;
-        accel_up[1] *= accel_inverse_mag;
-        accel_up[2] *= accel_inverse_mag;
-
-        ld->fvLastAccelRaw[0] = accel_up[0];
-        ld->fvLastAccelRaw[1] = accel_up[1];
-        ld->fvLastAccelRaw[2] = accel_up[2];
-
-        if (ld->sampCount++ == 0)
-        {
-            // set fqQuat to be the rotation to go from our "up" from the
-            // accelerometer to the nominal "up"
-            float ideal_up[3] = {0, 1, 0};
-            mathQuatFromTwoVectors(ld->fqQuat, ideal_up, accel_up);
-        }
-        else
-        {
-            // Step 6B: Next, compute what we think "up" should be from our point of view.  We will use +Y Up.
-            float what_we_think_is_up[3] = {0, 1, 0};
-            mathRotateVectorByInverseOfQuaternion(what_we_think_is_up, LSM6DSL.fqQuat, what_we_think_is_up);
-
-            // Step 6C: Next, we determine how far off we are.  This will tell us our error.
-            float corrective_quaternion[4];
-
-            // TRICKY: The ouput of this is actually the axis of rotation, which is ironically
-            // in vector-form the same as a quaternion.  So we can write directly into the quat.
-            mathCrossProduct(corrective_quaternion + 1, accel_up, what_we_think_is_up);
-
-            // Now, we apply this in step 7.
-
-            // First, we can compute what the drift values of our axes are, to anti-drift them.
-            // If you do only this, you will always end up in an unstable oscillation.
-            memcpy(ld->fCorrectLast, corrective_quaternion + 1, 12);
-
-            // XXX TODO: We need to multiply by amount the accelerometer gives us assurance.
-            ld->fvBias[0] += mathsqrtf(corrective_quaternion[1]) * 0.0000002;
-            ld->fvBias[1] += mathsqrtf(corrective_quaternion[2]) * 0.0000002;
-            ld->fvBias[2] += mathsqrtf(corrective_quaternion[3]) * 0.0000002;
-
-            float corrective_force = 0.0005f;
-
-            // Second, we can apply a very small corrective tug.  This helps prevent oscillation
-            // about the correct answer.  This acts sort of like a P term to a PID loop.
-            // This is actually the **primary**, or fastest responding thing.
-            corrective_quaternion[1] *= corrective_force;
-            corrective_quaternion[2] *= corrective_force;
-            corrective_quaternion[3] *= corrective_force;
-
-            // x^2+y^2+z^2+q^2 -> ALGEBRA! -> sqrt( 1-x^2-y^2-z^2 ) = w
-            corrective_quaternion[0] = mathsqrtf(1 - corrective_quaternion[1] * corrective_quaternion[1]
-                                                 - corrective_quaternion[2] * corrective_quaternion[2]
-                                                 - corrective_quaternion[3] * corrective_quaternion[3]);
-
-            mathQuatApply(ld->fqQuat, ld->fqQuat, corrective_quaternion);
-        }
-        cdata += 6;
+        return ESP_ERR_INVALID_STATE;
     }
 
-    // Now we move onto the outer loop.
-    // STEP 5: We now want to normalize the quat periodically.  Don't do this too
-    // soon, otherwise you won't notice math errors.  Realistically, this should
-    // only need to be done every hundreds of thousands of samples.
-    //
-    // Also, don't do this too often, otherwise you will reduce accuracy,
-    // unnecessarily.
-    float* qRot  = ld->fqQuat;
-    float qmagsq = qRot[0] * qRot[0] + qRot[1] * qRot[1] + qRot[2] * qRot[2] + qRot[3] * qRot[3];
-    if (qmagsq > 1.05 || qmagsq < 0.95)
-    {
-        // This normalizes everything.
-        qmagsq  = rsqrtf(qmagsq);
-        qRot[0] = qRot[0] * qmagsq;
-        qRot[1] = qRot[1] * qmagsq;
-        qRot[2] = qRot[2] * qmagsq;
-        qRot[3] = qRot[3] * qmagsq;
-    }
+    imuSnapshot_t latest;
+    accelReadLatest(&latest);
+    memcpy(LSM6DSL.fqQuat, latest.quat, sizeof(LSM6DSL.fqQuat));
+    memcpy(LSM6DSL.fvLastAccelRaw, latest.accelUp, sizeof(LSM6DSL.fvLastAccelRaw));
 
-    if (samp)
+    if (atomic_exchange(&calFinished, false))
     {
-        ld->gyrolast[0]  = cdata[-6];
-        ld->gyrolast[1]  = cdata[-5];
-        ld->gyrolast[2]  = cdata[-4];
-        ld->accellast[0] = cdata[-3];
-        ld->accellast[1] = cdata[-2];
-        ld->accellast[2] = cdata[-1];
+        struct fiunion
+        {
+            union
+            {
+                int32_t i;
+                float f;
+            } u;
+        };
+        struct fiunion x, y, z;
+        x.u.f = LSM6DSL.fvBias[0];
+        y.u.f = LSM6DSL.fvBias[1];
+        z.u.f = LSM6DSL.fvBias[2];
+        writeNvs32("gyrocalx", x.u.i);
+        writeNvs32("gyrocaly", y.u.i);
+        writeNvs32("gyrocalz", z.u.i);
     }
 
-    ld->computetime = getCycleCount() - start;
-
     return ESP_OK;
 }
 
@@ -624,9 +693,11 @@ esp_err_t accelIntegrate()
  */
 esp_err_t accelGetAccelVecRaw(int16_t* x, int16_t* y, int16_t* z)
 {
-    *x = LSM6DSL.fvLastAccelRaw[0] * 256;
-    *y = LSM6DSL.fvLastAccelRaw[1] * 256;
-    *z = LSM6DSL.fvLastAccelRaw[2] * 256;
+    imuSnapshot_t latest;
+    accelReadLatest(&latest);
+    *x = latest.accelRaw[0];
+    *y = latest.accelRaw[1];
+    *z = latest.accelRaw[2];
     return ESP_OK;
 }
 
@@ -637,11 +708,11 @@ esp_err_t accelGetAccelVecRaw(int16_t* x, int16_t* y, int16_t* z)
  */
 esp_err_t accelGetOrientVec(int16_t* x, int16_t* y, int16_t* z)
 {
-    float plusy[3] = {0, 1, 0};
-    mathRotateVectorByInverseOfQuaternion(plusy, LSM6DSL.fqQuat, plusy);
-    *x = plusy[0] * 256;
-    *y = plusy[1] * 256;
-    *z = plusy[2] * 256;
+    imuSnapshot_t latest;
+    accelReadLatest(&latest);
+    *x = latest.orient[0];
+    *y = latest.orient[1];
+    *z = latest.orient[2];
     return ESP_OK;
 }
 
@@ -652,11 +723,12 @@ esp_err_t accelGetOrientVec(int16_t* x, int16_t* y, int16_t* z)
  */
 esp_err_t accelGetQuaternion(float* q)
 {
-    float* fq = LSM6DSL.fqQuat;
-    q[0]      = fq[0];
-    q[1]      = fq[1];
-    q[2]      = fq[2];
-    q[3]      = fq[3];
+    imuSnapshot_t latest;
+    accelReadLatest(&latest);
+    q[0] = latest.quat[0];
+    q[1] = latest.quat[1];
+    q[2] = latest.quat[2];
+    q[3] = latest.quat[3];
     return ESP_OK;
 }
 
@@ -667,6 +739,12 @@ esp_err_t accelGetQuaternion(float* q)
  */
 esp_err_t accelPerformCal()
 {
+    // The sampling task calibrates, so don't let it see a half-reset calibration
+    if (imuTimer)
+    {
+        esp_timer_stop(imuTimer);
+    }
+
     LSM6DSL.performCal     = 1;
     LSM6DSL.fvDeviation[0] = 1;
     LSM6DSL.fvDeviation[1] = 1;
@@ -675,6 +753,11 @@ esp_err_t accelPerformCal()
     LSM6DSL.fvAverage[1]   = 0;
     LSM6DSL.fvAverage[2]   = 0;
 
+    if (imuTimer)
+    {
+        esp_timer_start_periodic(imuTimer, IMU_SAMPLE_PERIOD_US);
+    }
+
     // Ignore failures here.
     eraseNvsKey("gyrocalx");
     eraseNvsKey("gyrocaly");
@@ -697,10 +780,13 @@ esp_err_t accelPerformCal()
  */
 esp_err_t accelGetSteeringAngleDegrees(int16_t* xcomp, int16_t* ycomp)
 {
+    imuSnapshot_t latest;
+    accelReadLatest(&latest);
+
     // compute steering angle
     float up_from_face_of_controller[3] = {0, 0, 1};
 
-    mathRotateVectorByInverseOfQuaternion(up_from_face_of_controller, LSM6DSL.fqQuat, up_from_face_of_controller);
+    mathRotateVectorByInverseOfQuaternion(up_from_face_of_controller, latest.quat, up_from_face_of_controller);
 
     float up_from_face_of_controller_local[3] = {0, 0, 1};
 
@@ -711,7 +797,7 @@ esp_err_t accelGetSteeringAngleDegrees(int16_t* xcomp, int16_t* ycomp)
     float q[4];
     mathQuatFromTwoVectors(q, up_from_face_of_controller, up_from_face_of_controller_local);
     float q2[4];
-    mathQuatApply(q2, LSM6DSL.fqQuat, q);
+    mathQuatApply(q2, latest.quat, q);
 
     // q2 now has the correct Z-rotation (Because it's in-plane with the virtual Z plane made by the flat surface of the
     // swadge.
@@ -747,6 +833,13 @@ float accelGetStdDevInCal()
  */
 void accelSetRegistersAndReset(void)
 {
+    // The sampling task shares the I2C bus and the fusion. It runs at a higher priority than the caller, so once it is
+    // stopped it can't be partway through a read.
+    if (imuTimer)
+    {
+        esp_timer_stop(imuTimer);
+    }
+
     LSM6DSLSet(LSM6DSL_FIFO_CTRL5, (0b0101 << 3) | 0b000); // Reset FIFO
     LSM6DSLSet(
         LSM6DSL_FIFO_CTRL5,
@@ -778,4 +871,13 @@ void accelSetRegistersAndReset(void)
         LSM6DSL.performCal = 1;
         LSM6DSL.fvBias[2]  = 0;
     }
+
+    imuFusionFixedReset(&fusion, LSM6DSL.fvBias);
+    atomic_store(&calFinished, false);
+    accelPublish();
+
+    if (imuTimer)
+    {
+        esp_timer_start_periodic(imuTimer, IMU_SAMPLE_PERIOD_US);
+    }
 }
@@ -0,0 +1,420 @@
+#include "imu_fusion.h"
+#include "quaternions.h"
+
+#include <string.h>
+
+// Euler angles are converted to Q2.30 from the Q18.46 sum of the scaled gyro and the bias
+#define GYRO_SCALE_Q46 ((int64_t)((float)IMU_GYRO_SCALE * IMU_BIAS_ONE + 0.5))
+// mathsqrtf() returns 0.0001 for anything smaller than 0.0000001
+#define SQRT_FLOOR_IN  107
+#define SQRT_FLOOR_OUT 107374
+// Each correction moves the bias by the square root of the error, times 0.0000002
+#define BIAS_STEP_Q46 14073749
+// The corrective tug is 0.0005 of the error
+#define CORRECTIVE_FORCE_Q30 536871
+// Renormalize the quat every this many samples, about every 77ms at 208 Hz
+#define RENORM_PERIOD 16
+
+//==============================================================================
+// Fixed point math
+//==============================================================================
+
+/**
+ * @brief Multiply two Q2.30 numbers
+ *
+ * @param a The first number
+ * @param b The second number
+ * @return a * b, in Q2.30
+ */
+static inline int32_t fixMul(int32_t a, int32_t b)
+{
+    return (int32_t)(((int64_t)a * b) >> 30);
+}
+
+/**
+ * @brief Take the integer square root of an unsigned 64 bit number, one bit at a time
+ *
+ * @param x The number to take the square root of
+ * @return floor(sqrt(x))
+ */
+static uint32_t fixIsqrt64(uint64_t x)
+{
+    uint64_t root = 0;
+    uint64_t bit  = 1ULL << 62;
+    while (bit > x)
+    {
+        bit >>= 2;
+    }
+    while (bit)
+    {
+        if (x >= root + bit)
+        {
+            x -= root + bit;
+            root = (root >> 1) + bit;
+        }
+        else
+        {
+            root >>= 1;
+        }
+        bit >>= 2;
+    }
+    return (uint32_t)root;
+}
+
+/**
+ * @brief The fixed point twin of mathsqrtf(), including its sign handling, floor and four Newton steps
+ *
+ * @param x The Q2.30 number to take a square root of
+ * @return approximately sqrt(x), in Q2.30
+ */
+static int32_t fixSqrtApprox(int32_t x)
+{
+    int sign = x < 0;
+    if (sign)
+        x = -x;
+    if (x <= SQRT_FLOOR_IN)
+        return SQRT_FLOOR_OUT;
+    int64_t xs = (int64_t)x << 30;
+    int64_t o  = x;
+    o          = (o + xs / o) / 2;
+    o          = (o + xs / o) / 2;
+    o          = (o + xs / o) / 2;
+    o          = (o + xs / o) / 2;
+    if (sign)
+        return -(int32_t)o;
+    else
+        return (int32_t)o;
+}
+
+/**
+ * @brief Perform a 3D cross product in Q2.30
+ *
+ * @param p Pointer to the int32_t[3] output of the cross product (p = a x b)
+ * @param a Pointer to the int32_t[3] of the cross product a vector.
+ * @param b Pointer to the int32_t[3] of the cross product b vector.
+ */
+static void fixCrossProduct(int32_t* p, const int32_t* a, const int32_t* b)
+{
+    int32_t tx = (int32_t)(((int64_t)a[1] * b[2] - (int64_t)a[2] * b[1]) >> 30);
+    int32_t ty = (int32_t)(((int64_t)a[2] * b[0] - (int64_t)a[0] * b[2]) >> 30);
+    p[2]       = (int32_t)(((int64_t)a[0] * b[1] - (int64_t)a[1] * b[0]) >> 30);
+    p[1]       = ty;
+    p[0]       = tx;
+}
+
+/**
+ * @brief Rotate one Q2.30 quaternion by another (and do not normalize)
+ *
+ * @param qout Pointer to the wxyz quat (int32_t[4]) to be written.
+ * @param q1 First quaternion to be rotated.
+ * @param q2 Quaternion to rotate q1 by.
+ */
+static void fixQuatApply(int32_t* qout, const int32_t* q1, const int32_t* q2)
+{
+    int64_t tmpw = (int64_t)q1[0] * q2[0] - (int64_t)q1[1] * q2[1] - (int64_t)q1[2] * q2[2] - (int64_t)q1[3] * q2[3];
+    int64_t tmpx = (int64_t)q1[0] * q2[1] + (int64_t)q1[1] * q2[0] + (int64_t)q1[2] * q2[3] - (int64_t)q1[3] * q2[2];
+    int64_t tmpy = (int64_t)q1[0] * q2[2] - (int64_t)q1[1] * q2[3] + (int64_t)q1[2] * q2[0] + (int64_t)q1[3] * q2[1];
+    int64_t tmpz = (int64_t)q1[0] * q2[3] + (int64_t)q1[1] * q2[2] - (int64_t)q1[2] * q2[1] + (int64_t)q1[3] * q2[0];
+    qout[0]      = (int32_t)(tmpw >> 30);
+    qout[1]      = (int32_t)(tmpx >> 30);
+    qout[2]      = (int32_t)(tmpy >> 30);
+    qout[3]      = (int32_t)(tmpz >> 30);
+}
+
+/**
+ * @brief Rotate a Q2.30 vector by the inverse of a Q2.30 quaternion
+ *
+ * @param pout Pointer to the int32_t[3] output of the antirotation.
+ * @param q Pointer to the wxyz quaternion (int32_t[4]) opposite of the rotation.
+ * @param p Pointer to the int32_t[3] of the vector to antirotate.
+ */
+static void fixRotateVectorByInverseOfQuaternion(int32_t* pout, const int32_t* q, const int32_t* p)
+{
+    int32_t iqo[3];
+    fixCrossProduct(iqo, p, q + 1 /*.xyz*/);
+    iqo[0] += fixMul(q[0], p[0]);
+    iqo[1] += fixMul(q[0], p[1]);
+    iqo[2] += fixMul(q[0], p[2]);
+    int32_t ret[3];
+    fixCrossProduct(ret, iqo, q + 1 /*.xyz*/);
+    pout[0] = (int32_t)((int64_t)ret[0] * 2 + p[0]);
+    pout[1] = (int32_t)((int64_t)ret[1] * 2 + p[1]);
+    pout[2] = (int32_t)((int64_t)ret[2] * 2 + p[2]);
+}
+
+/**
+ * @brief Convert small Q2.30 euler angles (in radians) to a Q2.30 quaternion.
+ *
+ * A single gyro sample turns less than 0.1 radians, so sin and cos of the half angles come from the first terms of
+ * their Taylor series, which are exact to well under one part in 2^30 there.
+ *
+ * @param q Pointer to the wxyz quat (int32_t[4]) to be written.
+ * @param euler Pointer to a int32_t[3] of euler angles.
+ */
+static void fixEulerToQuat(int32_t* q, const int32_t* euler)
+{
+    int32_t s[3], c[3];
+    for (int i = 0; i < 3; i++)
+    {
+        int32_t h  = euler[i] / 2;
+        int32_t h2 = fixMul(h, h);
+        s[i]       = h - fixMul(h2, h) / 6;
+        c[i]       = IMU_Q30_ONE - h2 / 2 + fixMul(h2, h2) / 24;
+    }
+    // Pitch: About X, Yaw: About Y, Roll: About Z
+    int32_t crcp = fixMul(c[0], c[1]);
+    int32_t srsp = fixMul(s[0], s[1]);
+    int32_t srcp = fixMul(s[0], c[1]);
+    int32_t crsp = fixMul(c[0], s[1]);
+    q[0]         = fixMul(crcp, c[2]) + fixMul(srsp, s[2]);
+    q[1]         = fixMul(srcp, c[2]) - fixMul(crsp, s[2]);
+    q[2]         = fixMul(crsp, c[2]) + fixMul(srcp, s[2]);
+    q[3]         = fixMul(crcp, s[2]) - fixMul(srsp, c[2]);
+}
+
+/**
+ * @brief Compute the Q2.30 quaterntion rotation between two Q2.30 vectors, from v1 to v2
+ *
+ * @param qOut Pointer to the int32_t[4] (wxyz) output of the rotation defined by v1 to v2
+ * @param v1 is the vector you are rotating FROM. THIS MUST BE NORMALIZED.
+ * @param v2 is the vector you are rotating TO. THIS MUST BE NORMALIZED.
+ */
+static void fixQuatFromTwoVectors(int32_t* qOut, const int32_t* v1, const int32_t* v2)
+{
+    int64_t sum[3] = {(int64_t)v2[0] + v1[0], (int64_t)v2[1] + v1[1], (int64_t)v2[2] + v1[2]};
+    uint32_t mag   = fixIsqrt64(sum[0] * sum[0] + sum[1] * sum[1] + sum[2] * sum[2]);
+    int32_t half[3];
+    for (int i = 0; i < 3; i++)
+    {
+        half[i] = mag ? (int32_t)((sum[i] * IMU_Q30_ONE) / mag) : 0;
+    }
+
+    fixCrossProduct(qOut + 1, v2, half);
+    qOut[0] = (int32_t)(((int64_t)v2[0] * half[0] + (int64_t)v2[1] * half[1] + (int64_t)v2[2] * half[2]) >> 30);
+}
+
+//==============================================================================
+// Float fusion
+//==============================================================================
+
+/**
+ * @brief Reset the float fusion to the identity rotation
+ *
+ * @param f The fusion to reset
+ * @param bias The float[3] gyro bias, in radians per sample
+ */
+void imuFusionFloatReset(imuFusionFloat_t* f, const float* bias)
+{
+    memset(f, 0, sizeof(*f));
+    f->quat[0]     = 1;
+    f->quatLast[0] = 1;
+    memcpy(f->bias, bias, sizeof(f->bias));
+}
+
+/**
+ * @brief Fuse one sample from the IMU's FIFO with float math. This is the reference the fixed point fusion is
+ * checked against.
+ *
+ * @param f The fusion to update
+ * @param sample Six words from the FIFO, the gyro's XYZ and then the accelerometer's XYZ
+ */
+void imuFusionFloatStep(imuFusionFloat_t* f, const int16_t* sample)
+{
+    const int16_t* euler_deltas = sample; // Euler angles, from gyro.
+    const int16_t* accel_data   = sample + 3;
+
+    // Integrate gyro values into a quaternion.
+    float fScale          = IMU_GYRO_SCALE;
+    float fEulerScales[3] = {-fScale, fScale, -fScale};
+
+    float fEulers[3] = {euler_deltas[0] * fEulerScales[0] + f->bias[0], euler_deltas[1] * fEulerScales[1] + f->bias[1],
+                        euler_deltas[2] * fEulerScales[2] + f->bias[2]};
+
+    mathEulerToQuat(f->quatLast, fEulers);
+    mathQuatApply(f->quat, f->quat, f->quatLast);
+
+    // We want an "up" vector, not a gravity vector. This is "up" in the controller's point of view.
+    float accel_up[3] = {-accel_data[0], accel_data[1], -accel_data[2]};
+
+    float accel_inverse_mag = rsqrtf(accel_up[0] * accel_up[0] + accel_up[1] * accel_up[1] + accel_up[2] * accel_up[2]);
+    f->accelUp[0]           = accel_up[0] * accel_inverse_mag;
+    f->accelUp[1]           = accel_up[1] * accel_inverse_mag;
+    f->accelUp[2]           = accel_up[2] * accel_inverse_mag;
+
+    if (f->sampCount++ == 0)
+    {
+        // set quat to be the rotation to go from our "up" from the accelerometer to the nominal "up"
+        float ideal_up[3] = {0, 1, 0};
+        mathQuatFromTwoVectors(f->quat, ideal_up, f->accelUp);
+    }
+    else
+    {
+        // Compute what we think "up" should be from our point of view. We will use +Y Up.
+        float what_we_think_is_up[3] = {0, 1, 0};
+        mathRotateVectorByInverseOfQuaternion(what_we_think_is_up, f->quat, what_we_think_is_up);
+
+        // TRICKY: The ouput of this is actually the axis of rotation, which is ironically
+        // in vector-form the same as a quaternion.  So we can write directly into the quat.
+        float corrective_quaternion[4];
+        mathCrossProduct(corrective_quaternion + 1, f->accelUp, what_we_think_is_up);
+        memcpy(f->correctLast, corrective_quaternion + 1, sizeof(f->correctLast));
+
+        // Anti-drift the axes. If you do only this, you will always end up in an unstable oscillation.
+        f->bias[0] += mathsqrtf(corrective_quaternion[1]) * 0.0000002;
+        f->bias[1] += mathsqrtf(corrective_quaternion[2]) * 0.0000002;
+        f->bias[2] += mathsqrtf(corrective_quaternion[3]) * 0.0000002;
+
+        // Apply a very small corrective tug, sort of like a P term to a PID loop.
+        float corrective_force = 0.0005f;
+        corrective_quaternion[1] *= corrective_force;
+        corrective_quaternion[2] *= corrective_force;
+        corrective_quaternion[3] *= corrective_force;
+
+        // x^2+y^2+z^2+q^2 -> ALGEBRA! -> sqrt( 1-x^2-y^2-z^2 ) = w
+        corrective_quaternion[0] = mathsqrtf(1 - corrective_quaternion[1] * corrective_quaternion[1]
+                                             - corrective_quaternion[2] * corrective_quaternion[2]
+                                             - corrective_quaternion[3] * corrective_quaternion[3]);
+
+        mathQuatApply(f->quat, f->quat, corrective_quaternion);
+    }
+
+    // Renormalize periodically. Only normalizing once the magnitude leaves [0.95, 1.05] lets rounding error shape the
+    // rotation for minutes at a time, and the float and fixed point fusions then drift apart.
+    if (0 == f->sampCount % RENORM_PERIOD)
+    {
+        mathQuatNormalize(f->quat, f->quat);
+    }
+}
+
+//==============================================================================
+// Fixed point fusion
+//==============================================================================
+
+/**
+ * @brief Reset the fixed point fusion to the identity rotation
+ *
+ * @param f The fusion to reset
+ * @param bias The float[3] gyro bias, in radians per sample
+ */
+void imuFusionFixedReset(imuFusionFixed_t* f, const float* bias)
+{
+    memset(f, 0, sizeof(*f));
+    f->quat[0] = IMU_Q30_ONE;
+    imuFusionFixedSetBias(f, bias);
+}
+
+/**
+ * @brief Set the gyro bias of the fixed point fusion, i.e. after calibrating
+ *
+ * @param f The fusion to update
+ * @param bias The float[3] gyro bias, in radians per sample
+ */
+void imuFusionFixedSetBias(imuFusionFixed_t* f, const float* bias)
+{
+    f->bias[0] = (int64_t)(bias[0] * (float)IMU_BIAS_ONE);
+    f->bias[1] = (int64_t)(bias[1] * (float)IMU_BIAS_ONE);
+    f->bias[2] = (int64_t)(bias[2] * (float)IMU_BIAS_ONE);
+}
+
+/**
+ * @brief Fuse one sample from the IMU's FIFO with integer math. Every step mirrors imuFusionFloatStep().
+ *
+ * @param f The fusion to update
+ * @param sample Six words from the FIFO, the gyro's XYZ and then the accelerometer's XYZ
+ */
+void imuFusionFixedStep(imuFusionFixed_t* f, const int16_t* sample)
+{
+    const int16_t* euler_deltas = sample;
+    const int16_t* accel_data   = sample + 3;
+
+    // Integrate gyro values into a quaternion.
+    int32_t eulers[3] = {
+        (int32_t)((-euler_deltas[0] * GYRO_SCALE_Q46 + f->bias[0]) >> 16),
+        (int32_t)((euler_deltas[1] * GYRO_SCALE_Q46 + f->bias[1]) >> 16),
+        (int32_t)((-euler_deltas[2] * GYRO_SCALE_Q46 + f->bias[2]) >> 16),
+    };
+
+    int32_t quatLast[4];
+    fixEulerToQuat(quatLast, eulers);
+    fixQuatApply(f->quat, f->quat, quatLast);
+
+    // Normalize the "up" vector from the accelerometer
+    int32_t accel_up[3] = {-accel_data[0], accel_data[1], -accel_data[2]};
+    uint32_t mag        = fixIsqrt64((int64_t)accel_up[0] * accel_up[0] + (int64_t)accel_up[1] * accel_up[1]
+                                     + (int64_t)accel_up[2] * accel_up[2]);
+    int64_t inv_mag     = mag ? (1LL << 46) / mag : 0;
+    f->accelUp[0]       = (int32_t)((accel_up[0] * inv_mag) >> 16);
+    f->accelUp[1]       = (int32_t)((accel_up[1] * inv_mag) >> 16);
+    f->accelUp[2]       = (int32_t)((accel_up[2] * inv_mag) >> 16);
+
+    if (f->sampCount++ == 0)
+    {
+        int32_t ideal_up[3] = {0, IMU_Q30_ONE, 0};
+        fixQuatFromTwoVectors(f->quat, ideal_up, f->accelUp);
+    }
+    else
+    {
+        int32_t what_we_think_is_up[3] = {0, IMU_Q30_ONE, 0};
+        fixRotateVectorByInverseOfQuaternion(what_we_think_is_up, f->quat, what_we_think_is_up);
+
+        int32_t corrective_quaternion[4];
+        fixCrossProduct(corrective_quaternion + 1, f->accelUp, what_we_think_is_up);
+        memcpy(f->correctLast, corrective_quaternion + 1, sizeof(f->correctLast));
+
+        f->bias[0] += ((int64_t)fixSqrtApprox(corrective_quaternion[1]) * BIAS_STEP_Q46) >> 30;
+        f->bias[1] += ((int64_t)fixSqrtApprox(corrective_quaternion[2]) * BIAS_STEP_Q46) >> 30;
+        f->bias[2] += ((int64_t)fixSqrtApprox(corrective_quaternion[3]) * BIAS_STEP_Q46) >> 30;
+
+        corrective_quaternion[1] = fixMul(corrective_quaternion[1], CORRECTIVE_FORCE_Q30);
+        corrective_quaternion[2] = fixMul(corrective_quaternion[2], CORRECTIVE_FORCE_Q30);
+        corrective_quaternion[3] = fixMul(corrective_quaternion[3], CORRECTIVE_FORCE_Q30);
+
+        corrective_quaternion[0]
+            = fixSqrtApprox(IMU_Q30_ONE - fixMul(corrective_quaternion[1], corrective_quaternion[1])
+                            - fixMul(corrective_quaternion[2], corrective_quaternion[2])
+                            - fixMul(corrective_quaternion[3], corrective_quaternion[3]));
+
+        fixQuatApply(f->quat, f->quat, corrective_quaternion);
+    }
+
+    // Renormalize on the same samples as the float fusion
+    if (0 == f->sampCount % RENORM_PERIOD)
+    {
+        int32_t* qRot = f->quat;
+        uint32_t qmag = fixIsqrt64((int64_t)qRot[0] * qRot[0] + (int64_t)qRot[1] * qRot[1]
+                                   + (int64_t)qRot[2] * qRot[2] + (int64_t)qRot[3] * qRot[3]);
+        if (qmag)
+        {
+            qRot[0] = (int32_t)((int64_t)qRot[0] * IMU_Q30_ONE / qmag);
+            qRot[1] = (int32_t)((int64_t)qRot[1] * IMU_Q30_ONE / qmag);
+            qRot[2] = (int32_t)((int64_t)qRot[2] * IMU_Q30_ONE / qmag);
+            qRot[3] = (int32_t)((int64_t)qRot[3] * IMU_Q30_ONE / qmag);
+        }
+    }
+}
+
+/**
+ * @brief Get the rotation of the fixed point fusion as a float quaternion
+ *
+ * @param f The fusion to read
+ * @param q Pointer to the wxyz quat (float[4]) to be written.
+ */
+void imuFusionFixedGetQuat(const imuFusionFixed_t* f, float* q)
+{
+    q[0] = f->quat[0] * (1.0f / IMU_Q30_ONE);
+    q[1] = f->quat[1] * (1.0f / IMU_Q30_ONE);
+    q[2] = f->quat[2] * (1.0f / IMU_Q30_ONE);
+    q[3] = f->quat[3] * (1.0f / IMU_Q30_ONE);
+}
+
+/**
+ * @brief Get the orientation "up" vector of the fixed point fusion, from the device's point of view
+ *
+ * @param f The fusion to read
+ * @param v Pointer to the int32_t[3] to write the Q2.30 vector to
+ */
+void imuFusionFixedGetOrient(const imuFusionFixed_t* f, int32_t* v)
+{
+    int32_t plusy[3] = {0, IMU_Q30_ONE, 0};
+    fixRotateVectorByInverseOfQuaternion(v, f->quat, plusy);
+}
@@ -8,7 +8,12 @@
  * Unlike the accelerometer process, the IMU fuses the gyroscope and accelerometer data from the LMS6DSL.  By fusing
  * both sensors, we are able to produce a quaternion to represent the rotation of the swadge.  The idea is that
  * we run the IMU at 208 Hz, and we use the hardware FIFO built into the LSM6DSL to queue up events.  Then, every
- * frame, we empty out the FIFO.
+ * 10ms, a timer task empties out the FIFO and fuses the samples.
+ *
+ * The Swadge has no FPU, so the fusion runs in Q2.30 fixed point (see imu_fusion.h). It mirrors the float fusion step
+ * for step, and the float fusion is kept as the reference. The emulator's \c --imu-replay option replays a recorded
+ * FIFO dump through both and reports how far apart they are. Each pass publishes the quaternion and "up" vectors so
+ * the getters only copy them.
  *
  * \section imu_usage Usage
  *
@@ -17,13 +22,14 @@
  *
  * accelSetRegistersAndReset() \b must be called when entering a Swadge mode that uses the IMU.
  *
- * accelIntegrate() \b should be called periodically. This can be done either in the mode's main loop or in the
- * background draw callback. If this is called from the background draw callback, make sure to only call it once per
- * frame, since multiple callbacks are called per-frame.
+ * accelIntegrate() copies the latest fused sample into ::LSM6DSL, and saves a finished calibration to NVS. Call it
+ * periodically if you read ::LSM6DSL directly or calibrate with accelPerformCal(). The getters don't need it.
  *
  * The functions you can use to get acceleration data are:
  *  - accelGetAccelVecRaw()
+ *  - accelGetOrientVec()
  *  - accelGetQuaternion()
+ *  - accelGetSteeringAngleDegrees()
  *
  * \section imu_example Example
  *
@@ -0,0 +1,47 @@
+#ifndef _IMU_FUSION_H_
+#define _IMU_FUSION_H_
+
+#include <stdint.h>
+
+// 2000 dps full-scale, 32768 is full-scale, 208 SPS, converted to radians, with a measured fudge factor
+#define IMU_GYRO_SCALE ((2000.0f / 32768.0f / 208.0f * 2.0 * 3.14159f / 180.0f) * 0.5625f)
+
+#define IMU_Q30_ONE  (1 << 30)   ///< 1.0 in the Q2.30 format used for quaternions and vectors
+#define IMU_BIAS_ONE (1LL << 46) ///< 1.0 in the Q18.46 format used for gyro bias, which drifts in tiny steps
+
+/**
+ * @brief The float sensor fusion, which the fixed point fusion is checked against
+ *
+ * Quats are wxyz. You can take a vector, in controller space, rotate by the quat, and you get it in world space.
+ */
+typedef struct
+{
+    float quat[4];        ///< Absolute rotation
+    float quatLast[4];    ///< Rotation from the last gyro sample
+    float accelUp[3];     ///< The last normalized "up" vector from the accelerometer (NOT FUSED)
+    float bias[3];        ///< Bias for all of the euler angles
+    float correctLast[3]; ///< The last error between the accelerometer and the fused "up"
+    uint32_t sampCount;   ///< Samples fused since the last reset
+} imuFusionFloat_t;
+
+/**
+ * @brief The fixed point sensor fusion. Each step mirrors imuFusionFloatStep() in integer math.
+ */
+typedef struct
+{
+    int32_t quat[4];        ///< Absolute rotation, Q2.30
+    int32_t accelUp[3];     ///< The last normalized "up" vector from the accelerometer, Q2.30
+    int64_t bias[3];        ///< Bias for all of the euler angles, Q18.46
+    int32_t correctLast[3]; ///< The last error between the accelerometer and the fused "up", Q2.30
+    uint32_t sampCount;     ///< Samples fused since the last reset
+} imuFusionFixed_t;
+
+void imuFusionFloatReset(imuFusionFloat_t* f, const float* bias);
+void imuFusionFloatStep(imuFusionFloat_t* f, const int16_t* sample);
+void imuFusionFixedReset(imuFusionFixed_t* f, const float* bias);
+void imuFusionFixedSetBias(imuFusionFixed_t* f, const float* bias);
+void imuFusionFixedStep(imuFusionFixed_t* f, const int16_t* sample);
+void imuFusionFixedGetQuat(const imuFusionFixed_t* f, float* q);
+void imuFusionFixedGetOrient(const imuFusionFixed_t* f, int32_t* v);
+
+#endif
@@ -4,7 +4,9 @@
 
 #include <driver/rmt_tx.h>
 #include <esp_rom_gpio.h>
+#include <esp_timer.h>
 #include <soc/gpio_sig_map.h>
+#include <stdatomic.h>
 #include <string.h>
 #include <driver/gpio.h>
 
@@ -18,14 +20,80 @@
 /// 10MHz resolution, 1 tick = 0.1us (led strip needs a high resolution)
 #define RMT_LED_STRIP_RESOLUTION_HZ 10000000
 
+/// How often the LEDs are refreshed. Sending nine LEDs takes about 300us.
+#define LED_REFRESH_PERIOD_US 2000
+
+/// The number of fractional bits of each channel kept for temporal dithering. More bits make smoother fades but
+/// flicker at a lower rate, the slowest being (1000000 / LED_REFRESH_PERIOD_US) >> LED_DITHER_BITS Hz
+#define LED_DITHER_BITS 3
+
+/// The bits of a brightness-scaled channel which are kept, the integer part and LED_DITHER_BITS of the fraction
+#define LED_DITHER_MASK (0xFFFF & ~(0xFF >> LED_DITHER_BITS))
+
+/// How long the LEDs are dithered after they stop changing. Then a rounded frame is sent and nothing more is sent until
+/// they change, rather than retransmitting every refresh forever
+#define LED_DITHER_SETTLE_US 250000
+
+//==============================================================================
+// Const Variables
+//==============================================================================
+
+/// The light output of each brightness setting, as a 0.16 fixed point fraction of full output. Each step is
+/// ((setting / MAX_LED_BRIGHTNESS) ^ 2.2) so the steps look evenly spaced. This must match the emulator's table.
+static const uint32_t brightnessGains[MAX_LED_BRIGHTNESS + 1] = {
+    0, 676, 3104, 7574, 14263, 23303, 34803, 48854, 65536,
+};
+
+//==============================================================================
+// Function Prototypes
+//==============================================================================
+
+static bool IRAM_ATTR ledTxDoneCb(rmt_channel_handle_t channel, const rmt_tx_done_event_data_t* edata,
+                                  void* user_ctx);
+static void ledRefreshCb(void* arg);
+static bool ledRefresh(bool dither);
+static uint8_t ledRound(uint16_t scaled);
+
 //==============================================================================
 // Variables
 //==============================================================================
 
 static rmt_channel_handle_t led_chan    = NULL;
 static rmt_encoder_handle_t led_encoder = NULL;
-static uint8_t ledBrightness            = 0;
-static led_t localLeds[CONFIG_NUM_LEDS] = {0};
+
+/// Timer which refreshes the LEDs, independent of how often setLeds() is called
+static esp_timer_handle_t refreshTimer = NULL;
+/// true when the refresh timer is stopped by flushLeds()
+static bool refreshPaused = false;
+
+/// Each channel value scaled by the brightness, as an 8.8 fixed point number
+static uint16_t brightnessLut[256] = {0};
+/// Set when the brightness changes, so the LEDs are refreshed even if setLeds() isn't called
+static volatile bool brightnessChanged = false;
+
+/// The LEDs most recently passed to setLeds(), before brightness is applied
+static led_t requestedLeds[CONFIG_NUM_LEDS] = {0};
+/// The number of LEDs most recently passed to setLeds()
+static uint8_t requestedNumLeds = 0;
+/// Odd while requestedLeds is being written, incremented by two for each call to setLeds()
+static atomic_uint requestedSeq;
+
+/// Two buffers, so one can be filled while the RMT sends the other
+static led_t txLeds[2][CONFIG_NUM_LEDS] = {0};
+/// The buffer to fill next
+static uint8_t txIdx = 0;
+/// The number of transmissions the RMT hasn't finished
+static atomic_uint txInFlight;
+/// The value of requestedSeq when the LEDs were last refreshed
+static unsigned int txSeq = 0;
+/// The fraction of each channel not yet shown, carried from one refresh to the next
+static uint8_t ditherError[CONFIG_NUM_LEDS * sizeof(led_t)] = {0};
+/// true if any channel has a fraction, so the LEDs must keep being refreshed
+static bool dithering = false;
+/// The number of refreshes since the LEDs or brightness last changed
+static uint32_t unchangedRefreshes = 0;
+/// Set while the LEDs are being refreshed, so the timer and flushLeds() don't both refresh
+static atomic_flag refreshBusy = ATOMIC_FLAG_INIT;
 
 //==============================================================================
 // Functions
@@ -57,6 +125,11 @@ esp_err_t initLeds(gpio_num_t gpio, gpio_num_t gpioAlt, uint8_t brightness)
     };
     ESP_ERROR_CHECK(rmt_new_led_strip_encoder(&encoder_config, &led_encoder));
 
+    rmt_tx_event_callbacks_t cbs = {
+        .on_trans_done = ledTxDoneCb,
+    };
+    ESP_ERROR_CHECK(rmt_tx_register_event_callbacks(led_chan, &cbs, NULL));
+
     ESP_ERROR_CHECK(rmt_enable(led_chan));
 
     if (GPIO_NUM_NC != gpioAlt)
@@ -79,6 +152,18 @@ esp_err_t initLeds(gpio_num_t gpio, gpio_num_t gpioAlt, uint8_t brightness)
         // changes, this will break!!!
         esp_rom_gpio_connect_out_signal(gpioAlt, RMT_SIG_OUT0_IDX + *((int*)led_chan), false, false);
     }
+
+    /* Refresh the LEDs in the background */
+    const esp_timer_create_args_t refreshTimerArgs = {
+        .callback              = ledRefreshCb,
+        .arg                   = NULL,
+        .dispatch_method       = ESP_TIMER_TASK,
+        .name                  = "leds",
+        .skip_unhandled_events = true,
+    };
+    ESP_ERROR_CHECK(esp_timer_create(&refreshTimerArgs, &refreshTimer));
+    ESP_ERROR_CHECK(esp_timer_start_periodic(refreshTimer, LED_REFRESH_PERIOD_US));
+    refreshPaused = false;
     return ESP_OK;
 }
 
@@ -89,6 +174,14 @@ esp_err_t initLeds(gpio_num_t gpio, gpio_num_t gpioAlt, uint8_t brightness)
  */
 esp_err_t deinitLeds(void)
 {
+    if (!refreshPaused)
+    {
+        ESP_ERROR_CHECK(esp_timer_stop(refreshTimer));
+    }
+    ESP_ERROR_CHECK(esp_timer_delete(refreshTimer));
+    refreshTimer  = NULL;
+    refreshPaused = false;
+    ESP_ERROR_CHECK(rmt_tx_wait_all_done(led_chan, -1));
     ESP_ERROR_CHECK(rmt_disable(led_chan));
     ESP_ERROR_CHECK(rmt_del_encoder(led_encoder));
     ESP_ERROR_CHECK(rmt_del_channel(led_chan));
@@ -103,44 +196,57 @@ esp_err_t deinitLeds(void)
  */
 void setLedBrightness(uint8_t brightness)
 {
-    // LED channels are right-shifted by this value when being set
-    ledBrightness = (MAX_LED_BRIGHTNESS - brightness);
+    if (brightness > MAX_LED_BRIGHTNESS)
+    {
+        brightness = MAX_LED_BRIGHTNESS;
+    }
+
+    // Scale every channel value once here, rather than every refresh
+    for (uint32_t v = 0; v < 256; v++)
+    {
+        brightnessLut[v] = (v * brightnessGains[brightness]) >> 8;
+    }
+    brightnessChanged = true;
 }
 
 /**
- * @brief Set the RGB LEDs to the given values
+ * @brief Set the RGB LEDs to the given values. This only copies the values, they are sent to the LEDs on the next
+ * refresh, so it is cheap and never waits for the LEDs. If it's called more than once between refreshes, only the last
+ * values are shown.
  *
  * @param leds A pointer to an array of ::led_t structs to set the LEDs to. The array must have at least numLeds
  * elements
  * @param numLeds The number of LEDs to set, probably CONFIG_NUM_LEDS
- * @return ESP_OK if the LEDs were set, or a nonzero value if they did were not
+ * @return ESP_OK
  */
 esp_err_t setLeds(led_t* leds, uint8_t numLeds)
 {
-    rmt_transmit_config_t tx_config = {
-        .loop_count = 0, // no transfer loop
-    };
-
     // Make sure to not overflow
     if (numLeds > CONFIG_NUM_LEDS)
     {
         numLeds = CONFIG_NUM_LEDS;
     }
 
-    // Fill a local copy of LEDs with brightness applied
-    for (uint8_t i = 0; i < numLeds; i++)
+    // The refresh skips a copy it catches in the middle of being written
+    unsigned int seq = atomic_load_explicit(&requestedSeq, memory_order_relaxed);
+    atomic_store_explicit(&requestedSeq, seq + 1, memory_order_relaxed);
+    atomic_thread_fence(memory_order_release);
+    memcpy(requestedLeds, leds, numLeds * sizeof(led_t));
+    requestedNumLeds = numLeds;
+    atomic_store_explicit(&requestedSeq, seq + 2, memory_order_release);
+
+    // The LEDs may have been deinitialized, in which case there's no timer to restart
+    if (refreshPaused && NULL != refreshTimer)
     {
-        localLeds[i].r = (leds[i].r >> ledBrightness);
-        localLeds[i].g = (leds[i].g >> ledBrightness);
-        localLeds[i].b = (leds[i].b >> ledBrightness);
+        refreshPaused = false;
+        esp_timer_start_periodic(refreshTimer, LED_REFRESH_PERIOD_US);
     }
-
-    // Write RGB values to LEDs
-    return rmt_transmit(led_chan, led_encoder, (uint8_t*)localLeds, numLeds * sizeof(led_t), &tx_config);
+    return ESP_OK;
 }
 
 /**
- * @brief Write the current LED state into the given array
+ * @brief Write the current LED state into the given array. This is what was last passed to setLeds(), before
+ * brightness is applied, so it may be passed to setLeds() again to restore the LEDs.
  *
  * @param[out] leds The LED array to write the state into
  * @param numLeds The maximum number of LEDs to write
@@ -155,7 +261,7 @@ uint8_t getLedState(led_t* leds, uint8_t numLeds)
             numLeds = CONFIG_NUM_LEDS;
         }
 
-        memcpy(leds, localLeds, sizeof(led_t) * numLeds);
+        memcpy(leds, requestedLeds, sizeof(led_t) * numLeds);
         return numLeds;
     }
 
@@ -163,9 +269,163 @@ uint8_t getLedState(led_t* leds, uint8_t numLeds)
 }
 
 /**
- * @brief Wait until any pending LED transactions are finished, then return
+ * @brief Send the last values passed to setLeds() and wait until all LED transactions are finished, then return.
+ * Refreshing pauses until setLeds() is called again, so nothing is sent during light sleep.
+ *
+ * The values are rounded rather than dithered. A dithered frame would be held for the whole sleep, so callers which
+ * flush before every short sleep would show a slow flicker.
  */
 void flushLeds(void)
 {
+    if (NULL == refreshTimer)
+    {
+        return;
+    }
+
+    if (!refreshPaused)
+    {
+        refreshPaused = true;
+        esp_timer_stop(refreshTimer);
+    }
+
+    // Wait for a buffer to be free and for a refresh from the timer to finish, then send the latest values
+    do
+    {
+        rmt_tx_wait_all_done(led_chan, -1);
+    } while (!ledRefresh(false));
     rmt_tx_wait_all_done(led_chan, -1);
 }
+
+/**
+ * @brief Count a finished transmission, so its buffer may be filled again
+ *
+ * @param channel The RMT channel
+ * @param edata The transmission event data
+ * @param user_ctx Unused
+ * @return false, no task was woken
+ */
+static bool IRAM_ATTR ledTxDoneCb(rmt_channel_handle_t channel, const rmt_tx_done_event_data_t* edata,
+                                  void* user_ctx)
+{
+    atomic_fetch_sub_explicit(&txInFlight, 1, memory_order_release);
+    return false;
+}
+
+/**
+ * @brief Timer callback which refreshes the LEDs
+ *
+ * @param arg Unused
+ */
+static void ledRefreshCb(void* arg)
+{
+    ledRefresh(true);
+}
+
+/**
+ * @brief Round a brightness-scaled channel to the nearest integer, keeping channels which aren't off lit
+ *
+ * @param scaled The channel scaled by the brightness, as an 8.8 fixed point number
+ * @return The rounded channel
+ */
+static uint8_t ledRound(uint16_t scaled)
+{
+    uint8_t rounded = (scaled + 0x80) >> 8;
+    return (0 == rounded && 0 != scaled) ? 1 : rounded;
+}
+
+/**
+ * @brief Scale the latest LEDs by the brightness, dither or round them, and send them from whichever buffer isn't
+ * being sent.
+ *
+ * When dithering, nothing is sent if the LEDs haven't changed and aren't being dithered. Once they have been unchanged
+ * for LED_DITHER_SETTLE_US, a rounded frame is sent and dithering stops until they change. When not dithering, a
+ * rounded frame is always sent and the dither error is left alone.
+ *
+ * @param dither true to dither the fraction of each channel over several refreshes, false to round it
+ * @return true if the refresh ran, false if it was skipped because another refresh or both buffers were busy, or
+ * setLeds() was writing the LEDs
+ */
+static bool ledRefresh(bool dither)
+{
+    if (atomic_flag_test_and_set(&refreshBusy))
+    {
+        return false;
+    }
+
+    // With both buffers being sent, neither can be filled
+    if (atomic_load_explicit(&txInFlight, memory_order_acquire) >= 2)
+    {
+        atomic_flag_clear(&refreshBusy);
+        return false;
+    }
+
+    // Copy the requested LEDs, unless setLeds() is in the middle of writing them
+    unsigned int seq = atomic_load_explicit(&requestedSeq, memory_order_acquire);
+    if (seq & 1)
+    {
+        atomic_flag_clear(&refreshBusy);
+        return false;
+    }
+    bool changed = (seq != txSeq) || brightnessChanged;
+    if (dither && !(changed || dithering))
+    {
+        atomic_flag_clear(&refreshBusy);
+        return true;
+    }
+    uint8_t raw[CONFIG_NUM_LEDS * sizeof(led_t)];
+    uint8_t numLeds = requestedNumLeds;
+    memcpy(raw, requestedLeds, sizeof(raw));
+    atomic_thread_fence(memory_order_acquire);
+    if (seq != atomic_load_explicit(&requestedSeq, memory_order_relaxed))
+    {
+        atomic_flag_clear(&refreshBusy);
+        return false;
+    }
+    txSeq             = seq;
+    brightnessChanged = false;
+
+    // Stop dithering once the LEDs have settled
+    unchangedRefreshes = changed ? 0 : unchangedRefreshes + 1;
+    if (unchangedRefreshes >= LED_DITHER_SETTLE_US / LED_REFRESH_PERIOD_US)
+    {
+        dither    = false;
+        dithering = false;
+    }
+
+    uint8_t* out = (uint8_t*)txLeds[txIdx];
+    if (dither)
+    {
+        // Scale each channel, then round it up or down so that over several refreshes it averages to the scaled value
+        dithering = false;
+        for (uint32_t i = 0; i < numLeds * sizeof(led_t); i++)
+        {
+            uint16_t scaled = brightnessLut[raw[i]] & LED_DITHER_MASK;
+            uint16_t total  = scaled + ditherError[i];
+            out[i]          = total >> 8;
+            ditherError[i]  = total & 0xFF;
+            dithering |= (0 != (scaled & 0xFF));
+        }
+    }
+    else
+    {
+        for (uint32_t i = 0; i < numLeds * sizeof(led_t); i++)
+        {
+            out[i] = ledRound(brightnessLut[raw[i]]);
+        }
+    }
+
+    rmt_transmit_config_t tx_config = {
+        .loop_count = 0, // no transfer loop
+    };
+    atomic_fetch_add_explicit(&txInFlight, 1, memory_order_relaxed);
+    if (ESP_OK == rmt_transmit(led_chan, led_encoder, out, numLeds * sizeof(led_t), &tx_config))
+    {
+        txIdx ^= 1;
+    }
+    else
+    {
+        atomic_fetch_sub_explicit(&txInFlight, 1, memory_order_relaxed);
+    }
+    atomic_flag_clear(&refreshBusy);
+    return true;
+}
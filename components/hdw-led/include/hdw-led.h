@@ -17,18 +17,28 @@
  *
  * You don't need to call initLeds() or deinitLeds(). The system does so at the appropriate time.
  *
- * You should call setLeds() any time you want to set the LEDs. There is no buffer, so the LEDs are immediately set to
- * the values given. setLeds() takes a pointer to an array of ::led_t as an argument. These structs each have a red,
- * green, and blue field.
+ * You should call setLeds() any time you want to set the LEDs. setLeds() takes a pointer to an array of ::led_t as an
+ * argument. These structs each have a red, green, and blue field. setLeds() only copies the values and returns, so it
+ * may be called as often as you like, even from time-sensitive code. A timer refreshes the LEDs every two milliseconds
+ * with the latest values, from one of two buffers so a transmission in progress is never overwritten. If setLeds() is
+ * called more than once between refreshes, only the last values are shown.
  *
  * setLedBrightness() may be called to adjust overall LED brightness.
- * Brightness is adjusted per-color-channel, so dimming may produce different colors.
+ * Each brightness step scales light output along a gamma curve, so the steps look evenly spaced. Scaled channels keep a
+ * fraction, which is shown by rounding up on some refreshes and down on others (temporal dithering). This keeps dim
+ * colors from being rounded to black, and makes slow fades smooth. A quarter second after the LEDs stop changing,
+ * dithering stops and a rounded frame is sent, so the LEDs aren't retransmitted forever. Channels which aren't off are
+ * never rounded down to black.
  * setLedBrightnessSetting() should be called instead if the brightness change should be persistent through reboots.
  *
- * flushLeds() may be called to wait until all pending LED transactions are completed. This does not need to be called
- * under normal operation. The RMT peripheral handles updating LEDs in the background automatically, but transactions
- * must be flushed before entering light sleep. If they are not, garbage data may be sent after light sleep begins,
- * resulting in indeterminate LED behavior.
+ * getLedState() returns the values last passed to setLeds(), before brightness is applied, so they can be restored
+ * later.
+ *
+ * flushLeds() may be called to send the latest values and wait until all pending LED transactions are completed. This
+ * does not need to be called under normal operation, but transactions must be flushed before entering light sleep. If
+ * they are not, garbage data may be sent after light sleep begins, resulting in indeterminate LED behavior. The values
+ * are rounded rather than dithered, so a frame held through light sleep doesn't flicker. Refreshing pauses after
+ * flushLeds() until setLeds() is called again.
  *
  * \section led_example Example
  *
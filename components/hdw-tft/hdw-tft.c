@@ -17,6 +17,7 @@
 #include <driver/gpio.h>
 
 #include "hdw-tft.h"
+#include "trace.h"
 
 // #define PROC_PROFILE
 
@@ -475,7 +476,9 @@ void drawDisplayTft(fnBackgroundDrawCallback_t fnBackgroundDrawCallback)
         // of frames has been sent.
 
         // Send the calculated data
+        TRACE_BEGIN(TRACE_TFT_CHUNK);
         esp_lcd_panel_draw_bitmap(panel_handle, 0, y, TFT_WIDTH, y + PARALLEL_LINES, s_lines[sending_line]);
+        TRACE_END(TRACE_TFT_CHUNK);
 
         if (y == 0 && fnBackgroundDrawCallback)
         {
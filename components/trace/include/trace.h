@@ -0,0 +1,110 @@
+/*! \file trace.h
+ *
+ * \section trace_design Design Philosophy
+ *
+ * This component records timestamped events to measure latency through the system, for instance from a button press
+ * being captured in an interrupt, through the Swadge mode's main loop, to the frame which reflects it being sent to the
+ * TFT. It is opt-in and compiled out entirely unless \c CONFIG_TRACE_ENABLE is set, which is done in \c menuconfig for
+ * the firmware and always for the emulator.
+ *
+ * Events are written into a fixed ring buffer of \c CONFIG_TRACE_BUFFER_LEN entries in RAM. Writing an event is
+ * lock-free and safe from interrupts and other tasks, so recording doesn't change the timing being measured much. The
+ * main loop calls traceFlush() once per iteration, which writes out buffered events once the buffer is half full.
+ * deinitTrace() calls traceFlushAll() to write out whatever is left. If the buffer fills before being flushed, new
+ * events are dropped and counted.
+ *
+ * Events are written in the JSON Array Format of the Chrome trace event format, which can be opened in \c
+ * chrome://tracing or https://ui.perfetto.dev. Spans are drawn as bars on one track per ::traceTrack_t. Events
+ * are put on the track of the task or thread they run in, which can differ between the firmware and the emulator, e.g.
+ * ::TRACE_DAC_FILL runs in the main loop on the firmware and in the audio thread in the emulator.
+ *
+ * On the firmware, events are printed over the serial console, each line prefixed with \c "TRACE ", and interleaved
+ * with any other log output. To get a trace file, capture the serial output, keep only those lines, and remove the
+ * prefix, e.g. <tt>grep '^TRACE ' log.txt | cut -c7- > trace.json</tt>. Printing takes time, so the spans immediately
+ * after a flush are slightly perturbed.
+ *
+ * In the emulator, tracing is only active if the \c --trace option is given, and events are written to that file
+ * instead.
+ *
+ * \section trace_usage Usage
+ *
+ * You don't need to call initTrace(), deinitTrace(), traceFlush(), or traceFlushAll(). The system does at the
+ * appropriate times.
+ *
+ * Use the TRACE_BEGIN() and TRACE_END() macros around a span of code, or TRACE_INSTANT() to mark a point in time. New
+ * event types may be added to ::traceId_t, along with a name and track in traceInfo, in trace.c.
+ *
+ * \section trace_example Example
+ *
+ * \code{.c}
+ * TRACE_BEGIN(TRACE_MAIN_LOOP);
+ * cSwadgeMode->fnMainLoop(elapsedUs);
+ * TRACE_END(TRACE_MAIN_LOOP);
+ * \endcode
+ */
+
+#ifndef _TRACE_H_
+#define _TRACE_H_
+
+#include <stdint.h>
+
+/**
+ * @brief The events which can be traced
+ */
+typedef enum
+{
+    TRACE_BTN_ISR,     ///< A push-button state was queued by the button interrupt. The argument is the button state
+    TRACE_BTN_DEQUEUE, ///< A button event was received by the Swadge mode. The argument is the button state
+    TRACE_TOUCH,       ///< A touch event was received by the Swadge mode. The argument is the touch angle
+    TRACE_MAIN_LOOP,   ///< The Swadge mode's main loop
+    TRACE_TFT_FRAME,   ///< Sending a whole frame to the TFT
+    TRACE_TFT_CHUNK,   ///< Sending one chunk of rows to the TFT
+    TRACE_DAC_FILL,    ///< Filling a buffer of audio samples for the DAC
+    TRACE_ESP_NOW_RX,  ///< Handling a received ESP-NOW packet
+    TRACE_NUM_IDS,     ///< The number of event types
+} traceId_t;
+
+/**
+ * @brief The kind of a trace event
+ */
+typedef enum
+{
+    TRACE_PH_BEGIN,   ///< The start of a span
+    TRACE_PH_END,     ///< The end of a span
+    TRACE_PH_INSTANT, ///< A single point in time
+} tracePhase_t;
+
+/**
+ * @brief The tracks events are drawn on. Spans on the same track must nest
+ */
+typedef enum
+{
+    TRACE_TRACK_MAIN,    ///< The main loop
+    TRACE_TRACK_INPUT,   ///< Input interrupts, or the emulator's input thread
+    TRACE_TRACK_AUDIO,   ///< The emulator's audio thread. On the firmware, audio is processed in the main loop
+    TRACE_TRACK_ESP_NOW, ///< ESP-NOW receive, which is the WiFi task for ::ESP_NOW_IMMEDIATE modes
+} traceTrack_t;
+
+#if defined(CONFIG_TRACE_ENABLE)
+    /// Mark the start of a span of the given ::traceId_t
+    #define TRACE_BEGIN(id) traceRecord(id, TRACE_PH_BEGIN, 0)
+    /// Mark the end of a span of the given ::traceId_t
+    #define TRACE_END(id) traceRecord(id, TRACE_PH_END, 0)
+    /// Mark a point in time with the given ::traceId_t and argument
+    #define TRACE_INSTANT(id, arg) traceRecord(id, TRACE_PH_INSTANT, arg)
+#else
+    /// Mark the start of a span of the given ::traceId_t
+    #define TRACE_BEGIN(id)
+    /// Mark the end of a span of the given ::traceId_t
+    #define TRACE_END(id)
+    /// Mark a point in time with the given ::traceId_t and argument
+    #define TRACE_INSTANT(id, arg)
+#endif
+
+void initTrace(void);
+void deinitTrace(void);
+void traceRecord(traceId_t id, tracePhase_t phase, uint32_t arg);
+void traceFlush(void);
+void traceFlushAll(void);
+
+#endif
@@ -0,0 +1,226 @@
+//==============================================================================
+// Includes
+//==============================================================================
+
+#include <stdio.h>
+#include <stdbool.h>
+#include <inttypes.h>
+#include <stdatomic.h>
+
+#include <esp_attr.h>
+#include <esp_timer.h>
+
+#include "trace.h"
+
+#if defined(CONFIG_TRACE_ENABLE)
+
+//==============================================================================
+// Defines
+//==============================================================================
+
+/// The prefix for every line of trace output, so it can be separated from other serial output
+#define TRACE_PREFIX "TRACE "
+
+//==============================================================================
+// Structs
+//==============================================================================
+
+/// @brief A single recorded event
+typedef struct
+{
+    uint32_t time;       ///< The time of the event, in microseconds since boot
+    uint32_t arg;        ///< An event-specific argument
+    uint8_t id;          ///< The ::traceId_t
+    uint8_t phase;       ///< The ::tracePhase_t
+    atomic_bool written; ///< Set once the rest of the entry has been written, cleared when it's flushed
+} traceEvent_t;
+
+/// @brief How to display a ::traceId_t
+typedef struct
+{
+    const char* name;   ///< The name of the event
+    traceTrack_t track; ///< The track to draw the event on
+} traceInfo_t;
+
+//==============================================================================
+// Variables
+//==============================================================================
+
+/// The names and tracks of each ::traceId_t
+static const traceInfo_t traceInfo[TRACE_NUM_IDS] = {
+    [TRACE_BTN_ISR]     = {.name = "btnIsr", .track = TRACE_TRACK_INPUT},
+    [TRACE_BTN_DEQUEUE] = {.name = "btnDequeue", .track = TRACE_TRACK_MAIN},
+    [TRACE_TOUCH]       = {.name = "touch", .track = TRACE_TRACK_MAIN},
+    [TRACE_MAIN_LOOP]   = {.name = "mainLoop", .track = TRACE_TRACK_MAIN},
+    [TRACE_TFT_FRAME]   = {.name = "tftFrame", .track = TRACE_TRACK_MAIN},
+    [TRACE_TFT_CHUNK]   = {.name = "tftChunk", .track = TRACE_TRACK_MAIN},
+    [TRACE_DAC_FILL]    = {.name = "dacFill", .track = TRACE_TRACK_MAIN},
+    [TRACE_ESP_NOW_RX]  = {.name = "espNowRx", .track = TRACE_TRACK_ESP_NOW},
+};
+
+/// The names of each ::traceTrack_t
+static const char* const trackNames[] = {"main", "input", "audio", "espNow"};
+
+/// The ring buffer of events. This is in internal RAM so it can be written from interrupts
+static DRAM_ATTR traceEvent_t traceBuf[CONFIG_TRACE_BUFFER_LEN];
+
+/// The number of events ever claimed for writing
+static atomic_uint traceHead;
+/// The number of events ever flushed
+static atomic_uint traceTail;
+/// The number of events dropped because the buffer was full
+static atomic_uint traceDropped;
+
+//==============================================================================
+// Functions
+//==============================================================================
+
+/**
+ * @brief Start tracing by printing the start of the trace and names for the tracks
+ */
+void initTrace(void)
+{
+    printf(TRACE_PREFIX "[\n");
+    for (int i = 0; i < sizeof(trackNames) / sizeof(trackNames[0]); i++)
+    {
+        printf(TRACE_PREFIX "{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":0,\"tid\":%d,"
+                            "\"args\":{\"name\":\"%s\"}},\n",
+               i, trackNames[i]);
+    }
+}
+
+/**
+ * @brief Flush any remaining events
+ */
+void deinitTrace(void)
+{
+    traceFlushAll();
+}
+
+/**
+ * @brief Record a trace event. This may be called from an interrupt. Use the TRACE_BEGIN(), TRACE_END(), and
+ * TRACE_INSTANT() macros instead of calling this directly, so the calls are compiled out when tracing is disabled.
+ *
+ * @param id The event type
+ * @param phase Whether this begins a span, ends one, or is instantaneous
+ * @param arg An event-specific argument
+ */
+void IRAM_ATTR traceRecord(traceId_t id, tracePhase_t phase, uint32_t arg)
+{
+    uint32_t time = esp_timer_get_time();
+
+    // Claim a slot, unless the buffer is full
+    unsigned int head = atomic_load_explicit(&traceHead, memory_order_relaxed);
+    do
+    {
+        if (head - atomic_load_explicit(&traceTail, memory_order_acquire) >= CONFIG_TRACE_BUFFER_LEN)
+        {
+            atomic_fetch_add_explicit(&traceDropped, 1, memory_order_relaxed);
+            return;
+        }
+    } while (!atomic_compare_exchange_weak_explicit(&traceHead, &head, head + 1, memory_order_relaxed,
+                                                    memory_order_relaxed));
+
+    traceEvent_t* evt = &traceBuf[head % CONFIG_TRACE_BUFFER_LEN];
+    evt->time         = time;
+    evt->arg          = arg;
+    evt->id           = id;
+    evt->phase        = phase;
+    atomic_store_explicit(&evt->written, true, memory_order_release);
+}
+
+/**
+ * @brief Print buffered events over serial once the buffer is half full. This should be called from the main loop.
+ */
+void traceFlush(void)
+{
+    if (atomic_load_explicit(&traceHead, memory_order_relaxed) - atomic_load_explicit(&traceTail, memory_order_relaxed)
+        >= CONFIG_TRACE_BUFFER_LEN / 2)
+    {
+        traceFlushAll();
+    }
+}
+
+/**
+ * @brief Print all buffered events over serial, however few there are
+ */
+void traceFlushAll(void)
+{
+    static const char phaseChars[] = {'B', 'E', 'i'};
+
+    unsigned int tail = atomic_load_explicit(&traceTail, memory_order_relaxed);
+
+    // Copy events out before printing so the slots are freed as quickly as possible
+    traceEvent_t* evt;
+    while ((evt = &traceBuf[tail % CONFIG_TRACE_BUFFER_LEN])
+           && atomic_load_explicit(&evt->written, memory_order_acquire))
+    {
+        traceEvent_t copy = {
+            .time  = evt->time,
+            .arg   = evt->arg,
+            .id    = evt->id,
+            .phase = evt->phase,
+        };
+        atomic_store_explicit(&evt->written, false, memory_order_relaxed);
+        atomic_store_explicit(&traceTail, ++tail, memory_order_release);
+
+        printf(TRACE_PREFIX "{\"name\":\"%s\",\"ph\":\"%c\",\"ts\":%" PRIu32 ",\"pid\":0,\"tid\":%d,\"s\":\"t\","
+                            "\"args\":{\"v\":%" PRIu32 "}},\n",
+               traceInfo[copy.id].name, phaseChars[copy.phase], copy.time, traceInfo[copy.id].track, copy.arg);
+    }
+
+    unsigned int dropped = atomic_exchange_explicit(&traceDropped, 0, memory_order_relaxed);
+    if (dropped)
+    {
+        printf(TRACE_PREFIX "{\"name\":\"dropped\",\"ph\":\"i\",\"ts\":%" PRIu32 ",\"pid\":0,\"tid\":0,\"s\":\"g\","
+                            "\"args\":{\"v\":%u}},\n",
+               (uint32_t)esp_timer_get_time(), dropped);
+    }
+}
+
+#else
+
+//==============================================================================
+// Functions
+//==============================================================================
+
+/**
+ * @brief Tracing is disabled, so this does nothing
+ */
+void initTrace(void)
+{
+}
+
+/**
+ * @brief Tracing is disabled, so this does nothing
+ */
+void deinitTrace(void)
+{
+}
+
+/**
+ * @brief Tracing is disabled, so this does nothing
+ *
+ * @param id unused
+ * @param phase unused
+ * @param arg unused
+ */
+void traceRecord(traceId_t id, tracePhase_t phase, uint32_t arg)
+{
+}
+
+/**
+ * @brief Tracing is disabled, so this does nothing
+ */
+void traceFlush(void)
+{
+}
+
+/**
+ * @brief Tracing is disabled, so this does nothing
+ */
+void traceFlushAll(void)
+{
+}
+
+#endif
@@ -100,3 +100,12 @@ void *heap_caps_realloc_dbg(void *ptr, size_t size, uint32_t caps, const char* f
 void heap_caps_free_dbg(void* ptr, const char* file, const char* func, int32_t line, const char* tag);
 
 void dumpAllocTable(void);
+
+/**
+ * @brief Record the most of an allocation that was ever in use, for allocations which are suballocated like arenas.
+ * It is printed by dumpAllocTable().
+ *
+ * @param ptr The allocation
+ * @param highWater The most bytes of the allocation that were ever in use
+ */
+void heap_caps_track_high_water(void* ptr, size_t highWater);
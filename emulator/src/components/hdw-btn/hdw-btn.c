@@ -13,6 +13,14 @@
 #include "linked_list.h"
 #include "touchUtils.h"
 #include "esp_timer.h"
+#include "trace.h"
+
+//==============================================================================
+// Defines
+//==============================================================================
+
+/// The number of touch events which can be queued, the same as the firmware
+#define TOUCH_QUEUE_LEN 32
 
 //==============================================================================
 // Variables
@@ -45,6 +53,21 @@ static int32_t lastTouchRadius = 0;
 /// The touchpad analog intensity
 static int32_t lastTouchIntensity = 0;
 
+/// The time the touchpad last changed, or 0 once getTouchJoystick() has consumed the change
+static uint32_t lastTouchTime = 0;
+
+/// The queue for touch events
+static list_t* touchQueue;
+
+/// The time of the earliest input event consumed since takeInputConsumedTime() was last called, or 0
+static uint32_t inputConsumedTime = 0;
+
+//==============================================================================
+// Function Prototypes
+//==============================================================================
+
+static void markInputConsumed(uint32_t time);
+
 //==============================================================================
 // Functions
 //==============================================================================
@@ -62,6 +85,7 @@ void initButtons(gpio_num_t* pushButtons, uint8_t numPushButtons, touch_pad_t* t
 {
     buttonState = 0;
     buttonQueue = calloc(1, sizeof(list_t));
+    touchQueue  = calloc(1, sizeof(list_t));
 }
 
 /**
@@ -80,6 +104,13 @@ void deinitButtons(void)
     }
     clear(buttonQueue);
     free(buttonQueue);
+
+    while (NULL != (val = shift(touchQueue)))
+    {
+        free(val);
+    }
+    clear(touchQueue);
+    free(touchQueue);
 }
 
 /**
@@ -107,11 +138,84 @@ bool checkButtonQueue(buttonEvt_t* evt)
         memcpy(evt, val, sizeof(buttonEvt_t));
         // Free everything
         free(val);
+        markInputConsumed(evt->time);
         // Return that an event occurred
         return true;
     }
 }
 
+/**
+ * @brief Service the queue of touch events
+ * This only returns a single event, even if there are multiple in the queue
+ * This function may be called multiple times in a row to completely empty the queue
+ *
+ * @param evt If an event occurred, return it through this argument
+ * @return true if an event occurred, false if nothing happened
+ */
+bool checkTouchQueue(touchEvt_t* evt)
+{
+    touchEvt_t* val = shift(touchQueue);
+
+    if (NULL == val)
+    {
+        return false;
+    }
+
+    memcpy(evt, val, sizeof(touchEvt_t));
+    free(val);
+    markInputConsumed(evt->time);
+    TRACE_INSTANT(TRACE_TOUCH, evt->phi);
+    return true;
+}
+
+/**
+ * @brief Discard all queued touch events. The system calls this when switching Swadge modes, so a mode doesn't receive
+ * events queued before it started.
+ */
+void flushTouchQueue(void)
+{
+    void* val;
+    while (NULL != touchQueue && NULL != (val = shift(touchQueue)))
+    {
+        free(val);
+    }
+}
+
+/**
+ * @brief Set how strongly touch samples are smoothed. Emulated touches are already smooth, so this does nothing
+ *
+ * @param strength unused
+ */
+void setTouchFilter(uint8_t strength)
+{
+}
+
+/**
+ * @brief Get and clear the time of the earliest button or touch event consumed since this was last called
+ *
+ * @return The time of the event, in us since boot, or 0 if no events were consumed
+ */
+uint32_t takeInputConsumedTime(void)
+{
+    uint32_t time     = inputConsumedTime;
+    inputConsumedTime = 0;
+    return time;
+}
+
+/**
+ * @brief Remember the time of a consumed input event, if it's the earliest since takeInputConsumedTime()
+ *
+ * @param time The time of the event, in us since boot
+ */
+static void markInputConsumed(uint32_t time)
+{
+    if (0 == inputConsumedTime)
+    {
+        // Zero means nothing was consumed
+        inputConsumedTime = time ? time : 1;
+    }
+}
+
 /**
  * @brief Get the touch intensity and location in terms of angle and distance from
  * the center touchpad
@@ -130,6 +234,13 @@ int getTouchJoystick(int32_t* phi, int32_t* r, int32_t* intensity)
         return false;
     }
 
+    // Count each change once for the input latency, like the firmware counts each sample
+    if (0 != lastTouchTime)
+    {
+        markInputConsumed(lastTouchTime);
+        lastTouchTime = 0;
+    }
+
     // A touch in the center at 50% intensity
     if (phi)
     {
@@ -196,10 +307,29 @@ void emulatorInjectButton(buttonBit_t button, bool down)
 
     // Add the event to the list
     push(buttonQueue, evt);
+    TRACE_INSTANT(TRACE_BTN_ISR, buttonState);
 }
 
 void emulatorSetTouchJoystick(int32_t phi, int32_t radius, int32_t intensity)
 {
+    // Queue changes. Like the firmware, drop the newest event if the queue is full because nobody is reading it
+    if (NULL != touchQueue && touchQueue->length < TOUCH_QUEUE_LEN
+        && (phi != lastTouchPhi || radius != lastTouchRadius || (0 == intensity) != (0 == lastTouchIntensity)))
+    {
+        touchEvt_t* evt = malloc(sizeof(touchEvt_t));
+        evt->touched    = (0 != intensity);
+        evt->phi        = evt->touched ? phi : 0;
+        evt->r          = evt->touched ? radius : 0;
+        evt->intensity  = intensity;
+        evt->time       = esp_timer_get_time();
+        push(touchQueue, evt);
+    }
+
+    if (phi != lastTouchPhi || radius != lastTouchRadius || intensity != lastTouchIntensity)
+    {
+        lastTouchTime = esp_timer_get_time();
+    }
+
     lastTouchPhi       = phi;
     lastTouchRadius    = radius;
     lastTouchIntensity = intensity;
@@ -7,12 +7,29 @@
 #include "hdw-led_emu.h"
 #include "emu_main.h"
 
+//==============================================================================
+// Const Variables
+//==============================================================================
+
+/// The light output of each brightness setting, as a 0.16 fixed point fraction of full output. This must match the
+/// firmware's table.
+static const uint32_t brightnessGains[MAX_LED_BRIGHTNESS + 1] = {
+    0, 676, 3104, 7574, 14263, 23303, 34803, 48854, 65536,
+};
+
+//==============================================================================
+// Function Prototypes
+//==============================================================================
+
+static uint8_t ledRound(uint32_t scaled);
+
 //==============================================================================
 // Variables
 //==============================================================================
 
-static led_t rdLeds[CONFIG_NUM_LEDS] = {0};
-static uint8_t ledBrightness         = 0;
+static led_t rdLeds[CONFIG_NUM_LEDS]        = {0};
+static led_t requestedLeds[CONFIG_NUM_LEDS] = {0};
+static uint32_t ledGain                     = 0;
 
 //==============================================================================
 // Functions
@@ -28,6 +45,7 @@ static uint8_t ledBrightness         = 0;
 esp_err_t initLeds(gpio_num_t gpio, gpio_num_t gpioAlt, uint8_t brightness)
 {
     memset(rdLeds, 0, sizeof(rdLeds));
+    memset(requestedLeds, 0, sizeof(requestedLeds));
     setLedBrightness(brightness);
     return ESP_OK;
 }
@@ -49,8 +67,14 @@ esp_err_t deinitLeds(void)
  */
 void setLedBrightness(uint8_t brightness)
 {
-    // LED channels are right-shifted by this value when being set
-    ledBrightness = (MAX_LED_BRIGHTNESS - brightness);
+    if (brightness > MAX_LED_BRIGHTNESS)
+    {
+        brightness = MAX_LED_BRIGHTNESS;
+    }
+    ledGain = brightnessGains[brightness];
+
+    // The firmware applies a new brightness on its next refresh
+    setLeds(requestedLeds, CONFIG_NUM_LEDS);
 }
 
 /**
@@ -68,11 +92,13 @@ esp_err_t setLeds(led_t* leds, uint8_t numLeds)
         numLeds = CONFIG_NUM_LEDS;
     }
 
+    // The firmware dithers the fraction over several refreshes, then rounds it once the LEDs settle, so round it here
+    memmove(requestedLeds, leds, numLeds * sizeof(led_t));
     for (uint8_t i = 0; i < numLeds; i++)
     {
-        rdLeds[i].r = (leds[i].r >> ledBrightness);
-        rdLeds[i].g = (leds[i].g >> ledBrightness);
-        rdLeds[i].b = (leds[i].b >> ledBrightness);
+        rdLeds[i].r = ledRound(requestedLeds[i].r * ledGain);
+        rdLeds[i].g = ledRound(requestedLeds[i].g * ledGain);
+        rdLeds[i].b = ledRound(requestedLeds[i].b * ledGain);
     }
 
     return ESP_OK;
@@ -87,7 +113,7 @@ uint8_t getLedState(led_t* leds, uint8_t numLeds)
             numLeds = CONFIG_NUM_LEDS;
         }
 
-        memcpy(leds, rdLeds, sizeof(led_t) * numLeds);
+        memcpy(leds, requestedLeds, sizeof(led_t) * numLeds);
         return numLeds;
     }
 
@@ -114,3 +140,16 @@ void flushLeds(void)
 {
     return;
 }
+
+/**
+ * @brief Round a brightness-scaled channel to the nearest integer, keeping channels which aren't off lit, like the
+ * firmware does once the LEDs settle
+ *
+ * @param scaled The channel scaled by the brightness, as a 16.16 fixed point number
+ * @return The rounded channel
+ */
+static uint8_t ledRound(uint32_t scaled)
+{
+    uint8_t rounded = (scaled + 0x8000) >> 16;
+    return (0 == rounded && 0 != scaled) ? 1 : rounded;
+}
@@ -0,0 +1,191 @@
+//==============================================================================
+// Includes
+//==============================================================================
+
+#include <stdio.h>
+#include <stdbool.h>
+#include <inttypes.h>
+#include <stdatomic.h>
+
+#include "esp_timer.h"
+#include "emu_args.h"
+#include "macros.h"
+#include "trace.h"
+
+//==============================================================================
+// Structs
+//==============================================================================
+
+/// @brief A single recorded event
+typedef struct
+{
+    uint32_t time;       ///< The time of the event, in microseconds since boot
+    uint32_t arg;        ///< An event-specific argument
+    uint8_t id;          ///< The ::traceId_t
+    uint8_t phase;       ///< The ::tracePhase_t
+    atomic_bool written; ///< Set once the rest of the entry has been written, cleared when it's flushed
+} traceEvent_t;
+
+/// @brief How to display a ::traceId_t
+typedef struct
+{
+    const char* name;   ///< The name of the event
+    traceTrack_t track; ///< The track to draw the event on
+} traceInfo_t;
+
+//==============================================================================
+// Variables
+//==============================================================================
+
+/// The names and tracks of each ::traceId_t
+static const traceInfo_t traceInfo[TRACE_NUM_IDS] = {
+    [TRACE_BTN_ISR]     = {.name = "btnIsr", .track = TRACE_TRACK_INPUT},
+    [TRACE_BTN_DEQUEUE] = {.name = "btnDequeue", .track = TRACE_TRACK_MAIN},
+    [TRACE_TOUCH]       = {.name = "touch", .track = TRACE_TRACK_MAIN},
+    [TRACE_MAIN_LOOP]   = {.name = "mainLoop", .track = TRACE_TRACK_MAIN},
+    [TRACE_TFT_FRAME]   = {.name = "tftFrame", .track = TRACE_TRACK_MAIN},
+    [TRACE_TFT_CHUNK]   = {.name = "tftChunk", .track = TRACE_TRACK_MAIN},
+    [TRACE_DAC_FILL]    = {.name = "dacFill", .track = TRACE_TRACK_AUDIO},
+    [TRACE_ESP_NOW_RX]  = {.name = "espNowRx", .track = TRACE_TRACK_ESP_NOW},
+};
+
+/// The names of each ::traceTrack_t
+static const char* const trackNames[] = {"main", "input", "audio", "espNow"};
+
+/// The file to write the trace to, or NULL if tracing is inactive
+static FILE* traceFile = NULL;
+
+/// The ring buffer of events
+static traceEvent_t traceBuf[CONFIG_TRACE_BUFFER_LEN];
+
+/// The number of events ever claimed for writing
+static atomic_uint traceHead;
+/// The number of events ever flushed
+static atomic_uint traceTail;
+/// The number of events dropped because the buffer was full
+static atomic_uint traceDropped;
+
+//==============================================================================
+// Functions
+//==============================================================================
+
+/**
+ * @brief Open the trace file given with the \c --trace option, if any, and write names for the tracks
+ */
+void initTrace(void)
+{
+    if (NULL == emulatorArgs.traceFile || NULL != traceFile)
+    {
+        return;
+    }
+
+    traceFile = fopen(emulatorArgs.traceFile, "w");
+    if (NULL == traceFile)
+    {
+        printf("ERR: Could not open trace file %s\n", emulatorArgs.traceFile);
+        return;
+    }
+
+    fprintf(traceFile, "[\n");
+    for (int i = 0; i < ARRAY_SIZE(trackNames); i++)
+    {
+        fprintf(traceFile, "%s{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":0,\"tid\":%d,\"args\":{\"name\":\"%s\"}}",
+                i ? ",\n" : "", i, trackNames[i]);
+    }
+}
+
+/**
+ * @brief Flush any remaining events and close the trace file
+ */
+void deinitTrace(void)
+{
+    if (NULL != traceFile)
+    {
+        traceFlushAll();
+        fprintf(traceFile, "\n]\n");
+        fclose(traceFile);
+        traceFile = NULL;
+    }
+}
+
+/**
+ * @brief Record a trace event. This may be called from any thread. Use the TRACE_BEGIN(), TRACE_END(), and
+ * TRACE_INSTANT() macros instead of calling this directly, so the calls are compiled out when tracing is disabled.
+ *
+ * @param id The event type
+ * @param phase Whether this begins a span, ends one, or is instantaneous
+ * @param arg An event-specific argument
+ */
+void traceRecord(traceId_t id, tracePhase_t phase, uint32_t arg)
+{
+    if (NULL == traceFile)
+    {
+        return;
+    }
+
+    uint32_t time = esp_timer_get_time();
+
+    // Claim a slot, unless the buffer is full
+    unsigned int head = atomic_load_explicit(&traceHead, memory_order_relaxed);
+    do
+    {
+        if (head - atomic_load_explicit(&traceTail, memory_order_acquire) >= CONFIG_TRACE_BUFFER_LEN)
+        {
+            atomic_fetch_add_explicit(&traceDropped, 1, memory_order_relaxed);
+            return;
+        }
+    } while (!atomic_compare_exchange_weak_explicit(&traceHead, &head, head + 1, memory_order_relaxed,
+                                                    memory_order_relaxed));
+
+    traceEvent_t* evt = &traceBuf[head % CONFIG_TRACE_BUFFER_LEN];
+    evt->time         = time;
+    evt->arg          = arg;
+    evt->id           = id;
+    evt->phase        = phase;
+    atomic_store_explicit(&evt->written, true, memory_order_release);
+}
+
+/**
+ * @brief Write all buffered events to the trace file. Writing to a file is quick, so unlike the firmware this doesn't
+ * wait for the buffer to fill up.
+ */
+void traceFlush(void)
+{
+    traceFlushAll();
+}
+
+/**
+ * @brief Write all buffered events to the trace file
+ */
+void traceFlushAll(void)
+{
+    static const char phaseChars[] = {'B', 'E', 'i'};
+
+    if (NULL == traceFile)
+    {
+        return;
+    }
+
+    unsigned int tail = atomic_load_explicit(&traceTail, memory_order_relaxed);
+    traceEvent_t* evt;
+    while ((evt = &traceBuf[tail % CONFIG_TRACE_BUFFER_LEN])
+           && atomic_load_explicit(&evt->written, memory_order_acquire))
+    {
+        fprintf(traceFile,
+                ",\n{\"name\":\"%s\",\"ph\":\"%c\",\"ts\":%" PRIu32 ",\"pid\":0,\"tid\":%d,\"s\":\"t\","
+                "\"args\":{\"v\":%" PRIu32 "}}",
+                traceInfo[evt->id].name, phaseChars[evt->phase], evt->time, traceInfo[evt->id].track, evt->arg);
+
+        atomic_store_explicit(&evt->written, false, memory_order_relaxed);
+        atomic_store_explicit(&traceTail, ++tail, memory_order_release);
+    }
+
+    unsigned int dropped = atomic_exchange_explicit(&traceDropped, 0, memory_order_relaxed);
+    if (dropped)
+    {
+        fprintf(traceFile,
+                ",\n{\"name\":\"dropped\",\"ph\":\"i\",\"ts\":%" PRIu32 ",\"pid\":0,\"tid\":0,\"s\":\"g\","
+                "\"args\":{\"v\":%u}}",
+                (uint32_t)esp_timer_get_time(), dropped);
+    }
+}
@@ -45,6 +45,7 @@
 #include "hdw-esp-now.h"
 #include "esp_random_emu.h"
 #include "mainMenu.h"
+#include "frameProfiler.h"
 
 // clang-format off
 // Necessary for CNFA
@@ -192,6 +193,11 @@ int main(int argc, char** argv)
         return 0;
     }
 
+    if (emulatorArgs.profilerOverlay)
+    {
+        profilerSetOverlay(true);
+    }
+
     if (emulatorArgs.seed != UINT32_MAX)
     {
         emulatorSetEspRandomSeed(emulatorArgs.seed);
@@ -7,11 +7,18 @@
 #include <string.h>
 #include <stdbool.h>
 #include <stdint.h>
+#include <stdlib.h>
 #include "getopt_win.h"
 
 #include "emu_args.h"
 #include "macros.h"
 #include "ext_modes.h"
+#include "ultimateTTTcpuPlayer.h"
+#include "soko_solver.h"
+#include "hdw-imu_emu.h"
+#include "hashMap.h"
+#include "cnfs.h"
+#include "emu_fill_bench.h"
 
 //==============================================================================
 // Defines
@@ -120,6 +127,10 @@ emuArgs_t emulatorArgs = {
 
     .vsync = true,
 
+    .traceFile = NULL,
+
+    .profilerOverlay = false,
+
     .joystick = NULL,
 };
 
@@ -130,6 +141,7 @@ static const char mainDoc[] = "Emulates a swadge";
 // the same in both options and argDocs
 static const char argFakeFps[]     = "fake-fps";
 static const char argFakeTime[]    = "fake-time";
+static const char argFillBench[]   = "fill-bench";
 static const char argFullscreen[]  = "fullscreen";
 static const char argFuzz[]        = "fuzz";
 static const char argFuzzButtons[] = "fuzz-buttons";
@@ -137,7 +149,9 @@ static const char argFuzzTouch[]   = "fuzz-touch";
 static const char argFuzzTime[]    = "fuzz-time";
 static const char argFuzzMotion[]  = "fuzz-motion";
 static const char argHeadless[]    = "headless";
+static const char argHashBench[]   = "hash-bench";
 static const char argHideLeds[]    = "hide-leds";
+static const char argImuReplay[]   = "imu-replay";
 static const char argJoystick[]    = "joystick";
 static const char argJsPreset[]    = "preset";
 static const char argKeymap[]      = "keymap";
@@ -148,9 +162,13 @@ static const char argModeSwitch[]  = "mode-switch";
 static const char argModeList[]    = "modes-list";
 static const char argPlayback[]    = "playback";
 static const char argRecord[]      = "record";
+static const char argProfiler[]    = "profiler";
 static const char argSeed[]        = "seed";
 static const char argShowFps[]     = "show-fps";
+static const char argSokoVerify[]  = "soko-verify";
 static const char argTouch[]       = "touch";
+static const char argTrace[]       = "trace";
+static const char argTttBench[]    = "ttt-bench";
 static const char argVsync[]       = "vsync";
 static const char argHelp[]        = "help";
 static const char argUsage[]       = "usage";
@@ -163,6 +181,7 @@ static const struct option options[] =
 {
     { argFakeFps,     required_argument, NULL,                             0    },
     { argFakeTime,    no_argument,       (int*)&emulatorArgs.fakeTime,     true },
+    { argFillBench,   optional_argument, NULL,                             0    },
     { argFullscreen,  no_argument,       (int*)&emulatorArgs.fullscreen,   true },
     { argFuzz,        no_argument,       (int*)&emulatorArgs.fuzz,         true },
     { argFuzzButtons, optional_argument, (int*)&emulatorArgs.fuzzButtons,  true },
@@ -170,7 +189,9 @@ static const struct option options[] =
     { argFuzzTouch,   optional_argument, (int*)&emulatorArgs.fuzzTouch,    true },
     { argFuzzMotion,  optional_argument, (int*)&emulatorArgs.fuzzMotion,   true },
     { argHeadless,    no_argument,       (int*)&emulatorArgs.headless,     true },
+    { argHashBench,   optional_argument, NULL,                             0    },
     { argHideLeds,    no_argument,       (int*)&emulatorArgs.hideLeds,     true },
+    { argImuReplay,   required_argument, NULL,                             0    },
     { argJoystick,    required_argument, (int*)&emulatorArgs.joystick,     'j'  },
     { argJsPreset,    required_argument, (int*)&emulatorArgs.jsPreset,     0    },
     { argKeymap,      required_argument, NULL,                             'k'  },
@@ -178,12 +199,16 @@ static const struct option options[] =
     { argMidiFile,    required_argument, NULL,                             0    },
     { argMode,        required_argument, NULL,                             'm'  },
     { argPlayback,    required_argument, (int*)&emulatorArgs.playback,     'p'  },
+    { argProfiler,    no_argument,       NULL,                             0    },
     { argRecord,      optional_argument, (int*)&emulatorArgs.record,       'r'  },
     { argSeed,        required_argument, (int*)&emulatorArgs.seed,         0    },
     { argShowFps,     optional_argument, (int*)&emulatorArgs.showFps,      'c'  },
+    { argSokoVerify,  no_argument,       NULL,                             0    },
     { argModeSwitch,  optional_argument, NULL,                             10   },
     { argModeList,    no_argument,       NULL,                             0    },
     { argTouch,       no_argument,       (int*)&emulatorArgs.emulateTouch, 't'  },
+    { argTrace,       required_argument, NULL,                             0    },
+    { argTttBench,    optional_argument, NULL,                             0    },
     { argVsync,       optional_argument, (int*)&emulatorArgs.vsync,        true },
     { argHelp,        no_argument,       NULL,                             'h'  },
     { argUsage,       no_argument,       NULL,                             0    },
@@ -197,6 +222,7 @@ static const optDoc_t argDocs[] =
 {
     { 0,  argFakeFps,     "RATE",  "Set a fake framerate. RATE can be a decimal number"},
     { 0,  argFakeTime,    NULL,    "Use a fake timer that ticks at a constant "},
+    { 0,  argFillBench,   "SHAPES", "Benchmark the span-based shape fills against per-pixel fills, then exit" },
     {'f', argFullscreen,  NULL,    "Open in fullscreen mode" },
     { 0,  argFuzz,        NULL,    "Enable fuzzing mode, which injects random input in order to test modes" },
     { 0,  argFuzzButtons, "y|n",   "Set whether buttons are fuzzed" },
@@ -206,7 +232,9 @@ static const optDoc_t argDocs[] =
     { 0,  argHeadless,    NULL,    "Runs the emulator without a window." },
     {'j', argJoystick,   "JOYDEV", "Sets the joystick device to use." },
     { 0,  argJsPreset,   "PRESET", "Sets the joystick config preset to use. PRESET can be swadge or switch"},
+    { 0,  argHashBench,   "ITEMS", "Benchmark the normal and flat hash maps, then exit" },
     { 0,  argHideLeds,    NULL,    "Don't draw simulated LEDs next to the display" },
+    { 0,  argImuReplay,   "FILE",  "Replay an IMU FIFO dump through the float and fixed point fusions, then exit" },
     {'k', argKeymap,     "LAYOUT", "Use an alternative keymap. LAYOUT can be azerty, colemak, or dvorak"},
     {'l', argLock,        NULL,    "Lock the emulator in the start mode" },
     { 0,  argMidiFile,    "FILE",  "Open and immediately play a MIDI file" },
@@ -214,10 +242,14 @@ static const optDoc_t argDocs[] =
     { 0,  argModeSwitch,  "TIME",  "Enable or set the timer to switch modes automatically" },
     { 0,  argModeList,    NULL,    "Print out a list of all possible values for MODE" },
     {'p', argPlayback,    "FILE",  "Play back recorded emulator inputs from a file" },
+    { 0,  argProfiler,    NULL,    "Draw a bar showing how much of each frame's time budget is used" },
     {'r', argRecord,      "FILE",  "Record emulator inputs to a file" },
     {'s', argSeed,        "SEED",  "Seed the random number generator with a specific value" },
     {'c', argShowFps,     NULL,    "Display an FPS counter" },
+    { 0,  argSokoVerify,  NULL,    "Check that every Sokoban level can be solved, then exit" },
     {'t', argTouch,       NULL,    "Simulate touch sensor readings with a virtual touchpad" },
+    { 0,  argTrace,       "FILE",  "Write a Chrome trace of input, main loop, display, and audio timing to a file" },
+    { 0,  argTttBench,    "GAMES", "Benchmark the Ultimate TTT search against the CPU players, then exit" },
     { 0,  argVsync,       "y|n",   "Set whether VSync is enabled" },
     {'h', argHelp,        NULL,    "Give this help list" },
     { 0,  argUsage,       NULL,    "Give a short usage message" },
@@ -364,6 +396,10 @@ static bool handleArgument(const char* optName, const char* arg, int optVal)
             emulatorArgs.modeSwitchTime = optVal;
         }
     }
+    else if (argProfiler == optName)
+    {
+        emulatorArgs.profilerOverlay = true;
+    }
     else if (argRecord == optName)
     {
         if (emulatorArgs.playback)
@@ -403,6 +439,84 @@ static bool handleArgument(const char* optName, const char* arg, int optVal)
             }
         }
     }
+    else if (argTrace == optName)
+    {
+        if (arg)
+        {
+            emulatorArgs.traceFile = arg;
+        }
+        else
+        {
+            printf("ERR: Trace file name is required\n");
+            return false;
+        }
+    }
+    else if (argTttBench == optName)
+    {
+        int32_t games = 20;
+        if (arg)
+        {
+            errno = 0;
+            games = atol(arg);
+            if (errno || games <= 0)
+            {
+                printf("ERR: Invalid number of games '%s'\n", arg);
+                return false;
+            }
+        }
+
+        tttCpuBenchmark(games);
+        return false;
+    }
+    else if (argHashBench == optName)
+    {
+        int32_t items = 10000;
+        if (arg)
+        {
+            errno = 0;
+            items = atol(arg);
+            if (errno || items <= 0)
+            {
+                printf("ERR: Invalid number of items '%s'\n", arg);
+                return false;
+            }
+        }
+
+        hashBenchmark(items);
+        return false;
+    }
+    else if (argFillBench == optName)
+    {
+        int32_t shapes = 2000;
+        if (arg)
+        {
+            errno = 0;
+            shapes = atol(arg);
+            if (errno || shapes <= 0)
+            {
+                printf("ERR: Invalid number of shapes '%s'\n", arg);
+                return false;
+            }
+        }
+
+        emulatorFillBenchmark(shapes);
+        return false;
+    }
+    else if (argImuReplay == optName)
+    {
+        if (!emulatorReplayImu(arg))
+        {
+            exit(EXIT_FAILURE);
+        }
+        return false;
+    }
+    else if (argSokoVerify == optName)
+    {
+        // Arguments are handled before the filesystem is set up
+        initCnfs();
+        sokoVerifyLevels();
+        return false;
+    }
     else if (argShowFps == optName)
     {
         emulatorArgs.showFps = true;
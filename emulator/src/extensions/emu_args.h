@@ -75,6 +75,12 @@ typedef struct
     /// @brief Whether VSync is enabled
     bool vsync;
 
+    /// @brief Name of the file to write a Chrome trace to, or NULL to not trace
+    const char* traceFile;
+
+    /// @brief Whether to draw the frame profiler's overlay
+    bool profilerOverlay;
+
     // MIDI
     const char* midiFile;
 
@@ -0,0 +1,1071 @@
+/*! \file emu_fill_bench.c
+ *
+ * \section emu_fill_bench_design Design Philosophy
+ *
+ * This benchmarks the span-based shape and fill primitives against the per-pixel implementations they replaced. The
+ * per-pixel implementations are kept here, and only here, so the two can be timed and compared on the same inputs.
+ * Each primitive is drawn with the same pseudo-random parameters by both implementations, then the framebuffers are
+ * compared pixel by pixel.
+ *
+ * fillCircleSector() is not expected to match exactly. The span version tests angles per span instead of rasterizing
+ * two triangles per degree, so pixels along the edges of the sector differ.
+ */
+
+//==============================================================================
+// Includes
+//==============================================================================
+
+#include <stdio.h>
+#include <string.h>
+#include <inttypes.h>
+
+#include <esp_timer.h>
+#include <esp_log.h>
+#include <esp_heap_caps.h>
+
+#include "hdw-tft.h"
+#include "macros.h"
+#include "shapes.h"
+#include "fill.h"
+#include "trigonometry.h"
+#include "emu_fill_bench.h"
+
+//==============================================================================
+// Defines
+//==============================================================================
+
+#define FIXEDPOINT   16
+#define FIXEDPOINTD2 15
+
+//==============================================================================
+// Enums
+//==============================================================================
+
+/// @brief The primitives which are benchmarked
+typedef enum
+{
+    FB_TRIANGLE,
+    FB_CIRCLE_FILLED,
+    FB_CIRCLE_QUADRANTS,
+    FB_CIRCLE_SCALED,
+    FB_CIRCLE_OUTLINE,
+    FB_ROUNDED_RECT,
+    FB_SHADE_AREA,
+    FB_ODD_EVEN_FILL,
+    FB_CIRCLE_SECTOR,
+    FB_NUM_PRIMITIVES,
+} fillBenchPrim_t;
+
+//==============================================================================
+// Const data
+//==============================================================================
+
+/// @brief The names of each ::fillBenchPrim_t, for the report
+static const char* const primNames[] = {
+    "drawTriangleOutlined",   "drawCircleFilled", "drawCircleFilledQuadrants",
+    "drawCircleFilledScaled", "drawCircleOutline", "drawRoundedRect",
+    "shadeDisplayArea",       "oddEvenFill",       "fillCircleSector",
+};
+
+/// @brief The number of pseudo-random parameters each primitive is drawn with
+#define FB_NUM_PARAMS 8
+
+//==============================================================================
+// Function Prototypes
+//==============================================================================
+
+static uint32_t fillBenchRand(uint32_t* state);
+static void fillBenchParams(uint32_t* state, int32_t* p);
+static void fillBenchSetup(fillBenchPrim_t prim, const int32_t* p);
+static void fillBenchDraw(fillBenchPrim_t prim, bool perPixel, const int32_t* p);
+
+//==============================================================================
+// Per-pixel implementations
+//==============================================================================
+
+// These are the implementations from before the primitives were drawn in spans, renamed and otherwise unchanged
+
+static void drawTriangleOutlinedPerPixel(int16_t v0x, int16_t v0y, int16_t v1x, int16_t v1y, int16_t v2x, int16_t v2y,
+                                         paletteColor_t fillColor, paletteColor_t outlineColor)
+{
+    SETUP_FOR_TURBO();
+
+    int16_t i16tmp;
+
+    // Sort triangle such that v0 is the top-most vertex.
+    // v0->v1 is LEFT edge.
+    // v0->v2 is RIGHT edge.
+
+    if (v0y > v1y)
+    {
+        i16tmp = v0x;
+        v0x    = v1x;
+        v1x    = i16tmp;
+        i16tmp = v0y;
+        v0y    = v1y;
+        v1y    = i16tmp;
+    }
+    if (v0y > v2y)
+    {
+        i16tmp = v0x;
+        v0x    = v2x;
+        v2x    = i16tmp;
+        i16tmp = v0y;
+        v0y    = v2y;
+        v2y    = i16tmp;
+    }
+
+    // v0 is now top-most vertex.  Now orient 2 and 3.
+    // Tricky: Use slopes!  Otherwise, we could get it wrong.
+    {
+        int slope02;
+        if (v2y - v0y)
+        {
+            slope02 = ((v2x - v0x) << FIXEDPOINT) / (v2y - v0y);
+        }
+        else
+        {
+            slope02 = ((v2x - v0x) > 0) ? 0x7fffff : -0x800000;
+        }
+
+        int slope01;
+        if (v1y - v0y)
+        {
+            slope01 = ((v1x - v0x) << FIXEDPOINT) / (v1y - v0y);
+        }
+        else
+        {
+            slope01 = ((v1x - v0x) > 0) ? 0x7fffff : -0x800000;
+        }
+
+        if (slope02 < slope01)
+        {
+            i16tmp = v1x;
+            v1x    = v2x;
+            v2x    = i16tmp;
+            i16tmp = v1y;
+            v1y    = v2y;
+            v2y    = i16tmp;
+        }
+    }
+
+    // We now have a fully oriented triangle.
+    int16_t x0A = v0x;
+    int16_t y0A = v0y;
+    int16_t x0B = v0x;
+    // int16_t y0B = v0y;
+
+    // A is to the LEFT of B.
+    int dxA            = (v1x - v0x);
+    int dyA            = (v1y - v0y);
+    int dxB            = (v2x - v0x);
+    int dyB            = (v2y - v0y);
+    int sdxA           = (dxA > 0) ? 1 : -1;
+    int sdyA           = (dyA > 0) ? 1 : -1;
+    int sdxB           = (dxB > 0) ? 1 : -1;
+    int sdyB           = (dyB > 0) ? 1 : -1;
+    int xerrdivA       = (dyA * sdyA); // dx, but always positive.
+    int xerrdivB       = (dyB * sdyB); // dx, but always positive.
+    int xerrnumeratorA = 0;
+    int xerrnumeratorB = 0;
+
+    if (xerrdivA)
+    {
+        xerrnumeratorA = (((dxA * sdxA) << FIXEDPOINT) + xerrdivA / 2) / xerrdivA;
+    }
+    else
+    {
+        xerrnumeratorA = 0x7fffff;
+    }
+
+    if (xerrdivB)
+    {
+        xerrnumeratorB = (((dxB * sdxB) << FIXEDPOINT) + xerrdivB / 2) / xerrdivB;
+    }
+    else
+    {
+        xerrnumeratorB = 0x7fffff;
+    }
+
+    // X-clipping is handled on a per-scanline basis.
+    // Y-clipping must be handled upfront.
+
+    /*
+        //Optimization BUT! Can't do this here, as we would need to be smarter about it.
+        //If we do this, and the second triangle is above y=0, we'll get the wrong answer.
+        if( y0A < 0 )
+        {
+            delta = 0 - y0A;
+            y0A = 0;
+            y0B = 0;
+            x0A += (((xerrnumeratorA*delta)) * sdxA) >> FIXEDPOINT; //Could try rounding.
+            x0B += (((xerrnumeratorB*delta)) * sdxB) >> FIXEDPOINT;
+        }
+    */
+
+    {
+        // Section 1 only.
+        int yend = (v1y < v2y) ? v1y : v2y;
+        int errA = 1 << FIXEDPOINTD2;
+        int errB = 1 << FIXEDPOINTD2;
+        int y;
+
+        // Going between x0A and x0B
+        for (y = y0A; y < yend; y++)
+        {
+            int x        = x0A;
+            int endx     = x0B;
+            int suppress = 1;
+
+            if (y >= 0 && y < (int)TFT_HEIGHT)
+            {
+                suppress = 0;
+                if (x < 0)
+                {
+                    x = 0;
+                }
+                if (endx > (int)(TFT_WIDTH))
+                {
+                    endx = (int)(TFT_WIDTH);
+                }
+
+                // Draw left line
+                if (x0A >= 0 && x0A < (int)TFT_WIDTH)
+                {
+                    TURBO_SET_PIXEL(x0A, y, outlineColor);
+                    x++;
+                }
+
+                // Draw body
+                if (cTransparent != fillColor)
+                {
+                    for (; x < endx; x++)
+                    {
+                        TURBO_SET_PIXEL(x, y, fillColor);
+                    }
+                }
+
+                // Draw right line
+                if (x0B < (int)TFT_WIDTH && x0B >= 0)
+                {
+                    TURBO_SET_PIXEL(x0B, y, outlineColor);
+                }
+            }
+
+            // Now, advance the start/end X's.
+            errA += xerrnumeratorA;
+            errB += xerrnumeratorB;
+            while (errA >= (1 << FIXEDPOINT) && x0A != v1x)
+            {
+                x0A += sdxA;
+                // if( x0A < 0 || x0A > (TFT_WIDTH-1) ) break;
+                if (x0A >= 0 && x0A < (int)TFT_WIDTH && !suppress)
+                {
+                    TURBO_SET_PIXEL(x0A, y, outlineColor);
+                }
+                errA -= 1 << FIXEDPOINT;
+            }
+            while (errB >= (1 << FIXEDPOINT) && x0B != v2x)
+            {
+                x0B += sdxB;
+                // if( x0B < 0 || x0B > (TFT_WIDTH-1) ) break;
+                if (x0B >= 0 && x0B < (int)TFT_WIDTH && !suppress)
+                {
+                    TURBO_SET_PIXEL(x0B, y, outlineColor);
+                }
+                errB -= 1 << FIXEDPOINT;
+            }
+        }
+
+        // We've come to the end of section 1.  Now, we need to figure
+
+        // Now, yend is the highest possible hit on the triangle.
+
+        // v1 is LEFT OF v2
+        //  A is LEFT OF B
+        if (v1y < v2y)
+        {
+            // V1 has terminated, move to V1->V2 but keep V0->V2[B] segment
+            yend     = v2y;
+            dxA      = (v2x - v1x);
+            dyA      = (v2y - v1y);
+            sdxA     = (dxA > 0) ? 1 : -1;
+            xerrdivA = (dyA); // dx, but always positive.
+
+            xerrnumeratorA = (((dxA * sdxA) << FIXEDPOINT) + xerrdivA / 2) / xerrdivA;
+
+            x0A  = v1x;
+            errA = 1 << FIXEDPOINTD2;
+        }
+        else
+        {
+            // V2 has terminated, move to V2->V1 but keep V0->V1[A] segment
+            yend     = v1y;
+            dxB      = (v1x - v2x);
+            dyB      = (v1y - v2y);
+            sdxB     = (dxB > 0) ? 1 : -1;
+            sdyB     = (dyB > 0) ? 1 : -1;
+            xerrdivB = (dyB * sdyB); // dx, but always positive.
+            if (xerrdivB)
+            {
+                xerrnumeratorB = (((dxB * sdxB) << FIXEDPOINT) + xerrdivB / 2) / xerrdivB;
+            }
+            else
+            {
+                xerrnumeratorB = 0x7fffff;
+            }
+            x0B  = v2x;
+            errB = 1 << FIXEDPOINTD2;
+        }
+
+        if (yend > (int)(TFT_HEIGHT - 1))
+        {
+            yend = (int)TFT_HEIGHT - 1;
+        }
+
+        if (xerrnumeratorA > 1000000 || xerrnumeratorB > 1000000)
+        {
+            if (x0A < x0B)
+            {
+                sdxA = 1;
+                sdxB = -1;
+            }
+            if (x0A > x0B)
+            {
+                sdxA = -1;
+                sdxB = 1;
+            }
+            if (x0A == x0B)
+            {
+                if (x0A >= 0 && x0A < (int)TFT_WIDTH && y >= 0 && y < (int)TFT_HEIGHT)
+                {
+                    TURBO_SET_PIXEL(x0A, y, outlineColor);
+                }
+                return;
+            }
+        }
+
+        for (; y <= yend; y++)
+        {
+            int x        = x0A;
+            int endx     = x0B;
+            int suppress = 1;
+
+            if (y >= 0 && y <= (int)(TFT_HEIGHT - 1))
+            {
+                suppress = 0;
+                if (x < 0)
+                {
+                    x = 0;
+                }
+                if (endx >= (int)(TFT_WIDTH))
+                {
+                    endx = (TFT_WIDTH);
+                }
+
+                // Draw left line
+                if (x0A >= 0 && x0A < (int)(TFT_WIDTH))
+                {
+                    TURBO_SET_PIXEL(x0A, y, outlineColor);
+                    x++;
+                }
+
+                // Draw body
+                if (cTransparent != fillColor)
+                {
+                    for (; x < endx; x++)
+                    {
+                        TURBO_SET_PIXEL(x, y, fillColor);
+                    }
+                }
+
+                // Draw right line
+                if (x0B < (int)(TFT_WIDTH) && x0B >= 0)
+                {
+                    TURBO_SET_PIXEL(x0B, y, outlineColor);
+                }
+            }
+
+            // Now, advance the start/end X's.
+            errA += xerrnumeratorA;
+            errB += xerrnumeratorB;
+            while (errA >= (1 << FIXEDPOINT))
+            {
+                x0A += sdxA;
+                // if( x0A < 0 || x0A > (TFT_WIDTH-1) ) break;
+                if (x0A >= 0 && x0A < (int)(TFT_WIDTH) && !suppress)
+                {
+                    TURBO_SET_PIXEL(x0A, y, outlineColor);
+                }
+                errA -= 1 << FIXEDPOINT;
+                if (x0A == x0B)
+                {
+                    return;
+                }
+            }
+            while (errB >= (1 << FIXEDPOINT))
+            {
+                x0B += sdxB;
+                if (x0B >= 0 && x0B < (int)(TFT_WIDTH) && !suppress)
+                {
+                    TURBO_SET_PIXEL(x0B, y, outlineColor);
+                }
+                errB -= 1 << FIXEDPOINT;
+                if (x0A == x0B)
+                {
+                    return;
+                }
+            }
+        }
+    }
+}
+
+static void drawCircleFilledQuadrantsPerPixel(int xm, int ym, int r, bool q1, bool q2, bool q3, bool q4,
+                                              paletteColor_t col)
+{
+    SETUP_FOR_TURBO();
+
+    int x = -r, y = 0, err = 2 - 2 * r; /* bottom left to top right */
+    do
+    {
+        /// Left half
+        if (q2 || q3)
+        {
+            for (int lineX = xm + x; lineX <= xm; lineX++)
+            {
+                // Top
+                if (q2)
+                {
+                    TURBO_SET_PIXEL_BOUNDS(lineX, ym - y, col);
+                }
+
+                // Bottom
+                if (q3)
+                {
+                    TURBO_SET_PIXEL_BOUNDS(lineX, ym + y, col);
+                }
+            }
+        }
+
+        // Right half
+        if (q1 || q4)
+        {
+            for (int lineX = xm; lineX <= xm - x; lineX++)
+            {
+                // Top
+                if (q1)
+                {
+                    TURBO_SET_PIXEL_BOUNDS(lineX, ym - y, col);
+                }
+
+                // Bottom
+                if (q4)
+                {
+                    TURBO_SET_PIXEL_BOUNDS(lineX, ym + y, col);
+                }
+            }
+        }
+
+        r = err;
+        if (r <= y)
+        {
+            err += ++y * 2 + 1; /* e_xy+e_y < 0 */
+        }
+        if (r > x || err > y) /* e_xy+e_x > 0 or no 2nd y-step */
+        {
+            err += ++x * 2 + 1; /* -> x-step now */
+        }
+    } while (x < 0);
+}
+
+static void drawCircleFilledInnerPerPixel(int xm, int ym, int r, paletteColor_t col, int xOrigin, int yOrigin,
+                                          int xScale, int yScale)
+{
+    SETUP_FOR_TURBO();
+
+    int x = -r, y = 0, err = 2 - 2 * r; /* bottom left to top right */
+    do
+    {
+        for (int lineX = xm + x; lineX <= xm - x; lineX++)
+        {
+            TURBO_SET_PIXEL_BOUNDS(xOrigin + lineX * xScale, yOrigin + (ym - y) * yScale, col);
+            TURBO_SET_PIXEL_BOUNDS(xOrigin + lineX * xScale, yOrigin + (ym + y) * yScale, col);
+        }
+
+        r = err;
+        if (r <= y)
+        {
+            err += ++y * 2 + 1; /* e_xy+e_y < 0 */
+        }
+        if (r > x || err > y) /* e_xy+e_x > 0 or no 2nd y-step */
+        {
+            err += ++x * 2 + 1; /* -> x-step now */
+        }
+    } while (x < 0);
+}
+
+static void drawCircleOutlinePerPixel(int xm, int ym, int r, int stroke, paletteColor_t col)
+{
+    SETUP_FOR_TURBO();
+
+    // Outer circle
+    int x = -r, y = 0, err = 2 - 2 * r; /* bottom left to top right */
+
+    // Inner circle
+    int r_inner = r - stroke;
+    int x_inner = -r_inner, y_inner = 0, err_inner = 2 - 2 * r_inner; /* bottom left to top right */
+
+    // Iterates over Y
+    do
+    {
+        // Iterates over X
+        for (int lineX = xm + x; lineX <= xm - x; lineX++)
+        {
+            // Only draw the outline
+            if (lineX < (xm + x_inner) || lineX > (xm - x_inner))
+            {
+                TURBO_SET_PIXEL_BOUNDS(lineX, (ym - y), col);
+                TURBO_SET_PIXEL_BOUNDS(lineX, (ym + y), col);
+            }
+        }
+
+        // Iterate the outer circle
+        r = err;
+        if (r <= y)
+        {
+            err += ++y * 2 + 1; /* e_xy+e_y < 0 */
+        }
+        if (r > x || err > y) /* e_xy+e_x > 0 or no 2nd y-step */
+        {
+            err += ++x * 2 + 1; /* -> x-step now */
+        }
+
+        // Iterate the inner circle to match
+        while (y_inner != y)
+        {
+            r_inner = err_inner;
+            if (r_inner <= y_inner)
+            {
+                err_inner += ++y_inner * 2 + 1; /* e_xy+e_y < 0 */
+            }
+            if (r_inner > x_inner || err_inner > y_inner) /* e_xy+e_x > 0 or no 2nd y-step */
+            {
+                err_inner += ++x_inner * 2 + 1; /* -> x-step now */
+            }
+        }
+    } while (x < 0);
+}
+
+static void drawCircleFilledPerPixel(int xm, int ym, int r, paletteColor_t col)
+{
+    drawCircleFilledInnerPerPixel(xm, ym, r, col, 0, 0, 1, 1);
+}
+
+static void drawCircleFilledScaledPerPixel(int xm, int ym, int r, paletteColor_t col, int xOrigin, int yOrigin,
+                                           int xScale, int yScale)
+{
+    for (uint8_t i = 0; i < xScale * yScale; i++)
+    {
+        drawCircleFilledInnerPerPixel(xm, ym, r, col, xOrigin + i % yScale, yOrigin + i / xScale, xScale, yScale);
+    }
+}
+
+static void drawRoundedRectPerPixel(int x0, int y0, int x1, int y1, int r, paletteColor_t fillColor,
+                                    paletteColor_t outlineColor)
+{
+    if (x0 > x1)
+    {
+        int tmp = x0;
+        x0      = x1;
+        x1      = tmp;
+    }
+
+    if (y0 > y1)
+    {
+        int tmp = y0;
+        y0      = y1;
+        y1      = tmp;
+    }
+
+    if (fillColor != cTransparent)
+    {
+        // Top-left circle
+        drawCircleFilledQuadrantsPerPixel(x0 + r, y0 + r, r, false, true, false, false, fillColor);
+        // Top-right
+        drawCircleFilledQuadrantsPerPixel(x1 - r, y0 + r, r, true, false, false, false, fillColor);
+        // Bottom-left
+        drawCircleFilledQuadrantsPerPixel(x0 + r, y1 - r, r, false, false, true, false, fillColor);
+        // Bottom-right
+        drawCircleFilledQuadrantsPerPixel(x1 - r, y1 - r, r, false, false, false, true, fillColor);
+
+        // Boxes
+        // Top portion (between two circles)
+        drawRectFilled(x0 + r, y0, x1 - r, y0 + r, fillColor);
+
+        // Middle
+        drawRectFilled(x0, y0 + r, x1, y1 - r, fillColor);
+
+        // Bottom (between circles)
+        drawRectFilled(x0 + r, y1 - r, x1 - r, y1, fillColor);
+    }
+
+    if (outlineColor != cTransparent)
+    {
+        // Top-left circle
+        drawCircleQuadrants(x0 + r, y0 + r, r, false, false, true, false, outlineColor);
+        // Top-right
+        drawCircleQuadrants(x1 - r, y0 + r, r, false, false, false, true, outlineColor);
+        // Bottom-left
+        drawCircleQuadrants(x0 + r, y1 - r, r, false, true, false, false, outlineColor);
+        // Bottom-right
+        drawCircleQuadrants(x1 - r, y1 - r, r, true, false, false, false, outlineColor);
+
+        // Top
+        drawLineFast(x0 + r, y0, x1 - r, y0, outlineColor);
+        // Left
+        drawLineFast(x0, y0 + r, x0, y1 - r, outlineColor);
+        // Right
+        drawLineFast(x1, y0 + r, x1, y1 - r, outlineColor);
+        // Bottom
+        drawLineFast(x0 + r, y1, x1 - r, y1, outlineColor);
+    }
+}
+
+static void shadeDisplayAreaPerPixel(int16_t x1, int16_t y1, int16_t x2, int16_t y2, uint8_t shadeLevel,
+                                     paletteColor_t color)
+{
+    SETUP_FOR_TURBO();
+    int16_t xMin, yMin, xMax, yMax;
+    if (x1 < x2)
+    {
+        xMin = x1;
+        xMax = x2;
+    }
+    else
+    {
+        xMin = x2;
+        xMax = x1;
+    }
+    if (y1 < y2)
+    {
+        yMin = y1;
+        yMax = y2;
+    }
+    else
+    {
+        yMin = y2;
+        yMax = y1;
+    }
+
+    if (xMin < 0)
+    {
+        xMin = 0;
+    }
+    if (xMax >= (int16_t)TFT_WIDTH)
+    {
+        xMax = TFT_WIDTH - 1;
+    }
+    if (xMin >= (int16_t)TFT_WIDTH)
+    {
+        return;
+    }
+    if (xMax < 0)
+    {
+        return;
+    }
+    if (yMin < 0)
+    {
+        yMin = 0;
+    }
+    if (yMax >= (int16_t)TFT_HEIGHT)
+    {
+        yMax = TFT_HEIGHT - 1;
+    }
+    if (yMin >= (int16_t)TFT_HEIGHT)
+    {
+        return;
+    }
+    if (yMax < 0)
+    {
+        return;
+    }
+
+    for (int16_t dy = yMin; dy <= yMax; dy++)
+    {
+        for (int16_t dx = xMin; dx < xMax; dx++)
+        {
+            switch (shadeLevel)
+            {
+                case 0:
+                {
+                    // 25% faded
+                    if (dy % 2 == 0 && dx % 2 == 0)
+                    {
+                        TURBO_SET_PIXEL_BOUNDS(dx, dy, color);
+                    }
+                    break;
+                }
+                case 1:
+                {
+                    // 37.5% faded
+                    if (dy % 2 == 0 && dx % 2 == 0)
+                    {
+                        TURBO_SET_PIXEL_BOUNDS(dx, dy, color);
+                    }
+                    else if (dx % 4 == 0)
+                    {
+                        TURBO_SET_PIXEL_BOUNDS(dx, dy, color);
+                    }
+                    break;
+                }
+                case 2:
+                {
+                    // 50% faded
+                    if ((dy % 2) == (dx % 2))
+                    {
+                        TURBO_SET_PIXEL_BOUNDS(dx, dy, color);
+                    }
+                    break;
+                }
+                case 3:
+                {
+                    // 62.5% faded
+                    if (dy % 2 == 0 && dx % 2 == 0)
+                    {
+                        TURBO_SET_PIXEL_BOUNDS(dx, dy, color);
+                    }
+                    else if (dx % 4 < 3)
+                    {
+                        TURBO_SET_PIXEL_BOUNDS(dx, dy, color);
+                    }
+                    break;
+                }
+                case 4:
+                {
+                    // 75% faded
+                    if (dy % 2 == 0 || dx % 2 == 0)
+                    {
+                        TURBO_SET_PIXEL_BOUNDS(dx, dy, color);
+                    }
+                    break;
+                }
+                default:
+                {
+                    return;
+                }
+            }
+        }
+    }
+}
+
+static void oddEvenFillPerPixel(int x0, int y0, int x1, int y1, paletteColor_t boundaryColor, paletteColor_t fillColor)
+{
+    SETUP_FOR_TURBO();
+
+    // Adjust the bounding box if it's out of bounds
+    if (x0 < 0)
+    {
+        x0 = 0;
+    }
+    if (x1 > TFT_WIDTH)
+    {
+        x1 = TFT_WIDTH;
+    }
+    if (y0 < 0)
+    {
+        y0 = 0;
+    }
+    if (y1 > TFT_HEIGHT)
+    {
+        y1 = TFT_HEIGHT;
+    }
+    for (int y = y0; y < y1; y++)
+    {
+        // Assume starting outside the shape or on border for each row
+        // Count rising edges of row
+        bool isInside            = false;
+        bool insideHysteresis    = false;
+        uint16_t transitionCount = 0;
+        // Pre-scan the row for even number of transitions. Algo only works for even number of transitions.
+        for (int x = x0; x < x1; x++)
+        {
+            if (boundaryColor == getPxTft(x, y))
+            {
+                // Flip this boolean, don't color the boundary
+                if (!insideHysteresis)
+                {
+                    isInside         = !isInside;
+                    insideHysteresis = true;
+                    transitionCount++;
+                }
+            }
+            else
+            {
+                insideHysteresis = false; // If not on a boundary color, reset hysteresis
+            }
+        }
+        if (!(transitionCount % 2)) // Check for even number of transitions to prevent coloring to edge of bounding box.
+        {
+            isInside         = false;
+            insideHysteresis = false;
+            for (int x = x0; x < x1; x++)
+            {
+                // If a boundary is hit
+                if (boundaryColor == getPxTft(x, y))
+                {
+                    // Flip this boolean, don't color the boundary
+                    if (!insideHysteresis)
+                    {
+                        isInside         = !isInside;
+                        insideHysteresis = true;
+                    }
+                }
+                else if (isInside)
+                {
+                    // If we're in-bounds, color the pixel
+                    TURBO_SET_PIXEL_BOUNDS(x, y, fillColor);
+                    insideHysteresis = false;
+                }
+                else
+                {
+                    insideHysteresis = false;
+                }
+            }
+        }
+    }
+}
+
+static void fillCircleSectorPerPixel(uint16_t x, uint16_t y, uint16_t innerR, uint16_t outerR, uint16_t startAngle,
+                                     uint16_t endAngle, paletteColor_t col)
+{
+    for (uint16_t deg = startAngle; deg != endAngle; deg = (deg + 1) % 360)
+    {
+        uint16_t inStartX  = x + getCos1024(deg) * innerR / 1024;
+        uint16_t inStartY  = y - getSin1024(deg) * innerR / 1024;
+        uint16_t outStartX = x + getCos1024(deg) * outerR / 1024;
+        uint16_t outStartY = y - getSin1024(deg) * outerR / 1024;
+        uint16_t inEndX    = x + getCos1024((deg + 1) % 360) * innerR / 1024;
+        uint16_t inEndY    = y - getSin1024((deg + 1) % 360) * innerR / 1024;
+        uint16_t outEndX   = x + getCos1024((deg + 1) % 360) * outerR / 1024;
+        uint16_t outEndY   = y - getSin1024((deg + 1) % 360) * outerR / 1024;
+
+        drawTriangleOutlinedPerPixel(inStartX, inStartY, outStartX, outStartY, outEndX, outEndY, col, col);
+        drawTriangleOutlinedPerPixel(inEndX, inEndY, outEndX, outEndY, inStartX, inStartY, col, col);
+    }
+}
+//==============================================================================
+// Functions
+//==============================================================================
+
+/**
+ * @brief Return the next value from a xorshift generator, so each run draws the same shapes
+ *
+ * @param state The generator state, which must not be zero
+ * @return The next pseudo-random value
+ */
+static uint32_t fillBenchRand(uint32_t* state)
+{
+    uint32_t x = *state;
+    x ^= x << 13;
+    x ^= x >> 17;
+    x ^= x << 5;
+    *state = x;
+    return x;
+}
+
+/**
+ * @brief Generate one set of parameters for a primitive. Positions may be a little off screen to exercise clipping
+ *
+ * @param state The generator state
+ * @param p [OUT] The ::FB_NUM_PARAMS parameters
+ */
+static void fillBenchParams(uint32_t* state, int32_t* p)
+{
+    p[0] = (int32_t)(fillBenchRand(state) % (TFT_WIDTH + 40)) - 20;
+    p[1] = (int32_t)(fillBenchRand(state) % (TFT_HEIGHT + 40)) - 20;
+    p[2] = (int32_t)(fillBenchRand(state) % (TFT_WIDTH + 40)) - 20;
+    p[3] = (int32_t)(fillBenchRand(state) % (TFT_HEIGHT + 40)) - 20;
+    p[4] = (int32_t)(fillBenchRand(state) % (TFT_WIDTH + 40)) - 20;
+    p[5] = (int32_t)(fillBenchRand(state) % (TFT_HEIGHT + 40)) - 20;
+    p[6] = 4 + (int32_t)(fillBenchRand(state) % 60);
+    p[7] = (int32_t)(fillBenchRand(state) % 360);
+}
+
+/**
+ * @brief Draw whatever a primitive needs on the display before it is timed. Only oddEvenFill() needs anything, a
+ * boundary to fill
+ *
+ * @param prim The primitive about to be drawn
+ * @param p The parameters it will be drawn with
+ */
+static void fillBenchSetup(fillBenchPrim_t prim, const int32_t* p)
+{
+    clearPxTft();
+    if (FB_ODD_EVEN_FILL == prim)
+    {
+        drawCircle(p[0], p[1], p[6], c555);
+        drawTriangleOutlined(p[0], p[1], p[2], p[3], p[4], p[5], cTransparent, c555);
+    }
+}
+
+/**
+ * @brief Draw one primitive with either the span or the per-pixel implementation
+ *
+ * @param prim The primitive to draw
+ * @param perPixel true to draw with the per-pixel implementation, false to draw with the span implementation
+ * @param p The parameters to draw with
+ */
+static void fillBenchDraw(fillBenchPrim_t prim, bool perPixel, const int32_t* p)
+{
+    int32_t r = p[6];
+    switch (prim)
+    {
+        case FB_TRIANGLE:
+        {
+            (perPixel ? drawTriangleOutlinedPerPixel : drawTriangleOutlined)(p[0], p[1], p[2], p[3], p[4], p[5], c123,
+                                                                             c531);
+            break;
+        }
+        case FB_CIRCLE_FILLED:
+        {
+            (perPixel ? drawCircleFilledPerPixel : drawCircleFilled)(p[0], p[1], r, c123);
+            break;
+        }
+        case FB_CIRCLE_QUADRANTS:
+        {
+            bool q1 = p[7] & 1;
+            bool q2 = p[7] & 2;
+            bool q3 = p[7] & 4;
+            bool q4 = p[7] & 8;
+            (perPixel ? drawCircleFilledQuadrantsPerPixel : drawCircleFilledQuadrants)(p[0], p[1], r, q1, q2, q3, q4,
+                                                                                       c123);
+            break;
+        }
+        case FB_CIRCLE_SCALED:
+        {
+            int32_t scale = 1 + p[7] % 4;
+            (perPixel ? drawCircleFilledScaledPerPixel : drawCircleFilledScaled)(p[0] / scale, p[1] / scale,
+                                                                                 r / scale, c123, 0, 0, scale, scale);
+            break;
+        }
+        case FB_CIRCLE_OUTLINE:
+        {
+            int32_t stroke = 1 + p[7] % MAX(1, r / 2);
+            (perPixel ? drawCircleOutlinePerPixel : drawCircleOutline)(p[0], p[1], r, stroke, c123);
+            break;
+        }
+        case FB_ROUNDED_RECT:
+        {
+            int32_t x0 = MIN(p[0], p[2]);
+            int32_t x1 = MAX(p[0], p[2]);
+            int32_t y0 = MIN(p[1], p[3]);
+            int32_t y1 = MAX(p[1], p[3]);
+            r          = MIN(r, MIN(x1 - x0, y1 - y0) / 2);
+            (perPixel ? drawRoundedRectPerPixel : drawRoundedRect)(x0, y0, x1, y1, r, c123, c531);
+            break;
+        }
+        case FB_SHADE_AREA:
+        {
+            int16_t x0 = MIN(p[0], p[2]);
+            int16_t x1 = MAX(p[0], p[2]);
+            int16_t y0 = MIN(p[1], p[3]);
+            int16_t y1 = MAX(p[1], p[3]);
+            (perPixel ? shadeDisplayAreaPerPixel : shadeDisplayArea)(x0, y0, x1, y1, p[7] % 5, c123);
+            break;
+        }
+        case FB_ODD_EVEN_FILL:
+        {
+            (perPixel ? oddEvenFillPerPixel : oddEvenFill)(0, 0, TFT_WIDTH, TFT_HEIGHT, c555, c123);
+            break;
+        }
+        case FB_CIRCLE_SECTOR:
+        {
+            uint16_t x     = CLAMP(p[0], 0, TFT_WIDTH - 1);
+            uint16_t y     = CLAMP(p[1], 0, TFT_HEIGHT - 1);
+            uint16_t inner = r / 2;
+            uint16_t end   = (p[7] + 30 + p[2] % 300) % 360;
+            (perPixel ? fillCircleSectorPerPixel : fillCircleSector)(x, y, inner, r, p[7], end, c123);
+            break;
+        }
+        default:
+        {
+            break;
+        }
+    }
+}
+
+/**
+ * @brief Time each span-based shape and fill primitive against the per-pixel implementation it replaced, check that
+ * both draw the same pixels, and log the results
+ *
+ * @param reps The number of shapes to draw with each implementation of each primitive
+ */
+void emulatorFillBenchmark(int32_t reps)
+{
+    // Arguments are handled before the display is set up
+    initTFT(0, 0, 0, 0, 0, 0, 0, false, 0, 0, 0);
+    paletteColor_t* fb = getPxTftFramebuffer();
+
+    paletteColor_t* spanPx = heap_caps_malloc(sizeof(paletteColor_t) * TFT_WIDTH * TFT_HEIGHT, MALLOC_CAP_8BIT);
+    int32_t* params        = heap_caps_malloc(sizeof(int32_t) * FB_NUM_PARAMS * reps, MALLOC_CAP_8BIT);
+    if (NULL == spanPx || NULL == params)
+    {
+        heap_caps_free(spanPx);
+        heap_caps_free(params);
+        deinitTFT();
+        return;
+    }
+
+    for (fillBenchPrim_t prim = 0; prim < FB_NUM_PRIMITIVES; prim++)
+    {
+        uint32_t seed = 0x5AD6E + prim;
+        for (int32_t i = 0; i < reps; i++)
+        {
+            fillBenchParams(&seed, &params[i * FB_NUM_PARAMS]);
+        }
+
+        // Time both implementations. Setup is drawn first and not counted
+        int64_t us[2] = {0};
+        for (int perPixel = 0; perPixel < 2; perPixel++)
+        {
+            for (int32_t i = 0; i < reps; i++)
+            {
+                fillBenchSetup(prim, &params[i * FB_NUM_PARAMS]);
+                int64_t start = esp_timer_get_time();
+                fillBenchDraw(prim, perPixel, &params[i * FB_NUM_PARAMS]);
+                us[perPixel] += esp_timer_get_time() - start;
+            }
+        }
+
+        // Draw each shape with both implementations and count the shapes and pixels which differ
+        int32_t diffShapes = 0;
+        int64_t diffPx     = 0;
+        for (int32_t i = 0; i < reps; i++)
+        {
+            fillBenchSetup(prim, &params[i * FB_NUM_PARAMS]);
+            fillBenchDraw(prim, false, &params[i * FB_NUM_PARAMS]);
+            memcpy(spanPx, fb, sizeof(paletteColor_t) * TFT_WIDTH * TFT_HEIGHT);
+
+            fillBenchSetup(prim, &params[i * FB_NUM_PARAMS]);
+            fillBenchDraw(prim, true, &params[i * FB_NUM_PARAMS]);
+
+            int32_t shapeDiff = 0;
+            for (int32_t px = 0; px < TFT_WIDTH * TFT_HEIGHT; px++)
+            {
+                shapeDiff += (spanPx[px] != fb[px]);
+            }
+            diffShapes += (0 != shapeDiff);
+            diffPx += shapeDiff;
+        }
+
+        ESP_LOGI("FillBench",
+                 "%-25s %" PRId32 " shapes: spans %" PRId64 "ns, per-pixel %" PRId64 "ns per shape (%" PRId64
+                 "%%), %" PRId32 " shapes differ by %" PRId64 " px",
+                 primNames[prim], reps, us[0] * 1000 / reps, us[1] * 1000 / reps,
+                 us[1] ? (us[0] * 100 / us[1]) : 0, diffShapes, diffPx);
+    }
+
+    heap_caps_free(spanPx);
+    heap_caps_free(params);
+    deinitTFT();
+}
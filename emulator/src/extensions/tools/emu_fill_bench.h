@@ -0,0 +1,5 @@
+#pragma once
+
+#include <stdint.h>
+
+void emulatorFillBenchmark(int32_t reps);
@@ -52,6 +52,7 @@ typedef struct
     const char* func;
     uint32_t line;
     char tag[32];
+    size_t highWater;
 } allocation_t;
 
 //==============================================================================
@@ -153,6 +154,38 @@ void dumpAllocTable(void)
                    al->caps & MALLOC_CAP_SPIRAM ? (uint32_t)al->size : 0, 0, 0);
         }
     }
+
+    // Arenas report how much of their allocation was ever used
+    for (int idx = 0; idx < A_TABLE_SIZE; idx++)
+    {
+        allocation_t* al = &aTable[idx];
+        if (al->ptr && al->highWater)
+        {
+            printf("%s,%s,%p,high-water %d of %d\n", "ARENA", al->tag, al->ptr, (uint32_t)al->highWater,
+                   (uint32_t)al->size);
+        }
+    }
+}
+
+/**
+ * @brief Record the most of an allocation that was ever in use, for allocations which are suballocated like arenas.
+ * It is printed by dumpAllocTable().
+ *
+ * @param ptr The allocation
+ * @param highWater The most bytes of the allocation that were ever in use
+ */
+void heap_caps_track_high_water(void* ptr, size_t highWater)
+{
+#ifdef MEMORY_DEBUG
+    for (int idx = 0; idx < A_TABLE_SIZE; idx++)
+    {
+        if (ptr == aTable[idx].ptr)
+        {
+            aTable[idx].highWater = highWater;
+            return;
+        }
+    }
+#endif
 }
 
 /**
@@ -72,6 +72,10 @@ bool loadFont(const char* name, font_t* font, bool spiRam)
         font->chars[chIdx++].width = 0;
     }
 
+    // Expand the characters into runs so they draw faster
+    font->atlas = NULL;
+    buildFontAtlas(font, spiRam);
+
     return true;
 }
 
@@ -84,6 +88,8 @@ void freeFont(font_t* font)
 {
     if (font->height)
     {
+        clearTextWidthCache(font);
+        freeFontAtlas(font);
         // using uint8_t instead of char because a char will overflow to -128 after the last char is freed (\x7f)
         for (uint8_t idx = 0; idx <= '~' - ' ' + 1; idx++)
         {
@@ -14,10 +14,168 @@
 #include "fs_wsg.h"
 #include "macros.h"
 
+//==============================================================================
+// Function Prototypes
+//==============================================================================
+
+static bool wsgFromDecompressed(wsg_t* wsg, const uint8_t* buf, uint32_t bufSize, bool spiRam, const char* tag);
+static bool wsgDecodeRle(wsg_t* wsg, const uint8_t* rle, uint32_t rleSize, bool spiRam, const char* tag);
+
 //==============================================================================
 // Functions
 //==============================================================================
 
+/**
+ * @brief Fill in a WSG from a decompressed WSG file, allocating its pixels and span table
+ *
+ * @param wsg The WSG to fill in
+ * @param buf The decompressed file, a four byte header followed by raw or run-length encoded pixels
+ * @param bufSize The size of buf
+ * @param spiRam true to allocate in SPI RAM, false to allocate in normal RAM
+ * @param tag A name to tag allocations with
+ * @return true if the WSG was filled in, false if it was malformed or memory couldn't be allocated
+ */
+static bool wsgFromDecompressed(wsg_t* wsg, const uint8_t* buf, uint32_t bufSize, bool spiRam, const char* tag)
+{
+    if (bufSize < 4)
+    {
+        return false;
+    }
+
+    // The first four bytes are dimension. The top bit of width marks run-length encoded pixels
+    uint16_t w    = (buf[0] << 8) | buf[1];
+    bool rle      = (w & WSG_RLE_FLAG) ? true : false;
+    wsg->w        = w & ~WSG_RLE_FLAG;
+    wsg->h        = (buf[2] << 8) | buf[3];
+    wsg->spans    = NULL;
+    wsg->rowSpans = NULL;
+
+    // The rest of the bytes are pixels
+    wsg->px = (paletteColor_t*)heap_caps_malloc_tag(sizeof(paletteColor_t) * wsg->w * wsg->h,
+                                                    spiRam ? MALLOC_CAP_SPIRAM : MALLOC_CAP_8BIT, tag);
+    if (NULL == wsg->px)
+    {
+        return false;
+    }
+
+    if (rle)
+    {
+        if (!wsgDecodeRle(wsg, &buf[4], bufSize - 4, spiRam, tag))
+        {
+            ESP_LOGE("WSG", "Malformed RLE WSG %s", tag);
+            heap_caps_free(wsg->px);
+            if (NULL != wsg->spans)
+            {
+                heap_caps_free(wsg->spans);
+            }
+            wsg->px       = NULL;
+            wsg->spans    = NULL;
+            wsg->rowSpans = NULL;
+            return false;
+        }
+    }
+    else
+    {
+        memcpy(wsg->px, &buf[4], MIN(bufSize - 4, (uint32_t)wsg->w * wsg->h));
+        wsgFindSpans(wsg, spiRam, tag);
+    }
+    return true;
+}
+
+/**
+ * @brief Expand run-length encoded pixels into a WSG and build its span table from the runs.
+ *
+ * Each row is a sequence of (skip, run) byte pairs. skip transparent pixels are followed by run opaque pixels, which
+ * follow the pair. Pairs repeat until the row is full. Runs longer than 255 pixels are split with a skip of 0.
+ *
+ * @param wsg The WSG to expand into, with w, h, and px already set
+ * @param rle The encoded pixels
+ * @param rleSize The number of encoded bytes
+ * @param spiRam true to allocate the span table in SPI RAM, false to allocate it in normal RAM
+ * @param tag A name to tag allocations with
+ * @return true if the pixels were expanded, false if they were malformed
+ */
+static bool wsgDecodeRle(wsg_t* wsg, const uint8_t* rle, uint32_t rleSize, bool spiRam, const char* tag)
+{
+    // Two passes. The first validates the data and counts spans so the table can be allocated, the second fills it in
+    for (int pass = 0; pass < 2; pass++)
+    {
+        uint32_t idx       = 0;
+        uint32_t numSpans  = 0;
+        paletteColor_t* px = wsg->px;
+
+        for (int32_t y = 0; y < wsg->h; y++)
+        {
+            if (pass && wsg->spans)
+            {
+                wsg->rowSpans[y] = numSpans;
+            }
+
+            int32_t x       = 0;
+            bool spanIsOpen = false;
+            while (x < wsg->w)
+            {
+                if (idx + 2 > rleSize)
+                {
+                    return false;
+                }
+                uint8_t skip = rle[idx++];
+                uint8_t run  = rle[idx++];
+                if (0 == skip + run || x + skip + run > wsg->w || idx + run > rleSize)
+                {
+                    return false;
+                }
+
+                if (pass)
+                {
+                    memset(&px[x], cTransparent, skip);
+                    memcpy(&px[x + skip], &rle[idx], run);
+                }
+                idx += run;
+                x += skip;
+
+                if (run)
+                {
+                    // A skip of 0 continues the previous span
+                    if (spanIsOpen && 0 == skip)
+                    {
+                        if (pass && wsg->spans)
+                        {
+                            wsg->spans[numSpans - 1].len += run;
+                        }
+                    }
+                    else
+                    {
+                        if (pass && wsg->spans)
+                        {
+                            wsg->spans[numSpans].x   = x;
+                            wsg->spans[numSpans].len = run;
+                        }
+                        numSpans++;
+                    }
+                    spanIsOpen = true;
+                    x += run;
+                }
+                else
+                {
+                    spanIsOpen = false;
+                }
+            }
+            px += wsg->w;
+        }
+
+        if (pass && wsg->spans)
+        {
+            wsg->rowSpans[wsg->h] = numSpans;
+        }
+        else if (!pass)
+        {
+            wsgAllocSpans(wsg, numSpans, spiRam, tag);
+        }
+    }
+    return true;
+}
+
 /**
  * @brief Load a WSG from ROM to RAM. WSGs placed in the assets_image folder
  * before compilation will be automatically flashed to ROM
@@ -40,23 +198,12 @@ bool loadWsg(const char* name, wsg_t* wsg, bool spiRam)
         return false;
     }
 
-    // Save the decompressed info to the wsg. The first four bytes are dimension
-    wsg->w = (decompressedBuf[0] << 8) | decompressedBuf[1];
-    wsg->h = (decompressedBuf[2] << 8) | decompressedBuf[3];
-    // The rest of the bytes are pixels
-    wsg->px = (paletteColor_t*)heap_caps_malloc_tag(sizeof(paletteColor_t) * wsg->w * wsg->h,
-                                                    spiRam ? MALLOC_CAP_SPIRAM : MALLOC_CAP_8BIT, name);
-
-    if (NULL != wsg->px)
-    {
-        memcpy(wsg->px, &decompressedBuf[4], decompressedSize - 4);
-        heap_caps_free(decompressedBuf);
-        return true;
-    }
+    // Save the decompressed info to the wsg
+    bool result = wsgFromDecompressed(wsg, decompressedBuf, decompressedSize, spiRam, name);
 
     // all done
     heap_caps_free(decompressedBuf);
-    return false;
+    return result;
 }
 
 /**
@@ -85,21 +232,8 @@ bool loadWsgInplace(const char* name, wsg_t* wsg, bool spiRam, uint8_t* decompre
         return false;
     }
 
-    // Save the decompressed info to the wsg. The first four bytes are dimension
-    wsg->w = (decompressedBuf[0] << 8) | decompressedBuf[1];
-    wsg->h = (decompressedBuf[2] << 8) | decompressedBuf[3];
-    // The rest of the bytes are pixels
-    wsg->px = (paletteColor_t*)heap_caps_malloc_tag(sizeof(paletteColor_t) * wsg->w * wsg->h,
-                                                    spiRam ? MALLOC_CAP_SPIRAM : MALLOC_CAP_8BIT, name);
-
-    if (NULL != wsg->px)
-    {
-        memcpy(wsg->px, &decompressedBuf[4], decompressedSize - 4);
-        return true;
-    }
-
-    // all done
-    return false;
+    // Save the decompressed info to the wsg
+    return wsgFromDecompressed(wsg, decompressedBuf, decompressedSize, spiRam, name);
 }
 
 bool loadWsgNvs(const char* namespace, const char* key, wsg_t* wsg, bool spiRam)
@@ -115,29 +249,20 @@ bool loadWsgNvs(const char* namespace, const char* key, wsg_t* wsg, bool spiRam)
 
     ESP_LOGD("WSG", "decompressedBuf size is %" PRIu32, decompressedSize);
 
-    // Save the decompressed info to the wsg. The first four bytes are dimension
-    wsg->w = (decompressedBuf[0] << 8) | decompressedBuf[1];
-    wsg->h = (decompressedBuf[2] << 8) | decompressedBuf[3];
-
-    ESP_LOGD("WSG", "full WSG is %" PRIu16 " x %" PRIu16 ", or %d pixels", wsg->w, wsg->h, wsg->w * wsg->h);
-
-    // The rest of the bytes are pixels
-    wsg->px = (paletteColor_t*)heap_caps_malloc_tag(sizeof(paletteColor_t) * wsg->w * wsg->h,
-                                                    spiRam ? MALLOC_CAP_SPIRAM : MALLOC_CAP_8BIT, key);
-
-    if (NULL != wsg->px)
+    // Save the decompressed info to the wsg
+    bool result = wsgFromDecompressed(wsg, decompressedBuf, decompressedSize, spiRam, key);
+    if (result)
     {
-        ESP_LOGD("WSG", "Copying %" PRIu32 " pixels into WSG now", decompressedSize - 4);
-        memcpy(wsg->px, &decompressedBuf[4], decompressedSize - 4);
-        heap_caps_free(decompressedBuf);
-        return true;
+        ESP_LOGD("WSG", "full WSG is %" PRIu16 " x %" PRIu16 ", or %d pixels", wsg->w, wsg->h, wsg->w * wsg->h);
+    }
+    else
+    {
+        ESP_LOGE("WSG", "Allocating pixels failed");
     }
-
-    ESP_LOGE("WSG", "Allocating pixels failed");
 
     // all done
     heap_caps_free(decompressedBuf);
-    return false;
+    return result;
 }
 
 bool saveWsgNvs(const char* namespace, const char* key, const wsg_t* wsg)
@@ -198,7 +323,13 @@ void freeWsg(wsg_t* wsg)
     if (wsg->w && wsg->h)
     {
         heap_caps_free(wsg->px);
-        wsg->h = 0;
-        wsg->w = 0;
+        if (NULL != wsg->spans)
+        {
+            heap_caps_free(wsg->spans);
+        }
+        wsg->spans    = NULL;
+        wsg->rowSpans = NULL;
+        wsg->h        = 0;
+        wsg->w        = 0;
     }
 }
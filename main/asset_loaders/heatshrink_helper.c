@@ -1,4 +1,5 @@
 #include <stddef.h>
+#include <string.h>
 
 #include <esp_log.h>
 #include <esp_heap_caps.h>
@@ -10,75 +11,173 @@
 #include <nvs.h>
 
 #include "heatshrink_helper.h"
+#include "macros.h"
+
+static bool heatshrinkDecodeBuf(const heatshrinkHeader_t* hdr, const uint8_t* source, uint32_t sourceSize,
+                                uint8_t* dest, heatshrink_decoder* hsd, const char* name);
 
 /**
- * @brief Read a heatshrink compressed file from the filesystem into an output array.
- * Files that are in the assets_image folder before compilation and flashing
- * will automatically be included in the firmware.
+ * @brief Parse the four byte header at the start of heatshrink data
  *
- * You must provide a decoder and decode space for this function
+ * @param buf The heatshrink data
+ * @param bufSize The number of bytes in buf
+ * @param hdr The parsed header is written here
+ * @return true if the header was parsed, false if it is too short or the parameters are invalid
+ */
+bool heatshrinkParseHeader(const uint8_t* buf, uint32_t bufSize, heatshrinkHeader_t* hdr)
+{
+    // Can't decompress if the heatshrink header doesn't even fit
+    if (bufSize < HS_HDR_SIZE)
+    {
+        return false;
+    }
+
+    hdr->size   = (buf[1] << 16) | (buf[2] << 8) | (buf[3]);
+    hdr->stored = (HS_HDR_STORED == buf[0]);
+    if (HS_HDR_LEGACY == buf[0])
+    {
+        // Written before the parameters were part of the header
+        hdr->windowSz2    = HS_DEFAULT_WINDOW;
+        hdr->lookaheadSz2 = HS_DEFAULT_LOOKAHEAD;
+    }
+    else if (hdr->stored)
+    {
+        hdr->windowSz2    = 0;
+        hdr->lookaheadSz2 = 0;
+        return (bufSize - HS_HDR_SIZE) >= hdr->size;
+    }
+    else
+    {
+        hdr->windowSz2    = buf[0] >> 4;
+        hdr->lookaheadSz2 = buf[0] & 0x0F;
+    }
+
+    return (hdr->windowSz2 >= HEATSHRINK_MIN_WINDOW_BITS) && (hdr->windowSz2 <= HEATSHRINK_MAX_WINDOW_BITS)
+           && (hdr->lookaheadSz2 >= HEATSHRINK_MIN_LOOKAHEAD_BITS) && (hdr->lookaheadSz2 < hdr->windowSz2);
+}
+
+/**
+ * @brief Decompress heatshrink data with a parsed header into a buffer
  *
- * @param fname   The name of the file to load
- * @param outsize A pointer to a size_t to return how much data was read
- * @param decompressedBuf Memory to store decoded data. This must be as large as the decoded data
- * @param hsd A heatshrink decoder
- * @return A pointer to the read data if successful, or NULL if there is a failure
- *         This data must be freed when done
+ * @param hdr The parsed header of the data
+ * @param source The heatshrink data, including the header
+ * @param sourceSize The number of bytes in source
+ * @param dest Memory to store decoded data. This must be at least hdr->size bytes
+ * @param hsd A heatshrink decoder to use, or NULL to allocate one. If its parameters don't match the header, a
+ * temporary one is allocated instead
+ * @param name The name of the data, for error logs
+ * @return true if the data was decompressed, false if it wasn't
  */
-uint8_t* readHeatshrinkFileInplace(const char* fname, uint32_t* outsize, uint8_t* decompressedBuf,
-                                   heatshrink_decoder* hsd)
+static bool heatshrinkDecodeBuf(const heatshrinkHeader_t* hdr, const uint8_t* source, uint32_t sourceSize,
+                                uint8_t* dest, heatshrink_decoder* hsd, const char* name)
 {
-    // Read WSG from file
-    size_t sz;
-    const uint8_t* buf = cnfsGetFile(fname, &sz);
-    if (NULL == buf)
+    if (hdr->stored)
     {
-        ESP_LOGE("WSG", "Failed to read %s", fname);
-        (*outsize) = 0;
-        return NULL;
+        // Nothing to decode
+        memcpy(dest, &source[HS_HDR_SIZE], hdr->size);
+        return true;
     }
 
-    // Pick out the decompressed size and create a space for it
-    (*outsize) = (buf[0] << 24) | (buf[1] << 16) | (buf[2] << 8) | (buf[3]);
+    // Use the given decoder if it can decode this data, otherwise make one which can
+    heatshrink_decoder* tmpHsd = NULL;
+    if (NULL == hsd || HEATSHRINK_DECODER_WINDOW_BITS(hsd) != hdr->windowSz2
+        || HEATSHRINK_DECODER_LOOKAHEAD_BITS(hsd) != hdr->lookaheadSz2)
+    {
+        tmpHsd = heatshrink_decoder_alloc(256, hdr->windowSz2, hdr->lookaheadSz2);
+        if (NULL == tmpHsd)
+        {
+            ESP_LOGE("HS", "Failed to allocate decoder for %s", name);
+            return false;
+        }
+        hsd = tmpHsd;
+    }
 
-    // Create the decoder
     size_t copied = 0;
     heatshrink_decoder_reset(hsd);
 
-    // The decompressed filesize is four bytes, so start after that
-    uint32_t inputIdx  = 4;
+    // The header is four bytes, so start after that
+    uint32_t inputIdx  = HS_HDR_SIZE;
     uint32_t outputIdx = 0;
+    bool ok            = true;
     // Decode the file in chunks
-    while (inputIdx < sz)
+    while (inputIdx < sourceSize)
     {
         // Decode some data
         copied = 0;
-        heatshrink_decoder_sink(hsd, &buf[inputIdx], sz - inputIdx, &copied);
+        heatshrink_decoder_sink(hsd, &source[inputIdx], sourceSize - inputIdx, &copied);
         inputIdx += copied;
 
         if (copied == 0)
         {
-            ESP_LOGE("WSG", "Failed to read %s fault on decode", fname);
-            heatshrink_decoder_finish(hsd);
-            return 0;
+            ESP_LOGE("HS", "Failed to decompress %s, fault on decode", name);
+            ok = false;
+            break;
         }
 
         // Save it to the output array
         copied = 0;
-        heatshrink_decoder_poll(hsd, &decompressedBuf[outputIdx], (*outsize) - outputIdx, &copied);
+        heatshrink_decoder_poll(hsd, &dest[outputIdx], hdr->size - outputIdx, &copied);
         outputIdx += copied;
     }
 
     // Note that it's all done
     heatshrink_decoder_finish(hsd);
 
-    // Flush any final output
-    copied = 0;
-    heatshrink_decoder_poll(hsd, &decompressedBuf[outputIdx], (*outsize) - outputIdx, &copied);
-    outputIdx += copied;
+    if (ok)
+    {
+        // Flush any final output
+        copied = 0;
+        heatshrink_decoder_poll(hsd, &dest[outputIdx], hdr->size - outputIdx, &copied);
+        outputIdx += copied;
 
-    // All done decoding
-    heatshrink_decoder_finish(hsd);
+        // All done decoding
+        heatshrink_decoder_finish(hsd);
+    }
+
+    if (NULL != tmpHsd)
+    {
+        heatshrink_decoder_free(tmpHsd);
+    }
+    return ok;
+}
+
+/**
+ * @brief Read a heatshrink compressed file from the filesystem into an output array.
+ * Files that are in the assets_image folder before compilation and flashing
+ * will automatically be included in the firmware.
+ *
+ * You must provide a decoder and decode space for this function. If the file was compressed with different parameters
+ * than the decoder, a temporary decoder is allocated for it.
+ *
+ * @param fname   The name of the file to load
+ * @param outsize A pointer to a size_t to return how much data was read
+ * @param decompressedBuf Memory to store decoded data. This must be as large as the decoded data
+ * @param hsd A heatshrink decoder
+ * @return A pointer to the read data if successful, or NULL if there is a failure
+ *         This data must be freed when done
+ */
+uint8_t* readHeatshrinkFileInplace(const char* fname, uint32_t* outsize, uint8_t* decompressedBuf,
+                                   heatshrink_decoder* hsd)
+{
+    // Read WSG from file
+    size_t sz;
+    const uint8_t* buf = cnfsGetFile(fname, &sz);
+    heatshrinkHeader_t hdr;
+    if (NULL == buf || !heatshrinkParseHeader(buf, sz, &hdr))
+    {
+        ESP_LOGE("WSG", "Failed to read %s", fname);
+        (*outsize) = 0;
+        return NULL;
+    }
+
+    // Pick out the decompressed size
+    (*outsize) = hdr.size;
+
+    // Decode the file
+    if (!heatshrinkDecodeBuf(&hdr, buf, sz, decompressedBuf, hsd, fname))
+    {
+        return NULL;
+    }
 
     // Return the decompressed bytes
     return decompressedBuf;
@@ -100,7 +199,8 @@ uint8_t* readHeatshrinkFile(const char* fname, uint32_t* outsize, bool readToSpi
     // Read WSG from file
     size_t sz;
     const uint8_t* buf = cnfsGetFile(fname, &sz);
-    if (NULL == buf)
+    heatshrinkHeader_t hdr;
+    if (NULL == buf || !heatshrinkParseHeader(buf, sz, &hdr))
     {
         ESP_LOGE("WSG", "Failed to read %s", fname);
         (*outsize) = 0;
@@ -108,34 +208,28 @@ uint8_t* readHeatshrinkFile(const char* fname, uint32_t* outsize, bool readToSpi
     }
 
     // Pick out the decompressed size and create a space for it
-    int32_t decompressedSize = (buf[0] << 24) | (buf[1] << 16) | (buf[2] << 8) | (buf[3]);
     uint8_t* decompressedBuf;
     if (readToSpiRam)
     {
-        decompressedBuf = (uint8_t*)heap_caps_malloc(decompressedSize, MALLOC_CAP_SPIRAM);
+        decompressedBuf = (uint8_t*)heap_caps_malloc(hdr.size, MALLOC_CAP_SPIRAM);
     }
     else
     {
-        decompressedBuf = (uint8_t*)heap_caps_malloc(decompressedSize, MALLOC_CAP_8BIT);
+        decompressedBuf = (uint8_t*)heap_caps_malloc(hdr.size, MALLOC_CAP_8BIT);
     }
 
-    // Allocate the decoder
-    heatshrink_decoder* hsd = heatshrink_decoder_alloc(256, 8, 4);
-
-    // Decode the file
-    uint8_t* data = readHeatshrinkFileInplace(fname, outsize, decompressedBuf, hsd);
-
-    // Free the decoder
-    heatshrink_decoder_free(hsd);
-
-    // If there was an error, free decompressedBuf
-    if (NULL == data)
+    // Decode the file, with a decoder made for it
+    if (NULL == decompressedBuf || !heatshrinkDecodeBuf(&hdr, buf, sz, decompressedBuf, NULL, fname))
     {
+        // If there was an error, free decompressedBuf
         heap_caps_free(decompressedBuf);
+        (*outsize) = 0;
+        return NULL;
     }
 
     // Return the data
-    return data;
+    (*outsize) = hdr.size;
+    return decompressedBuf;
 }
 
 uint8_t* readHeatshrinkNvs(const char* namespace, const char* key, uint32_t* outsize, bool spiRam)
@@ -154,50 +248,25 @@ uint8_t* readHeatshrinkNvs(const char* namespace, const char* key, uint32_t* out
         return NULL;
     }
 
-    if (!readNamespaceNvsBlob(namespace, key, buf, &sz))
+    heatshrinkHeader_t hdr;
+    if (!readNamespaceNvsBlob(namespace, key, buf, &sz) || !heatshrinkParseHeader(buf, sz, &hdr))
     {
         heap_caps_free(buf);
         return NULL;
     }
 
     // Pick out the decompresed size and create a space for it
-    (*outsize) = (buf[0] << 24) | (buf[1] << 16) | (buf[2] << 8) | (buf[3]);
+    (*outsize) = hdr.size;
 
     uint8_t* decompressedBuf = (uint8_t*)heap_caps_malloc((*outsize), spiRam ? MALLOC_CAP_SPIRAM : MALLOC_CAP_8BIT);
 
-    // Create the decoder
-    size_t copied           = 0;
-    heatshrink_decoder* hsd = heatshrink_decoder_alloc(256, 8, 4);
-    heatshrink_decoder_reset(hsd);
-
-    // The decompressed filesize is four bytes, so start after that
-    uint32_t inputIdx  = 4;
-    uint32_t outputIdx = 0;
-    // Decode the file in chunks
-    while (inputIdx < sz)
+    // Decode the blob
+    if (NULL != decompressedBuf && !heatshrinkDecodeBuf(&hdr, buf, sz, decompressedBuf, NULL, key))
     {
-        // Decode some data
-        copied = 0;
-        heatshrink_decoder_sink(hsd, &buf[inputIdx], sz - inputIdx, &copied);
-        inputIdx += copied;
-
-        // Save it to the output array
-        copied = 0;
-        heatshrink_decoder_poll(hsd, &decompressedBuf[outputIdx], (*outsize) - outputIdx, &copied);
-        outputIdx += copied;
+        heap_caps_free(decompressedBuf);
+        decompressedBuf = NULL;
     }
 
-    // Note that it's all done
-    heatshrink_decoder_finish(hsd);
-
-    // Flush any final output
-    copied = 0;
-    heatshrink_decoder_poll(hsd, &decompressedBuf[outputIdx], (*outsize) - outputIdx, &copied);
-    outputIdx += copied;
-
-    // All done decoding
-    heatshrink_decoder_finish(hsd);
-    heatshrink_decoder_free(hsd);
     // Free the bytes read from the file
     heap_caps_free(buf);
 
@@ -205,6 +274,15 @@ uint8_t* readHeatshrinkNvs(const char* namespace, const char* key, uint32_t* out
     return decompressedBuf;
 }
 
+/**
+ * @brief Compress bytes with the default parameters. The header is written with ::HS_HDR_LEGACY in its first byte,
+ * like all data compressed before the parameters were part of the header.
+ *
+ * @param dest Where to write the header and compressed bytes. This must be at least size bytes
+ * @param src The bytes to compress
+ * @param size The number of bytes to compress
+ * @return The number of bytes written to dest including the header, or 0 if the data couldn't be compressed
+ */
 uint32_t heatshrinkCompress(uint8_t* dest, const uint8_t* src, uint32_t size)
 {
     heatshrink_encoder* hse = heatshrink_encoder_alloc(8, 4);
@@ -351,8 +429,9 @@ bool heatshrinkDecompress(uint8_t* dest, uint32_t* destSize, const uint8_t* sour
     // -- It should be possible to pass both a non-null destSize and non-null dest, as long as it's big enough
     bool sizeRead = false;
 
-    // Can't decompress if the heatshrnk header doesn't even fit
-    if (sourceSize < 4)
+    // Can't decompress if the heatshrnk header doesn't even fit, or is invalid
+    heatshrinkHeader_t hdr;
+    if (!heatshrinkParseHeader(source, sourceSize, &hdr))
     {
         return false;
     }
@@ -360,57 +439,173 @@ bool heatshrinkDecompress(uint8_t* dest, uint32_t* destSize, const uint8_t* sour
     // Write the destSize
     if (destSize)
     {
-        (*destSize) = (source[0] << 24) | (source[1] << 16) | (source[2] << 8) | (source[3]);
+        (*destSize) = hdr.size;
         sizeRead    = true;
     }
 
     // Write the actual data
     if (dest)
     {
-        // Create the decoder
-        size_t copied           = 0;
-        heatshrink_decoder* hsd = heatshrink_decoder_alloc(256, 8, 4);
-        heatshrink_decoder_reset(hsd);
+        return heatshrinkDecodeBuf(&hdr, source, sourceSize, dest, NULL, "buffer");
+    }
+
+    return sizeRead;
+}
 
-        // The decompressed filesize is four bytes, so start after that
-        uint32_t inputIdx  = 4;
-        uint32_t outputIdx = 0;
-        // Decode the file in chunks
-        while (inputIdx < sourceSize)
+/**
+ * @brief Start streaming a heatshrink compressed buffer, without decompressing any of it yet
+ *
+ * The decoder only needs memory for its window and a small input buffer, regardless of the decompressed size. Data
+ * which was stored without compression doesn't need a decoder at all. The compressed data must remain valid until the
+ * stream is deinitialized, which is always the case for files from cnfsGetFile().
+ *
+ * @param stream The stream to initialize
+ * @param source The compressed data, including the four byte header
+ * @param sourceSize The number of bytes in source
+ * @return true if the stream was initialized, or false if the header is invalid or memory couldn't be allocated
+ */
+bool heatshrinkStreamInit(heatshrinkStream_t* stream, const uint8_t* source, uint32_t sourceSize)
+{
+    memset(stream, 0, sizeof(heatshrinkStream_t));
+
+    heatshrinkHeader_t hdr;
+    if (!heatshrinkParseHeader(source, sourceSize, &hdr))
+    {
+        return false;
+    }
+
+    if (!hdr.stored)
+    {
+        stream->hsd = heatshrink_decoder_alloc(32, hdr.windowSz2, hdr.lookaheadSz2);
+        if (NULL == stream->hsd)
         {
-            // Decode some data
-            copied = 0;
-            heatshrink_decoder_sink(hsd, &source[inputIdx], sourceSize - inputIdx, &copied);
-            inputIdx += copied;
+            return false;
+        }
+    }
+
+    stream->remaining  = hdr.size;
+    stream->source     = &source[HS_HDR_SIZE];
+    stream->sourceSize = sourceSize - HS_HDR_SIZE;
+    return true;
+}
+
+/**
+ * @brief Read the next decompressed bytes from a heatshrink stream
+ *
+ * @param stream The stream to read from
+ * @param dest Where to write the decompressed bytes, or NULL to skip over them
+ * @param size The number of bytes to read
+ * @return The number of bytes read, which is less than size only at the end of the data
+ */
+uint32_t heatshrinkStreamRead(heatshrinkStream_t* stream, uint8_t* dest, uint32_t size)
+{
+    uint8_t scratch[32];
+    uint32_t read = 0;
+
+    if (size > stream->remaining)
+    {
+        size = stream->remaining;
+    }
 
-            if (copied == 0)
+    if (NULL == stream->hsd)
+    {
+        // Stored without compression, so just copy it
+        if (NULL != dest)
+        {
+            memcpy(dest, &stream->source[stream->sourceIdx], size);
+        }
+        stream->sourceIdx += size;
+        stream->remaining -= size;
+        return size;
+    }
+
+    while (read < size)
+    {
+        // Pull out whatever the decoder has ready
+        size_t polled = 0;
+        if (NULL != dest)
+        {
+            heatshrink_decoder_poll(stream->hsd, &dest[read], size - read, &polled);
+        }
+        else
+        {
+            heatshrink_decoder_poll(stream->hsd, scratch, MIN(size - read, sizeof(scratch)), &polled);
+        }
+        read += polled;
+
+        // If it didn't have enough, give it more input
+        if (read < size && 0 == polled)
+        {
+            size_t sunk = 0;
+            if (stream->sourceIdx < stream->sourceSize)
             {
-                ESP_LOGE("WSG", "Failed to decompress heatshrink buffer -- fault on decode");
-                heatshrink_decoder_finish(hsd);
-                heatshrink_decoder_free(hsd);
-                return false;
+                heatshrink_decoder_sink(stream->hsd, &stream->source[stream->sourceIdx],
+                                        stream->sourceSize - stream->sourceIdx, &sunk);
+                stream->sourceIdx += sunk;
             }
 
-            // Save it to the output array
-            copied = 0;
-            heatshrink_decoder_poll(hsd, &dest[outputIdx], (*destSize) - outputIdx, &copied);
-            outputIdx += copied;
+            if (0 == sunk)
+            {
+                // Out of input, the data must be truncated
+                ESP_LOGE("HS", "Heatshrink stream ended %" PRIu32 " bytes early", stream->remaining - read);
+                stream->remaining = read;
+                break;
+            }
         }
+    }
 
-        // Note that it's all done
-        heatshrink_decoder_finish(hsd);
+    stream->remaining -= read;
+    return read;
+}
 
-        // Flush any final output
-        copied = 0;
-        heatshrink_decoder_poll(hsd, &dest[outputIdx], (*destSize) - outputIdx, &copied);
-        outputIdx += copied;
+/**
+ * @brief Copy a heatshrink stream, so the copy can be read from the same position independently
+ *
+ * @param dest The stream to copy into. If it is not already initialized with a copy of the same stream, it should be
+ * zeroed
+ * @param src The stream to copy
+ * @param spiRam true to allocate the copy's decoder in SPIRAM, false to use normal RAM
+ * @return true if the stream was copied, or false if memory couldn't be allocated
+ */
+bool heatshrinkStreamCopy(heatshrinkStream_t* dest, const heatshrinkStream_t* src, bool spiRam)
+{
+    if (NULL == src->hsd)
+    {
+        // Stored without compression, so there's no decoder to copy
+        *dest = *src;
+        return true;
+    }
 
-        // All done decoding
-        heatshrink_decoder_finish(hsd);
-        heatshrink_decoder_free(hsd);
+    // The decoder's state is all plain data, followed by its input and window buffers
+    size_t decoderSize = sizeof(heatshrink_decoder) + src->hsd->input_buffer_size + (1 << src->hsd->window_sz2);
 
-        return true;
+    heatshrink_decoder* hsd = dest->hsd;
+    if (NULL == hsd)
+    {
+        hsd = heap_caps_malloc(decoderSize, spiRam ? MALLOC_CAP_SPIRAM : MALLOC_CAP_8BIT);
+        if (NULL == hsd)
+        {
+            return false;
+        }
     }
 
-    return sizeRead;
+    memcpy(hsd, src->hsd, decoderSize);
+
+    *dest     = *src;
+    dest->hsd = hsd;
+    return true;
+}
+
+/**
+ * @brief Free the memory used by a heatshrink stream
+ *
+ * @param stream The stream to deinitialize
+ */
+void heatshrinkStreamDeinit(heatshrinkStream_t* stream)
+{
+    if (NULL != stream->hsd)
+    {
+        heatshrink_decoder_free(stream->hsd);
+    }
+    memset(stream, 0, sizeof(heatshrinkStream_t));
 }
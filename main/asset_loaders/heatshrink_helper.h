@@ -7,6 +7,55 @@
 #include "heatshrink_decoder.h"
 #include "heatshrink_encoder.h"
 
+/// The size of the header at the start of all heatshrink data
+#define HS_HDR_SIZE 4
+
+/// The first header byte of data compressed with the default parameters, before they were part of the header
+#define HS_HDR_LEGACY 0x00
+
+/// The first header byte of data which is stored without compression
+#define HS_HDR_STORED 0xFF
+
+/// The default window size, as a power of two
+#define HS_DEFAULT_WINDOW 8
+
+/// The default lookahead size, as a power of two
+#define HS_DEFAULT_LOOKAHEAD 4
+
+/**
+ * @brief The parsed header of heatshrink data.
+ *
+ * The assets preprocessor picks the window and lookahead sizes per file, and may store a file without compression if
+ * compressing it doesn't pay off. The first byte of the header is (windowSz2 << 4) | lookaheadSz2, ::HS_HDR_STORED,
+ * or ::HS_HDR_LEGACY for the default parameters. The next three bytes are the decompressed size, big endian.
+ */
+typedef struct
+{
+    uint32_t size;        ///< The decompressed size
+    uint8_t windowSz2;    ///< The window size, as a power of two
+    uint8_t lookaheadSz2; ///< The lookahead size, as a power of two
+    bool stored;          ///< true if the data is stored without compression
+} heatshrinkHeader_t;
+
+/**
+ * @brief An incremental heatshrink decoder which pulls compressed bytes from a buffer as decompressed bytes are read
+ */
+typedef struct
+{
+    const uint8_t* source;   ///< The compressed data, not including the four byte header
+    uint32_t sourceSize;     ///< The number of compressed bytes
+    uint32_t sourceIdx;      ///< The next compressed byte to sink into the decoder
+    uint32_t remaining;      ///< The number of decompressed bytes which have not been read yet
+    heatshrink_decoder* hsd; ///< The decoder, which holds the sliding window, or NULL for stored data
+} heatshrinkStream_t;
+
+bool heatshrinkParseHeader(const uint8_t* buf, uint32_t bufSize, heatshrinkHeader_t* hdr);
+
+bool heatshrinkStreamInit(heatshrinkStream_t* stream, const uint8_t* source, uint32_t sourceSize);
+uint32_t heatshrinkStreamRead(heatshrinkStream_t* stream, uint8_t* dest, uint32_t size);
+bool heatshrinkStreamCopy(heatshrinkStream_t* dest, const heatshrinkStream_t* src, bool spiRam);
+void heatshrinkStreamDeinit(heatshrinkStream_t* stream);
+
 uint8_t* readHeatshrinkFileInplace(const char* fname, uint32_t* outsize, uint8_t* decompressedBuf,
                                    heatshrink_decoder* hsd);
 uint8_t* readHeatshrinkFile(const char* fname, uint32_t* outsize, bool readToSpiRam);
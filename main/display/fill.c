@@ -9,6 +9,7 @@
 #include "macros.h"
 #include "shapes.h"
 #include "trigonometry.h"
+#include "fp_math.h"
 #include "fill.h"
 
 //==============================================================================
@@ -19,6 +20,26 @@ static void _floodFill(uint16_t x, uint16_t y, paletteColor_t search, paletteCol
                        uint16_t xMax, uint16_t yMax);
 static void _floodFillInner(uint16_t x, uint16_t y, paletteColor_t search, paletteColor_t fill, uint16_t xMin,
                             uint16_t yMin, uint16_t xMax, uint16_t yMax);
+static void sectorHalfPlane(int16_t angle, int32_t py, bool ccwSide, int32_t* lo, int32_t* hi);
+static void fillAnnulusSpans(int16_t cx, int16_t y, int32_t xi, int32_t xo, int32_t lo, int32_t hi,
+                             paletteColor_t col);
+static int32_t floorDiv(int32_t n, int32_t d);
+
+//==============================================================================
+// Const data
+//==============================================================================
+
+/**
+ * Which of four consecutive pixels to draw for each shadeDisplayArea() level, for even and odd rows. Bit N is set if
+ * pixels where (x % 4 == N) are drawn
+ */
+static const uint8_t shadeMasks[5][2] = {
+    {0x5, 0x0}, // 25% faded
+    {0x5, 0x1}, // 37.5% faded
+    {0x5, 0xA}, // 50% faded
+    {0x7, 0x7}, // 62.5% faded
+    {0xF, 0x5}, // 75% faded
+};
 
 //==============================================================================
 // Functions
@@ -64,6 +85,129 @@ void fillDisplayArea(int16_t x1, int16_t y1, int16_t x2, int16_t y2, paletteColo
     }
 }
 
+/**
+ * @brief Fill a horizontal span of pixels on a single row with a single color. This is the common backend for filled
+ * shapes, which should break themselves into spans rather than setting individual pixels.
+ *
+ * The span is clipped to the display once, then filled with aligned 32 bit stores.
+ *
+ * @param x0 The first X coordinate to fill, inclusive
+ * @param x1 The last X coordinate to fill, exclusive
+ * @param y The row to fill
+ * @param c The color to fill
+ */
+void fillDisplaySpan(int16_t x0, int16_t x1, int16_t y, paletteColor_t c)
+{
+    if (y < 0 || y >= TFT_HEIGHT)
+    {
+        return;
+    }
+
+    x0 = MAX(x0, 0);
+    x1 = MIN(x1, TFT_WIDTH);
+    if (x0 >= x1)
+    {
+        return;
+    }
+
+    // Use bytes rather than paletteColor_t, which is packed and can't be cast to wider types
+    uint8_t* px = (uint8_t*)(getPxTftFramebuffer() + y * TFT_WIDTH + x0);
+    int len     = x1 - x0;
+
+    // Write single pixels until the pointer is word aligned
+    while (len && ((uintptr_t)px & 3))
+    {
+        *(px++) = c;
+        len--;
+    }
+
+    // Write four pixels at a time
+    uint32_t word = c * 0x01010101u;
+    uint32_t* pw  = (uint32_t*)px;
+    for (; len >= 4; len -= 4)
+    {
+        *(pw++) = word;
+    }
+
+    // Write whatever is left over
+    px = (uint8_t*)pw;
+    while (len--)
+    {
+        *(px++) = c;
+    }
+}
+
+/**
+ * @brief 'Shade' a horizontal span of pixels on a single row by drawing some of them in an ordered-dithering way. The
+ * pattern is anchored to the display, so adjacent spans line up. See shadeDisplayArea() for the levels.
+ *
+ * Whole words are written with a read-modify-write of the pattern mask rather than one pixel at a time.
+ *
+ * @param x0 The first X coordinate to shade, inclusive
+ * @param x1 The last X coordinate to shade, exclusive
+ * @param y The row to shade
+ * @param shadeLevel The level of shading, Higher means more shaded. Must be 0 to 4
+ * @param color the color to draw with
+ */
+void shadeDisplaySpan(int16_t x0, int16_t x1, int16_t y, uint8_t shadeLevel, paletteColor_t color)
+{
+    if (shadeLevel >= ARRAY_SIZE(shadeMasks) || y < 0 || y >= TFT_HEIGHT)
+    {
+        return;
+    }
+
+    x0 = MAX(x0, 0);
+    x1 = MIN(x1, TFT_WIDTH);
+    if (x0 >= x1)
+    {
+        return;
+    }
+
+    uint8_t mask = shadeMasks[shadeLevel][y % 2];
+    uint8_t* row = (uint8_t*)(getPxTftFramebuffer() + y * TFT_WIDTH);
+    int16_t x    = x0;
+
+    // Word stores only line up with the pattern if the row starts on a word boundary
+    if (0 == ((uintptr_t)row & 3))
+    {
+        // Single pixels until the X coordinate is word aligned
+        for (; x < x1 && (x & 3); x++)
+        {
+            if (mask & (1 << (x & 3)))
+            {
+                row[x] = color;
+            }
+        }
+
+        // Build a byte mask for each pixel in the word. This assumes a little endian CPU
+        uint32_t wordMask = 0;
+        for (int i = 0; i < 4; i++)
+        {
+            if (mask & (1 << i))
+            {
+                wordMask |= (0xFFu << (8 * i));
+            }
+        }
+        uint32_t colorWord = (color * 0x01010101u) & wordMask;
+
+        uint32_t* pw = (uint32_t*)&row[x];
+        for (; x + 4 <= x1; x += 4)
+        {
+            *pw = (*pw & ~wordMask) | colorWord;
+            pw++;
+        }
+    }
+
+    // Whatever is left over
+    for (; x < x1; x++)
+    {
+        if (mask & (1 << (x & 3)))
+        {
+            row[x] = color;
+        }
+    }
+}
+
 /**
  * 'Shade' an area by drawing pixels over it in a ordered-dithering way
  *
@@ -76,7 +220,6 @@ void fillDisplayArea(int16_t x1, int16_t y1, int16_t x2, int16_t y2, paletteColo
  */
 void shadeDisplayArea(int16_t x1, int16_t y1, int16_t x2, int16_t y2, uint8_t shadeLevel, paletteColor_t color)
 {
-    SETUP_FOR_TURBO();
     int16_t xMin, yMin, xMax, yMax;
     if (x1 < x2)
     {
@@ -134,69 +277,7 @@ void shadeDisplayArea(int16_t x1, int16_t y1, int16_t x2, int16_t y2, uint8_t sh
 
     for (int16_t dy = yMin; dy <= yMax; dy++)
     {
-        for (int16_t dx = xMin; dx < xMax; dx++)
-        {
-            switch (shadeLevel)
-            {
-                case 0:
-                {
-                    // 25% faded
-                    if (dy % 2 == 0 && dx % 2 == 0)
-                    {
-                        TURBO_SET_PIXEL_BOUNDS(dx, dy, color);
-                    }
-                    break;
-                }
-                case 1:
-                {
-                    // 37.5% faded
-                    if (dy % 2 == 0 && dx % 2 == 0)
-                    {
-                        TURBO_SET_PIXEL_BOUNDS(dx, dy, color);
-                    }
-                    else if (dx % 4 == 0)
-                    {
-                        TURBO_SET_PIXEL_BOUNDS(dx, dy, color);
-                    }
-                    break;
-                }
-                case 2:
-                {
-                    // 50% faded
-                    if ((dy % 2) == (dx % 2))
-                    {
-                        TURBO_SET_PIXEL_BOUNDS(dx, dy, color);
-                    }
-                    break;
-                }
-                case 3:
-                {
-                    // 62.5% faded
-                    if (dy % 2 == 0 && dx % 2 == 0)
-                    {
-                        TURBO_SET_PIXEL_BOUNDS(dx, dy, color);
-                    }
-                    else if (dx % 4 < 3)
-                    {
-                        TURBO_SET_PIXEL_BOUNDS(dx, dy, color);
-                    }
-                    break;
-                }
-                case 4:
-                {
-                    // 75% faded
-                    if (dy % 2 == 0 || dx % 2 == 0)
-                    {
-                        TURBO_SET_PIXEL_BOUNDS(dx, dy, color);
-                    }
-                    break;
-                }
-                default:
-                {
-                    return;
-                }
-            }
-        }
+        shadeDisplaySpan(xMin, xMax, dy, shadeLevel, color);
     }
 }
 
@@ -227,8 +308,6 @@ void shadeDisplayArea(int16_t x1, int16_t y1, int16_t x2, int16_t y2, uint8_t sh
  */
 void oddEvenFill(int x0, int y0, int x1, int y1, paletteColor_t boundaryColor, paletteColor_t fillColor)
 {
-    SETUP_FOR_TURBO();
-
     // Adjust the bounding box if it's out of bounds
     if (x0 < 0)
     {
@@ -248,20 +327,20 @@ void oddEvenFill(int x0, int y0, int x1, int y1, paletteColor_t boundaryColor, p
     }
     for (int y = y0; y < y1; y++)
     {
+        const paletteColor_t* row = getPxTftFramebuffer() + y * TFT_WIDTH;
+
         // Assume starting outside the shape or on border for each row
         // Count rising edges of row
-        bool isInside            = false;
         bool insideHysteresis    = false;
         uint16_t transitionCount = 0;
         // Pre-scan the row for even number of transitions. Algo only works for even number of transitions.
         for (int x = x0; x < x1; x++)
         {
-            if (boundaryColor == getPxTft(x, y))
+            if (boundaryColor == row[x])
             {
-                // Flip this boolean, don't color the boundary
+                // Count this transition, don't color the boundary
                 if (!insideHysteresis)
                 {
-                    isInside         = !isInside;
                     insideHysteresis = true;
                     transitionCount++;
                 }
@@ -273,29 +352,31 @@ void oddEvenFill(int x0, int y0, int x1, int y1, paletteColor_t boundaryColor, p
         }
         if (!(transitionCount % 2)) // Check for even number of transitions to prevent coloring to edge of bounding box.
         {
-            isInside         = false;
-            insideHysteresis = false;
-            for (int x = x0; x < x1; x++)
+            // Fill each run of non-boundary pixels between a rising edge and the next one
+            bool isInside = false;
+            int x         = x0;
+            while (x < x1)
             {
-                // If a boundary is hit
-                if (boundaryColor == getPxTft(x, y))
+                if (boundaryColor == row[x])
                 {
-                    // Flip this boolean, don't color the boundary
-                    if (!insideHysteresis)
+                    // Flip this boolean once per boundary, however thick it is
+                    isInside = !isInside;
+                    while (x < x1 && boundaryColor == row[x])
                     {
-                        isInside         = !isInside;
-                        insideHysteresis = true;
+                        x++;
                     }
                 }
-                else if (isInside)
-                {
-                    // If we're in-bounds, color the pixel
-                    TURBO_SET_PIXEL_BOUNDS(x, y, fillColor);
-                    insideHysteresis = false;
-                }
                 else
                 {
-                    insideHysteresis = false;
+                    int runStart = x;
+                    while (x < x1 && boundaryColor != row[x])
+                    {
+                        x++;
+                    }
+                    if (isInside)
+                    {
+                        fillDisplaySpan(runStart, x, y, fillColor);
+                    }
                 }
             }
         }
@@ -472,7 +553,10 @@ static void _floodFillInner(uint16_t x, uint16_t y, paletteColor_t search, palet
 }
 
 /**
- * @brief Helper function to draw a filled circle with translation and scaling
+ * @brief Fill a sector of a circle, or of a ring if innerR is nonzero.
+ *
+ * Each row of the circle is intersected with the half-planes on either side of the start and end angles, which gives
+ * at most a few spans per row to fill.
  *
  * @param x The X coordinate of the center of the circle
  * @param y The Y coordinate of the center of the circle
@@ -485,18 +569,135 @@ static void _floodFillInner(uint16_t x, uint16_t y, paletteColor_t search, palet
 void fillCircleSector(uint16_t x, uint16_t y, uint16_t innerR, uint16_t outerR, uint16_t startAngle, uint16_t endAngle,
                       paletteColor_t col)
 {
-    for (uint16_t deg = startAngle; deg != endAngle; deg = (deg + 1) % 360)
+    startAngle %= 360;
+    endAngle %= 360;
+    if (startAngle == endAngle)
+    {
+        return;
+    }
+
+    // A sector up to half a circle is the intersection of two half-planes, anything larger is the union
+    bool isUnion   = ((endAngle - startAngle + 360) % 360) > 180;
+    int32_t rOut2  = outerR * outerR;
+    int32_t rIn2   = innerR * innerR;
+    int32_t rowMin = MAX(-(int32_t)outerR, -y);
+    int32_t rowMax = MIN((int32_t)outerR, TFT_HEIGHT - 1 - y);
+
+    for (int32_t dy = rowMin; dy <= rowMax; dy++)
+    {
+        int32_t dy2 = dy * dy;
+
+        // Outermost drawn pixel on this row
+        int32_t xo = isqrt(rOut2 - dy2);
+
+        // Innermost pixel of the hole on this row, or -1 for no hole
+        int32_t xi = -1;
+        if (dy2 < rIn2)
+        {
+            xi = isqrt(rIn2 - dy2);
+            if (xi * xi == rIn2 - dy2)
+            {
+                xi--;
+            }
+        }
+
+        // Up is positive for angles
+        int32_t startLo, startHi, endLo, endHi;
+        sectorHalfPlane(startAngle, -dy, true, &startLo, &startHi);
+        sectorHalfPlane(endAngle, -dy, false, &endLo, &endHi);
+
+        if (isUnion)
+        {
+            fillAnnulusSpans(x, y + dy, xi, xo, startLo, startHi, col);
+            fillAnnulusSpans(x, y + dy, xi, xo, endLo, endHi, col);
+        }
+        else
+        {
+            fillAnnulusSpans(x, y + dy, xi, xo, MAX(startLo, endLo), MIN(startHi, endHi), col);
+        }
+    }
+}
+
+/**
+ * @brief Find which X offsets on a row are on one side of a ray from the center of a circle
+ *
+ * @param angle The angle of the ray, in degrees CCW
+ * @param py The row's Y offset from the center, where up is positive
+ * @param ccwSide true for the counter-clockwise side of the ray, false for the clockwise side
+ * @param lo [OUT] The smallest X offset on that side
+ * @param hi [OUT] The largest X offset on that side. If hi is less than lo, no part of the row is on that side
+ */
+static void sectorHalfPlane(int16_t angle, int32_t py, bool ccwSide, int32_t* lo, int32_t* hi)
+{
+    // A point is on the CCW side if cos * py - sin * px >= 0
+    int32_t s = getSin1024(angle);
+    int32_t c = getCos1024(angle);
+    if (!ccwSide)
+    {
+        s = -s;
+        c = -c;
+    }
+
+    *lo = INT16_MIN;
+    *hi = INT16_MAX;
+    if (s > 0)
+    {
+        // px <= c * py / s
+        *hi = floorDiv(c * py, s);
+    }
+    else if (s < 0)
+    {
+        // px >= c * py / s
+        *lo = -floorDiv(c * py, -s);
+    }
+    else if (c * py < 0)
+    {
+        // Horizontal ray, and this row is on the wrong side of it
+        *lo = INT16_MAX;
+        *hi = INT16_MIN;
+    }
+}
+
+/**
+ * @brief Fill the one or two spans of a ring's row, limited to a range of X offsets
+ *
+ * @param cx The X coordinate of the center of the ring
+ * @param y The row to fill
+ * @param xi The largest X offset of the hole in the ring on this row, or -1 if there is no hole
+ * @param xo The largest X offset of the outside of the ring on this row
+ * @param lo The smallest X offset to fill
+ * @param hi The largest X offset to fill
+ * @param col The color to fill
+ */
+static void fillAnnulusSpans(int16_t cx, int16_t y, int32_t xi, int32_t xo, int32_t lo, int32_t hi,
+                             paletteColor_t col)
+{
+    lo = MAX(lo, -xo);
+    hi = MIN(hi, xo);
+    if (lo > hi)
     {
-        uint16_t inStartX  = x + getCos1024(deg) * innerR / 1024;
-        uint16_t inStartY  = y - getSin1024(deg) * innerR / 1024;
-        uint16_t outStartX = x + getCos1024(deg) * outerR / 1024;
-        uint16_t outStartY = y - getSin1024(deg) * outerR / 1024;
-        uint16_t inEndX    = x + getCos1024((deg + 1) % 360) * innerR / 1024;
-        uint16_t inEndY    = y - getSin1024((deg + 1) % 360) * innerR / 1024;
-        uint16_t outEndX   = x + getCos1024((deg + 1) % 360) * outerR / 1024;
-        uint16_t outEndY   = y - getSin1024((deg + 1) % 360) * outerR / 1024;
+        return;
+    }
 
-        drawTriangleOutlined(inStartX, inStartY, outStartX, outStartY, outEndX, outEndY, col, col);
-        drawTriangleOutlined(inEndX, inEndY, outEndX, outEndY, inStartX, inStartY, col, col);
+    if (xi < 0)
+    {
+        fillDisplaySpan(cx + MAX(-xo, lo), cx + MIN(xo, hi) + 1, y, col);
     }
-}
\ No newline at end of file
+    else
+    {
+        fillDisplaySpan(cx + MAX(-xo, lo), cx + MIN(-xi - 1, hi) + 1, y, col);
+        fillDisplaySpan(cx + MAX(xi + 1, lo), cx + MIN(xo, hi) + 1, y, col);
+    }
+}
+
+/**
+ * @brief Integer division which rounds toward negative infinity rather than toward zero
+ *
+ * @param n The numerator
+ * @param d The denominator, must be positive
+ * @return n / d, rounded down
+ */
+static int32_t floorDiv(int32_t n, int32_t d)
+{
+    return (n >= 0) ? (n / d) : -((-n + d - 1) / d);
+}
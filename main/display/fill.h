@@ -11,6 +11,10 @@
  *
  * shadeDisplayArea() is used to shade a rectangular area using
  *
+ * fillDisplaySpan() and shadeDisplaySpan() fill or shade a single horizontal run of pixels. Filled shapes are built
+ * from these spans so that clipping happens once per row instead of once per pixel, and so that pixels can be written
+ * four at a time.
+ *
  * oddEvenFill() is an efficient way to fill areas using the <a
  * href="https://en.wikipedia.org/wiki/Even%E2%80%93odd_rule">Even–odd rule</a>. It may not work in all cases, but if it
  * does work, it is preferrable to use.
@@ -53,6 +57,8 @@
 
 void fillDisplayArea(int16_t x1, int16_t y1, int16_t x2, int16_t y2, paletteColor_t c);
 void shadeDisplayArea(int16_t x1, int16_t y1, int16_t x2, int16_t y2, uint8_t shadeLevel, paletteColor_t color);
+void fillDisplaySpan(int16_t x0, int16_t x1, int16_t y, paletteColor_t c);
+void shadeDisplaySpan(int16_t x0, int16_t x1, int16_t y, uint8_t shadeLevel, paletteColor_t color);
 void oddEvenFill(int x0, int y0, int x1, int y1, paletteColor_t boundaryColor, paletteColor_t fillColor);
 void floodFill(uint16_t x, uint16_t y, paletteColor_t col, uint16_t xMin, uint16_t yMin, uint16_t xMax, uint16_t yMax);
 void fillCircleSector(uint16_t x, uint16_t y, uint16_t innerR, uint16_t outerR, uint16_t startAngle, uint16_t endAngle,
@@ -21,13 +21,42 @@ typedef enum
     TEXT_CENTER  = 0x04, /// Flag for drawTextWordWrapFlags() to center text horizontally
 } wordWrapFlags_t;
 
+//==============================================================================
+// Defines
+//==============================================================================
+
+/// The number of entries in the measured string cache. Must be a power of two
+#define TEXT_WIDTH_CACHE_SIZE 32
+
+//==============================================================================
+// Structs
+//==============================================================================
+
+/// @brief An entry in the measured string cache
+typedef struct
+{
+    const font_t* font; ///< The font the text was measured in
+    const char* text;   ///< The text which was measured
+    uint32_t hash;      ///< A hash of the text's contents when it was measured
+    uint16_t width;     ///< The width of the text
+} textWidthCacheEntry_t;
+
+//==============================================================================
+// Variables
+//==============================================================================
+
+/// A direct-mapped cache of recently measured strings
+static textWidthCacheEntry_t textWidthCache[TEXT_WIDTH_CACHE_SIZE];
+
 //==============================================================================
 // Static Function Declarations
 //==============================================================================
 
 static const char* drawTextWordWrapFlags(const font_t* font, paletteColor_t color, const char* text, int16_t xStart,
                                          int16_t yStart, int16_t* xOff, int16_t* yOff, int16_t xMax, int16_t yMax,
-                                         uint16_t flags);
+                                         uint16_t flags, textLayer_t* layer);
+static bool getFontPx(const font_ch_t* ch, int16_t height, int16_t x, int16_t y);
+static int32_t countCharRuns(const font_ch_t* ch, int16_t height, font_run_t* runs, uint8_t* rowRuns);
 
 //==============================================================================
 // Functions
@@ -55,6 +84,33 @@ void drawCharBounds(paletteColor_t color, int h, const font_ch_t* ch, int16_t xO
         return;
     }
 
+    // If the character has been expanded into runs, fill each visible run
+    if (NULL != ch->runs)
+    {
+        xMin           = MAX(xMin, 0);
+        xMax           = MIN(xMax, TFT_WIDTH);
+        int16_t yStart = MAX(MAX(yOff, yMin), 0);
+        int16_t yEnd   = MIN(MIN(yOff + h, yMax), TFT_HEIGHT);
+
+        paletteColor_t* pxOutput = getPxTftFramebuffer() + (yStart * TFT_WIDTH);
+        for (int16_t y = yStart; y < yEnd; y++)
+        {
+            const font_run_t* run    = &ch->runs[ch->rowRuns[y - yOff]];
+            const font_run_t* runEnd = &ch->runs[ch->rowRuns[y - yOff + 1]];
+            for (; run < runEnd; run++)
+            {
+                int16_t x0 = MAX(xOff + run->x, xMin);
+                int16_t x1 = MIN(xOff + run->x + run->len, xMax);
+                if (x0 < x1)
+                {
+                    memset(&pxOutput[x0], color, x1 - x0);
+                }
+            }
+            pxOutput += TFT_WIDTH;
+        }
+        return;
+    }
+
     //  This function has been micro optimized by cnlohr on 2022-09-07, using gcc version 8.4.0 (crosstool-NG
     //  esp-2021r2-patch3)
     int bitIdx            = 0;
@@ -244,9 +300,75 @@ uint16_t textWidth(const font_t* font, const char* text)
     return width;
 }
 
+/**
+ * @brief Return the pixel width of some text in a given font, using a cache of recently measured strings.
+ *
+ * Entries are keyed by font and text pointer, and hold a hash of the text's contents, so text in a buffer which is
+ * rewritten in place is measured again. Hashing is cheaper than measuring, but text which changes every frame, like a
+ * score, should still be measured with textWidth() so it doesn't evict other entries.
+ *
+ * @param font The font to use
+ * @param text The text to measure
+ * @return The width of the text rendered in the font
+ */
+uint16_t textWidthCached(const font_t* font, const char* text)
+{
+    // FNV-1a
+    uint32_t hash = 2166136261u;
+    for (const char* c = text; *c; c++)
+    {
+        hash = (hash ^ (uint8_t)*c) * 16777619u;
+    }
+
+    uint32_t idx                 = (((uintptr_t)text) ^ (((uintptr_t)font) >> 4)) & (TEXT_WIDTH_CACHE_SIZE - 1);
+    textWidthCacheEntry_t* entry = &textWidthCache[idx];
+    if (entry->font != font || entry->text != text || entry->hash != hash)
+    {
+        entry->font  = font;
+        entry->text  = text;
+        entry->hash  = hash;
+        entry->width = textWidth(font, text);
+    }
+    return entry->width;
+}
+
+/**
+ * @brief Forget cached text widths. This must be called when a font is freed, which freeFont() does
+ *
+ * @param font The font to forget widths for, or NULL to forget all widths
+ */
+void clearTextWidthCache(const font_t* font)
+{
+    for (int32_t i = 0; i < TEXT_WIDTH_CACHE_SIZE; i++)
+    {
+        if (NULL == font || textWidthCache[i].font == font)
+        {
+            textWidthCache[i].font = NULL;
+            textWidthCache[i].text = NULL;
+        }
+    }
+}
+
+/**
+ * @brief Draw, measure, or lay out text, breaking on word boundaries, until the given bounds are filled or all text is
+ * drawn
+ *
+ * @param font The font to use when drawing the text
+ * @param color The color of the text to be drawn
+ * @param text The text to be pointed, as a null-terminated string
+ * @param xStart The X-coordinate lines start at
+ * @param yStart The Y-coordinate the first line starts at
+ * @param xOff The X-coordinate to begin drawing the text at, and is set to where the text ended
+ * @param yOff The Y-coordinate to begin drawing the text at, and is set to where the last line started
+ * @param xMax The maximum x-coordinate at which any text may be drawn
+ * @param yMax The maximum y-coordinate at which text may be drawn
+ * @param flags A bitmask of ::wordWrapFlags_t
+ * @param layer If not NULL, each line is counted in layer->numLines, and saved to layer->lines if it's not NULL
+ * @return A pointer to the first unprinted character within `text`, or NULL if all text has been written
+ */
 static const char* drawTextWordWrapFlags(const font_t* font, paletteColor_t color, const char* text, int16_t xStart,
                                          int16_t yStart, int16_t* xOff, int16_t* yOff, int16_t xMax, int16_t yMax,
-                                         uint16_t flags)
+                                         uint16_t flags, textLayer_t* layer)
 {
     const char* textPtr = text;
     int16_t textX = *xOff, textY = *yOff;
@@ -316,6 +438,21 @@ static const char* drawTextWordWrapFlags(const font_t* font, paletteColor_t colo
             }
         }
 
+        // Save the line to the layer, if there is one
+        if (NULL != layer)
+        {
+            if (NULL != layer->lines)
+            {
+                textLine_t* line = &layer->lines[layer->numLines];
+                line->text       = textPtr;
+                line->len        = strlen(buf);
+                line->x          = (flags & TEXT_CENTER) ? (xStart + (xMax - xStart - textWidth(font, buf)) / 2)
+                                                         : textX;
+                line->y          = textY;
+            }
+            layer->numLines++;
+        }
+
         // the line must have enough space for the rest of the buffer
         // print the line, and advance the text pointer and offset
         if (!(flags & TEXT_MEASURE) && textY + font->height >= 0 && textY <= TFT_HEIGHT)
@@ -377,7 +514,7 @@ static const char* drawTextWordWrapFlags(const font_t* font, paletteColor_t colo
 const char* drawTextWordWrap(const font_t* font, paletteColor_t color, const char* text, int16_t* xOff, int16_t* yOff,
                              int16_t xMax, int16_t yMax)
 {
-    return drawTextWordWrapFlags(font, color, text, *xOff, *yOff, xOff, yOff, xMax, yMax, TEXT_DRAW);
+    return drawTextWordWrapFlags(font, color, text, *xOff, *yOff, xOff, yOff, xMax, yMax, TEXT_DRAW, NULL);
 }
 
 /**
@@ -402,13 +539,14 @@ const char* drawTextWordWrap(const font_t* font, paletteColor_t color, const cha
 const char* drawTextWordWrapCentered(const font_t* font, paletteColor_t color, const char* text, int16_t* xOff,
                                      int16_t* yOff, int16_t xMax, int16_t yMax)
 {
-    return drawTextWordWrapFlags(font, color, text, *xOff, *yOff, xOff, yOff, xMax, yMax, TEXT_DRAW | TEXT_CENTER);
+    return drawTextWordWrapFlags(font, color, text, *xOff, *yOff, xOff, yOff, xMax, yMax, TEXT_DRAW | TEXT_CENTER,
+                                 NULL);
 }
 
 const char* drawTextWordWrapFixed(const font_t* font, paletteColor_t color, const char* text, int16_t xStart,
                                   int16_t yStart, int16_t* xOff, int16_t* yOff, int16_t xMax, int16_t yMax)
 {
-    return drawTextWordWrapFlags(font, color, text, xStart, yStart, xOff, yOff, xMax, yMax, TEXT_DRAW);
+    return drawTextWordWrapFlags(font, color, text, xStart, yStart, xOff, yOff, xMax, yMax, TEXT_DRAW, NULL);
 }
 
 /**
@@ -424,10 +562,104 @@ uint16_t textWordWrapHeight(const font_t* font, const char* text, int16_t width,
 {
     int16_t xEnd = 0;
     int16_t yEnd = 0;
-    drawTextWordWrapFlags(font, cTransparent, text, 0, 0, &xEnd, &yEnd, width, maxHeight, TEXT_MEASURE);
+    drawTextWordWrapFlags(font, cTransparent, text, 0, 0, &xEnd, &yEnd, width, maxHeight, TEXT_MEASURE, NULL);
     return yEnd + font->height + 1;
 }
 
+/**
+ * @brief Lay out a word-wrapped block of text once so that it can be drawn repeatedly with drawTextLayer(). Lines wrap
+ * the same way they do in drawTextWordWrap(). The layer points into the text, so the text must not be changed or freed
+ * while the layer is used.
+ *
+ * @param layer The layer to lay the text out in
+ * @param font The font to lay the text out in
+ * @param text The text to lay out, as a null-terminated string
+ * @param width The width of the text block
+ * @param height The maximum height of the text block. Text past this is not laid out, see ::textLayer_t.remaining
+ * @param center true to center each line horizontally, false to left align
+ * @return true if the text was laid out, false if memory couldn't be allocated
+ */
+bool textLayerInit(textLayer_t* layer, const font_t* font, const char* text, int16_t width, int16_t height,
+                   bool center)
+{
+    memset(layer, 0, sizeof(textLayer_t));
+    layer->font    = font;
+    uint16_t flags = TEXT_MEASURE | (center ? TEXT_CENTER : 0);
+
+    // First count the lines so they can be allocated
+    int16_t xEnd = 0;
+    int16_t yEnd = 0;
+    drawTextWordWrapFlags(font, cTransparent, text, 0, 0, &xEnd, &yEnd, width, height, flags, layer);
+    if (0 == layer->numLines)
+    {
+        return true;
+    }
+
+    layer->lines = heap_caps_calloc(layer->numLines, sizeof(textLine_t), MALLOC_CAP_8BIT);
+    if (NULL == layer->lines)
+    {
+        layer->numLines = 0;
+        return false;
+    }
+
+    // Then save them
+    layer->numLines  = 0;
+    xEnd             = 0;
+    yEnd             = 0;
+    layer->remaining = drawTextWordWrapFlags(font, cTransparent, text, 0, 0, &xEnd, &yEnd, width, height, flags, layer);
+    layer->height    = yEnd + font->height + 1;
+    return true;
+}
+
+/**
+ * @brief Free the memory for a text layer
+ *
+ * @param layer The layer to free
+ */
+void textLayerDeinit(textLayer_t* layer)
+{
+    if (NULL != layer->lines)
+    {
+        heap_caps_free(layer->lines);
+    }
+    memset(layer, 0, sizeof(textLayer_t));
+}
+
+/**
+ * @brief Draw a text layer to the display
+ *
+ * @param layer The layer to draw
+ * @param color The color of the text to draw
+ * @param xOff The x offset to draw the layer at
+ * @param yOff The y offset to draw the layer at
+ */
+void drawTextLayer(const textLayer_t* layer, paletteColor_t color, int16_t xOff, int16_t yOff)
+{
+    const font_t* font = layer->font;
+    for (uint16_t lIdx = 0; lIdx < layer->numLines; lIdx++)
+    {
+        const textLine_t* line = &layer->lines[lIdx];
+        int16_t y              = yOff + line->y;
+
+        // Skip lines which are entirely off the display
+        if (y + font->height <= 0 || y >= TFT_HEIGHT)
+        {
+            continue;
+        }
+
+        int16_t x = xOff + line->x;
+        for (uint16_t cIdx = 0; cIdx < line->len && x < TFT_WIDTH; cIdx++)
+        {
+            const font_ch_t* ch = &font->chars[line->text[cIdx] - ' '];
+            if (x + ch->width >= 0)
+            {
+                drawCharBounds(color, font->height, ch, x, y, 0, 0, TFT_WIDTH, TFT_HEIGHT);
+            }
+            x += ch->width + 1;
+        }
+    }
+}
+
 /**
  * @brief Get a single pixel from a font character
  *
@@ -437,7 +669,7 @@ uint16_t textWordWrapHeight(const font_t* font, const char* text, int16_t width,
  * @param y The Y coordinate of the pixel
  * @return true if the pixel is set, false if it is not
  */
-static bool getFontPx(font_ch_t* ch, int16_t height, int16_t x, int16_t y)
+static bool getFontPx(const font_ch_t* ch, int16_t height, int16_t x, int16_t y)
 {
     // Bounds checks
     if (x < 0 || x >= ch->width || y < 0 || y >= height)
@@ -492,6 +724,7 @@ void makeOutlineFont(font_t* srcFont, font_t* dstFont, bool spiRam)
 
     // Copy the height
     dstFont->height = srcFont->height;
+    dstFont->atlas  = NULL;
 
     // For each character
     for (int16_t cIdx = 0; cIdx < ARRAY_SIZE(dstFont->chars); cIdx++)
@@ -531,6 +764,143 @@ void makeOutlineFont(font_t* srcFont, font_t* dstFont, bool spiRam)
             }
         }
     }
+
+    // Expand the outlines into runs now, rather than decoding bits every time they're drawn
+    buildFontAtlas(dstFont, spiRam);
+}
+
+/**
+ * @brief Find the runs of set pixels in a character
+ *
+ * @param ch The character to find runs in
+ * @param height The height of the character
+ * @param runs Where to save the runs, or NULL to only count them
+ * @param rowRuns Where to save the index of each row's first run, or NULL to only count them
+ * @return The number of runs, or -1 if there are too many to index with a uint8_t
+ */
+static int32_t countCharRuns(const font_ch_t* ch, int16_t height, font_run_t* runs, uint8_t* rowRuns)
+{
+    int32_t numRuns = 0;
+    for (int16_t y = 0; y < height; y++)
+    {
+        if (NULL != rowRuns)
+        {
+            rowRuns[y] = numRuns;
+        }
+
+        int16_t x = 0;
+        while (x < ch->width)
+        {
+            // Skip clear pixels
+            while (x < ch->width && !getFontPx(ch, height, x, y))
+            {
+                x++;
+            }
+            if (x == ch->width)
+            {
+                break;
+            }
+
+            // Measure set pixels
+            int16_t start = x;
+            while (x < ch->width && getFontPx(ch, height, x, y))
+            {
+                x++;
+            }
+
+            if (NULL != runs)
+            {
+                runs[numRuns].x   = start;
+                runs[numRuns].len = x - start;
+            }
+            numRuns++;
+        }
+    }
+
+    if (numRuns > UINT8_MAX)
+    {
+        return -1;
+    }
+    else if (NULL != rowRuns)
+    {
+        rowRuns[height] = numRuns;
+    }
+    return numRuns;
+}
+
+/**
+ * @brief Expand every character of a font into runs of set pixels, stored together in one allocation. Characters with
+ * runs are drawn a run at a time rather than a bit at a time. This is called by loadFont() and makeOutlineFont(), and
+ * the atlas is freed by freeFont()
+ *
+ * @param font The font to build an atlas for
+ * @param spiRam true to allocate memory in SPI RAM, false to allocate memory in normal RAM
+ * @return true if the atlas was built, false if memory couldn't be allocated
+ */
+bool buildFontAtlas(font_t* font, bool spiRam)
+{
+    freeFontAtlas(font);
+
+    // Count the runs first so they can be allocated together. Characters with too many runs are drawn from the bitmap
+    uint32_t totalRuns = 0;
+    uint32_t totalRows = 0;
+    for (int16_t cIdx = 0; cIdx < ARRAY_SIZE(font->chars); cIdx++)
+    {
+        font_ch_t* ch = &font->chars[cIdx];
+        if (NULL != ch->bitmap)
+        {
+            int32_t numRuns = countCharRuns(ch, font->height, NULL, NULL);
+            if (0 <= numRuns)
+            {
+                totalRuns += numRuns;
+                totalRows += font->height + 1;
+            }
+        }
+    }
+
+    // Runs go first, then the row indices
+    font->atlas = heap_caps_malloc((sizeof(font_run_t) * totalRuns) + (sizeof(uint8_t) * totalRows),
+                                   spiRam ? MALLOC_CAP_SPIRAM : MALLOC_CAP_8BIT);
+    if (NULL == font->atlas)
+    {
+        return false;
+    }
+
+    font_run_t* runs = (font_run_t*)font->atlas;
+    uint8_t* rowRuns = (uint8_t*)&runs[totalRuns];
+    for (int16_t cIdx = 0; cIdx < ARRAY_SIZE(font->chars); cIdx++)
+    {
+        font_ch_t* ch = &font->chars[cIdx];
+        if (NULL != ch->bitmap && 0 <= countCharRuns(ch, font->height, NULL, NULL))
+        {
+            int32_t numRuns = countCharRuns(ch, font->height, runs, rowRuns);
+            ch->runs        = runs;
+            ch->rowRuns     = rowRuns;
+            runs += numRuns;
+            rowRuns += font->height + 1;
+        }
+    }
+    return true;
+}
+
+/**
+ * @brief Free a font's atlas, if it has one. Characters are then drawn from their bitmaps
+ *
+ * @param font The font to free the atlas of
+ */
+void freeFontAtlas(font_t* font)
+{
+    if (NULL != font->atlas)
+    {
+        heap_caps_free(font->atlas);
+        font->atlas = NULL;
+    }
+
+    for (int16_t cIdx = 0; cIdx < ARRAY_SIZE(font->chars); cIdx++)
+    {
+        font->chars[cIdx].runs    = NULL;
+        font->chars[cIdx].rowRuns = NULL;
+    }
 }
 
 /**
@@ -27,6 +27,20 @@
  * textWordWrapHeight() is used to measure the height of a word-wrapped text block.
  * There is no function to get the height of text because it is accessible in ::font_t.height.
  *
+ * \section font_cache Caching
+ *
+ * When a font is loaded, or an outline font is made with makeOutlineFont(), buildFontAtlas() expands every character's
+ * bitmap into horizontal runs of set pixels (::font_run_t), stored together in one allocation per font. Characters are
+ * then drawn a run at a time with memset() instead of one bit at a time.
+ *
+ * textWidthCached() remembers the widths of recently measured strings, keyed by font and text pointer, and measures the
+ * text again if its contents changed. It's meant for labels and titles which rarely change. Text which changes every
+ * frame, like a score, should be measured with textWidth() instead.
+ *
+ * Word-wrapped paragraphs which are drawn every frame can be laid out once with textLayerInit(), then drawn with
+ * drawTextLayer() without re-measuring or re-wrapping the text. The layer points into the original text, which must
+ * outlive it. Free the layer with textLayerDeinit().
+ *
  * \section font_example Example
  *
  * \code{.c}
@@ -48,14 +62,25 @@
 
 #include "palette.h"
 
+/**
+ * @brief A horizontal run of set pixels in one row of a character
+ */
+typedef struct
+{
+    uint8_t x;   ///< The first column of the run
+    uint8_t len; ///< The number of set pixels in the run
+} font_run_t;
+
 /**
  * @brief A character used in a font_t. Each character is a bitmap with the same height as the other characters in the
  * font.
  */
 typedef struct
 {
-    uint8_t width;   ///< The width of this character
-    uint8_t* bitmap; ///< This character's bitmap data
+    uint8_t width;           ///< The width of this character
+    uint8_t* bitmap;         ///< This character's bitmap data
+    const font_run_t* runs;  ///< This character's runs of set pixels in the font's atlas, or NULL to draw the bitmap
+    const uint8_t* rowRuns;  ///< height + 1 indices into runs. Row y is runs[rowRuns[y]] to runs[rowRuns[y + 1]]
 } font_ch_t;
 
 /**
@@ -66,8 +91,32 @@ typedef struct
 {
     uint8_t height;                 ///< The height of this font. All chars have the same height
     font_ch_t chars['~' - ' ' + 2]; ///< An array of characters, enough space for all printed ASCII chars, and pi
+    void* atlas;                    ///< The allocation holding every character's runs, or NULL if there are none
 } font_t;
 
+/**
+ * @brief One line of a laid out text block
+ */
+typedef struct
+{
+    const char* text; ///< The first character of the line, in the text the layer was laid out from
+    uint16_t len;     ///< The number of characters in the line
+    int16_t x;        ///< The X offset of the line, relative to the layer's position
+    int16_t y;        ///< The Y offset of the line, relative to the layer's position
+} textLine_t;
+
+/**
+ * @brief A word-wrapped text block which is laid out once and drawn many times
+ */
+typedef struct
+{
+    const font_t* font;    ///< The font the text was laid out in
+    textLine_t* lines;     ///< The lines of text
+    uint16_t numLines;     ///< The number of lines of text
+    uint16_t height;       ///< The height of the text block
+    const char* remaining; ///< The first character which didn't fit in the bounds, or NULL if all text fit
+} textLayer_t;
+
 void drawChar(paletteColor_t color, int h, const font_ch_t* ch, int16_t xOff, int16_t yOff);
 int16_t drawText(const font_t* font, paletteColor_t color, const char* text, int16_t xOff, int16_t yOff);
 void drawCharBounds(paletteColor_t color, int h, const font_ch_t* ch, int16_t xOff, int16_t yOff, int16_t xMin,
@@ -85,6 +134,17 @@ uint16_t textWidth(const font_t* font, const char* text);
 uint16_t textWordWrapHeight(const font_t* font, const char* text, int16_t width, int16_t maxHeight);
 
 void makeOutlineFont(font_t* srcFont, font_t* dstFont, bool spiRam);
+bool buildFontAtlas(font_t* font, bool spiRam);
+void freeFontAtlas(font_t* font);
+
+uint16_t textWidthCached(const font_t* font, const char* text);
+void clearTextWidthCache(const font_t* font);
+
+bool textLayerInit(textLayer_t* layer, const font_t* font, const char* text, int16_t width, int16_t height,
+                   bool center);
+void textLayerDeinit(textLayer_t* layer);
+void drawTextLayer(const textLayer_t* layer, paletteColor_t color, int16_t xOff, int16_t yOff);
+
 int16_t drawTextMarquee(const font_t* font, paletteColor_t color, const char* text, int16_t xOff, int16_t yOff,
                         int16_t xMax, int32_t* timer);
 bool drawTextEllipsize(const font_t* font, paletteColor_t color, const char* text, int16_t xOff, int16_t yOff,
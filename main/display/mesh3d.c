@@ -0,0 +1,586 @@
+//==============================================================================
+// Includes
+//==============================================================================
+
+#include <stdlib.h>
+#include <string.h>
+
+#include <esp_heap_caps.h>
+#include <esp_log.h>
+
+#include "hdw-tft.h"
+#include "macros.h"
+#include "trigonometry.h"
+#include "mesh3d.h"
+
+//==============================================================================
+// Defines
+//==============================================================================
+
+/// The number of fractional bits in the trigonometry tables
+#define TRIG_SHIFT 10
+
+/// Shift a q16_16 depth by this to get the 14.2 value stored in the depth buffer
+#define DEPTH_BUF_SHIFT 14
+
+//==============================================================================
+// Function Prototypes
+//==============================================================================
+
+static void buildMatrix(const mesh3dTransform_t* xf, int32_t m[3][3]);
+static void transformVerts(mesh3dRenderer_t* renderer, const mesh3d_t* mesh, const mesh3dTransform_t* xf);
+static bool setupTri(mesh3dRenderer_t* renderer, const mesh3dVert_t* v0, const mesh3dVert_t* v1,
+                     const mesh3dVert_t* v2, paletteColor_t color, mesh3dTri_t* tri);
+static paletteColor_t shadeColor(const mesh3dRenderer_t* renderer, const mesh3dVert_t* v0, const mesh3dVert_t* v1,
+                                 const mesh3dVert_t* v2, paletteColor_t color);
+static int cmpTriDepth(const void* a, const void* b);
+static void fillTriRows(const mesh3dRenderer_t* renderer, const mesh3dTri_t* tri, int16_t yStart, int16_t yEnd);
+
+//==============================================================================
+// Functions
+//==============================================================================
+
+/**
+ * @brief Allocate memory for a 3D renderer and initialize it
+ *
+ * @param renderer The renderer to initialize
+ * @param maxVerts The largest number of vertices any single mesh will have
+ * @param maxTris The largest number of triangles which may be queued per frame
+ * @param useDepthBuffer true to allocate a depth buffer in SPIRAM, false to sort triangles instead
+ * @return true if the renderer was initialized, false if memory couldn't be allocated. If this fails, nothing is left
+ * allocated and the renderer draws nothing.
+ */
+bool mesh3dInit(mesh3dRenderer_t* renderer, uint16_t maxVerts, uint16_t maxTris, bool useDepthBuffer)
+{
+    memset(renderer, 0, sizeof(mesh3dRenderer_t));
+
+    renderer->verts    = heap_caps_malloc(maxVerts * sizeof(mesh3dVert_t), MALLOC_CAP_SPIRAM);
+    renderer->maxVerts = maxVerts;
+    renderer->tris     = heap_caps_malloc(maxTris * sizeof(mesh3dTri_t), MALLOC_CAP_SPIRAM);
+    renderer->maxTris  = maxTris;
+
+    if (useDepthBuffer)
+    {
+        renderer->depthBuf = heap_caps_malloc(TFT_WIDTH * TFT_HEIGHT * sizeof(uint16_t), MALLOC_CAP_SPIRAM);
+    }
+
+    if (NULL == renderer->verts || NULL == renderer->tris || (useDepthBuffer && NULL == renderer->depthBuf))
+    {
+        ESP_LOGE("MESH3D", "Allocating renderer failed");
+        mesh3dDeinit(renderer);
+        return false;
+    }
+
+    // Default light is up, to the left, and toward the viewer
+    mesh3dSetLight(renderer, -443, 591, 591, 256);
+    return true;
+}
+
+/**
+ * @brief Free all memory associated with a 3D renderer
+ *
+ * @param renderer The renderer to deinitialize
+ */
+void mesh3dDeinit(mesh3dRenderer_t* renderer)
+{
+    heap_caps_free(renderer->verts);
+    heap_caps_free(renderer->tris);
+    if (renderer->depthBuf)
+    {
+        heap_caps_free(renderer->depthBuf);
+    }
+    memset(renderer, 0, sizeof(mesh3dRenderer_t));
+}
+
+/**
+ * @brief Set the directional light used to flat shade triangles
+ *
+ * The direction is in model space after rotation, i.e. +X is right, +Y is up, and +Z is toward the viewer, and points
+ * from the surface toward the light. It should have a length of 1024.
+ *
+ * @param renderer The renderer to set the light for
+ * @param x The X component of the light direction
+ * @param y The Y component of the light direction
+ * @param z The Z component of the light direction
+ * @param ambient The light level of faces pointing away from the light, from 0 to 1024. 1024 disables shading.
+ */
+void mesh3dSetLight(mesh3dRenderer_t* renderer, int16_t x, int16_t y, int16_t z, int16_t ambient)
+{
+    renderer->lightX  = x;
+    renderer->lightY  = y;
+    renderer->lightZ  = z;
+    renderer->ambient = CLAMP(ambient, 0, 1024);
+}
+
+/**
+ * @brief Discard all triangles queued for the prior frame. This should be called before adding meshes to a new frame.
+ *
+ * @param renderer The renderer to clear
+ */
+void mesh3dClear(mesh3dRenderer_t* renderer)
+{
+    renderer->numTris = 0;
+    renderer->sorted  = false;
+}
+
+/**
+ * @brief Transform a mesh, cull and shade its triangles, and queue the visible ones to be rasterized
+ *
+ * If the renderer runs out of space for triangles, the remaining triangles are not queued.
+ *
+ * @param renderer The renderer to queue triangles in
+ * @param mesh The mesh to add
+ * @param xf The position, rotation, scale, and projection of the mesh
+ * @return The number of triangles which were queued
+ */
+uint16_t mesh3dAdd(mesh3dRenderer_t* renderer, const mesh3d_t* mesh, const mesh3dTransform_t* xf)
+{
+    if (mesh->numVerts > renderer->maxVerts)
+    {
+        return 0;
+    }
+
+    transformVerts(renderer, mesh, xf);
+
+    uint16_t queued = 0;
+    for (uint16_t t = 0; t < mesh->numTris && renderer->numTris < renderer->maxTris; t++)
+    {
+        uint16_t i0, i1, i2;
+        paletteColor_t color;
+        if (MESH3D_8BIT == mesh->format)
+        {
+            const uint8_t* tri = &((const uint8_t*)mesh->tris)[t * 4];
+            i0                 = tri[0];
+            i1                 = tri[1];
+            i2                 = tri[2];
+            color              = tri[3];
+        }
+        else
+        {
+            const uint16_t* tri = &((const uint16_t*)mesh->tris)[t * 4];
+            i0                  = tri[0];
+            i1                  = tri[1];
+            i2                  = tri[2];
+            color               = tri[3];
+        }
+
+        if (i0 >= mesh->numVerts || i1 >= mesh->numVerts || i2 >= mesh->numVerts)
+        {
+            continue;
+        }
+
+        const mesh3dVert_t* v0 = &renderer->verts[i0];
+        const mesh3dVert_t* v1 = &renderer->verts[i1];
+        const mesh3dVert_t* v2 = &renderer->verts[i2];
+
+        // Skip triangles with any vertex that can't be drawn
+        if (v0->sz < 0 || v1->sz < 0 || v2->sz < 0)
+        {
+            continue;
+        }
+
+        // Twice the signed area in display space. Display Y points down, so counter-clockwise (front) faces are
+        // negative
+        int32_t area = (v1->sx - v0->sx) * (v2->sy - v0->sy) - (v2->sx - v0->sx) * (v1->sy - v0->sy);
+        if (0 == area || (MESH3D_CULL_BACK == xf->cull && area > 0) || (MESH3D_CULL_FRONT == xf->cull && area < 0))
+        {
+            continue;
+        }
+
+        if (xf->overrideColor)
+        {
+            color = xf->color;
+        }
+        color = shadeColor(renderer, v0, v1, v2, color);
+
+        if (setupTri(renderer, v0, v1, v2, color, &renderer->tris[renderer->numTris]))
+        {
+            renderer->numTris++;
+            queued++;
+        }
+    }
+
+    renderer->sorted = false;
+    return queued;
+}
+
+/**
+ * @brief Fill all queued triangles which cover a band of rows on the display
+ *
+ * This may be called from a ::fnBackgroundDrawCallback_t with the chunk being drawn. If the renderer has a depth
+ * buffer, the band's depth values are reset before drawing.
+ *
+ * @param renderer The renderer with queued triangles
+ * @param yStart The first row to draw, inclusive
+ * @param yEnd The last row to draw, exclusive
+ */
+void mesh3dRasterize(mesh3dRenderer_t* renderer, int16_t yStart, int16_t yEnd)
+{
+    yStart = CLAMP(yStart, 0, TFT_HEIGHT);
+    yEnd   = CLAMP(yEnd, 0, TFT_HEIGHT);
+    if (yStart >= yEnd)
+    {
+        return;
+    }
+
+    if (renderer->depthBuf)
+    {
+        // Reset the band to 0xFFFF, further than anything
+        memset(&renderer->depthBuf[yStart * TFT_WIDTH], 0xFF, (yEnd - yStart) * TFT_WIDTH * sizeof(uint16_t));
+    }
+    else if (!renderer->sorted)
+    {
+        // Without a depth buffer, draw back to front. Only sort once per frame, not once per band
+        qsort(renderer->tris, renderer->numTris, sizeof(mesh3dTri_t), cmpTriDepth);
+        renderer->sorted = true;
+    }
+
+    for (uint16_t t = 0; t < renderer->numTris; t++)
+    {
+        const mesh3dTri_t* tri = &renderer->tris[t];
+        if (tri->yBot > yStart && tri->yTop < yEnd)
+        {
+            fillTriRows(renderer, tri, MAX(tri->yTop, yStart), MIN(tri->yBot, yEnd));
+        }
+    }
+}
+
+/**
+ * @brief Fill all queued triangles on the whole display
+ *
+ * @param renderer The renderer with queued triangles
+ */
+void mesh3dDraw(mesh3dRenderer_t* renderer)
+{
+    mesh3dRasterize(renderer, 0, TFT_HEIGHT);
+}
+
+/**
+ * @brief Build a scaled rotation matrix, with TRIG_SHIFT fractional bits, from a transform
+ *
+ * @param xf The transform to build a matrix for
+ * @param m [OUT] The matrix, row major
+ */
+static void buildMatrix(const mesh3dTransform_t* xf, int32_t m[3][3])
+{
+    int16_t yaw   = POS_MODULO_ADD(xf->yaw, 0, 360);
+    int16_t pitch = POS_MODULO_ADD(xf->pitch, 0, 360);
+    int16_t roll  = POS_MODULO_ADD(xf->roll, 0, 360);
+
+    int32_t sy = getSin1024(yaw), cy = getCos1024(yaw);
+    int32_t sp = getSin1024(pitch), cp = getCos1024(pitch);
+    int32_t sr = getSin1024(roll), cr = getCos1024(roll);
+
+    // Rx(pitch) * Ry(yaw)
+    int32_t xy[3][3] = {
+        {cy, 0, sy},
+        {(sp * sy) >> TRIG_SHIFT, cp, -(sp * cy) >> TRIG_SHIFT},
+        {-(cp * sy) >> TRIG_SHIFT, sp, (cp * cy) >> TRIG_SHIFT},
+    };
+
+    // Rz(roll) * Rx(pitch) * Ry(yaw), then scale
+    for (int c = 0; c < 3; c++)
+    {
+        int32_t r0 = (cr * xy[0][c] - sr * xy[1][c]) >> TRIG_SHIFT;
+        int32_t r1 = (sr * xy[0][c] + cr * xy[1][c]) >> TRIG_SHIFT;
+        int32_t r2 = xy[2][c];
+
+        m[0][c] = (r0 * xf->scale) >> 8;
+        m[1][c] = (r1 * xf->scale) >> 8;
+        m[2][c] = (r2 * xf->scale) >> 8;
+    }
+}
+
+/**
+ * @brief Rotate, scale, and project all of a mesh's vertices into the renderer's vertex scratch space
+ *
+ * @param renderer The renderer to store vertices in
+ * @param mesh The mesh to transform
+ * @param xf The transform to apply
+ */
+static void transformVerts(mesh3dRenderer_t* renderer, const mesh3d_t* mesh, const mesh3dTransform_t* xf)
+{
+    int32_t m[3][3];
+    buildMatrix(xf, m);
+
+    for (uint16_t i = 0; i < mesh->numVerts; i++)
+    {
+        int32_t x, y, z;
+        if (MESH3D_8BIT == mesh->format)
+        {
+            const int8_t* v = &((const int8_t*)mesh->verts)[i * 3];
+            x               = v[0];
+            y               = v[1];
+            z               = v[2];
+        }
+        else
+        {
+            const int16_t* v = &((const int16_t*)mesh->verts)[i * 3];
+            x                = v[0];
+            y                = v[1];
+            z                = v[2];
+        }
+
+        mesh3dVert_t* out = &renderer->verts[i];
+        out->vx           = (m[0][0] * x + m[0][1] * y + m[0][2] * z) >> TRIG_SHIFT;
+        out->vy           = (m[1][0] * x + m[1][1] * y + m[1][2] * z) >> TRIG_SHIFT;
+        out->vz           = (m[2][0] * x + m[2][1] * y + m[2][2] * z) >> TRIG_SHIFT;
+
+        int32_t depth = xf->z - out->vz;
+        int32_t sx, sy;
+        if (MESH3D_ORTHOGRAPHIC == xf->focalLength)
+        {
+            sx = xf->x + out->vx;
+            sy = xf->y - out->vy;
+        }
+        else if (depth > 0)
+        {
+            sx = xf->x + (out->vx * xf->focalLength) / depth;
+            sy = xf->y - (out->vy * xf->focalLength) / depth;
+        }
+        else
+        {
+            // Behind the camera
+            out->sz = -1;
+            continue;
+        }
+
+        if (sx < -MESH3D_GUARD_BAND || sx >= TFT_WIDTH + MESH3D_GUARD_BAND || sy < -MESH3D_GUARD_BAND
+            || sy >= TFT_HEIGHT + MESH3D_GUARD_BAND)
+        {
+            out->sz = -1;
+            continue;
+        }
+
+        out->sx = sx;
+        out->sy = sy;
+        out->sz = CLAMP(depth, 0, MESH3D_MAX_DEPTH);
+    }
+}
+
+/**
+ * @brief Sort a triangle's vertices top to bottom and precompute its edge and depth slopes
+ *
+ * @param renderer The renderer the triangle is for
+ * @param v0 A vertex of the triangle
+ * @param v1 A vertex of the triangle
+ * @param v2 A vertex of the triangle
+ * @param color The color to fill the triangle with
+ * @param tri [OUT] The triangle to set up
+ * @return true if the triangle is on the display and should be queued, false if not
+ */
+static bool setupTri(mesh3dRenderer_t* renderer, const mesh3dVert_t* v0, const mesh3dVert_t* v1,
+                     const mesh3dVert_t* v2, paletteColor_t color, mesh3dTri_t* tri)
+{
+    const mesh3dVert_t* tmp;
+
+    // Sort so that v0 is the top and v2 is the bottom
+    if (v0->sy > v1->sy)
+    {
+        tmp = v0;
+        v0  = v1;
+        v1  = tmp;
+    }
+    if (v1->sy > v2->sy)
+    {
+        tmp = v1;
+        v1  = v2;
+        v2  = tmp;
+    }
+    if (v0->sy > v1->sy)
+    {
+        tmp = v0;
+        v0  = v1;
+        v1  = tmp;
+    }
+
+    // Reject triangles which don't cover any rows or are entirely off the display
+    if (v0->sy == v2->sy || v2->sy <= 0 || v0->sy >= TFT_HEIGHT)
+    {
+        return false;
+    }
+    int16_t xMin = MIN(v0->sx, MIN(v1->sx, v2->sx));
+    int16_t xMax = MAX(v0->sx, MAX(v1->sx, v2->sx));
+    if (xMax < 0 || xMin >= TFT_WIDTH)
+    {
+        return false;
+    }
+
+    int32_t dxLong = v2->sx - v0->sx;
+    int32_t dyLong = v2->sy - v0->sy;
+    int32_t dxTop  = v1->sx - v0->sx;
+    int32_t dyTop  = v1->sy - v0->sy;
+    int32_t dxBot  = v2->sx - v1->sx;
+    int32_t dyBot  = v2->sy - v1->sy;
+
+    // Positive when the middle vertex is to the right of the long edge
+    int32_t cross = dxTop * dyLong - dxLong * dyTop;
+    if (0 == cross)
+    {
+        return false;
+    }
+
+    tri->yTop     = v0->sy;
+    tri->yMid     = v1->sy;
+    tri->yBot     = v2->sy;
+    tri->xTop     = v0->sx;
+    tri->xMid     = v1->sx;
+    tri->longLeft = (cross > 0);
+    tri->color    = color;
+    tri->depth    = v0->sz + v1->sz + v2->sz;
+
+    tri->slopeLong = (dxLong << Q16_16_FRAC_BITS) / dyLong;
+    tri->slopeTop  = dyTop ? (dxTop << Q16_16_FRAC_BITS) / dyTop : 0;
+    tri->slopeBot  = dyBot ? (dxBot << Q16_16_FRAC_BITS) / dyBot : 0;
+
+    if (renderer->depthBuf)
+    {
+        int32_t dzLong = v2->sz - v0->sz;
+        int32_t dzTop  = v1->sz - v0->sz;
+
+        tri->zTop       = v0->sz << Q16_16_FRAC_BITS;
+        tri->zMid       = v1->sz << Q16_16_FRAC_BITS;
+        tri->zSlopeLong = (dzLong << Q16_16_FRAC_BITS) / dyLong;
+        tri->zSlopeTop  = dyTop ? (dzTop << Q16_16_FRAC_BITS) / dyTop : 0;
+        tri->zSlopeBot  = dyBot ? ((int32_t)(v2->sz - v1->sz) << Q16_16_FRAC_BITS) / dyBot : 0;
+
+        // Solve the plane equation for the depth change per column. Slivers can have huge gradients, so use 64 bits
+        // and clamp. Spans across slivers are tiny, so the clamping isn't visible
+        int64_t dzdx = (((int64_t)(dzTop * dyLong - dzLong * dyTop)) << Q16_16_FRAC_BITS) / cross;
+        tri->dzdx    = CLAMP(dzdx, -(1 << 30), (1 << 30));
+    }
+    return true;
+}
+
+/**
+ * @brief Shade a triangle's color with the renderer's directional and ambient light
+ *
+ * @param renderer The renderer with the light settings
+ * @param v0 A vertex of the triangle, counter-clockwise
+ * @param v1 A vertex of the triangle, counter-clockwise
+ * @param v2 A vertex of the triangle, counter-clockwise
+ * @param color The unshaded color
+ * @return The shaded color
+ */
+static paletteColor_t shadeColor(const mesh3dRenderer_t* renderer, const mesh3dVert_t* v0, const mesh3dVert_t* v1,
+                                 const mesh3dVert_t* v2, paletteColor_t color)
+{
+    if (renderer->ambient >= 1024 || color >= cTransparent)
+    {
+        return color;
+    }
+
+    // The face normal, from the cross product of two edges
+    int64_t ax = v1->vx - v0->vx, ay = v1->vy - v0->vy, az = v1->vz - v0->vz;
+    int64_t bx = v2->vx - v0->vx, by = v2->vy - v0->vy, bz = v2->vz - v0->vz;
+    int64_t nx = ay * bz - az * by;
+    int64_t ny = az * bx - ax * bz;
+    int64_t nz = ax * by - ay * bx;
+
+    // Shift the normal down so the squared length fits in 32 bits
+    while (ABS(nx) >= (1 << 14) || ABS(ny) >= (1 << 14) || ABS(nz) >= (1 << 14))
+    {
+        nx /= 2;
+        ny /= 2;
+        nz /= 2;
+    }
+
+    int32_t len = isqrt(nx * nx + ny * ny + nz * nz);
+    int32_t dot = nx * renderer->lightX + ny * renderer->lightY + nz * renderer->lightZ;
+    int32_t diffuse = (len && dot > 0) ? (dot / len) : 0;
+    int32_t level   = renderer->ambient + (((1024 - renderer->ambient) * MIN(diffuse, 1024)) >> TRIG_SHIFT);
+
+    int32_t r = color / 36;
+    int32_t g = (color / 6) % 6;
+    int32_t b = color % 6;
+    r         = (r * level + 512) >> TRIG_SHIFT;
+    g         = (g * level + 512) >> TRIG_SHIFT;
+    b         = (b * level + 512) >> TRIG_SHIFT;
+    return (paletteColor_t)(r * 36 + g * 6 + b);
+}
+
+/**
+ * @brief qsort() comparator to sort triangles furthest first
+ *
+ * @param a A mesh3dTri_t to compare
+ * @param b Another mesh3dTri_t to compare
+ * @return A negative number if a is further than b, positive if b is further than a, 0 if they are the same depth
+ */
+static int cmpTriDepth(const void* a, const void* b)
+{
+    return ((const mesh3dTri_t*)b)->depth - ((const mesh3dTri_t*)a)->depth;
+}
+
+/**
+ * @brief Fill a range of a triangle's rows, one span at a time
+ *
+ * Pixels are sampled at integer coordinates and a pixel is filled if it's at or to the right of the left edge, and
+ * left of the right edge. This way triangles which share an edge never draw the same pixel twice.
+ *
+ * @param renderer The renderer, for the depth buffer
+ * @param tri The triangle to fill
+ * @param yStart The first row to fill, inclusive. Must be within the triangle and the display
+ * @param yEnd The last row to fill, exclusive. Must be within the triangle and the display
+ */
+static void fillTriRows(const mesh3dRenderer_t* renderer, const mesh3dTri_t* tri, int16_t yStart, int16_t yEnd)
+{
+    paletteColor_t* fb = getPxTftFramebuffer();
+    q16_16 xTop        = tri->xTop << Q16_16_FRAC_BITS;
+    q16_16 xMid        = tri->xMid << Q16_16_FRAC_BITS;
+
+    for (int16_t y = yStart; y < yEnd; y++)
+    {
+        int32_t dyTop  = y - tri->yTop;
+        q16_16 xLong   = xTop + tri->slopeLong * dyTop;
+        q16_16 zLong   = tri->zTop + tri->zSlopeLong * dyTop;
+        q16_16 xShort, zShort;
+        if (y < tri->yMid)
+        {
+            xShort = xTop + tri->slopeTop * dyTop;
+            zShort = tri->zTop + tri->zSlopeTop * dyTop;
+        }
+        else
+        {
+            int32_t dyMid = y - tri->yMid;
+            xShort        = xMid + tri->slopeBot * dyMid;
+            zShort        = tri->zMid + tri->zSlopeBot * dyMid;
+        }
+
+        q16_16 xl = tri->longLeft ? xLong : xShort;
+        q16_16 xr = tri->longLeft ? xShort : xLong;
+
+        // Round both edges up to the next pixel center and clip
+        int32_t xs = (xl + 0xFFFF) >> Q16_16_FRAC_BITS;
+        int32_t xe = (xr + 0xFFFF) >> Q16_16_FRAC_BITS;
+        xs         = MAX(xs, 0);
+        xe         = MIN(xe, TFT_WIDTH);
+        if (xs >= xe)
+        {
+            continue;
+        }
+
+        paletteColor_t* row = &fb[y * TFT_WIDTH];
+        if (NULL == renderer->depthBuf)
+        {
+            memset(&row[xs], tri->color, xe - xs);
+        }
+        else
+        {
+            // Step depth from the left edge to the first pixel center, then across the span
+            q16_16 zl = tri->longLeft ? zLong : zShort;
+            q16_16 z  = zl + (q16_16)(((int64_t)tri->dzdx * ((xs << Q16_16_FRAC_BITS) - xl)) >> Q16_16_FRAC_BITS);
+
+            uint16_t* zRow = &renderer->depthBuf[y * TFT_WIDTH];
+            for (int32_t x = xs; x < xe; x++)
+            {
+                int32_t d = z >> DEPTH_BUF_SHIFT;
+                if (d < zRow[x])
+                {
+                    zRow[x] = d;
+                    row[x]  = tri->color;
+                }
+                z += tri->dzdx;
+            }
+        }
+    }
+}
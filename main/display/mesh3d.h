@@ -0,0 +1,228 @@
+/*! \file mesh3d.h
+ *
+ * \section mesh3d_design Design Philosophy
+ *
+ * This is a small fixed-point 3D pipeline for drawing solid triangle meshes. There is no FPU on the ESP32-S2, so
+ * everything is done with integer math. Vertices are rotated with a matrix built from getSin1024() and getCos1024(),
+ * projected either orthographically or with a simple perspective divide, back-face culled, flat shaded with a single
+ * directional light, and finally filled one scanline span at a time.
+ *
+ * Meshes use the same layout that \c tools/sandbox_test/test_donut/obj_to_array.c emits. Vertices are packed XYZ
+ * triplets and triangles are packed quadruplets of three vertex indices followed by a ::paletteColor_t. Both 8 bit
+ * (\c int8_t vertices, \c uint8_t triangles) and 16 bit (\c int16_t vertices, \c uint16_t triangles) variants are
+ * supported. Front faces are wound counter-clockwise, like in an OBJ file.
+ *
+ * Drawing happens in two steps. First all meshes for a frame are added with mesh3dAdd(), which transforms every vertex
+ * and sets up every visible triangle once. Then mesh3dRasterize() fills the triangles which cover a horizontal band of
+ * the display. The band can be the whole display, or it can be the chunk passed to a ::fnBackgroundDrawCallback_t so
+ * that rasterization is interleaved with the SPI transfer to the TFT.
+ *
+ * Hidden surfaces are removed one of two ways. Without a depth buffer, triangles are sorted back to front and drawn
+ * over each other (the painter's algorithm). This is fast and works well for convex-ish models like the donut. With a
+ * depth buffer, a 16 bit depth value is kept for every pixel in SPIRAM and each pixel is tested as it is filled. This
+ * handles intersecting and overlapping geometry correctly at the cost of a read and compare per pixel.
+ *
+ * Triangles with a vertex further than ::MESH3D_GUARD_BAND pixels off the display, or behind the camera when using a
+ * perspective projection, are skipped rather than clipped. Depth is clamped to ::MESH3D_MAX_DEPTH model units.
+ *
+ * \section mesh3d_usage Usage
+ *
+ * mesh3dInit() allocates a renderer with space for a given number of vertices and triangles per frame, and optionally a
+ * depth buffer. It returns false if there isn't enough memory. mesh3dDeinit() frees it.
+ *
+ * mesh3dSetLight() sets the light direction and ambient level used for flat shading.
+ *
+ * mesh3dClear() should be called at the start of each frame to discard the prior frame's triangles.
+ *
+ * mesh3dAdd() transforms a ::mesh3d_t with a ::mesh3dTransform_t and queues its visible triangles.
+ *
+ * mesh3dRasterize() draws queued triangles within a band of rows. mesh3dDraw() draws them to the whole display.
+ *
+ * \section mesh3d_example Example
+ *
+ * \code{.c}
+ * #include "donut.h"
+ *
+ * static const mesh3d_t donutMesh = {
+ *     .format   = MESH3D_8BIT,
+ *     .verts    = donut_verts,
+ *     .tris     = donut_tris,
+ *     .numVerts = sizeof(donut_verts) / 3,
+ *     .numTris  = sizeof(donut_tris) / 4,
+ * };
+ *
+ * static mesh3dRenderer_t renderer;
+ * static int16_t yaw = 0;
+ *
+ * static void enterMode(void)
+ * {
+ *     if (!mesh3dInit(&renderer, 512, 1024, false))
+ *     {
+ *         switchToSwadgeMode(&mainMenuMode);
+ *     }
+ * }
+ *
+ * static void mainLoop(int64_t elapsedUs)
+ * {
+ *     mesh3dTransform_t xf = {
+ *         .x     = TFT_WIDTH / 2,
+ *         .y     = TFT_HEIGHT / 2,
+ *         .z     = 256,
+ *         .scale = 256,
+ *         .yaw   = yaw,
+ *         .pitch = 30,
+ *     };
+ *     yaw = (yaw + 1) % 360;
+ *
+ *     mesh3dClear(&renderer);
+ *     mesh3dAdd(&renderer, &donutMesh, &xf);
+ * }
+ *
+ * // Triangles are filled band by band while the display is being sent
+ * static void backgroundDrawCallback(int16_t x, int16_t y, int16_t w, int16_t h, int16_t up, int16_t upNum)
+ * {
+ *     fillDisplayArea(x, y, x + w, y + h, c000);
+ *     mesh3dRasterize(&renderer, y, y + h);
+ * }
+ *
+ * static void exitMode(void)
+ * {
+ *     mesh3dDeinit(&renderer);
+ * }
+ * \endcode
+ */
+
+#ifndef _MESH3D_H_
+#define _MESH3D_H_
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#include "palette.h"
+#include "fp_math.h"
+
+/// Triangles with a vertex more than this many pixels outside the display are not drawn
+#define MESH3D_GUARD_BAND 1024
+
+/// The largest depth which can be represented. Anything further is drawn at this depth
+#define MESH3D_MAX_DEPTH 16383
+
+/// Pass as ::mesh3dTransform_t.focalLength for an orthographic projection
+#define MESH3D_ORTHOGRAPHIC 0
+
+/**
+ * @brief The in-memory layout of a mesh's vertex and triangle arrays
+ */
+typedef enum
+{
+    MESH3D_8BIT,  ///< \c int8_t XYZ vertices and \c uint8_t (v0, v1, v2, color) triangles
+    MESH3D_16BIT, ///< \c int16_t XYZ vertices and \c uint16_t (v0, v1, v2, color) triangles
+} mesh3dFormat_t;
+
+/**
+ * @brief Which triangles to discard based on their winding once projected
+ */
+typedef enum
+{
+    MESH3D_CULL_BACK,  ///< Discard triangles which face away from the camera. This is the default
+    MESH3D_CULL_NONE,  ///< Draw all triangles
+    MESH3D_CULL_FRONT, ///< Discard triangles which face toward the camera
+} mesh3dCull_t;
+
+/**
+ * @brief A constant triangle mesh, usually generated by a tool and stored in flash
+ */
+typedef struct
+{
+    mesh3dFormat_t format; ///< The layout of verts and tris
+    const void* verts;     ///< Packed XYZ vertex triplets
+    const void* tris;      ///< Packed triangles, three vertex indices and a ::paletteColor_t each
+    uint16_t numVerts;     ///< The number of vertices (not the number of array elements!)
+    uint16_t numTris;      ///< The number of triangles (not the number of array elements!)
+} mesh3d_t;
+
+/**
+ * @brief How to place a mesh in the scene
+ *
+ * Model space is right handed with +Y up and +Z toward the viewer. Rotations are applied yaw (about Y) first, then
+ * pitch (about X), then roll (about Z).
+ */
+typedef struct
+{
+    int16_t x;            ///< The display X coordinate of the model's origin
+    int16_t y;            ///< The display Y coordinate of the model's origin
+    int16_t z;            ///< The distance from the camera to the model's origin, in model units
+    uq8_8 scale;          ///< The model scale, where 256 is 1:1
+    int16_t yaw;          ///< Rotation about the Y axis, in degrees
+    int16_t pitch;        ///< Rotation about the X axis, in degrees
+    int16_t roll;         ///< Rotation about the Z axis, in degrees
+    int16_t focalLength;  ///< The perspective focal length in pixels, or ::MESH3D_ORTHOGRAPHIC
+    mesh3dCull_t cull;    ///< Which faces to cull
+    bool overrideColor;   ///< true to use color for every triangle instead of the mesh's colors
+    paletteColor_t color; ///< The color to use for every triangle if overrideColor is set
+} mesh3dTransform_t;
+
+/**
+ * @brief A triangle which has been transformed and set up for scanline filling
+ */
+typedef struct
+{
+    int16_t yTop;          ///< The first row covered by this triangle
+    int16_t yMid;          ///< The row where the short edges meet
+    int16_t yBot;          ///< The row after the last one covered by this triangle
+    int16_t xTop;          ///< The X coordinate of the top vertex
+    int16_t xMid;          ///< The X coordinate of the middle vertex
+    bool longLeft;         ///< true if the edge from top to bottom is on the left
+    paletteColor_t color;  ///< The shaded color to fill with
+    q16_16 slopeLong;      ///< X change per row along the top-bottom edge
+    q16_16 slopeTop;       ///< X change per row along the top-middle edge
+    q16_16 slopeBot;       ///< X change per row along the middle-bottom edge
+    q16_16 zTop;           ///< Depth at the top vertex
+    q16_16 zMid;           ///< Depth at the middle vertex
+    q16_16 zSlopeLong;     ///< Depth change per row along the top-bottom edge
+    q16_16 zSlopeTop;      ///< Depth change per row along the top-middle edge
+    q16_16 zSlopeBot;      ///< Depth change per row along the middle-bottom edge
+    q16_16 dzdx;           ///< Depth change per column across the triangle
+    int32_t depth;         ///< Sum of vertex depths, used to sort when there is no depth buffer
+} mesh3dTri_t;
+
+/**
+ * @brief A vertex after being transformed for the current frame
+ */
+typedef struct
+{
+    int32_t vx; ///< Rotated and scaled X, used for lighting
+    int32_t vy; ///< Rotated and scaled Y, used for lighting
+    int32_t vz; ///< Rotated and scaled Z, used for lighting
+    int16_t sx; ///< Projected display X
+    int16_t sy; ///< Projected display Y
+    int16_t sz; ///< Depth from the camera, or -1 if the vertex can't be drawn
+} mesh3dVert_t;
+
+/**
+ * @brief All the state needed to transform, set up, and rasterize triangles
+ */
+typedef struct
+{
+    mesh3dVert_t* verts; ///< Scratch space for one mesh's transformed vertices
+    uint16_t maxVerts;   ///< The largest number of vertices a single mesh may have
+    mesh3dTri_t* tris;   ///< The triangles queued for the current frame
+    uint16_t maxTris;    ///< The most triangles which can be queued per frame
+    uint16_t numTris;    ///< The number of triangles queued for the current frame
+    bool sorted;         ///< true if the queued triangles have been sorted back to front
+    uint16_t* depthBuf;  ///< A TFT_WIDTH * TFT_HEIGHT depth buffer, or NULL to use the painter's algorithm
+    int16_t lightX;      ///< Light direction X, pointing toward the light, length 1024
+    int16_t lightY;      ///< Light direction Y, pointing toward the light, length 1024
+    int16_t lightZ;      ///< Light direction Z, pointing toward the light, length 1024
+    int16_t ambient;     ///< Ambient light level, from 0 to 1024. At 1024, shading is disabled
+} mesh3dRenderer_t;
+
+bool mesh3dInit(mesh3dRenderer_t* renderer, uint16_t maxVerts, uint16_t maxTris, bool useDepthBuffer);
+void mesh3dDeinit(mesh3dRenderer_t* renderer);
+void mesh3dSetLight(mesh3dRenderer_t* renderer, int16_t x, int16_t y, int16_t z, int16_t ambient);
+void mesh3dClear(mesh3dRenderer_t* renderer);
+uint16_t mesh3dAdd(mesh3dRenderer_t* renderer, const mesh3d_t* mesh, const mesh3dTransform_t* xf);
+void mesh3dRasterize(mesh3dRenderer_t* renderer, int16_t yStart, int16_t yEnd);
+void mesh3dDraw(mesh3dRenderer_t* renderer);
+
+#endif
@@ -7,6 +7,7 @@
 #include <assert.h>
 
 #include "hdw-tft.h"
+#include "macros.h"
 #include "shapes.h"
 #include "fill.h"
 
@@ -811,10 +812,7 @@ void drawTriangleOutlined(int16_t v0x, int16_t v0y, int16_t v1x, int16_t v1y, in
                 // Draw body
                 if (cTransparent != fillColor)
                 {
-                    for (; x < endx; x++)
-                    {
-                        TURBO_SET_PIXEL(x, y, fillColor);
-                    }
+                    fillDisplaySpan(x, endx, y, fillColor);
                 }
 
                 // Draw right line
@@ -945,10 +943,7 @@ void drawTriangleOutlined(int16_t v0x, int16_t v0y, int16_t v1x, int16_t v1y, in
                 // Draw body
                 if (cTransparent != fillColor)
                 {
-                    for (; x < endx; x++)
-                    {
-                        TURBO_SET_PIXEL(x, y, fillColor);
-                    }
+                    fillDisplaySpan(x, endx, y, fillColor);
                 }
 
                 // Draw right line
@@ -1231,46 +1226,26 @@ void drawCircleQuadrants(int xm, int ym, int r, bool q1, bool q2, bool q3, bool
  */
 void drawCircleFilledQuadrants(int xm, int ym, int r, bool q1, bool q2, bool q3, bool q4, paletteColor_t col)
 {
-    SETUP_FOR_TURBO();
+    int lastY = -1;
 
     int x = -r, y = 0, err = 2 - 2 * r; /* bottom left to top right */
     do
     {
-        /// Left half
-        if (q2 || q3)
+        // The first step on each row is the widest, later steps on the same row are already covered
+        if (y != lastY)
         {
-            for (int lineX = xm + x; lineX <= xm; lineX++)
-            {
-                // Top
-                if (q2)
-                {
-                    TURBO_SET_PIXEL_BOUNDS(lineX, ym - y, col);
-                }
+            lastY = y;
 
-                // Bottom
-                if (q3)
-                {
-                    TURBO_SET_PIXEL_BOUNDS(lineX, ym + y, col);
-                }
+            // Top half, left and/or right
+            if (q1 || q2)
+            {
+                fillDisplaySpan(q2 ? xm + x : xm, (q1 ? xm - x : xm) + 1, ym - y, col);
             }
-        }
 
-        // Right half
-        if (q1 || q4)
-        {
-            for (int lineX = xm; lineX <= xm - x; lineX++)
+            // Bottom half, left and/or right
+            if (q3 || q4)
             {
-                // Top
-                if (q1)
-                {
-                    TURBO_SET_PIXEL_BOUNDS(lineX, ym - y, col);
-                }
-
-                // Bottom
-                if (q4)
-                {
-                    TURBO_SET_PIXEL_BOUNDS(lineX, ym + y, col);
-                }
+                fillDisplaySpan(q3 ? xm + x : xm, (q4 ? xm - x : xm) + 1, ym + y, col);
             }
         }
 
@@ -1287,7 +1262,7 @@ void drawCircleFilledQuadrants(int xm, int ym, int r, bool q1, bool q2, bool q3,
 }
 
 /**
- * @brief Helper function to draw a filled circle with translation and scaling
+ * @brief Helper function to draw a filled circle with translation and scaling. Each scaled pixel is filled completely.
  *
  * @param xm The X coordinate of the center of the circle
  * @param ym The Y coordinate of the center of the circle
@@ -1301,15 +1276,26 @@ void drawCircleFilledQuadrants(int xm, int ym, int r, bool q1, bool q2, bool q3,
 static void drawCircleFilledInner(int xm, int ym, int r, paletteColor_t col, int xOrigin, int yOrigin, int xScale,
                                   int yScale)
 {
-    SETUP_FOR_TURBO();
+    int lastY = -1;
 
     int x = -r, y = 0, err = 2 - 2 * r; /* bottom left to top right */
     do
     {
-        for (int lineX = xm + x; lineX <= xm - x; lineX++)
+        // The first step on each row is the widest, later steps on the same row are already covered
+        if (y != lastY)
         {
-            TURBO_SET_PIXEL_BOUNDS(xOrigin + lineX * xScale, yOrigin + (ym - y) * yScale, col);
-            TURBO_SET_PIXEL_BOUNDS(xOrigin + lineX * xScale, yOrigin + (ym + y) * yScale, col);
+            lastY = y;
+
+            int xStart = xOrigin + (xm + x) * xScale;
+            int xEnd   = xOrigin + (xm - x + 1) * xScale;
+            for (int subY = 0; subY < yScale; subY++)
+            {
+                fillDisplaySpan(xStart, xEnd, yOrigin + (ym - y) * yScale + subY, col);
+                if (y)
+                {
+                    fillDisplaySpan(xStart, xEnd, yOrigin + (ym + y) * yScale + subY, col);
+                }
+            }
         }
 
         r = err;
@@ -1335,7 +1321,7 @@ static void drawCircleFilledInner(int xm, int ym, int r, paletteColor_t col, int
  */
 void drawCircleOutline(int xm, int ym, int r, int stroke, paletteColor_t col)
 {
-    SETUP_FOR_TURBO();
+    int lastY = -1;
 
     // Outer circle
     int x = -r, y = 0, err = 2 - 2 * r; /* bottom left to top right */
@@ -1347,14 +1333,24 @@ void drawCircleOutline(int xm, int ym, int r, int stroke, paletteColor_t col)
     // Iterates over Y
     do
     {
-        // Iterates over X
-        for (int lineX = xm + x; lineX <= xm - x; lineX++)
+        // The first step on each row is the widest, later steps on the same row are already covered
+        if (y != lastY)
         {
-            // Only draw the outline
-            if (lineX < (xm + x_inner) || lineX > (xm - x_inner))
+            lastY = y;
+
+            // Rows past the inner circle are drawn all the way across
+            if (x_inner > 0)
+            {
+                fillDisplaySpan(xm + x, xm - x + 1, ym - y, col);
+                fillDisplaySpan(xm + x, xm - x + 1, ym + y, col);
+            }
+            else
             {
-                TURBO_SET_PIXEL_BOUNDS(lineX, (ym - y), col);
-                TURBO_SET_PIXEL_BOUNDS(lineX, (ym + y), col);
+                // Only draw the outline, left of the inner circle and right of it
+                fillDisplaySpan(xm + x, MIN(xm - x + 1, xm + x_inner), ym - y, col);
+                fillDisplaySpan(MAX(xm + x, xm - x_inner + 1), xm - x + 1, ym - y, col);
+                fillDisplaySpan(xm + x, MIN(xm - x + 1, xm + x_inner), ym + y, col);
+                fillDisplaySpan(MAX(xm + x, xm - x_inner + 1), xm - x + 1, ym + y, col);
             }
         }
 
@@ -1369,8 +1365,9 @@ void drawCircleOutline(int xm, int ym, int r, int stroke, paletteColor_t col)
             err += ++x * 2 + 1; /* -> x-step now */
         }
 
-        // Iterate the inner circle to match
-        while (y_inner != y)
+        // Iterate the inner circle to match. Once it's done, every row is drawn all the way across, so stop iterating
+        // it rather than running its error term off past the end
+        while (y_inner != y && x_inner <= 0)
         {
             r_inner = err_inner;
             if (r_inner <= y_inner)
@@ -1412,10 +1409,7 @@ void drawCircleFilled(int xm, int ym, int r, paletteColor_t col)
  */
 void drawCircleFilledScaled(int xm, int ym, int r, paletteColor_t col, int xOrigin, int yOrigin, int xScale, int yScale)
 {
-    for (uint8_t i = 0; i < xScale * yScale; i++)
-    {
-        drawCircleFilledInner(xm, ym, r, col, xOrigin + i % yScale, yOrigin + i / xScale, xScale, yScale);
-    }
+    drawCircleFilledInner(xm, ym, r, col, xOrigin, yOrigin, xScale, yScale);
 }
 
 /**
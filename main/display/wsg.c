@@ -4,16 +4,184 @@
 
 #include <string.h>
 
+#include <esp_heap_caps.h>
+
 #include "hdw-tft.h"
 #include "macros.h"
 #include "trigonometry.h"
+#include "fp_math.h"
 #include "fill.h"
 #include "wsg.h"
 
+//==============================================================================
+// Function Prototypes
+//==============================================================================
+
+static void drawWsgSpans(const wsg_t* wsg, int32_t xOff, int32_t yOff, bool flipLR, bool flipUD);
+static void drawWsgRotatedTo(const wsg_t* wsg, paletteColor_t* dst, int32_t dstW, int32_t dstH, int32_t xOff,
+                             int32_t yOff, bool flipLR, bool flipUD, int32_t rotateDeg);
+
 //==============================================================================
 // Functions
 //==============================================================================
 
+/**
+ * @brief Draw a WSG to the display using its span table, without rotation. Transparent runs are skipped entirely and
+ * opaque runs are copied
+ *
+ * @param wsg  The WSG to draw to the display. It must have a span table
+ * @param xOff The x offset to draw the WSG at
+ * @param yOff The y offset to draw the WSG at
+ * @param flipLR true to flip the image across the Y axis
+ * @param flipUD true to flip the image across the X axis
+ */
+static void drawWsgSpans(const wsg_t* wsg, int32_t xOff, int32_t yOff, bool flipLR, bool flipUD)
+{
+    int32_t wsgw = wsg->w;
+    int32_t wsgh = wsg->h;
+
+    // Only draw in bounds
+    if (xOff >= TFT_WIDTH || xOff + wsgw <= 0)
+    {
+        return;
+    }
+    int32_t yMin = CLAMP(yOff, 0, TFT_HEIGHT);
+    int32_t yMax = CLAMP(yOff + wsgh, 0, TFT_HEIGHT);
+
+    paletteColor_t* lineout = &getPxTftFramebuffer()[yMin * TFT_WIDTH];
+    for (int32_t y = yMin; y < yMax; y++)
+    {
+        // Reflect over X axis?
+        int32_t srcY                 = flipUD ? (yOff + wsgh - 1 - y) : (y - yOff);
+        const paletteColor_t* linein = &wsg->px[srcY * wsgw];
+        const wsgSpan_t* span        = &wsg->spans[wsg->rowSpans[srcY]];
+        const wsgSpan_t* spanEnd     = &wsg->spans[wsg->rowSpans[srcY + 1]];
+
+        for (; span < spanEnd; span++)
+        {
+            // Find where this span lands on the display, reflected over the Y axis if necessary
+            int32_t dstX0 = xOff + (flipLR ? (wsgw - span->x - span->len) : span->x);
+            int32_t dstX1 = dstX0 + span->len;
+            int32_t xMin  = MAX(dstX0, 0);
+            int32_t xMax  = MIN(dstX1, TFT_WIDTH);
+            if (xMin >= xMax)
+            {
+                continue;
+            }
+
+            if (flipLR)
+            {
+                const paletteColor_t* src = &linein[wsgw - 1 - (xMin - xOff)];
+                for (int32_t x = xMin; x < xMax; x++)
+                {
+                    lineout[x] = *src--;
+                }
+            }
+            else
+            {
+                memcpy(&lineout[xMin], &linein[xMin - xOff], xMax - xMin);
+            }
+        }
+        lineout += TFT_WIDTH;
+    }
+}
+
+/**
+ * @brief Draw a rotated WSG to a buffer by inverse mapping. Each destination pixel in the rotated bounding box is
+ * mapped back to the source pixel which covers it, so there are no holes. Source coordinates are stepped across each
+ * row and down each column in 16.16 fixed point, so there is no trigonometry or division per pixel.
+ *
+ * @param wsg  The WSG to draw
+ * @param dst The buffer to draw to, such as the display's framebuffer
+ * @param dstW The width of the buffer
+ * @param dstH The height of the buffer
+ * @param xOff The x offset to draw the WSG at, before rotation
+ * @param yOff The y offset to draw the WSG at, before rotation
+ * @param flipLR true to flip the image across the Y axis
+ * @param flipUD true to flip the image across the X axis
+ * @param rotateDeg The number of degrees to rotate clockwise
+ */
+static void drawWsgRotatedTo(const wsg_t* wsg, paletteColor_t* dst, int32_t dstW, int32_t dstH, int32_t xOff,
+                             int32_t yOff, bool flipLR, bool flipUD, int32_t rotateDeg)
+{
+    int32_t wsgw = wsg->w;
+    int32_t wsgh = wsg->h;
+
+    rotateDeg %= 360;
+    if (rotateDeg < 0)
+    {
+        rotateDeg += 360;
+    }
+    int32_t sinR = getSin1024(rotateDeg);
+    int32_t cosR = getCos1024(rotateDeg);
+
+    // Find the rotated bounding box around the sprite's center, with a pixel of slack for rounding
+    int32_t halfW = (ABS(wsgw * cosR) + ABS(wsgh * sinR) + 2047) / 2048;
+    int32_t halfH = (ABS(wsgw * sinR) + ABS(wsgh * cosR) + 2047) / 2048;
+    int32_t xMin  = MAX(xOff + (wsgw / 2) - halfW - 1, 0);
+    int32_t xMax  = MIN(xOff + ((wsgw + 1) / 2) + halfW + 1, dstW);
+    int32_t yMin  = MAX(yOff + (wsgh / 2) - halfH - 1, 0);
+    int32_t yMax  = MIN(yOff + ((wsgh + 1) / 2) + halfH + 1, dstH);
+    if (xMin >= xMax || yMin >= yMax)
+    {
+        return;
+    }
+
+    // Distance from the sprite's center to the first destination pixel's center, doubled to keep it an integer
+    int32_t dx2 = (2 * xMin) + 1 - (2 * xOff) - wsgw;
+    int32_t dy2 = (2 * yMin) + 1 - (2 * yOff) - wsgh;
+
+    // Rotate that counter-clockwise to find the source coordinate, in 16.16 fixed point. 1024 * 64 is 1 << 16
+    int32_t rowU = ((dx2 * cosR) + (dy2 * sinR)) * 32 + (wsgw << 15);
+    int32_t rowV = ((dy2 * cosR) - (dx2 * sinR)) * 32 + (wsgh << 15);
+    int32_t dUdX = cosR * 64;
+    int32_t dVdX = -sinR * 64;
+    int32_t dUdY = sinR * 64;
+    int32_t dVdY = cosR * 64;
+
+    // Flipping the source is the same as mirroring its coordinates
+    if (flipLR)
+    {
+        rowU = (wsgw << 16) - 1 - rowU;
+        dUdX = -dUdX;
+        dUdY = -dUdY;
+    }
+    if (flipUD)
+    {
+        rowV = (wsgh << 16) - 1 - rowV;
+        dVdX = -dVdX;
+        dVdY = -dVdY;
+    }
+
+    // Negative coordinates become large unsigned ones, so one compare per axis checks both bounds
+    uint32_t uLimit = (uint32_t)wsgw << 16;
+    uint32_t vLimit = (uint32_t)wsgh << 16;
+
+    paletteColor_t* lineout = &dst[yMin * dstW];
+    for (int32_t y = yMin; y < yMax; y++)
+    {
+        int32_t u = rowU;
+        int32_t v = rowV;
+        for (int32_t x = xMin; x < xMax; x++)
+        {
+            if ((uint32_t)u < uLimit && (uint32_t)v < vLimit)
+            {
+                // Draw if not transparent
+                paletteColor_t color = wsg->px[(v >> 16) * wsgw + (u >> 16)];
+                if (cTransparent != color)
+                {
+                    lineout[x] = color;
+                }
+            }
+            u += dUdX;
+            v += dVdX;
+        }
+        rowU += dUdY;
+        rowV += dVdY;
+        lineout += dstW;
+    }
+}
+
 /**
  * Transform a pixel's coordinates by rotation around the sprite's center point,
  * then reflection over Y axis, then reflection over X axis, then translation
@@ -124,48 +292,12 @@ void drawWsg(const wsg_t* wsg, int32_t xOff, int32_t yOff, bool flipLR, bool fli
 
     if (rotateDeg)
     {
-        SETUP_FOR_TURBO();
-        int32_t wsgw = wsg->w;
-        int32_t wsgh = wsg->h;
-        for (int32_t srcY = 0; srcY < wsgh; srcY++)
-        {
-            int32_t usey = srcY;
-
-            // Reflect over X axis?
-            if (flipUD)
-            {
-                usey = wsg->h - 1 - usey;
-            }
-
-            const paletteColor_t* linein = &wsg->px[usey * wsgw];
-
-            // Reflect over Y axis?
-            int32_t readX    = 0;
-            int32_t advanceX = 1;
-            if (flipLR)
-            {
-                readX    = wsgw - 1;
-                advanceX = -1;
-            }
-
-            for (int32_t srcX = 0; srcX != wsgw; srcX++)
-            {
-                // Draw if not transparent
-                paletteColor_t color = linein[readX];
-                if (cTransparent != color)
-                {
-                    int32_t tx = srcX;
-                    int32_t ty = srcY;
-
-                    rotatePixel(&tx, &ty, rotateDeg, wsgw, wsgh);
-
-                    tx += xOff;
-                    ty += yOff;
-                    TURBO_SET_PIXEL_BOUNDS(tx, ty, color);
-                }
-                readX += advanceX;
-            }
-        }
+        drawWsgRotatedTo(wsg, getPxTftFramebuffer(), TFT_WIDTH, TFT_HEIGHT, xOff, yOff, flipLR, flipUD, rotateDeg);
+    }
+    else if (NULL != wsg->spans)
+    {
+        // Draw the image's opaque spans (no rotation)
+        drawWsgSpans(wsg, xOff, yOff, flipLR, flipUD);
     }
     else
     {
@@ -285,6 +417,11 @@ void drawWsgSimple(const wsg_t* wsg, int16_t xOff, int16_t yOff)
     {
         return;
     }
+    else if (NULL != wsg->spans)
+    {
+        drawWsgSpans(wsg, xOff, yOff, false, false);
+        return;
+    }
 
     // Only draw in bounds
     int dWidth                   = TFT_WIDTH;
@@ -487,4 +624,217 @@ void drawWsgTile(const wsg_t* wsg, int32_t xOff, int32_t yOff)
         pxDisp += dWidth;
         pxWsg += wWidth;
     }
-}
\ No newline at end of file
+}
+
+/**
+ * @brief Build a WSG's span table by scanning its pixels for transparency
+ *
+ * @param wsg The WSG to build a span table for
+ * @param spiRam true to allocate the span table in SPI RAM, false to allocate it in normal RAM
+ * @param tag A name to tag allocations with
+ */
+void wsgFindSpans(wsg_t* wsg, bool spiRam, const char* tag)
+{
+    // Two passes. The first counts spans so the table can be allocated, the second fills it in
+    for (int pass = 0; pass < 2; pass++)
+    {
+        uint32_t numSpans            = 0;
+        const paletteColor_t* linein = wsg->px;
+        for (int32_t y = 0; y < wsg->h; y++)
+        {
+            if (pass)
+            {
+                wsg->rowSpans[y] = numSpans;
+            }
+
+            int32_t x = 0;
+            while (x < wsg->w)
+            {
+                // Skip transparent pixels
+                while (x < wsg->w && cTransparent == linein[x])
+                {
+                    x++;
+                }
+                if (x == wsg->w)
+                {
+                    break;
+                }
+
+                // Measure opaque pixels
+                int32_t start = x;
+                while (x < wsg->w && cTransparent != linein[x])
+                {
+                    x++;
+                }
+
+                if (pass)
+                {
+                    wsg->spans[numSpans].x   = start;
+                    wsg->spans[numSpans].len = x - start;
+                }
+                numSpans++;
+            }
+            linein += wsg->w;
+        }
+
+        if (pass)
+        {
+            wsg->rowSpans[wsg->h] = numSpans;
+        }
+        else if (!wsgAllocSpans(wsg, numSpans, spiRam, tag))
+        {
+            return;
+        }
+    }
+}
+
+/**
+ * @brief Allocate a span table for a WSG, if it's worth having
+ *
+ * The table isn't allocated if the spans are so fragmented that it would take more than half as much memory as the
+ * pixels do. Such images gain little from spans, and are drawn one pixel at a time instead.
+ *
+ * @param wsg The WSG to allocate a span table for
+ * @param numSpans The number of spans in the WSG
+ * @param spiRam true to allocate the span table in SPI RAM, false to allocate it in normal RAM
+ * @param tag A name to tag allocations with
+ * @return true if the table was allocated, false if it was not
+ */
+bool wsgAllocSpans(wsg_t* wsg, uint32_t numSpans, bool spiRam, const char* tag)
+{
+    uint32_t tableSize = (sizeof(wsgSpan_t) * numSpans) + (sizeof(uint16_t) * (wsg->h + 1));
+    if (numSpans > UINT16_MAX || tableSize > ((uint32_t)wsg->w * wsg->h) / 2)
+    {
+        return false;
+    }
+
+    // The spans and the row indices share one allocation, spans first to keep them aligned
+    wsg->spans = (wsgSpan_t*)heap_caps_malloc_tag(tableSize, spiRam ? MALLOC_CAP_SPIRAM : MALLOC_CAP_8BIT, tag);
+    if (NULL == wsg->spans)
+    {
+        return false;
+    }
+    wsg->rowSpans = (uint16_t*)&wsg->spans[numSpans];
+    return true;
+}
+
+/**
+ * @brief Pre-rotate a WSG at evenly spaced angles so that drawing it rotated is as fast as drawing it unrotated. This
+ * trades memory for speed, and is meant for sprites which rotate continuously. Each frame is big enough to hold the
+ * WSG at any angle, so the cache takes roughly (2 * numAngles) times as much memory as the WSG does.
+ *
+ * @param cache The cache to initialize
+ * @param wsg The WSG to rotate. It may be freed after the cache is initialized
+ * @param numAngles The number of angles to pre-rotate at, evenly spaced around the circle
+ * @param spiRam true to allocate frames in SPI RAM, false to allocate them in normal RAM
+ * @return true if the cache was initialized, false if memory couldn't be allocated
+ */
+bool wsgRotationCacheInit(wsgRotationCache_t* cache, const wsg_t* wsg, uint16_t numAngles, bool spiRam)
+{
+    memset(cache, 0, sizeof(wsgRotationCache_t));
+    if (NULL == wsg->px || 0 == numAngles)
+    {
+        return false;
+    }
+
+    cache->frames = (wsg_t*)heap_caps_calloc(numAngles, sizeof(wsg_t), spiRam ? MALLOC_CAP_SPIRAM : MALLOC_CAP_8BIT);
+    if (NULL == cache->frames)
+    {
+        return false;
+    }
+    cache->numAngles = numAngles;
+
+    // Every frame must fit the diagonal. Match the WSG's parity so the frame and WSG share a center
+    uint32_t diag = isqrt((uint32_t)(wsg->w * wsg->w) + (wsg->h * wsg->h)) + 2;
+    uint16_t frameW = diag + ((diag ^ wsg->w) & 1);
+    uint16_t frameH = diag + ((diag ^ wsg->h) & 1);
+    cache->xPad     = (frameW - wsg->w) / 2;
+    cache->yPad     = (frameH - wsg->h) / 2;
+
+    for (uint16_t i = 0; i < numAngles; i++)
+    {
+        wsg_t* frame = &cache->frames[i];
+        frame->px    = (paletteColor_t*)heap_caps_malloc(sizeof(paletteColor_t) * frameW * frameH,
+                                                         spiRam ? MALLOC_CAP_SPIRAM : MALLOC_CAP_8BIT);
+        if (NULL == frame->px)
+        {
+            wsgRotationCacheDeinit(cache);
+            return false;
+        }
+        frame->w = frameW;
+        frame->h = frameH;
+
+        // Rotate into the frame, then find its spans so that drawing it skips the transparent corners
+        memset(frame->px, cTransparent, sizeof(paletteColor_t) * frameW * frameH);
+        drawWsgRotatedTo(wsg, frame->px, frameW, frameH, cache->xPad, cache->yPad, false, false,
+                         (i * 360) / numAngles);
+        wsgFindSpans(frame, spiRam, "wsgRotationCache");
+    }
+    return true;
+}
+
+/**
+ * @brief Free the memory for a rotation cache
+ *
+ * @param cache The cache to free
+ */
+void wsgRotationCacheDeinit(wsgRotationCache_t* cache)
+{
+    if (NULL != cache->frames)
+    {
+        for (uint16_t i = 0; i < cache->numAngles; i++)
+        {
+            if (NULL != cache->frames[i].px)
+            {
+                heap_caps_free(cache->frames[i].px);
+            }
+            if (NULL != cache->frames[i].spans)
+            {
+                heap_caps_free(cache->frames[i].spans);
+            }
+        }
+        heap_caps_free(cache->frames);
+    }
+    memset(cache, 0, sizeof(wsgRotationCache_t));
+}
+
+/**
+ * @brief Draw a WSG from a rotation cache. The result is the same as drawWsg() with the source WSG, except that the
+ * angle is rounded to the nearest cached angle
+ *
+ * @param cache The rotation cache to draw from
+ * @param xOff The x offset to draw the WSG at
+ * @param yOff The y offset to draw the WSG at
+ * @param flipLR true to flip the image across the Y axis
+ * @param flipUD true to flip the image across the X axis
+ * @param rotateDeg The number of degrees to rotate clockwise
+ */
+void drawWsgRotationCache(const wsgRotationCache_t* cache, int32_t xOff, int32_t yOff, bool flipLR, bool flipUD,
+                          int32_t rotateDeg)
+{
+    if (NULL == cache->frames)
+    {
+        return;
+    }
+
+    // Flips can be traded for rotation. Flipping across the Y axis then rotating is the same as rotating the other
+    // way then flipping across the Y axis, and flipping across both axes is the same as rotating 180 degrees
+    if (flipUD)
+    {
+        rotateDeg += 180;
+        flipLR = !flipLR;
+    }
+    if (flipLR)
+    {
+        rotateDeg = -rotateDeg;
+    }
+    rotateDeg %= 360;
+    if (rotateDeg < 0)
+    {
+        rotateDeg += 360;
+    }
+
+    // Pick the nearest cached angle
+    uint16_t idx = ((rotateDeg * cache->numAngles + 180) / 360) % cache->numAngles;
+    drawWsg(&cache->frames[idx], xOff - cache->xPad, yOff - cache->yPad, flipLR, false, 0);
+}
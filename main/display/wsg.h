@@ -19,7 +19,8 @@
  *
  * There are five ways to draw a WSG to the display each with varying complexity and speed
  * - drawWsg(): Draw a WSG to the display with transparency, rotation, and flipping over horizontal or vertical axes.
- * This is the slowest option.
+ * This is the slowest option. Rotated WSGs are drawn by mapping each display pixel in the rotated bounding box back to
+ * the WSG pixel which covers it, stepping through the WSG in fixed point.
  * - drawWsgSimple(): Draw a WSG to the display with transparency. This is the medium speed option and should be used if
  * the WSG is not rotated or flipped.
  * - drawWsgTile(): Draw a WSG to the display without transparency. Any transparent pixels will be an indeterminate
@@ -28,6 +29,13 @@
  * values, so 2x, 3x, 4x... are the valid options.
  * - drawWsgSimpleHalf(): Draw a WSG to the display with transparency at half the original resolution.
  *
+ * Most sprites are solid shapes surrounded by transparent margins. When a WSG is loaded, a table of opaque spans is
+ * built for each row (see ::wsgSpan_t). drawWsg(), drawWsgSimple(), drawWsgPalette(), and drawWsgPaletteSimple() use
+ * this table to skip transparent runs in one step and copy opaque runs with memcpy() rather than testing every pixel.
+ * WSG files which contain transparency are stored run-length encoded by the \c assets_preprocessor, so the span table
+ * is read directly from the file rather than found by scanning the pixels. WSGs without a span table, or whose spans
+ * would take more memory than they are worth, are drawn one pixel at a time as before.
+ *
  * \section wsg_example Example
  *
  * \code{.c}
@@ -50,6 +58,18 @@
 #include <palette.h>
 #include <stdbool.h>
 
+/// Set in the width field of a WSG file's header if the pixels are run-length encoded
+#define WSG_RLE_FLAG 0x8000
+
+/**
+ * @brief A horizontal run of opaque pixels in one row of a WSG
+ */
+typedef struct
+{
+    uint16_t x;   ///< The first column of the run
+    uint16_t len; ///< The number of opaque pixels in the run
+} wsgSpan_t;
+
 /**
  * @brief A sprite using paletteColor_t colors that can be drawn to the display
  */
@@ -58,8 +78,21 @@ typedef struct
     paletteColor_t* px; ///< The row-order array of pixels in the image
     uint16_t w;         ///< The width of the image
     uint16_t h;         ///< The height of the image
+    wsgSpan_t* spans;   ///< Every row's opaque spans, in order, or NULL to test each pixel for transparency
+    uint16_t* rowSpans; ///< h + 1 indices into spans. Row y's spans are spans[rowSpans[y]] to spans[rowSpans[y + 1]]
 } wsg_t;
 
+/**
+ * @brief A WSG pre-rotated at evenly spaced angles
+ */
+typedef struct
+{
+    wsg_t* frames;      ///< numAngles rotated frames. Frame i is rotated (i * 360 / numAngles) degrees clockwise
+    uint16_t numAngles; ///< The number of frames
+    int16_t xPad;       ///< How many pixels of padding are left and right of the original WSG in each frame
+    int16_t yPad;       ///< How many pixels of padding are above and below the original WSG in each frame
+} wsgRotationCache_t;
+
 void rotatePixel(int32_t* x, int32_t* y, int32_t rotateDeg, int32_t width, int32_t height);
 void drawWsg(const wsg_t* wsg, int32_t xOff, int32_t yOff, bool flipLR, bool flipUD, int32_t rotateDeg);
 void drawWsgSimple(const wsg_t* wsg, int16_t xOff, int16_t yOff);
@@ -67,4 +100,12 @@ void drawWsgSimpleScaled(const wsg_t* wsg, int16_t xOff, int16_t yOff, int16_t x
 void drawWsgTile(const wsg_t* wsg, int32_t xOff, int32_t yOff);
 void drawWsgSimpleHalf(const wsg_t* wsg, int16_t xOff, int16_t yOff);
 
+bool wsgAllocSpans(wsg_t* wsg, uint32_t numSpans, bool spiRam, const char* tag);
+void wsgFindSpans(wsg_t* wsg, bool spiRam, const char* tag);
+
+bool wsgRotationCacheInit(wsgRotationCache_t* cache, const wsg_t* wsg, uint16_t numAngles, bool spiRam);
+void wsgRotationCacheDeinit(wsgRotationCache_t* cache);
+void drawWsgRotationCache(const wsgRotationCache_t* cache, int32_t xOff, int32_t yOff, bool flipLR, bool flipUD,
+                          int32_t rotateDeg);
+
 #endif
\ No newline at end of file
@@ -19,76 +19,210 @@
 #include "macros.h"
 #include "fill.h"
 
+//==============================================================================
+// Function Prototypes
+//==============================================================================
+
+static void drawWsgPaletteSpans(const wsg_t* wsg, int32_t xOff, int32_t yOff, const wsgPalette_t* palette,
+                                bool flipLR, bool flipUD);
+static void drawWsgPaletteRotated(const wsg_t* wsg, int32_t xOff, int32_t yOff, const wsgPalette_t* palette,
+                                  bool flipLR, bool flipUD, int32_t rotateDeg);
+
 //==============================================================================
 // Functions
 //==============================================================================
 
 /**
- * @brief Draw a WSG to the display utilizing a palette
+ * @brief Draw a WSG to the display utilizing a palette and the WSG's span table, without rotation. Transparent runs
+ * are skipped entirely. Pixels in opaque runs are still checked because the palette may map them to transparent
  *
- * @param wsg  The WSG to draw to the display
+ * @param wsg  The WSG to draw to the display. It must have a span table
  * @param xOff The x offset to draw the WSG at
  * @param yOff The y offset to draw the WSG at
  * @param palette The new palette used to translate the colors
  * @param flipLR true to flip the image across the Y axis
  * @param flipUD true to flip the image across the X axis
- * @param rotateDeg The number of degrees to rotate clockwise, must be 0-359
  */
-void drawWsgPalette(const wsg_t* wsg, int32_t xOff, int32_t yOff, wsgPalette_t* palette, bool flipLR, bool flipUD,
-                    int32_t rotateDeg)
+static void drawWsgPaletteSpans(const wsg_t* wsg, int32_t xOff, int32_t yOff, const wsgPalette_t* palette,
+                                bool flipLR, bool flipUD)
 {
-    //  This function has been micro optimized by cnlohr on 2022-09-08, using gcc version 8.4.0 (crosstool-NG
-    //  esp-2021r2-patch3)
+    int32_t wsgw = wsg->w;
+    int32_t wsgh = wsg->h;
 
-    if (NULL == wsg->px)
+    // Only draw in bounds
+    if (xOff >= TFT_WIDTH || xOff + wsgw <= 0)
     {
         return;
     }
+    int32_t yMin = CLAMP(yOff, 0, TFT_HEIGHT);
+    int32_t yMax = CLAMP(yOff + wsgh, 0, TFT_HEIGHT);
 
-    if (rotateDeg)
+    // Step backwards through the source when reflecting over the Y axis
+    int32_t srcInc = flipLR ? -1 : 1;
+
+    paletteColor_t* lineout = &getPxTftFramebuffer()[yMin * TFT_WIDTH];
+    for (int32_t y = yMin; y < yMax; y++)
     {
-        SETUP_FOR_TURBO();
-        int32_t wsgw = wsg->w;
-        int32_t wsgh = wsg->h;
-        for (int32_t srcY = 0; srcY < wsgh; srcY++)
-        {
-            int32_t usey = srcY;
+        // Reflect over X axis?
+        int32_t srcY                 = flipUD ? (yOff + wsgh - 1 - y) : (y - yOff);
+        const paletteColor_t* linein = &wsg->px[srcY * wsgw];
+        const wsgSpan_t* span        = &wsg->spans[wsg->rowSpans[srcY]];
+        const wsgSpan_t* spanEnd     = &wsg->spans[wsg->rowSpans[srcY + 1]];
 
-            // Reflect over X axis?
-            if (flipUD)
+        for (; span < spanEnd; span++)
+        {
+            // Find where this span lands on the display, reflected over the Y axis if necessary
+            int32_t dstX0 = xOff + (flipLR ? (wsgw - span->x - span->len) : span->x);
+            int32_t dstX1 = dstX0 + span->len;
+            int32_t xMin  = MAX(dstX0, 0);
+            int32_t xMax  = MIN(dstX1, TFT_WIDTH);
+            if (xMin >= xMax)
             {
-                usey = wsg->h - 1 - usey;
+                continue;
             }
 
-            const paletteColor_t* linein = &wsg->px[usey * wsgw];
-
-            // Reflect over Y axis?
-            int32_t readX    = 0;
-            int32_t advanceX = 1;
-            if (flipLR)
+            const paletteColor_t* src = &linein[flipLR ? (wsgw - 1 - (xMin - xOff)) : (xMin - xOff)];
+            for (int32_t x = xMin; x < xMax; x++)
             {
-                readX    = wsgw - 1;
-                advanceX = -1;
+                uint8_t color = palette->newColors[*src];
+                if (cTransparent != color)
+                {
+                    lineout[x] = color;
+                }
+                src += srcInc;
             }
+        }
+        lineout += TFT_WIDTH;
+    }
+}
+
+/**
+ * @brief Draw a rotated WSG to the display utilizing a palette, by inverse mapping. Each destination pixel in the
+ * rotated bounding box is mapped back to the source pixel which covers it, so there are no holes. Source coordinates
+ * are stepped across each row and down each column in 16.16 fixed point, so there is no trigonometry or division per
+ * pixel.
+ *
+ * @param wsg  The WSG to draw to the display
+ * @param xOff The x offset to draw the WSG at, before rotation
+ * @param yOff The y offset to draw the WSG at, before rotation
+ * @param palette The new palette used to translate the colors
+ * @param flipLR true to flip the image across the Y axis
+ * @param flipUD true to flip the image across the X axis
+ * @param rotateDeg The number of degrees to rotate clockwise
+ */
+static void drawWsgPaletteRotated(const wsg_t* wsg, int32_t xOff, int32_t yOff, const wsgPalette_t* palette,
+                                  bool flipLR, bool flipUD, int32_t rotateDeg)
+{
+    int32_t dstW = TFT_WIDTH;
+    int32_t dstH = TFT_HEIGHT;
+    int32_t wsgw = wsg->w;
+    int32_t wsgh = wsg->h;
+
+    rotateDeg %= 360;
+    if (rotateDeg < 0)
+    {
+        rotateDeg += 360;
+    }
+    int32_t sinR = getSin1024(rotateDeg);
+    int32_t cosR = getCos1024(rotateDeg);
+
+    // Find the rotated bounding box around the sprite's center, with a pixel of slack for rounding
+    int32_t halfW = (ABS(wsgw * cosR) + ABS(wsgh * sinR) + 2047) / 2048;
+    int32_t halfH = (ABS(wsgw * sinR) + ABS(wsgh * cosR) + 2047) / 2048;
+    int32_t xMin  = MAX(xOff + (wsgw / 2) - halfW - 1, 0);
+    int32_t xMax  = MIN(xOff + ((wsgw + 1) / 2) + halfW + 1, dstW);
+    int32_t yMin  = MAX(yOff + (wsgh / 2) - halfH - 1, 0);
+    int32_t yMax  = MIN(yOff + ((wsgh + 1) / 2) + halfH + 1, dstH);
+    if (xMin >= xMax || yMin >= yMax)
+    {
+        return;
+    }
+
+    // Distance from the sprite's center to the first destination pixel's center, doubled to keep it an integer
+    int32_t dx2 = (2 * xMin) + 1 - (2 * xOff) - wsgw;
+    int32_t dy2 = (2 * yMin) + 1 - (2 * yOff) - wsgh;
 
-            for (int32_t srcX = 0; srcX != wsgw; srcX++)
+    // Rotate that counter-clockwise to find the source coordinate, in 16.16 fixed point. 1024 * 64 is 1 << 16
+    int32_t rowU = ((dx2 * cosR) + (dy2 * sinR)) * 32 + (wsgw << 15);
+    int32_t rowV = ((dy2 * cosR) - (dx2 * sinR)) * 32 + (wsgh << 15);
+    int32_t dUdX = cosR * 64;
+    int32_t dVdX = -sinR * 64;
+    int32_t dUdY = sinR * 64;
+    int32_t dVdY = cosR * 64;
+
+    // Flipping the source is the same as mirroring its coordinates
+    if (flipLR)
+    {
+        rowU = (wsgw << 16) - 1 - rowU;
+        dUdX = -dUdX;
+        dUdY = -dUdY;
+    }
+    if (flipUD)
+    {
+        rowV = (wsgh << 16) - 1 - rowV;
+        dVdX = -dVdX;
+        dVdY = -dVdY;
+    }
+
+    // Negative coordinates become large unsigned ones, so one compare per axis checks both bounds
+    uint32_t uLimit = (uint32_t)wsgw << 16;
+    uint32_t vLimit = (uint32_t)wsgh << 16;
+
+    paletteColor_t* lineout = &getPxTftFramebuffer()[yMin * dstW];
+    for (int32_t y = yMin; y < yMax; y++)
+    {
+        int32_t u = rowU;
+        int32_t v = rowV;
+        for (int32_t x = xMin; x < xMax; x++)
+        {
+            if ((uint32_t)u < uLimit && (uint32_t)v < vLimit)
             {
-                // Draw if not transparent
-                paletteColor_t color = palette->newColors[linein[readX]];
+                // Get colors from remap, then draw if not transparent
+                paletteColor_t color = palette->newColors[wsg->px[(v >> 16) * wsgw + (u >> 16)]];
                 if (cTransparent != color)
                 {
-                    int32_t tx = srcX;
-                    int32_t ty = srcY;
-
-                    rotatePixel(&tx, &ty, rotateDeg, wsgw, wsgh);
-
-                    tx += xOff;
-                    ty += yOff;
-                    TURBO_SET_PIXEL_BOUNDS(tx, ty, color);
+                    lineout[x] = color;
                 }
-                readX += advanceX;
             }
+            u += dUdX;
+            v += dVdX;
         }
+        rowU += dUdY;
+        rowV += dVdY;
+        lineout += dstW;
+    }
+}
+
+/**
+ * @brief Draw a WSG to the display utilizing a palette
+ *
+ * @param wsg  The WSG to draw to the display
+ * @param xOff The x offset to draw the WSG at
+ * @param yOff The y offset to draw the WSG at
+ * @param palette The new palette used to translate the colors
+ * @param flipLR true to flip the image across the Y axis
+ * @param flipUD true to flip the image across the X axis
+ * @param rotateDeg The number of degrees to rotate clockwise, must be 0-359
+ */
+void drawWsgPalette(const wsg_t* wsg, int32_t xOff, int32_t yOff, wsgPalette_t* palette, bool flipLR, bool flipUD,
+                    int32_t rotateDeg)
+{
+    //  This function has been micro optimized by cnlohr on 2022-09-08, using gcc version 8.4.0 (crosstool-NG
+    //  esp-2021r2-patch3)
+
+    if (NULL == wsg->px)
+    {
+        return;
+    }
+
+    if (rotateDeg)
+    {
+        drawWsgPaletteRotated(wsg, xOff, yOff, palette, flipLR, flipUD, rotateDeg);
+    }
+    else if (NULL != wsg->spans)
+    {
+        // Draw the image's opaque spans (no rotation)
+        drawWsgPaletteSpans(wsg, xOff, yOff, palette, flipLR, flipUD);
     }
     else
     {
@@ -211,6 +345,11 @@ void drawWsgPaletteSimple(const wsg_t* wsg, int16_t xOff, int16_t yOff, wsgPalet
     {
         return;
     }
+    else if (NULL != wsg->spans)
+    {
+        drawWsgPaletteSpans(wsg, xOff, yOff, palette, false, false);
+        return;
+    }
 
     // Only draw in bounds
     int dWidth                   = TFT_WIDTH;
@@ -58,8 +58,8 @@ static const int16_t selectedBounceOffsets[] = {
 // Function Prototypes
 //==============================================================================
 
-static void drawMenuText(menuManiaRenderer_t* renderer, const char* text, int16_t x, int16_t y, bool isSelected,
-                         bool leftArrow, bool rightArrow, bool doubleArrows);
+static void drawMenuText(menuManiaRenderer_t* renderer, const char* text, bool textIsStatic, int16_t x, int16_t y,
+                         bool isSelected, bool leftArrow, bool rightArrow, bool doubleArrows);
 
 //==============================================================================
 // Functions
@@ -213,6 +213,8 @@ void deinitMenuManiaRenderer(menuManiaRenderer_t* renderer)
  *
  * @param renderer The renderer to draw with
  * @param text The text to draw
+ * @param textIsStatic true if the text is a label which rarely changes, so its width may be cached, false if it was
+ * formatted into a buffer
  * @param x The X coordinate to draw the text at
  * @param y The Y coordinate to draw the text at
  * @param isSelected true if the text is selected, false if it is not
@@ -220,8 +222,8 @@ void deinitMenuManiaRenderer(menuManiaRenderer_t* renderer)
  * @param rightArrow true to draw an arrow to the right, used when a menu item has options or a super-menu
  * @param doubleArrows true to draw double arrows instead of single arrows, used when entering or leaving submenus
  */
-static void drawMenuText(menuManiaRenderer_t* renderer, const char* text, int16_t x, int16_t y, bool isSelected,
-                         bool leftArrow, bool rightArrow, bool doubleArrows)
+static void drawMenuText(menuManiaRenderer_t* renderer, const char* text, bool textIsStatic, int16_t x, int16_t y,
+                         bool isSelected, bool leftArrow, bool rightArrow, bool doubleArrows)
 {
     // Pick colors based on selection
     paletteColor_t textColor = renderer->rowTextColor;
@@ -252,7 +254,12 @@ static void drawMenuText(menuManiaRenderer_t* renderer, const char* text, int16_
     }
 
     // Draw the text
-    if (isSelected && textWidth(renderer->menuFont, text) > (PARALLELOGRAM_WIDTH - PARALLELOGRAM_HEIGHT - 10))
+    uint16_t tWidth = 0;
+    if (isSelected)
+    {
+        tWidth = textIsStatic ? textWidthCached(renderer->menuFont, text) : textWidth(renderer->menuFont, text);
+    }
+    if (tWidth > (PARALLELOGRAM_WIDTH - PARALLELOGRAM_HEIGHT - 10))
     {
         drawTextMarquee(renderer->menuFont, textColor, text, x + PARALLELOGRAM_HEIGHT + 10, y + 2,
                         x + PARALLELOGRAM_WIDTH - 5, &renderer->selectedMarqueeTimer);
@@ -526,7 +533,7 @@ void drawMenuMania(menu_t* menu, menuManiaRenderer_t* renderer, int64_t elapsedU
     // Where to start drawing
     int16_t y = Y_SECTION_MARGIN;
 
-    int16_t tWidth = textWidth(renderer->titleFont, menu->title);
+    int16_t tWidth = textWidthCached(renderer->titleFont, menu->title);
 
     // Draw blue hexagon behind the title
     int16_t titleBgX0 = (TFT_WIDTH - tWidth) / 2 - 6;
@@ -600,7 +607,8 @@ void drawMenuMania(menu_t* menu, menuManiaRenderer_t* renderer, int64_t elapsedU
             bool rightArrow   = menuItemHasNext(item) || menuItemHasSubMenu(item);
             bool doubleArrows = menuItemIsBack(item) || menuItemHasSubMenu(item);
 
-            drawMenuText(renderer, label, PARALLELOGRAM_X_OFFSET, y, isSelected, leftArrow, rightArrow, doubleArrows);
+            drawMenuText(renderer, label, label != buffer, PARALLELOGRAM_X_OFFSET, y, isSelected, leftArrow, rightArrow,
+                         doubleArrows);
 
             // Move to the next item
             pageStart = pageStart->next;
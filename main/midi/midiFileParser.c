@@ -21,6 +21,22 @@
 // Structs
 //==============================================================================
 
+/// @brief Contains the incremental decompression state for one track of a streamed file
+typedef struct
+{
+    /// @brief The buffered bytes of the track, which are parsed like a whole track
+    midiTrack_t window;
+
+    /// @brief The decoder, positioned after the buffered bytes
+    heatshrinkStream_t stream;
+
+    /// @brief The number of bytes in the track which have not been buffered yet
+    uint32_t unbuffered;
+
+    /// @brief The buffer for the decompressed bytes
+    uint8_t buf[MIDI_STREAM_BUFFER_SIZE];
+} midiTrackStream_t;
+
 /// @brief Contains all track-specific parsing state
 struct midiTrackState
 {
@@ -44,8 +60,30 @@ struct midiTrackState
 
     /// @brief Whether or not the END OF TRACK event has been read
     bool done;
+
+    /// @brief If the file is streamed, the buffered part of this track, which \c track points to. Otherwise NULL
+    midiTrackStream_t* stream;
 };
 
+//==============================================================================
+// Defines
+//==============================================================================
+
+/// @brief The only supported version of the seek index chunk
+#define SEEK_INDEX_VERSION 1
+
+/// @brief The size of a seek point, not including the channel snapshots
+#define SEEK_POINT_HEADER_SIZE 18
+
+/// @brief The size of a channel snapshot, not including the controllers
+#define SEEK_CHANNEL_HEADER_SIZE 5
+
+/// @brief The value of a snapshot byte for a control which was never set
+#define SEEK_UNSET 0xFF
+
+/// @brief Read a 32-bit big-endian value
+#define READ_BE32(p) (((uint32_t)(p)[0] << 24) | ((uint32_t)(p)[1] << 16) | ((uint32_t)(p)[2] << 8) | (p)[3])
+
 typedef struct
 {
     midiPlayer_t player;
@@ -63,6 +101,15 @@ static int writeVariableLength(uint8_t* out, int max, uint32_t length);
 static bool trackParseNext(midiFileReader_t* reader, midiTrackState_t* track);
 static bool parseMidiHeader(midiFile_t* file, const char* name);
 static void readFirstEvents(midiFileReader_t* reader);
+static void parseSeekIndex(midiFile_t* file, const uint8_t* data, uint32_t length);
+static void readSeekPoint(const midiSeekIndex_t* index, uint16_t n, midiSeekPoint_t* point);
+static void consumeEvent(midiFileReader_t* reader, midiEvent_t* event);
+static uint16_t parseTimeDivision(uint16_t division);
+static void resetTrackStream(const midiFile_t* file, midiTrackState_t* state, int index);
+static bool fillTrackStream(midiTrackState_t* state);
+static bool skipOversizedEvent(midiTrackState_t* state);
+static bool parseNext(midiFileReader_t* reader, midiTrackState_t* state);
+static void freeTrackStreams(midiFileReader_t* reader);
 
 //==============================================================================
 // Variables
@@ -70,6 +117,7 @@ static void readFirstEvents(midiFileReader_t* reader);
 
 static const uint8_t midiHeader[]  = {'M', 'T', 'h', 'd'};
 static const uint8_t trackHeader[] = {'M', 'T', 'r', 'k'};
+static const uint8_t seekHeader[]  = {'S', 'W', 'i', 'x'};
 
 //==============================================================================
 // Functions
@@ -592,6 +640,51 @@ static bool trackParseNext(midiFileReader_t* reader, midiTrackState_t* track)
     return true;
 }
 
+/**
+ * @brief Convert the division from a MIDI header into the number of ticks per quarter note or frame
+ *
+ * @param division The division field from the MIDI header
+ * @return uint16_t The time division
+ */
+static uint16_t parseTimeDivision(uint16_t division)
+{
+    if (division & 0x8000)
+    {
+        // MIDI Spec Sez:
+        // Bits 14 thru 8 contain one of the four values -24, -25, -29, or -30, corresponding to
+        // the four standard SMPTE and MIDI time code formats (-29 corresponds to 30 drop frame)
+        int8_t smpte            = (((int16_t)division) >> 8) & 0xFF;
+        uint8_t framesPerSecond = -smpte;
+
+        // -24: 24fps
+        // -25: 25fps
+        // -29: 29.97fps (30 drop frame)
+        // -30: 30fps
+
+        // If we get 29.97...
+        // Wikipedia sez:
+        // In order to make an hour of timecode match an hour on the clock, drop-frame timecode
+        // skips frame numbers 0 and 1 of the first second of every minute, except when the number
+        // of minutes is divisible by ten.
+        // TODO: Screw that, I'm just going to round it to 30 for now
+        if (framesPerSecond == 29)
+        {
+            // GET YOUR UGLY FRAMERATE OUT OF HERE
+            framesPerSecond = 30;
+        }
+
+        // positive timecode division
+        uint8_t ticksPerFrame = (division & 0xFF);
+        return ticksPerFrame;
+    }
+    else
+    {
+        // ticks per quarter note
+        uint16_t ticksPerQuarterNote = (division & 0x7FFF);
+        return ticksPerQuarterNote;
+    }
+}
+
 /**
  * @brief Parse the information contained in the MIDI header and write it to the file struct
  *
@@ -647,41 +740,7 @@ static bool parseMidiHeader(midiFile_t* file, const char* name)
     uint16_t division = (file->data[offset] << 8) | file->data[offset + 1];
     offset += 2;
 
-    if (division & 0x8000)
-    {
-        // MIDI Spec Sez:
-        // Bits 14 thru 8 contain one of the four values -24, -25, -29, or -30, corresponding to
-        // the four standard SMPTE and MIDI time code formats (-29 corresponds to 30 drop frame)
-        int8_t smpte            = (((int16_t)division) >> 8) & 0xFF;
-        uint8_t framesPerSecond = -smpte;
-
-        // -24: 24fps
-        // -25: 25fps
-        // -29: 29.97fps (30 drop frame)
-        // -30: 30fps
-
-        // If we get 29.97...
-        // Wikipedia sez:
-        // In order to make an hour of timecode match an hour on the clock, drop-frame timecode
-        // skips frame numbers 0 and 1 of the first second of every minute, except when the number
-        // of minutes is divisible by ten.
-        // TODO: Screw that, I'm just going to round it to 30 for now
-        if (framesPerSecond == 29)
-        {
-            // GET YOUR UGLY FRAMERATE OUT OF HERE
-            framesPerSecond = 30;
-        }
-
-        // positive timecode division
-        uint8_t ticksPerFrame = (division & 0xFF);
-        file->timeDivision    = ticksPerFrame;
-    }
-    else
-    {
-        // ticks per quarter note
-        uint16_t ticksPerQuarterNote = (division & 0x7FFF);
-        file->timeDivision           = ticksPerQuarterNote;
-    }
+    file->timeDivision = parseTimeDivision(division);
 
     // TODO: Actually do something with the timing info
 
@@ -766,11 +825,286 @@ static bool parseMidiHeader(midiFile_t* file, const char* name)
         return false;
     }
 
+    // Look for a seek index in any chunks after the tracks
+    while ((ptr - file->data) + 8 <= file->length)
+    {
+        uint32_t extraChunkLen = READ_BE32(ptr + 4);
+        if (extraChunkLen > file->length - (ptr - file->data) - 8)
+        {
+            break;
+        }
+
+        if (1 == file->trackCount && !memcmp(ptr, seekHeader, sizeof(seekHeader)))
+        {
+            parseSeekIndex(file, ptr + 8, extraChunkLen);
+        }
+
+        ptr += 8 + extraChunkLen;
+    }
+
     // Header has been read and all track offsets have been loaded
     // And all track data chunks should be safe
     return true;
 }
 
+/**
+ * @brief Parse a seek index chunk written by the assets preprocessor and save it in the file struct
+ *
+ * The index is left empty if the chunk is malformed or has an unknown version.
+ *
+ * @param file The MIDI file struct to write the seek index into
+ * @param data The chunk data, not including the chunk header
+ * @param length The length of the chunk data
+ */
+static void parseSeekIndex(midiFile_t* file, const uint8_t* data, uint32_t length)
+{
+    midiSeekIndex_t index = {0};
+    const uint8_t* end    = data + length;
+
+    // Version, source track count, channel mask, controller count
+    if (length < 5 || SEEK_INDEX_VERSION != data[0])
+    {
+        ESP_LOGW("MIDIParser", "Ignoring unsupported seek index");
+        return;
+    }
+
+    index.channelMask = (data[2] << 8) | data[3];
+    index.ccCount     = data[4];
+    data += 5;
+
+    index.ccNumbers = data;
+    data += index.ccCount;
+
+    // Seek point count and track map length
+    if (end - data < 6)
+    {
+        ESP_LOGW("MIDIParser", "Seek index is truncated");
+        return;
+    }
+    index.count     = (data[0] << 8) | data[1];
+    index.mapLength = READ_BE32(data + 2);
+    data += 6;
+
+    if ((uint32_t)(end - data) < index.mapLength)
+    {
+        ESP_LOGW("MIDIParser", "Seek index is truncated");
+        return;
+    }
+    index.trackMap = index.mapLength ? data : NULL;
+    data += index.mapLength;
+
+    // Setup event offsets
+    if (end - data < 2)
+    {
+        ESP_LOGW("MIDIParser", "Seek index is truncated");
+        return;
+    }
+    index.setupCount = (data[0] << 8) | data[1];
+    data += 2;
+
+    if ((uint32_t)(end - data) < (uint32_t)index.setupCount * 4)
+    {
+        ESP_LOGW("MIDIParser", "Seek index is truncated");
+        return;
+    }
+    index.setupOffsets = data;
+    data += (uint32_t)index.setupCount * 4;
+
+    index.entrySize = SEEK_POINT_HEADER_SIZE
+                      + __builtin_popcount(index.channelMask) * (SEEK_CHANNEL_HEADER_SIZE + index.ccCount);
+    if ((uint32_t)(end - data) < (uint32_t)index.count * index.entrySize)
+    {
+        ESP_LOGW("MIDIParser", "Seek index is truncated");
+        return;
+    }
+    index.entries = data;
+
+    file->seekIndex = index;
+}
+
+/**
+ * @brief Read a seek point from a seek index
+ *
+ * @param index The seek index to read from
+ * @param n The index of the seek point to read
+ * @param[out] point The seek point to write to
+ */
+static void readSeekPoint(const midiSeekIndex_t* index, uint16_t n, midiSeekPoint_t* point)
+{
+    const uint8_t* entry = index->entries + (uint32_t)n * index->entrySize;
+
+    point->tick          = READ_BE32(entry);
+    point->offset        = READ_BE32(entry + 4);
+    point->metaIndex     = READ_BE32(entry + 8);
+    point->tempo         = (entry[12] << 16) | (entry[13] << 8) | entry[14];
+    point->runningStatus = entry[15];
+    point->setupCount    = (entry[16] << 8) | entry[17];
+    point->channels      = entry + SEEK_POINT_HEADER_SIZE;
+}
+
+/**
+ * @brief Rewind a streamed track to its start by restoring the decoder from the file's checkpoint
+ *
+ * @param file The streamed MIDI file
+ * @param state The track state, which must already have a stream
+ * @param index The index of the track
+ */
+static void resetTrackStream(const midiFile_t* file, midiTrackState_t* state, int index)
+{
+    midiTrackStream_t* trackStream = state->stream;
+
+    // The destination decoder is already allocated, so this can't fail
+    heatshrinkStreamCopy(&trackStream->stream, &file->trackStreams[index], true);
+    trackStream->unbuffered    = file->tracks[index].length;
+    trackStream->window.length = 0;
+    state->cur                 = trackStream->buf;
+}
+
+/**
+ * @brief Move the unread bytes of a streamed track to the start of its buffer, then fill the rest of the buffer
+ *
+ * @param state The track state to fill the buffer of
+ * @return true if any bytes were decompressed
+ * @return false if the whole track has already been buffered
+ */
+static bool fillTrackStream(midiTrackState_t* state)
+{
+    midiTrackStream_t* trackStream = state->stream;
+    uint32_t unread                = trackStream->window.length - (state->cur - trackStream->buf);
+
+    if (0 == trackStream->unbuffered)
+    {
+        return false;
+    }
+
+    memmove(trackStream->buf, state->cur, unread);
+    state->cur = trackStream->buf;
+
+    uint32_t toRead = MIN(sizeof(trackStream->buf) - unread, trackStream->unbuffered);
+    uint32_t read   = heatshrinkStreamRead(&trackStream->stream, &trackStream->buf[unread], toRead);
+
+    // If the stream was cut short, there's nothing more to read
+    trackStream->unbuffered    = (read < toRead) ? 0 : trackStream->unbuffered - read;
+    trackStream->window.length = unread + read;
+    return read > 0;
+}
+
+/**
+ * @brief Make sure a streamed track's next meta or SysEx event is buffered, or skip it if it's too big to ever be
+ *
+ * The track's buffer must already hold at least the event's delta-time, status, and length.
+ *
+ * @param state The track state to check the next event of
+ * @return true if an event was skipped, and this should be called again for the next one
+ * @return false if the next event can be parsed from the buffer
+ */
+static bool skipOversizedEvent(midiTrackState_t* state)
+{
+    midiTrackStream_t* trackStream = state->stream;
+    const uint8_t* data            = state->cur;
+    uint32_t unread                = trackStream->window.length - (data - trackStream->buf);
+
+    uint32_t deltaTime;
+    uint32_t offset = readVariableLength(data, unread, &deltaTime);
+    if (0 == offset || offset >= unread)
+    {
+        return false;
+    }
+
+    // Only meta and SysEx events have a length that can exceed the buffer
+    uint8_t status = data[offset++];
+    if (0xFF == status)
+    {
+        // Skip the meta type
+        offset++;
+    }
+    else if (0xF0 != status && 0xF7 != status)
+    {
+        return false;
+    }
+
+    uint32_t length;
+    int read = (offset < unread) ? readVariableLength(&data[offset], unread - offset, &length) : 0;
+    if (0 == read)
+    {
+        return false;
+    }
+
+    uint32_t total = offset + read + length;
+    if (total <= unread)
+    {
+        // Already buffered
+        return false;
+    }
+    else if (total <= sizeof(trackStream->buf))
+    {
+        // It'll fit once the buffer is filled
+        fillTrackStream(state);
+        return false;
+    }
+
+    ESP_LOGW("MIDIParser", "Skipping %" PRIu32 " byte event which does not fit in the stream buffer", total);
+
+    // Throw away the rest of the event, which hasn't been decompressed yet
+    uint32_t discard = MIN(total - unread, trackStream->unbuffered);
+    heatshrinkStreamRead(&trackStream->stream, NULL, discard);
+    trackStream->unbuffered -= discard;
+    trackStream->window.length = 0;
+    state->cur                 = trackStream->buf;
+
+    // Keep the event's time, and its effect on running status
+    state->time += deltaTime;
+    if (0xFF != status)
+    {
+        state->runningStatus = 0;
+    }
+    return true;
+}
+
+/**
+ * @brief Parse the next event in a track, first decompressing more of it if the file is streamed
+ *
+ * @param reader The reader to read file data from
+ * @param state The track parse state where the event will be stored
+ * @return true If an event was successfully parsed
+ * @return false If there are no more events in the track, or a fatal error was encountered while parsing
+ */
+static bool parseNext(midiFileReader_t* reader, midiTrackState_t* state)
+{
+    if (NULL != state->stream && !state->done)
+    {
+        do
+        {
+            // Anything but a meta or SysEx event is at most 7 bytes, and their headers are at most 10
+            if (state->stream->window.length - (state->cur - state->stream->buf) < 16)
+            {
+                fillTrackStream(state);
+            }
+        } while (skipOversizedEvent(state));
+    }
+
+    return trackParseNext(reader, state);
+}
+
+/**
+ * @brief Free the stream buffers and decoders of all of a reader's track states
+ *
+ * @param reader The reader to free the streams of
+ */
+static void freeTrackStreams(midiFileReader_t* reader)
+{
+    for (int i = 0; i < reader->stateCount; i++)
+    {
+        midiTrackStream_t* trackStream = reader->states[i].stream;
+        if (NULL != trackStream)
+        {
+            heatshrinkStreamDeinit(&trackStream->stream);
+            heap_caps_free(trackStream);
+            reader->states[i].stream = NULL;
+        }
+    }
+}
+
 /**
  * @brief Attempt to read the first event from each track in the MIDI file
  *
@@ -781,7 +1115,7 @@ static void readFirstEvents(midiFileReader_t* reader)
     for (int i = 0; i < reader->file->trackCount; i++)
     {
         // Parse the first event from each track?
-        reader->states[i].eventParsed = trackParseNext(reader, &reader->states[i]);
+        reader->states[i].eventParsed = parseNext(reader, &reader->states[i]);
 
         // Handle empty/invalid tracks
         if (!reader->states[i].eventParsed)
@@ -863,8 +1197,140 @@ bool loadMidiFile(const char* name, midiFile_t* file, bool spiRam)
     }
 }
 
+bool loadMidiFileStreamed(const char* name, midiFile_t* file, bool spiRam)
+{
+    size_t rawSize;
+    const uint8_t* raw = cnfsGetFile(name, &rawSize);
+    if (NULL == raw)
+    {
+        return false;
+    }
+
+    if (rawSize >= sizeof(midiHeader) && !memcmp(raw, midiHeader, sizeof(midiHeader)))
+    {
+        // Nothing to stream
+        return loadMidiFile(name, file, spiRam);
+    }
+
+    memset(file, 0, sizeof(midiFile_t));
+
+    heatshrinkStream_t stream;
+    if (!heatshrinkStreamInit(&stream, raw, (uint32_t)rawSize))
+    {
+        ESP_LOGE("MIDIFileParser", "Song %s could not be decompressed!", name);
+        return false;
+    }
+    file->length = stream.remaining;
+
+    uint8_t header[8 + 6];
+    if (sizeof(header) != heatshrinkStreamRead(&stream, header, sizeof(header))
+        || memcmp(header, midiHeader, sizeof(midiHeader)))
+    {
+        ESP_LOGE("MIDIParser", "Not a MIDI file! Header does not match");
+        heatshrinkStreamDeinit(&stream);
+        return false;
+    }
+
+    uint32_t chunkLen = READ_BE32(&header[4]);
+    uint16_t format   = (header[8] << 8) | header[9];
+    uint16_t count    = (header[10] << 8) | header[11];
+    uint16_t division = (header[12] << 8) | header[13];
+
+    if (format > 2)
+    {
+        ESP_LOGE("MIDIParser", "Unsupported MIDI file format: %" PRIu16, format);
+        heatshrinkStreamDeinit(&stream);
+        return false;
+    }
+    else if (format == 0 && count != 1)
+    {
+        ESP_LOGE("MIDIParser", "Type-0 MIDI file should have 1 track, instead it has: %" PRIu16, count);
+        heatshrinkStreamDeinit(&stream);
+        return false;
+    }
+
+    file->format       = (midiFileFormat_t)format;
+    file->timeDivision = parseTimeDivision(division);
+    file->trackCount   = count;
+    file->tracks       = heap_caps_calloc_tag(count, sizeof(midiTrack_t), MALLOC_CAP_SPIRAM, name);
+    file->trackStreams = heap_caps_calloc_tag(count, sizeof(heatshrinkStream_t), MALLOC_CAP_SPIRAM, name);
+    if (NULL == file->tracks || NULL == file->trackStreams)
+    {
+        ESP_LOGE("MIDIParser", "Could not allocate data for MIDI file with %" PRIu16 " tracks", count);
+        heatshrinkStreamDeinit(&stream);
+        unloadMidiFile(file);
+        return false;
+    }
+
+    // Skip anything extra that might be in the header, the same way parseMidiHeader() does
+    if (chunkLen > sizeof(header) + sizeof(midiHeader) + 4)
+    {
+        heatshrinkStreamRead(&stream, NULL, chunkLen - (sizeof(midiHeader) + 4) - sizeof(header));
+    }
+
+    int i = 0;
+    while (i < count)
+    {
+        uint8_t chunkHeader[8];
+        if (sizeof(chunkHeader) != heatshrinkStreamRead(&stream, chunkHeader, sizeof(chunkHeader)))
+        {
+            ESP_LOGE("MIDIParser", ":%d Reached end of file unexpectedly while reading track chunk %d", __LINE__, i);
+            heatshrinkStreamDeinit(&stream);
+            unloadMidiFile(file);
+            return false;
+        }
+
+        uint32_t trackChunkLen = READ_BE32(&chunkHeader[4]);
+        if (memcmp(chunkHeader, trackHeader, sizeof(trackHeader)))
+        {
+            // We should ignore unknown chunk types
+            ESP_LOGW("MIDIParser", "Start of chunk %d did not contain track chunk header", i);
+            heatshrinkStreamRead(&stream, NULL, trackChunkLen);
+            continue;
+        }
+
+        if (trackChunkLen > stream.remaining)
+        {
+            ESP_LOGW("MIDIParser",
+                     "Track chunk %d claims length of %" PRIu32 " but there are only %" PRIu32
+                     " bytes remaining in the file",
+                     i, trackChunkLen, stream.remaining);
+            trackChunkLen = stream.remaining;
+        }
+
+        // Remember where this track starts, so readers can decompress it from there
+        file->tracks[i].length = trackChunkLen;
+        if (!heatshrinkStreamCopy(&file->trackStreams[i], &stream, spiRam))
+        {
+            ESP_LOGE("MIDIParser", "Could not allocate decoder for track %d", i);
+            heatshrinkStreamDeinit(&stream);
+            unloadMidiFile(file);
+            return false;
+        }
+
+        // Nothing after the last track is needed, so don't bother decompressing it
+        if (++i < count)
+        {
+            heatshrinkStreamRead(&stream, NULL, trackChunkLen);
+        }
+    }
+
+    heatshrinkStreamDeinit(&stream);
+    ESP_LOGI("MIDIFileParser", "Song %s has %" PRIu32 " bytes, streamed from %" PRIu32, name, file->length,
+             (uint32_t)rawSize);
+    return true;
+}
+
 void unloadMidiFile(midiFile_t* file)
 {
+    if (NULL != file->trackStreams)
+    {
+        for (int i = 0; i < file->trackCount; i++)
+        {
+            heatshrinkStreamDeinit(&file->trackStreams[i]);
+        }
+        heap_caps_free(file->trackStreams);
+    }
     heap_caps_free(file->tracks);
     heap_caps_free(file->data);
     memset(file, 0, sizeof(midiFile_t));
@@ -890,6 +1356,7 @@ void midiParserSetFile(midiFileReader_t* reader, const midiFile_t* file)
 {
     if (reader->states != NULL)
     {
+        freeTrackStreams(reader);
         heap_caps_free(reader->states);
         reader->states = NULL;
     }
@@ -900,12 +1367,35 @@ void midiParserSetFile(midiFileReader_t* reader, const midiFile_t* file)
     // Initialize the reader's internal per-track parsing states
     for (int i = 0; i < file->trackCount; i++)
     {
-        reader->states[i].track = &file->tracks[i];
-        reader->states[i].cur   = file->tracks[i].data;
+        midiTrackState_t* state = &reader->states[i];
+        if (NULL != file->trackStreams)
+        {
+            // Each reader decompresses its own copy of the track
+            state->stream = heap_caps_calloc(1, sizeof(midiTrackStream_t), MALLOC_CAP_SPIRAM);
+            if (NULL == state->stream
+                || !heatshrinkStreamCopy(&state->stream->stream, &file->trackStreams[i], true))
+            {
+                ESP_LOGE("MIDIParser", "Could not allocate stream for track %d", i);
+                heap_caps_free(state->stream);
+                state->stream = NULL;
+                state->done   = true;
+                continue;
+            }
+
+            state->stream->window.data = state->stream->buf;
+            state->track               = &state->stream->window;
+            resetTrackStream(file, state, i);
+        }
+        else
+        {
+            state->track = &file->tracks[i];
+            state->cur   = file->tracks[i].data;
+        }
     }
 
-    reader->file     = file;
-    reader->division = file->timeDivision;
+    reader->file       = file;
+    reader->division   = file->timeDivision;
+    reader->metaIndex = 0;
 
     readFirstEvents(reader);
 }
@@ -917,7 +1407,11 @@ void resetMidiParser(midiFileReader_t* reader)
         reader->states[i].done          = false;
         reader->states[i].eventParsed   = false;
         reader->states[i].runningStatus = 0;
-        if (reader->states[i].track != NULL)
+        if (reader->states[i].stream != NULL && reader->file != NULL)
+        {
+            resetTrackStream(reader->file, &reader->states[i], i);
+        }
+        else if (reader->states[i].track != NULL)
         {
             reader->states[i].cur = reader->states[i].track->data;
         }
@@ -930,6 +1424,8 @@ void resetMidiParser(midiFileReader_t* reader)
         reader->states[i].time = 0;
     }
 
+    reader->metaIndex = 0;
+
     if (reader->file != NULL)
     {
         reader->division = reader->file->timeDivision;
@@ -939,6 +1435,8 @@ void resetMidiParser(midiFileReader_t* reader)
 
 void deinitMidiParser(midiFileReader_t* reader)
 {
+    freeTrackStreams(reader);
+
     midiTrackState_t* states = reader->states;
 
     reader->stateCount = 0;
@@ -974,15 +1472,15 @@ bool midiNextEvent(midiFileReader_t* reader, midiEvent_t* event)
             {
                 continue;
             }
-            info->eventParsed = trackParseNext(reader, info);
+            info->eventParsed = parseNext(reader, info);
         }
 
         // Check if we either already have a parsed event waiting, or are able to parse one now
         // Short-circuiting will make sure we only parse another event when needed and permitted
         // TODO doesn't this basically do the same thing as the block above?
-        if (info->eventParsed || (info->nextEvent.deltaTime != UINT32_MAX && trackParseNext(reader, info)))
+        if (info->eventParsed || (info->nextEvent.deltaTime != UINT32_MAX && parseNext(reader, info)))
         {
-            // info->nextEvent has now been set by trackParseNext()
+            // info->nextEvent has now been set by parseNext()
             if (!info->nextEvent.deltaTime || (reader && reader->file && reader->file->format == MIDI_FORMAT_2))
             {
                 // The delta-time is 0! Just return this event immediately
@@ -993,6 +1491,7 @@ bool midiNextEvent(midiFileReader_t* reader, midiEvent_t* event)
 
                 // Add to the time still, since deltaTime could be non-zero
                 info->time += info->nextEvent.deltaTime;
+                consumeEvent(reader, event);
                 return true;
             }
             else if (info->time + info->nextEvent.deltaTime < minTime)
@@ -1013,9 +1512,170 @@ bool midiNextEvent(midiFileReader_t* reader, midiEvent_t* event)
     *event                 = nextTrack->nextEvent;
     nextTrack->eventParsed = false;
     nextTrack->time += event->deltaTime;
+    consumeEvent(reader, event);
     return true;
 }
 
+/**
+ * @brief Count a meta-event returned by the reader, and restore its original track index if the file was pre-merged
+ *
+ * @param reader The reader the event was returned from
+ * @param event The event which was returned
+ */
+static void consumeEvent(midiFileReader_t* reader, midiEvent_t* event)
+{
+    if (META_EVENT == event->type)
+    {
+        const midiSeekIndex_t* index = &reader->file->seekIndex;
+        if (index->trackMap && reader->metaIndex < index->mapLength)
+        {
+            event->track = index->trackMap[reader->metaIndex];
+        }
+        reader->metaIndex++;
+    }
+}
+
+bool midiFindSeekPoint(const midiFile_t* file, uint32_t ticks, midiSeekPoint_t* point)
+{
+    const midiSeekIndex_t* index = &file->seekIndex;
+    if (NULL == index->entries || 0 == index->count)
+    {
+        return false;
+    }
+
+    // Find the last point whose tick is not after the target
+    int32_t lo    = 0;
+    int32_t hi    = index->count - 1;
+    int32_t found = -1;
+    while (lo <= hi)
+    {
+        int32_t mid = (lo + hi) / 2;
+        if (READ_BE32(index->entries + (uint32_t)mid * index->entrySize) <= ticks)
+        {
+            found = mid;
+            lo    = mid + 1;
+        }
+        else
+        {
+            hi = mid - 1;
+        }
+    }
+
+    if (found < 0)
+    {
+        return false;
+    }
+
+    readSeekPoint(index, found, point);
+    return point->offset < file->tracks[0].length && point->setupCount <= index->setupCount;
+}
+
+void midiParserJump(midiFileReader_t* reader, const midiSeekPoint_t* point)
+{
+    midiTrackState_t* state = &reader->states[0];
+
+    state->cur           = state->track->data + point->offset;
+    state->time          = point->tick;
+    state->runningStatus = point->runningStatus;
+    state->done          = false;
+    state->eventParsed   = false;
+    memset(&state->nextEvent, 0, sizeof(midiEvent_t));
+
+    reader->metaIndex = point->metaIndex;
+    readFirstEvents(reader);
+}
+
+bool midiSeekPointEvent(midiFileReader_t* reader, const midiSeekPoint_t* point, uint16_t index, midiEvent_t* event)
+{
+    const midiSeekIndex_t* seekIndex = &reader->file->seekIndex;
+
+    if (index < point->setupCount)
+    {
+        // Parse the setup event in place, without disturbing the reader's position
+        midiTrackState_t* state = &reader->states[0];
+        midiTrackState_t saved  = *state;
+        uint32_t offset         = READ_BE32(seekIndex->setupOffsets + (uint32_t)index * 4);
+
+        bool parsed = false;
+        if (offset < state->track->length)
+        {
+            state->cur           = state->track->data + offset;
+            state->runningStatus = 0;
+            state->done          = false;
+            parsed               = trackParseNext(reader, state);
+            *event               = state->nextEvent;
+            event->absTime       = point->tick;
+        }
+        *state = saved;
+
+        return parsed;
+    }
+    index -= point->setupCount;
+
+    // Each channel is restored by bank select, program change, each controller, then pitch bend
+    const uint8_t slotsPerChannel = 4 + seekIndex->ccCount;
+    const uint8_t* snapshot       = point->channels;
+
+    for (uint8_t channel = 0; channel < 16; channel++)
+    {
+        if (!(seekIndex->channelMask & (1 << channel)))
+        {
+            continue;
+        }
+
+        for (uint8_t slot = 0; slot < slotsPerChannel; slot++)
+        {
+            uint8_t status, data0, data1;
+            if (slot < 2)
+            {
+                // Bank MSB, then LSB
+                status = 0xB0;
+                data0  = slot ? MCC_BANK_LSB : MCC_BANK_MSB;
+                data1  = snapshot[slot];
+            }
+            else if (slot == 2)
+            {
+                status = 0xC0;
+                data0  = snapshot[2];
+                data1  = 0;
+            }
+            else if (slot < slotsPerChannel - 1)
+            {
+                status = 0xB0;
+                data0  = seekIndex->ccNumbers[slot - 3];
+                data1  = snapshot[SEEK_CHANNEL_HEADER_SIZE + slot - 3];
+            }
+            else
+            {
+                status = 0xE0;
+                data0  = snapshot[3];
+                data1  = snapshot[4];
+            }
+
+            if (SEEK_UNSET == data0 || SEEK_UNSET == data1)
+            {
+                // This was never set before the seek point
+                continue;
+            }
+
+            if (0 == index--)
+            {
+                memset(event, 0, sizeof(midiEvent_t));
+                event->absTime        = point->tick;
+                event->type           = MIDI_EVENT;
+                event->midi.status    = status | channel;
+                event->midi.data[0]   = data0;
+                event->midi.data[1]   = data1;
+                return true;
+            }
+        }
+
+        snapshot += SEEK_CHANNEL_HEADER_SIZE + seekIndex->ccCount;
+    }
+
+    return false;
+}
+
 void* globalMidiSave(void)
 {
     // TODO: There are multiple allocs here, so the return value _can't_ safely be heap_caps_free()'d by others
@@ -1028,6 +1688,10 @@ void* globalMidiSave(void)
         {
             memcpy(&saveState[i].player, player, sizeof(midiPlayer_t));
 
+            // The copy must not share the live reader's track states, which are freed when the player is reset
+            saveState[i].player.reader.states     = NULL;
+            saveState[i].player.reader.stateCount = 0;
+
             if (player->reader.file != NULL)
             {
                 saveState[i].trackCount = player->reader.file->trackCount;
@@ -1035,7 +1699,8 @@ void* globalMidiSave(void)
                     = heap_caps_calloc(saveState[i].trackCount, sizeof(midiTrackState_t), MALLOC_CAP_SPIRAM);
 
                 // Overwrite the copy with the newly allocated pointer, since the current one may be free'd
-                saveState[i].player.reader.states = saveState[i].trackStates;
+                saveState[i].player.reader.states     = saveState[i].trackStates;
+                saveState[i].player.reader.stateCount = saveState[i].trackCount;
 
                 for (int trackIdx = 0; trackIdx < saveState[i].trackCount; trackIdx++)
                 {
@@ -1043,6 +1708,33 @@ void* globalMidiSave(void)
                     midiTrackState_t* stateCopy       = &saveState[i].trackStates[trackIdx];
 
                     memcpy(stateCopy, stateOrig, sizeof(midiTrackState_t));
+
+                    if (NULL != stateOrig->stream)
+                    {
+                        // Streamed tracks need their own buffer and decoder, pointed to by the copied state
+                        midiTrackStream_t* streamCopy = heap_caps_malloc(sizeof(midiTrackStream_t), MALLOC_CAP_SPIRAM);
+                        if (NULL != streamCopy)
+                        {
+                            memcpy(streamCopy, stateOrig->stream, sizeof(midiTrackStream_t));
+                            streamCopy->stream.hsd = NULL;
+                        }
+
+                        if (NULL == streamCopy
+                            || !heatshrinkStreamCopy(&streamCopy->stream, &stateOrig->stream->stream, true))
+                        {
+                            ESP_LOGE("MIDIParser", "Could not save stream for track %d", trackIdx);
+                            heap_caps_free(streamCopy);
+                            stateCopy->stream = NULL;
+                            stateCopy->track  = NULL;
+                            stateCopy->done   = true;
+                            continue;
+                        }
+
+                        streamCopy->window.data = streamCopy->buf;
+                        stateCopy->stream       = streamCopy;
+                        stateCopy->track        = &streamCopy->window;
+                        stateCopy->cur          = streamCopy->buf + (stateOrig->cur - stateOrig->stream->buf);
+                    }
                 }
             }
         }
@@ -1062,6 +1754,10 @@ void globalMidiRestore(void* data)
         {
             midiPlayerReset(player);
 
+            // Free the live track states and their stream buffers and decoders before the saved ones replace them.
+            // midiPlayerReset() does this too, but the restore must not depend on it
+            deinitMidiParser(&player->reader);
+
             memcpy(player, &saveState[i].player, sizeof(midiPlayer_t));
         }
     }
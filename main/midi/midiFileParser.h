@@ -7,6 +7,15 @@
 #include <stdint.h>
 #include <stdbool.h>
 
+#include "heatshrink_helper.h"
+
+//==============================================================================
+// Defines
+//==============================================================================
+
+/// @brief The number of decompressed bytes buffered for each track when a file is streamed
+#define MIDI_STREAM_BUFFER_SIZE 256
+
 //==============================================================================
 // Enums
 //==============================================================================
@@ -73,16 +82,87 @@ typedef struct
     /// @brief Total chunk length
     uint32_t length;
 
-    /// @brief Pointer to the start of this chunk's data
+    /// @brief Pointer to the start of this chunk's data, or NULL if the file is streamed
     uint8_t* data;
 } midiTrack_t;
 
+/**
+ * @brief The seek index of a pre-merged MIDI file, pointing into the file's data
+ *
+ * The assets preprocessor can merge all of a MIDI file's tracks into a single track, and then append a chunk with the
+ * ID \c SWix which holds an index of points in that track where playback may resume. Each point records the absolute
+ * tick, byte offset, tempo, running status, and a snapshot of each channel's bank, program, pitch bend, and
+ * controllers. State which can't be captured in a snapshot, like SysEx and parameter data entry, is restored by
+ * replaying those "setup" events from their offsets in the track. The chunk also maps each merged meta-event back to
+ * the track it originally came from. Other MIDI software will ignore the unknown chunk and play the merged track
+ * normally.
+ */
+typedef struct
+{
+    /// @brief The first seek point, or NULL if the file has no seek index
+    const uint8_t* entries;
+
+    /// @brief The number of seek points
+    uint16_t count;
+
+    /// @brief The size of each seek point, in bytes
+    uint16_t entrySize;
+
+    /// @brief A bitmask of channels which are included in each seek point's snapshot
+    uint16_t channelMask;
+
+    /// @brief The number of controllers included in each channel's snapshot
+    uint8_t ccCount;
+
+    /// @brief The controller numbers included in each channel's snapshot
+    const uint8_t* ccNumbers;
+
+    /// @brief The number of entries in trackMap
+    uint32_t mapLength;
+
+    /// @brief The original track index of each meta-event in the merged track, or NULL
+    const uint8_t* trackMap;
+
+    /// @brief The number of setup events in the merged track
+    uint16_t setupCount;
+
+    /// @brief The big-endian 32-bit offsets of each setup event within the merged track
+    const uint8_t* setupOffsets;
+} midiSeekIndex_t;
+
+/**
+ * @brief A point in a pre-merged MIDI file where playback may resume
+ */
+typedef struct
+{
+    /// @brief The absolute time of the event before this point, in ticks
+    uint32_t tick;
+
+    /// @brief The byte offset of the next event within the merged track
+    uint32_t offset;
+
+    /// @brief The number of meta-events in the merged track before this point
+    uint32_t metaIndex;
+
+    /// @brief The tempo at this point, in microseconds per quarter note
+    uint32_t tempo;
+
+    /// @brief The running status at this point, or 0 if none
+    uint8_t runningStatus;
+
+    /// @brief The number of setup events before this point
+    uint16_t setupCount;
+
+    /// @brief The packed channel snapshot for this point
+    const uint8_t* channels;
+} midiSeekPoint_t;
+
 /**
  * @brief Contains information which applies to the entire MIDI file
  */
 typedef struct
 {
-    /// @brief A pointer to the start of the MIDI file
+    /// @brief A pointer to the start of the MIDI file, or NULL if the file is streamed
     uint8_t* data;
 
     /// @brief The total length of the MIDI file
@@ -99,6 +179,12 @@ typedef struct
 
     /// @brief An array of MIDI tracks
     midiTrack_t* tracks;
+
+    /// @brief The seek index, if this file was pre-merged by the assets preprocessor and is not streamed
+    midiSeekIndex_t seekIndex;
+
+    /// @brief If the file is streamed, the decoder state at the start of each track's data, otherwise NULL
+    heatshrinkStream_t* trackStreams;
 } midiFile_t;
 
 typedef struct midiTrackState midiTrackState_t;
@@ -117,6 +203,9 @@ typedef struct
     /// @brief The number of track states allocated
     uint8_t stateCount;
 
+    /// @brief The number of meta-events returned since the start of the file, used to look up pre-merged track indices
+    uint32_t metaIndex;
+
     /// @brief An array containing the internal parser state for each track
     midiTrackState_t* states;
 } midiFileReader_t;
@@ -269,6 +358,28 @@ typedef struct
  */
 bool loadMidiFile(const char* name, midiFile_t* file, bool spiRam);
 
+/**
+ * @brief Load a MIDI file from the filesystem for streaming, without decompressing it all at once
+ *
+ * Instead of inflating the whole file into RAM, this saves a copy of the heatshrink decoder's state at the start of
+ * each track. Readers of a streamed file decompress each track incrementally into a ::MIDI_STREAM_BUFFER_SIZE byte
+ * buffer, so memory use depends on the number of tracks rather than the length of the song. Finding the tracks means
+ * decompressing everything before the last one once, but a single-track file, like one pre-merged by the assets
+ * preprocessor, is ready immediately.
+ *
+ * When streaming, the text or data of a meta-event or SysEx event is only valid until the next call to
+ * midiNextEvent(), and events with more data than fit in the buffer are skipped. Seek indexes are not used, so seeking
+ * restarts from the beginning and meta-events from pre-merged files all report track 0. Files which are not compressed
+ * are loaded normally.
+ *
+ * @param name The name of the MIDI file to load
+ * @param file A pointer to a midiFile_t struct to load the file into
+ * @param spiRam Whether to store the track decoder states in SPIRAM
+ * @return true If the load succeeded
+ * @return false If the load failed
+ */
+bool loadMidiFileStreamed(const char* name, midiFile_t* file, bool spiRam);
+
 /**
  * @brief Free the data associated with the given MIDI file
  *
@@ -328,6 +439,45 @@ uint32_t midiNextEventTime(midiFileReader_t* reader);
  */
 bool midiNextEvent(midiFileReader_t* reader, midiEvent_t* event);
 
+/**
+ * @brief Find the last seek point at or before the given time in a pre-merged MIDI file
+ *
+ * This is a binary search over the file's seek index.
+ *
+ * @param file The MIDI file to search
+ * @param ticks The time to seek to, in ticks
+ * @param[out] point A pointer to a seek point to be updated with the point found
+ * @return true if a seek point was found
+ * @return false if the file has no seek index or no seek point at or before the given time
+ */
+bool midiFindSeekPoint(const midiFile_t* file, uint32_t ticks, midiSeekPoint_t* point);
+
+/**
+ * @brief Move a reader to a seek point, so the next event returned is the first event after the point
+ *
+ * The reader must already be initialized with the file the seek point came from. Only the reader's position is
+ * changed, use midiSeekPointEvent() to retrieve the events needed to restore the player state.
+ *
+ * @param reader The reader to move
+ * @param point The seek point to move to
+ */
+void midiParserJump(midiFileReader_t* reader, const midiSeekPoint_t* point);
+
+/**
+ * @brief Retrieve one of the events which restores the player state saved at a seek point
+ *
+ * Call this with an increasing index starting from 0 until it returns false, and handle each event in order. The setup
+ * events before the point are returned first, followed by the channel snapshot. The reader's position is not changed.
+ *
+ * @param reader The reader, initialized with the file the seek point came from
+ * @param point The seek point to restore
+ * @param index The index of the restore event to retrieve
+ * @param[out] event A pointer to a MIDI event to be updated with the restore event
+ * @return true if event data was written to event
+ * @return false if there are no more restore events
+ */
+bool midiSeekPointEvent(midiFileReader_t* reader, const midiSeekPoint_t* point, uint16_t index, midiEvent_t* event);
+
 /**
  * @brief Writes a MIDI event to a byte buffer
  *
@@ -2376,13 +2376,34 @@ void midiSeek(midiPlayer_t* player, uint32_t ticks)
         player->songFinishedCallback = NULL;
         bool loop                    = player->loop;
 
-        if (SAMPLES_TO_MIDI_TICKS(player->sampleCount, player->tempo, player->reader.division) > ticks)
+        // If the file was pre-merged with a seek index, jump to the nearest point before the target when going
+        // backwards or when that point is further ahead than the current position
+        uint32_t startTick = SAMPLES_TO_MIDI_TICKS(player->sampleCount, player->tempo, player->reader.division);
+        midiSeekPoint_t point;
+        bool useIndex = midiFindSeekPoint(loadedFile, ticks, &point) && (startTick > ticks || point.tick > startTick);
+
+        if (useIndex || startTick > ticks)
         {
             // We have to go back
             midiPlayerReset(player);
             midiSetFile(player, loadedFile);
         }
 
+        if (useIndex)
+        {
+            // Restore the tempo and channel state at the seek point, then continue from there
+            midiEvent_t restoreEvent;
+            for (uint16_t i = 0; midiSeekPointEvent(&player->reader, &point, i, &restoreEvent); i++)
+            {
+                handleEvent(player, &restoreEvent);
+            }
+
+            midiParserJump(&player->reader, &point);
+            player->tempo = point.tempo;
+
+            player->sampleCount = TICKS_TO_SAMPLES(point.tick, player->tempo, player->reader.division);
+        }
+
         // Set the seeking flag so that the DAC won't get any output
         player->seeking = true;
 
@@ -973,7 +973,9 @@ void midiPause(midiPlayer_t* player, bool pause);
  *
  * Note that in the current implementation, seeking backwards by any amount requires
  * re-reading the file from the beginning, and so may be very slow, particularly for
- * large MIDI files.
+ * large MIDI files. Files pre-merged with a seek index by the assets preprocessor instead
+ * resume from the nearest seek point, restoring its tempo and channel state. Notes held
+ * across a seek point are not restored.
  *
  * @param player The MIDI player to seek on
  * @param ticks The absolute number of MIDI ticks to seek to. If this is -1, it
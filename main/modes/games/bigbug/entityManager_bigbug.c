@@ -311,10 +311,8 @@ void bb_updateEntities(bb_entityManager_t* entityManager, bb_camera_t* camera)
                 if (foundSpot->spriteIndex == EGG_LEAVES || foundSpot->spriteIndex == BB_SKELETON)
                 {
                     // inform the tilemap of this uncached embedded entity address.
-                    entityManager->activeBooster->gameData->tilemap
-                        .fgTiles[foundSpot->pos.x >> 9][foundSpot->pos.y >> 9]
-                        .entity
-                        = foundSpot;
+                    bb_setTileEntity(&entityManager->activeBooster->gameData->tilemap, foundSpot->pos.x >> 9,
+                                     foundSpot->pos.y >> 9, foundSpot);
                 }
             }
         }
@@ -358,17 +356,15 @@ void bb_updateEntities(bb_entityManager_t* entityManager, bb_camera_t* camera)
                         case BB_SKELETON:
                         {
                             // tell the tilemap of the change in address
-                            cachedEntity->gameData->tilemap.fgTiles[cachedEntity->pos.x >> 9][cachedEntity->pos.y >> 9]
-                                .entity
-                                = cachedEntity;
+                            bb_setTileEntity(&cachedEntity->gameData->tilemap, cachedEntity->pos.x >> 9,
+                                             cachedEntity->pos.y >> 9, cachedEntity);
                             break;
                         }
                         case EGG_LEAVES:
                         {
                             // tell the tilemap of the change in address
-                            cachedEntity->gameData->tilemap.fgTiles[cachedEntity->pos.x >> 9][cachedEntity->pos.y >> 9]
-                                .entity
-                                = cachedEntity;
+                            bb_setTileEntity(&cachedEntity->gameData->tilemap, cachedEntity->pos.x >> 9,
+                                             cachedEntity->pos.y >> 9, cachedEntity);
                             break;
                         }
                         default:
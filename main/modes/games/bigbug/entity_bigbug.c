@@ -179,7 +179,7 @@ void bb_updateRocketLanding(bb_entity_t* self)
     int16_t terrainY = 0;
     for (int i = 0; i < TILE_FIELD_HEIGHT; i++)
     {
-        if (self->gameData->tilemap.fgTiles[self->pos.x >> 9][i].health)
+        if (bb_getFgHealth(&self->gameData->tilemap, self->pos.x >> 9, i))
         {
             terrainY = i << 9;
             break;
@@ -937,7 +937,7 @@ void bb_updateGarbotnikFlying(bb_entity_t* self)
                 node_t* cur  = gData->towedEntities.first;
                 while (cur != NULL)
                 {
-                    void* curNode = (bb_midgroundTileInfo_t*)cur->val;
+                    void* curNode = cur->val;
                     if (curNode == curEntity)
                     {
                         isTowed = true;
@@ -1230,21 +1230,19 @@ void bb_updateGarbotnikFlying(bb_entity_t* self)
         ///////////////////////
 
         // Update the dirt by decrementing it.
-        self->gameData->tilemap.fgTiles[hitInfo.tile_i][hitInfo.tile_j].health
-            -= self->gameData->GarbotnikStat_diggingStrength;
-        if (self->gameData->tilemap.fgTiles[hitInfo.tile_i][hitInfo.tile_j].health < 0)
+        int8_t health = bb_getFgHealth(&self->gameData->tilemap, hitInfo.tile_i, hitInfo.tile_j)
+                        - self->gameData->GarbotnikStat_diggingStrength;
+        if (health < 0)
         {
-            self->gameData->tilemap.fgTiles[hitInfo.tile_i][hitInfo.tile_j].health = 0;
+            health = 0;
         }
+        bb_setFgHealth(&self->gameData->tilemap, hitInfo.tile_i, hitInfo.tile_j, health);
 
-        bb_midgroundTileInfo_t* tile
-            = (bb_midgroundTileInfo_t*)&self->gameData->tilemap.fgTiles[hitInfo.tile_i][hitInfo.tile_j];
-
-        if (tile->health == 0 || tile->health == 1
-            || (tile->health < 5 && tile->health + self->gameData->GarbotnikStat_diggingStrength >= 5))
+        if (health == 0 || health == 1
+            || (health < 5 && health + self->gameData->GarbotnikStat_diggingStrength >= 5))
         {
             // Create a crumble
-            bb_crumbleDirt(self->gameData, 2, hitInfo.tile_i, hitInfo.tile_j, !tile->health, !tile->health);
+            bb_crumbleDirt(self->gameData, 2, hitInfo.tile_i, hitInfo.tile_j, !health, !health);
         }
         else
         {
@@ -1411,8 +1409,8 @@ void bb_updateEggLeaves(bb_entity_t* self)
                 if (hitInfo.hit == true)
                 {
                     // Update the dirt to air.
-                    self->gameData->tilemap.fgTiles[hitInfo.tile_i][hitInfo.tile_j].embed  = NOTHING_EMBED;
-                    self->gameData->tilemap.fgTiles[hitInfo.tile_i][hitInfo.tile_j].entity = NULL;
+                    bb_setEmbed(&self->gameData->tilemap, hitInfo.tile_i, hitInfo.tile_j, NOTHING_EMBED);
+                    bb_setTileEntity(&self->gameData->tilemap, hitInfo.tile_i, hitInfo.tile_j, NULL);
                     // Create a crumble
                     bb_crumbleDirt(self->gameData, 2, hitInfo.tile_i, hitInfo.tile_j, true, true);
                     midiPlayer_t* sfx = soundGetPlayerSfx();
@@ -1432,7 +1430,7 @@ void bb_updateFarEggleaves(bb_entity_t* self)
     bb_collisionCheck(&self->gameData->tilemap, self, NULL, &hitInfo);
     if (hitInfo.hit == true)
     {
-        self->gameData->tilemap.fgTiles[hitInfo.tile_i][hitInfo.tile_j].entity = NULL;
+        bb_setTileEntity(&self->gameData->tilemap, hitInfo.tile_i, hitInfo.tile_j, NULL);
     }
     else
     {
@@ -2775,7 +2773,7 @@ void bb_updateExplosion(bb_entity_t* self)
                                         (vec_t){self->pos.x >> 4, self->pos.y >> 4}))
                     < eData->radius * eData->radius)
                 {
-                    if (self->gameData->tilemap.fgTiles[checkI][checkJ].health > 0)
+                    if (bb_getFgHealth(&self->gameData->tilemap, checkI, checkJ) > 0)
                     {
                         // Update the dirt to air.
                         bb_crumbleDirt(self->gameData, bb_randomInt(2, 3), checkI, checkJ, true, true);
@@ -2879,6 +2877,13 @@ void bb_updateExplosion(bb_entity_t* self)
         }
     }
 
+    // Light up the surrounding tiles, fading out over the explosion's lifetime
+    if (eData->lifetime < 1000)
+    {
+        bb_addLight(&self->gameData->tilemap.lightMap, self->pos.x >> DECIMAL_BITS, self->pos.y >> DECIMAL_BITS,
+                    eData->radius * 3, BB_MAX_BRIGHTNESS - eData->lifetime / 200);
+    }
+
     eData->lifetime += self->gameData->elapsedUs >> 10;
     if (eData->lifetime > 1000)
     {
@@ -2965,7 +2970,7 @@ void bb_updateDrillBot(bb_entity_t* self)
         {
             int8_t direction = (dData->facingRight * 2) - 1;
             self->pos.x += direction * 8 * self->gameData->elapsedUs >> 13;
-            if (self->gameData->tilemap.fgTiles[(self->pos.x + direction * 144) >> 9][self->pos.y >> 9].health > 0)
+            if (bb_getFgHealth(&self->gameData->tilemap, (self->pos.x + direction * 144) >> 9, self->pos.y >> 9) > 0)
             {
                 if (bb_randomInt(0, 95) == 1)
                 {
@@ -3032,7 +3037,7 @@ void bb_updateSpaceLaser(bb_entity_t* self)
         // Position it at half height above the highest garbage
         for (int i = 0; i < TILE_FIELD_HEIGHT; i++)
         {
-            if (self->gameData->tilemap.fgTiles[self->pos.x >> 9][i].health > 0)
+            if (bb_getFgHealth(&self->gameData->tilemap, self->pos.x >> 9, i) > 0)
             {
                 slData->highestGarbage = i;
                 break;
@@ -3048,11 +3053,12 @@ void bb_updateSpaceLaser(bb_entity_t* self)
     if (bb_randomInt(0, 50) == 0)
     {
         // decrement the health of the tile below the laser by one
-        if (self->gameData->tilemap.fgTiles[self->pos.x >> 9][slData->highestGarbage].health)
+        if (bb_getFgHealth(&self->gameData->tilemap, self->pos.x >> 9, slData->highestGarbage))
         {
-            self->gameData->tilemap.fgTiles[self->pos.x >> 9][slData->highestGarbage].health--;
+            bb_setFgHealth(&self->gameData->tilemap, self->pos.x >> 9, slData->highestGarbage,
+                           bb_getFgHealth(&self->gameData->tilemap, self->pos.x >> 9, slData->highestGarbage) - 1);
         }
-        int8_t health = self->gameData->tilemap.fgTiles[self->pos.x >> 9][slData->highestGarbage].health;
+        int8_t health = bb_getFgHealth(&self->gameData->tilemap, self->pos.x >> 9, slData->highestGarbage);
         if (health == 1 || health == 4 || health == 10)
         {
             bb_crumbleDirt(self->gameData, 2, self->pos.x >> 9, slData->highestGarbage, false, false);
@@ -3063,7 +3069,7 @@ void bb_updateSpaceLaser(bb_entity_t* self)
             // recalculate the highest garbage
             for (int i = 0; i < TILE_FIELD_HEIGHT; i++)
             {
-                if (self->gameData->tilemap.fgTiles[self->pos.x >> 9][i].health > 0)
+                if (bb_getFgHealth(&self->gameData->tilemap, self->pos.x >> 9, i) > 0)
                 {
                     slData->highestGarbage = i;
                     break;
@@ -4394,7 +4400,7 @@ void bb_drawDrillBot(bb_entityManager_t* entityManager, rectangle_t* camera, bb_
     {
         int8_t direction = (dData->facingRight * 2) - 1;
         if (self->pos.y >= 0
-            && self->gameData->tilemap.fgTiles[(self->pos.x + direction * 144) >> 9][self->pos.y >> 9].health > 0)
+            && bb_getFgHealth(&self->gameData->tilemap, (self->pos.x + direction * 144) >> 9, self->pos.y >> 9) > 0)
         {
             drawWsg(&entityManager->sprites[self->spriteIndex].frames[((dData->lifetime >> 2) % 2) + 5],
                     (self->pos.x >> DECIMAL_BITS) - entityManager->sprites[self->spriteIndex].originX - camera->pos.x,
@@ -4593,7 +4599,7 @@ void bb_onCollisionHarpoon(bb_entity_t* self, bb_entity_t* other, bb_hitInfo_t*
         // pop that egg
         int32_t tile_i = other->pos.x >> 9; // 4 decimal bits and 5 bitshifts is divide by 32.
         int32_t tile_j = other->pos.y >> 9; // 4 decimal bits and 5 bitshifts is divide by 32.
-        if (self->gameData->tilemap.fgTiles[tile_i][tile_j].health
+        if (bb_getFgHealth(&self->gameData->tilemap, tile_i, tile_j)
             == 0) // This case is for boss eggs that are in the air.
         {
             // spawn a bug
@@ -4607,25 +4613,25 @@ void bb_onCollisionHarpoon(bb_entity_t* self, bb_entity_t* other, bb_hitInfo_t*
                 midiPlayerReset(sfx);
                 soundPlaySfx(&self->gameData->sfxEgg, 0);
 
-                if (self->gameData->tilemap.fgTiles[tile_i][tile_j].entity != NULL)
+                if (bb_getTileEntity(&self->gameData->tilemap, tile_i, tile_j) != NULL)
                 {
-                    bb_entity_t* egg
-                        = ((bb_eggLeavesData_t*)(self->gameData->tilemap.fgTiles[tile_i][tile_j].entity->data))->egg;
+                    bb_entity_t* eggLeaves = bb_getTileEntity(&self->gameData->tilemap, tile_i, tile_j);
+                    bb_entity_t* egg       = ((bb_eggLeavesData_t*)eggLeaves->data)->egg;
                     if (egg != NULL)
                     {
                         // destroy the egg
                         bb_destroyEntity(egg, false, true);
                     }
                     // destroy this (eggLeaves)
-                    bb_destroyEntity(self->gameData->tilemap.fgTiles[tile_i][tile_j].entity, false, true);
+                    bb_destroyEntity(bb_getTileEntity(&self->gameData->tilemap, tile_i, tile_j), false, true);
                 }
-                self->gameData->tilemap.fgTiles[tile_i][tile_j].embed = NOTHING_EMBED;
+                bb_setEmbed(&self->gameData->tilemap, tile_i, tile_j, NOTHING_EMBED);
             }
             bb_crumbleDirt(other->gameData, 2, tile_i, tile_j, true, true);
         }
         else
         {
-            self->gameData->tilemap.fgTiles[tile_i][tile_j].health = 0;
+            bb_setFgHealth(&self->gameData->tilemap, tile_i, tile_j, 0);
             bb_crumbleDirt(other->gameData, 2, tile_i, tile_j, true, true);
         }
         // destroy this harpoon
@@ -4974,9 +4980,9 @@ void bb_onCollisionJankyBugDig(bb_entity_t* self, bb_entity_t* other, bb_hitInfo
             break;
         }
     }
-    if (self->gameData->tilemap.fgTiles[tilePos.x][tilePos.y].health > 0)
+    if (bb_getFgHealth(&self->gameData->tilemap, tilePos.x, tilePos.y) > 0)
     {
-        self->gameData->tilemap.fgTiles[tilePos.x][tilePos.y].health = 0;
+        bb_setFgHealth(&self->gameData->tilemap, tilePos.x, tilePos.y, 0);
         bb_crumbleDirt(self->gameData, 2, tilePos.x, tilePos.y, true, true);
     }
     self->pos.x = (tilePos.x << 9) + (16 << DECIMAL_BITS);
@@ -6060,11 +6066,11 @@ void bb_spawnHorde(bb_entity_t* self, uint8_t numBugs)
                 if (spawnPos.x - 1 >= 0 && spawnPos.y - 1 >= 0 && spawnPos.x + 1 < TILE_FIELD_WIDTH
                     && spawnPos.y + 1 < TILE_FIELD_HEIGHT)
                 {
-                    if (self->gameData->tilemap.fgTiles[spawnPos.x][spawnPos.y].health > 0
-                        && self->gameData->tilemap.fgTiles[spawnPos.x - 1][spawnPos.y].health > 0
-                        && self->gameData->tilemap.fgTiles[spawnPos.x][spawnPos.y - 1].health > 0
-                        && self->gameData->tilemap.fgTiles[spawnPos.x + 1][spawnPos.y].health > 0
-                        && self->gameData->tilemap.fgTiles[spawnPos.x][spawnPos.y + 1].health > 0)
+                    if (bb_getFgHealth(&self->gameData->tilemap, spawnPos.x, spawnPos.y) > 0
+                        && bb_getFgHealth(&self->gameData->tilemap, spawnPos.x - 1, spawnPos.y) > 0
+                        && bb_getFgHealth(&self->gameData->tilemap, spawnPos.x, spawnPos.y - 1) > 0
+                        && bb_getFgHealth(&self->gameData->tilemap, spawnPos.x + 1, spawnPos.y) > 0
+                        && bb_getFgHealth(&self->gameData->tilemap, spawnPos.x, spawnPos.y + 1) > 0)
                     {
                         consecutiveGarbage++;
                     }
@@ -6155,10 +6161,8 @@ void bb_spawnHorde(bb_entity_t* self, uint8_t numBugs)
     {
         if (cData->jankyBugDig[jankyBugDigIdx] != NULL)
         {
-            self->gameData->tilemap
-                .fgTiles[cData->jankyBugDig[jankyBugDigIdx]->pos.x >> 9][cData->jankyBugDig[jankyBugDigIdx]->pos.y >> 9]
-                .health
-                = 0;
+            bb_setFgHealth(&self->gameData->tilemap, cData->jankyBugDig[jankyBugDigIdx]->pos.x >> 9,
+                           cData->jankyBugDig[jankyBugDigIdx]->pos.y >> 9, 0);
         }
     }
 }
@@ -6284,12 +6288,12 @@ void bb_crumbleDirt(bb_gameData_t* gameData, uint8_t gameFramesPerAnimationFrame
 
     if (zeroHealth)
     {
-        gameData->tilemap.fgTiles[tile_i][tile_j].health = 0;
+        bb_setFgHealth(&gameData->tilemap, tile_i, tile_j, 0);
         if (flagNeighborsForPathfinding)
         {
-            flagNeighbors((bb_midgroundTileInfo_t*)&gameData->tilemap.fgTiles[tile_i][tile_j], gameData);
+            flagNeighbors(tile_i, tile_j, gameData);
         }
-        switch (gameData->tilemap.fgTiles[tile_i][tile_j].embed)
+        switch (bb_getEmbed(&gameData->tilemap, tile_i, tile_j))
         {
             case EGG_EMBED:
             {
@@ -6304,27 +6308,27 @@ void bb_crumbleDirt(bb_gameData_t* gameData, uint8_t gameFramesPerAnimationFrame
                     midiPlayerReset(sfx);
                     soundPlaySfx(&gameData->sfxEgg, 0);
 
-                    if (gameData->tilemap.fgTiles[tile_i][tile_j].entity != NULL)
+                    if (bb_getTileEntity(&gameData->tilemap, tile_i, tile_j) != NULL)
                     {
                         bb_entity_t* egg
-                            = ((bb_eggLeavesData_t*)(gameData->tilemap.fgTiles[tile_i][tile_j].entity->data))->egg;
+                            = ((bb_eggLeavesData_t*)(bb_getTileEntity(&gameData->tilemap, tile_i, tile_j)->data))->egg;
                         if (egg != NULL)
                         {
                             // destroy the egg
                             bb_destroyEntity(egg, false, true);
                         }
                         // destroy this (eggLeaves)
-                        bb_destroyEntity(gameData->tilemap.fgTiles[tile_i][tile_j].entity, false, true);
+                        bb_destroyEntity(bb_getTileEntity(&gameData->tilemap, tile_i, tile_j), false, true);
                     }
-                    gameData->tilemap.fgTiles[tile_i][tile_j].embed = NOTHING_EMBED;
+                    bb_setEmbed(&gameData->tilemap, tile_i, tile_j, NOTHING_EMBED);
                 }
                 break;
             }
             case SKELETON_EMBED:
             {
                 vec_t tilePos = {.x = tile_i * TILE_SIZE + HALF_TILE, .y = tile_j * TILE_SIZE + HALF_TILE};
-                bb_destroyEntity(gameData->tilemap.fgTiles[tile_i][tile_j].entity, false, true);
-                gameData->tilemap.fgTiles[tile_i][tile_j].embed = NOTHING_EMBED;
+                bb_destroyEntity(bb_getTileEntity(&gameData->tilemap, tile_i, tile_j), false, true);
+                bb_setEmbed(&gameData->tilemap, tile_i, tile_j, NOTHING_EMBED);
 
                 // create fuel
                 bb_ensureEntitySpace(&gameData->entityManager, 1);
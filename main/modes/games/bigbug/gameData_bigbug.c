@@ -55,8 +55,13 @@ void bb_initializeGameData(bb_gameData_t* gameData)
     loadFont("tiny_numbers.font", &gameData->tinyNumbersFont, false);
     loadFont("seven_segment.font", &gameData->sevenSegmentFont, false);
 
+    // Crumbling pushes and pops a lot of nodes every frame, so draw them from a pool instead of the heap
+    listPoolInit(&gameData->nodePool, 128, MALLOC_CAP_8BIT);
     memset(&gameData->pleaseCheck, 0, sizeof(list_t));
     memset(&gameData->unsupported, 0, sizeof(list_t));
+    gameData->pleaseCheck.pool = &gameData->nodePool;
+    gameData->unsupported.pool = &gameData->nodePool;
+    gameData->heapNodeAllocs   = listHeapNodeAllocs();
 
     // Palette setup
     wsgPaletteReset(&gameData->damagePalette);
@@ -208,6 +213,10 @@ void bb_freeGameData(bb_gameData_t* gameData)
     {
         heap_caps_free(shift(&gameData->pleaseCheck));
     }
+    listPoolLog(&gameData->nodePool, "bigbug");
+    ESP_LOGI("LIST", "bigbug: %" PRIu32 " nodes allocated individually from the heap",
+             listHeapNodeAllocs() - gameData->heapNodeAllocs);
+    listPoolDeinit(&gameData->nodePool);
     if (gameData->loadoutScreenData != NULL)
     {
         heap_caps_free(gameData->loadoutScreenData);
@@ -172,8 +172,10 @@ struct bb_gameData_t
 
     int8_t neighbors[4][2]; // a handy table of left, up, right, and down offsets
 
-    list_t pleaseCheck; // a list of tiles to check if they are supported.
-    list_t unsupported; // a list of tiles that flood-fill crumble.
+    listPool_t nodePool;     // nodes for the crumble lists and pathfinding, freed all at once when the mode exits
+    uint32_t heapNodeAllocs; // listHeapNodeAllocs() when the mode started, to log the list nodes allocated since
+    list_t pleaseCheck;      // a list of tiles to check if they are supported.
+    list_t unsupported;      // a list of tiles that flood-fill crumble.
 
     font_t font;
     font_t tinyNumbersFont;
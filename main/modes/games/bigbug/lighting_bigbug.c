@@ -1,6 +1,7 @@
 //==============================================================================
 // Includes
 //==============================================================================
+#include <stdlib.h>
 #include "lighting_bigbug.h"
 
 //==============================================================================
@@ -134,4 +135,137 @@ inline uint8_t bb_foregroundLighting(wsg_t* headlampWsg, vec_t* lookup, int32_t*
     }
 
     return brightness;
-}
\ No newline at end of file
+}
+
+/**
+ * @brief Add a point light for the next light map update. Lights only last one update, so they should be added every
+ * frame they are lit.
+ *
+ * @param lightMap The light map
+ * @param x The center of the light, in world pixels
+ * @param y The center of the light, in world pixels
+ * @param radius The radius of the light, in pixels
+ * @param intensity The brightness added at the center of the light
+ */
+void bb_addLight(bb_lightMap_t* lightMap, int32_t x, int32_t y, uint16_t radius, uint8_t intensity)
+{
+    if (lightMap->numLights < BB_MAX_LIGHTS && radius > 0 && intensity > 0)
+    {
+        lightMap->lights[lightMap->numLights++] = (bb_pointLight_t){
+            .x         = x,
+            .y         = y,
+            .radius    = radius,
+            .intensity = intensity,
+        };
+    }
+}
+
+/**
+ * @brief Update the light map for the tiles on screen, if anything that lights them changed
+ *
+ * @param lightMap The light map
+ * @param headlampWsg The headlamp lookup texture
+ * @param iStart The first tile column on screen
+ * @param iEnd The last tile column on screen
+ * @param jStart The first tile row on screen
+ * @param jEnd The last tile row on screen
+ * @param garbotnikPos Garbotnik's draw position in the world, in pixels
+ * @param garbotnikRotation Garbotnik's rotation
+ * @param headlampOn true if the headlamp lights the tiles, false if only depth and point lights do
+ */
+void bb_updateLightMap(bb_lightMap_t* lightMap, wsg_t* headlampWsg, int16_t iStart, int16_t iEnd, int16_t jStart,
+                       int16_t jEnd, const vec_t* garbotnikPos, int32_t garbotnikRotation, bool headlampOn)
+{
+    // Don't go past the end of the map
+    if (iEnd - iStart + 1 > BB_LIGHT_COLS / 2)
+    {
+        iEnd = iStart + BB_LIGHT_COLS / 2 - 1;
+    }
+    if (jEnd - jStart + 1 > BB_LIGHT_ROWS / 2)
+    {
+        jEnd = jStart + BB_LIGHT_ROWS / 2 - 1;
+    }
+
+    bool dirty = !lightMap->valid || lightMap->iStart != iStart || lightMap->iEnd != iEnd
+                 || lightMap->jStart != jStart || lightMap->jEnd != jEnd || lightMap->headlampOn != headlampOn
+                 || lightMap->numLights || lightMap->numLitLights;
+    if (headlampOn)
+    {
+        dirty = dirty || lightMap->garbotnikPos.x != garbotnikPos->x || lightMap->garbotnikPos.y != garbotnikPos->y
+                || abs(lightMap->garbotnikRotation - garbotnikRotation) >= BB_LIGHT_ROTATION_THRESHOLD;
+    }
+
+    if (!dirty)
+    {
+        return;
+    }
+
+    lightMap->iStart       = iStart;
+    lightMap->iEnd         = iEnd;
+    lightMap->jStart       = jStart;
+    lightMap->jEnd         = jEnd;
+    lightMap->headlampOn   = headlampOn;
+    lightMap->garbotnikPos = *garbotnikPos;
+    // Light with the rotation the headlamp was last computed at, so small turns don't accumulate
+    if (abs(lightMap->garbotnikRotation - garbotnikRotation) >= BB_LIGHT_ROTATION_THRESHOLD || !lightMap->valid)
+    {
+        lightMap->garbotnikRotation = garbotnikRotation;
+    }
+    lightMap->valid = true;
+
+    for (int32_t j = jStart; j <= jEnd; j++)
+    {
+        // Deeper tiles are darker
+        uint8_t depthBrightness = BB_MAX_BRIGHTNESS - (j > 25 ? 25 : j) / 5;
+
+        for (int32_t i = iStart; i <= iEnd; i++)
+        {
+            // Where the top left quadrant samples the headlamp texture
+            vec_t tileLookup = {i * TILE_SIZE + 8 - (garbotnikPos->x + 18) + headlampWsg->w,
+                                j * TILE_SIZE + 8 - (garbotnikPos->y + 17) + headlampWsg->h};
+            tileLookup       = divVec2d(tileLookup, 2);
+
+            for (int32_t qy = 0; qy < 2; qy++)
+            {
+                for (int32_t qx = 0; qx < 2; qx++)
+                {
+                    int32_t row = 2 * (j - jStart) + qy;
+                    int32_t col = 2 * (i - iStart) + qx;
+
+                    int32_t mg = depthBrightness;
+                    int32_t fg = 0;
+                    if (headlampOn)
+                    {
+                        vec_t lookup = {tileLookup.x + 8 * qx, tileLookup.y + 8 * qy};
+                        mg = bb_midgroundLighting(headlampWsg, &lookup, &lightMap->garbotnikRotation, mg);
+                        fg = bb_foregroundLighting(headlampWsg, &lookup, &lightMap->garbotnikRotation);
+                    }
+
+                    // Add the point lights, measured at the quadrant's center
+                    int32_t cx = i * TILE_SIZE + qx * HALF_TILE + HALF_TILE / 2;
+                    int32_t cy = j * TILE_SIZE + qy * HALF_TILE + HALF_TILE / 2;
+                    for (int32_t l = 0; l < lightMap->numLights; l++)
+                    {
+                        const bb_pointLight_t* light = &lightMap->lights[l];
+                        int32_t dx                   = cx - light->x;
+                        int32_t dy                   = cy - light->y;
+                        int32_t sqDist               = dx * dx + dy * dy;
+                        int32_t sqRadius             = light->radius * light->radius;
+                        if (sqDist < sqRadius)
+                        {
+                            int32_t add = (light->intensity * (sqRadius - sqDist)) / sqRadius;
+                            mg += add;
+                            fg += add;
+                        }
+                    }
+
+                    lightMap->mg[row][col] = mg > BB_MAX_BRIGHTNESS ? BB_MAX_BRIGHTNESS : mg;
+                    lightMap->fg[row][col] = fg > BB_MAX_BRIGHTNESS ? BB_MAX_BRIGHTNESS : fg;
+                }
+            }
+        }
+    }
+
+    lightMap->numLitLights = lightMap->numLights;
+    lightMap->numLights    = 0;
+}
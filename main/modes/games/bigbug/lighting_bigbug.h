@@ -7,8 +7,61 @@
 #include "vector2d.h"
 #include "entityManager_bigbug.h"
 #include "wsg.h"
+#include "typedef_bigbug.h"
 #include <stdint.h>
 
+//==============================================================================
+// Constants
+//==============================================================================
+#define BB_MAX_BRIGHTNESS 5 // The brightest pre-shaded tile
+
+// The light map has a cell for each quadrant of each tile which may be on screen
+#define BB_LIGHT_COLS (2 * (TFT_WIDTH / TILE_SIZE + 2))
+#define BB_LIGHT_ROWS (2 * (TFT_HEIGHT / TILE_SIZE + 2))
+
+#define BB_MAX_LIGHTS 8 // The most point lights in one frame
+
+// How far Garbotnik has to turn before the headlamp is recomputed. Turning less shifts the headlamp under a pixel.
+#define BB_LIGHT_ROTATION_THRESHOLD 12
+
+//==============================================================================
+// Structs
+//==============================================================================
+
+/**
+ * @brief A light which brightens the tiles around it for one frame, such as an explosion
+ */
+typedef struct
+{
+    int32_t x;         ///< The center, in world pixels
+    int32_t y;         ///< The center, in world pixels
+    uint16_t radius;   ///< The radius, in pixels
+    uint8_t intensity; ///< The brightness added at the center, fading to nothing at the radius
+} bb_pointLight_t;
+
+/**
+ * @brief The brightness of every tile quadrant on screen. It is recomputed when the visible tiles, Garbotnik's
+ * position or rotation, or any point lights change, and tile draws look brightness up from it.
+ */
+typedef struct
+{
+    uint8_t mg[BB_LIGHT_ROWS][BB_LIGHT_COLS]; ///< Midground brightness of each quadrant
+    uint8_t fg[BB_LIGHT_ROWS][BB_LIGHT_COLS]; ///< Foreground brightness of each quadrant
+    int16_t iStart;                           ///< The first tile column in the map
+    int16_t jStart;                           ///< The first tile row in the map
+    int16_t iEnd;                             ///< The last tile column in the map
+    int16_t jEnd;                             ///< The last tile row in the map
+    bool valid;                               ///< false if the map must be recomputed
+
+    vec_t garbotnikPos;        ///< Garbotnik's world position the headlamp was computed at
+    int32_t garbotnikRotation; ///< Garbotnik's rotation the headlamp was computed at
+    bool headlampOn;           ///< Whether the headlamp was on
+
+    bb_pointLight_t lights[BB_MAX_LIGHTS]; ///< Point lights added since the map was last updated
+    uint8_t numLights;                     ///< The number of lights added since the map was last updated
+    uint8_t numLitLights;                  ///< The number of lights in the current map
+} bb_lightMap_t;
+
 //==============================================================================
 // Prototypes
 //==============================================================================
@@ -16,4 +69,42 @@ uint8_t bb_midgroundLighting(wsg_t* headlampWsg, vec_t* lookup, int32_t* garbotn
 
 uint8_t bb_foregroundLighting(wsg_t* headlampWsg, vec_t* lookup, int32_t* garbotnikRotation);
 
+void bb_addLight(bb_lightMap_t* lightMap, int32_t x, int32_t y, uint16_t radius, uint8_t intensity);
+void bb_updateLightMap(bb_lightMap_t* lightMap, wsg_t* headlampWsg, int16_t iStart, int16_t iEnd, int16_t jStart,
+                       int16_t jEnd, const vec_t* garbotnikPos, int32_t garbotnikRotation, bool headlampOn);
+
+//==============================================================================
+// Inline Functions
+//==============================================================================
+
+/**
+ * @brief Look up the midground brightness of a tile quadrant. The tile must be in the range the map was updated for.
+ *
+ * @param lightMap The light map
+ * @param i The tile's column
+ * @param j The tile's row
+ * @param qx 0 for the left quadrants, 1 for the right
+ * @param qy 0 for the top quadrants, 1 for the bottom
+ * @return The brightness, 0 through ::BB_MAX_BRIGHTNESS
+ */
+static inline uint8_t bb_getMidgroundLight(const bb_lightMap_t* lightMap, int32_t i, int32_t j, int32_t qx, int32_t qy)
+{
+    return lightMap->mg[2 * (j - lightMap->jStart) + qy][2 * (i - lightMap->iStart) + qx];
+}
+
+/**
+ * @brief Look up the foreground brightness of a tile quadrant. The tile must be in the range the map was updated for.
+ *
+ * @param lightMap The light map
+ * @param i The tile's column
+ * @param j The tile's row
+ * @param qx 0 for the left quadrants, 1 for the right
+ * @param qy 0 for the top quadrants, 1 for the bottom
+ * @return The brightness, 0 through ::BB_MAX_BRIGHTNESS
+ */
+static inline uint8_t bb_getForegroundLight(const bb_lightMap_t* lightMap, int32_t i, int32_t j, int32_t qx, int32_t qy)
+{
+    return lightMap->fg[2 * (j - lightMap->jStart) + qy][2 * (i - lightMap->iStart) + qx];
+}
+
 #endif
\ No newline at end of file
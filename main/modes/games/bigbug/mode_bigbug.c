@@ -138,13 +138,14 @@ static void bb_EnterMode(void)
     // Allocate memory for the game state
     bigbug = heap_caps_calloc_tag(1, sizeof(bb_t), MALLOC_CAP_SPIRAM, "bigbug");
 
-    // calloc the columns in layers separately to avoid a big alloc
-    for (int32_t w = 0; w < TILE_FIELD_WIDTH; w++)
+    // Allocate the tiles, in chunks which are paged in around the camera. The game can't run without them, so go back
+    // to the main menu if they can't be allocated
+    if (NULL == bigbug || !bb_initTileStorage(&bigbug->gameData.tilemap))
     {
-        bigbug->gameData.tilemap.fgTiles[w]
-            = heap_caps_calloc_tag(TILE_FIELD_HEIGHT, sizeof(bb_foregroundTileInfo_t), MALLOC_CAP_SPIRAM, "fgTile");
-        bigbug->gameData.tilemap.mgTiles[w]
-            = heap_caps_calloc_tag(TILE_FIELD_HEIGHT, sizeof(bb_midgroundTileInfo_t), MALLOC_CAP_SPIRAM, "mgTiles");
+        heap_caps_free(bigbug);
+        bigbug = NULL;
+        switchToSwadgeMode(&mainMenuMode);
+        return;
     }
 
     // Allocate WSG loading helpers
@@ -219,13 +220,14 @@ static void bb_EnterModeSkipIntro(void)
     // Allocate memory for the game state
     bigbug = heap_caps_calloc(1, sizeof(bb_t), MALLOC_CAP_SPIRAM);
 
-    // calloc the columns in layers separately to avoid a big alloc
-    for (int32_t w = 0; w < TILE_FIELD_WIDTH; w++)
+    // Allocate the tiles, in chunks which are paged in around the camera. The game can't run without them, so go back
+    // to the main menu if they can't be allocated
+    if (NULL == bigbug || !bb_initTileStorage(&bigbug->gameData.tilemap))
     {
-        bigbug->gameData.tilemap.fgTiles[w]
-            = heap_caps_calloc(TILE_FIELD_HEIGHT, sizeof(bb_foregroundTileInfo_t), MALLOC_CAP_SPIRAM);
-        bigbug->gameData.tilemap.mgTiles[w]
-            = heap_caps_calloc(TILE_FIELD_HEIGHT, sizeof(bb_midgroundTileInfo_t), MALLOC_CAP_SPIRAM);
+        heap_caps_free(bigbug);
+        bigbug = NULL;
+        switchToSwadgeMode(&mainMenuMode);
+        return;
     }
 
     // Allocate WSG loading helpers
@@ -351,11 +353,7 @@ void bb_setupMidi(void)
 
 void bb_FreeTilemapData(void)
 {
-    for (int32_t w = 0; w < TILE_FIELD_WIDTH; w++)
-    {
-        heap_caps_free(bigbug->gameData.tilemap.fgTiles[w]);
-        heap_caps_free(bigbug->gameData.tilemap.mgTiles[w]);
-    }
+    bb_deinitTileStorage(&bigbug->gameData.tilemap);
 
     while (bigbug->gameData.pleaseCheck.first != NULL)
     {
@@ -372,6 +370,12 @@ void bb_FreeTilemapData(void)
 
 static void bb_ExitMode(void)
 {
+    // Nothing was loaded if entering the mode failed
+    if (NULL == bigbug)
+    {
+        return;
+    }
+
     soundStop(true);
     heatshrink_decoder_free(bb_hsd);
     heap_caps_free(bb_decodeSpace);
@@ -404,6 +408,12 @@ static void bb_ExitMode(void)
 
 static void bb_MainLoop(int64_t elapsedUs)
 {
+    // Entering the mode failed, wait for the switch back to the main menu
+    if (NULL == bigbug)
+    {
+        return;
+    }
+
     // Save the elapsed time
     bigbug->gameData.elapsedUs = elapsedUs;
 
@@ -471,6 +481,11 @@ static void bb_BackgroundDrawCallbackBlack(int16_t x, int16_t y, int16_t w, int1
 
 static void bb_BackgroundDrawCallback(int16_t x, int16_t y, int16_t w, int16_t h, int16_t up, int16_t upNum)
 {
+    if (NULL == bigbug)
+    {
+        return;
+    }
+
     // Convenience camera pointer
     vec_t* cameraPos = &bigbug->gameData.camera.camera.pos;
 
@@ -599,25 +614,25 @@ static void bb_DrawScene_Radar(void)
         int16_t yMax = CLAMP(yMin + FIELD_HEIGHT / 4, 0, TILE_FIELD_HEIGHT);
         for (int yIdx = yMin; yIdx < yMax; yIdx++)
         {
-            uint16_t radarTileColor = bigbug->gameData.tilemap.fgTiles[xIdx][yIdx].health > 0 ? c333 : c000;
+            uint16_t radarTileColor = bb_getFgHealth(&bigbug->gameData.tilemap, xIdx, yIdx) > 0 ? c333 : c000;
             if ((bigbug->gameData.radar.upgrades >> BIGBUG_GARBAGE_DENSITY) & 1)
             {
-                if (bigbug->gameData.tilemap.fgTiles[xIdx][yIdx].health > 0
-                    && bigbug->gameData.tilemap.fgTiles[xIdx][yIdx].health < 4)
+                if (bb_getFgHealth(&bigbug->gameData.tilemap, xIdx, yIdx) > 0
+                    && bb_getFgHealth(&bigbug->gameData.tilemap, xIdx, yIdx) < 4)
                 {
                     radarTileColor = c222;
                 }
-                else if (bigbug->gameData.tilemap.fgTiles[xIdx][yIdx].health > 3
-                         && bigbug->gameData.tilemap.fgTiles[xIdx][yIdx].health < 10)
+                else if (bb_getFgHealth(&bigbug->gameData.tilemap, xIdx, yIdx) > 3
+                         && bb_getFgHealth(&bigbug->gameData.tilemap, xIdx, yIdx) < 10)
                 {
                     radarTileColor = c333;
                 }
-                else if (bigbug->gameData.tilemap.fgTiles[xIdx][yIdx].health > 9
-                         && bigbug->gameData.tilemap.fgTiles[xIdx][yIdx].health < 100)
+                else if (bb_getFgHealth(&bigbug->gameData.tilemap, xIdx, yIdx) > 9
+                         && bb_getFgHealth(&bigbug->gameData.tilemap, xIdx, yIdx) < 100)
                 {
                     radarTileColor = c444;
                 }
-                else if (bigbug->gameData.tilemap.fgTiles[xIdx][yIdx].health > 99)
+                else if (bb_getFgHealth(&bigbug->gameData.tilemap, xIdx, yIdx) > 99)
                 {
                     radarTileColor = c555;
                 }
@@ -636,28 +651,28 @@ static void bb_DrawScene_Radar(void)
         {
             if ((bigbug->gameData.radar.upgrades >> BIGBUG_ENEMIES) & 1)
             {
-                if (bigbug->gameData.tilemap.fgTiles[xIdx][yIdx].embed == EGG_EMBED)
+                if (bb_getEmbed(&bigbug->gameData.tilemap, xIdx, yIdx) == EGG_EMBED)
                 {
                     drawCircleFilled(xIdx * 4 - 2, yIdx * 4 - bigbug->gameData.radar.cam.y, 1, c500);
                 }
             }
             if ((bigbug->gameData.radar.upgrades >> BIGBUG_FUEL) & 1)
             {
-                if (bigbug->gameData.tilemap.fgTiles[xIdx][yIdx].embed == SKELETON_EMBED)
+                if (bb_getEmbed(&bigbug->gameData.tilemap, xIdx, yIdx) == SKELETON_EMBED)
                 {
                     drawCircleFilled(xIdx * 4 - 2, yIdx * 4 - bigbug->gameData.radar.cam.y, 2, c050);
                 }
             }
             if ((bigbug->gameData.radar.upgrades >> BIGBUG_POINTS_OF_INTEREST) & 1)
             {
-                if (bigbug->gameData.tilemap.fgTiles[xIdx][yIdx].embed == BB_CAR_WITH_DONUT_EMBED
-                    || bigbug->gameData.tilemap.fgTiles[xIdx][yIdx].embed == BB_FOOD_CART_WITH_DONUT_EMBED)
+                if (bb_getEmbed(&bigbug->gameData.tilemap, xIdx, yIdx) == BB_CAR_WITH_DONUT_EMBED
+                    || bb_getEmbed(&bigbug->gameData.tilemap, xIdx, yIdx) == BB_FOOD_CART_WITH_DONUT_EMBED)
                 {
                     drawWsgSimple(&bigbug->gameData.entityManager.sprites[BB_DONUT].frames[0], xIdx * 4 - 15,
                                   yIdx * 4 - bigbug->gameData.radar.cam.y - 6);
                 }
-                if (bigbug->gameData.tilemap.fgTiles[xIdx][yIdx].embed == BB_CAR_WITH_SWADGE_EMBED
-                    || bigbug->gameData.tilemap.fgTiles[xIdx][yIdx].embed == BB_FOOD_CART_WITH_SWADGE_EMBED)
+                if (bb_getEmbed(&bigbug->gameData.tilemap, xIdx, yIdx) == BB_CAR_WITH_SWADGE_EMBED
+                    || bb_getEmbed(&bigbug->gameData.tilemap, xIdx, yIdx) == BB_FOOD_CART_WITH_SWADGE_EMBED)
                 {
                     drawWsgSimple(&bigbug->gameData.entityManager.sprites[BB_HOTDOG].frames[0], xIdx * 4 - 15,
                                   yIdx * 4 - bigbug->gameData.radar.cam.y - 6);
@@ -1651,6 +1666,9 @@ static void bb_GameLoop(int64_t elapsedUs)
         }
     }
 
+    // Keep the tiles around the camera in internal RAM
+    bb_pageTileChunks(&bigbug->gameData.tilemap, &bigbug->gameData.camera.camera);
+
     bb_updateEntities(&(bigbug->gameData.entityManager), &(bigbug->gameData.camera));
 
     // If the game is not paused, do game logic
@@ -1722,16 +1740,13 @@ static void bb_UpdateTileSupport(void)
     while (bigbug->gameData.pleaseCheck.first != NULL)
     {
         uint8_t* shiftedVal = (uint8_t*)shift(&bigbug->gameData.pleaseCheck);
-        if ((shiftedVal[2] ? bigbug->gameData.tilemap.fgTiles[shiftedVal[0]][shiftedVal[1]].health
-                           : bigbug->gameData.tilemap.mgTiles[shiftedVal[0]][shiftedVal[1]].health)
-            > 0)
+        // Neighbors off the edge of the field are flagged too, skip them
+        if (shiftedVal[0] < TILE_FIELD_WIDTH && shiftedVal[1] < TILE_FIELD_HEIGHT
+            && bb_getHealth(&bigbug->gameData.tilemap, shiftedVal[0], shiftedVal[1], shiftedVal[2]) > 0)
         {
             // pathfind
-            if (!(shiftedVal[2] ? pathfindToPerimeter(
-                      (bb_midgroundTileInfo_t*)&bigbug->gameData.tilemap.fgTiles[shiftedVal[0]][shiftedVal[1]],
-                      &bigbug->gameData.tilemap)
-                                : pathfindToPerimeter(&bigbug->gameData.tilemap.mgTiles[shiftedVal[0]][shiftedVal[1]],
-                                                      &bigbug->gameData.tilemap)))
+            if (!pathfindToPerimeter(BB_TILE_POS(shiftedVal[0], shiftedVal[1], shiftedVal[2]),
+                                     &bigbug->gameData.tilemap, &bigbug->gameData.nodePool))
             {
                 // trigger a cascading collapse
                 uint8_t* val = heap_caps_calloc(3, sizeof(uint8_t), MALLOC_CAP_SPIRAM);
@@ -1756,18 +1771,16 @@ static void bb_UpdateTileSupport(void)
             // remove the first item from the list
             uint8_t* shiftedVal = (uint8_t*)shift(&bigbug->gameData.unsupported);
             // check that it's still dirt, because a previous pass may have crumbled it.
-            if ((shiftedVal[2] ? bigbug->gameData.tilemap.fgTiles[shiftedVal[0]][shiftedVal[1]].health
-                               : bigbug->gameData.tilemap.mgTiles[shiftedVal[0]][shiftedVal[1]].health)
-                > 0)
+            if (bb_getHealth(&bigbug->gameData.tilemap, shiftedVal[0], shiftedVal[1], shiftedVal[2]) > 0)
             {
                 // set it to air
                 if (shiftedVal[2])
                 {
-                    bigbug->gameData.tilemap.fgTiles[shiftedVal[0]][shiftedVal[1]].health = 0;
+                    bb_setFgHealth(&bigbug->gameData.tilemap, shiftedVal[0], shiftedVal[1], 0);
                 }
                 else
                 {
-                    bigbug->gameData.tilemap.mgTiles[shiftedVal[0]][shiftedVal[1]].health = 0;
+                    bb_setMgHealth(&bigbug->gameData.tilemap, shiftedVal[0], shiftedVal[1], 0);
                 }
 
                 if (bigbug->gameData.entityManager.activeEntities < MAX_ENTITIES)
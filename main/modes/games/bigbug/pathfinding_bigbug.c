@@ -9,36 +9,42 @@
 // Functions
 //==============================================================================
 // static inline function to get bits 0-6 of pos
-static inline uint8_t getX(const bb_midgroundTileInfo_t* tile)
+static inline uint8_t getX(uint16_t pos)
 {
-    return tile->pos & 0x7F;
+    return pos & 0x7F;
 }
 
 // static inline function to get bits 7-14 of pos
-static inline uint8_t getY(const bb_midgroundTileInfo_t* tile)
+static inline uint8_t getY(uint16_t pos)
 {
-    return (tile->pos >> 7) & 0xFF;
+    return (pos >> 7) & 0xFF;
 }
 
 // static inline function to get bit 15 of pos
-static inline bool getZ(const bb_midgroundTileInfo_t* tile)
+static inline bool getZ(uint16_t pos)
 {
-    return (tile->pos >> 15) & 0x1;
+    return (pos >> 15) & 0x1;
 }
 
-static inline uint16_t fCost(const bb_midgroundTileInfo_t* tile)
+static inline uint16_t fCost(const bb_tilemap_t* tilemap, uint16_t pos)
 {
-    return tile->gCost + tile->hCost;
+    return tilemap->gCosts[bb_tileCostIdx(pos)] + tilemap->hCosts[bb_tileCostIdx(pos)];
+}
+
+// Nodes in the lists are packed positions, stored in the pointer itself
+static inline uint16_t nodePos(const node_t* node)
+{
+    return (uint16_t)(uintptr_t)node->val;
 }
 
 // Returns True if the node is one of the pieces near the edge of the level (where player can't traverse).
 // functions as my target nodes all down the sides which offer grounded stability to tiles.
-bool isPerimeterNode(const bb_midgroundTileInfo_t* tile)
+bool isPerimeterNode(uint16_t tile)
 {
     return getX(tile) == 4 || getX(tile) == TILE_FIELD_WIDTH - 5 || getY(tile) == TILE_FIELD_HEIGHT - 5;
 }
 
-void getNeighbors(const bb_midgroundTileInfo_t* tile, list_t* neighbors, bb_tilemap_t* tilemap)
+void getNeighbors(uint16_t tile, list_t* neighbors, bb_tilemap_t* tilemap)
 {
     // left neighbor
     uint16_t neighborX = getX(tile) - 1;
@@ -50,13 +56,11 @@ void getNeighbors(const bb_midgroundTileInfo_t* tile, list_t* neighbors, bb_tile
     {
         if (neighborX < TILE_FIELD_WIDTH && neighborY < TILE_FIELD_HEIGHT)
         {
-            bb_midgroundTileInfo_t* neighbor = neighborZ
-                                                   ? (bb_midgroundTileInfo_t*)&tilemap->fgTiles[neighborX][neighborY]
-                                                   : &tilemap->mgTiles[neighborX][neighborY];
-            neighbor->gCost                  = 0;
-            neighbor->hCost                  = 0;
+            uint16_t neighbor                          = BB_TILE_POS(neighborX, neighborY, neighborZ);
+            tilemap->gCosts[bb_tileCostIdx(neighbor)] = 0;
+            tilemap->hCosts[bb_tileCostIdx(neighbor)] = 0;
             // neighbor->parent = NULL;
-            push(neighbors, (void*)neighbor);
+            push(neighbors, (void*)(uintptr_t)neighbor);
         }
 
         // moves checkers to another orthogonal neighbor.
@@ -93,13 +97,12 @@ void getNeighbors(const bb_midgroundTileInfo_t* tile, list_t* neighbors, bb_tile
     }
 }
 
-bool contains(const list_t* nodeList, const bb_midgroundTileInfo_t* tile)
+bool contains(const list_t* nodeList, uint16_t tile)
 {
     node_t* cur = nodeList->first;
     while (cur != NULL)
     {
-        bb_midgroundTileInfo_t* curNode = (bb_midgroundTileInfo_t*)cur->val;
-        if (getX(tile) == getX(curNode) && getY(tile) == getY(curNode) && getZ(tile) == getZ(curNode))
+        if (tile == nodePos(cur))
         {
             return true;
         }
@@ -110,29 +113,30 @@ bool contains(const list_t* nodeList, const bb_midgroundTileInfo_t* tile)
 
 // Returns True if there is a way to the perimeter
 // start[0]=x;start[1]=y;start[2]=z
-bool pathfindToPerimeter(bb_midgroundTileInfo_t* start, bb_tilemap_t* tilemap)
+// The open, closed, and neighbor lists draw their nodes from pool
+bool pathfindToPerimeter(uint16_t start, bb_tilemap_t* tilemap, listPool_t* pool)
 {
-    uint16_t halfFieldWidth = TILE_FIELD_WIDTH / 2;
-    start->gCost            = 0;
+    uint16_t halfFieldWidth                = TILE_FIELD_WIDTH / 2;
+    tilemap->gCosts[bb_tileCostIdx(start)] = 0;
     // manhattan distance from the target
     if (getX(start) < halfFieldWidth)
     {
-        start->hCost = getX(start) - 4;
+        tilemap->hCosts[bb_tileCostIdx(start)] = getX(start) - 4;
     }
     else
     {
-        start->hCost = TILE_FIELD_WIDTH - 5 - getX(start);
+        tilemap->hCosts[bb_tileCostIdx(start)] = TILE_FIELD_WIDTH - 5 - getX(start);
     }
     // bb_tileInfo_t* start = heap_caps_malloc(sizeof(bb_tileInfo_t), MALLOC_CAP_SPIRAM);
     //  It's like a memcopy
     //*start = *_start;
 
     // 1. initialize the open list
-    list_t open = {0};
+    list_t open = {.pool = pool};
     // 2. initialize the closed list
-    list_t closed = {0};
+    list_t closed = {.pool = pool};
     // put the starting node on the open list (you can leave its f at zero)
-    push(&open, (void*)start);
+    push(&open, (void*)(uintptr_t)start);
 
     // 3. while the open list is not empty
     // a) find the node with the least f on the open list, call it "current"
@@ -143,20 +147,18 @@ bool pathfindToPerimeter(bb_midgroundTileInfo_t* start, bb_tilemap_t* tilemap)
         node_t* openNode    = open.first;
         while (openNode != NULL)
         {
-            if (fCost((bb_midgroundTileInfo_t*)openNode->val) < fCost((bb_midgroundTileInfo_t*)currentNode->val)
-                || (fCost((bb_midgroundTileInfo_t*)openNode->val) < fCost((bb_midgroundTileInfo_t*)currentNode->val)
-                    && ((bb_midgroundTileInfo_t*)openNode->val)->hCost
-                           < ((bb_midgroundTileInfo_t*)currentNode->val)->hCost))
+            if (fCost(tilemap, nodePos(openNode)) < fCost(tilemap, nodePos(currentNode))
+                || (fCost(tilemap, nodePos(openNode)) < fCost(tilemap, nodePos(currentNode))
+                    && tilemap->hCosts[bb_tileCostIdx(nodePos(openNode))]
+                           < tilemap->hCosts[bb_tileCostIdx(nodePos(currentNode))]))
             {
                 currentNode = openNode;
             }
             openNode = openNode->next;
         }
         // b) remove current from open and add current to closed
-        bb_midgroundTileInfo_t* current = removeEntry(&open, currentNode);
-        // ESP_LOGD(BB_TAG,"Is this true?: %d\n", current == (current->z ? &tilemap->fgTiles[current->x][current->y] :
-        // &tilemap->mgTiles[current->x][current->y]));
-        push(&closed, (void*)current);
+        uint16_t current = (uint16_t)(uintptr_t)removeEntry(&open, currentNode);
+        push(&closed, (void*)(uintptr_t)current);
         if (isPerimeterNode(current))
         {
             clear(&open);
@@ -164,14 +166,14 @@ bool pathfindToPerimeter(bb_midgroundTileInfo_t* start, bb_tilemap_t* tilemap)
             return true;
         }
 
-        list_t* neighbors = heap_caps_calloc(1, sizeof(list_t), MALLOC_CAP_SPIRAM);
-        getNeighbors(current, neighbors, tilemap);
+        list_t neighbors = {.pool = pool};
+        getNeighbors(current, &neighbors, tilemap);
 
         // foreach neighbor of the current node
-        node_t* neighbor = neighbors->first;
+        node_t* neighbor = neighbors.first;
         while (neighbor != NULL)
         {
-            bb_midgroundTileInfo_t* neighborTile = (bb_midgroundTileInfo_t*)neighbor->val;
+            uint16_t neighborTile = nodePos(neighbor);
             // if neighbor is not traversable or if neighbor is in closed
             // node_t* temp = closed.first;
             //  while (temp != NULL) {
@@ -179,9 +181,7 @@ bool pathfindToPerimeter(bb_midgroundTileInfo_t* start, bb_tilemap_t* tilemap)
             //      temp = temp->next;
             //  }
 
-            if ((getZ(neighborTile) ? tilemap->fgTiles[getX(neighborTile)][getY(neighborTile)].health
-                                    : tilemap->mgTiles[getX(neighborTile)][getY(neighborTile)].health)
-                    == 0
+            if (bb_getHealth(tilemap, getX(neighborTile), getY(neighborTile), getZ(neighborTile)) == 0
                 || contains(&closed, neighborTile))
             {
                 // skip to the next neighbor
@@ -190,20 +190,20 @@ bool pathfindToPerimeter(bb_midgroundTileInfo_t* start, bb_tilemap_t* tilemap)
             }
 
             // if new path to neighbor is shorter or neighbor is not in open
-            uint16_t newCostToNeighbor
-                = current->gCost + 1; // simply use + 1 because each neighbor is an orthogonal step
-            if (newCostToNeighbor < neighborTile->gCost || !contains(&open, neighborTile))
+            uint16_t newCostToNeighbor = tilemap->gCosts[bb_tileCostIdx(current)]
+                                         + 1; // simply use + 1 because each neighbor is an orthogonal step
+            if (newCostToNeighbor < tilemap->gCosts[bb_tileCostIdx(neighborTile)] || !contains(&open, neighborTile))
             {
                 // set fCost of neighbor (we don't set the fCost, we calculate the gCost and hCost)
-                neighborTile->gCost = newCostToNeighbor;
+                tilemap->gCosts[bb_tileCostIdx(neighborTile)] = newCostToNeighbor;
                 // manhattan distance from the target
                 if (getX(neighborTile) < halfFieldWidth)
                 {
-                    neighborTile->hCost = getX(neighborTile) - 4;
+                    tilemap->hCosts[bb_tileCostIdx(neighborTile)] = getX(neighborTile) - 4;
                 }
                 else
                 {
-                    neighborTile->hCost = TILE_FIELD_WIDTH - 5 - getX(neighborTile);
+                    tilemap->hCosts[bb_tileCostIdx(neighborTile)] = TILE_FIELD_WIDTH - 5 - getX(neighborTile);
                     // set parent of neighbor to current
                     //  neighborTile->parent = current;
                 }
@@ -211,13 +211,12 @@ bool pathfindToPerimeter(bb_midgroundTileInfo_t* start, bb_tilemap_t* tilemap)
                 if (!contains(&open, neighborTile))
                 {
                     // add neighbor to open
-                    push(&open, (void*)neighborTile);
+                    push(&open, (void*)(uintptr_t)neighborTile);
                 }
             }
             neighbor = neighbor->next;
         }
-        clear(neighbors);
-        heap_caps_free(neighbors);
+        clear(&neighbors);
     } // end (while loop)
     clear(&open);
     clear(&closed);
@@ -16,9 +16,9 @@
 // Prototypes
 //==============================================================================
 
-bool isPerimeterNode(const bb_midgroundTileInfo_t* tile);
-void getNeighbors(const bb_midgroundTileInfo_t* tile, list_t* neighbors, bb_tilemap_t* tilemap);
-bool contains(const list_t* nodeList, const bb_midgroundTileInfo_t* tile);
-bool pathfindToPerimeter(bb_midgroundTileInfo_t* start, bb_tilemap_t* tilemap);
+bool isPerimeterNode(uint16_t tile);
+void getNeighbors(uint16_t tile, list_t* neighbors, bb_tilemap_t* tilemap);
+bool contains(const list_t* nodeList, uint16_t tile);
+bool pathfindToPerimeter(uint16_t start, bb_tilemap_t* tilemap, listPool_t* pool);
 
 #endif
\ No newline at end of file
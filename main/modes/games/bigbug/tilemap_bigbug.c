@@ -1,6 +1,7 @@
 //==============================================================================
 // Includes
 //==============================================================================
+#include <string.h>
 #include <color_utils.h>
 #include "mode_bigbug.h"
 #include "typedef_bigbug.h"
@@ -9,6 +10,17 @@
 #include "entity_bigbug.h"
 #include "lighting_bigbug.h"
 
+//==============================================================================
+// Defines
+//==============================================================================
+
+// How far around the camera to page chunks into internal RAM, in pixels. Roughly where entities are updated.
+#define BB_PAGE_MARGIN 200
+// The size of a chunk, in pixels
+#define BB_CHUNK_PX (TILE_SIZE << BB_CHUNK_SHIFT)
+// The most chunks paged in along each axis
+#define BB_PAGE_SPAN 3
+
 //==============================================================================
 // Function Prototypes
 //==============================================================================
@@ -16,21 +28,138 @@
 //==============================================================================
 // Functions
 //==============================================================================
-// static inline function to get bits 0-6 of pos
-static inline uint8_t getX(const bb_midgroundTileInfo_t* tile)
+
+/**
+ * @brief Allocate the tilemap's storage. Chunks of tile health and the pathfinding costs live in SPIRAM, and a few
+ * chunk slots in internal RAM are used for the chunks around the camera.
+ *
+ * @param tilemap The tilemap to allocate storage for
+ * @return true if everything was allocated, false if something wasn't
+ */
+bool bb_initTileStorage(bb_tilemap_t* tilemap)
 {
-    return tile->pos & 0x7F;
+    tilemap->chunkHomes = heap_caps_calloc_tag(BB_NUM_CHUNKS, sizeof(bb_tileChunk_t), MALLOC_CAP_SPIRAM, "chunks");
+    // It's fine if this fails, chunks will just stay in SPIRAM
+    tilemap->chunkSlots = heap_caps_calloc_tag(BB_CHUNK_SLOTS, sizeof(bb_tileChunk_t), MALLOC_CAP_8BIT, "chunkSlots");
+    tilemap->fgEmbeds   = heap_caps_calloc_tag(BB_NUM_TILES, sizeof(uint8_t), MALLOC_CAP_SPIRAM, "fgEmbeds");
+    tilemap->fgEntities = heap_caps_calloc_tag(BB_NUM_TILES, sizeof(bb_entity_t*), MALLOC_CAP_SPIRAM, "fgEntities");
+    tilemap->gCosts     = heap_caps_calloc_tag(2 * BB_NUM_TILES, sizeof(uint16_t), MALLOC_CAP_SPIRAM, "gCosts");
+    tilemap->hCosts     = heap_caps_calloc_tag(2 * BB_NUM_TILES, sizeof(uint16_t), MALLOC_CAP_SPIRAM, "hCosts");
+
+    if (NULL == tilemap->chunkHomes || NULL == tilemap->fgEmbeds || NULL == tilemap->fgEntities
+        || NULL == tilemap->gCosts || NULL == tilemap->hCosts)
+    {
+        ESP_LOGE(BB_TAG, "Couldn't allocate tile storage");
+        bb_deinitTileStorage(tilemap);
+        return false;
+    }
+
+    for (int32_t c = 0; c < BB_NUM_CHUNKS; c++)
+    {
+        tilemap->chunks[c] = &tilemap->chunkHomes[c];
+    }
+    for (int32_t s = 0; s < BB_CHUNK_SLOTS; s++)
+    {
+        tilemap->slotChunks[s] = -1;
+    }
+    return true;
 }
 
-// static inline function to get bits 7-14 of pos
-static inline uint8_t getY(const bb_midgroundTileInfo_t* tile)
+/**
+ * @brief Free the tilemap's storage
+ *
+ * @param tilemap The tilemap to free storage for
+ */
+void bb_deinitTileStorage(bb_tilemap_t* tilemap)
 {
-    return (tile->pos >> 7) & 0xFF;
+    heap_caps_free(tilemap->chunkHomes);
+    heap_caps_free(tilemap->chunkSlots);
+    heap_caps_free(tilemap->fgEmbeds);
+    heap_caps_free(tilemap->fgEntities);
+    heap_caps_free(tilemap->gCosts);
+    heap_caps_free(tilemap->hCosts);
+    tilemap->chunkHomes = NULL;
+    tilemap->chunkSlots = NULL;
+    tilemap->fgEmbeds   = NULL;
+    tilemap->fgEntities = NULL;
+    tilemap->gCosts     = NULL;
+    tilemap->hCosts     = NULL;
+    memset(tilemap->chunks, 0, sizeof(tilemap->chunks));
 }
 
-static inline uint16_t fCost(const bb_midgroundTileInfo_t* tile)
+/**
+ * @brief Page the chunks around the camera into internal RAM, and write chunks which are no longer near it back to
+ * SPIRAM. Tiles are always read through tilemap->chunks, so this only changes how fast they are to access.
+ *
+ * @param tilemap The tilemap
+ * @param camera The camera, in pixels
+ */
+void bb_pageTileChunks(bb_tilemap_t* tilemap, const rectangle_t* camera)
 {
-    return tile->gCost + tile->hCost;
+    if (NULL == tilemap->chunkSlots || NULL == tilemap->chunkHomes)
+    {
+        return;
+    }
+
+    // Find the chunks near the camera
+    int32_t left   = camera->pos.x - BB_PAGE_MARGIN;
+    int32_t top    = camera->pos.y - BB_PAGE_MARGIN;
+    int32_t right  = camera->pos.x + TFT_WIDTH + BB_PAGE_MARGIN - 1;
+    int32_t bottom = camera->pos.y + TFT_HEIGHT + BB_PAGE_MARGIN - 1;
+
+    int32_t c0x = 0;
+    int32_t c0y = 0;
+    int32_t c1x = -1; // An empty range when nothing is near the camera
+    int32_t c1y = -1;
+    if (right >= 0 && bottom >= 0 && left < TILE_FIELD_WIDTH * TILE_SIZE && top < TILE_FIELD_HEIGHT * TILE_SIZE)
+    {
+        c0x = MAX(left, 0) / BB_CHUNK_PX;
+        c0y = MAX(top, 0) / BB_CHUNK_PX;
+        c1x = MIN(MIN(right / BB_CHUNK_PX, BB_CHUNKS_WIDE - 1), c0x + BB_PAGE_SPAN - 1);
+        c1y = MIN(MIN(bottom / BB_CHUNK_PX, BB_CHUNKS_TALL - 1), c0y + BB_PAGE_SPAN - 1);
+    }
+
+    // Write back chunks which aren't wanted anymore
+    for (int32_t s = 0; s < BB_CHUNK_SLOTS; s++)
+    {
+        int16_t c = tilemap->slotChunks[s];
+        if (c >= 0)
+        {
+            int32_t cx = c % BB_CHUNKS_WIDE;
+            int32_t cy = c / BB_CHUNKS_WIDE;
+            if (cx < c0x || cx > c1x || cy < c0y || cy > c1y)
+            {
+                memcpy(&tilemap->chunkHomes[c], &tilemap->chunkSlots[s], sizeof(bb_tileChunk_t));
+                tilemap->chunks[c]     = &tilemap->chunkHomes[c];
+                tilemap->slotChunks[s] = -1;
+            }
+        }
+    }
+
+    // Page in wanted chunks which aren't resident yet
+    int32_t s = 0;
+    for (int32_t cy = c0y; cy <= c1y; cy++)
+    {
+        for (int32_t cx = c0x; cx <= c1x; cx++)
+        {
+            int32_t c = cy * BB_CHUNKS_WIDE + cx;
+            if (tilemap->chunks[c] != &tilemap->chunkHomes[c])
+            {
+                continue;
+            }
+            while (s < BB_CHUNK_SLOTS && tilemap->slotChunks[s] >= 0)
+            {
+                s++;
+            }
+            if (s == BB_CHUNK_SLOTS)
+            {
+                return;
+            }
+            memcpy(&tilemap->chunkSlots[s], &tilemap->chunkHomes[c], sizeof(bb_tileChunk_t));
+            tilemap->chunks[c]     = &tilemap->chunkSlots[s];
+            tilemap->slotChunks[s] = c;
+        }
+    }
 }
 
 void bb_loadWsgs(bb_tilemap_t* tilemap)
@@ -137,41 +266,41 @@ void bb_freeWsgs(bb_tilemap_t* tilemap)
 }
 
 // flags neighbors to check for structural support
-void flagNeighbors(const bb_midgroundTileInfo_t* tile, bb_gameData_t* gameData)
+void flagNeighbors(uint8_t i, uint8_t j, bb_gameData_t* gameData)
 {
     uint8_t* left = heap_caps_calloc(3, sizeof(uint8_t), MALLOC_CAP_SPIRAM);
-    left[0]       = getX(tile) - 1;
-    left[1]       = getY(tile);
+    left[0]       = i - 1;
+    left[1]       = j;
     left[2]       = 1;
     push(&gameData->pleaseCheck, (void*)left);
 
-    if (getY(tile) > 0)
+    if (j > 0)
     {
         uint8_t* up = heap_caps_calloc(3, sizeof(uint8_t), MALLOC_CAP_SPIRAM);
-        up[0]       = getX(tile);
-        up[1]       = getY(tile) - 1;
+        up[0]       = i;
+        up[1]       = j - 1;
         up[2]       = 1;
         push(&gameData->pleaseCheck, (void*)up);
     }
 
     uint8_t* right = heap_caps_calloc(3, sizeof(uint8_t), MALLOC_CAP_SPIRAM);
-    right[0]       = getX(tile) + 1;
-    right[1]       = getY(tile);
+    right[0]       = i + 1;
+    right[1]       = j;
     right[2]       = 1;
     push(&gameData->pleaseCheck, (void*)right);
 
-    if (getY(tile) < TILE_FIELD_HEIGHT)
+    if (j < TILE_FIELD_HEIGHT)
     {
         uint8_t* down = heap_caps_calloc(3, sizeof(uint8_t), MALLOC_CAP_SPIRAM);
-        down[0]       = getX(tile);
-        down[1]       = getY(tile) + 1;
+        down[0]       = i;
+        down[1]       = j + 1;
         down[2]       = 1;
         push(&gameData->pleaseCheck, (void*)down);
     }
 
     uint8_t* midground = heap_caps_calloc(3, sizeof(uint8_t), MALLOC_CAP_SPIRAM);
-    midground[0]       = getX(tile);
-    midground[1]       = getY(tile);
+    midground[0]       = i;
+    midground[1]       = j;
     midground[2]       = 0;
     push(&gameData->pleaseCheck, (void*)midground);
 }
@@ -225,14 +354,21 @@ void bb_drawTileMap(bb_tilemap_t* tilemap, rectangle_t* camera, vec_t* garbotnik
 
         int32_t brightness;
 
+        // Light the tiles on screen. camera + garbotnikDrawPos is Garbotnik's draw position in the world.
+        vec_t garbotnikWorldPos = {garbotnikDrawPos->x + camera->pos.x, garbotnikDrawPos->y + camera->pos.y};
+        bb_updateLightMap(&tilemap->lightMap, &tilemap->headlampWsg, iStart, iEnd, jStart, jEnd, &garbotnikWorldPos,
+                          garbotnikRotation->x,
+                          entityManager->playerEntity != NULL
+                              && entityManager->playerEntity->updateFunction == bb_updateGarbotnikFlying);
+
         for (int32_t i = iStart; i <= iEnd; i++)
         {
             for (int32_t j = jStart; j <= jEnd; j++)
             {
                 // Hijacking this i j double for loop to load entities within the camera bounds before drawing tiles.
-                if (tilemap->fgTiles[i][j].embed != NOTHING_EMBED && tilemap->fgTiles[i][j].entity == NULL)
+                if (bb_getEmbed(tilemap, i, j) != NOTHING_EMBED && bb_getTileEntity(tilemap, i, j) == NULL)
                 {
-                    switch (tilemap->fgTiles[i][j].embed)
+                    switch (bb_getEmbed(tilemap, i, j))
                     {
                         case EGG_EMBED:
                         {
@@ -251,7 +387,7 @@ void bb_drawTileMap(bb_tilemap_t* tilemap, rectangle_t* camera, vec_t* garbotnik
                                 }
                                 else
                                 {
-                                    tilemap->fgTiles[i][j].entity = eggLeaves;
+                                    bb_setTileEntity(tilemap, i, j, eggLeaves);
                                 }
                             }
                             break;
@@ -264,7 +400,7 @@ void bb_drawTileMap(bb_tilemap_t* tilemap, rectangle_t* camera, vec_t* garbotnik
                                                   i * TILE_SIZE + HALF_TILE, j * TILE_SIZE + HALF_TILE, false, false);
                             if (skeleton != NULL)
                             {
-                                tilemap->fgTiles[i][j].entity = skeleton;
+                                bb_setTileEntity(tilemap, i, j, skeleton);
                             }
                             break;
                         }
@@ -275,7 +411,7 @@ void bb_drawTileMap(bb_tilemap_t* tilemap, rectangle_t* camera, vec_t* garbotnik
                                                 i * TILE_SIZE + HALF_TILE, j * TILE_SIZE + HALF_TILE, false, false)
                                 != NULL)
                             {
-                                tilemap->fgTiles[i][j].embed = NOTHING_EMBED;
+                                bb_setEmbed(tilemap, i, j, NOTHING_EMBED);
                             }
                             break;
                         }
@@ -289,7 +425,7 @@ void bb_drawTileMap(bb_tilemap_t* tilemap, rectangle_t* camera, vec_t* garbotnik
                             {
                                 ((bb_carData_t*)car->data)->reward = BB_DONUT;
                                 car->currentAnimationFrame         = 1;
-                                tilemap->fgTiles[i][j].embed       = NOTHING_EMBED;
+                                bb_setEmbed(tilemap, i, j, NOTHING_EMBED);
                             }
                             break;
                         }
@@ -303,7 +439,7 @@ void bb_drawTileMap(bb_tilemap_t* tilemap, rectangle_t* camera, vec_t* garbotnik
                             {
                                 ((bb_carData_t*)car->data)->reward = BB_SWADGE;
                                 car->currentAnimationFrame         = 1;
-                                tilemap->fgTiles[i][j].embed       = NOTHING_EMBED;
+                                bb_setEmbed(tilemap, i, j, NOTHING_EMBED);
                             }
                             break;
                         }
@@ -328,7 +464,7 @@ void bb_drawTileMap(bb_tilemap_t* tilemap, rectangle_t* camera, vec_t* garbotnik
                                     ((bb_foodCartData_t*)foodCart->data)->reward = BB_DONUT;
                                     foodCart->currentAnimationFrame
                                         = 20; // Also used as health for the food cart. It takes 10 hits to destroy.
-                                    tilemap->fgTiles[i][j].embed = NOTHING_EMBED;
+                                    bb_setEmbed(tilemap, i, j, NOTHING_EMBED);
                                 }
                                 else
                                 {
@@ -357,7 +493,7 @@ void bb_drawTileMap(bb_tilemap_t* tilemap, rectangle_t* camera, vec_t* garbotnik
 
                                     ((bb_foodCartData_t*)foodCart->data)->reward = BB_SWADGE;
                                     foodCart->currentAnimationFrame = 20; // functions as health for the food cart
-                                    tilemap->fgTiles[i][j].embed    = NOTHING_EMBED;
+                                    bb_setEmbed(tilemap, i, j, NOTHING_EMBED);
                                 }
                                 else
                                 {
@@ -373,7 +509,7 @@ void bb_drawTileMap(bb_tilemap_t* tilemap, rectangle_t* camera, vec_t* garbotnik
                                                 i * TILE_SIZE + HALF_TILE, j * TILE_SIZE + HALF_TILE, false, false)
                                 != NULL)
                             {
-                                tilemap->fgTiles[i][j].embed = NOTHING_EMBED;
+                                bb_setEmbed(tilemap, i, j, NOTHING_EMBED);
                             }
                             break;
                         }
@@ -384,7 +520,7 @@ void bb_drawTileMap(bb_tilemap_t* tilemap, rectangle_t* camera, vec_t* garbotnik
                                                 i * TILE_SIZE + HALF_TILE, j * TILE_SIZE + HALF_TILE, false, false)
                                 != NULL)
                             {
-                                tilemap->fgTiles[i][j].embed = NOTHING_EMBED;
+                                bb_setEmbed(tilemap, i, j, NOTHING_EMBED);
                             }
                             break;
                         }
@@ -395,7 +531,7 @@ void bb_drawTileMap(bb_tilemap_t* tilemap, rectangle_t* camera, vec_t* garbotnik
                                                 i * TILE_SIZE + HALF_TILE, j * TILE_SIZE + HALF_TILE, false, false)
                                 != NULL)
                             {
-                                tilemap->fgTiles[i][j].embed = NOTHING_EMBED;
+                                bb_setEmbed(tilemap, i, j, NOTHING_EMBED);
                             }
                             break;
                         }
@@ -410,7 +546,7 @@ void bb_drawTileMap(bb_tilemap_t* tilemap, rectangle_t* camera, vec_t* garbotnik
 
                 // Figure out which midground tile quadrants are worth drawing
                 // to cut down on overdraw
-                if (tilemap->mgTiles[i][j].health > 0)
+                if (bb_getMgHealth(tilemap, i, j) > 0)
                 {
                     // Just don't draw it if it is on the very edge, because I am lazy to handle those cases.
                     if (i && (i != TILE_FIELD_WIDTH - 1) && j && (j != TILE_FIELD_HEIGHT - 1))
@@ -421,74 +557,74 @@ void bb_drawTileMap(bb_tilemap_t* tilemap, rectangle_t* camera, vec_t* garbotnik
                         // 0b00000010 means draw bottom left  mg
                         // 0b00000001 means draw bottom right mg
                         uint8_t drawMidground = 0;
-                        if (tilemap->fgTiles[i][j].health > 0) // if there is fg
+                        if (bb_getFgHealth(tilemap, i, j) > 0) // if there is fg
                         {
                             // top left stuff
                             drawMidground |= ((
                                                   // mg going left & fg isn't
-                                                  ((tilemap->mgTiles[i - 1][j].health > 0)
-                                                   && (tilemap->fgTiles[i - 1][j].health == 0))
+                                                  ((bb_getMgHealth(tilemap, i - 1, j) > 0)
+                                                   && (bb_getFgHealth(tilemap, i - 1, j) == 0))
                                                   ||
                                                   // mg going up & fg isn't
-                                                  ((tilemap->mgTiles[i][j - 1].health > 0)
-                                                   && (tilemap->fgTiles[i][j - 1].health == 0))
+                                                  ((bb_getMgHealth(tilemap, i, j - 1) > 0)
+                                                   && (bb_getFgHealth(tilemap, i, j - 1) == 0))
                                                   ||
                                                   // mg going diagonal and fg isn't at diagonal
-                                                  ((tilemap->mgTiles[i - 1][j].health > 0)
-                                                   && (tilemap->mgTiles[i][j - 1].health > 0)
-                                                   && (tilemap->mgTiles[i - 1][j - 1].health > 0)
-                                                   && (tilemap->fgTiles[i - 1][j - 1].health == 0)))
+                                                  ((bb_getMgHealth(tilemap, i - 1, j) > 0)
+                                                   && (bb_getMgHealth(tilemap, i, j - 1) > 0)
+                                                   && (bb_getMgHealth(tilemap, i - 1, j - 1) > 0)
+                                                   && (bb_getFgHealth(tilemap, i - 1, j - 1) == 0)))
                                               << 3); // set the 3rd bit
 
                             // top right stuff
                             drawMidground |= ((
                                                   // mg going right & fg isn't
-                                                  ((tilemap->mgTiles[i + 1][j].health > 0)
-                                                   && (tilemap->fgTiles[i + 1][j].health == 0))
+                                                  ((bb_getMgHealth(tilemap, i + 1, j) > 0)
+                                                   && (bb_getFgHealth(tilemap, i + 1, j) == 0))
                                                   ||
                                                   // mg going up & fg isn't
-                                                  ((tilemap->mgTiles[i][j - 1].health > 0)
-                                                   && (tilemap->fgTiles[i][j - 1].health == 0))
+                                                  ((bb_getMgHealth(tilemap, i, j - 1) > 0)
+                                                   && (bb_getFgHealth(tilemap, i, j - 1) == 0))
                                                   ||
                                                   // mg going diagonal and fg isn't at diagonal
-                                                  ((tilemap->mgTiles[i + 1][j].health > 0)
-                                                   && (tilemap->mgTiles[i][j - 1].health > 0)
-                                                   && (tilemap->mgTiles[i + 1][j - 1].health > 0)
-                                                   && (tilemap->fgTiles[i + 1][j - 1].health == 0)))
+                                                  ((bb_getMgHealth(tilemap, i + 1, j) > 0)
+                                                   && (bb_getMgHealth(tilemap, i, j - 1) > 0)
+                                                   && (bb_getMgHealth(tilemap, i + 1, j - 1) > 0)
+                                                   && (bb_getFgHealth(tilemap, i + 1, j - 1) == 0)))
                                               << 2); // set the 2nd bit
 
                             // bottom left stuff
                             drawMidground |= ((
                                                   // mg going left & fg isn't
-                                                  ((tilemap->mgTiles[i - 1][j].health > 0)
-                                                   && (tilemap->fgTiles[i - 1][j].health == 0))
+                                                  ((bb_getMgHealth(tilemap, i - 1, j) > 0)
+                                                   && (bb_getFgHealth(tilemap, i - 1, j) == 0))
                                                   ||
                                                   // mg going down & fg isn't
-                                                  ((tilemap->mgTiles[i][j + 1].health > 0)
-                                                   && (tilemap->fgTiles[i][j + 1].health == 0))
+                                                  ((bb_getMgHealth(tilemap, i, j + 1) > 0)
+                                                   && (bb_getFgHealth(tilemap, i, j + 1) == 0))
                                                   ||
                                                   // mg going diagonal and fg isn't at diagonal
-                                                  ((tilemap->mgTiles[i - 1][j].health > 0)
-                                                   && (tilemap->mgTiles[i][j + 1].health > 0)
-                                                   && (tilemap->mgTiles[i - 1][j + 1].health > 0)
-                                                   && (tilemap->fgTiles[i - 1][j + 1].health == 0)))
+                                                  ((bb_getMgHealth(tilemap, i - 1, j) > 0)
+                                                   && (bb_getMgHealth(tilemap, i, j + 1) > 0)
+                                                   && (bb_getMgHealth(tilemap, i - 1, j + 1) > 0)
+                                                   && (bb_getFgHealth(tilemap, i - 1, j + 1) == 0)))
                                               << 1); // set the 1st bit
 
                             // bottom right stuff
                             drawMidground |= ((
                                                   // mg going right & fg isn't
-                                                  ((tilemap->mgTiles[i + 1][j].health > 0)
-                                                   && (tilemap->fgTiles[i + 1][j].health == 0))
+                                                  ((bb_getMgHealth(tilemap, i + 1, j) > 0)
+                                                   && (bb_getFgHealth(tilemap, i + 1, j) == 0))
                                                   ||
                                                   // mg going down & fg isn't
-                                                  ((tilemap->mgTiles[i][j + 1].health > 0)
-                                                   && (tilemap->fgTiles[i][j + 1].health == 0))
+                                                  ((bb_getMgHealth(tilemap, i, j + 1) > 0)
+                                                   && (bb_getFgHealth(tilemap, i, j + 1) == 0))
                                                   ||
                                                   // mg going diagonal and fg isn't at diagonal
-                                                  ((tilemap->mgTiles[i + 1][j].health > 0)
-                                                   && (tilemap->mgTiles[i][j + 1].health > 0)
-                                                   && (tilemap->mgTiles[i + 1][j + 1].health > 0)
-                                                   && (tilemap->fgTiles[i + 1][j + 1].health == 0)))
+                                                  ((bb_getMgHealth(tilemap, i + 1, j) > 0)
+                                                   && (bb_getMgHealth(tilemap, i, j + 1) > 0)
+                                                   && (bb_getMgHealth(tilemap, i + 1, j + 1) > 0)
+                                                   && (bb_getFgHealth(tilemap, i + 1, j + 1) == 0)))
                                               << 0); // set the 0th bit
                         }
                         else
@@ -501,33 +637,29 @@ void bb_drawTileMap(bb_tilemap_t* tilemap, rectangle_t* camera, vec_t* garbotnik
 
                         // sprite_idx LURD order.
                         int8_t sprite_idx
-                            = 8 * ((i - 1 < 0) ? 0 : (tilemap->mgTiles[i - 1][j].health > 0))
-                              + 4 * ((j - 1 < 0) ? 0 : (tilemap->mgTiles[i][j - 1].health > 0))
-                              + 2 * ((i + 1 > TILE_FIELD_WIDTH - 1) ? 0 : tilemap->mgTiles[i + 1][j].health > 0)
-                              + 1 * ((j + 1 > TILE_FIELD_HEIGHT - 1) ? 0 : tilemap->mgTiles[i][j + 1].health > 0);
+                            = 8 * ((i - 1 < 0) ? 0 : (bb_getMgHealth(tilemap, i - 1, j) > 0))
+                              + 4 * ((j - 1 < 0) ? 0 : (bb_getMgHealth(tilemap, i, j - 1) > 0))
+                              + 2 * ((i + 1 > TILE_FIELD_WIDTH - 1) ? 0 : bb_getMgHealth(tilemap, i + 1, j) > 0)
+                              + 1 * ((j + 1 > TILE_FIELD_HEIGHT - 1) ? 0 : bb_getMgHealth(tilemap, i, j + 1) > 0);
                         // corner_info represents up_left, up_right, down_left, down_right dirt presence (remember >0 is
                         // dirt).
                         int8_t corner_info
                             = 8
                                   * ((i - 1 < 0)   ? 0
                                      : (j - 1 < 0) ? 0
-                                                   : (tilemap->mgTiles[i - 1][j - 1].health > 0))
+                                                   : (bb_getMgHealth(tilemap, i - 1, j - 1) > 0))
                               + 4
                                     * ((i + 1 > TILE_FIELD_WIDTH - 1) ? 0
                                        : (j - 1 < 0)                  ? 0
-                                                                      : tilemap->mgTiles[i + 1][j - 1].health > 0)
+                                                                      : bb_getMgHealth(tilemap, i + 1, j - 1) > 0)
                               + 2
                                     * ((i - 1 < 0)                       ? 0
                                        : (j + 1 > TILE_FIELD_HEIGHT - 1) ? 0
-                                                                         : tilemap->mgTiles[i - 1][j + 1].health > 0)
+                                                                         : bb_getMgHealth(tilemap, i - 1, j + 1) > 0)
                               + 1
                                     * ((i + 1 > TILE_FIELD_WIDTH - 1)    ? 0
                                        : (j + 1 > TILE_FIELD_HEIGHT - 1) ? 0
-                                                                         : tilemap->mgTiles[i + 1][j + 1].health > 0);
-
-                        vec_t lookup = {tilePos.x + 8 - (garbotnikDrawPos->x + 18) + tilemap->headlampWsg.w,
-                                        tilePos.y + 8 - (garbotnikDrawPos->y + 17) + tilemap->headlampWsg.h};
-                        lookup       = divVec2d(lookup, 2);
+                                                                         : bb_getMgHealth(tilemap, i + 1, j + 1) > 0);
 
                         if (drawMidground & 0b00001000)
                         {
@@ -537,16 +669,7 @@ void bb_drawTileMap(bb_tilemap_t* tilemap, rectangle_t* camera, vec_t* garbotnik
                             // 8 01xx xxxx
                             // 12 00xx xxxx
                             // 16 11xx 0xxx
-                            // vec_t lookup = {tilePos.x + 8 - garbotnikDrawPos->x + 16 + tilemap->headlampWsg.w / 2,
-                            //                 tilePos.y + 8 - garbotnikDrawPos->y + 17 + tilemap->headlampWsg.h / 2};
-                            // ESP_LOGD(BB_TAG,"lookup: %d\n",lookup.x);
-                            brightness = 5 - (j > 25 ? 25 : j) / 5;
-                            if (entityManager->playerEntity != NULL
-                                && entityManager->playerEntity->updateFunction == bb_updateGarbotnikFlying)
-                            {
-                                brightness = bb_midgroundLighting(&(tilemap->headlampWsg), &lookup,
-                                                                  &(garbotnikRotation->x), brightness);
-                            }
+                            brightness = bb_getMidgroundLight(&tilemap->lightMap, i, j, 0, 0);
 
                             switch (sprite_idx & 0b1100)
                             {
@@ -583,7 +706,6 @@ void bb_drawTileMap(bb_tilemap_t* tilemap, rectangle_t* camera, vec_t* garbotnik
                             }
                         }
 
-                        lookup.x += 8;
 
                         if (drawMidground & 0b000000100)
                         {
@@ -593,13 +715,7 @@ void bb_drawTileMap(bb_tilemap_t* tilemap, rectangle_t* camera, vec_t* garbotnik
                             // 9 x10x xxxx
                             // 13 x00x xxxx
                             // 17 x11x x0xx
-                            brightness = 5 - (j > 25 ? 25 : j) / 5;
-                            if (entityManager->playerEntity != NULL
-                                && entityManager->playerEntity->updateFunction == bb_updateGarbotnikFlying)
-                            {
-                                brightness = bb_midgroundLighting(&(tilemap->headlampWsg), &lookup,
-                                                                  &(garbotnikRotation->x), brightness);
-                            }
+                            brightness = bb_getMidgroundLight(&tilemap->lightMap, i, j, 1, 0);
 
                             switch (sprite_idx & 0b110)
                             {
@@ -643,9 +759,6 @@ void bb_drawTileMap(bb_tilemap_t* tilemap, rectangle_t* camera, vec_t* garbotnik
                             }
                         }
 
-                        lookup.x -= 8;
-                        lookup.y += 8;
-
                         if (drawMidground & 0b00000010)
                         {
                             // Bottom Left
@@ -655,13 +768,7 @@ void bb_drawTileMap(bb_tilemap_t* tilemap, rectangle_t* camera, vec_t* garbotnik
                             // 14 0xx0 xxxx
                             // 18 1xx1 xx0x
 
-                            brightness = 5 - (j > 25 ? 25 : j) / 5;
-                            if (entityManager->playerEntity != NULL
-                                && entityManager->playerEntity->updateFunction == bb_updateGarbotnikFlying)
-                            {
-                                brightness = bb_midgroundLighting(&(tilemap->headlampWsg), &lookup,
-                                                                  &(garbotnikRotation->x), brightness);
-                            }
+                            brightness = bb_getMidgroundLight(&tilemap->lightMap, i, j, 0, 1);
 
                             switch (sprite_idx & 0b1001)
                             {
@@ -705,7 +812,6 @@ void bb_drawTileMap(bb_tilemap_t* tilemap, rectangle_t* camera, vec_t* garbotnik
                             }
                         }
 
-                        lookup.x += 8;
                         if (drawMidground & 0b00000001)
                         {
                             // Bottom Right
@@ -714,13 +820,7 @@ void bb_drawTileMap(bb_tilemap_t* tilemap, rectangle_t* camera, vec_t* garbotnik
                             // 11 xx01 xxxx
                             // 15 xx00 xxxx
                             // 19 xx11 xxx0
-                            brightness = 5 - (j > 25 ? 25 : j) / 5;
-                            if (entityManager->playerEntity != NULL
-                                && entityManager->playerEntity->updateFunction == bb_updateGarbotnikFlying)
-                            {
-                                brightness = bb_midgroundLighting(&(tilemap->headlampWsg), &lookup,
-                                                                  &(garbotnikRotation->x), brightness);
-                            }
+                            brightness = bb_getMidgroundLight(&tilemap->lightMap, i, j, 1, 1);
 
                             switch (sprite_idx & 0b0011)
                             {
@@ -767,49 +867,37 @@ void bb_drawTileMap(bb_tilemap_t* tilemap, rectangle_t* camera, vec_t* garbotnik
                 }
 
                 // Draw foreground tiles
-                if (tilemap->fgTiles[i][j].health >= 1)
+                if (bb_getFgHealth(tilemap, i, j) >= 1)
                 {
                     wsg_t(*wsgForegroundArrayPtr)[240] = bb_GetForegroundWsgArrForCoord(tilemap, i, j);
 
                     // sprite_idx LURD order.
                     uint8_t sprite_idx
-                        = 8 * ((i - 1 < 0) ? 0 : (tilemap->fgTiles[i - 1][j].health > 0))
-                          + 4 * ((j - 1 < 0) ? 0 : (tilemap->fgTiles[i][j - 1].health > 0))
-                          + 2 * ((i + 1 > TILE_FIELD_WIDTH - 1) ? 0 : (tilemap->fgTiles[i + 1][j].health > 0))
-                          + 1 * ((j + 1 > TILE_FIELD_HEIGHT - 1) ? 0 : (tilemap->fgTiles[i][j + 1]).health > 0);
+                        = 8 * ((i - 1 < 0) ? 0 : (bb_getFgHealth(tilemap, i - 1, j) > 0))
+                          + 4 * ((j - 1 < 0) ? 0 : (bb_getFgHealth(tilemap, i, j - 1) > 0))
+                          + 2 * ((i + 1 > TILE_FIELD_WIDTH - 1) ? 0 : (bb_getFgHealth(tilemap, i + 1, j) > 0))
+                          + 1 * ((j + 1 > TILE_FIELD_HEIGHT - 1) ? 0 : (bb_getFgHealth(tilemap, i, j + 1) > 0));
                     // corner_info represents up_left, up_right, down_left, down_right dirt presence (remember >0 is
                     // dirt).
                     uint8_t corner_info
                         = 8
                               * ((i - 1 < 0)   ? 0
                                  : (j - 1 < 0) ? 0
-                                               : (tilemap->fgTiles[i - 1][j - 1].health > 0))
+                                               : (bb_getFgHealth(tilemap, i - 1, j - 1) > 0))
                           + 4
                                 * ((i + 1 > TILE_FIELD_WIDTH - 1) ? 0
                                    : (j - 1 < 0)                  ? 0
-                                                                  : (tilemap->fgTiles[i + 1][j - 1].health > 0))
+                                                                  : (bb_getFgHealth(tilemap, i + 1, j - 1) > 0))
                           + 2
                                 * ((i - 1 < 0)                       ? 0
                                    : (j + 1 > TILE_FIELD_HEIGHT - 1) ? 0
-                                                                     : (tilemap->fgTiles[i - 1][j + 1].health > 0))
+                                                                     : (bb_getFgHealth(tilemap, i - 1, j + 1) > 0))
                           + 1
                                 * ((i + 1 > TILE_FIELD_WIDTH - 1)    ? 0
                                    : (j + 1 > TILE_FIELD_HEIGHT - 1) ? 0
-                                                                     : (tilemap->fgTiles[i + 1][j + 1]).health > 0);
+                                                                     : (bb_getFgHealth(tilemap, i + 1, j + 1) > 0));
 
-                    vec_t lookup = {tilePos.x + 8 - (garbotnikDrawPos->x + 18) + tilemap->headlampWsg.w,
-                                    tilePos.y + 8 - (garbotnikDrawPos->y + 17) + tilemap->headlampWsg.h};
-                    lookup       = divVec2d(lookup, 2);
-
-                    if (entityManager->playerEntity != NULL
-                        && entityManager->playerEntity->updateFunction == bb_updateGarbotnikFlying)
-                    {
-                        brightness = bb_foregroundLighting(&(tilemap->headlampWsg), &lookup, &(garbotnikRotation->x));
-                    }
-                    else
-                    {
-                        brightness = 0;
-                    }
+                    brightness = bb_getForegroundLight(&tilemap->lightMap, i, j, 0, 0);
 
                     // Top Left      V
                     // 00RD ....   (0,0),  (2,1),  (0,2),  (2,3), #convex corners
@@ -879,16 +967,7 @@ void bb_drawTileMap(bb_tilemap_t* tilemap, rectangle_t* camera, vec_t* garbotnik
                         drawWsgSimple(&(*wsgForegroundArrayPtr)[39], tilePos.x, tilePos.y);
                     }
 
-                    lookup.x += 8;
-                    if (entityManager->playerEntity != NULL
-                        && entityManager->playerEntity->updateFunction == bb_updateGarbotnikFlying)
-                    {
-                        brightness = bb_foregroundLighting(&(tilemap->headlampWsg), &lookup, &(garbotnikRotation->x));
-                    }
-                    else
-                    {
-                        brightness = 0;
-                    }
+                    brightness = bb_getForegroundLight(&tilemap->lightMap, i, j, 1, 0);
 
                     // Top Right             V
                     // L00D ....   (0,0),  (2,1),  (0,2),  (2,3), #convex corners
@@ -968,17 +1047,7 @@ void bb_drawTileMap(bb_tilemap_t* tilemap, rectangle_t* camera, vec_t* garbotnik
                         drawWsgSimple(&(*wsgForegroundArrayPtr)[39], tilePos.x + HALF_TILE, tilePos.y);
                     }
 
-                    lookup.x -= 8;
-                    lookup.y += 8;
-                    if (entityManager->playerEntity != NULL
-                        && entityManager->playerEntity->updateFunction == bb_updateGarbotnikFlying)
-                    {
-                        brightness = bb_foregroundLighting(&(tilemap->headlampWsg), &lookup, &(garbotnikRotation->x));
-                    }
-                    else
-                    {
-                        brightness = 0;
-                    }
+                    brightness = bb_getForegroundLight(&tilemap->lightMap, i, j, 0, 1);
                     // Bottom Left                   V
                     // 0UR0 ....   (0,0),  (2,1),  (0,2),  (2,3), #convex corners
                     // 0110 ..1.   (14,0), (12,1), (6,2),  (4,3), #opposite convex corners
@@ -1058,16 +1127,7 @@ void bb_drawTileMap(bb_tilemap_t* tilemap, rectangle_t* camera, vec_t* garbotnik
                         drawWsgSimple(&(*wsgForegroundArrayPtr)[39], tilePos.x, tilePos.y + HALF_TILE);
                     }
 
-                    lookup.x += 8;
-                    if (entityManager->playerEntity != NULL
-                        && entityManager->playerEntity->updateFunction == bb_updateGarbotnikFlying)
-                    {
-                        brightness = bb_foregroundLighting(&(tilemap->headlampWsg), &lookup, &(garbotnikRotation->x));
-                    }
-                    else
-                    {
-                        brightness = 0;
-                    }
+                    brightness = bb_getForegroundLight(&tilemap->lightMap, i, j, 1, 1);
                     // Bottom Right                          V
                     if ((num & 0b00110000) == 0b00000000)
                     {
@@ -1166,7 +1226,7 @@ void bb_collisionCheck(bb_tilemap_t* tilemap, bb_entity_t* ent, vec_t* previousP
         {
             if (i >= 0 && i < TILE_FIELD_WIDTH && j >= 0 && j < TILE_FIELD_HEIGHT)
             {
-                if (ent->gameData->tilemap.fgTiles[i][j].health >= 1)
+                if (bb_getFgHealth(&ent->gameData->tilemap, i, j) >= 1)
                 {
                     // Initial circle check for preselecting the closest dirt tile
                     int32_t sqDist
@@ -1252,11 +1312,11 @@ void bb_collisionCheck(bb_tilemap_t* tilemap, bb_entity_t* ent, vec_t* previousP
 
 wsg_t (*bb_GetMidgroundWsgArrForCoord(bb_tilemap_t* tilemap, const uint32_t i, const uint32_t j))[120]
 {
-    if (tilemap->mgTiles[i][j].health > 4)
+    if (bb_getMgHealth(tilemap, i, j) > 4)
     {
         return &tilemap->mid_h_Wsg;
     }
-    else if (tilemap->mgTiles[i][j].health > 1)
+    else if (bb_getMgHealth(tilemap, i, j) > 1)
     {
         return &tilemap->mid_m_Wsg;
     }
@@ -1265,15 +1325,15 @@ wsg_t (*bb_GetMidgroundWsgArrForCoord(bb_tilemap_t* tilemap, const uint32_t i, c
 
 wsg_t (*bb_GetForegroundWsgArrForCoord(bb_tilemap_t* tilemap, const uint32_t i, const uint32_t j))[240]
 {
-    if (tilemap->fgTiles[i][j].health > 10)
+    if (bb_getFgHealth(tilemap, i, j) > 10)
     {
         return &tilemap->fore_b_Wsg;
     }
-    else if (tilemap->fgTiles[i][j].health > 4)
+    else if (bb_getFgHealth(tilemap, i, j) > 4)
     {
         return &tilemap->fore_h_Wsg;
     }
-    else if (tilemap->fgTiles[i][j].health > 1)
+    else if (bb_getFgHealth(tilemap, i, j) > 1)
     {
         return &tilemap->fore_m_Wsg;
     }
@@ -6,6 +6,7 @@
 #include "swadge2024.h"
 #include "typedef_bigbug.h"
 #include "entityManager_bigbug.h"
+#include "lighting_bigbug.h"
 
 //==============================================================================
 // Constants
@@ -13,6 +14,20 @@
 #define TILE_FIELD_WIDTH  74  // matches the level wsg graphic width
 #define TILE_FIELD_HEIGHT 197 // matches the level wsg graphic height
 
+#define BB_CHUNK_SHIFT 4 // Chunks are 16x16 tiles
+#define BB_CHUNK_SIZE  (1 << BB_CHUNK_SHIFT)
+#define BB_CHUNK_MASK  (BB_CHUNK_SIZE - 1)
+#define BB_CHUNKS_WIDE ((TILE_FIELD_WIDTH + BB_CHUNK_MASK) >> BB_CHUNK_SHIFT)
+#define BB_CHUNKS_TALL ((TILE_FIELD_HEIGHT + BB_CHUNK_MASK) >> BB_CHUNK_SHIFT)
+#define BB_NUM_CHUNKS  (BB_CHUNKS_WIDE * BB_CHUNKS_TALL)
+#define BB_CHUNK_SLOTS 9 // Enough chunks in internal RAM to cover the camera and where entities are active
+
+#define BB_NUM_TILES (TILE_FIELD_WIDTH * TILE_FIELD_HEIGHT)
+
+// A tile position packed for pathfinding. x is bits 0 through 6, y is bits 7 through 14, and z is bit 15. z is true
+// for foreground false for midground.
+#define BB_TILE_POS(x, y, z) ((uint16_t)((x) | ((y) << 7) | ((z) << 15)))
+
 //==============================================================================
 // Enums
 //==============================================================================
@@ -20,37 +35,15 @@
 //==============================================================================
 // Structs
 //==============================================================================
-struct bb_midgroundTileInfo_t // parent class
+/**
+ * @brief The health of a square of tiles, which is all that is needed to draw them and collide with them. Chunks live
+ * in SPIRAM, and the ones around the camera are paged into faster internal RAM each frame.
+ */
+typedef struct
 {
-    uint16_t pos;  // bitpacked x,y,z
-                   // x is bits 0 through 6
-                   // y is bits 7 through 14
-                   // z is bit 15
-                   // x and y are indices in the tilemap. z is true for foreground false for midground.
-    int8_t health; // 0 is air, > 0 is garbage. Use an int8_t incase damage decrements lower than zero, then we can snap
-                   // to zero.
-    uint16_t gCost;
-    uint16_t hCost;
-};
-
-struct bb_foregroundTileInfo_t // child class
-{
-    // must be exactly same as bb_midgroundTileInfo_t
-    uint16_t pos;  // bitpacked x,y,z
-                   // x is bits 0 through 6
-                   // y is bits 7 through 14
-                   // z is bit 15
-                   // x and y are indices in the tilemap. z is true for foreground false for midground.
-    int8_t health; // 0 is air, > 0 is garbage. Use an int8_t incase damage decrements lower than zero, then we can snap
-                   // to zero.
-    uint16_t gCost;
-    uint16_t hCost;
-
-    // specific to bb_foregroundTileInfo_t
-    bb_embeddable_t embed; // Some kind of something embedded in the garbage tile.
-    bb_entity_t* entity;   // Null when the tile is off screen. Becomes an embedded entity when on screen.
-                           // Tracking for the sake of doing something to it when this tile crumbles.
-};
+    int8_t fgHealth[BB_CHUNK_SIZE * BB_CHUNK_SIZE]; ///< Foreground health, row major. 0 is air, > 0 is garbage.
+    int8_t mgHealth[BB_CHUNK_SIZE * BB_CHUNK_SIZE]; ///< Midground health, row major. 0 is air, > 0 is garbage.
+} bb_tileChunk_t;
 
 struct bb_tilemap_t
 {
@@ -71,9 +64,17 @@ struct bb_tilemap_t
     wsg_t surface2Wsg;      ///< A graphic at the surface of the city dump
     wsg_t landfillGradient; ///< A tall gradient repeated acroos the screen under surface1Wsg
 
-    bb_foregroundTileInfo_t* fgTiles[TILE_FIELD_WIDTH]; ///< The array of foreground tiles. The number
-                                                        ///< is the dirt's health. 0 is air.
-    bb_midgroundTileInfo_t* mgTiles[TILE_FIELD_WIDTH];  ///< The array of midground tiles.
+    bb_tileChunk_t* chunks[BB_NUM_CHUNKS]; ///< Where each chunk is, either its home or a slot it is paged into
+    bb_tileChunk_t* chunkHomes;            ///< Every chunk, in SPIRAM
+    bb_tileChunk_t* chunkSlots;            ///< Chunks paged into internal RAM
+    int16_t slotChunks[BB_CHUNK_SLOTS];    ///< The chunk in each slot, or -1 if it's free
+    uint8_t* fgEmbeds;                     ///< The bb_embeddable_t in each foreground tile, row major
+    bb_entity_t** fgEntities;              ///< The entity for each foreground tile's embed, row major. NULL when the
+                                           ///< tile is off screen.
+    uint16_t* gCosts;                      ///< Pathfinding costs from the start, indexed by bb_tileCostIdx()
+    uint16_t* hCosts;                      ///< Pathfinding costs to the perimeter, indexed by bb_tileCostIdx()
+
+    bb_lightMap_t lightMap; ///< The brightness of the tiles on screen
 };
 
 struct bb_hitInfo_t
@@ -88,9 +89,12 @@ struct bb_hitInfo_t
 //==============================================================================
 // Prototypes
 //==============================================================================
+bool bb_initTileStorage(bb_tilemap_t* tilemap);
+void bb_deinitTileStorage(bb_tilemap_t* tilemap);
+void bb_pageTileChunks(bb_tilemap_t* tilemap, const rectangle_t* camera);
 void bb_loadWsgs(bb_tilemap_t* tilemap);
 void bb_freeWsgs(bb_tilemap_t* tilemap);
-void flagNeighbors(const bb_midgroundTileInfo_t* tile, bb_gameData_t* gameData);
+void flagNeighbors(uint8_t i, uint8_t j, bb_gameData_t* gameData);
 void bb_drawTileMap(bb_tilemap_t* tilemap, rectangle_t* camera, vec_t* garbotnikDrawPos, vec_t* garbotnikRotation,
                     bb_entityManager_t* entityManager);
 void bb_DrawForegroundCornerTile(bb_tilemap_t* tilemap, rectangle_t* camera, const uint8_t* idx_arr, uint32_t i,
@@ -101,4 +105,98 @@ void bb_collisionCheck(bb_tilemap_t* tilemap, bb_entity_t* ent, vec_t* previousP
 wsg_t (*bb_GetMidgroundWsgArrForCoord(bb_tilemap_t* tilemap, const uint32_t i, const uint32_t j))[120];
 wsg_t (*bb_GetForegroundWsgArrForCoord(bb_tilemap_t* tilemap, const uint32_t i, const uint32_t j))[240];
 
+//==============================================================================
+// Inline Functions
+//==============================================================================
+
+/**
+ * @brief Get the chunk holding a tile
+ *
+ * @param tilemap The tilemap
+ * @param i The tile's column
+ * @param j The tile's row
+ * @return The chunk, wherever it is currently paged
+ */
+static inline bb_tileChunk_t* bb_getChunk(const bb_tilemap_t* tilemap, uint32_t i, uint32_t j)
+{
+    return tilemap->chunks[(j >> BB_CHUNK_SHIFT) * BB_CHUNKS_WIDE + (i >> BB_CHUNK_SHIFT)];
+}
+
+/**
+ * @brief Get the index of a tile within its chunk
+ *
+ * @param i The tile's column
+ * @param j The tile's row
+ * @return The index in the chunk's arrays
+ */
+static inline uint32_t bb_chunkTileIdx(uint32_t i, uint32_t j)
+{
+    return ((j & BB_CHUNK_MASK) << BB_CHUNK_SHIFT) | (i & BB_CHUNK_MASK);
+}
+
+static inline int8_t bb_getFgHealth(const bb_tilemap_t* tilemap, uint32_t i, uint32_t j)
+{
+    return bb_getChunk(tilemap, i, j)->fgHealth[bb_chunkTileIdx(i, j)];
+}
+
+static inline void bb_setFgHealth(bb_tilemap_t* tilemap, uint32_t i, uint32_t j, int8_t health)
+{
+    bb_getChunk(tilemap, i, j)->fgHealth[bb_chunkTileIdx(i, j)] = health;
+}
+
+static inline int8_t bb_getMgHealth(const bb_tilemap_t* tilemap, uint32_t i, uint32_t j)
+{
+    return bb_getChunk(tilemap, i, j)->mgHealth[bb_chunkTileIdx(i, j)];
+}
+
+static inline void bb_setMgHealth(bb_tilemap_t* tilemap, uint32_t i, uint32_t j, int8_t health)
+{
+    bb_getChunk(tilemap, i, j)->mgHealth[bb_chunkTileIdx(i, j)] = health;
+}
+
+/**
+ * @brief Get the health of a foreground or midground tile
+ *
+ * @param tilemap The tilemap
+ * @param i The tile's column
+ * @param j The tile's row
+ * @param z true for the foreground, false for the midground
+ * @return The tile's health. 0 is air.
+ */
+static inline int8_t bb_getHealth(const bb_tilemap_t* tilemap, uint32_t i, uint32_t j, bool z)
+{
+    return z ? bb_getFgHealth(tilemap, i, j) : bb_getMgHealth(tilemap, i, j);
+}
+
+static inline bb_embeddable_t bb_getEmbed(const bb_tilemap_t* tilemap, uint32_t i, uint32_t j)
+{
+    return tilemap->fgEmbeds[j * TILE_FIELD_WIDTH + i];
+}
+
+static inline void bb_setEmbed(bb_tilemap_t* tilemap, uint32_t i, uint32_t j, bb_embeddable_t embed)
+{
+    tilemap->fgEmbeds[j * TILE_FIELD_WIDTH + i] = embed;
+}
+
+static inline bb_entity_t* bb_getTileEntity(const bb_tilemap_t* tilemap, uint32_t i, uint32_t j)
+{
+    return tilemap->fgEntities[j * TILE_FIELD_WIDTH + i];
+}
+
+static inline void bb_setTileEntity(bb_tilemap_t* tilemap, uint32_t i, uint32_t j, bb_entity_t* entity)
+{
+    tilemap->fgEntities[j * TILE_FIELD_WIDTH + i] = entity;
+}
+
+/**
+ * @brief Get the index of a packed tile position in the pathfinding cost arrays
+ *
+ * @param pos A position packed with BB_TILE_POS()
+ * @return The index in gCosts and hCosts
+ */
+static inline uint32_t bb_tileCostIdx(uint16_t pos)
+{
+    return (pos >> 15) * BB_NUM_TILES + ((pos >> 7) & 0xFF) * TILE_FIELD_WIDTH + (pos & 0x7F);
+}
+
 #endif
\ No newline at end of file
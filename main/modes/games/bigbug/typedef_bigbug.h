@@ -25,8 +25,6 @@ typedef struct bb_tilemap_t bb_tilemap_t;
 typedef struct bb_hitInfo_t bb_hitInfo_t;
 typedef struct bb_camera_t bb_camera_t;
 typedef struct bb_gameData_t bb_gameData_t;
-typedef struct bb_midgroundTileInfo_t bb_midgroundTileInfo_t;
-typedef struct bb_foregroundTileInfo_t bb_foregroundTileInfo_t;
 
 typedef void (*bb_callbackFunction_t)(bb_entity_t* self);
 
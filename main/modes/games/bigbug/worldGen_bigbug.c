@@ -30,19 +30,17 @@ void bb_generateWorld(bb_tilemap_t* tilemap, int8_t* oldBoosterYs)
     // (booster positions).
     uint8_t washingMachineXPositions[35] = {0};
 
+    // Reset the pathfinding costs
+    memset(tilemap->gCosts, 0, 2 * BB_NUM_TILES * sizeof(uint16_t));
+    memset(tilemap->hCosts, 0, 2 * BB_NUM_TILES * sizeof(uint16_t));
+
     // Set all the tiles
     for (int i = 0; i < TILE_FIELD_WIDTH; i++)
     {
         for (int j = 0; j < TILE_FIELD_HEIGHT; j++)
         {
-            tilemap->fgTiles[i][j].pos    = i | (j << 7) | (1 << 15);
-            tilemap->mgTiles[i][j].pos    = i | (j << 7); // z is implicitly zero
-            tilemap->fgTiles[i][j].embed  = NOTHING_EMBED;
-            tilemap->fgTiles[i][j].entity = NULL;
-            tilemap->fgTiles[i][j].gCost  = 0;
-            tilemap->mgTiles[i][j].gCost  = 0;
-            tilemap->fgTiles[i][j].hCost  = 0;
-            tilemap->mgTiles[i][j].hCost  = 0;
+            bb_setEmbed(tilemap, i, j, NOTHING_EMBED);
+            bb_setTileEntity(tilemap, i, j, NULL);
 
             uint32_t rgbCol = paletteToRGB(levelWsg.px[(j * levelWsg.w) + i]);
 
@@ -51,40 +49,41 @@ void bb_generateWorld(bb_tilemap_t* tilemap, int8_t* oldBoosterYs)
             {
                 case 102:
                 {
-                    tilemap->fgTiles[i][j].health = 1;
+                    bb_setFgHealth(tilemap, i, j, 1);
                     break;
                 }
                 case 153:
                 {
-                    tilemap->fgTiles[i][j].health = 4;
+                    bb_setFgHealth(tilemap, i, j, 4);
                     break;
                 }
                 case 204:
                 {
-                    tilemap->fgTiles[i][j].health = 10;
+                    bb_setFgHealth(tilemap, i, j, 10);
                     break;
                 }
                 case 255:
                 {
-                    tilemap->fgTiles[i][j].health = 100;
+                    bb_setFgHealth(tilemap, i, j, 100);
                     break;
                 }
                 default: // case 0
                 {
-                    tilemap->fgTiles[i][j].health = 0;
+                    bb_setFgHealth(tilemap, i, j, 0);
                     // blue value used for washing machines, cars, swadges/donuts
                     switch (rgbCol & 255)
                     {
                         case 51:
                         {
-                            tilemap->fgTiles[i][j].embed
-                                = bb_randomInt(0, 1) == 0 ? BB_CAR_WITH_DONUT_EMBED : BB_CAR_WITH_SWADGE_EMBED;
+                            bb_setEmbed(tilemap, i, j,
+                                        bb_randomInt(0, 1) == 0 ? BB_CAR_WITH_DONUT_EMBED : BB_CAR_WITH_SWADGE_EMBED);
                             break;
                         }
                         case 102:
                         {
-                            tilemap->fgTiles[i][j].embed = bb_randomInt(0, 1) == 0 ? BB_FOOD_CART_WITH_DONUT_EMBED
-                                                                                   : BB_FOOD_CART_WITH_SWADGE_EMBED;
+                            bb_setEmbed(tilemap, i, j,
+                                        bb_randomInt(0, 1) == 0 ? BB_FOOD_CART_WITH_DONUT_EMBED
+                                                                : BB_FOOD_CART_WITH_SWADGE_EMBED);
                             break;
                         }
                         case 153:
@@ -100,7 +99,7 @@ void bb_generateWorld(bb_tilemap_t* tilemap, int8_t* oldBoosterYs)
                                     else if (washingMachineXPositions[lookupIdx] == 0)
                                     {
                                         washingMachineXPositions[lookupIdx] = i;
-                                        tilemap->fgTiles[i][j].embed        = WASHING_MACHINE_EMBED;
+                                        bb_setEmbed(tilemap, i, j, WASHING_MACHINE_EMBED);
                                         break;
                                     }
                                 }
@@ -121,54 +120,54 @@ void bb_generateWorld(bb_tilemap_t* tilemap, int8_t* oldBoosterYs)
             {
                 case 51:
                 {
-                    tilemap->mgTiles[i][j].health = tilemap->fgTiles[i][j].health == 0
-                                                        ? midgroundHealthValues[bb_randomInt(0, 2)]
-                                                        : tilemap->fgTiles[i][j].health;
+                    int8_t fgHealth = bb_getFgHealth(tilemap, i, j);
+                    bb_setMgHealth(tilemap, i, j,
+                                   fgHealth == 0 ? midgroundHealthValues[bb_randomInt(0, 2)] : fgHealth);
                     break;
                 }
                 case 102:
                 {
-                    tilemap->mgTiles[i][j].health = 0;
-                    tilemap->fgTiles[i][j].embed  = DOOR_EMBED;
+                    bb_setMgHealth(tilemap, i, j, 0);
+                    bb_setEmbed(tilemap, i, j, DOOR_EMBED);
                     break;
                 }
                 case 153:
                 {
-                    tilemap->mgTiles[i][j].health = 0;
-                    tilemap->fgTiles[i][j].embed  = FINAL_BOSS_EMBED;
+                    bb_setMgHealth(tilemap, i, j, 0);
+                    bb_setEmbed(tilemap, i, j, FINAL_BOSS_EMBED);
                     break;
                 }
                 default:
                 {
-                    tilemap->mgTiles[i][j].health = 0;
+                    bb_setMgHealth(tilemap, i, j, 0);
                     break;
                 }
             }
 
             // blue channel is also for enemy density where there are foreground tiles.
-            if (tilemap->fgTiles[i][j].health > 0)
+            if (bb_getFgHealth(tilemap, i, j) > 0)
             {
                 if (bb_randomInt(0, 999) < 15 && i > 20 && i < 52)
                 {
-                    tilemap->fgTiles[i][j].embed = SKELETON_EMBED;
+                    bb_setEmbed(tilemap, i, j, SKELETON_EMBED);
                 }
                 else if (bb_randomInt(0, 99) < (((rgbCol & 255) / 51) * 15))
                 {
-                    tilemap->fgTiles[i][j].embed = EGG_EMBED;
+                    bb_setEmbed(tilemap, i, j, EGG_EMBED);
                 }
             }
         }
     }
 
-    tilemap->fgTiles[TILE_FIELD_WIDTH / 2 - 7][0].embed = EGG_EMBED; // tutorial egg
+    bb_setEmbed(tilemap, TILE_FIELD_WIDTH / 2 - 7, 0, EGG_EMBED); // tutorial egg
 
     if (level == 3)
     {
-        tilemap->fgTiles[53][27].embed = BRICK_TUTORIAL_EMBED;
+        bb_setEmbed(tilemap, 53, 27, BRICK_TUTORIAL_EMBED);
     }
     else if (level == 4)
     {
-        tilemap->fgTiles[20][8].embed = BRICK_TUTORIAL_EMBED;
+        bb_setEmbed(tilemap, 20, 8, BRICK_TUTORIAL_EMBED);
     }
 
     // carve out three tiles where any old boosters are buried
@@ -180,8 +179,8 @@ void bb_generateWorld(bb_tilemap_t* tilemap, int8_t* oldBoosterYs)
             {
                 if (carveY >= 0)
                 {
-                    tilemap->fgTiles[34 + booster * 3][carveY].health = 0;
-                    tilemap->fgTiles[35 + booster * 3][carveY].embed  = NOTHING_EMBED;
+                    bb_setFgHealth(tilemap, 34 + booster * 3, carveY, 0);
+                    bb_setEmbed(tilemap, 35 + booster * 3, carveY, NOTHING_EMBED);
                 }
             }
         }
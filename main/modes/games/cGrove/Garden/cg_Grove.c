@@ -100,6 +100,13 @@ static char namePrompt[] = "Enter the Chowa's name!";
  */
 static void cg_attemptGrab(cGrove_t* cg);
 
+/**
+ * @brief Puts down the held Chowa. If it was picked up on the way to an item, it gives up on that item.
+ *
+ * @param cg Game Object
+ */
+static void cg_releaseChowa(cGrove_t* cg);
+
 /**
  * @brief Input handling for garden
  *
@@ -221,6 +228,7 @@ void cg_initGrove(cGrove_t* cg)
     cg_setupBorders(cg);
 
     // Initialize Chowa
+    cg->grove.nextDecisionIdx = 0;
     for (int32_t i = 0; i < CG_MAX_CHOWA; i++)
     {
         cg->grove.chowa[i].chowa = &cg->chowa[i];
@@ -487,7 +495,7 @@ void cg_runGrove(cGrove_t* cg, int64_t elapsedUS)
                 cg->grove.ring.despawnTimer = 0;
             }
 
-            // Chowa AI
+            // Chowa AI. Every Chowa moves each frame, but only a few pick new behaviors.
             for (int32_t idx = 0; idx < CG_MAX_CHOWA + CG_GROVE_MAX_GUEST_CHOWA; idx++)
             {
                 if (cg->grove.chowa[idx].chowa->active)
@@ -495,6 +503,7 @@ void cg_runGrove(cGrove_t* cg, int64_t elapsedUS)
                     cg_GroveAI(cg, &cg->grove.chowa[idx], elapsedUS);
                 }
             }
+            cg_GroveAIDecide(cg);
             cg_GroveEggAI(cg, elapsedUS);
 
             // Draw
@@ -881,6 +890,19 @@ static void cg_attemptGrab(cGrove_t* cg)
     }
 }
 
+static void cg_releaseChowa(cGrove_t* cg)
+{
+    cgGroveChowa_t* c      = cg->grove.heldChowa;
+    cg->grove.holdingChowa = false;
+    c->gState              = CHOWA_IDLE;
+    if (c->nextState == CHOWA_GRAB_ITEM)
+    {
+        // The item was never grabbed, so leave it for any Chowa
+        c->heldItem  = NULL;
+        c->nextState = CHOWA_IDLE;
+    }
+}
+
 static void cg_handleInputGarden(cGrove_t* cg)
 {
     buttonEvt_t evt;
@@ -916,8 +938,7 @@ static void cg_handleInputGarden(cGrove_t* cg)
                     }
                     else if (cg->grove.holdingChowa)
                     {
-                        cg->grove.holdingChowa      = false;
-                        cg->grove.heldChowa->gState = CHOWA_IDLE;
+                        cg_releaseChowa(cg);
                     }
                     else if (cg->grove.ring.active && rectRectIntersection(rect, cg->grove.ring.aabb, &temp))
                     {
@@ -995,8 +1016,7 @@ static void cg_handleInputGarden(cGrove_t* cg)
                     }
                     else if (cg->grove.holdingChowa)
                     {
-                        cg->grove.holdingChowa      = false;
-                        cg->grove.heldChowa->gState = CHOWA_IDLE;
+                        cg_releaseChowa(cg);
                     }
                     else if (cg->grove.ring.active && rectRectIntersection(rect, cg->grove.ring.aabb, &temp))
                     {
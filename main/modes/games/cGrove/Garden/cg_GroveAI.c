@@ -25,6 +25,19 @@
 
 #define SECOND 1000000
 
+//==============================================================================
+// Structs
+//==============================================================================
+
+/**
+ * @brief Queries which are shared by all the Chowa picking new behaviors in a frame, so they're only run once
+ */
+typedef struct
+{
+    int8_t freeItems[CG_GROVE_MAX_ITEMS]; ///< Indices of items which can be picked up and no Chowa is going for
+    int8_t numFreeItems;                  ///< Number of items in freeItems
+} cgGroveAICache_t;
+
 //==============================================================================
 // Function Declarations
 //==============================================================================
@@ -42,15 +55,33 @@ static void cg_GroveGetRandMovePoint(cGrove_t* cg, cgGroveChowa_t* c);
  *
  * @param cg Game Data
  * @param c Chowa Data
+ * @param cache Queries shared by the Chowa picking new behaviors this frame
+ */
+static cgChowaStateGarden_t cg_getNewTask(cGrove_t* cg, cgGroveChowa_t* c, cgGroveAICache_t* cache);
+
+/**
+ * @brief Runs the queries shared by the Chowa picking new behaviors this frame
+ *
+ * @param cg Game Data
+ * @param cache The cache to fill
+ */
+static void cg_GroveFillAICache(cGrove_t* cg, cgGroveAICache_t* cache);
+
+/**
+ * @brief Moves the Chowa one step towards its target
+ *
+ * @param c Chowa Data
+ * @return true if the Chowa reached the target, false if it's still on the way
  */
-static cgChowaStateGarden_t cg_getNewTask(cGrove_t* cg, cgGroveChowa_t* c);
+static bool cg_GroveStepToTarget(cgGroveChowa_t* c);
 
 //==============================================================================
 // Functions
 //==============================================================================
 
 /**
- * @brief
+ * @brief Updates timers and moves the Chowa. This is cheap enough to run for every Chowa every frame. Chowa which are
+ * idle wait for cg_GroveAIDecide() to pick a new behavior.
  *
  * @param cg Game data
  * @param chowa The chowa to run AI on
@@ -105,10 +136,7 @@ void cg_GroveAI(cGrove_t* cg, cgGroveChowa_t* c, int64_t elapsedUs)
     {
         case CHOWA_IDLE:
         {
-            // Chowa is essentially unset. Look for new behavior
-            c->nextState = CHOWA_IDLE;
-            c->gState    = cg_getNewTask(cg, c);
-            c->animFrame = 0; // Reset animation frame to avoid displaying garbage data
+            // Chowa is essentially unset. Wait for cg_GroveAIDecide() to find a new behavior
             break;
         }
         case CHOWA_STATIC:
@@ -128,8 +156,7 @@ void cg_GroveAI(cGrove_t* cg, cgGroveChowa_t* c, int64_t elapsedUs)
                 cg_GroveGetRandMovePoint(cg, c);
                 return;
             }
-            vec_t difference = {.x = c->targetPos.x - c->aabb.pos.x, .y = c->targetPos.y - c->aabb.pos.y};
-            if (sqMagVec2d(difference) < pow(c->precision, 2))
+            if (cg_GroveStepToTarget(c))
             {
                 c->timeLeft = c->nextTimeLeft;
                 c->gState   = c->nextState;
@@ -142,19 +169,13 @@ void cg_GroveAI(cGrove_t* cg, cgGroveChowa_t* c, int64_t elapsedUs)
                     c->chowa->stats[CG_SPEED] += 1;
                 }
             }
-            fastNormVec(&difference.x, &difference.y);
-            int16_t angle = getAtan2(difference.y, difference.x);
-            c->angle      = angle;
-            c->aabb.pos.x += difference.x / 128;
-            c->aabb.pos.y += difference.y / 128;
             break;
         }
         case CHOWA_CHASE:
         {
             // Calculate the distance to target
-            c->targetPos     = addVec2d(cg->grove.cursor.pos, cg->grove.camera.pos);
-            vec_t difference = {.x = c->targetPos.x - c->aabb.pos.x, .y = c->targetPos.y - c->aabb.pos.y};
-            if (sqMagVec2d(difference) < pow(c->precision, 2))
+            c->targetPos = addVec2d(cg->grove.cursor.pos, cg->grove.camera.pos);
+            if (cg_GroveStepToTarget(c))
             {
                 c->timeLeft = c->nextTimeLeft;
                 c->gState   = c->nextState;
@@ -164,11 +185,6 @@ void cg_GroveAI(cGrove_t* cg, cgGroveChowa_t* c, int64_t elapsedUs)
                     c->chowa->stats[CG_STAMINA] += 1;
                 }
             }
-            fastNormVec(&difference.x, &difference.y);
-            int16_t angle = getAtan2(difference.y, difference.x);
-            c->angle      = angle;
-            c->aabb.pos.x += difference.x / 128;
-            c->aabb.pos.y += difference.y / 128;
             break;
         }
         case CHOWA_GRAB_ITEM:
@@ -380,6 +396,46 @@ void cg_GroveAI(cGrove_t* cg, cgGroveChowa_t* c, int64_t elapsedUs)
     }
 }
 
+/**
+ * @brief Picks new behaviors for idle Chowa. At most ::CG_GROVE_AI_DECISIONS_PER_FRAME Chowa decide each frame, taking
+ * turns so none of them wait for long, and the rest stay idle until a later frame.
+ *
+ * @param cg Game data
+ */
+void cg_GroveAIDecide(cGrove_t* cg)
+{
+    const int32_t numChowa = CG_MAX_CHOWA + CG_GROVE_MAX_GUEST_CHOWA;
+    cgGroveAICache_t cache;
+    bool cacheFilled  = false;
+    int32_t decisions = 0;
+
+    int32_t startIdx = cg->grove.nextDecisionIdx;
+    for (int32_t n = 0; n < numChowa && decisions < CG_GROVE_AI_DECISIONS_PER_FRAME; n++)
+    {
+        int32_t idx       = (startIdx + n) % numChowa;
+        cgGroveChowa_t* c = &cg->grove.chowa[idx];
+        if (!c->chowa->active || c->gState != CHOWA_IDLE)
+        {
+            continue;
+        }
+
+        // Only run the shared queries if someone needs them
+        if (!cacheFilled)
+        {
+            cg_GroveFillAICache(cg, &cache);
+            cacheFilled = true;
+        }
+
+        c->nextState = CHOWA_IDLE;
+        c->gState    = cg_getNewTask(cg, c, &cache);
+        c->animFrame = 0; // Reset animation frame to avoid displaying garbage data
+        decisions++;
+
+        // The next Chowa in line goes first next frame
+        cg->grove.nextDecisionIdx = (idx + 1) % numChowa;
+    }
+}
+
 /**
  * @brief Handles updating the egg
  *
@@ -444,7 +500,49 @@ static void cg_GroveGetRandMovePoint(cGrove_t* cg, cgGroveChowa_t* c)
     c->targetPos = targetPos.pos;
 }
 
-static cgChowaStateGarden_t cg_getNewTask(cGrove_t* cg, cgGroveChowa_t* c)
+static void cg_GroveFillAICache(cGrove_t* cg, cgGroveAICache_t* cache)
+{
+    // Items which a Chowa is walking to grab, or grabbing, aren't free. heldItem may be left over from a walk that was
+    // interrupted, so check the state too
+    bool claimed[CG_GROVE_MAX_ITEMS] = {false};
+    for (int32_t idx = 0; idx < CG_MAX_CHOWA + CG_GROVE_MAX_GUEST_CHOWA; idx++)
+    {
+        cgGroveChowa_t* c = &cg->grove.chowa[idx];
+        bool grabbing
+            = (c->gState == CHOWA_WALK && c->nextState == CHOWA_GRAB_ITEM) || c->gState == CHOWA_GRAB_ITEM;
+        if (!grabbing)
+        {
+            continue;
+        }
+        cgItem_t* item = c->heldItem;
+        if (item != NULL && item >= cg->grove.items && item < &cg->grove.items[CG_GROVE_MAX_ITEMS])
+        {
+            claimed[item - cg->grove.items] = true;
+        }
+    }
+
+    cache->numFreeItems = 0;
+    for (int32_t idx = 0; idx < CG_GROVE_MAX_ITEMS; idx++)
+    {
+        if (cg->grove.items[idx].active && !claimed[idx] && 0 != strcmp(shopMenuItems[11], cg->grove.items[idx].name))
+        {
+            cache->freeItems[cache->numFreeItems++] = idx;
+        }
+    }
+}
+
+static bool cg_GroveStepToTarget(cgGroveChowa_t* c)
+{
+    vec_t difference = {.x = c->targetPos.x - c->aabb.pos.x, .y = c->targetPos.y - c->aabb.pos.y};
+    bool arrived     = sqMagVec2d(difference) < c->precision * c->precision;
+    fastNormVec(&difference.x, &difference.y);
+    c->angle = getAtan2(difference.y, difference.x);
+    c->aabb.pos.x += difference.x / 128;
+    c->aabb.pos.y += difference.y / 128;
+    return arrived;
+}
+
+static cgChowaStateGarden_t cg_getNewTask(cGrove_t* cg, cgGroveChowa_t* c, cgGroveAICache_t* cache)
 {
     // If in water, continue moving until outside the water
     vec_t temp;
@@ -545,21 +643,31 @@ static cgChowaStateGarden_t cg_getNewTask(cGrove_t* cg, cgGroveChowa_t* c)
         }
         return CHOWA_USE_ITEM;
     }
-    // Check if items present on map
-    if (c->heldItem == NULL)
+    // Go for the closest free item on the map
+    if (c->heldItem == NULL && !c->ballInAir && cache->numFreeItems > 0)
     {
-        for (int idx = 0; idx < CG_GROVE_MAX_ITEMS; idx++)
+        int32_t closest     = 0;
+        int32_t closestDist = INT32_MAX;
+        for (int32_t i = 0; i < cache->numFreeItems; i++)
         {
-            if (cg->grove.items[idx].active && 0 != strcmp(shopMenuItems[11], cg->grove.items[idx].name)
-                && !c->ballInAir)
+            vec_t difference = subVec2d(cg->grove.items[cache->freeItems[i]].aabb.pos, c->aabb.pos);
+            int32_t dist     = sqMagVec2d(difference);
+            if (dist < closestDist)
             {
-                c->targetPos = cg->grove.items[idx].aabb.pos;
-                c->heldItem  = &cg->grove.items[idx];
-                c->precision = 20.0f;
-                c->nextState = CHOWA_GRAB_ITEM;
-                return CHOWA_WALK;
+                closest     = i;
+                closestDist = dist;
             }
         }
+
+        // Claim the item so other Chowa deciding this frame don't go for it too
+        cgItem_t* item            = &cg->grove.items[cache->freeItems[closest]];
+        cache->freeItems[closest] = cache->freeItems[cache->numFreeItems - 1];
+        cache->numFreeItems--;
+        c->targetPos = item->aabb.pos;
+        c->heldItem  = item;
+        c->precision = 20.0f;
+        c->nextState = CHOWA_GRAB_ITEM;
+        return CHOWA_WALK;
     }
     // Otherwise, choose randomly
     switch (esp_random() % 3)
@@ -21,4 +21,5 @@
 //==============================================================================
 
 void cg_GroveAI(cGrove_t* cg, cgGroveChowa_t* chowa, int64_t elapsedUs);
+void cg_GroveAIDecide(cGrove_t* cg);
 void cg_GroveEggAI(cGrove_t* cg, int64_t elapsedUs);
\ No newline at end of file
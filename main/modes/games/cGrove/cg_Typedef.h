@@ -213,6 +213,8 @@ typedef struct
 
 #define CG_GROVE_SCREEN_BOUNDARY 32 ///< How close the cursor can get to the edge of the screen
 
+#define CG_GROVE_AI_DECISIONS_PER_FRAME 2 ///< Max number of Chowa which pick a new behavior each frame
+
 // Enum =================================
 typedef enum
 {
@@ -349,6 +351,7 @@ typedef struct
     cgGroveMoney_t ring;                                           ///< Ring available to collect
     cgEgg_t unhatchedEggs[CG_MAX_CHOWA];                           ///< Array of un-hatched eggs
     int8_t hatchIdx;                                               ///< Used for text input
+    int8_t nextDecisionIdx;                                        ///< First Chowa to pick a new behavior next frame
 
     // Menu
     menu_t* menu;                  ///< Shop menu object
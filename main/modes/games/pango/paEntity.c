@@ -1341,9 +1341,8 @@ bool pa_hitBlockTileCollisionHandler(paEntity_t* self, uint8_t tileId, uint8_t t
     {
         soundPlaySfx(&(self->soundManager->sndBlockStop), 1);
 
-        self->tilemap->map[PA_TO_TILECOORDS(self->y >> SUBPIXEL_RESOLUTION) * self->tilemap->mapWidth
-                           + PA_TO_TILECOORDS(self->x >> SUBPIXEL_RESOLUTION)]
-            = self->state;
+        pa_setTile(self->tilemap, PA_TO_TILECOORDS(self->x >> SUBPIXEL_RESOLUTION),
+                   PA_TO_TILECOORDS(self->y >> SUBPIXEL_RESOLUTION), self->state);
 
         if (PA_TO_TILECOORDS(self->x >> SUBPIXEL_RESOLUTION) == self->homeTileX
             && PA_TO_TILECOORDS(self->y >> SUBPIXEL_RESOLUTION) == self->homeTileY)
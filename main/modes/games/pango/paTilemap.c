@@ -13,6 +13,17 @@
 
 #include "cnfs.h"
 
+//==============================================================================
+// Function Prototypes
+//==============================================================================
+
+static int32_t pa_layerWrap(int32_t v, int32_t size);
+static void pa_scrollTileLayer(paTilemap_t* tilemap, int16_t tx, int16_t ty);
+static void pa_invalidateTileLayerId(paTilemap_t* tilemap, uint8_t tileId);
+static void pa_drawTileLayerCell(paTilemap_t* tilemap, int32_t col, int32_t row);
+static void pa_updateTileLayer(paTilemap_t* tilemap);
+static void pa_blitTileLayer(paTilemap_t* tilemap);
+
 //==============================================================================
 // Functions
 //==============================================================================
@@ -27,53 +38,287 @@ void pa_initializeTileMap(paTilemap_t* tilemap, paWsgManager_t* wsgManager)
     tilemap->executeTileSpawnRow    = -1;
 
     tilemap->wsgManager = wsgManager;
+
+    tilemap->layer = heap_caps_calloc(PA_LAYER_WIDTH_PIXELS * PA_LAYER_HEIGHT_PIXELS, sizeof(paletteColor_t),
+                                      MALLOC_CAP_SPIRAM);
+    pa_invalidateTileLayer(tilemap);
 }
 
+/**
+ * @brief Draw the visible part of the tilemap. Tiles are drawn into the retained layer only when they change or scroll
+ * into view, then the layer is copied to the display a row at a time.
+ *
+ * @param tilemap The tilemap to draw
+ */
 void pa_drawTileMap(paTilemap_t* tilemap)
 {
-    for (int32_t y = (tilemap->mapOffsetY >> PA_TILE_SIZE_IN_POWERS_OF_2);
-         y < (tilemap->mapOffsetY >> PA_TILE_SIZE_IN_POWERS_OF_2) + PA_TILE_MAP_DISPLAY_HEIGHT_TILES; y++)
+    pa_spawnTileEntities(tilemap);
+
+    if (NULL == tilemap->layer)
+    {
+        return;
+    }
+
+    pa_updateTileLayer(tilemap);
+    pa_blitTileLayer(tilemap);
+}
+
+/**
+ * @brief Spawn entities from the spawn tiles in the rows and columns which scrolled into view, or in the whole view if
+ * executeTileSpawnAll is set
+ *
+ * @param tilemap The tilemap to spawn entities from
+ */
+void pa_spawnTileEntities(paTilemap_t* tilemap)
+{
+    if (!tilemap->tileSpawnEnabled
+        || (tilemap->executeTileSpawnColumn < 0 && tilemap->executeTileSpawnRow < 0 && !tilemap->executeTileSpawnAll))
     {
-        if (y >= tilemap->mapHeight)
+        tilemap->executeTileSpawnAll = false;
+        return;
+    }
+
+    int32_t tx0 = MAX(tilemap->mapOffsetX >> PA_TILE_SIZE_IN_POWERS_OF_2, 0);
+    int32_t ty0 = MAX(tilemap->mapOffsetY >> PA_TILE_SIZE_IN_POWERS_OF_2, 0);
+    int32_t tx1 = MIN((tilemap->mapOffsetX >> PA_TILE_SIZE_IN_POWERS_OF_2) + PA_TILE_MAP_DISPLAY_WIDTH_TILES,
+                      tilemap->mapWidth);
+    int32_t ty1 = MIN((tilemap->mapOffsetY >> PA_TILE_SIZE_IN_POWERS_OF_2) + PA_TILE_MAP_DISPLAY_HEIGHT_TILES,
+                      tilemap->mapHeight);
+
+    for (int32_t y = ty0; y < ty1; y++)
+    {
+        // Only check the tiles in the row or column which scrolled into view
+        bool wholeRow = tilemap->executeTileSpawnAll || tilemap->executeTileSpawnRow == y;
+        if (!wholeRow && (tilemap->executeTileSpawnColumn < tx0 || tilemap->executeTileSpawnColumn >= tx1))
         {
-            break;
+            continue;
         }
 
-        for (int32_t x = (tilemap->mapOffsetX >> PA_TILE_SIZE_IN_POWERS_OF_2);
-             x < (tilemap->mapOffsetX >> PA_TILE_SIZE_IN_POWERS_OF_2) + PA_TILE_MAP_DISPLAY_WIDTH_TILES; x++)
+        for (int32_t x = wholeRow ? tx0 : tilemap->executeTileSpawnColumn;
+             x < (wholeRow ? tx1 : tilemap->executeTileSpawnColumn + 1); x++)
         {
-            if (x >= tilemap->mapWidth)
-            {
-                break;
-            }
-            else if (x < 0)
+            uint8_t tile = tilemap->map[(y * tilemap->mapWidth) + x];
+            if (tile > 127)
             {
-                continue;
+                pa_tileSpawnEntity(tilemap, tile - 128, x, y);
             }
+        }
+    }
 
-            uint8_t tile = tilemap->map[(y * tilemap->mapWidth) + x];
+    tilemap->executeTileSpawnAll = false;
+}
 
-            if (tile < PA_TILE_WALL_0 || tile == PA_TILE_INVISIBLE_BLOCK)
-            {
-                continue;
-            }
+/**
+ * @brief Redraw the whole retained tile layer on the next frame, e.g. after a new map is loaded
+ *
+ * @param tilemap The tilemap to invalidate the layer of
+ */
+void pa_invalidateTileLayer(paTilemap_t* tilemap)
+{
+    tilemap->layerValid = false;
+}
+
+/**
+ * @brief Wrap a coordinate into the retained layer, for coordinates which may be negative
+ *
+ * @param v The coordinate
+ * @param size The size of the layer in the coordinate's units
+ * @return The coordinate modulo size, from 0 to size - 1
+ */
+static int32_t pa_layerWrap(int32_t v, int32_t size)
+{
+    int32_t m = v % size;
+    return (m < 0) ? m + size : m;
+}
+
+/**
+ * @brief Move the retained layer's window to a new top left tile, marking only the columns and rows which came into
+ * view to be redrawn
+ *
+ * @param tilemap The tilemap to scroll the layer of
+ * @param tx The tile X coordinate of the new top left
+ * @param ty The tile Y coordinate of the new top left
+ */
+static void pa_scrollTileLayer(paTilemap_t* tilemap, int16_t tx, int16_t ty)
+{
+    int32_t dx = tx - tilemap->layerTx;
+    int32_t dy = ty - tilemap->layerTy;
+
+    if (ABS(dx) >= PA_LAYER_WIDTH_TILES || ABS(dy) >= PA_LAYER_HEIGHT_TILES)
+    {
+        // Scrolled a whole screen, nothing can be kept
+        tilemap->layerValid = false;
+        return;
+    }
+
+    // Columns which came into view, from either side
+    uint32_t newCols = 0;
+    int32_t colStart = (dx > 0) ? tilemap->layerTx + PA_LAYER_WIDTH_TILES : tx;
+    for (int32_t i = 0; i < ABS(dx); i++)
+    {
+        newCols |= 1 << pa_layerWrap(colStart + i, PA_LAYER_WIDTH_TILES);
+    }
+
+    // Rows which came into view, from either side
+    uint32_t newRows = 0;
+    int32_t rowStart = (dy > 0) ? tilemap->layerTy + PA_LAYER_HEIGHT_TILES : ty;
+    for (int32_t i = 0; i < ABS(dy); i++)
+    {
+        newRows |= 1 << pa_layerWrap(rowStart + i, PA_LAYER_HEIGHT_TILES);
+    }
 
-            // Draw only non-garbage tiles
-            if (tile > 0 && tile < 13)
+    for (int32_t row = 0; row < PA_LAYER_HEIGHT_TILES; row++)
+    {
+        tilemap->layerDirty[row] |= (newRows & (1 << row)) ? ((1 << PA_LAYER_WIDTH_TILES) - 1) : newCols;
+    }
+
+    tilemap->layerTx = tx;
+    tilemap->layerTy = ty;
+}
+
+/**
+ * @brief Mark every tile in the retained layer's window with the given ID to be redrawn, e.g. after its image changed
+ *
+ * @param tilemap The tilemap to invalidate tiles in
+ * @param tileId The tile ID to redraw
+ */
+static void pa_invalidateTileLayerId(paTilemap_t* tilemap, uint8_t tileId)
+{
+    for (int32_t ty = MAX(tilemap->layerTy, 0);
+         ty < MIN(tilemap->layerTy + PA_LAYER_HEIGHT_TILES, tilemap->mapHeight); ty++)
+    {
+        for (int32_t tx = MAX(tilemap->layerTx, 0);
+             tx < MIN(tilemap->layerTx + PA_LAYER_WIDTH_TILES, tilemap->mapWidth); tx++)
+        {
+            if (tilemap->map[ty * tilemap->mapWidth + tx] == tileId)
             {
-                drawWsgTile(tilemap->wsgManager->tiles[tile - 1], x * PA_TILE_SIZE - tilemap->mapOffsetX,
-                            y * PA_TILE_SIZE - tilemap->mapOffsetY);
+                tilemap->layerDirty[pa_layerWrap(ty, PA_LAYER_HEIGHT_TILES)]
+                    |= 1 << pa_layerWrap(tx, PA_LAYER_WIDTH_TILES);
             }
-            else if (tile > 127 && tilemap->tileSpawnEnabled
-                     && (tilemap->executeTileSpawnColumn == x || tilemap->executeTileSpawnRow == y
-                         || tilemap->executeTileSpawnAll))
+        }
+    }
+}
+
+/**
+ * @brief Draw one tile of the window into the retained layer
+ *
+ * @param tilemap The tilemap to draw the tile of
+ * @param col The column of the layer to draw in
+ * @param row The row of the layer to draw in
+ */
+static void pa_drawTileLayerCell(paTilemap_t* tilemap, int32_t col, int32_t row)
+{
+    // Find which tile of the window is stored in this cell
+    int32_t tx = tilemap->layerTx + pa_layerWrap(col - tilemap->layerTx, PA_LAYER_WIDTH_TILES);
+    int32_t ty = tilemap->layerTy + pa_layerWrap(row - tilemap->layerTy, PA_LAYER_HEIGHT_TILES);
+
+    const wsg_t* wsg = NULL;
+    if (NULL != tilemap->map && tx >= 0 && ty >= 0 && tx < tilemap->mapWidth && ty < tilemap->mapHeight)
+    {
+        // Draw only non-garbage tiles
+        uint8_t tile = tilemap->map[(ty * tilemap->mapWidth) + tx];
+        if (tile >= PA_TILE_WALL_0 && tile <= PA_TILE_SPAWN_BLOCK_2)
+        {
+            wsg = tilemap->wsgManager->tiles[tile - 1];
+        }
+    }
+
+    paletteColor_t* px = &tilemap->layer[(row * PA_TILE_SIZE * PA_LAYER_WIDTH_PIXELS) + (col * PA_TILE_SIZE)];
+    for (int32_t y = 0; y < PA_TILE_SIZE; y++)
+    {
+        if (NULL != wsg)
+        {
+            memcpy(px, &wsg->px[y * wsg->w], PA_TILE_SIZE);
+        }
+        else
+        {
+            memset(px, c000, PA_TILE_SIZE);
+        }
+        px += PA_LAYER_WIDTH_PIXELS;
+    }
+}
+
+/**
+ * @brief Bring the retained layer up to date with the view, the map, and the tile images
+ *
+ * @param tilemap The tilemap to update the layer of
+ */
+static void pa_updateTileLayer(paTilemap_t* tilemap)
+{
+    int16_t tx = tilemap->mapOffsetX >> PA_TILE_SIZE_IN_POWERS_OF_2;
+    int16_t ty = tilemap->mapOffsetY >> PA_TILE_SIZE_IN_POWERS_OF_2;
+
+    if (tilemap->layerValid)
+    {
+        pa_scrollTileLayer(tilemap, tx, ty);
+    }
+
+    if (tilemap->layerValid)
+    {
+        // Tiles whose images were remapped, like animated blocks, are redrawn wherever they are
+        for (int32_t i = 0; i < PA_TILE_SET_SIZE; i++)
+        {
+            if (tilemap->layerTiles[i] != tilemap->wsgManager->tiles[i])
             {
-                pa_tileSpawnEntity(tilemap, tile - 128, x, y);
+                tilemap->layerTiles[i] = tilemap->wsgManager->tiles[i];
+                pa_invalidateTileLayerId(tilemap, i + 1);
             }
         }
     }
+    else
+    {
+        // Redraw everything
+        tilemap->layerTx = tx;
+        tilemap->layerTy = ty;
+        memcpy(tilemap->layerTiles, tilemap->wsgManager->tiles, sizeof(tilemap->layerTiles));
+        for (int32_t row = 0; row < PA_LAYER_HEIGHT_TILES; row++)
+        {
+            tilemap->layerDirty[row] = (1 << PA_LAYER_WIDTH_TILES) - 1;
+        }
+        tilemap->layerValid = true;
+    }
+
+    for (int32_t row = 0; row < PA_LAYER_HEIGHT_TILES; row++)
+    {
+        uint32_t dirty = tilemap->layerDirty[row];
+        while (dirty)
+        {
+            int32_t col = __builtin_ctz(dirty);
+            dirty &= dirty - 1;
+            pa_drawTileLayerCell(tilemap, col, row);
+        }
+        tilemap->layerDirty[row] = 0;
+    }
+}
 
-    tilemap->executeTileSpawnAll = 0;
+/**
+ * @brief Copy the visible window of the retained layer to the display
+ *
+ * @param tilemap The tilemap to copy the layer of
+ */
+static void pa_blitTileLayer(paTilemap_t* tilemap)
+{
+    // Each row is one or two copies, depending on if it wraps around the layer
+    int32_t lx       = pa_layerWrap(tilemap->mapOffsetX, PA_LAYER_WIDTH_PIXELS);
+    int32_t firstLen = MIN(TFT_WIDTH, PA_LAYER_WIDTH_PIXELS - lx);
+    int32_t ly       = pa_layerWrap(tilemap->mapOffsetY, PA_LAYER_HEIGHT_PIXELS);
+
+    paletteColor_t* pxDisp = getPxTftFramebuffer();
+    for (int32_t y = 0; y < TFT_HEIGHT; y++)
+    {
+        const paletteColor_t* pxRow = &tilemap->layer[ly * PA_LAYER_WIDTH_PIXELS];
+        memcpy(pxDisp, &pxRow[lx], firstLen);
+        if (firstLen < TFT_WIDTH)
+        {
+            memcpy(&pxDisp[firstLen], pxRow, TFT_WIDTH - firstLen);
+        }
+        pxDisp += TFT_WIDTH;
+
+        if (++ly == PA_LAYER_HEIGHT_PIXELS)
+        {
+            ly = 0;
+        }
+    }
 }
 
 void pa_scrollTileMap(paTilemap_t* tilemap, int16_t x, int16_t y)
@@ -135,6 +380,9 @@ bool pa_loadMapFromFile(paTilemap_t* tilemap, const char* name)
         return false;
     }
 
+    // Every tile changes
+    pa_invalidateTileLayer(tilemap);
+
     uint8_t width  = buf[0];
     uint8_t height = buf[1];
 
@@ -163,9 +411,9 @@ void pa_tileSpawnEntity(paTilemap_t* tilemap, uint8_t objectIndex, uint8_t tx, u
 
     if (entityCreated != NULL)
     {
-        entityCreated->homeTileX                  = tx;
-        entityCreated->homeTileY                  = ty;
-        tilemap->map[ty * tilemap->mapWidth + tx] = 0;
+        entityCreated->homeTileX = tx;
+        entityCreated->homeTileY = ty;
+        pa_setTile(tilemap, tx, ty, PA_TILE_EMPTY);
     }
 }
 
@@ -192,6 +440,13 @@ void pa_setTile(paTilemap_t* tilemap, uint8_t tx, uint8_t ty, uint8_t newTileId)
     }
 
     tilemap->map[ty * tilemap->mapWidth + tx] = newTileId;
+
+    // Redraw the tile in the retained layer, if it's in the layer's window
+    if (tx >= tilemap->layerTx && tx < tilemap->layerTx + PA_LAYER_WIDTH_TILES && ty >= tilemap->layerTy
+        && ty < tilemap->layerTy + PA_LAYER_HEIGHT_TILES)
+    {
+        tilemap->layerDirty[pa_layerWrap(ty, PA_LAYER_HEIGHT_TILES)] |= 1 << pa_layerWrap(tx, PA_LAYER_WIDTH_TILES);
+    }
 }
 
 bool pa_isSolid(uint8_t tileId)
@@ -218,6 +473,7 @@ void pa_unlockScrolling(paTilemap_t* tilemap)
 void pa_freeTilemap(paTilemap_t* tilemap)
 {
     heap_caps_free(tilemap->map);
+    heap_caps_free(tilemap->layer);
 }
 
 void pa_generateMaze(paTilemap_t* tilemap)
@@ -27,6 +27,13 @@
 
 #define PA_TILE_SET_SIZE 15
 
+// The retained tile layer holds exactly as many tiles as can be on screen at once. Tiles are stored at their map
+// coordinates modulo the layer size, so scrolling only redraws the rows and columns which come into view.
+#define PA_LAYER_WIDTH_TILES   PA_TILE_MAP_DISPLAY_WIDTH_TILES
+#define PA_LAYER_HEIGHT_TILES  PA_TILE_MAP_DISPLAY_HEIGHT_TILES
+#define PA_LAYER_WIDTH_PIXELS  (PA_LAYER_WIDTH_TILES * PA_TILE_SIZE)
+#define PA_LAYER_HEIGHT_PIXELS (PA_LAYER_HEIGHT_TILES * PA_TILE_SIZE)
+
 //==============================================================================
 // Structs
 //==============================================================================
@@ -59,6 +66,14 @@ struct paTilemap_t
     bool executeTileSpawnAll;
 
     paEntityManager_t* entityManager;
+
+    // Retained render layer, redrawn only where tiles change or scroll into view
+    paletteColor_t* layer;
+    int16_t layerTx; // Tile coordinates of the top left of the window the layer holds
+    int16_t layerTy;
+    bool layerValid; // false to redraw the whole layer
+    uint32_t layerDirty[PA_LAYER_HEIGHT_TILES]; // For each row of the layer, one bit per column to redraw
+    wsg_t* layerTiles[PA_TILE_SET_SIZE];        // The tile images the layer was drawn with
 };
 
 //==============================================================================
@@ -66,6 +81,8 @@ struct paTilemap_t
 //==============================================================================
 void pa_initializeTileMap(paTilemap_t* tilemap, paWsgManager_t* wsgManager);
 void pa_drawTileMap(paTilemap_t* tilemap);
+void pa_spawnTileEntities(paTilemap_t* tilemap);
+void pa_invalidateTileLayer(paTilemap_t* tilemap);
 void pa_scrollTileMap(paTilemap_t* tilemap, int16_t x, int16_t y);
 void pa_drawTile(paTilemap_t* tilemap, uint8_t tileId, int16_t x, int16_t y);
 bool pa_loadMapFromFile(paTilemap_t* tilemap, const char* name);
@@ -156,6 +156,13 @@ static void sokoEnterMode(void)
 
     // load level solved state.
     sokoLoadLevelSolvedState(soko);
+
+    // Without memory for the solver, the game is played without hints
+    sokoSolverInit(&soko->solver);
+
+    // Without memory for the board layer, tiles are drawn directly to the display every frame
+    soko->boardLayer = heap_caps_malloc(TFT_WIDTH * TFT_HEIGHT * sizeof(paletteColor_t), MALLOC_CAP_SPIRAM);
+    sokoInvalidateBoardLayer(soko);
 }
 
 static void sokoExitMode(void)
@@ -199,6 +206,11 @@ static void sokoExitMode(void)
     freeWsg(&soko->eulerTheme.crateWSG);
     freeWsg(&soko->eulerTheme.crateOnGoalWSG);
     heap_caps_free(soko->levelBinaryData); // TODO is this the best place to free?
+    sokoSolverDeinit(&soko->solver);
+    if (soko->boardLayer)
+    {
+        heap_caps_free(soko->boardLayer);
+    }
     // Free everything else
     heap_caps_free(soko);
 }
@@ -319,6 +331,12 @@ static void sokoMainLoop(int64_t elapsedUs)
 
 static void sokoBackgroundDrawCallback(int16_t x, int16_t y, int16_t w, int16_t h, int16_t up, int16_t upNum)
 {
+    // During gameplay the board layer is copied over the whole display, so there's nothing to draw under it
+    if (SOKO_LEVELPLAY == soko->screen && sokoBoardLayerActive(soko))
+    {
+        return;
+    }
+
     // Use TURBO drawing mode to draw individual pixels fast
     SETUP_FOR_TURBO();
     uint16_t shiftReg = 0xACE1u;
@@ -6,6 +6,7 @@
 #include "swadge2024.h"
 #include "soko_input.h"
 #include "soko_consts.h"
+#include "soko_solver.h"
 
 extern swadgeMode_t sokoMode;
 
@@ -248,6 +249,16 @@ typedef struct soko_abs_s
     uint16_t camWidth;
     uint16_t camHeight;
 
+    // retained board layer. The background and tiles are kept between frames and only redrawn where they change.
+    paletteColor_t* boardLayer;              ///< The background and tiles, the size of the display, or NULL if none
+    bool boardValid;                         ///< false if the whole board layer must be redrawn
+    int16_t boardOx;                         ///< The x pixel offset of the level when the board layer was drawn
+    int16_t boardOy;                         ///< The y pixel offset of the level when the board layer was drawn
+    uint16_t boardScale;                     ///< The level scale when the board layer was drawn
+    sokoTheme_t* boardTheme;                 ///< The theme when the board layer was drawn
+    sokoBackground_t boardBackground;        ///< The background when the board layer was drawn
+    uint32_t boardDirty[SOKO_MAX_LEVELSIZE]; ///< Tiles to redraw, one bit per column for each row
+
     // game loop functions //Functions are moved into game struct so engine can support different game rules
     void (*gameLoopFunc)(soko_abs_t* self, int64_t elapsedUs);
     void (*sokoTryPlayerMovementFunc)(soko_abs_t* self);
@@ -268,6 +279,9 @@ typedef struct soko_abs_s
 
     int chosen_victory_message;
 
+    // Deadlock detection and hints
+    sokoSolver_t solver;
+
     // Help page
     uint32_t helpIdx;
     uint32_t arrowBlinkTimer;
@@ -1,3 +1,5 @@
+#include <string.h>
+
 #include "soko_game.h"
 #include "soko.h"
 #include "soko_gamerules.h"
@@ -25,6 +27,12 @@ uint64_t victoryDanceTimer;
 
 const char key_sk_overworldPos[] = "sk_ovwPos";
 
+static paletteColor_t sokoTileColor(soko_abs_t* self, sokoTile_t tile);
+static int32_t sokoFloorDiv(int32_t a, int32_t b);
+static void sokoDrawBoardTile(soko_abs_t* self, sokoLevel_t* level, int16_t ox, int16_t oy, int32_t x, int32_t y);
+static void sokoScrollBoardLayer(soko_abs_t* self, sokoLevel_t* level, int16_t ox, int16_t oy);
+static void sokoUpdateBoardLayer(soko_abs_t* self, sokoLevel_t* level, int16_t ox, int16_t oy);
+
 void sokoConfigGamemode(
     soko_abs_t* soko,
     soko_var_t variant) // This should be called when you reload a level to make sure game rules are correct
@@ -106,6 +114,12 @@ void sokoConfigGamemode(
 
     // pick a single random victory message. We can't pick during the loop or it will be random every frame.
     soko->chosen_victory_message = rand() % victorym_count;
+
+    // start looking for deadlocks and hints in the new level
+    sokoSolverLoadLevel(&soko->solver, soko);
+
+    // the tiles all changed, redraw the whole board
+    sokoInvalidateBoardLayer(soko);
 }
 
 void absSokoGameLoop(soko_abs_t* soko, int64_t elapsedUs)
@@ -129,8 +143,14 @@ void absSokoGameLoop(soko_abs_t* soko, int64_t elapsedUs)
             soko->state       = SKS_VICTORY;
             victoryDanceTimer = 0;
         }
+        else
+        {
+            // search a little more for deadlocks and hints
+            sokoSolverUpdate(soko, elapsedUs);
+        }
         // draw level
         soko->drawTilesFunc(soko, &soko->currentLevel);
+        sokoSolverDrawStatus(soko);
     }
     else if (soko->state == SKS_VICTORY)
     {
@@ -271,13 +291,13 @@ bool absSokoTryMoveEntityInDirection(soko_abs_t* self, sokoEntity_t* entity, int
             if (self->currentLevel.tiles[entity->x + dx][entity->y + dy] == SKT_FLOOR)
             {
                 sokoAddTileMoveToHistory(self, entity->x + dx, entity->y + dy, SKT_FLOOR);
-                self->currentLevel.tiles[entity->x + dx][entity->y + dy] = SKT_FLOOR_WALKED;
+                sokoSetTile(self, entity->x + dx, entity->y + dy, SKT_FLOOR_WALKED);
             }
 
             if (self->currentLevel.tiles[entity->x][entity->y] == SKT_FLOOR)
             {
                 sokoAddTileMoveToHistory(self, entity->x, entity->y, SKT_FLOOR);
-                self->currentLevel.tiles[entity->x][entity->y] = SKT_FLOOR_WALKED;
+                sokoSetTile(self, entity->x, entity->y, SKT_FLOOR_WALKED);
             }
         }
         // No wall in front of us and nothing to push, we can move.
@@ -292,6 +312,283 @@ bool absSokoTryMoveEntityInDirection(soko_abs_t* self, sokoEntity_t* entity, int
 
     return false;
 }
+
+/**
+ * @brief Set a tile of the current level and mark it to be redrawn in the board layer
+ *
+ * @param self The game state
+ * @param x The x coordinate of the tile, in tiles
+ * @param y The y coordinate of the tile, in tiles
+ * @param tile The new tile
+ */
+void sokoSetTile(soko_abs_t* self, int x, int y, sokoTile_t tile)
+{
+    self->currentLevel.tiles[x][y] = tile;
+    self->boardDirty[y] |= (1u << x);
+}
+
+/**
+ * @brief Redraw the whole board layer the next time the tiles are drawn, e.g. after a new level is loaded
+ *
+ * @param self The game state
+ */
+void sokoInvalidateBoardLayer(soko_abs_t* self)
+{
+    self->boardValid = false;
+}
+
+/**
+ * @brief Check if tiles are drawn from the board layer. If they are, the board layer covers the whole display during
+ * gameplay and nothing needs to be drawn under it.
+ *
+ * @param self The game state
+ * @return true if the board layer is used, false if tiles are drawn directly to the display
+ */
+bool sokoBoardLayerActive(soko_abs_t* self)
+{
+    // The forest background isn't tied to screen position, so it can't be drawn a tile at a time
+    return (NULL != self->boardLayer) && (SKBG_GRID == self->background || SKBG_BLACK == self->background);
+}
+
+/**
+ * @brief Get the color of a tile. Tiles with no color show the background.
+ *
+ * @param self The game state
+ * @param tile The tile
+ * @return The color of the tile, or cTransparent
+ */
+static paletteColor_t sokoTileColor(soko_abs_t* self, sokoTile_t tile)
+{
+    switch (tile)
+    {
+        case SKT_FLOOR:
+        case SKT_GOAL:
+        {
+            return self->currentTheme->floorColor;
+        }
+        case SKT_WALL:
+        {
+            return self->currentTheme->wallColor;
+        }
+        case SKT_FLOOR_WALKED:
+        {
+            return self->currentTheme->altFloorColor;
+        }
+        case SKT_PORTAL:
+        { // todo: draw completed or not completed.
+            return c441;
+        }
+        case SKT_EMPTY:
+        default:
+        {
+            return cTransparent;
+        }
+    }
+}
+
+/**
+ * @brief Divide, rounding towards negative infinity
+ *
+ * @param a The dividend
+ * @param b The divisor, which must be positive
+ * @return a / b, rounded down
+ */
+static int32_t sokoFloorDiv(int32_t a, int32_t b)
+{
+    return (a >= 0) ? (a / b) : -((b - 1 - a) / b);
+}
+
+/**
+ * @brief Draw one tile into the board layer, with the background under it. The tile may be outside the level, in
+ * which case only the background is drawn.
+ *
+ * @param self The game state
+ * @param level The level to draw
+ * @param ox The x pixel offset of the level
+ * @param oy The y pixel offset of the level
+ * @param x The x coordinate of the tile, in tiles
+ * @param y The y coordinate of the tile, in tiles
+ */
+static void sokoDrawBoardTile(soko_abs_t* self, sokoLevel_t* level, int16_t ox, int16_t oy, int32_t x, int32_t y)
+{
+    int32_t scale = level->levelScale;
+    int32_t xd    = ox + x * scale;
+    int32_t yd    = oy + y * scale;
+
+    // Only draw on the display
+    int32_t xMin = MAX(xd, 0);
+    int32_t xMax = MIN(xd + scale, TFT_WIDTH);
+    int32_t yMin = MAX(yd, 0);
+    int32_t yMax = MIN(yd + scale, TFT_HEIGHT);
+    if (xMin >= xMax || yMin >= yMax)
+    {
+        return;
+    }
+
+    sokoTile_t tile = SKT_EMPTY;
+    if (x >= 0 && y >= 0 && x < level->width && y < level->height)
+    {
+        tile = level->tiles[x][y];
+    }
+    paletteColor_t color = sokoTileColor(self, tile);
+
+    for (int32_t yp = yMin; yp < yMax; yp++)
+    {
+        paletteColor_t* px = &self->boardLayer[yp * TFT_WIDTH];
+        if (cTransparent != color)
+        {
+            memset(&px[xMin], color, xMax - xMin);
+        }
+        else if (SKBG_BLACK == self->background || 0 == yp % 20)
+        {
+            // Same as sokoBackgroundDrawCallback()
+            memset(&px[xMin], (SKBG_BLACK == self->background) ? c000 : c002, xMax - xMin);
+        }
+        else
+        {
+            for (int32_t xp = xMin; xp < xMax; xp++)
+            {
+                px[xp] = (0 == xp % 20) ? c002 : c001;
+            }
+        }
+    }
+
+    if (SKT_GOAL == tile)
+    {
+        // Draw the goal over the floor, skipping transparent pixels
+        const wsg_t* goal = &self->currentTheme->goalWSG;
+        for (int32_t yp = yMin; yp < MIN(yMax, yd + goal->h); yp++)
+        {
+            const paletteColor_t* src = &goal->px[(yp - yd) * goal->w];
+            paletteColor_t* px        = &self->boardLayer[yp * TFT_WIDTH];
+            for (int32_t xp = xMin; xp < MIN(xMax, xd + goal->w); xp++)
+            {
+                if (cTransparent != src[xp - xd])
+                {
+                    px[xp] = src[xp - xd];
+                }
+            }
+        }
+    }
+}
+
+/**
+ * @brief Move the board layer to a new level offset after the camera moved. The pixels which are still on screen are
+ * moved, and tiles which scrolled into view or show the background are redrawn, because the background doesn't move
+ * with the level.
+ *
+ * @param self The game state
+ * @param level The level to draw
+ * @param ox The new x pixel offset of the level
+ * @param oy The new y pixel offset of the level
+ */
+static void sokoScrollBoardLayer(soko_abs_t* self, sokoLevel_t* level, int16_t ox, int16_t oy)
+{
+    int32_t dx = ox - self->boardOx;
+    int32_t dy = oy - self->boardOy;
+    if (ABS(dx) >= TFT_WIDTH || ABS(dy) >= TFT_HEIGHT)
+    {
+        self->boardValid = false;
+        return;
+    }
+
+    // Move the rows in an order which doesn't overwrite rows before they're moved
+    int32_t rowLen = TFT_WIDTH - ABS(dx);
+    int32_t dstX   = MAX(dx, 0);
+    int32_t srcX   = MAX(-dx, 0);
+    for (int32_t i = 0; i < TFT_HEIGHT - ABS(dy); i++)
+    {
+        int32_t dstY = (dy > 0) ? (TFT_HEIGHT - 1 - i) : i;
+        memmove(&self->boardLayer[dstY * TFT_WIDTH + dstX], &self->boardLayer[(dstY - dy) * TFT_WIDTH + srcX],
+                rowLen);
+    }
+
+    int32_t scale = level->levelScale;
+    int32_t xMin  = sokoFloorDiv(-ox, scale);
+    int32_t xMax  = sokoFloorDiv(TFT_WIDTH - 1 - ox, scale);
+    int32_t yMin  = sokoFloorDiv(-oy, scale);
+    int32_t yMax  = sokoFloorDiv(TFT_HEIGHT - 1 - oy, scale);
+    for (int32_t y = yMin; y <= yMax; y++)
+    {
+        // The visible part of this row of tiles, and where it was before the camera moved
+        int32_t yd0 = MAX(oy + y * scale, 0) - dy;
+        int32_t yd1 = MIN(oy + y * scale + scale, TFT_HEIGHT) - dy;
+        for (int32_t x = xMin; x <= xMax; x++)
+        {
+            int32_t xd0 = MAX(ox + x * scale, 0) - dx;
+            int32_t xd1 = MIN(ox + x * scale + scale, TFT_WIDTH) - dx;
+
+            bool wasVisible = (xd0 >= 0 && xd1 <= TFT_WIDTH && yd0 >= 0 && yd1 <= TFT_HEIGHT);
+            bool inLevel    = (x >= 0 && y >= 0 && x < level->width && y < level->height);
+            if (!wasVisible || !inLevel || cTransparent == sokoTileColor(self, level->tiles[x][y]))
+            {
+                sokoDrawBoardTile(self, level, ox, oy, x, y);
+            }
+        }
+    }
+
+    self->boardOx = ox;
+    self->boardOy = oy;
+}
+
+/**
+ * @brief Bring the board layer up to date with the level, the camera, and the theme
+ *
+ * @param self The game state
+ * @param level The level to draw
+ * @param ox The x pixel offset of the level
+ * @param oy The y pixel offset of the level
+ */
+static void sokoUpdateBoardLayer(soko_abs_t* self, sokoLevel_t* level, int16_t ox, int16_t oy)
+{
+    if (self->boardScale != level->levelScale || self->boardTheme != self->currentTheme
+        || self->boardBackground != self->background)
+    {
+        self->boardValid = false;
+    }
+
+    if (self->boardValid && (self->boardOx != ox || self->boardOy != oy))
+    {
+        sokoScrollBoardLayer(self, level, ox, oy);
+    }
+
+    if (self->boardValid)
+    {
+        // Redraw tiles which changed
+        for (int32_t y = 0; y < level->height; y++)
+        {
+            while (self->boardDirty[y])
+            {
+                int32_t x = __builtin_ctz(self->boardDirty[y]);
+                self->boardDirty[y] &= ~(1u << x);
+                sokoDrawBoardTile(self, level, ox, oy, x, y);
+            }
+        }
+    }
+    else
+    {
+        // Redraw every tile on screen
+        int32_t scale = level->levelScale;
+        for (int32_t y = sokoFloorDiv(-oy, scale); y <= sokoFloorDiv(TFT_HEIGHT - 1 - oy, scale); y++)
+        {
+            for (int32_t x = sokoFloorDiv(-ox, scale); x <= sokoFloorDiv(TFT_WIDTH - 1 - ox, scale); x++)
+            {
+                sokoDrawBoardTile(self, level, ox, oy, x, y);
+            }
+        }
+
+        self->boardValid      = true;
+        self->boardOx         = ox;
+        self->boardOy         = oy;
+        self->boardScale      = level->levelScale;
+        self->boardTheme      = self->currentTheme;
+        self->boardBackground = self->background;
+    }
+
+    // Anything left over was already drawn
+    memset(self->boardDirty, 0, sizeof(self->boardDirty));
+}
+
 // draw the tiles (and entities, for now) of the level.
 void absSokoDrawTiles(soko_abs_t* self, sokoLevel_t* level)
 {
@@ -364,67 +661,32 @@ void absSokoDrawTiles(soko_abs_t* self, sokoLevel_t* level)
     }
 
     // Tile Drawing (bg layer)
-    for (size_t x = screenMinX; x < screenMaxX; x++)
+    if (sokoBoardLayerActive(self))
     {
-        for (size_t y = screenMinY; y < screenMaxY; y++)
+        // Only the tiles which changed or scrolled into view are drawn, then the whole layer is copied to the display
+        sokoUpdateBoardLayer(self, level, ox, oy);
+        memcpy(getPxTftFramebuffer(), self->boardLayer, TFT_WIDTH * TFT_HEIGHT * sizeof(paletteColor_t));
+    }
+    else
+    {
+        for (size_t x = screenMinX; x < screenMaxX; x++)
         {
-            paletteColor_t color = cTransparent;
-            switch (level->tiles[x][y])
+            for (size_t y = screenMinY; y < screenMaxY; y++)
             {
-                case SKT_FLOOR:
+                // Draw a square.
+                paletteColor_t color = sokoTileColor(self, level->tiles[x][y]);
+                if (color != cTransparent)
                 {
-                    color = self->currentTheme->floorColor;
-                    break;
+                    int32_t xd = ox + x * scale;
+                    int32_t yd = oy + y * scale;
+                    fillDisplayArea(xd, yd, xd + scale, yd + scale, color);
                 }
-                case SKT_WALL:
-                {
-                    color = self->currentTheme->wallColor;
-                    break;
-                }
-                case SKT_GOAL:
-                {
-                    color = self->currentTheme->floorColor;
-                    break;
-                }
-                case SKT_FLOOR_WALKED:
-                {
-                    color = self->currentTheme->altFloorColor;
-                    break;
-                }
-                case SKT_EMPTY:
-                {
-                    color = cTransparent;
-                    break;
-                }
-                case SKT_PORTAL:
-                { // todo: draw completed or not completed.
-                    color = c441;
-                    // color = self->currentTheme->floorColor;
-                    break;
-                }
-                default:
+
+                if (level->tiles[x][y] == SKT_GOAL)
                 {
-                    break;
+                    drawWsgSimple(&self->currentTheme->goalWSG, ox + x * scale, oy + y * scale);
                 }
             }
-
-            // Draw a square.
-            // none of this matters it's all getting replaced with drawwsg later.
-            if (color != cTransparent)
-            {
-                int32_t xd = ox + x * scale;
-                int32_t yd = oy + y * scale;
-                fillDisplayArea(xd, yd, xd + scale, yd + scale, color);
-            }
-
-            if (level->tiles[x][y] == SKT_GOAL)
-            {
-                drawWsgSimple(&self->currentTheme->goalWSG, ox + x * scale, oy + y * scale);
-            }
-
-            // DEBUG_DRAW_COUNT++;
-            //  draw outline around the square.
-            //  drawRect(ox+x*s,oy+y*s,ox+x*s+s,oy+y*s+s,color);
         }
     }
 
@@ -642,12 +904,12 @@ void eulerSokoTryPlayerMovement(soko_abs_t* self)
         if (self->currentLevel.tiles[x][y] == SKT_FLOOR)
         {
             sokoAddTileMoveToHistory(self, x, y, SKT_FLOOR);
-            self->currentLevel.tiles[x][y] = SKT_FLOOR_WALKED;
+            sokoSetTile(self, x, y, SKT_FLOOR_WALKED);
         }
         if (self->currentLevel.tiles[self->soko_player->x][self->soko_player->y] == SKT_FLOOR)
         {
             sokoAddTileMoveToHistory(self, self->soko_player->x, self->soko_player->y, SKT_FLOOR);
-            self->currentLevel.tiles[self->soko_player->x][self->soko_player->y] = SKT_FLOOR_WALKED;
+            sokoSetTile(self, self->soko_player->x, self->soko_player->y, SKT_FLOOR_WALKED);
         }
 
         // Try Sticky Blocks
@@ -24,6 +24,11 @@ bool absSokoAllCratesOnGoal(soko_abs_t* self);
 sokoTile_t absSokoGetTile(soko_abs_t* self, int x, int y);
 bool allCratesOnGoal(void);
 
+// board layer
+void sokoSetTile(soko_abs_t* self, int x, int y, sokoTile_t tile);
+void sokoInvalidateBoardLayer(soko_abs_t* self);
+bool sokoBoardLayerActive(soko_abs_t* self);
+
 // euler
 void eulerSokoTryPlayerMovement(soko_abs_t* self);
 bool eulerNoUnwalkedFloors(soko_abs_t* self);
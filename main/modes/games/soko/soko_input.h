@@ -1,3 +1,6 @@
+#ifndef SOKO_INPUT_H
+#define SOKO_INPUT_H
+
 #include "swadge2024.h"
 
 // there is a way to set clever ints here such that we can super quickly convert to dx and dy with bit ops. I'll think
@@ -38,3 +41,5 @@ typedef struct
 
 void sokoInitInput(sokoGameplayInput_t*);
 void sokoPreProcessInput(sokoGameplayInput_t*, int64_t);
+
+#endif // SOKO_INPUT_H
@@ -0,0 +1,798 @@
+#include <stdlib.h>
+#include <string.h>
+#include <inttypes.h>
+#include <esp_timer.h>
+#include "soko.h"
+#include "soko_gamerules.h"
+#include "soko_save.h"
+#include "soko_solver.h"
+
+#define SOKO_SOLVER_SEEN_SIZE       (1 << SOKO_SOLVER_SEEN_BITS)
+#define SOKO_SOLVER_SEEN_MAX        (SOKO_SOLVER_SEEN_SIZE * 3 / 4) // Stop adding states before probing gets slow
+#define SOKO_SOLVER_NODES_PER_CHECK 32                              // States searched between checks of the clock
+#define SOKO_SOLVER_VERIFY_US       10000000                        // Time to spend on each level when verifying
+#define SOKO_SOLVER_VERIFY_SLICE_US 100000
+#define SOKO_SOLVER_PIECE_PLAYER    0
+#define SOKO_SOLVER_PIECE_WALKED    1
+#define SOKO_SOLVER_PIECE_CRATE_0   2
+
+extern bool sokoEntityTileCollision[6][9];
+
+// Directions in the order they are searched
+static const int8_t dirDx[]              = {0, 0, 1, -1};
+static const int8_t dirDy[]              = {-1, 1, 0, 0};
+static const sokoDirection_t dirValues[] = {SKD_UP, SKD_DOWN, SKD_RIGHT, SKD_LEFT};
+static const char* const dirNames[]      = {"", "Up", "Down", "Right", "Left"};
+
+static uint64_t solverZobrist(uint16_t piece, uint16_t cell);
+static uint64_t solverKey(const sokoSolverState_t* st);
+static bool solverSeen(sokoSolver_t* solver, uint64_t key);
+static sokoTile_t solverTile(const sokoSolver_t* solver, const sokoSolverState_t* st, int x, int y);
+static int8_t solverCrateAt(const sokoSolver_t* solver, const sokoSolverState_t* st, uint16_t cell);
+static void solverPaint(const sokoSolver_t* solver, sokoSolverState_t* st, uint16_t cell);
+static bool solverTryMove(const sokoSolver_t* solver, sokoSolverState_t* st, int8_t crate, int dx, int dy,
+                          uint16_t push);
+static bool solverMovePlayer(const sokoSolver_t* solver, sokoSolverState_t* st, uint8_t dir);
+static bool solverIsSolved(const sokoSolver_t* solver, const sokoSolverState_t* st);
+static void solverFindDeadCells(sokoSolver_t* solver);
+static bool solverBlockedOnAxis(const sokoSolver_t* solver, const sokoSolverState_t* st, uint16_t cell, int dx,
+                                int dy, uint16_t* frozen);
+static bool solverCrateFrozen(const sokoSolver_t* solver, const sokoSolverState_t* st, int8_t crate, uint16_t* frozen);
+static uint16_t solverNextFillMark(sokoSolver_t* solver);
+static bool solverEulerDeadlocked(sokoSolver_t* solver, const sokoSolverState_t* st);
+static bool solverIsDeadlocked(sokoSolver_t* solver, const sokoSolverState_t* st);
+static void solverReadGame(const sokoSolver_t* solver, soko_abs_t* soko, sokoSolverState_t* st);
+static void solverBeginState(sokoSolver_t* solver, const sokoSolverState_t* root);
+
+/// @brief Allocate the search stack and the set of searched states
+/// @param solver The solver to initialize
+/// @return true if there was enough memory
+bool sokoSolverInit(sokoSolver_t* solver)
+{
+    memset(solver, 0, sizeof(sokoSolver_t));
+    solver->stack = heap_caps_calloc(SOKO_SOLVER_MAX_DEPTH, sizeof(sokoSolverFrame_t), MALLOC_CAP_SPIRAM);
+    solver->seen  = heap_caps_calloc(SOKO_SOLVER_SEEN_SIZE, sizeof(uint64_t), MALLOC_CAP_SPIRAM);
+    if (NULL == solver->stack || NULL == solver->seen)
+    {
+        sokoSolverDeinit(solver);
+        return false;
+    }
+    return true;
+}
+
+/// @brief Free the memory allocated by sokoSolverInit()
+/// @param solver The solver to deinitialize
+void sokoSolverDeinit(sokoSolver_t* solver)
+{
+    heap_caps_free(solver->stack);
+    heap_caps_free(solver->seen);
+    solver->stack  = NULL;
+    solver->seen   = NULL;
+    solver->loaded = false;
+}
+
+/// @brief Copy the parts of the current level which don't change as it's played. Call this when a level is loaded,
+/// after the game rules are configured.
+/// @param solver The solver to load the level into
+/// @param soko The game with the level
+void sokoSolverLoadLevel(sokoSolver_t* solver, soko_abs_t* soko)
+{
+    sokoLevel_t* level = &soko->currentLevel;
+
+    solver->result     = SKSOLVE_IDLE;
+    solver->stuck      = false;
+    solver->needsBegin = true;
+    solver->loaded     = false;
+    if (NULL == solver->stack || level->gameMode == SOKO_OVERWORLD || level->width > SOKO_MAX_LEVELSIZE
+        || level->height > SOKO_MAX_LEVELSIZE)
+    {
+        return;
+    }
+
+    solver->euler      = (level->gameMode == SOKO_EULER);
+    solver->width      = level->width;
+    solver->height     = level->height;
+    solver->maxPush    = soko->maxPush;
+    solver->floorCount = 0;
+    for (int y = 0; y < level->height; y++)
+    {
+        for (int x = 0; x < level->width; x++)
+        {
+            sokoTile_t tile = level->tiles[x][y];
+            if (tile == SKT_FLOOR_WALKED)
+            {
+                tile = SKT_FLOOR;
+            }
+            solver->tiles[x + y * solver->width] = tile;
+            if (tile == SKT_FLOOR)
+            {
+                solver->floorCount++;
+            }
+        }
+    }
+
+    solver->crateCount = 0;
+    solver->trails     = false;
+    for (uint8_t i = 0; i < level->entityCount; i++)
+    {
+        sokoEntity_t* entity = &level->entities[i];
+        if (entity->type == SKE_CRATE || entity->type == SKE_STICKY_CRATE || entity->type == SKE_STICKY_TRAIL_CRATE)
+        {
+            solver->crateEntities[solver->crateCount] = i;
+            solver->crateTypes[solver->crateCount]    = entity->type;
+            solver->crateTrails[solver->crateCount]   = solver->euler && entity->propFlag && entity->properties.trail;
+            solver->trails |= solver->crateTrails[solver->crateCount];
+            solver->crateCount++;
+        }
+    }
+
+    solverFindDeadCells(solver);
+    solver->loaded = true;
+}
+
+/// @brief Start searching from the current state of the game
+/// @param solver The solver, which has the game's level loaded
+/// @param soko The game to solve
+void sokoSolverBegin(sokoSolver_t* solver, soko_abs_t* soko)
+{
+    sokoSolverState_t root;
+    solverReadGame(solver, soko, &root);
+    solverBeginState(solver, &root);
+}
+
+/// @brief Search for a while
+/// @param solver The solver, which has begun
+/// @param sliceUs How long to search for, in microseconds
+/// @return The result of the search so far
+sokoSolveResult_t sokoSolverRun(sokoSolver_t* solver, int64_t sliceUs)
+{
+    if (solver->result != SKSOLVE_SEARCHING)
+    {
+        return solver->result;
+    }
+
+    int64_t start = esp_timer_get_time();
+    uint32_t iter = 0;
+    while (true)
+    {
+        if (0 == (++iter % SOKO_SOLVER_NODES_PER_CHECK) && esp_timer_get_time() - start >= sliceUs)
+        {
+            break;
+        }
+
+        sokoSolverFrame_t* frame = &solver->stack[solver->sp];
+        if (frame->nextDir >= ARRAY_SIZE(dirValues))
+        {
+            // Every move from here was searched, back up
+            solver->sp--;
+            if (solver->sp < 0)
+            {
+                solver->result = solver->truncated ? SKSOLVE_GAVE_UP : SKSOLVE_DEADLOCKED;
+                break;
+            }
+            continue;
+        }
+
+        uint8_t dir              = frame->nextDir++;
+        sokoSolverState_t* child = &solver->stack[solver->sp + 1].state;
+        *child                   = frame->state;
+        if (!solverMovePlayer(solver, child, dir))
+        {
+            continue;
+        }
+        solver->nodes++;
+
+        if (solverIsSolved(solver, child))
+        {
+            solver->solutionLength = solver->sp + 1;
+            solver->hint           = dirValues[solver->stack[0].nextDir - 1];
+            solver->result         = SKSOLVE_SOLVED;
+            break;
+        }
+
+        if (solverSeen(solver, solverKey(child)) || solverIsDeadlocked(solver, child))
+        {
+            continue;
+        }
+
+        if (solver->sp + 2 >= SOKO_SOLVER_MAX_DEPTH)
+        {
+            solver->truncated = true;
+            continue;
+        }
+
+        solver->sp++;
+        solver->stack[solver->sp].nextDir = 0;
+    }
+
+    solver->searchUs += esp_timer_get_time() - start;
+    if (solver->result == SKSOLVE_DEADLOCKED)
+    {
+        solver->stuck = true;
+    }
+    return solver->result;
+}
+
+/// @brief Follow the game, searching again whenever the level changes. Call once per frame during gameplay.
+/// @param soko The game
+/// @param elapsedUs The time since the last call
+void sokoSolverUpdate(soko_abs_t* soko, int64_t elapsedUs)
+{
+    sokoSolver_t* solver = &soko->solver;
+    if (!solver->loaded)
+    {
+        return;
+    }
+
+    sokoSolverState_t now;
+    solverReadGame(solver, soko, &now);
+    if (solver->needsBegin || solverKey(&now) != solver->rootKey)
+    {
+        solverBeginState(solver, &now);
+        solver->idleUs = 0;
+    }
+    else
+    {
+        solver->idleUs += elapsedUs;
+    }
+
+    sokoSolverRun(solver, SOKO_SOLVER_SLICE_US);
+}
+
+/// @brief Draw a warning when the level can't be solved anymore, or a hint once the player has been idle for a while
+/// @param soko The game
+void sokoSolverDrawStatus(soko_abs_t* soko)
+{
+    sokoSolver_t* solver = &soko->solver;
+    char str[32]         = {0};
+    if (!solver->loaded)
+    {
+        return;
+    }
+    else if (solver->stuck)
+    {
+        snprintf(str, sizeof(str) - 1, "Stuck! Press A to undo");
+    }
+    else if (solver->result == SKSOLVE_SOLVED && solver->hint != SKD_NONE && solver->idleUs >= SOKO_SOLVER_HINT_IDLE_US)
+    {
+        snprintf(str, sizeof(str) - 1, "Hint: %s", dirNames[solver->hint]);
+    }
+    else
+    {
+        return;
+    }
+
+    int16_t tWidth = textWidth(&soko->ibm, str);
+    drawText(&soko->ibm, c555, str, ((TFT_WIDTH - tWidth) / 2), TFT_HEIGHT - soko->ibm.height - 2);
+}
+
+/// @brief Solve every level in the level list and log the results. Meant to be run on a host, it may take a while.
+void sokoVerifyLevels(void)
+{
+    soko_abs_t* soko = heap_caps_calloc(1, sizeof(soko_abs_t), MALLOC_CAP_SPIRAM);
+    if (NULL == soko || !sokoSolverInit(&soko->solver))
+    {
+        ESP_LOGE(SOKO_TAG, "Not enough memory to verify levels");
+        heap_caps_free(soko);
+        return;
+    }
+
+    // Level names are the tokens with .bin in them, in order
+    soko->levelFileText = loadTxt("SK_LEVEL_LIST.txt", true);
+    int levelCount      = 0;
+    char* token         = strtok(soko->levelFileText, ":");
+    while (NULL != token && levelCount < SOKO_LEVEL_COUNT)
+    {
+        if (strstr(token, ".bin") && !strpbrk(token, "\n\t\r "))
+        {
+            soko->levelNames[levelCount++] = token;
+        }
+        token = strtok(NULL, ":");
+    }
+
+    int solved = 0;
+    int played = 0;
+    for (int lIdx = 0; lIdx < levelCount; lIdx++)
+    {
+        sokoLoadBinLevel(soko, lIdx);
+        soko->soko_player = &soko->currentLevel.entities[soko->currentLevel.playerIndex];
+        if (soko->currentLevel.gameMode == SOKO_OVERWORLD)
+        {
+            continue;
+        }
+        soko->maxPush = (soko->currentLevel.gameMode == SOKO_CLASSIC) ? 1 : 0;
+        played++;
+
+        sokoSolver_t* solver = &soko->solver;
+        sokoSolverLoadLevel(solver, soko);
+        sokoSolverBegin(solver, soko);
+        while (solver->result == SKSOLVE_SEARCHING && solver->searchUs < SOKO_SOLVER_VERIFY_US)
+        {
+            sokoSolverRun(solver, SOKO_SOLVER_VERIFY_SLICE_US);
+        }
+
+        switch (solver->result)
+        {
+            case SKSOLVE_SOLVED:
+            {
+                solved++;
+                ESP_LOGI(SOKO_TAG, "%s: solved in %" PRIu16 " moves, %" PRIu32 " states, %" PRId64 "ms",
+                         soko->levelNames[lIdx], solver->solutionLength, solver->nodes, solver->searchUs / 1000);
+                break;
+            }
+            case SKSOLVE_DEADLOCKED:
+            {
+                ESP_LOGI(SOKO_TAG, "%s: NO SOLUTION, %" PRIu32 " states, %" PRId64 "ms", soko->levelNames[lIdx],
+                         solver->nodes, solver->searchUs / 1000);
+                break;
+            }
+            case SKSOLVE_IDLE:
+            case SKSOLVE_SEARCHING:
+            case SKSOLVE_GAVE_UP:
+            default:
+            {
+                ESP_LOGI(SOKO_TAG, "%s: gave up, %" PRIu32 " states, %" PRId64 "ms", soko->levelNames[lIdx],
+                         solver->nodes, solver->searchUs / 1000);
+                break;
+            }
+        }
+    }
+    ESP_LOGI(SOKO_TAG, "Solved %d of %d levels", solved, played);
+
+    heap_caps_free(soko->levelBinaryData);
+    freeTxt(soko->levelFileText);
+    sokoSolverDeinit(&soko->solver);
+    heap_caps_free(soko);
+}
+
+// Hashing
+
+static uint64_t solverZobrist(uint16_t piece, uint16_t cell)
+{
+    // splitmix64, so the keys don't need a table
+    uint64_t z = (((uint64_t)piece << 16) | cell) + 0x9E3779B97F4A7C15ULL;
+    z          = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ULL;
+    z          = (z ^ (z >> 27)) * 0x94D049BB133111EBULL;
+    return z ^ (z >> 31);
+}
+
+static uint64_t solverKey(const sokoSolverState_t* st)
+{
+    uint64_t key = st->hash ^ solverZobrist(SOKO_SOLVER_PIECE_PLAYER, st->player);
+    // 0 marks an empty slot in the set
+    return key ? key : 1;
+}
+
+/// @return true if the state was already searched, otherwise remember it and return false
+static bool solverSeen(sokoSolver_t* solver, uint64_t key)
+{
+    uint32_t mask = SOKO_SOLVER_SEEN_SIZE - 1;
+    for (uint32_t idx = key & mask;; idx = (idx + 1) & mask)
+    {
+        if (solver->seen[idx] == key)
+        {
+            return true;
+        }
+        else if (solver->seen[idx] == 0)
+        {
+            // When the set is full the search goes on without it, it just repeats itself more
+            if (solver->seenCount < SOKO_SOLVER_SEEN_MAX)
+            {
+                solver->seen[idx] = key;
+                solver->seenCount++;
+            }
+            return false;
+        }
+    }
+}
+
+// Game rules, which mirror absSokoTryMoveEntityInDirection() and eulerSokoTryPlayerMovement()
+
+static sokoTile_t solverTile(const sokoSolver_t* solver, const sokoSolverState_t* st, int x, int y)
+{
+    if (x < 0 || x >= solver->width || y < 0 || y >= solver->height)
+    {
+        return SKT_WALL;
+    }
+    uint16_t cell   = x + y * solver->width;
+    sokoTile_t tile = solver->tiles[cell];
+    if (tile == SKT_FLOOR && (st->walked[cell / 32] & (1u << (cell % 32))))
+    {
+        return SKT_FLOOR_WALKED;
+    }
+    return tile;
+}
+
+static int8_t solverCrateAt(const sokoSolver_t* solver, const sokoSolverState_t* st, uint16_t cell)
+{
+    for (int8_t i = 0; i < solver->crateCount; i++)
+    {
+        if (st->crates[i] == cell)
+        {
+            return i;
+        }
+    }
+    return -1;
+}
+
+static void solverPaint(const sokoSolver_t* solver, sokoSolverState_t* st, uint16_t cell)
+{
+    if (solver->tiles[cell] == SKT_FLOOR && !(st->walked[cell / 32] & (1u << (cell % 32))))
+    {
+        st->walked[cell / 32] |= (1u << (cell % 32));
+        st->walkedCount++;
+        st->hash ^= solverZobrist(SOKO_SOLVER_PIECE_WALKED, cell);
+    }
+}
+
+/// @brief Move the player, or a crate, one cell, pushing any crates in the way
+/// @param crate The crate to move, or -1 for the player
+static bool solverTryMove(const sokoSolver_t* solver, sokoSolverState_t* st, int8_t crate, int dx, int dy,
+                          uint16_t push)
+{
+    if (solver->maxPush != 0 && push > solver->maxPush)
+    {
+        return false;
+    }
+
+    uint16_t* pos         = (crate < 0) ? &st->player : &st->crates[crate];
+    sokoEntityType_t type = (crate < 0) ? SKE_PLAYER : solver->crateTypes[crate];
+    int px                = (*pos % solver->width) + dx;
+    int py                = (*pos / solver->width) + dy;
+    if (sokoEntityTileCollision[type][solverTile(solver, st, px, py)])
+    {
+        return false;
+    }
+
+    uint16_t next = px + py * solver->width;
+    int8_t pushed = solverCrateAt(solver, st, next);
+    if (pushed >= 0)
+    {
+        // Pushing a crate doesn't leave a trail
+        if (!solverTryMove(solver, st, pushed, dx, dy, push + 1))
+        {
+            return false;
+        }
+    }
+    else if (crate >= 0 && solver->crateTrails[crate])
+    {
+        solverPaint(solver, st, next);
+        solverPaint(solver, st, *pos);
+    }
+
+    if (crate >= 0)
+    {
+        st->hash ^= solverZobrist(SOKO_SOLVER_PIECE_CRATE_0 + crate, *pos)
+                    ^ solverZobrist(SOKO_SOLVER_PIECE_CRATE_0 + crate, next);
+    }
+    *pos = next;
+    return true;
+}
+
+static bool solverMovePlayer(const sokoSolver_t* solver, sokoSolverState_t* st, uint8_t dir)
+{
+    int dx        = dirDx[dir];
+    int dy        = dirDy[dir];
+    uint16_t prev = st->player;
+    if (!solverTryMove(solver, st, -1, dx, dy, 0))
+    {
+        return false;
+    }
+
+    if (solver->euler)
+    {
+        solverPaint(solver, st, prev);
+        solverPaint(solver, st, st->player);
+
+        // Sticky crates next to where the player was follow along
+        int ox = prev % solver->width;
+        int oy = prev / solver->width;
+        for (int8_t i = 0; i < solver->crateCount; i++)
+        {
+            int cx = st->crates[i] % solver->width;
+            int cy = st->crates[i] / solver->width;
+            if (solver->crateTypes[i] == SKE_STICKY_CRATE && (abs(cx - ox) + abs(cy - oy)) == 1)
+            {
+                solverTryMove(solver, st, i, dx, dy, 0);
+            }
+        }
+    }
+    return true;
+}
+
+static bool solverIsSolved(const sokoSolver_t* solver, const sokoSolverState_t* st)
+{
+    if (solver->euler)
+    {
+        return st->walkedCount == solver->floorCount;
+    }
+
+    for (int8_t i = 0; i < solver->crateCount; i++)
+    {
+        if (solver->crateTypes[i] == SKE_CRATE && solver->tiles[st->crates[i]] != SKT_GOAL)
+        {
+            return false;
+        }
+    }
+    return true;
+}
+
+// Deadlocks
+
+/// @brief Find the cells a crate can't be pushed from onto any goal, by pulling crates backwards from every goal
+static void solverFindDeadCells(sokoSolver_t* solver)
+{
+    uint16_t cells = solver->width * solver->height;
+    memset(solver->deadCells, 0, sizeof(solver->deadCells));
+    if (solver->euler)
+    {
+        return;
+    }
+
+    uint16_t mark = solverNextFillMark(solver);
+    uint16_t head = 0;
+    uint16_t tail = 0;
+    for (uint16_t cell = 0; cell < cells; cell++)
+    {
+        if (solver->tiles[cell] == SKT_GOAL)
+        {
+            solver->fillMarks[cell]   = mark;
+            solver->fillQueue[tail++] = cell;
+        }
+    }
+
+    sokoSolverState_t empty = {0};
+    while (head < tail)
+    {
+        uint16_t cell = solver->fillQueue[head++];
+        int x         = cell % solver->width;
+        int y         = cell / solver->width;
+        for (uint8_t dir = 0; dir < ARRAY_SIZE(dirValues); dir++)
+        {
+            // The crate is pulled from cell to n, by a player who ends up at p
+            int nx = x + dirDx[dir];
+            int ny = y + dirDy[dir];
+            int px = nx + dirDx[dir];
+            int py = ny + dirDy[dir];
+            if (sokoEntityTileCollision[SKE_CRATE][solverTile(solver, &empty, nx, ny)]
+                || sokoEntityTileCollision[SKE_PLAYER][solverTile(solver, &empty, px, py)])
+            {
+                continue;
+            }
+            uint16_t next = nx + ny * solver->width;
+            if (solver->fillMarks[next] != mark)
+            {
+                solver->fillMarks[next]   = mark;
+                solver->fillQueue[tail++] = next;
+            }
+        }
+    }
+
+    for (uint16_t cell = 0; cell < cells; cell++)
+    {
+        solver->deadCells[cell]
+            = (solver->fillMarks[cell] != mark) && !sokoEntityTileCollision[SKE_CRATE][solver->tiles[cell]];
+    }
+}
+
+static bool solverBlockedOnAxis(const sokoSolver_t* solver, const sokoSolverState_t* st, uint16_t cell, int dx,
+                                int dy, uint16_t* frozen)
+{
+    int ax = (cell % solver->width) - dx;
+    int ay = (cell / solver->width) - dy;
+    int bx = (cell % solver->width) + dx;
+    int by = (cell / solver->width) + dy;
+
+    // A wall on either side
+    if (sokoEntityTileCollision[SKE_CRATE][solverTile(solver, st, ax, ay)]
+        || sokoEntityTileCollision[SKE_CRATE][solverTile(solver, st, bx, by)])
+    {
+        return true;
+    }
+
+    // Dead cells on both sides
+    uint16_t a = ax + ay * solver->width;
+    uint16_t b = bx + by * solver->width;
+    if (solver->deadCells[a] && solver->deadCells[b])
+    {
+        return true;
+    }
+
+    // A frozen crate on either side. Crates already being checked count as walls.
+    int8_t crateA = solverCrateAt(solver, st, a);
+    int8_t crateB = solverCrateAt(solver, st, b);
+    return (crateA >= 0 && ((*frozen & (1 << crateA)) || solverCrateFrozen(solver, st, crateA, frozen)))
+           || (crateB >= 0 && ((*frozen & (1 << crateB)) || solverCrateFrozen(solver, st, crateB, frozen)));
+}
+
+static bool solverCrateFrozen(const sokoSolver_t* solver, const sokoSolverState_t* st, int8_t crate, uint16_t* frozen)
+{
+    // Treat this crate as a wall while checking its neighbors. If it turns out not to be frozen, forget it and any
+    // crates which were only frozen because of it.
+    uint16_t checked = *frozen;
+    *frozen |= (1 << crate);
+    if (solverBlockedOnAxis(solver, st, st->crates[crate], 1, 0, frozen)
+        && solverBlockedOnAxis(solver, st, st->crates[crate], 0, 1, frozen))
+    {
+        return true;
+    }
+    *frozen = checked;
+    return false;
+}
+
+static uint16_t solverNextFillMark(sokoSolver_t* solver)
+{
+    if (0 == ++solver->fillMark)
+    {
+        memset(solver->fillMarks, 0, sizeof(solver->fillMarks));
+        solver->fillMark = 1;
+    }
+    return solver->fillMark;
+}
+
+/// @brief Check that the player can still walk on every floor. Only valid when no crate leaves a trail.
+static bool solverEulerDeadlocked(sokoSolver_t* solver, const sokoSolverState_t* st)
+{
+    // Flood fill from the player over cells they can still enter, ignoring crates since they may move
+    uint16_t mark                 = solverNextFillMark(solver);
+    uint16_t head                 = 0;
+    uint16_t tail                 = 0;
+    solver->fillMarks[st->player] = mark;
+    solver->fillQueue[tail++]     = st->player;
+    while (head < tail)
+    {
+        uint16_t cell = solver->fillQueue[head++];
+        int x         = cell % solver->width;
+        int y         = cell / solver->width;
+        for (uint8_t dir = 0; dir < ARRAY_SIZE(dirValues); dir++)
+        {
+            int nx = x + dirDx[dir];
+            int ny = y + dirDy[dir];
+            if (sokoEntityTileCollision[SKE_PLAYER][solverTile(solver, st, nx, ny)])
+            {
+                continue;
+            }
+            uint16_t next = nx + ny * solver->width;
+            if (solver->fillMarks[next] != mark)
+            {
+                solver->fillMarks[next]   = mark;
+                solver->fillQueue[tail++] = next;
+            }
+        }
+    }
+
+    // Every unwalked floor must be reachable, and since the player can't walk back over painted floors, at most one
+    // can be a dead end, where the path finishes
+    uint16_t deadEnds = 0;
+    uint16_t cells    = solver->width * solver->height;
+    for (uint16_t cell = 0; cell < cells; cell++)
+    {
+        if (solverTile(solver, st, cell % solver->width, cell / solver->width) != SKT_FLOOR)
+        {
+            continue;
+        }
+        if (solver->fillMarks[cell] != mark)
+        {
+            return true;
+        }
+
+        uint8_t exits  = 0;
+        bool revisited = false;
+        int x          = cell % solver->width;
+        int y          = cell / solver->width;
+        for (uint8_t dir = 0; dir < ARRAY_SIZE(dirValues); dir++)
+        {
+            int nx          = x + dirDx[dir];
+            int ny          = y + dirDy[dir];
+            sokoTile_t tile = solverTile(solver, st, nx, ny);
+            if (!sokoEntityTileCollision[SKE_PLAYER][tile] || (nx + ny * solver->width) == st->player)
+            {
+                exits++;
+                // Goals and portals never get painted, so the player can come back out through them
+                revisited |= (tile != SKT_FLOOR && tile != SKT_FLOOR_WALKED);
+            }
+        }
+        if (exits <= 1 && !revisited && ++deadEnds > 1)
+        {
+            return true;
+        }
+    }
+    return false;
+}
+
+static bool solverIsDeadlocked(sokoSolver_t* solver, const sokoSolverState_t* st)
+{
+    if (solver->euler)
+    {
+        // Crates which leave trails paint floors the player never reaches, so these checks don't hold for them
+        return !solver->trails && solverEulerDeadlocked(solver, st);
+    }
+
+    for (int8_t i = 0; i < solver->crateCount; i++)
+    {
+        if (solver->crateTypes[i] != SKE_CRATE || solver->tiles[st->crates[i]] == SKT_GOAL)
+        {
+            continue;
+        }
+
+        uint16_t frozen = 0;
+        if (solver->deadCells[st->crates[i]] || solverCrateFrozen(solver, st, i, &frozen))
+        {
+            return true;
+        }
+    }
+    return false;
+}
+
+// Search
+
+static void solverReadGame(const sokoSolver_t* solver, soko_abs_t* soko, sokoSolverState_t* st)
+{
+    sokoLevel_t* level = &soko->currentLevel;
+    memset(st, 0, sizeof(sokoSolverState_t));
+
+    st->player = soko->soko_player->x + soko->soko_player->y * solver->width;
+    for (int8_t i = 0; i < solver->crateCount; i++)
+    {
+        sokoEntity_t* crate = &level->entities[solver->crateEntities[i]];
+        st->crates[i]       = crate->x + crate->y * solver->width;
+        st->hash ^= solverZobrist(SOKO_SOLVER_PIECE_CRATE_0 + i, st->crates[i]);
+    }
+
+    for (int y = 0; y < solver->height; y++)
+    {
+        for (int x = 0; x < solver->width; x++)
+        {
+            if (level->tiles[x][y] == SKT_FLOOR_WALKED)
+            {
+                solverPaint(solver, st, x + y * solver->width);
+            }
+        }
+    }
+
+    if (solver->euler)
+    {
+        // sokoConfigGamemode() paints these when the level starts
+        solverPaint(solver, st, st->player);
+        for (int8_t i = 0; i < solver->crateCount; i++)
+        {
+            if (solver->crateTypes[i] == SKE_STICKY_TRAIL_CRATE)
+            {
+                solverPaint(solver, st, st->crates[i]);
+            }
+        }
+    }
+}
+
+static void solverBeginState(sokoSolver_t* solver, const sokoSolverState_t* root)
+{
+    memset(solver->seen, 0, SOKO_SOLVER_SEEN_SIZE * sizeof(uint64_t));
+    solver->seenCount        = 0;
+    solver->truncated        = false;
+    solver->nodes            = 0;
+    solver->searchUs         = 0;
+    solver->solutionLength   = 0;
+    solver->hint             = SKD_NONE;
+    solver->needsBegin       = false;
+    solver->rootKey          = solverKey(root);
+    solver->sp               = 0;
+    solver->stack[0].state   = *root;
+    solver->stack[0].nextDir = 0;
+    solverSeen(solver, solver->rootKey);
+
+    solver->stuck = false;
+    if (solverIsSolved(solver, root))
+    {
+        solver->result = SKSOLVE_SOLVED;
+    }
+    else if (solverIsDeadlocked(solver, root))
+    {
+        solver->result = SKSOLVE_DEADLOCKED;
+        solver->stuck  = true;
+    }
+    else
+    {
+        solver->result = SKSOLVE_SEARCHING;
+    }
+    ESP_LOGD(SOKO_TAG, "Solver begins, %s", solver->stuck ? "stuck" : "searching");
+}
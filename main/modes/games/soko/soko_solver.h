@@ -0,0 +1,96 @@
+#ifndef SOKO_SOLVER_H
+#define SOKO_SOLVER_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "soko_consts.h"
+#include "soko_input.h"
+
+#define SOKO_SOLVER_MAX_CELLS    (SOKO_MAX_LEVELSIZE * SOKO_MAX_LEVELSIZE)
+#define SOKO_SOLVER_WALK_WORDS   ((SOKO_SOLVER_MAX_CELLS + 31) / 32)
+#define SOKO_SOLVER_MAX_DEPTH    256      // Longest solution searched for, in moves
+#define SOKO_SOLVER_SEEN_BITS    13       // The set of searched states has 2^13 entries
+#define SOKO_SOLVER_SLICE_US     3000     // Time to search each frame
+#define SOKO_SOLVER_HINT_IDLE_US 10000000 // Show a hint once the player hasn't moved for this long
+
+typedef struct soko_abs_s soko_abs_t;
+
+typedef enum
+{
+    SKSOLVE_IDLE,       ///< No level to solve
+    SKSOLVE_SEARCHING,  ///< Still searching
+    SKSOLVE_SOLVED,     ///< Found a solution
+    SKSOLVE_DEADLOCKED, ///< There is no solution
+    SKSOLVE_GAVE_UP,    ///< Couldn't search everything because some solutions were too long
+} sokoSolveResult_t;
+
+typedef struct
+{
+    uint16_t player;                         ///< The cell the player is in
+    uint16_t crates[SOKO_MAX_ENTITY_COUNT];  ///< The cell each crate is in
+    uint32_t walked[SOKO_SOLVER_WALK_WORDS]; ///< One bit for each floor cell which has been walked on, for Euler
+    uint16_t walkedCount;                    ///< How many floor cells have been walked on
+    uint64_t hash;                           ///< Zobrist hash of the crates and walked cells
+} sokoSolverState_t;
+
+typedef struct
+{
+    sokoSolverState_t state;
+    uint8_t nextDir; ///< The next direction to try from this state, 0 to 4
+} sokoSolverFrame_t;
+
+typedef struct
+{
+    // The level, which doesn't change as it's played
+    bool loaded;                                  ///< true if there is a level to solve
+    bool euler;                                   ///< true for Euler rules, false for classic rules
+    uint8_t width;
+    uint8_t height;
+    uint16_t maxPush;                             ///< The most crates pushed at once, or 0 for no limit
+    uint8_t tiles[SOKO_SOLVER_MAX_CELLS];         ///< sokoTile_t of each cell, with walked floors as floors
+    bool deadCells[SOKO_SOLVER_MAX_CELLS];        ///< Cells a crate can never be pushed from onto a goal
+    uint8_t crateCount;
+    uint8_t crateEntities[SOKO_MAX_ENTITY_COUNT]; ///< The index of each crate in the level's entities
+    uint8_t crateTypes[SOKO_MAX_ENTITY_COUNT];    ///< sokoEntityType_t of each crate
+    bool crateTrails[SOKO_MAX_ENTITY_COUNT];      ///< true if the crate paints floors it moves over
+    bool trails;                                  ///< true if any crate paints floors
+    uint16_t floorCount;                          ///< How many floor cells must be walked on, for Euler
+
+    // The search
+    sokoSolverFrame_t* stack; ///< Each state from the starting state to the current one
+    int16_t sp;
+    uint64_t* seen;           ///< Open addressed set of keys of states already searched
+    uint32_t seenCount;
+    bool truncated;           ///< true if any state was skipped for being too deep
+    sokoSolveResult_t result;
+    uint16_t solutionLength;  ///< Moves in the solution, once solved
+    sokoDirection_t hint;     ///< The first move of the solution, once solved
+    uint32_t nodes;           ///< States visited
+    int64_t searchUs;         ///< Time spent searching
+
+    // Scratch space for flood fills
+    uint16_t fillQueue[SOKO_SOLVER_MAX_CELLS];
+    uint16_t fillMarks[SOKO_SOLVER_MAX_CELLS];
+    uint16_t fillMark;
+
+    // The game being solved
+    bool needsBegin;  ///< true to search again even if the level looks the same
+    uint64_t rootKey; ///< Key of the state the search started from
+    bool stuck;       ///< true if the game can't be solved from here
+    int64_t idleUs;   ///< Time since the player last changed the level
+} sokoSolver_t;
+
+bool sokoSolverInit(sokoSolver_t* solver);
+void sokoSolverDeinit(sokoSolver_t* solver);
+void sokoSolverLoadLevel(sokoSolver_t* solver, soko_abs_t* soko);
+void sokoSolverBegin(sokoSolver_t* solver, soko_abs_t* soko);
+sokoSolveResult_t sokoSolverRun(sokoSolver_t* solver, int64_t sliceUs);
+
+// in-game hints
+void sokoSolverUpdate(soko_abs_t* soko, int64_t elapsedUs);
+void sokoSolverDrawStatus(soko_abs_t* soko);
+
+// host-side check of every level
+void sokoVerifyLevels(void);
+
+#endif // SOKO_SOLVER_H
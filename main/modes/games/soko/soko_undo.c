@@ -1,4 +1,5 @@
 #include "soko_undo.h"
+#include "soko_gamerules.h"
 
 void sokoInitHistory(soko_abs_t* soko)
 {
@@ -108,7 +109,7 @@ void sokoUndo(soko_abs_t* soko)
         else
         {
             // undo the tile
-            soko->currentLevel.tiles[m->x][m->y] = m->tile;
+            sokoSetTile(soko, m->x, m->y, m->tile);
         }
         // ring buffer
         if (soko->historyCurrent > 0)
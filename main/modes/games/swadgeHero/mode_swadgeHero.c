@@ -41,6 +41,8 @@ swadgeMode_t swadgeHeroMode = {
     .fnEspNowRecvCb           = NULL,
     .fnEspNowSendCb           = NULL,
     .fnAdvancedUSB            = NULL,
+    .modeArenaSize            = SH_MODE_ARENA_SIZE,
+    .arenaCaps                = MALLOC_CAP_SPIRAM,
 };
 
 shVars_t* shv;
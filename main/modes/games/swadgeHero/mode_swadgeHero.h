@@ -152,8 +152,8 @@ typedef struct
     wsg_t star;
     list_t starList;
 
-    // High score display
-    list_t hsStrs;
+    // High score display, the strings are in the mode arena past this mark
+    uint32_t hsArenaMark;
 } shVars_t;
 
 //==============================================================================
@@ -6,12 +6,6 @@
 #include "swadgeHero_game.h"
 #include "mainMenu.h"
 
-//==============================================================================
-// Defines
-//==============================================================================
-
-#define HS_STR_LEN 32
-
 //==============================================================================
 // Function Declarations
 //==============================================================================
@@ -143,6 +137,9 @@ void shSetupMenu(shVars_t* sh)
                              shadowColors, ARRAY_SIZE(shadowColors), ledColor);
     setManiaLedsOn(sh->renderer, true);
 
+    // High score strings are allocated from the mode arena, and released back to here when the menu is torn down
+    sh->hsArenaMark = arenaMark(getModeArena());
+
     // Add songs to play
     sh->menu = startSubMenu(sh->menu, strSongSelect);
     for (int32_t sIdx = 0; sIdx < ARRAY_SIZE(shSongList); sIdx++)
@@ -181,12 +178,18 @@ void shSetupMenu(shVars_t* sh)
                 tmpScore &= 0x0FFFFFFF;
 
                 // Allocate and print high score strings
-                char* hsStr = heap_caps_calloc(1, sizeof(char) * HS_STR_LEN, MALLOC_CAP_SPIRAM);
-                snprintf(hsStr, HS_STR_LEN - 1, "%s %" PRId32 " %s", labels[i], tmpScore, getLetterGrade(gradeIdx));
-                addSingleItemToMenu(sh->menu, hsStr);
-
-                // Save them all to a linked list to free later
-                push(&sh->hsStrs, hsStr);
+                char* hsStr = modeCalloc(HS_STR_LEN, sizeof(char));
+                if (NULL != hsStr)
+                {
+                    snprintf(hsStr, HS_STR_LEN - 1, "%s %" PRId32 " %s", labels[i], tmpScore,
+                             getLetterGrade(gradeIdx));
+                    addSingleItemToMenu(sh->menu, hsStr);
+                }
+                else
+                {
+                    // Out of arena, show the difficulty without the score
+                    addSingleItemToMenu(sh->menu, labels[i]);
+                }
             }
             else
             {
@@ -233,11 +236,7 @@ void shSetupMenu(shVars_t* sh)
 void shTeardownMenu(shVars_t* sh)
 {
     // Free all high score strings
-    void* toFree;
-    while ((toFree = pop(&sh->hsStrs)))
-    {
-        heap_caps_free(toFree);
-    }
+    arenaRelease(getModeArena(), sh->hsArenaMark);
 
     // Turn LEDs off
     setManiaLedsOn(sh->renderer, false);
@@ -2,6 +2,11 @@
 
 #include "mode_swadgeHero.h"
 
+#define HS_STR_LEN 32
+
+/// Mode arena for the high score strings, HS_STR_LEN for each difficulty of each song, with room for more songs
+#define SH_MODE_ARENA_SIZE (20 * 3 * HS_STR_LEN)
+
 void shSetupMenu(shVars_t* sh);
 void shTeardownMenu(shVars_t* sh);
 void shMenuInput(shVars_t* sh, buttonEvt_t* btn);
@@ -2,6 +2,8 @@
 
 #include <swadge2024.h>
 
+#include "ultimateTTTsearch.h"
+
 //==============================================================================
 // Defines
 //==============================================================================
@@ -109,6 +111,10 @@ typedef struct
     vec_t destSubgame;
     vec_t destCell;
     int64_t delayTime;
+    tttSearch_t search;
+    bool searching;
+    bool havePlan;
+    uint8_t plannedMove;
 } tttCpuData_t;
 
 typedef struct
@@ -1,5 +1,7 @@
 #include "ultimateTTTcpuPlayer.h"
 
+#include <inttypes.h>
+#include <string.h>
 #include <esp_random.h>
 #include <esp_log.h>
 #include <esp_timer.h>
@@ -19,6 +21,13 @@
 // 500ms delay so it's easier to see what's going on
 #define DELAY_TIME 500000
 
+// The hard CPU searches for up to 4ms each frame, and up to 1s for each move
+#define SEARCH_SLICE_TIME  4000
+#define SEARCH_BUDGET_TIME 1000000
+
+// The benchmark runs on the host, which is much faster, so give each move less time there
+#define BENCH_BUDGET_TIME 50000
+
 typedef enum
 {
     PLAYER_0   = 0x0,
@@ -88,9 +97,16 @@ static bool selectCell_easy(ultimateTTT_t* ttt, int* x, int* y);
 static bool selectCell_medium(ultimateTTT_t* ttt, int* x, int* y);
 static bool selectCell_hard(ultimateTTT_t* ttt, int* x, int* y);
 
+static bool selectSubgame_search(ultimateTTT_t* ttt, int* x, int* y);
+static bool selectCell_search(ultimateTTT_t* ttt, int* x, int* y);
+
 static void tttCpuSelectSubgame(ultimateTTT_t* ttt);
 static void tttCpuSelectCell(ultimateTTT_t* ttt);
 
+static void tttCpuGetPosition(ultimateTTT_t* ttt, tttPlayer_t player, tttPosition_t* pos);
+static void tttCpuStartSearch(ultimateTTT_t* ttt);
+static uint8_t benchHeuristicMove(ultimateTTT_t* ttt, const tttPosition_t* pos, tttCpuDifficulty_t difficulty);
+
 static int hasDiagonal(int x, int y);
 static rowCount_t checkRow(const tttPlayer_t game[3][3], int y, tttPlayer_t player);
 static rowCount_t checkCol(const tttPlayer_t game[3][3], int x, tttPlayer_t player);
@@ -113,7 +129,21 @@ void tttCpuNextMove(ultimateTTT_t* ttt)
     }
 
     int64_t now = esp_timer_get_time();
-    if (now < ttt->game.cpu.delayTime)
+    if (ttt->game.cpu.searching)
+    {
+        // Search a little each frame, and pick the move as soon as the search is done
+        if (!tttSearchRun(&ttt->game.cpu.search, SEARCH_SLICE_TIME))
+        {
+            return;
+        }
+
+        TCPU_LOG("Searched %" PRIu32 " positions to depth %d in %" PRId64 "us", ttt->game.cpu.search.nodes,
+                 ttt->game.cpu.search.finishedDepth, ttt->game.cpu.search.thinkUs);
+        ttt->game.cpu.searching   = false;
+        ttt->game.cpu.havePlan    = true;
+        ttt->game.cpu.plannedMove = ttt->game.cpu.search.bestMove;
+    }
+    else if (now < ttt->game.cpu.delayTime)
     {
         return;
     }
@@ -438,7 +468,13 @@ static void tttCpuSelectSubgame(ultimateTTT_t* ttt)
             break;
 
         case TDIFF_HARD:
-            result = selectSubgame_hard(ttt, &x, &y);
+            if (!ttt->game.cpu.havePlan)
+            {
+                // Search for the whole move first, then pick the subgame and cell from it
+                tttCpuStartSearch(ttt);
+                return;
+            }
+            result = selectSubgame_search(ttt, &x, &y) || selectSubgame_hard(ttt, &x, &y);
             break;
     }
 
@@ -739,7 +775,13 @@ static void tttCpuSelectCell(ultimateTTT_t* ttt)
             break;
 
         case TDIFF_HARD:
-            result = selectCell_hard(ttt, &x, &y);
+            if (!ttt->game.cpu.havePlan)
+            {
+                tttCpuStartSearch(ttt);
+                return;
+            }
+            result                 = selectCell_search(ttt, &x, &y) || selectCell_hard(ttt, &x, &y);
+            ttt->game.cpu.havePlan = false;
             break;
     }
 
@@ -752,6 +794,121 @@ static void tttCpuSelectCell(ultimateTTT_t* ttt)
     }
 }
 
+/**
+ * @brief Pick the subgame of the move found by the search
+ *
+ * @param ttt The entire game state
+ * @param[out] x The X index of the subgame
+ * @param[out] y The Y index of the subgame
+ * @return true if the search found a move, false if it didn't
+ */
+static bool selectSubgame_search(ultimateTTT_t* ttt, int* x, int* y)
+{
+    if (TTT_NO_MOVE == ttt->game.cpu.plannedMove)
+    {
+        return false;
+    }
+
+    uint8_t sub = TTT_MOVE_SUBGAME(ttt->game.cpu.plannedMove);
+    *x          = sub % 3;
+    *y          = sub / 3;
+    return true;
+}
+
+/**
+ * @brief Pick the cell of the move found by the search
+ *
+ * @param ttt The entire game state
+ * @param[out] x The X index of the cell
+ * @param[out] y The Y index of the cell
+ * @return true if the search found a move in the selected subgame, false if it didn't
+ */
+static bool selectCell_search(ultimateTTT_t* ttt, int* x, int* y)
+{
+    uint8_t move = ttt->game.cpu.plannedMove;
+    if (TTT_NO_MOVE == move
+        || TTT_MOVE_SUBGAME(move) != ttt->game.selectedSubgame.x + 3 * ttt->game.selectedSubgame.y)
+    {
+        return false;
+    }
+
+    *x = TTT_MOVE_CELL(move) % 3;
+    *y = TTT_MOVE_CELL(move) / 3;
+    return true;
+}
+
+/**
+ * @brief Convert the game board to a search position
+ *
+ * @param ttt The entire game state
+ * @param player The player to move
+ * @param[out] pos The position to write
+ */
+static void tttCpuGetPosition(ultimateTTT_t* ttt, tttPlayer_t player, tttPosition_t* pos)
+{
+    memset(pos, 0, sizeof(tttPosition_t));
+    for (int sy = 0; sy < 3; sy++)
+    {
+        for (int sx = 0; sx < 3; sx++)
+        {
+            const tttSubgame_t* subgame = &ttt->game.subgames[sx][sy];
+            uint8_t sub                 = sx + 3 * sy;
+            for (int cy = 0; cy < 3; cy++)
+            {
+                for (int cx = 0; cx < 3; cx++)
+                {
+                    if (TTT_P1 == subgame->game[cx][cy])
+                    {
+                        pos->cells[0][sub] |= (1 << (cx + 3 * cy));
+                    }
+                    else if (TTT_P2 == subgame->game[cx][cy])
+                    {
+                        pos->cells[1][sub] |= (1 << (cx + 3 * cy));
+                    }
+                }
+            }
+
+            switch (subgame->winner)
+            {
+                case TTT_P1:
+                    pos->won[0] |= (1 << sub);
+                    break;
+
+                case TTT_P2:
+                    pos->won[1] |= (1 << sub);
+                    break;
+
+                case TTT_DRAW:
+                    pos->drawn |= (1 << sub);
+                    break;
+
+                case TTT_NONE:
+                default:
+                    break;
+            }
+        }
+    }
+
+    pos->forced = (SELECT_SUBGAME == ttt->game.cursorMode)
+                      ? -1
+                      : (int8_t)(ttt->game.selectedSubgame.x + 3 * ttt->game.selectedSubgame.y);
+    pos->toMove = (TTT_P1 == player) ? 0 : 1;
+}
+
+/**
+ * @brief Start searching for the CPU's next move. tttCpuNextMove() runs it a little each frame until it's done.
+ *
+ * @param ttt The entire game state
+ */
+static void tttCpuStartSearch(ultimateTTT_t* ttt)
+{
+    tttPlayer_t cpuPlayer = (ttt->game.singlePlayerPlayOrder == GOING_FIRST) ? TTT_P2 : TTT_P1;
+    tttPosition_t pos;
+    tttCpuGetPosition(ttt, cpuPlayer, &pos);
+    tttSearchBegin(&ttt->game.cpu.search, &pos, TTT_SEARCH_MAX_DEPTH, SEARCH_BUDGET_TIME);
+    ttt->game.cpu.searching = true;
+}
+
 /**
  * @brief Return whether or not a given cell is part of the diagonals, and which one it is
  *
@@ -1308,4 +1465,201 @@ void printGame(const tttPlayer_t subgame[3][3])
     }
     *out = '\0';
     TCPU_LOG("%s", buf);
-}
\ No newline at end of file
+}
+
+/**
+ * @brief Pick a move for a heuristic CPU player in a search position, for the benchmark
+ *
+ * @param ttt A game state to set up for the heuristic player
+ * @param pos The position
+ * @param difficulty The heuristic player to pick a move with
+ * @return The move, or a random move if the heuristic player didn't pick a legal one
+ */
+static uint8_t benchHeuristicMove(ultimateTTT_t* ttt, const tttPosition_t* pos, tttCpuDifficulty_t difficulty)
+{
+    // Set the board up to match the position
+    for (uint8_t sub = 0; sub < 9; sub++)
+    {
+        tttSubgame_t* subgame = &ttt->game.subgames[sub % 3][sub / 3];
+        for (uint8_t cell = 0; cell < 9; cell++)
+        {
+            tttPlayer_t* marker = &subgame->game[cell % 3][cell / 3];
+            if (pos->cells[0][sub] & (1 << cell))
+            {
+                *marker = TTT_P1;
+            }
+            else if (pos->cells[1][sub] & (1 << cell))
+            {
+                *marker = TTT_P2;
+            }
+            else
+            {
+                *marker = TTT_NONE;
+            }
+        }
+
+        if (pos->won[0] & (1 << sub))
+        {
+            subgame->winner = TTT_P1;
+        }
+        else if (pos->won[1] & (1 << sub))
+        {
+            subgame->winner = TTT_P2;
+        }
+        else if (pos->drawn & (1 << sub))
+        {
+            subgame->winner = TTT_DRAW;
+        }
+        else
+        {
+            subgame->winner = TTT_NONE;
+        }
+    }
+
+    // The heuristic players are the player who isn't the human
+    ttt->game.singlePlayerPlayOrder = (0 == pos->toMove) ? GOING_SECOND : GOING_FIRST;
+
+    int x = 0, y = 0;
+    bool picked = true;
+    if (pos->forced < 0)
+    {
+        switch (difficulty)
+        {
+            case TDIFF_EASY:
+                picked = selectSubgame_easy(ttt, &x, &y);
+                break;
+
+            case TDIFF_MEDIUM:
+                picked = selectSubgame_medium(ttt, &x, &y);
+                break;
+
+            case TDIFF_HARD:
+                picked = selectSubgame_hard(ttt, &x, &y);
+                break;
+        }
+    }
+    else
+    {
+        x = pos->forced % 3;
+        y = pos->forced / 3;
+    }
+
+    uint8_t move = TTT_NO_MOVE;
+    if (picked && 0 <= x && x < 3 && 0 <= y && y < 3)
+    {
+        ttt->game.selectedSubgame.x = x;
+        ttt->game.selectedSubgame.y = y;
+
+        int cx = 0, cy = 0;
+        switch (difficulty)
+        {
+            case TDIFF_EASY:
+                picked = selectCell_easy(ttt, &cx, &cy);
+                break;
+
+            case TDIFF_MEDIUM:
+                picked = selectCell_medium(ttt, &cx, &cy);
+                break;
+
+            case TDIFF_HARD:
+                picked = selectCell_hard(ttt, &cx, &cy);
+                break;
+        }
+
+        if (picked && 0 <= cx && cx < 3 && 0 <= cy && cy < 3)
+        {
+            move = TTT_MOVE(x + 3 * y, cx + 3 * cy);
+        }
+    }
+
+    // Make sure the move is legal
+    uint8_t moves[TTT_SEARCH_MAX_MOVES];
+    uint8_t numMoves = tttPositionGetMoves(pos, moves);
+    for (uint8_t m = 0; m < numMoves; m++)
+    {
+        if (moves[m] == move)
+        {
+            return move;
+        }
+    }
+    return moves[esp_random() % numMoves];
+}
+
+/**
+ * @brief Play the search against each heuristic CPU player and log the results and search speed
+ *
+ * The search side alternates between going first and second. Each search move gets ::BENCH_BUDGET_TIME.
+ *
+ * @param games The number of games to play against each heuristic player
+ */
+void tttCpuBenchmark(int32_t games)
+{
+    static const char* const difficultyNames[] = {"easy", "medium", "hard"};
+
+    ultimateTTT_t* ttt = heap_caps_calloc(1, sizeof(ultimateTTT_t), MALLOC_CAP_8BIT);
+    if (NULL == ttt)
+    {
+        return;
+    }
+    tttSearch_t* search = &ttt->game.cpu.search;
+
+    for (tttCpuDifficulty_t difficulty = TDIFF_EASY; difficulty <= TDIFF_HARD; difficulty++)
+    {
+        int32_t wins     = 0;
+        int32_t losses   = 0;
+        int32_t draws    = 0;
+        uint64_t nodes   = 0;
+        int64_t searchUs = 0;
+
+        for (int32_t game = 0; game < games; game++)
+        {
+            tttPosition_t pos;
+            memset(&pos, 0, sizeof(pos));
+            pos.forced = -1;
+
+            // Alternate who goes first
+            uint8_t searchSide = game % 2;
+            int8_t winner;
+            while (!tttPositionIsOver(&pos, &winner))
+            {
+                uint8_t move;
+                if (searchSide == pos.toMove)
+                {
+                    tttSearchBegin(search, &pos, TTT_SEARCH_MAX_DEPTH, BENCH_BUDGET_TIME);
+                    while (!tttSearchRun(search, SEARCH_SLICE_TIME))
+                    {
+                        // Keep searching
+                    }
+                    nodes += search->nodes;
+                    searchUs += search->thinkUs;
+                    move = search->bestMove;
+                }
+                else
+                {
+                    move = benchHeuristicMove(ttt, &pos, difficulty);
+                }
+                tttPositionMakeMove(&pos, move);
+            }
+
+            if (winner < 0)
+            {
+                draws++;
+            }
+            else if (winner == searchSide)
+            {
+                wins++;
+            }
+            else
+            {
+                losses++;
+            }
+        }
+
+        ESP_LOGI("TTT", "Search vs %s: %" PRId32 " won, %" PRId32 " lost, %" PRId32 " drawn (%d%% won), %" PRIu64
+                        " positions/s",
+                 difficultyNames[difficulty], wins, losses, draws, games ? (int)(100 * wins / games) : 0,
+                 searchUs ? (uint64_t)(nodes * 1000000 / searchUs) : 0);
+    }
+
+    heap_caps_free(ttt);
+}
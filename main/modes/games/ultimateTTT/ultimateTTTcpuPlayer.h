@@ -11,3 +11,10 @@
  * @return int The index of the sub-game or square within a sub-game
  */
 void tttCpuNextMove(ultimateTTT_t* ttt);
+
+/**
+ * @brief Play the search used by the hard CPU against each heuristic CPU player and log the results and search speed
+ *
+ * @param games The number of games to play against each heuristic player
+ */
+void tttCpuBenchmark(int32_t games);
@@ -0,0 +1,507 @@
+//==============================================================================
+// Includes
+//==============================================================================
+
+#include <string.h>
+#include <esp_timer.h>
+
+#include "macros.h"
+
+#include "ultimateTTTsearch.h"
+
+//==============================================================================
+// Defines
+//==============================================================================
+
+/// The score of a won game, less the number of plies it takes so quicker wins are preferred
+#define TTT_SCORE_WIN 10000
+/// A score beyond any real score
+#define TTT_SCORE_INF 32000
+
+/// All nine cells of a board
+#define TTT_FULL_BOARD 0x1FF
+
+/// How many positions to visit between checks of the clock
+#define TTT_NODES_PER_CLOCK_CHECK 64
+
+/// The score for each subgame won
+#define TTT_SUBGAME_WON 25
+/// The score for being able to pick any open subgame
+#define TTT_FREE_CHOICE 15
+
+//==============================================================================
+// Function Declarations
+//==============================================================================
+
+static void initTables(void);
+static int16_t evaluate(const tttPosition_t* pos);
+static uint8_t orderMoves(const tttPosition_t* pos, uint8_t* moves);
+static bool expandNode(tttSearch_t* search, int8_t ply, int16_t* score);
+static void startIteration(tttSearch_t* search);
+static void backUp(tttSearchFrame_t* frame, uint8_t move, int16_t score);
+
+//==============================================================================
+// Const Variables
+//==============================================================================
+
+/// The eight lines of three, as masks of cells indexed x + 3 * y
+static const uint16_t winLines[] = {
+    0x007, 0x038, 0x1C0, // Rows
+    0x049, 0x092, 0x124, // Columns
+    0x111, 0x054,        // Diagonals
+};
+
+/// The score of a line of subgames which is still open, by the number of subgames won in it
+static const int16_t macroLineScores[] = {0, 10, 60, 0};
+/// The score of a line of cells in an open subgame which is still open, by the number of cells marked in it
+static const int16_t localLineScores[] = {0, 1, 5, 0};
+
+//==============================================================================
+// Variables
+//==============================================================================
+
+/// For each 9 bit board, true if it has a line of three
+static bool lineWins[1 << 9];
+/// For each 9 bit board, the cells which would complete a line of three
+static uint16_t lineThreats[1 << 9];
+/// true once the tables are filled in
+static bool tablesReady = false;
+
+//==============================================================================
+// Functions
+//==============================================================================
+
+/**
+ * @brief Fill in the tables of which boards have lines, and which cells would complete a line
+ */
+static void initTables(void)
+{
+    for (uint16_t board = 0; board <= TTT_FULL_BOARD; board++)
+    {
+        lineWins[board]    = false;
+        lineThreats[board] = 0;
+        for (uint8_t l = 0; l < ARRAY_SIZE(winLines); l++)
+        {
+            uint16_t marked = board & winLines[l];
+            if (marked == winLines[l])
+            {
+                lineWins[board] = true;
+            }
+            else if (2 == __builtin_popcount(marked))
+            {
+                lineThreats[board] |= winLines[l] & ~marked;
+            }
+        }
+    }
+    tablesReady = true;
+}
+
+/**
+ * @brief Mark a cell for the player to move, then pass the turn
+ *
+ * @param pos The position to change
+ * @param move The move to make, which must be one returned by tttPositionGetMoves()
+ */
+void tttPositionMakeMove(tttPosition_t* pos, uint8_t move)
+{
+    uint8_t sub  = TTT_MOVE_SUBGAME(move);
+    uint8_t cell = TTT_MOVE_CELL(move);
+    uint8_t p    = pos->toMove;
+
+    if (!tablesReady)
+    {
+        initTables();
+    }
+
+    pos->cells[p][sub] |= (1 << cell);
+    if (lineWins[pos->cells[p][sub]])
+    {
+        pos->won[p] |= (1 << sub);
+    }
+    else if (TTT_FULL_BOARD == (pos->cells[0][sub] | pos->cells[1][sub]))
+    {
+        pos->drawn |= (1 << sub);
+    }
+
+    // The next move is in the subgame matching this cell, unless that subgame is closed
+    uint16_t closed = pos->won[0] | pos->won[1] | pos->drawn;
+    pos->forced     = (closed & (1 << cell)) ? -1 : (int8_t)cell;
+    pos->toMove     = 1 - p;
+}
+
+/**
+ * @brief Get all the legal moves from a position
+ *
+ * @param pos The position
+ * @param moves An array of at least ::TTT_SEARCH_MAX_MOVES to write moves to
+ * @return The number of moves
+ */
+uint8_t tttPositionGetMoves(const tttPosition_t* pos, uint8_t* moves)
+{
+    uint16_t closed  = pos->won[0] | pos->won[1] | pos->drawn;
+    uint8_t numMoves = 0;
+    uint8_t firstSub = (pos->forced < 0) ? 0 : pos->forced;
+    uint8_t lastSub  = (pos->forced < 0) ? 8 : pos->forced;
+    for (uint8_t sub = firstSub; sub <= lastSub; sub++)
+    {
+        if (closed & (1 << sub))
+        {
+            continue;
+        }
+
+        uint16_t empty = ~(pos->cells[0][sub] | pos->cells[1][sub]) & TTT_FULL_BOARD;
+        while (empty)
+        {
+            uint8_t cell = __builtin_ctz(empty);
+            empty &= empty - 1;
+            moves[numMoves++] = TTT_MOVE(sub, cell);
+        }
+    }
+    return numMoves;
+}
+
+/**
+ * @brief Check if a game is over, the same way the game board does
+ *
+ * A line of three drawn subgames, or every subgame being closed, is a draw
+ *
+ * @param pos The position
+ * @param[out] winner The winner, 0 or 1, or -1 for a draw. Only written if the game is over
+ * @return true if the game is over, false if it isn't
+ */
+bool tttPositionIsOver(const tttPosition_t* pos, int8_t* winner)
+{
+    if (!tablesReady)
+    {
+        initTables();
+    }
+
+    if (lineWins[pos->won[0]])
+    {
+        *winner = 0;
+        return true;
+    }
+    else if (lineWins[pos->won[1]])
+    {
+        *winner = 1;
+        return true;
+    }
+    else if (lineWins[pos->drawn] || TTT_FULL_BOARD == (pos->won[0] | pos->won[1] | pos->drawn))
+    {
+        *winner = -1;
+        return true;
+    }
+    return false;
+}
+
+/**
+ * @brief Score a position which isn't over from the point of view of the player to move
+ *
+ * Lines of subgames which either player could still win score by how many subgames are won in them. Lines of cells
+ * in open subgames score the same way, but much less.
+ *
+ * @param pos The position
+ * @return The score, positive when the player to move is ahead
+ */
+static int16_t evaluate(const tttPosition_t* pos)
+{
+    uint8_t me      = pos->toMove;
+    uint8_t them    = 1 - me;
+    uint16_t closed = pos->won[0] | pos->won[1] | pos->drawn;
+    int32_t score   = 0;
+
+    for (uint8_t l = 0; l < ARRAY_SIZE(winLines); l++)
+    {
+        uint16_t line = winLines[l];
+        if (!(line & (pos->won[them] | pos->drawn)))
+        {
+            score += macroLineScores[__builtin_popcount(line & pos->won[me])];
+        }
+        if (!(line & (pos->won[me] | pos->drawn)))
+        {
+            score -= macroLineScores[__builtin_popcount(line & pos->won[them])];
+        }
+    }
+    score += TTT_SUBGAME_WON * (__builtin_popcount(pos->won[me]) - __builtin_popcount(pos->won[them]));
+
+    for (uint8_t sub = 0; sub < 9; sub++)
+    {
+        if (closed & (1 << sub))
+        {
+            continue;
+        }
+
+        uint16_t mine   = pos->cells[me][sub];
+        uint16_t theirs = pos->cells[them][sub];
+        for (uint8_t l = 0; l < ARRAY_SIZE(winLines); l++)
+        {
+            uint16_t line = winLines[l];
+            if (!(line & theirs))
+            {
+                score += localLineScores[__builtin_popcount(line & mine)];
+            }
+            if (!(line & mine))
+            {
+                score -= localLineScores[__builtin_popcount(line & theirs)];
+            }
+        }
+    }
+
+    if (pos->forced < 0)
+    {
+        score += TTT_FREE_CHOICE;
+    }
+    return score;
+}
+
+/**
+ * @brief Get the legal moves from a position, with the ones most likely to be good first
+ *
+ * Moves which win a subgame come first, then moves which block one, then the rest. Moves which let the opponent pick
+ * any subgame come last.
+ *
+ * @param pos The position
+ * @param moves An array of at least ::TTT_SEARCH_MAX_MOVES to write moves to
+ * @return The number of moves
+ */
+static uint8_t orderMoves(const tttPosition_t* pos, uint8_t* moves)
+{
+    uint8_t all[TTT_SEARCH_MAX_MOVES];
+    uint8_t numMoves = tttPositionGetMoves(pos, all);
+    uint16_t closed  = pos->won[0] | pos->won[1] | pos->drawn;
+    uint8_t me       = pos->toMove;
+
+    // Bucket the moves by priority, keeping their order within each bucket
+    uint8_t priorities[TTT_SEARCH_MAX_MOVES];
+    uint8_t counts[4] = {0};
+    for (uint8_t m = 0; m < numMoves; m++)
+    {
+        uint8_t sub  = TTT_MOVE_SUBGAME(all[m]);
+        uint16_t bit = 1 << TTT_MOVE_CELL(all[m]);
+        uint8_t prio;
+        if (lineThreats[pos->cells[me][sub]] & bit)
+        {
+            prio = 0;
+        }
+        else if (lineThreats[pos->cells[1 - me][sub]] & bit)
+        {
+            prio = 1;
+        }
+        else if (closed & bit)
+        {
+            prio = 3;
+        }
+        else
+        {
+            prio = 2;
+        }
+        priorities[m] = prio;
+        counts[prio]++;
+    }
+
+    uint8_t starts[4] = {0, counts[0], counts[0] + counts[1], counts[0] + counts[1] + counts[2]};
+    for (uint8_t m = 0; m < numMoves; m++)
+    {
+        moves[starts[priorities[m]]++] = all[m];
+    }
+    return numMoves;
+}
+
+/**
+ * @brief Score a position if it is a leaf, or list its moves if it isn't
+ *
+ * @param search The search
+ * @param ply The ply of the position in the search stack
+ * @param[out] score The score of the position from the point of view of the player to move, if it is a leaf
+ * @return true if the position is a leaf and was scored, false if its moves were listed
+ */
+static bool expandNode(tttSearch_t* search, int8_t ply, int16_t* score)
+{
+    tttSearchFrame_t* frame = &search->stack[ply];
+    search->nodes++;
+
+    int8_t winner;
+    if (tttPositionIsOver(&frame->pos, &winner))
+    {
+        // Only the player who just moved can have won
+        *score = (winner < 0) ? 0 : -(TTT_SCORE_WIN - ply);
+        return true;
+    }
+    else if (ply >= search->depth)
+    {
+        *score = evaluate(&frame->pos);
+        return true;
+    }
+
+    frame->numMoves = orderMoves(&frame->pos, frame->moves);
+    frame->moveIdx  = 0;
+    frame->best     = -TTT_SCORE_INF;
+    frame->bestMove = TTT_NO_MOVE;
+    return false;
+}
+
+/**
+ * @brief Start searching the root position to the current depth, trying the best move so far first
+ *
+ * @param search The search
+ */
+static void startIteration(tttSearch_t* search)
+{
+    tttSearchFrame_t* root = &search->stack[0];
+    root->alpha            = -TTT_SCORE_INF;
+    root->beta             = TTT_SCORE_INF;
+    search->sp             = 0;
+
+    int16_t score;
+    if (expandNode(search, 0, &score))
+    {
+        // The game is already over
+        search->done = true;
+        return;
+    }
+
+    for (uint8_t m = 1; m < root->numMoves; m++)
+    {
+        if (root->moves[m] == search->bestMove)
+        {
+            memmove(&root->moves[1], &root->moves[0], m);
+            root->moves[0] = search->bestMove;
+            break;
+        }
+    }
+}
+
+/**
+ * @brief Record the score of a searched move
+ *
+ * @param frame The frame the move was made from
+ * @param move The move
+ * @param score The score of the move from the point of view of the player who made it
+ */
+static void backUp(tttSearchFrame_t* frame, uint8_t move, int16_t score)
+{
+    if (score > frame->best)
+    {
+        frame->best     = score;
+        frame->bestMove = move;
+    }
+    if (score > frame->alpha)
+    {
+        frame->alpha = score;
+    }
+}
+
+/**
+ * @brief Start an iterative deepening search from a position. Call tttSearchRun() until it returns true to get a move
+ *
+ * @param search The search to start
+ * @param root The position to search from
+ * @param maxDepth The deepest iteration to search, at most ::TTT_SEARCH_MAX_DEPTH
+ * @param thinkBudgetUs The total time to spend searching. The search stops early with the best move from the last
+ * finished iteration when this runs out
+ */
+void tttSearchBegin(tttSearch_t* search, const tttPosition_t* root, uint8_t maxDepth, int64_t thinkBudgetUs)
+{
+    if (!tablesReady)
+    {
+        initTables();
+    }
+
+    search->stack[0].pos  = *root;
+    search->depth         = 1;
+    search->maxDepth      = (maxDepth > TTT_SEARCH_MAX_DEPTH) ? TTT_SEARCH_MAX_DEPTH : maxDepth;
+    search->bestMove      = TTT_NO_MOVE;
+    search->bestScore     = 0;
+    search->finishedDepth = 0;
+    search->done          = false;
+    search->nodes         = 0;
+    search->thinkUs       = 0;
+    search->thinkBudgetUs = thinkBudgetUs;
+    startIteration(search);
+}
+
+/**
+ * @brief Run a search for up to a slice of time. This picks up wherever the last call stopped.
+ *
+ * @param search The search to run
+ * @param sliceUs The time to search for before returning, in microseconds
+ * @return true if the search is finished and search->bestMove is set, false if it needs more time
+ */
+bool tttSearchRun(tttSearch_t* search, int64_t sliceUs)
+{
+    int64_t start   = esp_timer_get_time();
+    uint32_t checks = 0;
+
+    while (!search->done)
+    {
+        // Check the clock every so often
+        if (++checks >= TTT_NODES_PER_CLOCK_CHECK)
+        {
+            checks          = 0;
+            int64_t elapsed = esp_timer_get_time() - start;
+            if (search->finishedDepth && search->thinkUs + elapsed >= search->thinkBudgetUs)
+            {
+                // Out of time, abandon this iteration
+                search->done = true;
+                break;
+            }
+            else if (elapsed >= sliceUs)
+            {
+                search->thinkUs += elapsed;
+                return false;
+            }
+        }
+
+        tttSearchFrame_t* frame = &search->stack[search->sp];
+        if (frame->moveIdx < frame->numMoves && frame->alpha < frame->beta)
+        {
+            // Search the next move
+            uint8_t move            = frame->moves[frame->moveIdx++];
+            tttSearchFrame_t* child = &search->stack[search->sp + 1];
+            child->pos              = frame->pos;
+            tttPositionMakeMove(&child->pos, move);
+            child->alpha = -frame->beta;
+            child->beta  = -frame->alpha;
+
+            int16_t score;
+            if (expandNode(search, search->sp + 1, &score))
+            {
+                backUp(frame, move, -score);
+            }
+            else
+            {
+                search->sp++;
+            }
+        }
+        else if (search->sp > 0)
+        {
+            // All moves searched, or one was good enough to stop, so pass the score up
+            int16_t score = frame->best;
+            search->sp--;
+            tttSearchFrame_t* parent = &search->stack[search->sp];
+            backUp(parent, parent->moves[parent->moveIdx - 1], -score);
+        }
+        else
+        {
+            // Finished an iteration
+            search->bestMove      = frame->bestMove;
+            search->bestScore     = frame->best;
+            search->finishedDepth = search->depth;
+
+            // Stop at the deepest iteration, or once the result of the game is known
+            if (search->depth >= search->maxDepth || frame->best >= TTT_SCORE_WIN - TTT_SEARCH_MAX_DEPTH
+                || frame->best <= -(TTT_SCORE_WIN - TTT_SEARCH_MAX_DEPTH))
+            {
+                search->done = true;
+            }
+            else
+            {
+                search->depth++;
+                startIteration(search);
+            }
+        }
+    }
+
+    search->thinkUs += esp_timer_get_time() - start;
+    return true;
+}
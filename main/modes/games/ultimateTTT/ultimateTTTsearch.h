@@ -0,0 +1,88 @@
+#pragma once
+
+//==============================================================================
+// Includes
+//==============================================================================
+
+#include <stdint.h>
+#include <stdbool.h>
+
+//==============================================================================
+// Defines
+//==============================================================================
+
+/// The deepest the search goes, in plies
+#define TTT_SEARCH_MAX_DEPTH 12
+
+/// The most moves in any position
+#define TTT_SEARCH_MAX_MOVES 81
+
+/// A move which isn't a move
+#define TTT_NO_MOVE 0xFF
+
+/// Get the subgame index, 0 to 8, of a move
+#define TTT_MOVE_SUBGAME(m) ((m) / 9)
+/// Get the cell index, 0 to 8, of a move
+#define TTT_MOVE_CELL(m) ((m) % 9)
+/// Make a move from a subgame index and a cell index
+#define TTT_MOVE(sub, cell) ((sub) * 9 + (cell))
+
+//==============================================================================
+// Structs
+//==============================================================================
+
+/**
+ * @brief A compact position. Subgames and cells are indexed x + 3 * y, and each board is a 9 bit mask in that order.
+ */
+typedef struct
+{
+    uint16_t cells[2][9]; ///< The cells each player has marked in each subgame
+    uint16_t won[2];      ///< The subgames each player has won
+    uint16_t drawn;       ///< The subgames which are full without a winner
+    int8_t forced;        ///< The subgame the next move must be in, or -1 for any open subgame
+    uint8_t toMove;       ///< The player to move, 0 for P1 or 1 for P2
+} tttPosition_t;
+
+/**
+ * @brief One ply of the search stack
+ */
+typedef struct
+{
+    tttPosition_t pos;                   ///< The position at this ply
+    uint8_t moves[TTT_SEARCH_MAX_MOVES]; ///< The moves from this position, in the order they are searched
+    uint8_t numMoves;                    ///< The number of moves
+    uint8_t moveIdx;                     ///< The next move to search
+    uint8_t bestMove;                    ///< The best move found so far
+    int16_t alpha;                       ///< The lower bound, from the point of view of the player to move
+    int16_t beta;                        ///< The upper bound, from the point of view of the player to move
+    int16_t best;                        ///< The best score found so far
+} tttSearchFrame_t;
+
+/**
+ * @brief An iterative deepening alpha-beta search which can be paused and resumed between frames
+ */
+typedef struct
+{
+    tttSearchFrame_t stack[TTT_SEARCH_MAX_DEPTH + 1]; ///< The search stack, the root is at 0
+    int8_t sp;                                        ///< The current ply in the stack
+    uint8_t depth;                                    ///< The depth of the current iteration
+    uint8_t maxDepth;                                 ///< The deepest iteration to search
+    uint8_t bestMove;                                 ///< The best move from the last finished iteration
+    int16_t bestScore;                                ///< The score of bestMove
+    uint8_t finishedDepth;                            ///< The depth of the last finished iteration
+    bool done;                                        ///< true when the search is finished
+    uint32_t nodes;                                   ///< The number of positions visited
+    int64_t thinkUs;                                  ///< The time spent searching, in microseconds
+    int64_t thinkBudgetUs;                            ///< The time the search may spend in total, in microseconds
+} tttSearch_t;
+
+//==============================================================================
+// Function Declarations
+//==============================================================================
+
+void tttPositionMakeMove(tttPosition_t* pos, uint8_t move);
+uint8_t tttPositionGetMoves(const tttPosition_t* pos, uint8_t* moves);
+bool tttPositionIsOver(const tttPosition_t* pos, int8_t* winner);
+
+void tttSearchBegin(tttSearch_t* search, const tttPosition_t* root, uint8_t maxDepth, int64_t thinkBudgetUs);
+bool tttSearchRun(tttSearch_t* search, int64_t sliceUs);
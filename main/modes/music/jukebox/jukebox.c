@@ -1224,8 +1224,9 @@ void jukeboxLoadCategories(const jukeboxCategory_t* categoryArray, uint8_t numCa
     {
         for (int songIdx = 0; songIdx < categoryArray[categoryIdx].numSongs; songIdx++)
         {
-            loadMidiFile(categoryArray[categoryIdx].songs[songIdx].filename,
-                         &categoryArray[categoryIdx].songs[songIdx].song, true);
+            // Every song is loaded up front, so stream them rather than holding them all decompressed
+            loadMidiFileStreamed(categoryArray[categoryIdx].songs[songIdx].filename,
+                                 &categoryArray[categoryIdx].songs[songIdx].song, true);
             categoryArray[categoryIdx].songs[songIdx].shouldLoop = shouldLoop;
         }
     }
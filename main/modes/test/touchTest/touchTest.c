@@ -147,17 +147,22 @@ static void touchTestMainLoop(int64_t elapsedUs)
  */
 static void touchTestHandleInput(void)
 {
-    // Just call all the options for getting touchpad readings for demonstration purposes
-    touchTest->touch = getTouchJoystick(&touchTest->angle, &touchTest->radius, &touchTest->intensity);
-
-    if (touchTest->touch)
+    // Count spins from every queued sample, so a fast spin between frames isn't missed
+    touchEvt_t evt;
+    while (checkTouchQueue(&evt))
     {
-        getTouchSpins(&touchTest->spin, touchTest->angle, touchTest->radius);
-    }
-    else
-    {
-        touchTest->spin.startSet = false;
+        if (evt.touched)
+        {
+            getTouchSpins(&touchTest->spin, evt.phi, evt.r);
+        }
+        else
+        {
+            touchTest->spin.startSet = false;
+        }
     }
+
+    // Show the latest sample
+    touchTest->touch = getTouchJoystick(&touchTest->angle, &touchTest->radius, &touchTest->intensity);
 }
 
 /**
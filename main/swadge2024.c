@@ -179,6 +179,8 @@
 #include "advanced_usb_control.h"
 #include "shapes.h"
 #include "swadge2024.h"
+#include "trace.h"
+#include "frameProfiler.h"
 
 #include "factoryTest.h"
 #include "mainMenu.h"
@@ -257,8 +259,13 @@ static void swadgeModeEspNowRecvCb(const esp_now_recv_info_t* esp_now_info, cons
                                    int8_t rssi);
 static void swadgeModeEspNowSendCb(const uint8_t* mac_addr, esp_now_send_status_t status);
 static void setSwadgeMode(void* swadgeMode);
+static void enterSwadgeMode(void);
+static void exitSwadgeMode(void);
 static void initOptionalPeripherals(void);
 static void dacCallback(uint8_t* samples, int16_t len);
+#if defined(CONFIG_INPUT_LATENCY_STATS)
+static void logInputLatency(void);
+#endif
 
 //==============================================================================
 // Functions
@@ -336,6 +343,9 @@ void app_main(void)
     // Init timers
     esp_timer_init();
 
+    // Init latency tracing first, so everything after can be traced
+    initTrace();
+
     // Init file system
     initCnfs();
 
@@ -395,10 +405,7 @@ void app_main(void)
     tLastLoopUs                = esp_timer_get_time();
 
     // Initialize the swadge mode
-    if (NULL != cSwadgeMode->fnEnterMode)
-    {
-        cSwadgeMode->fnEnterMode();
-    }
+    enterSwadgeMode();
 
     // Run the main loop, forever
     while (true)
@@ -411,6 +418,8 @@ void app_main(void)
         // Process ADC samples
         if (NULL != cSwadgeMode->fnAudioCallback)
         {
+            profilerPhaseStart(PROF_MIC);
+
             // This must have the same number of elements as the bounds in mic_param
             const uint16_t micGains[] = {
                 32, 45, 64, 90, 128, 181, 256, 362,
@@ -435,8 +444,11 @@ void app_main(void)
                 }
                 cSwadgeMode->fnAudioCallback(adcSamples, sampleCnt);
             }
+
+            profilerPhaseEnd(PROF_MIC);
         }
 
+        profilerPhaseStart(PROF_AUDIO_OUT);
 #if defined(CONFIG_SOUND_OUTPUT_SPEAKER)
         // Check if a DAC buffer needs to be filled
         dacPoll();
@@ -444,10 +456,13 @@ void app_main(void)
         // Check for buzzer callback flags from the ISR
         bzrCheckSongDone();
 #endif
+        profilerPhaseEnd(PROF_AUDIO_OUT);
 
         if (NO_WIFI != cSwadgeMode->wifiMode)
         {
+            profilerPhaseStart(PROF_ESP_NOW);
             checkEspNowRxQueue();
+            profilerPhaseEnd(PROF_ESP_NOW);
         }
 
         // Only draw to the TFT every frameRateUs
@@ -457,6 +472,7 @@ void app_main(void)
         {
             // Decrement the accumulation
             tAccumDraw -= frameRateUs;
+            profilerStartFrame();
 
             // Call the mode's main loop
             if (NULL != cSwadgeMode->fnMainLoop)
@@ -468,7 +484,14 @@ void app_main(void)
                     tLastMainLoopCall = tNowUs;
                 }
 
+                // Free the last frame's scratch allocations
+                modeArenasNewFrame();
+
+                TRACE_BEGIN(TRACE_MAIN_LOOP);
+                profilerPhaseStart(PROF_MAIN_LOOP);
                 cSwadgeMode->fnMainLoop(tNowUs - tLastMainLoopCall);
+                profilerPhaseEnd(PROF_MAIN_LOOP);
+                TRACE_END(TRACE_MAIN_LOOP);
                 tLastMainLoopCall = tNowUs;
             }
 
@@ -515,8 +538,17 @@ void app_main(void)
                 cSwadgeMode = modeBehindQuickSettings;
             }
 
-            // Draw to the TFT
+            // Draw the frame profiler's overlay, if it's enabled, then draw to the TFT
+            drawProfilerOverlay();
+            TRACE_BEGIN(TRACE_TFT_FRAME);
+            profilerPhaseStart(PROF_TFT);
             drawDisplayTft(cSwadgeMode->fnBackgroundDrawCallback);
+            profilerPhaseEnd(PROF_TFT);
+            TRACE_END(TRACE_TFT_FRAME);
+            profilerEndFrame(frameRateUs);
+#if defined(CONFIG_INPUT_LATENCY_STATS)
+            logInputLatency();
+#endif
         }
 
         // If the mode should be switched, do it now
@@ -538,18 +570,50 @@ void app_main(void)
             esp_deep_sleep_start();
         }
 
+        // Write out trace events, if enough have been buffered
+        traceFlush();
+
         // Yield to let the rest of the RTOS run
         taskYIELD();
     }
 
     // Deinitialize the swadge mode
-    if (NULL != cSwadgeMode->fnExitMode)
+    exitSwadgeMode();
+
+    deinitSystem();
+}
+
+#if defined(CONFIG_INPUT_LATENCY_STATS)
+/**
+ * @brief Measure the time from the earliest input event the mode consumed this frame to the display being drawn, and
+ * periodically log the statistics
+ */
+static void logInputLatency(void)
+{
+    static uint32_t count = 0;
+    static uint64_t total = 0;
+    static uint32_t worst = 0;
+
+    uint32_t inputTime = takeInputConsumedTime();
+    if (0 == inputTime)
     {
-        cSwadgeMode->fnExitMode();
+        // No input this frame
+        return;
     }
 
-    deinitSystem();
+    // Event times are 32 bits, so this handles them wrapping around
+    uint32_t latency = (uint32_t)esp_timer_get_time() - inputTime;
+    total += latency;
+    worst = MAX(worst, latency);
+    if (++count == 64)
+    {
+        ESP_LOGI("LATENCY", "Input to display: avg %" PRIu32 "us, max %" PRIu32 "us", (uint32_t)(total / count), worst);
+        count = 0;
+        total = 0;
+        worst = 0;
+    }
 }
+#endif
 
 /**
  * @brief Initialize optional hardware peripherals for this Swadge mode
@@ -614,10 +678,7 @@ static void initOptionalPeripherals(void)
 void deinitSystem(void)
 {
     // Deinit the swadge mode
-    if (NULL != cSwadgeMode->fnExitMode)
-    {
-        cSwadgeMode->fnExitMode();
-    }
+    exitSwadgeMode();
 
     // Deinitialize everything
     deinitButtons();
@@ -628,6 +689,7 @@ void deinitSystem(void)
     deinitBuzzer();
 #endif
     deinitEspNow();
+    deInitAccelerometer();
     deinitLeds();
     deinitMic();
     deinitNvs();
@@ -636,6 +698,7 @@ void deinitSystem(void)
     deinitTFT();
     deinitUsb();
     deinitBattmon();
+    deinitTrace();
 }
 
 /**
@@ -652,7 +715,9 @@ static void swadgeModeEspNowRecvCb(const esp_now_recv_info_t* esp_now_info, cons
 {
     if (NULL != cSwadgeMode->fnEspNowRecvCb)
     {
+        TRACE_BEGIN(TRACE_ESP_NOW_RX);
         cSwadgeMode->fnEspNowRecvCb(esp_now_info, data, len, rssi);
+        TRACE_END(TRACE_ESP_NOW_RX);
     }
 }
 
@@ -685,19 +750,40 @@ static void setSwadgeMode(void* swadgeMode)
     }
 
     // Stop the prior mode
-    if (cSwadgeMode->fnExitMode)
-    {
-        cSwadgeMode->fnExitMode();
-    }
+    exitSwadgeMode();
 
     // Set and start the new mode
     cSwadgeMode = swadgeMode;
-    if (cSwadgeMode->fnEnterMode)
+    enterSwadgeMode();
+}
+
+/**
+ * @brief Flush queued touches and allocate the current Swadge mode's arenas, then enter it
+ */
+static void enterSwadgeMode(void)
+{
+    // Don't give the new mode touches from before it started
+    flushTouchQueue();
+
+    modeArenasStart(cSwadgeMode->frameArenaSize, cSwadgeMode->modeArenaSize, cSwadgeMode->arenaCaps);
+    if (NULL != cSwadgeMode->fnEnterMode)
     {
         cSwadgeMode->fnEnterMode();
     }
 }
 
+/**
+ * @brief Exit the current Swadge mode, then free its arenas so nothing allocated from them can outlive it
+ */
+static void exitSwadgeMode(void)
+{
+    if (NULL != cSwadgeMode->fnExitMode)
+    {
+        cSwadgeMode->fnExitMode();
+    }
+    modeArenasStop();
+}
+
 /**
  * Set up variables to synchronously switch the swadge mode in the main loop
  *
@@ -719,10 +805,7 @@ void softSwitchToPendingSwadge(void)
     if (pendingSwadgeMode)
     {
         // Exit the current mode
-        if (NULL != cSwadgeMode->fnExitMode)
-        {
-            cSwadgeMode->fnExitMode();
-        }
+        exitSwadgeMode();
 
         // Stop the music
         soundStop(true);
@@ -735,10 +818,7 @@ void softSwitchToPendingSwadge(void)
         initOptionalPeripherals();
 
         // Enter the next mode
-        if (NULL != cSwadgeMode->fnEnterMode)
-        {
-            cSwadgeMode->fnEnterMode();
-        }
+        enterSwadgeMode();
 
         // Reenable the TFT backlight
         enableTFTBacklight();
@@ -759,6 +839,10 @@ bool checkButtonQueueWrapper(buttonEvt_t* evt)
 {
     // Check the button queue
     bool retval = checkButtonQueue(evt);
+    if (retval)
+    {
+        TRACE_INSTANT(TRACE_BTN_DEQUEUE, evt->state);
+    }
 
     // Check for intercept
     if (retval &&                            // If there was a button press
@@ -830,6 +914,8 @@ uint32_t getFrameRateUs(void)
  */
 void dacCallback(uint8_t* samples, int16_t len)
 {
+    TRACE_BEGIN(TRACE_DAC_FILL);
+
     // If there is a DAC callback for the current mode
     if (cSwadgeMode->fnDacCb)
     {
@@ -841,6 +927,8 @@ void dacCallback(uint8_t* samples, int16_t len)
         // Otherwise use the song player
         globalMidiPlayerFillBuffer(samples, len);
     }
+
+    TRACE_END(TRACE_DAC_FILL);
 }
 
 /**
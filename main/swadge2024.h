@@ -79,6 +79,9 @@
  *     .fnEspNowSendCb           = demoEspNowSendCb,
  *     .fnAdvancedUSB            = demoAdvancedUSB,
  *     .fnDacCb                  = demoDacCb,
+ *     .frameArenaSize           = 0,
+ *     .modeArenaSize            = 0,
+ *     .arenaCaps                = 0,
  * };
  * \endcode
  *
@@ -195,6 +198,7 @@
 #include "wsg.h"
 #include "shapes.h"
 #include "fill.h"
+#include "mesh3d.h"
 #include "menu.h"
 #include "menuManiaRenderer.h"
 
@@ -210,6 +214,7 @@
 
 // General utilities
 #include "linked_list.h"
+#include "arena.h"
 #include "macros.h"
 #include "trigonometry.h"
 #include "vector2d.h"
@@ -347,6 +352,24 @@ typedef struct
      * globalMidiPlayerFillBuffer() will be used instead to fill sample buffers
      */
     fnDacCallback_t fnDacCb;
+
+    /**
+     * @brief This is a setting, not a function pointer. The size, in bytes, of the arena which frameAlloc() allocates
+     * from. It is reset before each call to fnMainLoop. If this is 0, the mode has no frame arena.
+     */
+    uint32_t frameArenaSize;
+
+    /**
+     * @brief This is a setting, not a function pointer. The size, in bytes, of the arena which modeAlloc() allocates
+     * from. It is freed after fnExitMode is called. If this is 0, the mode has no mode arena.
+     */
+    uint32_t modeArenaSize;
+
+    /**
+     * @brief This is a setting, not a function pointer. The heap capabilities to allocate both arenas with, e.g.
+     * MALLOC_CAP_8BIT for internal RAM or MALLOC_CAP_SPIRAM for SPIRAM. If this is 0, MALLOC_CAP_8BIT is used.
+     */
+    uint32_t arenaCaps;
 } swadgeMode_t;
 
 bool checkButtonQueueWrapper(buttonEvt_t* evt);
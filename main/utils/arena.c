@@ -0,0 +1,287 @@
+//==============================================================================
+// Includes
+//==============================================================================
+
+#include <string.h>
+#include <inttypes.h>
+
+#include <esp_log.h>
+#include <esp_heap_caps.h>
+
+#include "macros.h"
+#include "arena.h"
+
+//==============================================================================
+// Variables
+//==============================================================================
+
+/// The current mode's frame arena, reset before each main loop call
+static arena_t frameArena = {0};
+
+/// The current mode's arena, freed when the mode exits
+static arena_t modeArena = {0};
+
+//==============================================================================
+// Function Prototypes
+//==============================================================================
+
+static void arenaReportHighWater(arena_t* arena);
+
+//==============================================================================
+// Functions
+//==============================================================================
+
+/**
+ * @brief Allocate memory for an arena
+ *
+ * @param arena The arena to initialize
+ * @param size The number of bytes the arena can hold
+ * @param caps The heap capabilities to allocate the arena with, e.g. MALLOC_CAP_8BIT or MALLOC_CAP_SPIRAM
+ * @param name A name for the arena in logs, which must stay valid while the arena does
+ * @return true if the arena was allocated, false if it wasn't
+ */
+bool arenaInit(arena_t* arena, uint32_t size, uint32_t caps, const char* name)
+{
+    memset(arena, 0, sizeof(arena_t));
+    arena->name = name;
+    arena->base = heap_caps_malloc_tag(size, caps, name);
+    if (NULL == arena->base)
+    {
+        ESP_LOGE("ARENA", "Couldn't allocate %" PRIu32 " bytes for %s", size, name);
+        return false;
+    }
+    arena->size = size;
+    return true;
+}
+
+/**
+ * @brief Free an arena's memory and log how much of it was used
+ *
+ * @param arena The arena to free
+ */
+void arenaDeinit(arena_t* arena)
+{
+    if (NULL == arena->base)
+    {
+        return;
+    }
+
+    arenaReportHighWater(arena);
+    ESP_LOGI("ARENA", "%s: high-water %" PRIu32 " of %" PRIu32 " bytes, %" PRIu32 " failed allocations", arena->name,
+             arena->highWater, arena->size, arena->failures);
+
+    heap_caps_free(arena->base);
+    memset(arena, 0, sizeof(arena_t));
+}
+
+/**
+ * @brief Allocate memory from an arena. The memory is not initialized.
+ *
+ * @param arena The arena to allocate from
+ * @param size The number of bytes to allocate
+ * @return The memory, aligned to ::ARENA_ALIGN, or NULL if it doesn't fit in the arena
+ */
+void* arenaAlloc(arena_t* arena, uint32_t size)
+{
+    uint32_t start = (arena->used + (ARENA_ALIGN - 1)) & ~(uint32_t)(ARENA_ALIGN - 1);
+    if (NULL == arena->base || start > arena->size || size > arena->size - start)
+    {
+        arena->failures++;
+        return NULL;
+    }
+
+    arena->used = start + size;
+    if (arena->used > arena->highWater)
+    {
+        arena->highWater = arena->used;
+        arena->grew      = true;
+    }
+    return &arena->base[start];
+}
+
+/**
+ * @brief Allocate memory from an arena and set it to zero
+ *
+ * @param arena The arena to allocate from
+ * @param n The number of elements to allocate
+ * @param size The size of each element, in bytes
+ * @return The memory, aligned to ::ARENA_ALIGN, or NULL if it doesn't fit in the arena
+ */
+void* arenaCalloc(arena_t* arena, uint32_t n, uint32_t size)
+{
+    if (0 != size && n > UINT32_MAX / size)
+    {
+        arena->failures++;
+        return NULL;
+    }
+
+    void* mem = arenaAlloc(arena, n * size);
+    if (NULL != mem)
+    {
+        memset(mem, 0, n * size);
+    }
+    return mem;
+}
+
+/**
+ * @brief Free everything allocated from an arena
+ *
+ * @param arena The arena to reset
+ */
+void arenaReset(arena_t* arena)
+{
+    arenaReportHighWater(arena);
+    arena->used = 0;
+}
+
+/**
+ * @brief Get a mark which arenaRelease() can later free back to
+ *
+ * @param arena The arena to mark
+ * @return The mark
+ */
+uint32_t arenaMark(const arena_t* arena)
+{
+    return arena->used;
+}
+
+/**
+ * @brief Free everything allocated from an arena since arenaMark() returned the given mark
+ *
+ * @param arena The arena to release memory from
+ * @param mark A mark from arenaMark(), which must not be older than the arena's last reset
+ */
+void arenaRelease(arena_t* arena, uint32_t mark)
+{
+    if (mark < arena->used)
+    {
+        arena->used = mark;
+    }
+}
+
+/**
+ * @brief Tell the heap tracker an arena's high-water mark, if it rose since the last time
+ *
+ * @param arena The arena to report
+ */
+static void arenaReportHighWater(arena_t* arena)
+{
+    if (arena->grew)
+    {
+        arena->grew = false;
+        heap_caps_track_high_water(arena->base, arena->highWater);
+    }
+}
+
+/**
+ * @brief Allocate the arenas for a Swadge mode. This is called by the mode framework before the mode is entered.
+ *
+ * @param frameSize The size of the frame arena, or 0 for none
+ * @param modeSize The size of the mode arena, or 0 for none
+ * @param caps The heap capabilities to allocate both arenas with
+ */
+void modeArenasStart(uint32_t frameSize, uint32_t modeSize, uint32_t caps)
+{
+    modeArenasStop();
+
+    // If no capabilities are given, let the arenas go anywhere
+    if (0 == caps)
+    {
+        caps = MALLOC_CAP_8BIT;
+    }
+
+    if (frameSize)
+    {
+        arenaInit(&frameArena, frameSize, caps, "frameArena");
+    }
+    if (modeSize)
+    {
+        arenaInit(&modeArena, modeSize, caps, "modeArena");
+    }
+}
+
+/**
+ * @brief Free everything in the frame arena. This is called by the mode framework before each main loop call.
+ */
+void modeArenasNewFrame(void)
+{
+    if (NULL != frameArena.base)
+    {
+        arenaReset(&frameArena);
+    }
+}
+
+/**
+ * @brief Free the arenas for a Swadge mode. This is called by the mode framework after the mode is exited.
+ */
+void modeArenasStop(void)
+{
+    arenaDeinit(&frameArena);
+    arenaDeinit(&modeArena);
+}
+
+/**
+ * @brief Allocate memory which is freed before the next main loop call
+ *
+ * @param size The number of bytes to allocate
+ * @return The memory, or NULL if it doesn't fit in the frame arena
+ */
+void* frameAlloc(uint32_t size)
+{
+    return arenaAlloc(&frameArena, size);
+}
+
+/**
+ * @brief Allocate zeroed memory which is freed before the next main loop call
+ *
+ * @param n The number of elements to allocate
+ * @param size The size of each element, in bytes
+ * @return The memory, or NULL if it doesn't fit in the frame arena
+ */
+void* frameCalloc(uint32_t n, uint32_t size)
+{
+    return arenaCalloc(&frameArena, n, size);
+}
+
+/**
+ * @brief Allocate memory which is freed when the mode exits
+ *
+ * @param size The number of bytes to allocate
+ * @return The memory, or NULL if it doesn't fit in the mode arena
+ */
+void* modeAlloc(uint32_t size)
+{
+    return arenaAlloc(&modeArena, size);
+}
+
+/**
+ * @brief Allocate zeroed memory which is freed when the mode exits
+ *
+ * @param n The number of elements to allocate
+ * @param size The size of each element, in bytes
+ * @return The memory, or NULL if it doesn't fit in the mode arena
+ */
+void* modeCalloc(uint32_t n, uint32_t size)
+{
+    return arenaCalloc(&modeArena, n, size);
+}
+
+/**
+ * @brief Get the current mode's frame arena, e.g. to mark and release it
+ *
+ * @return The frame arena
+ */
+arena_t* getFrameArena(void)
+{
+    return &frameArena;
+}
+
+/**
+ * @brief Get the current mode's arena, e.g. to mark and release it
+ *
+ * @return The mode arena
+ */
+arena_t* getModeArena(void)
+{
+    return &modeArena;
+}
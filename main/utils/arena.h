@@ -0,0 +1,124 @@
+/*!
+ * \file arena.h
+ * \brief Bump pointer arenas for short-lived allocations, and the per-frame and per-mode arenas which the mode
+ * framework manages
+ *
+ * \section arena_design Design Philosophy
+ *
+ * An ::arena_t is one block of memory which hands out allocations by moving a pointer forward. Allocating is a few
+ * instructions with no locking or searching, and nothing is freed individually. Instead the whole arena is reset at
+ * once, which makes it a good fit for data that all dies at the same time.
+ *
+ * The mode framework owns two arenas for the current Swadge mode, sized by swadgeMode_t.frameArenaSize and
+ * swadgeMode_t.modeArenaSize and placed in the memory given by swadgeMode_t.arenaCaps:
+ * - The frame arena is reset right before every call to swadgeMode_t.fnMainLoop, so anything from frameAlloc() or
+ *   frameCalloc() is valid until the end of the frame. Use it for scratch space like formatted text, temporary lists
+ *   and sort buffers.
+ * - The mode arena is freed right after swadgeMode_t.fnExitMode is called, so anything from modeAlloc() or
+ *   modeCalloc() lives until the mode exits and can never leak past it.
+ *
+ * A mode which leaves both sizes at zero gets no arenas, and the allocation functions return NULL.
+ *
+ * When an arena runs out of space, allocations return NULL just like heap_caps_malloc(). The high-water mark of each
+ * arena is logged when it is freed, and the emulator's allocation dump (F8) lists it next to the arena's block, which
+ * shows how large to make the arena.
+ *
+ * \section arena_usage Usage
+ *
+ * arenaInit() and arenaDeinit() allocate and free an arena's memory.
+ *
+ * arenaAlloc() and arenaCalloc() allocate from an arena.
+ *
+ * arenaReset() frees everything allocated from an arena at once.
+ *
+ * arenaMark() and arenaRelease() free everything allocated from an arena since a certain point.
+ *
+ * frameAlloc(), frameCalloc(), modeAlloc() and modeCalloc() allocate from the current mode's arenas.
+ *
+ * \section arena_example Example
+ *
+ * Declaring arenas for a mode:
+ * \code{.c}
+ * swadgeMode_t demoMode = {
+ *     .modeName       = demoName,
+ *     ...
+ *     .frameArenaSize = 1024,
+ *     .modeArenaSize  = 4096,
+ *     .arenaCaps      = MALLOC_CAP_8BIT,
+ * };
+ * \endcode
+ *
+ * Using the frame arena:
+ * \code{.c}
+ * static void demoMainLoop(int64_t elapsedUs)
+ * {
+ *     // No need to free this, it's freed before the next frame
+ *     char* str = frameAlloc(32);
+ *     if (str)
+ *     {
+ *         snprintf(str, 32, "Score: %" PRId32, score);
+ *         drawTextWordWrap(&font, c555, str, &x, &y, TFT_WIDTH, TFT_HEIGHT);
+ *     }
+ * }
+ * \endcode
+ */
+
+#ifndef _ARENA_H_
+#define _ARENA_H_
+
+//==============================================================================
+// Includes
+//==============================================================================
+
+#include <stdint.h>
+#include <stdbool.h>
+
+//==============================================================================
+// Defines
+//==============================================================================
+
+/// Allocations from an arena are aligned to this many bytes, enough for any type
+#define ARENA_ALIGN 8
+
+//==============================================================================
+// Structs
+//==============================================================================
+
+/**
+ * @brief A block of memory which is allocated from by moving a pointer forward, and freed all at once
+ */
+typedef struct
+{
+    uint8_t* base;      ///< The arena's memory, or NULL if it isn't initialized
+    uint32_t size;      ///< The size of the arena's memory, in bytes
+    uint32_t used;      ///< The number of bytes allocated since the last reset
+    uint32_t highWater; ///< The most bytes that were ever allocated at once
+    uint32_t failures;  ///< The number of allocations which didn't fit
+    bool grew;          ///< true if the high-water mark rose since it was last reported to the heap tracker
+    const char* name;   ///< A name for the arena in logs
+} arena_t;
+
+//==============================================================================
+// Function Prototypes
+//==============================================================================
+
+bool arenaInit(arena_t* arena, uint32_t size, uint32_t caps, const char* name);
+void arenaDeinit(arena_t* arena);
+void* arenaAlloc(arena_t* arena, uint32_t size);
+void* arenaCalloc(arena_t* arena, uint32_t n, uint32_t size);
+void arenaReset(arena_t* arena);
+uint32_t arenaMark(const arena_t* arena);
+void arenaRelease(arena_t* arena, uint32_t mark);
+
+void modeArenasStart(uint32_t frameSize, uint32_t modeSize, uint32_t caps);
+void modeArenasNewFrame(void);
+void modeArenasStop(void);
+
+void* frameAlloc(uint32_t size);
+void* frameCalloc(uint32_t n, uint32_t size);
+void* modeAlloc(uint32_t size);
+void* modeCalloc(uint32_t n, uint32_t size);
+arena_t* getFrameArena(void);
+arena_t* getModeArena(void);
+
+#endif
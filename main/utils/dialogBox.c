@@ -110,6 +110,8 @@ typedef struct
 static void layoutDialogBox(const dialogBox_t* dialogBox, const font_t* titleFont, const font_t* detailFont, uint16_t x,
                             uint16_t y, uint16_t w, uint16_t h, uint16_t r, dialogDrawInfo_t* dialogInfo,
                             optionDrawInfo_t* options);
+static void drawDialogBoxText(dialogBoxText_t* dText, const font_t* font, paletteColor_t color, const char* text,
+                              int16_t x, int16_t y, int16_t xMax, int16_t yMax);
 
 //==============================================================================
 // Function definitions
@@ -117,7 +119,8 @@ static void layoutDialogBox(const dialogBox_t* dialogBox, const font_t* titleFon
 /**
  * @brief Allocate and return a new dialogBox_t with the given settings.
  *
- * The result must be deallocated with deinitDialogBox().
+ * The result must be deallocated with deinitDialogBox(). The title and detail text are laid out once, so they must not
+ * be changed while the dialog box is used.
  *
  * @param title The title text of the dialog box
  * @param detail The body text of the dialog box
@@ -145,6 +148,8 @@ dialogBox_t* initDialogBox(const char* title, const char* detail, const wsg_t* i
 void deinitDialogBox(dialogBox_t* dialogBox)
 {
     dialogBoxReset(dialogBox);
+    textLayerDeinit(&dialogBox->titleText.layer);
+    textLayerDeinit(&dialogBox->detailText.layer);
     heap_caps_free(dialogBox);
 }
 
@@ -249,7 +254,7 @@ static void layoutDialogBox(const dialogBox_t* dialogBox, const font_t* titleFon
     if (autoW)
     {
         // TODO maybe treat single-line texts differently here too?
-        w = MIN(maxW, MAX(OPTION_MARGIN + textWidth(titleFont, dialogBox->title), w));
+        w = MIN(maxW, MAX(OPTION_MARGIN + textWidthCached(titleFont, dialogBox->title), w));
     }
 
     curY += 3;
@@ -283,7 +288,7 @@ static void layoutDialogBox(const dialogBox_t* dialogBox, const font_t* titleFon
 
     if (autoW)
     {
-        w = MIN(maxW, MAX(OPTION_MARGIN + textOffset + textWidth(detailFont, dialogBox->detail), w));
+        w = MIN(maxW, MAX(OPTION_MARGIN + textOffset + textWidthCached(detailFont, dialogBox->detail), w));
     }
 
     curX = DIALOG_PADDING;
@@ -319,7 +324,7 @@ static void layoutDialogBox(const dialogBox_t* dialogBox, const font_t* titleFon
             }
         }
 
-        itemW += textWidth(detailFont, option->label);
+        itemW += textWidthCached(detailFont, option->label);
 
         // Now we're done calculating the item width, arrange it in the dialog
 
@@ -393,7 +398,7 @@ static void layoutDialogBox(const dialogBox_t* dialogBox, const font_t* titleFon
 
     if (titleH <= titleFont->height + 1)
     {
-        dialogInfo->titleX += (w - DIALOG_PADDING - textWidth(titleFont, dialogBox->title)) / 2;
+        dialogInfo->titleX += (w - DIALOG_PADDING - textWidthCached(titleFont, dialogBox->title)) / 2;
     }
 
     // Adjust everything for the final X and Y
@@ -424,7 +429,7 @@ static void layoutDialogBox(const dialogBox_t* dialogBox, const font_t* titleFon
  * @param h The height of the dialog box, or if combined with \c DIALOG_AUTO, the maximum height of the dialog box
  * @param r The corner-radius of the dialog box
  */
-void drawDialogBox(const dialogBox_t* dialogBox, const font_t* titleFont, const font_t* detailFont, uint16_t x,
+void drawDialogBox(dialogBox_t* dialogBox, const font_t* titleFont, const font_t* detailFont, uint16_t x,
                    uint16_t y, uint16_t w, uint16_t h, uint16_t r)
 {
     dialogDrawInfo_t dialogInfo;
@@ -471,27 +476,22 @@ void drawDialogBox(const dialogBox_t* dialogBox, const font_t* titleFont, const
     drawCircleQuadrants(x + w - r, y + h - r, r, true, false, false, false, COL_DIALOG_BORDER); // Bottom-right
 
     //// Draw Text
-    int16_t textX = dialogInfo.titleX;
-    int16_t textY = dialogInfo.titleY;
 
     // Draw title
-    drawTextWordWrap(titleFont, COL_TITLE, dialogBox->title, &textX, &textY, x + w - DIALOG_PADDING,
-                     y + h - DIALOG_PADDING);
+    drawDialogBoxText(&dialogBox->titleText, titleFont, COL_TITLE, dialogBox->title, dialogInfo.titleX,
+                      dialogInfo.titleY, x + w - DIALOG_PADDING, y + h - DIALOG_PADDING);
 
     // Draw a line under the title
     drawLineFast(x + DIALOG_PADDING, dialogInfo.ruleY, x + w - DIALOG_PADDING, dialogInfo.ruleY, COL_DIALOG_BORDER);
 
-    textX = dialogInfo.detailX;
-    textY = dialogInfo.detailY;
-
     if (dialogBox->icon)
     {
         drawWsgSimple(dialogBox->icon, dialogInfo.iconX, dialogInfo.iconY);
     }
 
     // Draw the detail text
-    drawTextWordWrap(detailFont, COL_DETAIL, dialogBox->detail, &textX, &textY, x + w - DIALOG_PADDING,
-                     y + h - DIALOG_PADDING);
+    drawDialogBoxText(&dialogBox->detailText, detailFont, COL_DETAIL, dialogBox->detail, dialogInfo.detailX,
+                      dialogInfo.detailY, x + w - DIALOG_PADDING, y + h - DIALOG_PADDING);
 
     // Loop over buttons and draw them
     for (optionDrawInfo_t* drawInfo = optionInfos; drawInfo < (optionInfos + dialogBox->options.length); ++drawInfo)
@@ -529,6 +529,41 @@ void drawDialogBox(const dialogBox_t* dialogBox, const font_t* titleFont, const
     }
 }
 
+/**
+ * @brief Draw word-wrapped dialog box text, laying it out again only if the text, font, or bounds changed since it was
+ * last drawn
+ *
+ * @param dText The laid out text to draw, which is updated if it must be laid out again
+ * @param font The font to draw the text with
+ * @param color The color to draw the text with
+ * @param text The text to draw
+ * @param x The X coordinate to draw the text at
+ * @param y The Y coordinate to draw the text at
+ * @param xMax The maximum x-coordinate at which any text may be drawn
+ * @param yMax The maximum y-coordinate at which text may be drawn
+ */
+static void drawDialogBoxText(dialogBoxText_t* dText, const font_t* font, paletteColor_t color, const char* text,
+                              int16_t x, int16_t y, int16_t xMax, int16_t yMax)
+{
+    int16_t w = xMax - x;
+    int16_t h = yMax - y;
+    if (dText->layer.font != font || dText->text != text || dText->w != w || dText->h != h)
+    {
+        textLayerDeinit(&dText->layer);
+        if (!textLayerInit(&dText->layer, font, text, w, h, false))
+        {
+            // Couldn't allocate the layer, so wrap the text every frame instead
+            dText->layer.font = NULL;
+            drawTextWordWrap(font, color, text, &x, &y, xMax, yMax);
+            return;
+        }
+        dText->text = text;
+        dText->w    = w;
+        dText->h    = h;
+    }
+    drawTextLayer(&dText->layer, color, x, y);
+}
+
 /**
  * @brief Handle button presses for the dialog box
  *
@@ -135,6 +135,22 @@ typedef struct
     dialogOptionHint_t hints;
 } dialogBoxOption_t;
 
+/// @brief Word-wrapped dialog box text, laid out once and redrawn until the text, font, or bounds change
+typedef struct
+{
+    /// @brief The laid out text
+    textLayer_t layer;
+
+    /// @brief The text the layer was laid out from
+    const char* text;
+
+    /// @brief The width the text was laid out in
+    int16_t w;
+
+    /// @brief The height the text was laid out in
+    int16_t h;
+} dialogBoxText_t;
+
 typedef struct
 {
     /// @brief The icon to draw in the left side of the dialog box, or NULL for no icon
@@ -160,6 +176,12 @@ typedef struct
 
     /// @brief Whether B is being held
     bool holdB;
+
+    /// @brief The title text, laid out for drawing
+    dialogBoxText_t titleText;
+
+    /// @brief The detail text, laid out for drawing
+    dialogBoxText_t detailText;
 } dialogBox_t;
 
 //==============================================================================
@@ -169,7 +191,7 @@ dialogBox_t* initDialogBox(const char* title, const char* detail, const wsg_t* i
 void deinitDialogBox(dialogBox_t* dialogBox);
 void dialogBoxAddOption(dialogBox_t* dialogBox, const char* label, const wsg_t* icon, dialogOptionHint_t hints);
 void dialogBoxReset(dialogBox_t* dialogBox);
-void drawDialogBox(const dialogBox_t* dialogBox, const font_t* titleFont, const font_t* detailFont, uint16_t x,
+void drawDialogBox(dialogBox_t* dialogBox, const font_t* titleFont, const font_t* detailFont, uint16_t x,
                    uint16_t y, uint16_t w, uint16_t h, uint16_t r);
 void dialogBoxButton(dialogBox_t* dialogBox, const buttonEvt_t* evt);
 
@@ -58,6 +58,36 @@ static const uint8_t complNormLut[] = {
 // Functions
 //==============================================================================
 
+/**
+ * @brief Integer square root
+ *
+ * @param n The number to find the square root of
+ * @return The square root of n, rounded down
+ */
+uint32_t isqrt(uint32_t n)
+{
+    uint32_t root = 0;
+    uint32_t bit  = 1u << 30;
+    while (bit > n)
+    {
+        bit >>= 2;
+    }
+    while (bit)
+    {
+        if (n >= root + bit)
+        {
+            n -= root + bit;
+            root = (root >> 1) + bit;
+        }
+        else
+        {
+            root >>= 1;
+        }
+        bit >>= 2;
+    }
+    return root;
+}
+
 /**
  * @brief Quickly normalize a q24_8 vector, in-place
  *
@@ -66,6 +66,7 @@ typedef struct
 //==============================================================================
 
 void fastNormVec(q24_8* xp, q24_8* yp);
+uint32_t isqrt(uint32_t n);
 
 vec_q24_8 fpvAdd(vec_q24_8 a, vec_q24_8 b);
 vec_q24_8 fpvSub(vec_q24_8 a, vec_q24_8 b);
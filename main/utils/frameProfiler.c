@@ -0,0 +1,319 @@
+//==============================================================================
+// Includes
+//==============================================================================
+
+#include <stdlib.h>
+#include <string.h>
+
+#include <esp_timer.h>
+
+#include "hdw-tft.h"
+#include "fill.h"
+#include "macros.h"
+#include "frameProfiler.h"
+
+//==============================================================================
+// Defines
+//==============================================================================
+
+/// The height of the overlay bar, in pixels
+#define PROF_BAR_HEIGHT 3
+
+/// The row of the history used for whole frame timings
+#define PROF_FRAME_ROW PROF_NUM_PHASES
+
+//==============================================================================
+// Variables
+//==============================================================================
+
+/// The color each phase is drawn with in the overlay
+static const paletteColor_t phaseColors[PROF_NUM_PHASES] = {
+    [PROF_MIC]       = c055,
+    [PROF_AUDIO_OUT] = c505,
+    [PROF_ESP_NOW]   = c550,
+    [PROF_MAIN_LOOP] = c050,
+    [PROF_TFT]       = c005,
+};
+
+/// The time each phase was started, in microseconds
+static int64_t phaseStartUs[PROF_NUM_PHASES];
+/// The time spent in each phase in the current frame so far, in microseconds
+static uint32_t curFrameUs[PROF_NUM_PHASES];
+/// The time spent in each phase in the last complete frame, in microseconds
+static uint32_t lastFrameUs[PROF_NUM_PHASES];
+/// The time the current frame was started, in microseconds, or 0 if no frame has been started
+static int64_t frameStartUs;
+/// The time from the previous frame's start to the current frame's start, in microseconds
+static uint32_t frameIntervalUs;
+/// Whether the last complete frame was late
+static bool lastFrameLate;
+/// The budget for the last complete frame, in microseconds
+static uint32_t lastBudgetUs;
+
+/// Saturated timings for the last ::PROF_WINDOW frames, one row per phase and a last row for whole frames
+static uint16_t history[PROF_NUM_PHASES + 1][PROF_WINDOW];
+/// The sum of each row of history, for averages
+static uint32_t historySum[PROF_NUM_PHASES + 1];
+/// The longest time seen for each phase and for whole frames
+static uint32_t maxUs[PROF_NUM_PHASES + 1];
+/// The index in history the next frame is written to
+static uint16_t historyIdx;
+/// The number of valid frames in history
+static uint16_t historyCount;
+
+/// The number of frames since the stats were reset
+static uint32_t frameCount;
+/// The number of late frames since the stats were reset
+static uint32_t lateFrames;
+
+/// Whether the overlay is drawn
+#if defined(CONFIG_FRAME_PROFILER_OVERLAY)
+static bool overlayEnabled = true;
+#else
+static bool overlayEnabled = false;
+#endif
+
+//==============================================================================
+// Function Prototypes
+//==============================================================================
+
+static int cmpU16(const void* a, const void* b);
+static void computeStats(int row, profStats_t* stats);
+
+//==============================================================================
+// Functions
+//==============================================================================
+
+/**
+ * @brief Start a frame. The time between frame starts is the frame time, which includes time the main loop spent idle
+ * or yielding between phases.
+ */
+void profilerStartFrame(void)
+{
+    int64_t nowUs = esp_timer_get_time();
+    if (0 != frameStartUs)
+    {
+        frameIntervalUs = MIN(nowUs - frameStartUs, UINT32_MAX);
+    }
+    frameStartUs = nowUs;
+}
+
+/**
+ * @brief Start timing a phase of the main loop
+ *
+ * @param phase The phase being started
+ */
+void profilerPhaseStart(profPhase_t phase)
+{
+    phaseStartUs[phase] = esp_timer_get_time();
+}
+
+/**
+ * @brief Stop timing a phase of the main loop and add the elapsed time to the current frame
+ *
+ * @param phase The phase being ended. It must have been started with profilerPhaseStart()
+ */
+void profilerPhaseEnd(profPhase_t phase)
+{
+    curFrameUs[phase] += esp_timer_get_time() - phaseStartUs[phase];
+}
+
+/**
+ * @brief Finish a frame, adding its timings to the history and checking it against the budget. The frame is checked
+ * against the budget using the time from the previous frame's start to this frame's start, or the sum of its phases if
+ * it is the first frame.
+ *
+ * @param budgetUs The time budget for the frame, in microseconds
+ */
+void profilerEndFrame(uint32_t budgetUs)
+{
+    uint32_t totalUs = 0;
+    uint32_t frameUs = 0;
+    for (int phase = 0; phase <= PROF_NUM_PHASES; phase++)
+    {
+        uint32_t us;
+        if (PROF_FRAME_ROW == phase)
+        {
+            // Use the time between frame starts, which includes idle time, if there is one
+            us      = (0 != frameIntervalUs) ? frameIntervalUs : totalUs;
+            frameUs = us;
+        }
+        else
+        {
+            us                 = curFrameUs[phase];
+            lastFrameUs[phase] = us;
+            curFrameUs[phase]  = 0;
+            totalUs += us;
+        }
+
+        // Replace the oldest sample in the window
+        uint16_t sample = MIN(us, UINT16_MAX);
+        historySum[phase] += sample - history[phase][historyIdx];
+        history[phase][historyIdx] = sample;
+
+        if (us > maxUs[phase])
+        {
+            maxUs[phase] = us;
+        }
+    }
+
+    historyIdx = (historyIdx + 1) % PROF_WINDOW;
+    if (historyCount < PROF_WINDOW)
+    {
+        historyCount++;
+    }
+
+    lastBudgetUs  = budgetUs;
+    lastFrameLate = frameUs > budgetUs;
+    frameCount++;
+    if (lastFrameLate)
+    {
+        lateFrames++;
+    }
+}
+
+/**
+ * @brief Compare two uint16_t for qsort()
+ *
+ * @param a A pointer to the first uint16_t
+ * @param b A pointer to the second uint16_t
+ * @return Negative, zero, or positive if a is less than, equal to, or greater than b
+ */
+static int cmpU16(const void* a, const void* b)
+{
+    return (int)*(const uint16_t*)a - (int)*(const uint16_t*)b;
+}
+
+/**
+ * @brief Compute the stats for one row of the history
+ *
+ * @param row The phase, or ::PROF_FRAME_ROW for whole frames
+ * @param stats The stats are written here
+ */
+static void computeStats(int row, profStats_t* stats)
+{
+    memset(stats, 0, sizeof(profStats_t));
+    if (0 == historyCount)
+    {
+        return;
+    }
+
+    // The window is small, so just sort a copy of it for the percentile
+    uint16_t sorted[PROF_WINDOW];
+    memcpy(sorted, history[row], historyCount * sizeof(uint16_t));
+    qsort(sorted, historyCount, sizeof(uint16_t), cmpU16);
+
+    stats->minUs = sorted[0];
+    stats->avgUs = historySum[row] / historyCount;
+    stats->p99Us = sorted[(historyCount * 99 + 99) / 100 - 1];
+    stats->maxUs = maxUs[row];
+    stats->count = historyCount;
+}
+
+/**
+ * @brief Get the rolling stats for one phase of the main loop
+ *
+ * @param phase The phase to get stats for
+ * @param stats The stats are written here
+ */
+void profilerGetStats(profPhase_t phase, profStats_t* stats)
+{
+    computeStats(phase, stats);
+}
+
+/**
+ * @brief Get the rolling stats for whole frames, measured from one frame's start to the next
+ *
+ * @param stats The stats are written here
+ */
+void profilerGetFrameStats(profStats_t* stats)
+{
+    computeStats(PROF_FRAME_ROW, stats);
+}
+
+/**
+ * @brief Get the number of frames which took longer than their budget since the stats were reset
+ *
+ * @return The number of late frames
+ */
+uint32_t profilerGetLateFrames(void)
+{
+    return lateFrames;
+}
+
+/**
+ * @brief Get the number of frames since the stats were reset
+ *
+ * @return The number of frames
+ */
+uint32_t profilerGetFrameCount(void)
+{
+    return frameCount;
+}
+
+/**
+ * @brief Clear all stats and history. Timing of the current frame continues.
+ */
+void profilerReset(void)
+{
+    memset(history, 0, sizeof(history));
+    memset(historySum, 0, sizeof(historySum));
+    memset(maxUs, 0, sizeof(maxUs));
+    historyIdx   = 0;
+    historyCount = 0;
+    frameCount   = 0;
+    lateFrames   = 0;
+}
+
+/**
+ * @brief Show or hide the overlay bar
+ *
+ * @param enabled true to draw the overlay, false to not
+ */
+void profilerSetOverlay(bool enabled)
+{
+    overlayEnabled = enabled;
+}
+
+/**
+ * @brief Get whether the overlay bar is shown
+ *
+ * @return true if the overlay is drawn, false if it is not
+ */
+bool profilerGetOverlay(void)
+{
+    return overlayEnabled;
+}
+
+/**
+ * @brief Draw the overlay bar for the last complete frame across the top of the display, if it is enabled. This should
+ * be called right before the display is drawn.
+ */
+void drawProfilerOverlay(void)
+{
+    if (!overlayEnabled || 0 == lastBudgetUs)
+    {
+        return;
+    }
+
+    // The full bar is twice the budget
+    uint32_t scaleUs = 2 * lastBudgetUs;
+
+    fillDisplayArea(0, 0, TFT_WIDTH, PROF_BAR_HEIGHT, c000);
+
+    uint32_t sumUs = 0;
+    int16_t x      = 0;
+    for (int phase = 0; phase < PROF_NUM_PHASES && x < TFT_WIDTH; phase++)
+    {
+        sumUs += lastFrameUs[phase];
+        int16_t endX = MIN(((uint64_t)sumUs * TFT_WIDTH) / scaleUs, TFT_WIDTH);
+        if (endX > x)
+        {
+            fillDisplayArea(x, 0, endX, PROF_BAR_HEIGHT, phaseColors[phase]);
+            x = endX;
+        }
+    }
+
+    // Mark the budget
+    fillDisplayArea(TFT_WIDTH / 2 - 1, 0, TFT_WIDTH / 2 + 1, PROF_BAR_HEIGHT + 2, lastFrameLate ? c500 : c555);
+}
@@ -0,0 +1,94 @@
+/*! \file frameProfiler.h
+ *
+ * \section frameProfiler_design Design Philosophy
+ *
+ * The frame profiler measures how much of each frame's time budget is spent in each part of the system's main loop in
+ * app_main(). Each time the display is drawn is one frame, and the budget for a frame is the frame period set with
+ * setFrameRateUs(). The parts of the main loop, the ::profPhase_t, are timed separately. Work which happens many times
+ * per frame, like polling the DAC, is summed over the frame.
+ *
+ * The profiler keeps the last ::PROF_WINDOW frames of timings for each phase and for the whole frame. The whole frame
+ * time is measured from the previous frame's start to this frame's start, so it includes time the main loop spent idle
+ * or yielding, not just the phases. From those the rolling minimum, average, and 99th percentile are computed when
+ * queried. It also counts late frames, where the whole frame time was larger than the budget, and keeps the all-time
+ * maximum for each phase. Frame timings are saturated at \c UINT16_MAX microseconds to keep the history small.
+ *
+ * Timing is always on, since it only costs two esp_timer_get_time() calls per phase. The overlay is optional. When it
+ * is enabled, a bar is drawn across the top of the display right before it is sent to the TFT. The full width of the
+ * bar is twice the budget, and a tick in the middle marks the budget itself. The bar is split into one colored segment
+ * per phase for the previous frame, and the tick turns red if the previous frame was late. The overlay can be enabled
+ * at boot with \c CONFIG_FRAME_PROFILER_OVERLAY, or with the \c --profiler option in the emulator.
+ *
+ * \section frameProfiler_usage Usage
+ *
+ * The system firmware calls profilerStartFrame(), profilerPhaseStart(), profilerPhaseEnd(), profilerEndFrame(), and
+ * drawProfilerOverlay().
+ * Swadge modes don't need to call these.
+ *
+ * profilerGetStats(), profilerGetFrameStats(), and profilerGetLateFrames() may be used to query the stats, for instance
+ * to assert that a mode stays within budget in an automated run. profilerReset() clears them. profilerSetOverlay()
+ * shows or hides the overlay.
+ *
+ * \section frameProfiler_example Example
+ *
+ * \code{.c}
+ * profStats_t frame;
+ * profilerGetFrameStats(&frame);
+ * if (frame.p99Us > getFrameRateUs())
+ * {
+ *     ESP_LOGW("PROF", "p99 frame time %" PRIu32 "us is over budget, %" PRIu32 " late frames", frame.p99Us,
+ *              profilerGetLateFrames());
+ * }
+ * \endcode
+ */
+
+#ifndef _FRAME_PROFILER_H_
+#define _FRAME_PROFILER_H_
+
+#include <stdbool.h>
+#include <stdint.h>
+
+/// The number of frames of history the rolling stats are computed over
+#define PROF_WINDOW 128
+
+/**
+ * @brief The parts of the main loop which are timed
+ */
+typedef enum
+{
+    PROF_MIC,        ///< Reading and filtering microphone samples, and the mode's audio callback
+    PROF_AUDIO_OUT,  ///< Polling the DAC, which may fill an audio buffer, or checking the buzzer
+    PROF_ESP_NOW,    ///< Handling received ESP-NOW packets
+    PROF_MAIN_LOOP,  ///< The mode's main loop
+    PROF_TFT,        ///< Sending the frame to the TFT, including background draw callbacks
+    PROF_NUM_PHASES, ///< The number of phases
+} profPhase_t;
+
+/**
+ * @brief Stats for one phase, or for whole frames
+ */
+typedef struct
+{
+    uint32_t minUs; ///< The shortest time in the window, in microseconds
+    uint32_t avgUs; ///< The average time over the window, in microseconds
+    uint32_t p99Us; ///< The 99th percentile time over the window, in microseconds
+    uint32_t maxUs; ///< The longest time since the stats were reset, in microseconds
+    uint32_t count; ///< The number of frames in the window
+} profStats_t;
+
+void profilerStartFrame(void);
+void profilerPhaseStart(profPhase_t phase);
+void profilerPhaseEnd(profPhase_t phase);
+void profilerEndFrame(uint32_t budgetUs);
+
+void profilerGetStats(profPhase_t phase, profStats_t* stats);
+void profilerGetFrameStats(profStats_t* stats);
+uint32_t profilerGetLateFrames(void);
+uint32_t profilerGetFrameCount(void);
+void profilerReset(void);
+
+void profilerSetOverlay(bool enabled);
+bool profilerGetOverlay(void);
+void drawProfilerOverlay(void);
+
+#endif
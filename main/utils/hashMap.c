@@ -4,12 +4,15 @@
 
 #include "hashMap.h"
 
+#include <inttypes.h>
+#include <stdio.h>
 #include <stdlib.h>
 #include <stddef.h>
 #include <string.h>
 
 #include <esp_log.h>
 #include <esp_heap_caps.h>
+#include <esp_timer.h>
 
 //==============================================================================
 // Defines
@@ -18,6 +21,12 @@
 // #define HASH_LOG(...) ESP_LOGI("HashMap", __VA_ARGS__)
 #define HASH_LOG(...)
 
+/// The smallest number of entries a flat hash map holds
+#define HASH_FLAT_MIN_SIZE 8
+
+/// Multiplier for Fibonacci hashing, which spreads the key hash into the top bits used to pick a flat entry
+#define HASH_FLAT_MULT 2654435769u
+
 //==============================================================================
 // Structs
 //==============================================================================
@@ -26,7 +35,7 @@
  * @brief A single key-value pair in the hash map
  *
  */
-typedef struct
+typedef struct hashNode
 {
     ///<  The key's hash value
     uint32_t hash;
@@ -38,6 +47,19 @@ typedef struct
     void* value;
 } hashNode_t;
 
+/**
+ * @brief A single entry of a flat hash map
+ *
+ */
+typedef struct hashFlatNode
+{
+    ///<  The key-value pair, with a NULL key if this entry is empty
+    hashNode_t node;
+
+    ///<  One more than the number of entries between this one and its key's home, or 0 if this entry is empty
+    uint32_t psl;
+} hashFlatNode_t;
+
 /**
  * @brief A single element of the hash map array, holding either one value or a list of values.
  *
@@ -74,6 +96,9 @@ typedef struct hashIterState
     ///<  The node containing the current item
     hashNode_t* curNode;
 
+    ///<  The index of the current item, for flat hash maps
+    int curIndex;
+
     ///<  The number of items returned by the iterator
     int returned;
 
@@ -92,6 +117,11 @@ static hashNode_t* bucketPut(hashMap_t* map, hashBucket_t* bucket, const void* k
                              int* count);
 static hashNode_t bucketRemove(hashMap_t* map, hashBucket_t* bucket, hashNode_t* node, node_t* multiNode, int* count);
 static bool hashIterNext(const hashMap_t* map, hashIterator_t* iter);
+static inline int flatHome(const hashMap_t* map, uint32_t hash);
+static void flatInsert(hashMap_t* map, hashFlatNode_t entry);
+static void flatCheckSize(hashMap_t* map);
+static int flatFind(const hashMap_t* map, const void* key, uint32_t hash);
+static void flatRemoveAt(hashMap_t* map, int index);
 
 //==============================================================================
 // Functions
@@ -193,7 +223,8 @@ static hashNode_t* hashFindNode(hashMap_t* map, const void* key, uint32_t* hashO
 
     if (bucket->hasMulti)
     {
-        node = bucket->multi.first->val;
+        node        = bucket->multi.first->val;
+        listNodeOut = bucket->multi.first;
     }
     else
     {
@@ -443,6 +474,152 @@ static hashNode_t bucketRemove(hashMap_t* map, hashBucket_t* bucket, hashNode_t*
     return result;
 }
 
+/**
+ * @brief Find the entry a key hash would occupy in a flat hash map if nothing else were there
+ *
+ * @param map The flat hash map
+ * @param hash The key's hash
+ * @return The key's home index
+ */
+static inline int flatHome(const hashMap_t* map, uint32_t hash)
+{
+    // Sizes are powers of two, so the top bits of the product pick an entry
+    return (int)((hash * HASH_FLAT_MULT) >> (__builtin_clz((uint32_t)map->size) + 1));
+}
+
+/**
+ * @brief Insert an entry whose key is not yet in a flat hash map, using Robin Hood probing.
+ *
+ * Each entry is as far from its home as it can be without being farther than an entry it passed. Whenever the new
+ * entry has probed farther than the entry it meets, they swap places and the displaced entry carries on probing.
+ *
+ * Runtime: O(1) average case, O(n) worst case
+ *
+ * @param map The flat hash map to insert into. It must have an empty entry.
+ * @param entry The entry to insert. Its psl is set here
+ */
+static void flatInsert(hashMap_t* map, hashFlatNode_t entry)
+{
+    int mask  = map->size - 1;
+    int index = flatHome(map, entry.node.hash);
+    entry.psl = 1;
+
+    while (map->flat[index].psl != 0)
+    {
+        hashFlatNode_t* cur = &map->flat[index];
+        if (cur->psl < entry.psl)
+        {
+            // Take from the rich
+            hashFlatNode_t tmp = *cur;
+            *cur               = entry;
+            entry              = tmp;
+        }
+        index = (index + 1) & mask;
+        entry.psl++;
+    }
+
+    map->flat[index] = entry;
+}
+
+/**
+ * @brief Check a flat hash map's size and double it if necessary.
+ *
+ * Runtime: O(n)
+ *
+ * @param map The flat hash map to resize
+ */
+static void flatCheckSize(hashMap_t* map)
+{
+    // if count + 1 > size * .75
+    if ((map->count + 1) * 4 > 3 * map->size)
+    {
+        int oldSize             = map->size;
+        hashFlatNode_t* oldFlat = map->flat;
+        hashFlatNode_t* newFlat = heap_caps_calloc(oldSize * 2, sizeof(hashFlatNode_t), MALLOC_CAP_8BIT);
+
+        if (newFlat != NULL)
+        {
+            HASH_LOG("Resizing flat array from %d to %d (count=%d)", oldSize, oldSize * 2, map->count);
+            map->size = oldSize * 2;
+            map->flat = newFlat;
+            for (int i = 0; i < oldSize; i++)
+            {
+                if (oldFlat[i].psl != 0)
+                {
+                    flatInsert(map, oldFlat[i]);
+                }
+            }
+            heap_caps_free(oldFlat);
+        }
+        else
+        {
+            ESP_LOGE("HashMap", "Failed to resize HashMap");
+        }
+    }
+}
+
+/**
+ * @brief Find the index of the entry for a key in a flat hash map
+ *
+ * Runtime: O(1) average case, O(n) worst case. Robin Hood probing lets a search for a missing key stop as soon as it
+ * meets an entry closer to its home than the key would be. Empty entries have a psl of 0, so the same check stops at
+ * them too.
+ *
+ * @param map The flat hash map to search
+ * @param key The key to search for
+ * @param hash The key's hash
+ * @return The index of the key's entry, or -1 if it is not in the map
+ */
+static int flatFind(const hashMap_t* map, const void* key, uint32_t hash)
+{
+    eqFunction_t eqFn = map->eqFunc ? map->eqFunc : strEq;
+    int mask          = map->size - 1;
+    int index         = flatHome(map, hash);
+
+    for (uint32_t psl = 1; psl <= (uint32_t)map->size; psl++)
+    {
+        const hashFlatNode_t* cur = &map->flat[index];
+        if (cur->psl < psl)
+        {
+            return -1;
+        }
+        if (cur->node.hash == hash && eqFn(cur->node.key, key))
+        {
+            return index;
+        }
+        index = (index + 1) & mask;
+    }
+    return -1;
+}
+
+/**
+ * @brief Remove the entry at an index from a flat hash map.
+ *
+ * The entries after it which aren't in their home are shifted back by one to fill the gap, so no tombstones are left
+ * behind to slow down later searches.
+ *
+ * Runtime: O(1) average case, O(n) worst case
+ *
+ * @param map The flat hash map to remove from
+ * @param index The index of the entry to remove
+ */
+static void flatRemoveAt(hashMap_t* map, int index)
+{
+    int mask = map->size - 1;
+    int next = (index + 1) & mask;
+
+    while (map->flat[next].psl > 1)
+    {
+        map->flat[index] = map->flat[next];
+        map->flat[index].psl--;
+        index = next;
+        next  = (next + 1) & mask;
+    }
+
+    memset(&map->flat[index], 0, sizeof(hashFlatNode_t));
+    map->count--;
+}
+
 /**
  * @brief Convert a NULL-terminated string to a hash value
  *
@@ -594,6 +771,36 @@ void* hashRemove(hashMap_t* map, const char* key)
  */
 void hashPutBin(hashMap_t* map, const void* key, void* value)
 {
+    if (map->flat)
+    {
+        uint32_t hash = map->hashFunc ? map->hashFunc(key) : hashString((const char*)key);
+        int index     = flatFind(map, key, hash);
+        if (index >= 0)
+        {
+            map->flat[index].node.key   = key;
+            map->flat[index].node.value = value;
+            return;
+        }
+
+        flatCheckSize(map);
+        if (map->count >= map->size)
+        {
+            ESP_LOGE("HashMap", "HashMap is full");
+            return;
+        }
+
+        hashFlatNode_t entry = {
+            .node = {
+                .hash  = hash,
+                .key   = key,
+                .value = value,
+            },
+        };
+        flatInsert(map, entry);
+        map->count++;
+        return;
+    }
+
     hashCheckSize(map);
 
     uint32_t hash = map->hashFunc ? map->hashFunc(key) : hashString((const char*)key);
@@ -636,6 +843,12 @@ void hashPutBin(hashMap_t* map, const void* key, void* value)
  */
 void* hashGetBin(hashMap_t* map, const void* key)
 {
+    if (map->flat)
+    {
+        int index = flatFind(map, key, map->hashFunc ? map->hashFunc(key) : hashString((const char*)key));
+        return (index >= 0) ? map->flat[index].node.value : NULL;
+    }
+
     hashNode_t* node = hashFindNode(map, key, NULL, NULL, NULL);
 
     if (node == NULL || node->key == NULL)
@@ -657,6 +870,18 @@ void* hashGetBin(hashMap_t* map, const void* key)
  */
 void* hashRemoveBin(hashMap_t* map, const void* key)
 {
+    if (map->flat)
+    {
+        int index = flatFind(map, key, map->hashFunc ? map->hashFunc(key) : hashString((const char*)key));
+        if (index < 0)
+        {
+            return NULL;
+        }
+        void* value = map->flat[index].node.value;
+        flatRemoveAt(map, index);
+        return value;
+    }
+
     uint32_t hash;
     hashBucket_t* bucket = NULL;
     node_t* multiNode    = NULL;
@@ -695,6 +920,7 @@ void hashInit(hashMap_t* map, int initialSize)
     map->count    = 0;
     map->size     = initialSize;
     map->values   = heap_caps_calloc(map->size, sizeof(hashBucket_t), MALLOC_CAP_8BIT);
+    map->flat     = NULL;
     map->hashFunc = NULL;
     map->eqFunc   = NULL;
 }
@@ -715,6 +941,47 @@ void hashInitBin(hashMap_t* map, int initialSize, hashFunction_t hashFunc, eqFun
     map->eqFunc   = eqFunc;
 }
 
+/**
+ * @brief Initialize a flat hash map for string keys
+ *
+ * A flat hash map stores every entry inline in one array, so collisions don't allocate. It has the same API as a
+ * normal hash map.
+ *
+ * @param map A pointer to a hashMap_t struct to be initialized
+ * @param initialSize The initial size of the hash map, which is rounded up to a power of two
+ */
+void hashInitFlat(hashMap_t* map, int initialSize)
+{
+    int size = HASH_FLAT_MIN_SIZE;
+    while (size < initialSize)
+    {
+        size *= 2;
+    }
+
+    map->count    = 0;
+    map->size     = size;
+    map->values   = NULL;
+    map->flat     = heap_caps_calloc(map->size, sizeof(hashFlatNode_t), MALLOC_CAP_8BIT);
+    map->hashFunc = NULL;
+    map->eqFunc   = NULL;
+}
+
+/**
+ * @brief Initialize a flat hash map for non-string keys, using the given functions for hashing and comparison
+ *
+ * @param map A pointer to a hashMap_t struct to be initialized
+ * @param initialSize The initial size of the hash map, which is rounded up to a power of two
+ * @param hashFunc The hash function to use for the key datatype
+ * @param eqFunc The comparison function to use for the key datatype
+ */
+void hashInitFlatBin(hashMap_t* map, int initialSize, hashFunction_t hashFunc, eqFunction_t eqFunc)
+{
+    hashInitFlat(map, initialSize);
+
+    map->hashFunc = hashFunc;
+    map->eqFunc   = eqFunc;
+}
+
 /**
  * @brief Deinitialize and free all memory associated with the given hash map
  *
@@ -722,7 +989,7 @@ void hashInitBin(hashMap_t* map, int initialSize, hashFunction_t hashFunc, eqFun
  */
 void hashDeinit(hashMap_t* map)
 {
-    if (map->count > 0)
+    if (map->count > 0 && map->values)
     {
         for (hashBucket_t* bucket = map->values; bucket < (map->values + map->size); bucket++)
         {
@@ -738,6 +1005,9 @@ void hashDeinit(hashMap_t* map)
     }
 
     heap_caps_free(map->values);
+    heap_caps_free(map->flat);
+    map->values   = NULL;
+    map->flat     = NULL;
     map->size     = 0;
     map->count    = 0;
     map->eqFunc   = NULL;
@@ -755,6 +1025,30 @@ void hashDeinit(hashMap_t* map)
 static bool hashIterNext(const hashMap_t* map, hashIterator_t* iterator)
 {
     hashIterState_t* state = iterator->_state;
+
+    if (map->flat)
+    {
+        if (state == NULL)
+        {
+            // Start the iteration before the first entry
+            iterator->_state = state = heap_caps_calloc(1, sizeof(hashIterState_t), MALLOC_CAP_8BIT);
+            state->curIndex          = -1;
+        }
+
+        // Scan for the next non-empty entry
+        do
+        {
+            if (++state->curIndex >= map->size)
+            {
+                // End of the line
+                return false;
+            }
+        } while (!map->flat[state->curIndex].psl);
+
+        state->curNode = &map->flat[state->curIndex].node;
+        return true;
+    }
+
     do
     {
         bool nextBucket = false;
@@ -911,6 +1205,22 @@ bool hashIterRemove(hashMap_t* map, hashIterator_t* iter)
     hashIterState_t* state = iter->_state;
     bool result            = false;
 
+    if (map->flat)
+    {
+        // Removing shifts the following entry back into this one, so look here again for the next item
+        flatRemoveAt(map, state->curIndex);
+        state->returned--;
+        state->curIndex--;
+        result         = hashIterNext(map, iter);
+        state->removed = result;
+        if (!result)
+        {
+            // Iteration is complete, so free the iterator like hashIterate() would
+            hashIterReset(iter);
+        }
+        return result;
+    }
+
     int newCount         = map->count;
     node_t* nextListNode = state->curBucket->hasMulti ? state->curListNode->next : NULL;
     bucketRemove(map, state->curBucket, state->curNode, state->curListNode, &newCount);
@@ -931,6 +1241,11 @@ bool hashIterRemove(hashMap_t* map, hashIterator_t* iter)
     if (nextListNode == NULL)
     {
         result = hashIterNext(map, iter);
+        if (!result)
+        {
+            // Iteration is complete, so free the iterator like hashIterate() would
+            hashIterReset(iter);
+        }
     }
     else
     {
@@ -971,7 +1286,25 @@ void hashReport(const hashMap_t* map)
 
     ESP_LOGI("HashMap", "================");
     ESP_LOGI("HashMap", "Hash Map %p contains %d items in %d buckets", (const void*)map, map->count, map->size);
-    for (hashBucket_t* bucket = map->values; bucket < (map->values + map->size); bucket++)
+    for (int i = 0; map->flat && i < map->size; i++)
+    {
+        const hashNode_t* node = &map->flat[i].node;
+        if (node->key == NULL)
+        {
+            ESP_LOGI("HashMap", "Entry %04d is empty", i);
+        }
+        else if (stringKeys)
+        {
+            ESP_LOGI("HashMap", "Entry %04d is %d from home with hash=%08" PRIx32 ", value=%p, and key=\"%s\"", i,
+                     map->flat[i].psl - 1, node->hash, node->value, (const char*)node->key);
+        }
+        else
+        {
+            ESP_LOGI("HashMap", "Entry %04d is %d from home with hash=%08" PRIx32 ", value=%p, and key=%p", i,
+                     map->flat[i].psl - 1, node->hash, node->value, node->key);
+        }
+    }
+    for (hashBucket_t* bucket = map->values; bucket && bucket < (map->values + map->size); bucket++)
     {
         uint32_t bucketIdx = (uint32_t)(bucket - map->values);
         if (bucket->hasMulti && bucket->multi.length > 0)
@@ -1022,4 +1355,88 @@ void hashReport(const hashMap_t* map)
         }
     }
     ESP_LOGI("HashMap", "================");
-}
\ No newline at end of file
+}
+/**
+ * @brief Time put, get, iterate, and remove on a normal and a flat hash map with the same string keys, and log the
+ * time each operation takes per item
+ *
+ * @param items The number of items to put in each map
+ */
+void hashBenchmark(int items)
+{
+    static const char* const backendNames[] = {"normal", "flat"};
+    const int keyLen                        = 16;
+
+    // Keys must remain valid while they are in the map, so format them all ahead of time
+    char* keys   = heap_caps_malloc(items * keyLen, MALLOC_CAP_8BIT);
+    char* misses = heap_caps_malloc(items * keyLen, MALLOC_CAP_8BIT);
+    if (NULL == keys || NULL == misses)
+    {
+        heap_caps_free(keys);
+        heap_caps_free(misses);
+        return;
+    }
+    for (int i = 0; i < items; i++)
+    {
+        snprintf(&keys[i * keyLen], keyLen, "key-%d", i);
+        snprintf(&misses[i * keyLen], keyLen, "miss-%d", i);
+    }
+
+    for (int flat = 0; flat < 2; flat++)
+    {
+        hashMap_t map;
+        if (flat)
+        {
+            hashInitFlat(&map, 16);
+        }
+        else
+        {
+            hashInit(&map, 16);
+        }
+        int errors = 0;
+
+        int64_t start = esp_timer_get_time();
+        for (int i = 0; i < items; i++)
+        {
+            hashPut(&map, &keys[i * keyLen], (void*)(intptr_t)(i + 1));
+        }
+        int64_t putUs = esp_timer_get_time() - start;
+
+        start = esp_timer_get_time();
+        for (int i = 0; i < items; i++)
+        {
+            errors += (hashGet(&map, &keys[i * keyLen]) != (void*)(intptr_t)(i + 1));
+            errors += (hashGet(&map, &misses[i * keyLen]) != NULL);
+        }
+        int64_t getUs = esp_timer_get_time() - start;
+
+        start               = esp_timer_get_time();
+        int seen            = 0;
+        hashIterator_t iter = {0};
+        while (hashIterate(&map, &iter))
+        {
+            seen++;
+        }
+        int64_t iterUs = esp_timer_get_time() - start;
+        errors += (seen != items);
+
+        start = esp_timer_get_time();
+        for (int i = 0; i < items; i++)
+        {
+            errors += (hashRemove(&map, &keys[i * keyLen]) != (void*)(intptr_t)(i + 1));
+        }
+        int64_t removeUs = esp_timer_get_time() - start;
+        errors += (map.count != 0);
+
+        hashDeinit(&map);
+
+        ESP_LOGI("HashMap",
+                 "%-6s %d items: put %" PRId64 "ns, get (hit + miss) %" PRId64 "ns, iterate %" PRId64
+                 "ns, remove %" PRId64 "ns per item, %d errors",
+                 backendNames[flat], items, putUs * 1000 / items, getUs * 1000 / items, iterUs * 1000 / items,
+                 removeUs * 1000 / items, errors);
+    }
+
+    heap_caps_free(keys);
+    heap_caps_free(misses);
+}
@@ -24,6 +24,23 @@
  * which buckets or keys are in use. This could theoretically be improved to O(n) worst case if keys were also kept in
  * a separate array, but this would be a marginal improvement with a lot of added complexity.
  *
+ * \subsection hashMap_flat Flat Hash Maps
+ *
+ * A hash map initialized with hashInitFlat() or hashInitFlatBin() uses the same API, but stores every entry inline in
+ * one array instead of allocating a list node for each collision. Collisions are handled by open addressing with
+ * Robin Hood probing, where an entry being inserted takes the place of any entry it meets which is closer to its own
+ * home, so probe lengths stay short and even, and a search for a missing key can stop early. Removing an entry shifts
+ * the entries after it back into the gap rather than leaving a tombstone. Each entry stores how far it is from its
+ * home, so probing doesn't rehash the entries it passes. The array is a power of two in size, and doubles once it
+ * becomes 75% full.
+ *
+ * hashPut() only allocates when the array grows, and hashRemove() never frees, so those are cheaper than in a normal
+ * hash map. Lookups and iteration are not faster. A normal hash map rarely shares a bucket between similar string
+ * keys, so its hashGet() is usually a single comparison, and in hashBenchmark() a flat hashGet() is slightly slower.
+ * Prefer a flat hash map where entries are added and removed often, not for lookup speed.
+ *
+ * The emulator's \c --hash-bench option compares the two with hashBenchmark().
+ *
  * \section hashMap_caveats Caveats
  *
  * It's important to note that, even though the hash map is a reasonably efficient data structure, its main use case
@@ -38,6 +55,8 @@
  *
  * hashInit() allocates a new hash map for use with string keys.
  *
+ * hashInitFlat() allocates a new flat hash map for use with string keys.
+ *
  * hashPut() adds a new entry to the map or updates the value of an existing one.
  *
  * hashGet() retrieves a value from the map.
@@ -54,7 +73,7 @@
  *
  * hashPutBin(), hashGetBin(), and hashRemoveBin() are variants of the normal hash map functions which accept
  * a void pointer in the \c key argument, rather than a char pointer. You must provide hash and equality
- * functions to hashInitBin() in order to safely use keys which are not nul-terminated strings.
+ * functions to hashInitBin() or hashInitFlatBin() in order to safely use keys which are not nul-terminated strings.
  *
  * hashString() and strEq() are the default hash and comparison functions respectively, and will be used when
  * the hash map is initialized with hashInit().
@@ -390,6 +409,8 @@ typedef uint32_t (*hashFunction_t)(const void* data);
 typedef bool (*eqFunction_t)(const void* a, const void* b);
 
 // Forward-declared internal structs
+typedef struct hashNode hashNode_t;
+typedef struct hashFlatNode hashFlatNode_t;
 typedef struct hashBucket hashBucket_t;
 typedef struct hashIterState hashIterState_t;
 
@@ -418,9 +439,12 @@ typedef struct
     /// @brief The actual number of items stored in the hash map
     int count;
 
-    /// @brief The array of bucket values
+    /// @brief The array of bucket values, or NULL for a flat hash map
     hashBucket_t* values;
 
+    /// @brief The array of inline entries of a flat hash map, or NULL for a normal hash map
+    hashFlatNode_t* flat;
+
     /// @brief The key hash function to use, or NULL to use hashString()
     hashFunction_t hashFunc;
 
@@ -450,6 +474,8 @@ void* hashRemoveBin(hashMap_t* map, const void* key);
 
 void hashInit(hashMap_t* map, int initialSize);
 void hashInitBin(hashMap_t* map, int initialSize, hashFunction_t hashFunc, eqFunction_t eqFunc);
+void hashInitFlat(hashMap_t* map, int initialSize);
+void hashInitFlatBin(hashMap_t* map, int initialSize, hashFunction_t hashFunc, eqFunction_t eqFunc);
 void hashDeinit(hashMap_t* map);
 
 bool hashIterate(const hashMap_t* map, hashIterator_t* iterator);
@@ -457,5 +483,6 @@ bool hashIterRemove(hashMap_t* map, hashIterator_t* iter);
 void hashIterReset(hashIterator_t* iterator);
 
 void hashReport(const hashMap_t* map);
+void hashBenchmark(int items);
 
 #endif
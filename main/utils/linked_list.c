@@ -4,6 +4,7 @@
 
 #include <stdlib.h>
 #include <stdio.h>
+#include <string.h>
 #include <inttypes.h>
 
 #include <esp_log.h>
@@ -22,10 +23,33 @@
     #define VALIDATE_LIST(func, line, nl, list, target)
 #endif
 
+//==============================================================================
+// Structs
+//==============================================================================
+
+/**
+ * @brief A block of nodes allocated at once for a ::listPool_t
+ */
+typedef struct listPoolSlab
+{
+    struct listPoolSlab* next; ///< The slab allocated before this one
+    node_t nodes[];            ///< listPool_t.slabNodes nodes
+} listPoolSlab_t;
+
+//==============================================================================
+// Variables
+//==============================================================================
+
+/// The number of nodes allocated individually on the heap, for lists without a pool
+static uint32_t heapNodeAllocs = 0;
+
 //==============================================================================
 // Function Prototypes
 //==============================================================================
 
+static node_t* allocNode(list_t* list);
+static void freeNode(list_t* list, node_t* node);
+
 #ifdef TEST_LIST
 static void validateList(const char* func, int line, bool nl, list_t* list, node_t* target);
 #endif
@@ -34,6 +58,74 @@ static void validateList(const char* func, int line, bool nl, list_t* list, node
 // Functions
 //==============================================================================
 
+/**
+ * @brief Get a node for a list, from the list's pool if it has one or from the heap if it doesn't
+ *
+ * @param list The list the node will be added to
+ * @return The node, or NULL if it couldn't be allocated. Its members are not initialized.
+ */
+static node_t* allocNode(list_t* list)
+{
+    listPool_t* pool = list->pool;
+    if (NULL == pool)
+    {
+        heapNodeAllocs++;
+        return heap_caps_malloc(sizeof(node_t), MALLOC_CAP_8BIT);
+    }
+
+    if (NULL == pool->freeNodes)
+    {
+        // Out of nodes, allocate another slab and thread all of its nodes onto the free list
+        listPoolSlab_t* slab = heap_caps_malloc(sizeof(listPoolSlab_t) + pool->slabNodes * sizeof(node_t), pool->caps);
+        if (NULL == slab)
+        {
+            ESP_LOGE("LIST", "Couldn't allocate a slab of %" PRIu16 " nodes", pool->slabNodes);
+            return NULL;
+        }
+        slab->next  = pool->slabs;
+        pool->slabs = slab;
+        pool->slabAllocs++;
+
+        for (int i = 0; i < pool->slabNodes - 1; i++)
+        {
+            slab->nodes[i].next = &slab->nodes[i + 1];
+        }
+        slab->nodes[pool->slabNodes - 1].next = NULL;
+        pool->freeNodes                       = slab->nodes;
+    }
+
+    node_t* node    = pool->freeNodes;
+    pool->freeNodes = node->next;
+
+    pool->nodeAllocs++;
+    pool->inUse++;
+    if (pool->inUse > pool->peak)
+    {
+        pool->peak = pool->inUse;
+    }
+    return node;
+}
+
+/**
+ * @brief Return a node removed from a list to the list's pool, or free it if the list has no pool
+ *
+ * @param list The list the node was removed from
+ * @param node The node to free
+ */
+static void freeNode(list_t* list, node_t* node)
+{
+    listPool_t* pool = list->pool;
+    if (NULL == pool)
+    {
+        heap_caps_free(node);
+        return;
+    }
+
+    node->next      = pool->freeNodes;
+    pool->freeNodes = node;
+    pool->inUse--;
+}
+
 /**
  * @brief Add to the end of the list
  *
@@ -43,7 +135,11 @@ static void validateList(const char* func, int line, bool nl, list_t* list, node
 void push(list_t* list, void* val)
 {
     VALIDATE_LIST(__func__, __LINE__, true, list, val);
-    node_t* newLast = heap_caps_malloc(sizeof(node_t), MALLOC_CAP_8BIT);
+    node_t* newLast = allocNode(list);
+    if (NULL == newLast)
+    {
+        return;
+    }
     newLast->val    = val;
     newLast->next   = NULL;
     newLast->prev   = list->last;
@@ -94,7 +190,7 @@ void* pop(list_t* list)
 
         // Get the last node val, then free it and update length
         retval = target->val;
-        heap_caps_free(target);
+        freeNode(list, target);
         list->length--;
     }
 
@@ -111,7 +207,11 @@ void* pop(list_t* list)
 void unshift(list_t* list, void* val)
 {
     VALIDATE_LIST(__func__, __LINE__, true, list, val);
-    node_t* newFirst = heap_caps_malloc(sizeof(node_t), MALLOC_CAP_8BIT);
+    node_t* newFirst = allocNode(list);
+    if (NULL == newFirst)
+    {
+        return;
+    }
     newFirst->val    = val;
     newFirst->next   = list->first;
     newFirst->prev   = NULL;
@@ -162,7 +262,7 @@ void* shift(list_t* list)
 
         // Get the first node val, then free it and update length
         retval = target->val;
-        heap_caps_free(target);
+        freeNode(list, target);
         list->length--;
     }
 
@@ -176,7 +276,7 @@ void* shift(list_t* list)
  * @param list The list to add to
  * @param val The value to add
  * @param index The index to add the value at
- * @return true if the value was added, false if the index was invalid
+ * @return true if the value was added, false if the index was invalid or a node couldn't be allocated
  */
 bool addIdx(list_t* list, void* val, uint16_t index)
 {
@@ -194,10 +294,14 @@ bool addIdx(list_t* list, void* val, uint16_t index)
     // Else if the index we're trying to add to is before the end of the list
     else if (index < list->length - 1)
     {
-        node_t* newNode = heap_caps_malloc(sizeof(node_t), MALLOC_CAP_8BIT);
-        newNode->val    = val;
-        newNode->next   = NULL;
-        newNode->prev   = NULL;
+        node_t* newNode = allocNode(list);
+        if (NULL == newNode)
+        {
+            return false;
+        }
+        newNode->val  = val;
+        newNode->next = NULL;
+        newNode->prev = NULL;
 
         node_t* current = list->first;
         for (uint16_t i = 0; i < index - 1; i++)
@@ -249,7 +353,11 @@ void addBefore(list_t* list, void* val, node_t* entry)
     else
     {
         node_t* prev    = entry->prev;
-        node_t* newNode = heap_caps_malloc(sizeof(node_t), MALLOC_CAP_8BIT);
+        node_t* newNode = allocNode(list);
+        if (NULL == newNode)
+        {
+            return;
+        }
         newNode->val    = val;
         newNode->prev   = prev;
         newNode->next   = entry;
@@ -288,7 +396,11 @@ void addAfter(list_t* list, void* val, node_t* entry)
     else
     {
         node_t* next    = entry->next;
-        node_t* newNode = heap_caps_malloc(sizeof(node_t), MALLOC_CAP_8BIT);
+        node_t* newNode = allocNode(list);
+        if (NULL == newNode)
+        {
+            return;
+        }
         newNode->val    = val;
         newNode->prev   = entry;
         newNode->next   = next;
@@ -350,7 +462,7 @@ void* removeIdx(list_t* list, uint16_t index)
         current->next       = target->next;
         current->next->prev = current;
 
-        heap_caps_free(target);
+        freeNode(list, target);
         target = NULL;
 
         list->length--;
@@ -416,7 +528,7 @@ void* removeEntry(list_t* list, node_t* entry)
     VALIDATE_LIST(__func__, __LINE__, false, list, entry);
 
     // free the memory
-    heap_caps_free(entry);
+    freeNode(list, entry);
 
     // Return the value
     return retVal;
@@ -437,6 +549,61 @@ void clear(list_t* list)
     VALIDATE_LIST(__func__, __LINE__, false, list, NULL);
 }
 
+/**
+ * @brief Initialize a pool of list nodes. No memory is allocated until a list using the pool needs a node.
+ *
+ * @param pool The pool to initialize
+ * @param slabNodes The number of nodes to allocate at once when the pool runs out, must be at least 1
+ * @param caps The heap capabilities to allocate slabs with, e.g. MALLOC_CAP_8BIT or MALLOC_CAP_SPIRAM
+ */
+void listPoolInit(listPool_t* pool, uint16_t slabNodes, uint32_t caps)
+{
+    memset(pool, 0, sizeof(listPool_t));
+    pool->slabNodes = (slabNodes > 0) ? slabNodes : 1;
+    pool->caps      = caps;
+}
+
+/**
+ * @brief Free every slab in a pool at once. All lists using the pool must be cleared or abandoned first, since their
+ * nodes are freed too. The pool may be used again afterwards.
+ *
+ * @param pool The pool to free
+ */
+void listPoolDeinit(listPool_t* pool)
+{
+    while (NULL != pool->slabs)
+    {
+        listPoolSlab_t* next = pool->slabs->next;
+        heap_caps_free(pool->slabs);
+        pool->slabs = next;
+    }
+    pool->freeNodes = NULL;
+    pool->inUse     = 0;
+}
+
+/**
+ * @brief Log how many nodes a pool handed out and how many heap allocations it made to do so
+ *
+ * @param pool The pool to log
+ * @param name A name for the pool in the log
+ */
+void listPoolLog(const listPool_t* pool, const char* name)
+{
+    ESP_LOGI("LIST", "%s: %" PRIu32 " nodes from %" PRIu32 " slab allocs of %" PRIu16 ", peak %" PRId32 ", %" PRId32
+                     " in use",
+             name, pool->nodeAllocs, pool->slabAllocs, pool->slabNodes, pool->peak, pool->inUse);
+}
+
+/**
+ * @brief Get the number of nodes allocated individually on the heap, for lists without a pool
+ *
+ * @return The number of heap allocations made for nodes since boot
+ */
+uint32_t listHeapNodeAllocs(void)
+{
+    return heapNodeAllocs;
+}
+
 #ifdef TEST_LIST
 
 /**
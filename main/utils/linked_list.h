@@ -21,6 +21,22 @@
  *
  * Links are allocated, so when done with a list, be sure to call clear() when done.
  *
+ * \section linked_list_pool Node Pools
+ *
+ * By default each link is its own heap allocation, which is made on every add and freed on every remove. Lists which
+ * churn, like search frontiers and work queues, can instead draw links from a ::listPool_t. A pool allocates links in
+ * slabs and keeps removed links on a free list to be reused, so a list which stays about the same size stops touching
+ * the heap entirely. Any number of lists may share one pool, e.g. one pool for a whole mode.
+ *
+ * To use a pool, initialize it with listPoolInit(), then point a list's \c pool at it while the list is empty. The
+ * list API is otherwise unchanged. Lists with a NULL \c pool, including any list that was calloc'd or zero
+ * initialized, use the heap as before. listPoolDeinit() frees every slab at once, so it must only be called after all
+ * lists using the pool are cleared or abandoned, typically when the mode exits.
+ *
+ * listPoolLog() prints how many links were handed out against how many heap allocations were actually made.
+ * listHeapNodeAllocs() counts the links allocated individually for lists without a pool, so a mode can log how many it
+ * made while it ran. Big Bug logs both when it exits.
+ *
  * \section linked_list_example Example
  *
  * Creating an empty list:
@@ -61,6 +77,22 @@
  * // Remove from tail
  * uint32_t* poppedVal = pop(myList);
  * \endcode
+ *
+ * Drawing links from a pool:
+ * \code{.c}
+ * // When the mode starts
+ * listPool_t pool;
+ * listPoolInit(&pool, 64, MALLOC_CAP_8BIT);
+ *
+ * // Point lists at the pool while they're empty
+ * list_t queue = {.pool = &pool};
+ * push(&queue, (void*)val1);
+ * pop(&queue);
+ *
+ * // When the mode exits, after clearing the lists
+ * clear(&queue);
+ * listPoolDeinit(&pool);
+ * \endcode
  */
 
 #ifndef _LINKED_LIST_H
@@ -80,14 +112,30 @@ typedef struct node
     struct node* prev; ///< The previous node in the list
 } node_t;
 
+/**
+ * @brief A pool of ::node_t allocated in slabs, with freed nodes kept on an intrusive free list for reuse
+ */
+typedef struct
+{
+    node_t* freeNodes;          ///< Nodes ready to be reused, linked through node_t.next
+    struct listPoolSlab* slabs; ///< Every slab allocated for this pool, freed together by listPoolDeinit()
+    uint16_t slabNodes;         ///< The number of nodes allocated in each slab
+    uint32_t caps;              ///< The heap capabilities slabs are allocated with
+    int32_t inUse;              ///< The number of nodes currently in lists
+    int32_t peak;               ///< The most nodes that were ever in lists at once
+    uint32_t nodeAllocs;        ///< The number of nodes handed out to lists
+    uint32_t slabAllocs;        ///< The number of heap allocations made for slabs
+} listPool_t;
+
 /**
  * @brief A doubly linked list with pointers to the first and last nodes
  */
 typedef struct
 {
-    node_t* first; ///< The first node in the list
-    node_t* last;  ///< The last node in the list
-    int length;    ///< The number of nodes in the list
+    node_t* first;    ///< The first node in the list
+    node_t* last;     ///< The last node in the list
+    int length;       ///< The number of nodes in the list
+    listPool_t* pool; ///< The pool to draw nodes from, or NULL to allocate each node on the heap
 } list_t;
 
 void push(list_t* list, void* val);
@@ -101,6 +149,11 @@ void* removeIdx(list_t* list, uint16_t index);
 void* removeEntry(list_t* list, node_t* entry);
 void clear(list_t* list);
 
+void listPoolInit(listPool_t* pool, uint16_t slabNodes, uint32_t caps);
+void listPoolDeinit(listPool_t* pool);
+void listPoolLog(const listPool_t* pool, const char* name);
+uint32_t listHeapNodeAllocs(void);
+
 #ifdef TEST_LIST
 // Exercise the linked list functions
 void listTester(void);
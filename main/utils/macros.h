@@ -129,4 +129,5 @@
 #define heap_caps_calloc_tag(n, s, c, t)  heap_caps_calloc(n, s, c)
 #define heap_caps_realloc_tag(p, s, c, t) heap_caps_realloc(p, s, c)
 #define heap_caps_free_tag(p)             heap_caps_free(p)
+#define heap_caps_track_high_water(p, h)
 #endif
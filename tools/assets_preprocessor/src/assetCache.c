@@ -0,0 +1,493 @@
+#include <dirent.h>
+#include <errno.h>
+#include <inttypes.h>
+#include <pthread.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <sys/stat.h>
+#include <sys/types.h>
+
+#include "fileUtils.h"
+#include "assetCache.h"
+
+/*
+ * The asset cache skips processing files whose contents haven't changed, rather than comparing modification times.
+ *
+ * Each job's output is keyed by a hash of the source file's contents, the output's extension, and a salt made of the
+ * preprocessor's options. A manifest in the cache directory records the hash each output in the output directory was
+ * made from, so unchanged sources are skipped even if they were touched. Every processed output is also copied into the
+ * cache directory, named by its hash, so renamed sources and sources restored by switching branches are copied from
+ * there instead of being processed again.
+ *
+ * At the end of each run, the manifest only keeps the outputs the run made or checked, and any cached output which it
+ * doesn't reference is deleted, so the cache doesn't grow forever.
+ *
+ * The cache directory must not be the output directory, since everything in the output directory is packed into the
+ * firmware image.
+ */
+
+/// Bump this when the output of any processor changes, to invalidate old caches
+#define ASSET_CACHE_VERSION 2
+
+/// The name of the manifest file in the cache directory
+#define MANIFEST_NAME "manifest.txt"
+
+/// The maximum number of outputs one job may write
+#define MAX_PENDING 4
+
+typedef struct
+{
+    char outFile[128]; ///< The output file's name, without the directory
+    uint64_t hash;     ///< The hash of the inputs the output file was made from
+    bool used;         ///< Whether this run made or checked the output file
+} cacheEntry_t;
+
+typedef struct
+{
+    char outFile[128]; ///< The full path of the output file
+    uint64_t hash;     ///< The hash of the inputs it's being made from
+} pendingOutput_t;
+
+/// The directory the manifest and cached outputs are kept in, or NULL if caching is disabled
+static const char* cacheDir = NULL;
+/// The salt mixed into every hash
+static char cacheSalt[64];
+
+/// The manifest entries
+static cacheEntry_t* entries = NULL;
+/// The number of manifest entries
+static int numEntries = 0;
+/// The allocated length of entries
+static int maxEntries = 0;
+/// A counter to make temporary file names unique
+static uint32_t tmpCounter = 0;
+/// Protects the manifest and tmpCounter
+static pthread_mutex_t cacheLock = PTHREAD_MUTEX_INITIALIZER;
+
+/// The outputs the current job is producing, which will be added to the cache when it ends
+static __thread pendingOutput_t pending[MAX_PENDING];
+/// The number of pending outputs for the current job
+static __thread int numPending = 0;
+/// Whether the current job processed any file rather than using the cache
+static __thread bool jobProcessed = false;
+/// The time the current job started
+static __thread time_t jobStart = 0;
+
+static void makeDir(const char* path);
+static uint8_t* readFile(const char* path, long* len);
+static bool copyFile(const char* src, const char* dst);
+static uint64_t hashBytes(uint64_t hash, const void* data, size_t len);
+static const char* getExtension(const char* path);
+static cacheEntry_t* findEntry(const char* outName);
+static void setEntry(const char* outName, uint64_t hash, bool used);
+static bool isCacheFileUsed(const char* name);
+static void pruneCache(void);
+
+/**
+ * @brief Create a directory if it doesn't exist
+ *
+ * @param path The directory to create
+ */
+static void makeDir(const char* path)
+{
+    struct stat st = {0};
+    if (stat(path, &st) == -1)
+    {
+#if defined(WINDOWS) || defined(__WINDOWS__) || defined(_WINDOWS) || defined(WIN32) || defined(WIN64) \
+    || defined(_WIN32) || defined(_WIN64) || defined(__WIN32__) || defined(__TOS_WIN__) || defined(_MSC_VER)
+        mkdir(path);
+#elif defined(__linux) || defined(__linux__) || defined(linux) || defined(__LINUX__) || defined(__CYGWIN__) \
+    || defined(__APPLE__)
+        mkdir(path, 0777);
+#endif
+    }
+}
+
+/**
+ * @brief Read an entire file into memory
+ *
+ * @param path The file to read
+ * @param[out] len The length of the file is written here
+ * @return The file's contents, which must be freed, or NULL if it couldn't be read
+ */
+static uint8_t* readFile(const char* path, long* len)
+{
+    FILE* fp = fopen(path, "rb");
+    if (NULL == fp)
+    {
+        return NULL;
+    }
+
+    fseek(fp, 0L, SEEK_END);
+    *len = ftell(fp);
+    fseek(fp, 0L, SEEK_SET);
+
+    uint8_t* data = malloc(*len + 1);
+    if (NULL != data && fread(data, 1, *len, fp) < (size_t)*len)
+    {
+        free(data);
+        data = NULL;
+    }
+    fclose(fp);
+    return data;
+}
+
+/**
+ * @brief Copy a file. The copy is written to a temporary file and renamed, so other threads never see a partial file
+ *
+ * @param src The file to copy
+ * @param dst The file to write
+ * @return true if the file was copied, false if it wasn't
+ */
+static bool copyFile(const char* src, const char* dst)
+{
+    long len      = 0;
+    uint8_t* data = readFile(src, &len);
+    if (NULL == data)
+    {
+        return false;
+    }
+
+    pthread_mutex_lock(&cacheLock);
+    uint32_t tmpId = tmpCounter++;
+    pthread_mutex_unlock(&cacheLock);
+
+    char tmpPath[160];
+    snprintf(tmpPath, sizeof(tmpPath), "%s.tmp%" PRIu32, dst, tmpId);
+
+    bool ok  = false;
+    FILE* fp = fopen(tmpPath, "wb");
+    if (NULL != fp)
+    {
+        ok = (fwrite(data, 1, len, fp) == (size_t)len);
+        ok = (0 == fclose(fp)) && ok;
+        // rename() won't replace an existing file on Windows
+        remove(dst);
+        ok = ok && (0 == rename(tmpPath, dst));
+        if (!ok)
+        {
+            remove(tmpPath);
+        }
+    }
+
+    free(data);
+    return ok;
+}
+
+/**
+ * @brief Add bytes to a 64-bit FNV-1a hash
+ *
+ * @param hash The hash so far
+ * @param data The bytes to hash
+ * @param len The number of bytes to hash
+ * @return The new hash
+ */
+static uint64_t hashBytes(uint64_t hash, const void* data, size_t len)
+{
+    const uint8_t* bytes = data;
+    for (size_t i = 0; i < len; i++)
+    {
+        hash ^= bytes[i];
+        hash *= 0x100000001b3ULL;
+    }
+    return hash;
+}
+
+/**
+ * @brief Get the extension of a file name, without the dot
+ *
+ * @param path The file name, with or without the directory
+ * @return The extension, or "out" if there isn't one
+ */
+static const char* getExtension(const char* path)
+{
+    // get_filename() returns "" for names without a directory
+    const char* name = strrchr(path, '/');
+    name             = (NULL == name) ? path : name + 1;
+    const char* dot  = strrchr(name, '.');
+    return (NULL == dot) ? "out" : dot + 1;
+}
+
+/**
+ * @brief Find the manifest entry for an output file. cacheLock must be held
+ *
+ * @param outName The output file's name, without the directory
+ * @return The entry, or NULL if there isn't one
+ */
+static cacheEntry_t* findEntry(const char* outName)
+{
+    for (int i = 0; i < numEntries; i++)
+    {
+        if (0 == strcmp(entries[i].outFile, outName))
+        {
+            return &entries[i];
+        }
+    }
+    return NULL;
+}
+
+/**
+ * @brief Set the hash of an output file in the manifest, adding an entry if there isn't one
+ *
+ * @param outName The output file's name, without the directory
+ * @param hash The hash of the inputs it was made from
+ * @param used true if this run made the output file, false if it's only loaded from the manifest
+ */
+static void setEntry(const char* outName, uint64_t hash, bool used)
+{
+    pthread_mutex_lock(&cacheLock);
+    cacheEntry_t* entry = findEntry(outName);
+    if (NULL == entry)
+    {
+        if (numEntries == maxEntries)
+        {
+            maxEntries = maxEntries ? 2 * maxEntries : 256;
+            entries    = realloc(entries, maxEntries * sizeof(cacheEntry_t));
+        }
+        entry = &entries[numEntries++];
+        snprintf(entry->outFile, sizeof(entry->outFile), "%s", outName);
+    }
+    entry->hash = hash;
+    entry->used = used;
+    pthread_mutex_unlock(&cacheLock);
+}
+
+/**
+ * @brief Check if a cached output is referenced by a manifest entry which this run used
+ *
+ * @param name The cached output's name, without the directory. It must start with a 16 digit hash and a dot
+ * @return true if the file must be kept, false if it can be deleted
+ */
+static bool isCacheFileUsed(const char* name)
+{
+    uint64_t hash   = strtoull(name, NULL, 16);
+    const char* ext = name + 17;
+    for (int i = 0; i < numEntries; i++)
+    {
+        if (entries[i].used && entries[i].hash == hash && 0 == strcmp(ext, getExtension(entries[i].outFile)))
+        {
+            return true;
+        }
+    }
+    return false;
+}
+
+/**
+ * @brief Delete cached outputs which no used manifest entry references, along with any temporary files left behind by
+ * a run which was interrupted
+ */
+static void pruneCache(void)
+{
+    DIR* dir = opendir(cacheDir);
+    if (NULL == dir)
+    {
+        return;
+    }
+
+    int pruned = 0;
+    struct dirent* ent;
+    while (NULL != (ent = readdir(dir)))
+    {
+        // Only touch files named like cached outputs, a 16 digit hash, a dot, and an extension
+        if (16 == strspn(ent->d_name, "0123456789abcdef") && '.' == ent->d_name[16] && !isCacheFileUsed(ent->d_name))
+        {
+            char path[160 + sizeof(ent->d_name)];
+            snprintf(path, sizeof(path), "%s/%s", cacheDir, ent->d_name);
+            if (0 == remove(path))
+            {
+                pruned++;
+            }
+        }
+    }
+    closedir(dir);
+
+    if (pruned)
+    {
+        printf("[assets-preprocessor] Pruned %d unused files from the cache\n", pruned);
+    }
+}
+
+/**
+ * @brief Enable the cache and load its manifest. If this isn't called, files are processed when the source file is
+ * newer than the output file
+ *
+ * @param dir The directory to keep the cache in. It is created if it doesn't exist
+ * @param salt A string describing the options which change the output, so files are processed again when they change
+ * @return true if the cache was enabled, false if it wasn't
+ */
+bool initAssetCache(const char* dir, const char* salt)
+{
+    makeDir(dir);
+    cacheDir = dir;
+    snprintf(cacheSalt, sizeof(cacheSalt), "v%d:%s", ASSET_CACHE_VERSION, salt);
+
+    char path[160];
+    snprintf(path, sizeof(path), "%s/" MANIFEST_NAME, cacheDir);
+    FILE* fp = fopen(path, "r");
+    if (NULL == fp)
+    {
+        // No manifest yet, which is fine
+        return true;
+    }
+
+    // Only use the manifest if it was written with the same version and options
+    char line[256];
+    char header[sizeof(cacheSalt) + 16];
+    snprintf(header, sizeof(header), "%s\n", cacheSalt);
+    if (NULL != fgets(line, sizeof(line), fp) && 0 == strcmp(line, header))
+    {
+        uint64_t hash;
+        char outName[128];
+        while (2 == fscanf(fp, "%" SCNx64 " %127s", &hash, outName))
+        {
+            setEntry(outName, hash, false);
+        }
+    }
+    fclose(fp);
+    return true;
+}
+
+/**
+ * @brief Write the manifest with only the outputs this run made or checked, delete cached outputs it no longer
+ * references, and disable the cache
+ */
+void deinitAssetCache(void)
+{
+    if (NULL == cacheDir)
+    {
+        return;
+    }
+
+    char path[160];
+    snprintf(path, sizeof(path), "%s/" MANIFEST_NAME, cacheDir);
+    FILE* fp = fopen(path, "w");
+    if (NULL == fp)
+    {
+        fprintf(stderr, "ERR: assetCache.c: Failed to write %s: %d - %s\n", path, errno, strerror(errno));
+    }
+    else
+    {
+        fprintf(fp, "%s\n", cacheSalt);
+        for (int i = 0; i < numEntries; i++)
+        {
+            if (entries[i].used)
+            {
+                fprintf(fp, "%016" PRIx64 " %s\n", entries[i].hash, entries[i].outFile);
+            }
+        }
+        fclose(fp);
+
+        // Only prune once the manifest is safely written
+        pruneCache();
+    }
+
+    free(entries);
+    entries    = NULL;
+    numEntries = 0;
+    maxEntries = 0;
+    cacheDir   = NULL;
+}
+
+/**
+ * @brief Check if a source file must be processed to make an output file. This is called by each processor. If the
+ * cache has an output made from identical source contents, it is copied to the output file and false is returned.
+ *
+ * @param inFile The source file
+ * @param outFile The output file made from it
+ * @return true if inFile must be processed, false if outFile is up to date
+ */
+bool shouldProcessFile(const char* inFile, const char* outFile)
+{
+    if (NULL == cacheDir)
+    {
+        bool newer = isSourceFileNewer(inFile, outFile);
+        jobProcessed |= newer;
+        return newer;
+    }
+
+    // Hash the options, the kind of output, and the source
+    long len      = 0;
+    uint8_t* data = readFile(inFile, &len);
+    if (NULL == data)
+    {
+        jobProcessed = true;
+        return true;
+    }
+    const char* ext = getExtension(outFile);
+    uint64_t hash   = hashBytes(0xcbf29ce484222325ULL, cacheSalt, strlen(cacheSalt) + 1);
+    hash            = hashBytes(hash, ext, strlen(ext) + 1);
+    hash            = hashBytes(hash, data, len);
+    free(data);
+
+    // If the output was already made from this source, there's nothing to do
+    const char* outName = get_filename(outFile);
+    pthread_mutex_lock(&cacheLock);
+    cacheEntry_t* entry = findEntry(outName);
+    bool upToDate       = (NULL != entry) && (entry->hash == hash);
+    pthread_mutex_unlock(&cacheLock);
+    if (upToDate && doesFileExist(outFile))
+    {
+        setEntry(outName, hash, true);
+        return false;
+    }
+
+    // If the output was made from this source before, but has since been overwritten or renamed, copy it back
+    char cachePath[160];
+    snprintf(cachePath, sizeof(cachePath), "%s/%016" PRIx64 ".%s", cacheDir, hash, ext);
+    if (doesFileExist(cachePath) && copyFile(cachePath, outFile))
+    {
+        setEntry(outName, hash, true);
+        return false;
+    }
+
+    // The file must be processed. Remember the output so it's cached when the job ends
+    if (numPending < MAX_PENDING)
+    {
+        snprintf(pending[numPending].outFile, sizeof(pending[numPending].outFile), "%s", outFile);
+        pending[numPending].hash = hash;
+        numPending++;
+    }
+    jobProcessed = true;
+    return true;
+}
+
+/**
+ * @brief Start a job on this thread. This must be called before running a processor
+ */
+void assetCacheBeginJob(void)
+{
+    numPending   = 0;
+    jobProcessed = false;
+    jobStart     = time(NULL);
+}
+
+/**
+ * @brief Finish a job on this thread, adding any outputs it wrote to the cache. Outputs which weren't written during
+ * the job, for instance because processing failed, aren't added
+ *
+ * @return true if the job processed a file, false if everything was up to date or copied from the cache
+ */
+bool assetCacheEndJob(void)
+{
+    for (int i = 0; i < numPending; i++)
+    {
+        struct stat st = {0};
+        if (0 != stat(pending[i].outFile, &st) || st.st_mtime < jobStart)
+        {
+            continue;
+        }
+
+        char cachePath[160];
+        snprintf(cachePath, sizeof(cachePath), "%s/%016" PRIx64 ".%s", cacheDir, pending[i].hash,
+                 getExtension(pending[i].outFile));
+        if (copyFile(pending[i].outFile, cachePath))
+        {
+            setEntry(get_filename(pending[i].outFile), pending[i].hash, true);
+        }
+    }
+    numPending = 0;
+    return jobProcessed;
+}
@@ -0,0 +1,13 @@
+#ifndef _ASSET_CACHE_H_
+#define _ASSET_CACHE_H_
+
+#include <stdbool.h>
+
+bool initAssetCache(const char* cacheDir, const char* salt);
+void deinitAssetCache(void);
+
+bool shouldProcessFile(const char* inFile, const char* outFile);
+void assetCacheBeginJob(void);
+bool assetCacheEndJob(void);
+
+#endif
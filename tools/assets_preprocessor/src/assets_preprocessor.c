@@ -1,11 +1,17 @@
+// For strdup(), clock_gettime(), and ftw() with -std=c99
+#define _XOPEN_SOURCE 700
+
 #include <ctype.h>
 #include <fcntl.h>
 #include <ftw.h>
 #include <getopt.h>
+#include <inttypes.h>
+#include <pthread.h>
 #include <stdbool.h>
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
+#include <time.h>
 #include <unistd.h>
 #include <sys/types.h>
 #include <sys/stat.h>
@@ -18,6 +24,15 @@
 #include "txt_processor.h"
 #include "rmd_processor.h"
 #include "raw_processor.h"
+#include "midi_processor.h"
+#include "assetCache.h"
+#include "heatshrink_util.h"
+
+/// The most threads which will process assets at once
+#define MAX_THREADS 64
+
+#define CLAMP(x, l, u) ((x) < l ? l : ((x) > u ? u : (x)))
+#define MIN(a, b)       (((a) < (b)) ? (a) : (b))
 
 /**
  * @brief A mapping of file extensions that should be compressed using heatshrink without any other processing
@@ -29,10 +44,92 @@ static const char* rawFileTypes[][2] = {
     {"raw", "raw"},
 };
 
+/**
+ * @brief The kinds of assets, each handled by a different processor
+ */
+typedef enum
+{
+    ASSET_NONE = -1, ///< Not an asset
+    ASSET_FONT,      ///< A .font.png font
+    ASSET_IMAGE,     ///< A .png image
+    ASSET_CHART,     ///< A .chart file
+    ASSET_JSON,      ///< A .json file
+    ASSET_BIN,       ///< A .bin file, copied as-is
+    ASSET_TXT,       ///< A .txt file
+    ASSET_RMD,       ///< A .rmd file
+    ASSET_MIDI,      ///< A MIDI file which will be merged
+    ASSET_RAW,       ///< A file which is compressed without other processing
+    ASSET_NUM_TYPES, ///< The number of asset types
+} assetType_t;
+
+/**
+ * @brief One asset to process
+ */
+typedef struct
+{
+    char* path;         ///< The path of the source file
+    assetType_t type;   ///< The kind of asset
+    const char* rawExt; ///< For ASSET_RAW, the output file's extension
+    long long size;     ///< The size of the source file, in bytes
+    int next;           ///< The index of the next job which may write the same output file, or -1
+    bool chained;       ///< Whether this job runs after another job which may write the same output file
+    bool superseded;    ///< Whether a later job writes the same output file, so this one is skipped
+} assetJob_t;
+
+/**
+ * @brief Counts and time spent for one type of asset
+ */
+typedef struct
+{
+    int files;      ///< The number of files of this type
+    int processed;  ///< The number of files which had to be processed
+    double seconds; ///< The total time spent on files of this type, summed over all threads
+} assetTypeStats_t;
+
+/// The names of each assetType_t, for the summary
+static const char* assetTypeNames[ASSET_NUM_TYPES] = {
+    [ASSET_FONT] = "font", [ASSET_IMAGE] = "image", [ASSET_CHART] = "chart", [ASSET_JSON] = "json", [ASSET_BIN] = "bin",
+    [ASSET_TXT] = "txt",   [ASSET_RMD] = "rmd",     [ASSET_MIDI] = "midi",   [ASSET_RAW] = "raw",
+};
+
 const char* outDirName = NULL;
 
+/// Whether to merge MIDI file tracks and add a seek index, rather than compressing them unchanged
+static bool mergeMidiFiles = false;
+
+/// All assets found in the input directory
+static assetJob_t* jobs = NULL;
+/// The number of assets in jobs
+static int numJobs = 0;
+/// The allocated length of jobs
+static int maxJobs = 0;
+/// Indices of jobs which aren't chained to another, in the order threads claim them
+static int* schedule = NULL;
+/// The number of jobs in schedule
+static int numScheduled = 0;
+/// The index of the next job in schedule for a thread to claim
+static int nextJob = 0;
+/// Counts and time spent for each type of asset
+static assetTypeStats_t typeStats[ASSET_NUM_TYPES];
+/// The number of threads processing jobs
+static int numThreads = 1;
+/// Protects nextJob and typeStats
+static pthread_mutex_t jobLock = PTHREAD_MUTEX_INITIALIZER;
+
 void print_usage(void);
 bool endsWith(const char* filename, const char* suffix);
+static assetType_t getAssetType(const char* fpath, const char** rawExt);
+static int queueFile(const char* fpath, const struct stat* st, int tflag);
+static int compareJobPaths(const void* a, const void* b);
+static const char* getStem(const char* fpath, int* len);
+static void getOutputName(const assetJob_t* job, char* outName, size_t outLen);
+static int compareStems(const void* a, const void* b);
+static void chainJobs(void);
+static int compareJobSizes(const void* a, const void* b);
+static void processJob(const assetJob_t* job);
+static double getTimeS(void);
+static void* processJobs(void* arg);
+static void printSummary(double wallTime);
 
 /**
  * @brief TODO
@@ -40,7 +137,19 @@ bool endsWith(const char* filename, const char* suffix);
  */
 void print_usage(void)
 {
-    printf("Usage:\n  assets_preprocessor\n    -i INPUT_DIRECTORY\n    -o OUTPUT_DIRECTORY\n");
+    printf("Usage:\n"
+           "  assets_preprocessor\n"
+           "    -i INPUT_DIRECTORY\n"
+           "    -o OUTPUT_DIRECTORY\n"
+           "    [-m] (merge MIDI tracks and add a seek index)\n"
+           "    [-c CACHE_DIRECTORY] (skip files whose contents haven't changed)\n"
+           "    [-j THREADS] (default is one per CPU)\n"
+           "    [-w DECODE_WEIGHT] (prefer faster decoding over smaller files, in hundredths of a byte per "
+           "decompressed byte, default 0)\n"
+           "    [-r REPORT_FILE] (write a CSV of each file's compression)\n"
+           "    [-d none|diffuse|ordered] (how images are dithered, default none)\n"
+           "    [-s SEED] (the seed for diffusion dithering, default 0)\n"
+           "    [-b PNG_FILE] (benchmark dithering PNG_FILE, then exit)\n");
 }
 
 /**
@@ -61,61 +170,94 @@ bool endsWith(const char* filename, const char* suffix)
 }
 
 /**
- * @brief TODO
+ * @brief Get the type of an asset from its file name
  *
- * @param fpath
- * @param st
- * @param tflag
- * @return int
+ * @param fpath The path of the asset
+ * @param[out] rawExt If the asset is a raw file, the extension of the output file is written here
+ * @return The type of the asset, or ASSET_NONE if it isn't processed
  */
-static int processFile(const char* fpath, const struct stat* st __attribute__((unused)), int tflag)
+static assetType_t getAssetType(const char* fpath, const char** rawExt)
 {
-    switch (tflag)
+    if (endsWith(fpath, ".font.png"))
     {
-        case FTW_F: // file
+        return ASSET_FONT;
+    }
+    else if (endsWith(fpath, ".png"))
+    {
+        return ASSET_IMAGE;
+    }
+    else if (endsWith(fpath, ".chart"))
+    {
+        return ASSET_CHART;
+    }
+    else if (endsWith(fpath, ".json"))
+    {
+        return ASSET_JSON;
+    }
+    else if (endsWith(fpath, ".bin"))
+    {
+        return ASSET_BIN;
+    }
+    else if (endsWith(fpath, ".txt"))
+    {
+        return ASSET_TXT;
+    }
+    else if (endsWith(fpath, ".rmd"))
+    {
+        return ASSET_RMD;
+    }
+    else if (mergeMidiFiles && (endsWith(fpath, ".mid") || endsWith(fpath, ".midi")))
+    {
+        return ASSET_MIDI;
+    }
+    else
+    {
+        char extBuf[16];
+        for (int i = 0; i < (sizeof(rawFileTypes) / sizeof(rawFileTypes[0])); i++)
         {
-            if (endsWith(fpath, ".font.png"))
-            {
-                process_font(fpath, outDirName);
-            }
-            else if (endsWith(fpath, ".png"))
-            {
-                process_image(fpath, outDirName);
-            }
-            else if (endsWith(fpath, ".chart"))
-            {
-                process_chart(fpath, outDirName);
-            }
-            else if (endsWith(fpath, ".json"))
-            {
-                process_json(fpath, outDirName);
-            }
-            else if (endsWith(fpath, ".bin"))
-            {
-                process_bin(fpath, outDirName);
-            }
-            else if (endsWith(fpath, ".txt"))
-            {
-                process_txt(fpath, outDirName);
-            }
-            else if (endsWith(fpath, ".rmd"))
+            snprintf(extBuf, sizeof(extBuf), ".%s", rawFileTypes[i][0]);
+
+            if (endsWith(fpath, extBuf))
             {
-                process_rmd(fpath, outDirName);
+                *rawExt = rawFileTypes[i][1];
+                return ASSET_RAW;
             }
-            else
+        }
+    }
+    return ASSET_NONE;
+}
+
+/**
+ * @brief Add a file found while walking the input directory to the list of jobs, if it is an asset
+ *
+ * @param fpath The path of the file
+ * @param st The file's status
+ * @param tflag What kind of file it is
+ * @return 0 to continue walking, -1 to stop
+ */
+static int queueFile(const char* fpath, const struct stat* st, int tflag)
+{
+    switch (tflag)
+    {
+        case FTW_F: // file
+        {
+            const char* rawExt = NULL;
+            assetType_t type   = getAssetType(fpath, &rawExt);
+            if (ASSET_NONE != type)
             {
-                char extBuf[16];
-                for (int i = 0; i < (sizeof(rawFileTypes) / sizeof(rawFileTypes[0])); i++)
+                if (numJobs == maxJobs)
                 {
-                    snprintf(extBuf, sizeof(extBuf), ".%s", rawFileTypes[i][0]);
-
-                    if (endsWith(fpath, extBuf))
-                    {
-                        // printf("Processing %s to raw .%s file\n", fpath, rawFileTypes[i][1]);
-                        process_raw(fpath, outDirName, rawFileTypes[i][1]);
-                        break;
-                    }
+                    maxJobs = maxJobs ? 2 * maxJobs : 256;
+                    jobs    = realloc(jobs, maxJobs * sizeof(assetJob_t));
                 }
+                jobs[numJobs].path   = strdup(fpath);
+                jobs[numJobs].type   = type;
+                jobs[numJobs].rawExt = rawExt;
+                jobs[numJobs].size   = st->st_size;
+                jobs[numJobs].next       = -1;
+                jobs[numJobs].chained    = false;
+                jobs[numJobs].superseded = false;
+                numJobs++;
             }
             break;
         }
@@ -134,6 +276,351 @@ static int processFile(const char* fpath, const struct stat* st __attribute__((u
     return 0;
 }
 
+/**
+ * @brief Sort jobs by path, so the order doesn't depend on the order the file system lists directories in
+ *
+ * @param a A pointer to one job
+ * @param b A pointer to another job
+ * @return Negative if a sorts first, positive if b does
+ */
+static int compareJobPaths(const void* a, const void* b)
+{
+    return strcmp(((const assetJob_t*)a)->path, ((const assetJob_t*)b)->path);
+}
+
+/**
+ * @brief Get the part of a file's name before the first dot
+ *
+ * @param fpath The path of the file
+ * @param[out] len The length of the stem is written here
+ * @return A pointer to the start of the stem in fpath
+ */
+static const char* getStem(const char* fpath, int* len)
+{
+    const char* name = strrchr(fpath, '/');
+    name             = (NULL == name) ? fpath : name + 1;
+    const char* dot  = strchr(name, '.');
+    *len             = (NULL == dot) ? (int)strlen(name) : (int)(dot - name);
+    return name;
+}
+
+/**
+ * @brief Get the name of the file a job writes, the same way its processor names it. This is the source file's name
+ * with the last extension replaced by the output extension, so a dot in the name is kept.
+ *
+ * @param job The job to get the output name of
+ * @param[out] outName The output file name is written here
+ * @param outLen The size of outName
+ */
+static void getOutputName(const assetJob_t* job, char* outName, size_t outLen)
+{
+    const char* name = strrchr(job->path, '/');
+    name             = (NULL == name) ? job->path : name + 1;
+    const char* dot  = strrchr(name, '.');
+    int baseLen      = (NULL == dot) ? (int)strlen(name) : (int)(dot - name);
+
+    const char* outExt = NULL;
+    switch (job->type)
+    {
+        case ASSET_FONT:
+        {
+            // ".font.png" becomes ".font"
+            snprintf(outName, outLen, "%.*s", baseLen, name);
+            return;
+        }
+        case ASSET_IMAGE:
+        {
+            outExt = "wsg";
+            break;
+        }
+        case ASSET_CHART:
+        {
+            outExt = "cch";
+            break;
+        }
+        case ASSET_JSON:
+        {
+            outExt = "hjs";
+            break;
+        }
+        case ASSET_RMD:
+        {
+            outExt = "rmh";
+            break;
+        }
+        case ASSET_MIDI:
+        {
+            outExt = "mid";
+            break;
+        }
+        case ASSET_RAW:
+        {
+            outExt = job->rawExt;
+            break;
+        }
+        case ASSET_BIN:
+        case ASSET_TXT:
+        case ASSET_NONE:
+        case ASSET_NUM_TYPES:
+        {
+            // Written with the same name
+            snprintf(outName, outLen, "%s", name);
+            return;
+        }
+    }
+    snprintf(outName, outLen, "%.*s.%s", baseLen, name, outExt);
+}
+
+/**
+ * @brief Sort job indices by the stem of the file name, then by the order the files were found
+ *
+ * @param a A pointer to one job index
+ * @param b A pointer to another job index
+ * @return Negative if a sorts first, positive if b does
+ */
+static int compareStems(const void* a, const void* b)
+{
+    int idxA = *(const int*)a;
+    int idxB = *(const int*)b;
+    int lenA, lenB;
+    const char* stemA = getStem(jobs[idxA].path, &lenA);
+    const char* stemB = getStem(jobs[idxB].path, &lenB);
+    int cmp           = strncmp(stemA, stemB, MIN(lenA, lenB));
+    if (0 == cmp)
+    {
+        cmp = (lenA > lenB) - (lenA < lenB);
+    }
+    return (0 != cmp) ? cmp : (idxA - idxB);
+}
+
+/**
+ * @brief Output files are named after the source file, so files with the same name in different directories write the
+ * same output. Chain jobs with the same file name stem so they run one after another on the same thread, in path
+ * order. When two sources write the same output file, only the last in path order is processed, and a warning is
+ * printed
+ */
+static void chainJobs(void)
+{
+    int* byStem = malloc(numJobs * sizeof(int));
+    for (int i = 0; i < numJobs; i++)
+    {
+        byStem[i] = i;
+    }
+    qsort(byStem, numJobs, sizeof(int), compareStems);
+
+    for (int i = 1; i < numJobs; i++)
+    {
+        int lenA, lenB;
+        const char* stemA = getStem(jobs[byStem[i - 1]].path, &lenA);
+        const char* stemB = getStem(jobs[byStem[i]].path, &lenB);
+        if (lenA == lenB && 0 == strncmp(stemA, stemB, lenA))
+        {
+            jobs[byStem[i - 1]].next = byStem[i];
+            jobs[byStem[i]].chained  = true;
+        }
+    }
+    free(byStem);
+
+    // Only keep the last of the jobs in a chain which write the same output. Jobs with the same stem may still write
+    // different files, e.g. "a.b.mid" and "a.b2.mid", so compare the output names
+    for (int i = 0; i < numJobs; i++)
+    {
+        char outI[256];
+        getOutputName(&jobs[i], outI, sizeof(outI));
+        for (int j = jobs[i].next; -1 != j; j = jobs[j].next)
+        {
+            char outJ[256];
+            getOutputName(&jobs[j], outJ, sizeof(outJ));
+            if (0 == strcmp(outI, outJ))
+            {
+                fprintf(stderr, "WARN: %s and %s write the same output, only %s is used\n", jobs[i].path, jobs[j].path,
+                        jobs[j].path);
+                jobs[i].superseded = true;
+                break;
+            }
+        }
+    }
+
+    // Schedule the first job of each chain
+    schedule     = malloc(numJobs * sizeof(int));
+    numScheduled = 0;
+    for (int i = 0; i < numJobs; i++)
+    {
+        if (!jobs[i].chained)
+        {
+            schedule[numScheduled++] = i;
+        }
+    }
+}
+
+/**
+ * @brief Sort job indices by decreasing file size, so the slowest jobs start first and threads finish around the same
+ * time
+ *
+ * @param a A pointer to one job index
+ * @param b A pointer to another job index
+ * @return Negative if a should be processed first, positive if b should, zero if it doesn't matter
+ */
+static int compareJobSizes(const void* a, const void* b)
+{
+    long long sizeA = jobs[*(const int*)a].size;
+    long long sizeB = jobs[*(const int*)b].size;
+    return (sizeA < sizeB) - (sizeA > sizeB);
+}
+
+/**
+ * @brief Run the processor for one asset
+ *
+ * @param job The asset to process
+ */
+static void processJob(const assetJob_t* job)
+{
+    switch (job->type)
+    {
+        case ASSET_FONT:
+        {
+            process_font(job->path, outDirName);
+            break;
+        }
+        case ASSET_IMAGE:
+        {
+            process_image(job->path, outDirName);
+            break;
+        }
+        case ASSET_CHART:
+        {
+            process_chart(job->path, outDirName);
+            break;
+        }
+        case ASSET_JSON:
+        {
+            process_json(job->path, outDirName);
+            break;
+        }
+        case ASSET_BIN:
+        {
+            process_bin(job->path, outDirName);
+            break;
+        }
+        case ASSET_TXT:
+        {
+            process_txt(job->path, outDirName);
+            break;
+        }
+        case ASSET_RMD:
+        {
+            process_rmd(job->path, outDirName);
+            break;
+        }
+        case ASSET_MIDI:
+        {
+            process_midi(job->path, outDirName);
+            break;
+        }
+        case ASSET_RAW:
+        {
+            process_raw(job->path, outDirName, job->rawExt);
+            break;
+        }
+        case ASSET_NONE:
+        case ASSET_NUM_TYPES:
+        {
+            break;
+        }
+    }
+}
+
+/**
+ * @brief Get a monotonic time in seconds
+ *
+ * @return The time, in seconds
+ */
+static double getTimeS(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+/**
+ * @brief A worker thread which processes jobs until there are none left
+ *
+ * @param arg unused
+ * @return NULL
+ */
+static void* processJobs(void* arg)
+{
+    while (true)
+    {
+        // Claim the next job
+        pthread_mutex_lock(&jobLock);
+        int scheduleIdx = nextJob++;
+        pthread_mutex_unlock(&jobLock);
+
+        if (scheduleIdx >= numScheduled)
+        {
+            return NULL;
+        }
+
+        // Process it, and any jobs chained after it
+        for (int jobIdx = schedule[scheduleIdx]; -1 != jobIdx; jobIdx = jobs[jobIdx].next)
+        {
+            const assetJob_t* job = &jobs[jobIdx];
+            if (job->superseded)
+            {
+                continue;
+            }
+
+            double start          = getTimeS();
+            assetCacheBeginJob();
+            processJob(job);
+            bool processed = assetCacheEndJob();
+            double elapsed = getTimeS() - start;
+
+            // Tally the time
+            pthread_mutex_lock(&jobLock);
+            typeStats[job->type].files++;
+            if (processed)
+            {
+                typeStats[job->type].processed++;
+            }
+            typeStats[job->type].seconds += elapsed;
+            pthread_mutex_unlock(&jobLock);
+        }
+    }
+}
+
+/**
+ * @brief Print the number of files of each type, how many were processed, and the time spent on them
+ *
+ * @param wallTime The total time spent processing, in seconds
+ */
+static void printSummary(double wallTime)
+{
+    int totalProcessed = 0;
+    for (int type = 0; type < ASSET_NUM_TYPES; type++)
+    {
+        totalProcessed += typeStats[type].processed;
+    }
+
+    // Stay quiet if nothing changed
+    if (0 == totalProcessed)
+    {
+        return;
+    }
+
+    printf("[assets-preprocessor] %-6s %6s %9s %8s\n", "Type", "Files", "Processed", "Time");
+    for (int type = 0; type < ASSET_NUM_TYPES; type++)
+    {
+        if (typeStats[type].files)
+        {
+            printf("[assets-preprocessor] %-6s %6d %9d %7.2fs\n", assetTypeNames[type], typeStats[type].files,
+                   typeStats[type].processed, typeStats[type].seconds);
+        }
+    }
+    printf("[assets-preprocessor] %d files processed in %.2fs on %d threads\n", totalProcessed, wallTime, numThreads);
+}
+
 /**
  * @brief TODO
  *
@@ -144,10 +631,18 @@ static int processFile(const char* fpath, const struct stat* st __attribute__((u
 int main(int argc, char** argv)
 {
     int c;
-    const char* inDirName = NULL;
+    const char* inDirName    = NULL;
+    const char* cacheDirName = NULL;
+    const char* reportName   = NULL;
+    uint32_t decodeWeight    = 0;
+    ditherMode_t ditherMode  = DITHER_NONE;
+    uint32_t ditherSeed      = 0;
+    const char* benchName    = NULL;
+
+    numThreads = sysconf(_SC_NPROCESSORS_ONLN);
 
     opterr = 0;
-    while ((c = getopt(argc, argv, "i:o:")) != -1)
+    while ((c = getopt(argc, argv, "i:o:mc:j:w:r:d:s:b:")) != -1)
     {
         switch (c)
         {
@@ -161,6 +656,51 @@ int main(int argc, char** argv)
                 outDirName = optarg;
                 break;
             }
+            case 'm':
+            {
+                mergeMidiFiles = true;
+                break;
+            }
+            case 'c':
+            {
+                cacheDirName = optarg;
+                break;
+            }
+            case 'j':
+            {
+                numThreads = atoi(optarg);
+                break;
+            }
+            case 'w':
+            {
+                decodeWeight = atoi(optarg);
+                break;
+            }
+            case 'r':
+            {
+                reportName = optarg;
+                break;
+            }
+            case 'd':
+            {
+                if (!parseDitherMode(optarg, &ditherMode))
+                {
+                    fprintf(stderr, "Invalid dither mode %s\n", optarg);
+                    print_usage();
+                    return -1;
+                }
+                break;
+            }
+            case 's':
+            {
+                ditherSeed = strtoul(optarg, NULL, 0);
+                break;
+            }
+            case 'b':
+            {
+                benchName = optarg;
+                break;
+            }
             default:
             {
                 fprintf(stderr, "Invalid argument %c\n", c);
@@ -170,6 +710,16 @@ int main(int argc, char** argv)
         }
     }
 
+    numThreads = CLAMP(numThreads, 1, MAX_THREADS);
+    // Images are already processed in parallel by the job threads, so each one is dithered on the thread processing it
+    // rather than spawning numThreads more per image
+    setImageDither(ditherMode, ditherSeed, 1);
+
+    if (NULL != benchName)
+    {
+        return benchmarkDither(benchName, numThreads) ? 0 : -1;
+    }
+
     if (NULL == inDirName || NULL == outDirName)
     {
         fprintf(stderr, "Failed to provide all arguments\n");
@@ -190,11 +740,49 @@ int main(int argc, char** argv)
 #endif
     }
 
-    if (ftw(inDirName, processFile, 99) == -1)
+    setHeatshrinkOptions(decodeWeight, reportName);
+
+    if (NULL != cacheDirName)
+    {
+        // Options which change the output must be part of the salt
+        char salt[32];
+        snprintf(salt, sizeof(salt), "%sw%" PRIu32 "d%ds%" PRIu32, mergeMidiFiles ? "m" : "", decodeWeight, ditherMode,
+                 ditherSeed);
+        initAssetCache(cacheDirName, salt);
+    }
+
+    // Find all the assets
+    if (ftw(inDirName, queueFile, 99) == -1)
     {
         fprintf(stderr, "Failed to walk file tree\n");
         return -1;
     }
+    qsort(jobs, numJobs, sizeof(assetJob_t), compareJobPaths);
+    chainJobs();
+    qsort(schedule, numScheduled, sizeof(int), compareJobSizes);
+
+    // Process them in parallel
+    pthread_t threads[MAX_THREADS];
+    double start = getTimeS();
+    for (int i = 0; i < numThreads; i++)
+    {
+        pthread_create(&threads[i], NULL, processJobs, NULL);
+    }
+    for (int i = 0; i < numThreads; i++)
+    {
+        pthread_join(threads[i], NULL);
+    }
+    printSummary(getTimeS() - start);
+    finishHeatshrinkReport();
+
+    deinitAssetCache();
+
+    for (int i = 0; i < numJobs; i++)
+    {
+        free(jobs[i].path);
+    }
+    free(jobs);
+    free(schedule);
 
     return 0;
 }
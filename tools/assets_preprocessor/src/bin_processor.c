@@ -3,6 +3,7 @@
 #include <stdlib.h>
 #include <string.h>
 #include "fileUtils.h"
+#include "assetCache.h"
 
 #include "bin_processor.h"
 
@@ -14,7 +15,7 @@ void process_bin(const char* infile, const char* outdir)
     strcat(outFilePath, "/");
     strcat(outFilePath, get_filename(infile));
 
-    if (!isSourceFileNewer(infile, outFilePath))
+    if (!shouldProcessFile(infile, outFilePath))
     {
         return;
     }
@@ -5,6 +5,7 @@
 
 #include "chart_processor.h"
 #include "fileUtils.h"
+#include "assetCache.h"
 
 typedef enum
 {
@@ -25,7 +26,7 @@ void process_chart(const char* infile, const char* outdir)
     char* dotptr = strrchr(outFilePath, '.');
     snprintf(&dotptr[1], strlen(dotptr), "cch");
 
-    if (!isSourceFileNewer(infile, outFilePath))
+    if (!shouldProcessFile(infile, outFilePath))
     {
         //printf("Output for %s already exists and is up-to-date\n", infile);
         return;
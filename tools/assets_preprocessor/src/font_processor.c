@@ -6,6 +6,7 @@
 #include "stb_image.h"
 #include "font_processor.h"
 #include "fileUtils.h"
+#include "assetCache.h"
 
 uint32_t getPx(unsigned char* data, int w, int x, int y);
 void appendCharToFile(FILE* fp, unsigned char* data, int w, int h, int charStartX, int charEndX);
@@ -88,7 +89,7 @@ void process_font(const char* infile, const char* outdir)
     /* Clip off the ".png", leaving ".font" */
     *(strrchr(outFilePath, '.')) = 0;
 
-    if (!isSourceFileNewer(infile, outFilePath))
+    if (!shouldProcessFile(infile, outFilePath))
     {
         return;
     }
@@ -1,161 +1,337 @@
+// For clock_gettime() with -std=c99
+#define _XOPEN_SOURCE 700
+
+#include <inttypes.h>
+#include <pthread.h>
 #include <stdio.h>
 #include <stdlib.h>
+#include <string.h>
+#include <time.h>
 
 #include "fileUtils.h"
 #include "heatshrink_encoder.h"
+#include "heatshrink_decoder.h"
 #include "heatshrink_util.h"
 
+/* The first byte of the header is the window and lookahead sizes, (window << 4) | lookahead, or this for data which is
+ * stored without compression. This must match HS_HDR_STORED in heatshrink_helper.h
+ */
+#define HS_HDR_STORED 0xFF
+
+/* The range of window and lookahead sizes to try, as powers of two */
+#define HS_MIN_WINDOW    8
+#define HS_MAX_WINDOW    11
+#define HS_MIN_LOOKAHEAD 4
+#define HS_MAX_LOOKAHEAD 6
+
+/* Files which are streamed keep a decoder per stream, so limit their window to keep that small */
+#define HS_MAX_WINDOW_STREAMED 8
+
+/* The parameters the firmware used for every file before they were chosen per file. These must match HS_DEFAULT_WINDOW
+ * and HS_DEFAULT_LOOKAHEAD in heatshrink_helper.h
+ */
+#define HS_BASELINE_WINDOW    8
+#define HS_BASELINE_LOOKAHEAD 4
+
+static uint32_t heatshrinkEncode(uint8_t* input, uint32_t len, uint8_t windowSz2, uint8_t lookaheadSz2,
+                                 uint8_t* output, uint32_t outputSize);
+static bool heatshrinkCheck(const uint8_t* input, uint32_t len, const uint8_t* compressed, uint32_t compressedLen,
+                            uint8_t windowSz2, uint8_t lookaheadSz2, double* decodeUs);
+
+/* How much one decompressed byte of decoding costs, in hundredths of a byte of flash */
+static uint32_t decodeWeight = 0;
+
+/* The report file, or NULL if no report is written */
+static FILE* reportFile = NULL;
+/* Totals for the summary */
+static uint64_t totalRaw      = 0;
+static uint64_t totalBaseline = 0;
+static uint64_t totalChosen   = 0;
+static double totalDecodeUs   = 0;
+static uint32_t totalFiles    = 0;
+/* Protects the report file and totals */
+static pthread_mutex_t reportLock = PTHREAD_MUTEX_INITIALIZER;
+
 /**
- * @brief Utility to compress the given bytes and write them to a file
+ * @brief Set how compression parameters are chosen, and start writing a report
  *
- * @param input The bytes to compress and write to a file
- * @param len The length of the bytes to compress and write
- * @param outFilePath The filename to write to
+ * @param weight How much decoding one byte costs, in hundredths of a byte of flash. 0 picks the smallest output,
+ * larger values favor storing data without compression when it saves little
+ * @param reportFileName A file to write a CSV report of each file's compression to, or NULL to not write one
  */
-void writeHeatshrinkFile(uint8_t* input, uint32_t len, const char* outFilePath)
+void setHeatshrinkOptions(uint32_t weight, const char* reportFileName)
 {
-    int32_t errLine = -1;
-    /* Set up variables for compression */
-    uint32_t outputSize = len;
-    uint8_t* output     = calloc(1, outputSize);
-    uint32_t outputIdx  = 0;
-    uint32_t inputIdx   = 0;
-    size_t copied       = 0;
-    FILE* shrunkFile    = NULL;
-
-    /* Creete the encoder */
-    heatshrink_encoder* hse = heatshrink_encoder_alloc(8, 4);
-    heatshrink_encoder_reset(hse);
-
-    /* Stream the data in chunks */
-    while (inputIdx < len)
+    decodeWeight = weight;
+    if (NULL != reportFileName)
     {
-        /* Pass bytes to the encoder for compression */
-        copied = 0;
-        switch (heatshrink_encoder_sink(hse, &input[inputIdx], len - inputIdx, &copied))
+        reportFile = fopen(reportFileName, "w");
+        if (NULL == reportFile)
+        {
+            perror("Error occurred while opening the report file.\n");
+        }
+        else
+        {
+            fprintf(reportFile, "file,raw_bytes,baseline_bytes,window,lookahead,bytes,host_decode_us\n");
+        }
+    }
+}
+
+/**
+ * @brief Print a summary of the flash saved compared to the baseline parameters, and finish the report
+ */
+void finishHeatshrinkReport(void)
+{
+    if (totalFiles)
+    {
+        printf("[assets-preprocessor] Compressed %" PRIu32 " files from %" PRIu64 " to %" PRIu64 " bytes (%" PRIu64
+               " bytes with heatshrink %d/%d), host decode time %.0fus\n",
+               totalFiles, totalRaw, totalChosen, totalBaseline, HS_BASELINE_WINDOW, HS_BASELINE_LOOKAHEAD,
+               totalDecodeUs);
+    }
+
+    if (NULL != reportFile)
+    {
+        fclose(reportFile);
+        reportFile = NULL;
+    }
+}
+
+/**
+ * @brief Compress bytes with heatshrink
+ *
+ * @param input The bytes to compress
+ * @param len The number of bytes to compress
+ * @param windowSz2 The window size, as a power of two
+ * @param lookaheadSz2 The lookahead size, as a power of two
+ * @param output The buffer to write compressed bytes to
+ * @param outputSize The size of the output buffer
+ * @return The number of compressed bytes, or 0 if they didn't fit in output or there was an error
+ */
+static uint32_t heatshrinkEncode(uint8_t* input, uint32_t len, uint8_t windowSz2, uint8_t lookaheadSz2,
+                                 uint8_t* output, uint32_t outputSize)
+{
+    uint32_t outputIdx = 0;
+    uint32_t inputIdx  = 0;
+    size_t copied      = 0;
+    bool finishing     = false;
+
+    heatshrink_encoder* hse = heatshrink_encoder_alloc(windowSz2, lookaheadSz2);
+    if (NULL == hse)
+    {
+        return 0;
+    }
+
+    while (true)
+    {
+        /* Pass bytes to the encoder for compression, then mark all input as processed */
+        if (inputIdx < len)
         {
-            case HSER_SINK_OK:
+            copied = 0;
+            if (HSER_SINK_OK != heatshrink_encoder_sink(hse, &input[inputIdx], len - inputIdx, &copied))
             {
-                // Continue
+                outputIdx = 0;
                 break;
             }
-            case HSER_SINK_ERROR_NULL:
-            case HSER_SINK_ERROR_MISUSE:
-            {
-                // Error handling
-                errLine = __LINE__;
-                goto heatshrink_error;
-            }
+            inputIdx += copied;
+        }
+        else if (!finishing)
+        {
+            finishing = true;
+        }
+
+        if (finishing && HSER_FINISH_DONE == heatshrink_encoder_finish(hse))
+        {
+            break;
         }
-        inputIdx += copied;
 
         /* Save compressed data */
-        copied             = 0;
-        bool stillEncoding = true;
-        while (stillEncoding)
+        HSE_poll_res pollRes;
+        do
         {
-            switch (heatshrink_encoder_poll(hse, &output[outputIdx], outputSize - outputIdx, &copied))
-            {
-                case HSER_POLL_EMPTY:
-                {
-                    stillEncoding = false;
-                    break;
-                }
-                case HSER_POLL_MORE:
-                {
-                    stillEncoding = true;
-                    break;
-                }
-                case HSER_POLL_ERROR_NULL:
-                case HSER_POLL_ERROR_MISUSE:
-                {
-                    // Error handling
-                    errLine = __LINE__;
-                    goto heatshrink_error;
-                }
-            }
+            copied  = 0;
+            pollRes = heatshrink_encoder_poll(hse, &output[outputIdx], outputSize - outputIdx, &copied);
             outputIdx += copied;
+        } while (HSER_POLL_MORE == pollRes && outputIdx < outputSize);
+
+        if (HSER_POLL_MORE == pollRes || pollRes < 0)
+        {
+            /* Didn't fit, or there was an error */
+            outputIdx = 0;
+            break;
         }
     }
 
-    /* Mark all input as processed */
-    switch (heatshrink_encoder_finish(hse))
+    heatshrink_encoder_free(hse);
+    return outputIdx;
+}
+
+/**
+ * @brief Get a monotonic time in microseconds
+ *
+ * @return The time, in microseconds
+ */
+static double getTimeUs(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec * 1e6 + ts.tv_nsec / 1e3;
+}
+
+/**
+ * @brief Decompress heatshrink compressed bytes, check they match the original, and time it
+ *
+ * @param input The original bytes
+ * @param len The number of original bytes
+ * @param compressed The compressed bytes
+ * @param compressedLen The number of compressed bytes
+ * @param windowSz2 The window size, as a power of two
+ * @param lookaheadSz2 The lookahead size, as a power of two
+ * @param[out] decodeUs The time taken to decompress, in microseconds
+ * @return true if the decompressed bytes match the original, false if they don't
+ */
+static bool heatshrinkCheck(const uint8_t* input, uint32_t len, const uint8_t* compressed, uint32_t compressedLen,
+                            uint8_t windowSz2, uint8_t lookaheadSz2, double* decodeUs)
+{
+    uint8_t* decoded = malloc(len + 1);
+    uint32_t inIdx   = 0;
+    uint32_t outIdx  = 0;
+    size_t copied    = 0;
+
+    double start            = getTimeUs();
+    heatshrink_decoder* hsd = heatshrink_decoder_alloc(256, windowSz2, lookaheadSz2);
+    while (inIdx < compressedLen)
     {
-        case HSER_FINISH_DONE:
+        copied = 0;
+        heatshrink_decoder_sink(hsd, &compressed[inIdx], compressedLen - inIdx, &copied);
+        inIdx += copied;
+
+        HSD_poll_res pollRes;
+        do
         {
-            // Continue
-            break;
-        }
-        case HSER_FINISH_MORE:
+            copied  = 0;
+            pollRes = heatshrink_decoder_poll(hsd, &decoded[outIdx], len + 1 - outIdx, &copied);
+            outIdx += copied;
+        } while (HSDR_POLL_MORE == pollRes && outIdx <= len);
+    }
+    while (HSDR_FINISH_MORE == heatshrink_decoder_finish(hsd) && outIdx <= len)
+    {
+        copied = 0;
+        heatshrink_decoder_poll(hsd, &decoded[outIdx], len + 1 - outIdx, &copied);
+        outIdx += copied;
+    }
+    heatshrink_decoder_free(hsd);
+    *decodeUs = getTimeUs() - start;
+
+    bool match = (outIdx == len) && (0 == memcmp(input, decoded, len));
+    free(decoded);
+    return match;
+}
+
+/**
+ * @brief Utility to compress the given bytes and write them to a file
+ *
+ * Every combination of window and lookahead size in range is tried, along with storing the bytes uncompressed. The one
+ * with the lowest cost is written, where the cost is the size of the output, plus the decompressed size scaled by the
+ * decode weight for compressed data. The parameters are written in the first byte of the header, and the decompressed
+ * size in the next three bytes, big endian.
+ *
+ * @param input The bytes to compress and write to a file
+ * @param len The length of the bytes to compress and write
+ * @param outFilePath The filename to write to
+ * @param streamed true if the file is decompressed in a stream, which limits the window size
+ */
+void writeHeatshrinkFile(uint8_t* input, uint32_t len, const char* outFilePath, bool streamed)
+{
+    if (len >= (1 << 24))
+    {
+        fprintf(stderr, "ERR: heatshrink_util.c: %s is too large to compress\n", outFilePath);
+        return;
+    }
+
+    /* Storing the bytes is the fallback */
+    uint8_t* best      = input;
+    uint32_t bestLen   = len;
+    uint64_t bestCost  = (uint64_t)len * 100;
+    uint8_t bestHdr    = HS_HDR_STORED;
+    uint32_t baseline  = len;
+    uint8_t* candidate = calloc(1, len + 1);
+    uint8_t* chosen    = calloc(1, len + 1);
+
+    /* Try every combination of parameters */
+    int maxWindow = streamed ? HS_MAX_WINDOW_STREAMED : HS_MAX_WINDOW;
+    for (int window = HS_MIN_WINDOW; window <= maxWindow; window++)
+    {
+        for (int lookahead = HS_MIN_LOOKAHEAD; lookahead <= HS_MAX_LOOKAHEAD && lookahead < window; lookahead++)
         {
-            /* Flush the last bits of output */
-            copied             = 0;
-            bool stillEncoding = true;
-            while (stillEncoding)
+            uint32_t size = heatshrinkEncode(input, len, window, lookahead, candidate, len);
+            if (0 == size)
             {
-                switch (heatshrink_encoder_poll(hse, &output[outputIdx], outputSize - outputIdx, &copied))
-                {
-                    case HSER_POLL_EMPTY:
-                    {
-                        stillEncoding = false;
-                        break;
-                    }
-                    case HSER_POLL_MORE:
-                    {
-                        stillEncoding = true;
-                        break;
-                    }
-                    case HSER_POLL_ERROR_NULL:
-                    case HSER_POLL_ERROR_MISUSE:
-                    {
-                        // Error handling
-                        errLine = __LINE__;
-                        goto heatshrink_error;
-                    }
-                }
-                outputIdx += copied;
+                continue;
+            }
+
+            if (HS_BASELINE_WINDOW == window && HS_BASELINE_LOOKAHEAD == lookahead)
+            {
+                baseline = size;
+            }
+
+            uint64_t cost = (uint64_t)size * 100 + (uint64_t)len * decodeWeight;
+            if (cost < bestCost)
+            {
+                memcpy(chosen, candidate, size);
+                best     = chosen;
+                bestLen  = size;
+                bestCost = cost;
+                bestHdr  = (window << 4) | lookahead;
             }
-            break;
-        }
-        case HSER_FINISH_ERROR_NULL:
-        {
-            // Error handling
-            errLine = __LINE__;
-            goto heatshrink_error;
         }
     }
 
+    /* Make sure the chosen data decodes, and time it */
+    double decodeUs = 0;
+    if (HS_HDR_STORED != bestHdr
+        && !heatshrinkCheck(input, len, best, bestLen, bestHdr >> 4, bestHdr & 0x0F, &decodeUs))
+    {
+        fprintf(stderr, "ERR: heatshrink_util.c: %s didn't decompress correctly, storing it\n", outFilePath);
+        best     = input;
+        bestLen  = len;
+        bestHdr  = HS_HDR_STORED;
+        decodeUs = 0;
+    }
+
     /* Write a compressed file */
-    shrunkFile = fopen(outFilePath, "wb");
+    FILE* shrunkFile = fopen(outFilePath, "wb");
     if (shrunkFile == NULL)
     {
         perror("Error occurred while writing file.\n");
     }
-    /* First four bytes are decompresed size */
-    putc(HI_BYTE(HI_WORD(len)), shrunkFile);
-    putc(LO_BYTE(HI_WORD(len)), shrunkFile);
-    putc(HI_BYTE(LO_WORD(len)), shrunkFile);
-    putc(LO_BYTE(LO_WORD(len)), shrunkFile);
-    /* Then dump the compressed bytes */
-    fwrite(output, outputIdx, 1, shrunkFile);
-    /* Done writing to the file */
-    fclose(shrunkFile);
-
-    /* Print results */
-    // printf("  Source length: %d\n  Shrunk length: %d\n", inputIdx, 4 + outputIdx);
-
-    /* Error handling and cleanup */
-heatshrink_error:
-    if (NULL != output)
-    {
-        free(output);
-    }
-    if (NULL != hse)
+    else
     {
-        heatshrink_encoder_free(hse);
+        /* First byte is the parameters, next three are the decompressed size */
+        putc(bestHdr, shrunkFile);
+        putc(LO_BYTE(HI_WORD(len)), shrunkFile);
+        putc(HI_BYTE(LO_WORD(len)), shrunkFile);
+        putc(LO_BYTE(LO_WORD(len)), shrunkFile);
+        /* Then dump the compressed bytes */
+        fwrite(best, bestLen, 1, shrunkFile);
+        /* Done writing to the file */
+        fclose(shrunkFile);
     }
-    if (-1 != errLine)
+
+    /* Record the choice */
+    pthread_mutex_lock(&reportLock);
+    totalFiles++;
+    totalRaw += len;
+    totalBaseline += baseline;
+    totalChosen += bestLen;
+    totalDecodeUs += decodeUs;
+    if (NULL != reportFile)
     {
-        fprintf(stderr, "[%d]: Heatshrink error\n", errLine);
+        fprintf(reportFile, "%s,%" PRIu32 ",%" PRIu32 ",%d,%d,%" PRIu32 ",%.1f\n", get_filename(outFilePath), len,
+                baseline, (HS_HDR_STORED == bestHdr) ? 0 : (bestHdr >> 4),
+                (HS_HDR_STORED == bestHdr) ? 0 : (bestHdr & 0x0F), bestLen, decodeUs);
     }
+    pthread_mutex_unlock(&reportLock);
+
+    free(candidate);
+    free(chosen);
 }
@@ -4,6 +4,8 @@
 #include <stdbool.h>
 #include <stdint.h>
 
-void writeHeatshrinkFile(uint8_t* input, uint32_t len, const char* outFilePath);
+void setHeatshrinkOptions(uint32_t weight, const char* reportFileName);
+void finishHeatshrinkReport(void);
+void writeHeatshrinkFile(uint8_t* input, uint32_t len, const char* outFilePath, bool streamed);
 
-#endif
\ No newline at end of file
+#endif
@@ -1,8 +1,13 @@
+// For clock_gettime() with -std=c99
+#define _XOPEN_SOURCE 700
+
 #include <limits.h>
+#include <pthread.h>
 #include <stdbool.h>
 #include <stdint.h>
 #include <stdio.h>
 #include <stdlib.h>
+#include <string.h>
 #include <time.h>
 #include <unistd.h>
 
@@ -30,9 +35,21 @@
 #include "heatshrink_util.h"
 
 #include "fileUtils.h"
+#include "assetCache.h"
 
 #define CLAMP(x, l, u) ((x) < l ? l : ((x) > u ? u : (x)))
 
+/* This must match WSG_RLE_FLAG in wsg.h */
+#define WSG_RLE_FLAG 0x8000
+
+/* This invalid palette index means 'transparent' */
+#define PAL_TRANSPARENT (6 * 6 * 6)
+
+/* The width and height of the tiles which are diffusion dithered together. Error only spreads to adjacent pixels, so
+ * tiles which don't touch are dithered in parallel
+ */
+#define DITHER_TILE 32
+
 typedef struct
 {
     uint8_t r;
@@ -45,22 +62,119 @@ typedef struct
     bool isDrawn;
 } pixel_t;
 
-void shuffleArray(uint32_t* ar, uint32_t len);
-int isNeighborNotDrawn(pixel_t** img, int x, int y, int w, int h);
-void spreadError(pixel_t** img, int x, int y, int w, int h, int teR, int teG, int teB, float diagScalar);
+typedef struct
+{
+    const unsigned char* data; ///< The source RGBA pixels
+    pixel_t* img;              ///< The dithered pixels, w * h of them
+    int w;                     ///< The width of the image
+    int h;                     ///< The height of the image
+    int phaseX;                ///< The parity of the tile columns being dithered
+    int phaseY;                ///< The parity of the tile rows being dithered
+    int tilesW;                ///< The number of tile columns in this phase
+    int numTiles;              ///< The number of tiles in this phase
+    int nextTile;              ///< The next tile in this phase to claim
+    pthread_mutex_t lock;      ///< Protects nextTile
+} ditherJob_t;
+
+void shuffleArray(uint32_t* ar, uint32_t len, uint32_t* rngState);
+int isNeighborNotDrawn(const pixel_t* img, int x, int y, int w, int h);
+void spreadError(pixel_t* img, int x, int y, int w, int h, int teR, int teG, int teB, float diagScalar);
+uint32_t rleEncodeImage(const unsigned char* paletteBuf, int w, int h, uint8_t* rle);
+void ditherImage(const unsigned char* data, int w, int h, unsigned char* paletteBuf, int threads);
+
+static uint32_t xorshift32(uint32_t* state);
+static void ditherTile(const ditherJob_t* job, int tx, int ty);
+static void* ditherTiles(void* arg);
+static void ditherDiffuse(const unsigned char* data, int w, int h, unsigned char* paletteBuf, int threads);
+static void ditherOrdered(const unsigned char* data, int w, int h, unsigned char* paletteBuf);
+static double getTimeS(void);
+
+/* How images are dithered */
+static ditherMode_t ditherMode = DITHER_NONE;
+/* The seed for diffusion dithering */
+static uint32_t ditherSeed = 0;
+/* The number of threads to diffusion dither each image with */
+static int ditherThreads = 1;
+
+/* The threshold map for ordered dithering */
+static const uint8_t bayer4[4][4] = {
+    {0, 8, 2, 10},
+    {12, 4, 14, 6},
+    {3, 11, 1, 9},
+    {15, 7, 13, 5},
+};
+
+/* The names of the dither modes, for options */
+static const char* const ditherModeNames[] = {
+    [DITHER_NONE]    = "none",
+    [DITHER_DIFFUSE] = "diffuse",
+    [DITHER_ORDERED] = "ordered",
+};
 
 /**
- * @brief TODO
+ * @brief Set how images are dithered. Diffusion dithering produces the same output for the same seed, regardless of
+ * the number of threads
  *
- * @param ar
- * @param len
+ * @param mode The dither mode
+ * @param seed The seed for the order pixels are diffusion dithered in
+ * @param threads The number of threads to diffusion dither each image with
  */
-void shuffleArray(uint32_t* ar, uint32_t len)
+void setImageDither(ditherMode_t mode, uint32_t seed, int threads)
+{
+    ditherMode    = mode;
+    ditherSeed    = seed;
+    ditherThreads = (threads < 1) ? 1 : threads;
+}
+
+/**
+ * @brief Parse the name of a dither mode
+ *
+ * @param name The name of the mode, "none", "diffuse", or "ordered"
+ * @param[out] mode The parsed mode is written here
+ * @return true if the name was parsed, false if it isn't a mode
+ */
+bool parseDitherMode(const char* name, ditherMode_t* mode)
+{
+    for (int i = 0; i < DITHER_NUM_MODES; i++)
+    {
+        if (0 == strcmp(name, ditherModeNames[i]))
+        {
+            *mode = i;
+            return true;
+        }
+    }
+    return false;
+}
+
+/**
+ * @brief Get the next value from a xorshift random number generator. This is deterministic and thread safe, unlike
+ * rand()
+ *
+ * @param state The state of the generator, which must not be zero
+ * @return The next random value
+ */
+static uint32_t xorshift32(uint32_t* state)
+{
+    uint32_t x = *state;
+    x ^= x << 13;
+    x ^= x >> 17;
+    x ^= x << 5;
+    *state = x;
+    return x;
+}
+
+/**
+ * @brief Shuffle an array with a Fisher-Yates shuffle
+ *
+ * @param ar The array to shuffle
+ * @param len The length of the array
+ * @param rngState The state of the random number generator to shuffle with
+ */
+void shuffleArray(uint32_t* ar, uint32_t len, uint32_t* rngState)
 {
-    srand(time(NULL));
     for (int i = len - 1; i > 0; i--)
     {
-        int index = rand() % (i + 1);
+        int index = xorshift32(rngState) % (i + 1);
         int a     = ar[index];
         ar[index] = ar[i];
         ar[i]     = a;
@@ -68,56 +182,357 @@ void shuffleArray(uint32_t* ar, uint32_t len)
 }
 
 /**
- * @brief TODO
+ * @brief Check if a pixel exists and hasn't been quantized yet
  *
- * @param img
- * @param x
- * @param y
- * @param w
- * @param h
- * @return int
+ * @param img The image, w * h pixels
+ * @param x The X coordinate of the pixel
+ * @param y The Y coordinate of the pixel
+ * @param w The width of the image
+ * @param h The height of the image
+ * @return 1 if the pixel hasn't been quantized, 0 if it has or is out of bounds
  */
-int isNeighborNotDrawn(pixel_t** img, int x, int y, int w, int h)
+int isNeighborNotDrawn(const pixel_t* img, int x, int y, int w, int h)
 {
     if (0 <= x && x < w)
     {
         if (0 <= y && y < h)
         {
-            return !(img[y][x].isDrawn) ? 1 : 0;
+            return !(img[y * w + x].isDrawn) ? 1 : 0;
         }
     }
     return 0;
 }
 
 /**
- * @brief TODO
+ * @brief Spread part of a pixel's quantization error to a neighbor, if it exists and hasn't been quantized yet
  *
- * @param image8b
- * @param x
- * @param y
- * @param w
- * @param h
- * @param teR
- * @param teG
- * @param teB
- * @param diagScalar
+ * @param img The image, w * h pixels
+ * @param x The X coordinate of the neighbor
+ * @param y The Y coordinate of the neighbor
+ * @param w The width of the image
+ * @param h The height of the image
+ * @param teR The total red error
+ * @param teG The total green error
+ * @param teB The total blue error
+ * @param diagScalar The fraction of the total error to give to this neighbor
  */
-void spreadError(pixel_t** img, int x, int y, int w, int h, int teR, int teG, int teB, float diagScalar)
+void spreadError(pixel_t* img, int x, int y, int w, int h, int teR, int teG, int teB, float diagScalar)
 {
     if (0 <= x && x < w)
     {
         if (0 <= y && y < h)
         {
-            if (!img[y][x].isDrawn)
+            pixel_t* px = &img[y * w + x];
+            if (!px->isDrawn)
+            {
+                px->eR = (int)(teR * diagScalar + 0.5);
+                px->eG = (int)(teG * diagScalar + 0.5);
+                px->eB = (int)(teB * diagScalar + 0.5);
+            }
+        }
+    }
+}
+
+/**
+ * @brief Diffusion dither one tile, quantizing its pixels in a random order and spreading the error of each to its
+ * neighbors which haven't been quantized yet
+ *
+ * @param job The image being dithered
+ * @param tx The tile's column
+ * @param ty The tile's row
+ */
+static void ditherTile(const ditherJob_t* job, int tx, int ty)
+{
+    pixel_t* img = job->img;
+    int w        = job->w;
+    int h        = job->h;
+    int x0       = tx * DITHER_TILE;
+    int y0       = ty * DITHER_TILE;
+    int tileW    = CLAMP(w - x0, 0, DITHER_TILE);
+    int tileH    = CLAMP(h - y0, 0, DITHER_TILE);
+
+    /* Create an array of pixel indicies, then shuffle it. Each tile gets its own sequence, so the order tiles are
+     * dithered in doesn't matter
+     */
+    uint32_t indices[DITHER_TILE * DITHER_TILE];
+    for (int i = 0; i < tileW * tileH; i++)
+    {
+        indices[i] = i;
+    }
+    uint32_t rngState = (ditherSeed * 2654435761u) ^ ((uint32_t)tx * 40503u) ^ ((uint32_t)ty * 2246822519u);
+    if (0 == rngState)
+    {
+        rngState = 1;
+    }
+    shuffleArray(indices, tileW * tileH, &rngState);
+
+    /* For all pixels in the tile */
+    for (int i = 0; i < tileW * tileH; i++)
+    {
+        /* Get the x, y coordinates for the random pixel */
+        int x      = x0 + indices[i] % tileW;
+        int y      = y0 + indices[i] / tileW;
+        pixel_t* p = &img[y * w + x];
+
+        /* Get the source pixel, 8 bits per channel */
+        const unsigned char* src = &job->data[(y * w + x) * 4];
+        unsigned char sourceR    = src[0];
+        unsigned char sourceG    = src[1];
+        unsigned char sourceB    = src[2];
+        unsigned char sourceA    = src[3];
+
+        /* Find the bit-reduced value, use rounding, 5551 for RGBA */
+        p->r = CLAMP((127 + ((sourceR + p->eR) * 5)) / 255, 0, 5);
+        p->g = CLAMP((127 + ((sourceG + p->eG) * 5)) / 255, 0, 5);
+        p->b = CLAMP((127 + ((sourceB + p->eB) * 5)) / 255, 0, 5);
+        p->a = (sourceA >= 128) ? 0xFF : 0x00;
+
+        /* Find the total error, 8 bits per channel */
+        int teR = sourceR - ((p->r * 255) / 5);
+        int teG = sourceG - ((p->g * 255) / 5);
+        int teB = sourceB - ((p->b * 255) / 5);
+
+        /* Count all the neighbors that haven't been drawn yet */
+        int adjNeighbors = 0;
+        adjNeighbors += isNeighborNotDrawn(img, x + 0, y + 1, w, h);
+        adjNeighbors += isNeighborNotDrawn(img, x + 0, y - 1, w, h);
+        adjNeighbors += isNeighborNotDrawn(img, x + 1, y + 0, w, h);
+        adjNeighbors += isNeighborNotDrawn(img, x - 1, y + 0, w, h);
+        int diagNeighbors = 0;
+        diagNeighbors += isNeighborNotDrawn(img, x - 1, y - 1, w, h);
+        diagNeighbors += isNeighborNotDrawn(img, x + 1, y - 1, w, h);
+        diagNeighbors += isNeighborNotDrawn(img, x - 1, y + 1, w, h);
+        diagNeighbors += isNeighborNotDrawn(img, x + 1, y + 1, w, h);
+
+        /* Spread the error to all neighboring unquantized pixels, with
+         * twice as much error to the adjacent pixels as the diagonal ones
+         */
+        if (adjNeighbors + diagNeighbors)
+        {
+            float diagScalar = 1 / (float)((2 * adjNeighbors) + diagNeighbors);
+            float adjScalar  = 2 * diagScalar;
+
+            /* Write the error */
+            spreadError(img, x - 1, y - 1, w, h, teR, teG, teB, diagScalar);
+            spreadError(img, x - 1, y + 1, w, h, teR, teG, teB, diagScalar);
+            spreadError(img, x + 1, y - 1, w, h, teR, teG, teB, diagScalar);
+            spreadError(img, x + 1, y + 1, w, h, teR, teG, teB, diagScalar);
+            spreadError(img, x - 1, y + 0, w, h, teR, teG, teB, adjScalar);
+            spreadError(img, x + 1, y + 0, w, h, teR, teG, teB, adjScalar);
+            spreadError(img, x + 0, y - 1, w, h, teR, teG, teB, adjScalar);
+            spreadError(img, x + 0, y + 1, w, h, teR, teG, teB, adjScalar);
+        }
+
+        /* Mark the random pixel as drawn */
+        p->isDrawn = true;
+    }
+}
+
+/**
+ * @brief A worker thread which diffusion dithers tiles in the current phase until there are none left
+ *
+ * @param arg The ditherJob_t for the image
+ * @return NULL
+ */
+static void* ditherTiles(void* arg)
+{
+    ditherJob_t* job = (ditherJob_t*)arg;
+    while (true)
+    {
+        // Claim the next tile
+        pthread_mutex_lock(&job->lock);
+        int tileIdx = job->nextTile++;
+        pthread_mutex_unlock(&job->lock);
+
+        if (tileIdx >= job->numTiles)
+        {
+            return NULL;
+        }
+
+        ditherTile(job, job->phaseX + 2 * (tileIdx % job->tilesW), job->phaseY + 2 * (tileIdx / job->tilesW));
+    }
+}
+
+/**
+ * @brief Diffusion dither an image, tile by tile.
+ *
+ * Tiles are dithered in four phases, by the parity of their column and row. Tiles in the same phase don't touch, so
+ * they can't spread error into each other and are dithered in parallel. Error spreads into tiles of later phases.
+ *
+ * @param data The source RGBA pixels
+ * @param w The width of the image
+ * @param h The height of the image
+ * @param paletteBuf The palette indices are written here, w * h of them
+ * @param threads The number of threads to use
+ */
+static void ditherDiffuse(const unsigned char* data, int w, int h, unsigned char* paletteBuf, int threads)
+{
+    ditherJob_t job = {
+        .data = data,
+        .img  = calloc(w * h, sizeof(pixel_t)),
+        .w    = w,
+        .h    = h,
+    };
+    pthread_mutex_init(&job.lock, NULL);
+
+    int tilesW = (w + DITHER_TILE - 1) / DITHER_TILE;
+    int tilesH = (h + DITHER_TILE - 1) / DITHER_TILE;
+    for (int phase = 0; phase < 4; phase++)
+    {
+        job.phaseX   = phase & 1;
+        job.phaseY   = phase >> 1;
+        job.tilesW   = (tilesW - job.phaseX + 1) / 2;
+        job.numTiles = job.tilesW * ((tilesH - job.phaseY + 1) / 2);
+        job.nextTile = 0;
+
+        /* Dither on this thread too */
+        int numThreads = CLAMP(job.numTiles, 1, threads);
+        pthread_t workers[numThreads];
+        for (int i = 1; i < numThreads; i++)
+        {
+            pthread_create(&workers[i], NULL, ditherTiles, &job);
+        }
+        ditherTiles(&job);
+        for (int i = 1; i < numThreads; i++)
+        {
+            pthread_join(workers[i], NULL);
+        }
+    }
+    pthread_mutex_destroy(&job.lock);
+
+    for (int i = 0; i < w * h; i++)
+    {
+        const pixel_t* p = &job.img[i];
+        paletteBuf[i]    = p->a ? (p->b + (6 * p->g) + (36 * p->r)) : PAL_TRANSPARENT;
+    }
+    free(job.img);
+}
+
+/**
+ * @brief Ordered dither an image with a 4x4 Bayer matrix. Each pixel only depends on its own value and position.
+ *
+ * @param data The source RGBA pixels
+ * @param w The width of the image
+ * @param h The height of the image
+ * @param paletteBuf The palette indices are written here, w * h of them
+ */
+static void ditherOrdered(const unsigned char* data, int w, int h, unsigned char* paletteBuf)
+{
+    for (int y = 0; y < h; y++)
+    {
+        const unsigned char* src = &data[y * w * 4];
+        unsigned char* dst       = &paletteBuf[y * w];
+
+        /* The threshold, from about -half to +half of a quantization step of 51 */
+        int bias[4];
+        for (int i = 0; i < 4; i++)
+        {
+            bias[i] = ((2 * bayer4[y & 3][i] + 1) * 51) / 32 - 25;
+        }
+
+        for (int x = 0; x < w; x++)
+        {
+            int r  = CLAMP((127 + ((src[4 * x + 0] + bias[x & 3]) * 5)) / 255, 0, 5);
+            int g  = CLAMP((127 + ((src[4 * x + 1] + bias[x & 3]) * 5)) / 255, 0, 5);
+            int b  = CLAMP((127 + ((src[4 * x + 2] + bias[x & 3]) * 5)) / 255, 0, 5);
+            dst[x] = (src[4 * x + 3] >= 128) ? (b + (6 * g) + (36 * r)) : PAL_TRANSPARENT;
+        }
+    }
+}
+
+/**
+ * @brief Reduce an image to the web-safe palette with the current dither mode
+ *
+ * @param data The source RGBA pixels
+ * @param w The width of the image
+ * @param h The height of the image
+ * @param paletteBuf The palette indices are written here, w * h of them
+ * @param threads The number of threads to diffusion dither with
+ */
+void ditherImage(const unsigned char* data, int w, int h, unsigned char* paletteBuf, int threads)
+{
+    switch (ditherMode)
+    {
+        case DITHER_DIFFUSE:
+        {
+            ditherDiffuse(data, w, h, paletteBuf, threads);
+            break;
+        }
+        case DITHER_ORDERED:
+        {
+            ditherOrdered(data, w, h, paletteBuf);
+            break;
+        }
+        case DITHER_NONE:
+        case DITHER_NUM_MODES:
+        {
+            /* Round each channel to the nearest of six levels. Index math! The palette indices increase blue, then
+             * green, then red
+             */
+            for (int i = 0; i < w * h; i++)
             {
-                img[y][x].eR = (int)(teR * diagScalar + 0.5);
-                img[y][x].eG = (int)(teG * diagScalar + 0.5);
-                img[y][x].eB = (int)(teB * diagScalar + 0.5);
+                const unsigned char* src = &data[i * 4];
+                int r                    = (127 + (src[0] * 5)) / 255;
+                int g                    = (127 + (src[1] * 5)) / 255;
+                int b                    = (127 + (src[2] * 5)) / 255;
+                paletteBuf[i]            = (src[3] >= 128) ? (b + (6 * g) + (36 * r)) : PAL_TRANSPARENT;
             }
+            break;
         }
     }
 }
 
+/**
+ * @brief Run-length encode palette indices as transparent and opaque runs.
+ *
+ * Each row is a sequence of (skip, run) byte pairs. skip transparent pixels are followed by run opaque pixels, which
+ * are written after the pair. Pairs repeat until the row is full. Skips and runs longer than 255 pixels are split, a
+ * long skip with a run of 0 and a long run with a following skip of 0.
+ *
+ * @param paletteBuf The palette indices to encode, w * h of them
+ * @param w The width of the image
+ * @param h The height of the image
+ * @param rle The buffer to write to. It must be at least 3 * w * h bytes long, the worst case
+ * @return The number of bytes written to rle
+ */
+uint32_t rleEncodeImage(const unsigned char* paletteBuf, int w, int h, uint8_t* rle)
+{
+    uint32_t rleIdx = 0;
+    for (int y = 0; y < h; y++)
+    {
+        const unsigned char* row = &paletteBuf[y * w];
+        int x                    = 0;
+        while (x < w)
+        {
+            /* Measure the transparent run */
+            int skip = 0;
+            while (x + skip < w && PAL_TRANSPARENT == row[x + skip] && skip < 255)
+            {
+                skip++;
+            }
+            x += skip;
+
+            /* Measure the opaque run, unless this skip was cut short */
+            int run = 0;
+            if (skip < 255 || x == w || PAL_TRANSPARENT != row[x])
+            {
+                while (x + run < w && PAL_TRANSPARENT != row[x + run] && run < 255)
+                {
+                    run++;
+                }
+            }
+
+            /* Write the pair, then the opaque pixels */
+            rle[rleIdx++] = skip;
+            rle[rleIdx++] = run;
+            memcpy(&rle[rleIdx], &row[x], run);
+            rleIdx += run;
+            x += run;
+        }
+    }
+    return rleIdx;
+}
+
 /**
  * @brief TODO
  *
@@ -136,7 +551,7 @@ void process_image(const char* infile, const char* outdir)
     char* dotptr = strrchr(outFilePath, '.');
     snprintf(&dotptr[1], strlen(dotptr), "wsg");
 
-    if (!isSourceFileNewer(infile, outFilePath))
+    if (!shouldProcessFile(infile, outFilePath))
     {
         return;
     }
@@ -151,82 +566,10 @@ void process_image(const char* infile, const char* outdir)
 
     if (NULL != data)
     {
-        /* Create an array for output */
-        pixel_t** image8b;
-        image8b = (pixel_t**)calloc(h, sizeof(pixel_t*));
-        for (int y = 0; y < h; y++)
-        {
-            image8b[y] = (pixel_t*)calloc(w, sizeof(pixel_t));
-        }
-
-        /* Create an array of pixel indicies, then shuffle it */
-        uint32_t* indices = (uint32_t*)calloc(w * h, sizeof(uint32_t)); //[w * h];
-        for (int i = 0; i < w * h; i++)
-        {
-            indices[i] = i;
-        }
-        shuffleArray(indices, w * h);
-
-        /* For all pixels */
-        for (int i = 0; i < w * h; i++)
-        {
-            /* Get the x, y coordinates for the random pixel */
-            int x = indices[i] % w;
-            int y = indices[i] / w;
-
-            /* Get the source pixel, 8 bits per channel */
-            unsigned char sourceR = data[(y * (w * 4)) + (x * 4) + 0];
-            unsigned char sourceG = data[(y * (w * 4)) + (x * 4) + 1];
-            unsigned char sourceB = data[(y * (w * 4)) + (x * 4) + 2];
-            unsigned char sourceA = data[(y * (w * 4)) + (x * 4) + 3];
-
-            /* Find the bit-reduced value, use rounding, 5551 for RGBA */
-            image8b[y][x].r = CLAMP((127 + ((sourceR + image8b[y][x].eR) * 5)) / 255, 0, 5);
-            image8b[y][x].g = CLAMP((127 + ((sourceG + image8b[y][x].eG) * 5)) / 255, 0, 5);
-            image8b[y][x].b = CLAMP((127 + ((sourceB + image8b[y][x].eB) * 5)) / 255, 0, 5);
-            image8b[y][x].a = (sourceA >= 128) ? 0xFF : 0x00;
-
-// Don't dither small sprites, it just doesn't look good
-#if defined(DITHER)
-            /* Find the total error, 8 bits per channel */
-            int teR = sourceR - ((image8b[y][x].r * 255) / 5);
-            int teG = sourceG - ((image8b[y][x].g * 255) / 5);
-            int teB = sourceB - ((image8b[y][x].b * 255) / 5);
-
-            /* Count all the neighbors that haven't been drawn yet */
-            int adjNeighbors = 0;
-            adjNeighbors += isNeighborNotDrawn(image8b, x + 0, y + 1, w, h);
-            adjNeighbors += isNeighborNotDrawn(image8b, x + 0, y - 1, w, h);
-            adjNeighbors += isNeighborNotDrawn(image8b, x + 1, y + 0, w, h);
-            adjNeighbors += isNeighborNotDrawn(image8b, x - 1, y + 0, w, h);
-            int diagNeighbors = 0;
-            diagNeighbors += isNeighborNotDrawn(image8b, x - 1, y - 1, w, h);
-            diagNeighbors += isNeighborNotDrawn(image8b, x + 1, y - 1, w, h);
-            diagNeighbors += isNeighborNotDrawn(image8b, x - 1, y + 1, w, h);
-            diagNeighbors += isNeighborNotDrawn(image8b, x + 1, y + 1, w, h);
-
-            /* Spread the error to all neighboring unquantized pixels, with
-             * twice as much error to the adjacent pixels as the diagonal ones
-             */
-            float diagScalar = 1 / (float)((2 * adjNeighbors) + diagNeighbors);
-            float adjScalar  = 2 * diagScalar;
-
-            /* Write the error */
-            spreadError(image8b, x - 1, y - 1, w, h, teR, teG, teB, diagScalar);
-            spreadError(image8b, x - 1, y + 1, w, h, teR, teG, teB, diagScalar);
-            spreadError(image8b, x + 1, y - 1, w, h, teR, teG, teB, diagScalar);
-            spreadError(image8b, x + 1, y + 1, w, h, teR, teG, teB, diagScalar);
-            spreadError(image8b, x - 1, y + 0, w, h, teR, teG, teB, adjScalar);
-            spreadError(image8b, x + 1, y + 0, w, h, teR, teG, teB, adjScalar);
-            spreadError(image8b, x + 0, y - 1, w, h, teR, teG, teB, adjScalar);
-            spreadError(image8b, x + 0, y + 1, w, h, teR, teG, teB, adjScalar);
-#endif
-
-            /* Mark the random pixel as drawn */
-            image8b[y][x].isDrawn = true;
-        }
-
-        free(indices);
+        /* Reduce it to the palette. Don't dither small sprites by default, it just doesn't look good */
+        uint32_t paletteBufSize   = sizeof(unsigned char) * w * h;
+        unsigned char* paletteBuf = calloc(1, paletteBufSize);
+        ditherImage(data, w, h, paletteBuf, ditherThreads);
 
         /* Free stbi memory */
         stbi_image_free(data);
@@ -236,67 +579,115 @@ void process_image(const char* infile, const char* outdir)
         /* Convert to a pixel buffer */
         unsigned char* pixBuf = (unsigned char*)calloc(w * h * 4, sizeof(unsigned char)); //[w*h*4];
         int pixBufIdx         = 0;
-        for (int y = 0; y < h; y++)
+        for (int i = 0; i < w * h; i++)
         {
-            for (int x = 0; x < w; x++)
-            {
-                pixBuf[pixBufIdx++] = (image8b[y][x].r * 255) / 5;
-                pixBuf[pixBufIdx++] = (image8b[y][x].g * 255) / 5;
-                pixBuf[pixBufIdx++] = (image8b[y][x].b * 255) / 5;
-                pixBuf[pixBufIdx++] = image8b[y][x].a;
-            }
+            uint8_t idx         = (PAL_TRANSPARENT == paletteBuf[i]) ? 0 : paletteBuf[i];
+            pixBuf[pixBufIdx++] = ((idx / 36) * 255) / 5;
+            pixBuf[pixBufIdx++] = (((idx / 6) % 6) * 255) / 5;
+            pixBuf[pixBufIdx++] = ((idx % 6) * 255) / 5;
+            pixBuf[pixBufIdx++] = (PAL_TRANSPARENT == paletteBuf[i]) ? 0x00 : 0xFF;
         }
         /* Write a PNG */
-        char pngOutFilePath[strlen(outFilePath) + 4];
+        char pngOutFilePath[strlen(outFilePath) + 5];
         strcpy(pngOutFilePath, outFilePath);
         strcat(pngOutFilePath, ".png");
         stbi_write_png(pngOutFilePath, w, h, 4, pixBuf, 4 * w);
         free(pixBuf);
 #endif
 
-        /* Convert to a palette buffer */
-        uint32_t paletteBufSize   = sizeof(unsigned char) * w * h;
-        unsigned char* paletteBuf = calloc(1, paletteBufSize);
-        int paletteBufIdx         = 0;
-        for (int y = 0; y < h; y++)
-        {
-            for (int x = 0; x < w; x++)
-            {
-                if (image8b[y][x].a)
-                {
-                    /* Index math! The palette indices increase blue, then green, then red.
-                     * Each has a value 0-5 (six levels)
-                     */
-                    paletteBuf[paletteBufIdx++]
-                        = (image8b[y][x].b) + (6 * (image8b[y][x].g)) + (36 * (image8b[y][x].r));
-                }
-                else
-                {
-                    /* This invalid value means 'transparent' */
-                    paletteBuf[paletteBufIdx++] = 6 * 6 * 6;
-                }
-            }
-        }
-
-        /* Free dithering memory */
-        for (int y = 0; y < h; y++)
-        {
-            free(image8b[y]);
-        }
-        free(image8b);
+        /* Run-length encode images with transparency, if that's smaller. The firmware builds its table of opaque spans
+         * directly from the runs
+         */
+        bool hasTransparency = (NULL != memchr(paletteBuf, PAL_TRANSPARENT, paletteBufSize));
+        uint8_t* rleBuf      = calloc(1, 3 * paletteBufSize);
+        uint32_t rleBufSize  = rleEncodeImage(paletteBuf, w, h, rleBuf);
+        bool useRle          = hasTransparency && (rleBufSize < paletteBufSize);
 
         /* Combine the header and image*/
-        uint32_t hdrAndImgSz = sizeof(uint8_t) * (4 + paletteBufSize);
+        uint32_t imgSz       = useRle ? rleBufSize : paletteBufSize;
+        uint32_t hdrAndImgSz = sizeof(uint8_t) * (4 + imgSz);
         uint8_t* hdrAndImg   = calloc(1, hdrAndImgSz);
-        hdrAndImg[0]         = HI_BYTE(w);
-        hdrAndImg[1]         = LO_BYTE(w);
+        uint16_t hdrW        = useRle ? (w | WSG_RLE_FLAG) : w;
+        hdrAndImg[0]         = HI_BYTE(hdrW);
+        hdrAndImg[1]         = LO_BYTE(hdrW);
         hdrAndImg[2]         = HI_BYTE(h);
         hdrAndImg[3]         = LO_BYTE(h);
-        memcpy(&hdrAndImg[4], paletteBuf, paletteBufSize);
+        memcpy(&hdrAndImg[4], useRle ? rleBuf : paletteBuf, imgSz);
+        free(rleBuf);
         /* Write the compressed file */
-        writeHeatshrinkFile(hdrAndImg, hdrAndImgSz, outFilePath);
+        writeHeatshrinkFile(hdrAndImg, hdrAndImgSz, outFilePath, false);
         /* Cleanup */
         free(hdrAndImg);
         free(paletteBuf);
     }
 }
+
+/**
+ * @brief Get a monotonic time in seconds
+ *
+ * @return The time, in seconds
+ */
+static double getTimeS(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+/**
+ * @brief Measure the throughput of each dither mode on an image, and check that diffusion dithering gives the same
+ * output with one thread as with many
+ *
+ * @param infile The PNG to dither
+ * @param threads The most threads to diffusion dither with
+ * @return true if the outputs matched, false if they didn't or the image couldn't be loaded
+ */
+bool benchmarkDither(const char* infile, int threads)
+{
+    int w, h, n;
+    unsigned char* data = stbi_load(infile, &w, &h, &n, 4);
+    if (NULL == data)
+    {
+        fprintf(stderr, "ERR: image_processor.c: Failed to load %s\n", infile);
+        return false;
+    }
+
+    unsigned char* single = calloc(1, w * h);
+    unsigned char* multi  = calloc(1, w * h);
+    bool match            = true;
+
+    printf("[assets-preprocessor] Dithering %s, %dx%d\n", infile, w, h);
+    ditherMode_t savedMode = ditherMode;
+    for (ditherMode_t mode = 0; mode < DITHER_NUM_MODES; mode++)
+    {
+        ditherMode = mode;
+        for (int t = 1; t <= threads; t = (t == threads) ? (threads + 1) : threads)
+        {
+            /* Dither for at least half a second */
+            int iterations = 0;
+            double start   = getTimeS();
+            double elapsed = 0;
+            do
+            {
+                ditherImage(data, w, h, (1 == t) ? single : multi, t);
+                iterations++;
+                elapsed = getTimeS() - start;
+            } while (elapsed < 0.5);
+
+            printf("[assets-preprocessor] %-8s %2d threads %8.2f Mpx/s\n", ditherModeNames[mode], t,
+                   ((double)w * h * iterations) / (elapsed * 1e6));
+
+            if (1 != t && memcmp(single, multi, w * h))
+            {
+                printf("[assets-preprocessor] %s output differs with %d threads\n", ditherModeNames[mode], t);
+                match = false;
+            }
+        }
+    }
+    ditherMode = savedMode;
+
+    free(single);
+    free(multi);
+    stbi_image_free(data);
+    return match;
+}
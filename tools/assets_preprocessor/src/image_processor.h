@@ -1,6 +1,20 @@
 #ifndef _IMAGE_PROCESSOR_H_
 #define _IMAGE_PROCESSOR_H_
 
+#include <stdbool.h>
+#include <stdint.h>
+
+typedef enum
+{
+    DITHER_NONE,      ///< Round each pixel to the nearest color
+    DITHER_DIFFUSE,   ///< Spread each pixel's error to its neighbors, in a random order
+    DITHER_ORDERED,   ///< Offset each pixel by a 4x4 Bayer matrix
+    DITHER_NUM_MODES, ///< The number of dither modes
+} ditherMode_t;
+
+void setImageDither(ditherMode_t mode, uint32_t seed, int threads);
+bool parseDitherMode(const char* name, ditherMode_t* mode);
 void process_image(const char* infile, const char* outdir);
+bool benchmarkDither(const char* infile, int threads);
 
-#endif /* _IMAGE_PROCESSOR_H_ */
\ No newline at end of file
+#endif /* _IMAGE_PROCESSOR_H_ */
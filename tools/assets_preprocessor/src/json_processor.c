@@ -7,6 +7,7 @@
 #include "cJSON.h"
 #include "heatshrink_encoder.h"
 #include "fileUtils.h"
+#include "assetCache.h"
 #include "heatshrink_util.h"
 
 #define JSON_COMPRESSION
@@ -25,7 +26,7 @@ void process_json(const char* infile, const char* outdir)
     snprintf(&dotptr[1], strlen(dotptr), "hjs");
 #endif
 
-    if (!isSourceFileNewer(infile, outFilePath))
+    if (!shouldProcessFile(infile, outFilePath))
     {
         return;
     }
@@ -50,6 +51,6 @@ void process_json(const char* infile, const char* outdir)
     fwrite(jsonInStr, sz, 1, outFile);
     fclose(outFile);
 #else
-    writeHeatshrinkFile((uint8_t*)jsonInStr, sz, outFilePath);
+    writeHeatshrinkFile((uint8_t*)jsonInStr, sz, outFilePath, false);
 #endif
 }
\ No newline at end of file
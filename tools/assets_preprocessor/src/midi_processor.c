@@ -0,0 +1,689 @@
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include "fileUtils.h"
+#include "assetCache.h"
+#include "heatshrink_util.h"
+#include "raw_processor.h"
+
+#include "midi_processor.h"
+
+/*
+ * Merges all the tracks of a MIDI file into a single track and appends a seek index chunk, so the firmware can read
+ * the next event without comparing tracks and can seek without replaying the whole song. The output is still a valid
+ * Standard MIDI File. See midiSeekIndex_t in midiFileParser.h for how the firmware uses it.
+ *
+ * The seek index chunk (ID "SWix") is big-endian and laid out as:
+ *   u8  version
+ *   u8  number of tracks in the source file
+ *   u16 mask of channels in each snapshot
+ *   u8  number of controllers in each snapshot, followed by the controller numbers
+ *   u16 number of seek points
+ *   u32 length of the track map, followed by the original track index of each merged meta-event
+ *   u16 number of setup events, followed by the u32 offset of each within the merged track
+ *   Seek points, each:
+ *     u32 tick, u32 offset, u32 meta-event index, u24 tempo, u8 running status, u16 setup event count
+ *     For each channel in the mask: bank MSB, bank LSB, program, bend LSB, bend MSB, controller values
+ */
+
+#define SEEK_INDEX_VERSION 1
+
+/// A seek point is added at least this many events apart
+#define SEEK_POINT_INTERVAL 512
+
+/// Snapshot value for a control which was never set
+#define SEEK_UNSET 0xFF
+
+/// Controllers saved in each channel snapshot. Bank select is always saved
+static const uint8_t snapshotCcs[] = {1, 7, 10, 11, 64, 66, 67, 71, 72, 73, 74, 75, 76, 91, 93};
+
+typedef struct
+{
+    uint32_t time;
+    uint32_t seq;
+    uint8_t track;
+    uint8_t status;
+    const uint8_t* data; ///< Bytes following the status byte
+    uint32_t len;
+} srcEvent_t;
+
+typedef struct
+{
+    uint8_t* data;
+    uint32_t len;
+    uint32_t cap;
+} byteBuf_t;
+
+typedef struct
+{
+    uint8_t bank[2];
+    uint8_t program;
+    uint8_t bend[2];
+    uint8_t cc[sizeof(snapshotCcs)];
+} channelState_t;
+
+static bool bufPut(byteBuf_t* buf, const void* data, uint32_t len);
+static bool bufByte(byteBuf_t* buf, uint8_t b);
+static bool bufBe(byteBuf_t* buf, uint32_t val, int bytes);
+static bool bufVarLen(byteBuf_t* buf, uint32_t val);
+static int readVarLen(const uint8_t* p, const uint8_t* end, uint32_t* out);
+static bool parseTrack(const uint8_t* p, uint32_t len, uint8_t track, srcEvent_t** events, uint32_t* count,
+                       uint32_t* cap, uint32_t* endTime);
+static int compareEvents(const void* a, const void* b);
+static bool isSetupEvent(const srcEvent_t* ev);
+static void updateState(channelState_t* chans, uint32_t* tempo, const srcEvent_t* ev);
+static bool mergeMidi(const uint8_t* in, uint32_t inLen, byteBuf_t* out);
+
+/**
+ * @brief Append bytes to a growable buffer
+ *
+ * @param buf The buffer to append to
+ * @param data The bytes to append
+ * @param len The number of bytes to append
+ * @return true if the bytes were appended, false if memory couldn't be allocated
+ */
+static bool bufPut(byteBuf_t* buf, const void* data, uint32_t len)
+{
+    if (buf->len + len > buf->cap)
+    {
+        uint32_t newCap = buf->cap ? buf->cap : 1024;
+        while (newCap < buf->len + len)
+        {
+            newCap *= 2;
+        }
+
+        uint8_t* newData = realloc(buf->data, newCap);
+        if (!newData)
+        {
+            return false;
+        }
+        buf->data = newData;
+        buf->cap  = newCap;
+    }
+
+    memcpy(&buf->data[buf->len], data, len);
+    buf->len += len;
+    return true;
+}
+
+/**
+ * @brief Append a single byte to a growable buffer
+ *
+ * @param buf The buffer to append to
+ * @param b The byte to append
+ * @return true if the byte was appended, false if memory couldn't be allocated
+ */
+static bool bufByte(byteBuf_t* buf, uint8_t b)
+{
+    return bufPut(buf, &b, 1);
+}
+
+/**
+ * @brief Append a big-endian integer to a growable buffer
+ *
+ * @param buf The buffer to append to
+ * @param val The value to append
+ * @param bytes The number of bytes to write, from 1 to 4
+ * @return true if the value was appended, false if memory couldn't be allocated
+ */
+static bool bufBe(byteBuf_t* buf, uint32_t val, int bytes)
+{
+    uint8_t tmp[4];
+    for (int i = 0; i < bytes; i++)
+    {
+        tmp[i] = (val >> (8 * (bytes - 1 - i))) & 0xFF;
+    }
+    return bufPut(buf, tmp, bytes);
+}
+
+/**
+ * @brief Append a MIDI variable length quantity to a growable buffer
+ *
+ * @param buf The buffer to append to
+ * @param val The value to append
+ * @return true if the value was appended, false if memory couldn't be allocated
+ */
+static bool bufVarLen(byteBuf_t* buf, uint32_t val)
+{
+    uint8_t tmp[5];
+    int n = 0;
+    for (int shift = 28; shift > 0; shift -= 7)
+    {
+        if (n || (val >> shift))
+        {
+            tmp[n++] = 0x80 | ((val >> shift) & 0x7F);
+        }
+    }
+    tmp[n++] = val & 0x7F;
+    return bufPut(buf, tmp, n);
+}
+
+/**
+ * @brief Read a MIDI variable length quantity
+ *
+ * @param p The bytes to read from
+ * @param end The end of the readable bytes
+ * @param[out] out The value read
+ * @return The number of bytes read, or 0 if the quantity was invalid or truncated
+ */
+static int readVarLen(const uint8_t* p, const uint8_t* end, uint32_t* out)
+{
+    uint32_t val = 0;
+    for (int i = 0; i < 4 && p + i < end; i++)
+    {
+        val = (val << 7) | (p[i] & 0x7F);
+        if (!(p[i] & 0x80))
+        {
+            *out = val;
+            return i + 1;
+        }
+    }
+    return 0;
+}
+
+/**
+ * @brief Parse all the events in a track chunk, resolving running status and absolute times
+ *
+ * End of track events are not added, but their time is saved in endTime
+ *
+ * @param p The track chunk data
+ * @param len The length of the track chunk data
+ * @param track The index of this track
+ * @param events The array of events to append to, reallocated as needed
+ * @param count The number of events in the array
+ * @param cap The capacity of the array
+ * @param endTime Updated with the end time of this track, if it is later
+ * @return true if the track was parsed, false if it was malformed
+ */
+static bool parseTrack(const uint8_t* p, uint32_t len, uint8_t track, srcEvent_t** events, uint32_t* count,
+                       uint32_t* cap, uint32_t* endTime)
+{
+    const uint8_t* end = p + len;
+    uint32_t time      = 0;
+    uint8_t running    = 0;
+
+    while (p < end)
+    {
+        uint32_t delta;
+        int read = readVarLen(p, end, &delta);
+        if (!read)
+        {
+            return false;
+        }
+        p += read;
+        time += delta;
+
+        if (p >= end)
+        {
+            return false;
+        }
+
+        uint8_t status = *p;
+        if (status & 0x80)
+        {
+            p++;
+            running = (status < 0xF0) ? status : 0;
+        }
+        else if (running)
+        {
+            status = running;
+        }
+        else
+        {
+            return false;
+        }
+
+        uint32_t n;
+        bool endOfTrack = false;
+        switch (status & 0xF0)
+        {
+            case 0xC0:
+            case 0xD0:
+            {
+                n = 1;
+                break;
+            }
+            case 0xF0:
+            {
+                uint32_t dataLen;
+                if (status == 0xFF)
+                {
+                    if (p >= end)
+                    {
+                        return false;
+                    }
+                    read = readVarLen(p + 1, end, &dataLen);
+                    if (!read)
+                    {
+                        return false;
+                    }
+                    endOfTrack = (p[0] == 0x2F);
+                    n          = 1 + read + dataLen;
+                }
+                else if (status == 0xF0 || status == 0xF7)
+                {
+                    read = readVarLen(p, end, &dataLen);
+                    if (!read)
+                    {
+                        return false;
+                    }
+                    n = read + dataLen;
+                }
+                else
+                {
+                    return false;
+                }
+                break;
+            }
+            default:
+            {
+                n = 2;
+                break;
+            }
+        }
+
+        if ((uint32_t)(end - p) < n)
+        {
+            return false;
+        }
+
+        if (time > *endTime)
+        {
+            *endTime = time;
+        }
+
+        if (endOfTrack)
+        {
+            return true;
+        }
+
+        if (*count == *cap)
+        {
+            uint32_t newCap       = *cap ? *cap * 2 : 1024;
+            srcEvent_t* newEvents = realloc(*events, newCap * sizeof(srcEvent_t));
+            if (!newEvents)
+            {
+                return false;
+            }
+            *events = newEvents;
+            *cap    = newCap;
+        }
+
+        srcEvent_t* ev = &(*events)[(*count)];
+        ev->time       = time;
+        ev->seq        = *count;
+        ev->track      = track;
+        ev->status     = status;
+        ev->data       = p;
+        ev->len        = n;
+        (*count)++;
+
+        p += n;
+    }
+
+    return true;
+}
+
+/**
+ * @brief qsort() comparator which orders events by time, then track, then original order
+ */
+static int compareEvents(const void* a, const void* b)
+{
+    const srcEvent_t* evA = a;
+    const srcEvent_t* evB = b;
+
+    if (evA->time != evB->time)
+    {
+        return (evA->time < evB->time) ? -1 : 1;
+    }
+    if (evA->track != evB->track)
+    {
+        return evA->track - evB->track;
+    }
+    return (evA->seq < evB->seq) ? -1 : (evA->seq > evB->seq);
+}
+
+/**
+ * @brief Check if an event changes state which a channel snapshot can't capture, so it must be replayed after seeking
+ *
+ * @param ev The event to check
+ * @return true if this is SysEx, a parameter selection or data entry, or a controller reset
+ */
+static bool isSetupEvent(const srcEvent_t* ev)
+{
+    if (ev->status == 0xF0 || ev->status == 0xF7)
+    {
+        return true;
+    }
+
+    if ((ev->status & 0xF0) == 0xB0)
+    {
+        switch (ev->data[0])
+        {
+            case 6:   // Data entry MSB
+            case 38:  // Data entry LSB
+            case 96:  // Data increment
+            case 97:  // Data decrement
+            case 98:  // NRPN LSB
+            case 99:  // NRPN MSB
+            case 100: // RPN LSB
+            case 101: // RPN MSB
+            case 121: // Reset all controllers
+            {
+                return true;
+            }
+            default:
+            {
+                break;
+            }
+        }
+    }
+    return false;
+}
+
+/**
+ * @brief Update the running channel snapshots and tempo with an event
+ *
+ * @param chans The 16 channel snapshots
+ * @param tempo The current tempo
+ * @param ev The event to apply
+ */
+static void updateState(channelState_t* chans, uint32_t* tempo, const srcEvent_t* ev)
+{
+    if (ev->status == 0xFF)
+    {
+        // Tempo is FF 51 03 tt tt tt
+        if (ev->data[0] == 0x51 && ev->len == 5)
+        {
+            *tempo = (ev->data[2] << 16) | (ev->data[3] << 8) | ev->data[4];
+            if (*tempo == 0)
+            {
+                *tempo = 500000;
+            }
+        }
+        return;
+    }
+
+    if (ev->status == 0xF0 && ev->len >= 5 && ev->data[1] == 0x7E && ev->data[3] == 0x09)
+    {
+        // General MIDI on or off resets everything, and the SysEx will be replayed after seeking
+        memset(chans, SEEK_UNSET, 16 * sizeof(channelState_t));
+        return;
+    }
+
+    channelState_t* chan = &chans[ev->status & 0x0F];
+    switch (ev->status & 0xF0)
+    {
+        case 0xB0:
+        {
+            if (ev->data[0] == 0)
+            {
+                chan->bank[0] = ev->data[1];
+            }
+            else if (ev->data[0] == 32)
+            {
+                chan->bank[1] = ev->data[1];
+            }
+            else if (ev->data[0] == 121)
+            {
+                // Resetting controllers resets everything but the bank, and it will be replayed after seeking
+                uint8_t bank[2] = {chan->bank[0], chan->bank[1]};
+                memset(chan, SEEK_UNSET, sizeof(channelState_t));
+                memcpy(chan->bank, bank, sizeof(bank));
+            }
+            else
+            {
+                for (int i = 0; i < sizeof(snapshotCcs); i++)
+                {
+                    if (snapshotCcs[i] == ev->data[0])
+                    {
+                        chan->cc[i] = ev->data[1];
+                        break;
+                    }
+                }
+            }
+            break;
+        }
+        case 0xC0:
+        {
+            chan->program = ev->data[0];
+            break;
+        }
+        case 0xE0:
+        {
+            chan->bend[0] = ev->data[0];
+            chan->bend[1] = ev->data[1];
+            break;
+        }
+        default:
+        {
+            break;
+        }
+    }
+}
+
+/**
+ * @brief Merge the tracks of a MIDI file and append a seek index
+ *
+ * @param in The MIDI file data
+ * @param inLen The length of the MIDI file data
+ * @param out The buffer to write the merged MIDI file to
+ * @return true if the file was merged, false if it is not a MIDI file which can be merged
+ */
+static bool mergeMidi(const uint8_t* in, uint32_t inLen, byteBuf_t* out)
+{
+    if (inLen < 14 || memcmp(in, "MThd", 4))
+    {
+        return false;
+    }
+
+    uint32_t headerLen  = (in[4] << 24) | (in[5] << 16) | (in[6] << 8) | in[7];
+    uint16_t format     = (in[8] << 8) | in[9];
+    uint16_t trackCount = (in[10] << 8) | in[11];
+    uint16_t division   = (in[12] << 8) | in[13];
+
+    // Format 2 tracks are played one after the other, so they can't be merged
+    if (format > 1 || trackCount == 0 || trackCount > 255)
+    {
+        return false;
+    }
+
+    // Some tools count the chunk header in the header length, so only trust it if a track follows
+    if (headerLen < 6 || headerLen > inLen - 16 || memcmp(in + 8 + headerLen, "MTrk", 4))
+    {
+        headerLen = 6;
+    }
+
+    // Parse every track
+    srcEvent_t* events = NULL;
+    uint32_t count = 0, cap = 0, endTime = 0;
+    const uint8_t* p   = in + 8 + headerLen;
+    const uint8_t* end = in + inLen;
+    uint8_t track      = 0;
+    while (track < trackCount && end - p >= 8)
+    {
+        uint32_t chunkLen = (p[4] << 24) | (p[5] << 16) | (p[6] << 8) | p[7];
+        if (chunkLen > (uint32_t)(end - p) - 8)
+        {
+            chunkLen = (uint32_t)(end - p) - 8;
+        }
+
+        if (!memcmp(p, "MTrk", 4))
+        {
+            if (!parseTrack(p + 8, chunkLen, track, &events, &count, &cap, &endTime))
+            {
+                free(events);
+                return false;
+            }
+            track++;
+        }
+        p += 8 + chunkLen;
+    }
+
+    qsort(events, count, sizeof(srcEvent_t), compareEvents);
+
+    // Find the channels which are used
+    uint16_t channelMask = 0;
+    for (uint32_t i = 0; i < count; i++)
+    {
+        if (events[i].status < 0xF0)
+        {
+            channelMask |= (1 << (events[i].status & 0x0F));
+        }
+    }
+
+    // Write the merged track and the seek points
+    byteBuf_t trk = {0}, points = {0}, setups = {0};
+    uint8_t* trackMap = malloc(count ? count : 1);
+    bool ok           = (NULL != trackMap);
+
+    channelState_t chans[16];
+    memset(chans, SEEK_UNSET, sizeof(chans));
+    uint32_t tempo      = 500000;
+    uint32_t lastTime   = 0;
+    uint8_t running     = 0;
+    uint32_t pointCount = 0;
+    uint32_t setupCount = 0;
+    uint32_t lastPoint  = 0;
+    uint32_t metaCount  = 0;
+
+    for (uint32_t i = 0; ok && i < count; i++)
+    {
+        const srcEvent_t* ev = &events[i];
+
+        if (i - lastPoint >= SEEK_POINT_INTERVAL && pointCount < UINT16_MAX && setupCount < UINT16_MAX)
+        {
+            ok = ok && bufBe(&points, lastTime, 4) && bufBe(&points, trk.len, 4) && bufBe(&points, metaCount, 4)
+                 && bufBe(&points, tempo, 3) && bufByte(&points, running) && bufBe(&points, setupCount, 2);
+            for (int ch = 0; ch < 16; ch++)
+            {
+                if (channelMask & (1 << ch))
+                {
+                    ok = ok && bufPut(&points, &chans[ch], sizeof(channelState_t));
+                }
+            }
+            pointCount++;
+            lastPoint = i;
+        }
+
+        bool setup = isSetupEvent(ev);
+        if (setup)
+        {
+            // Setup events always have an explicit status so they can be parsed on their own. Only the first 65535
+            // can be indexed, and no more seek points are added after that
+            if (setupCount < UINT16_MAX)
+            {
+                ok = ok && bufBe(&setups, trk.len, 4);
+            }
+            setupCount++;
+        }
+
+        ok = ok && bufVarLen(&trk, ev->time - lastTime);
+        if (setup || ev->status >= 0xF0 || ev->status != running)
+        {
+            ok = ok && bufByte(&trk, ev->status);
+        }
+        ok = ok && bufPut(&trk, ev->data, ev->len);
+
+        running     = (ev->status < 0xF0) ? ev->status : 0;
+        lastTime    = ev->time;
+        if (ev->status == 0xFF)
+        {
+            trackMap[metaCount++] = ev->track;
+        }
+        updateState(chans, &tempo, ev);
+    }
+
+    // Finish with a single end of track
+    static const uint8_t endOfTrack[] = {0xFF, 0x2F, 0x00};
+    ok = ok && bufVarLen(&trk, (endTime > lastTime) ? (endTime - lastTime) : 0)
+         && bufPut(&trk, endOfTrack, sizeof(endOfTrack));
+
+    setupCount = setups.len / 4;
+
+    // Only keep the track map if there were multiple tracks
+    uint32_t mapLength = (trackCount > 1) ? metaCount : 0;
+
+    // Header chunk, always format 0 with one track
+    ok = ok && bufPut(out, "MThd", 4) && bufBe(out, 6, 4) && bufBe(out, 0, 2) && bufBe(out, 1, 2)
+         && bufBe(out, division, 2);
+
+    // Merged track chunk
+    ok = ok && bufPut(out, "MTrk", 4) && bufBe(out, trk.len, 4) && bufPut(out, trk.data, trk.len);
+
+    // Seek index chunk
+    uint32_t indexLen = 5 + sizeof(snapshotCcs) + 2 + 4 + mapLength + 2 + setups.len + points.len;
+    ok = ok && bufPut(out, "SWix", 4) && bufBe(out, indexLen, 4) && bufByte(out, SEEK_INDEX_VERSION)
+         && bufByte(out, trackCount) && bufBe(out, channelMask, 2) && bufByte(out, sizeof(snapshotCcs))
+         && bufPut(out, snapshotCcs, sizeof(snapshotCcs)) && bufBe(out, pointCount, 2) && bufBe(out, mapLength, 4)
+         && bufPut(out, trackMap, mapLength) && bufBe(out, setupCount, 2) && bufPut(out, setups.data, setups.len)
+         && bufPut(out, points.data, points.len);
+
+    free(events);
+    free(trackMap);
+    free(trk.data);
+    free(points.data);
+    free(setups.data);
+    return ok;
+}
+
+void process_midi(const char* inFile, const char* outDir)
+{
+    // Determine if the output file already exists
+    char outFilePath[128] = {0};
+    strcat(outFilePath, outDir);
+    strcat(outFilePath, "/");
+    strcat(outFilePath, get_filename(inFile));
+
+    // Change the file extension
+    char* dotPtr = strrchr(outFilePath, '.');
+    strncpy(&dotPtr[1], "mid", sizeof(outFilePath) - (dotPtr - outFilePath) - 1);
+
+    if (!shouldProcessFile(inFile, outFilePath))
+    {
+        return;
+    }
+    else if (doesFileExist(outFilePath))
+    {
+        printf("[assets-preprocessor] %s modified! Regenerating %s\n", inFile, get_filename(outFilePath));
+    }
+
+    // Read input file
+    errno    = 0;
+    FILE* fp = fopen(inFile, "rb");
+    if (!fp)
+    {
+        fprintf(stderr, "ERR: midi_processor.c: Failed to open file %s: %d - %s\n", inFile, errno, strerror(errno));
+        return;
+    }
+
+    fseek(fp, 0L, SEEK_END);
+    long sz = ftell(fp);
+    fseek(fp, 0L, SEEK_SET);
+    uint8_t* byteString = malloc(sz + 1);
+    if (!byteString || fread(byteString, 1, sz, fp) < sz)
+    {
+        fprintf(stderr, "ERR: midi_processor.c: Failed to read file %s\n", inFile);
+        free(byteString);
+        fclose(fp);
+        return;
+    }
+    fclose(fp);
+
+    byteBuf_t merged = {0};
+    if (mergeMidi(byteString, sz, &merged))
+    {
+        writeHeatshrinkFile(merged.data, merged.len, outFilePath, true);
+    }
+    else
+    {
+        // Fall back to compressing the file as-is
+        printf("[assets-preprocessor] %s can't be merged, storing it unchanged\n", inFile);
+        process_raw(inFile, outDir, "mid");
+    }
+
+    free(merged.data);
+    free(byteString);
+}
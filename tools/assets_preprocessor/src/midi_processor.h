@@ -0,0 +1,3 @@
+#pragma once
+
+void process_midi(const char* inFile, const char* outDir);
@@ -4,6 +4,7 @@
 #include <string.h>
 #include <errno.h>
 #include "fileUtils.h"
+#include "assetCache.h"
 #include "heatshrink_util.h"
 
 #include "raw_processor.h"
@@ -20,7 +21,7 @@ void process_raw(const char* inFile, const char* outDir, const char* outExt)
     char* dotPtr = strrchr(outFilePath, '.');
     strncpy(&dotPtr[1], outExt, sizeof(outFilePath) - (dotPtr - outFilePath) - 1);
 
-    if (!isSourceFileNewer(inFile, outFilePath))
+    if (!shouldProcessFile(inFile, outFilePath))
     {
         return;
     }
@@ -66,8 +67,8 @@ void process_raw(const char* inFile, const char* outDir, const char* outExt)
     byteString[sz] = 0;
     fclose(fp);
 
-    // Write the compressed bytes to a file
-    writeHeatshrinkFile(byteString, sz, outFilePath);
+    // Write the compressed bytes to a file. MIDI files are streamed, not loaded whole
+    writeHeatshrinkFile(byteString, sz, outFilePath, 0 == strcmp(outExt, "mid"));
 
     // Cleanup
     free(byteString);
@@ -6,6 +6,7 @@
 #include "rmd_processor.h"
 #include "heatshrink_encoder.h"
 #include "fileUtils.h"
+#include "assetCache.h"
 #include "heatshrink_util.h"
 
 void process_rmd(const char* infile, const char* outdir)
@@ -20,7 +21,7 @@ void process_rmd(const char* infile, const char* outdir)
     char* dotptr = strrchr(outFilePath, '.');
     snprintf(&dotptr[1], strlen(dotptr), "rmh");
 
-    if(!isSourceFileNewer(infile, outFilePath))
+    if(!shouldProcessFile(infile, outFilePath))
     {
         return;
     }
@@ -39,5 +40,5 @@ void process_rmd(const char* infile, const char* outdir)
     rmdInStr[sz] = 0;
     fclose(fp);
 
-    writeHeatshrinkFile((uint8_t*)rmdInStr, sz, outFilePath);
+    writeHeatshrinkFile((uint8_t*)rmdInStr, sz, outFilePath, false);
 }
\ No newline at end of file
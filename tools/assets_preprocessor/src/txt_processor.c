@@ -6,6 +6,7 @@
 #include "txt_processor.h"
 #include "heatshrink_encoder.h"
 #include "fileUtils.h"
+#include "assetCache.h"
 
 long remove_chars(char* str, long len, char c);
 
@@ -41,7 +42,7 @@ void process_txt(const char* infile, const char* outdir)
     strcat(outFilePath, "/");
     strcat(outFilePath, get_filename(infile));
 
-    if (!isSourceFileNewer(infile, outFilePath))
+    if (!shouldProcessFile(infile, outFilePath))
     {
         return;
     }
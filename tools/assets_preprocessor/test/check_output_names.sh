@@ -0,0 +1,37 @@
+#!/bin/bash
+# Check that every source file produces the output file the firmware loads. Run with "make check"
+
+set -e
+
+TOOL="$(dirname "$0")/../assets_preprocessor"
+WORK="$(mktemp -d)"
+trap 'rm -rf "$WORK"' EXIT
+
+mkdir -p "$WORK/in/a" "$WORK/in/b" "$WORK/out"
+
+# Names with a dot before the extension share a stem, but write different files
+printf 'one' > "$WORK/in/a/Dr.Name Home.raw"
+printf 'two' > "$WORK/in/a/Dr.Name Home2.raw"
+# The same name in two directories writes one file, from the last source in path order
+printf 'first' > "$WORK/in/a/same.txt"
+printf 'second' > "$WORK/in/b/same.txt"
+
+"$TOOL" -i "$WORK/in" -o "$WORK/out" -j 2 > /dev/null 2>&1
+
+FAILED=0
+for EXPECTED in "Dr.Name Home.raw" "Dr.Name Home2.raw" "same.txt"; do
+    if [ ! -f "$WORK/out/$EXPECTED" ]; then
+        echo "FAIL: $EXPECTED was not written"
+        FAILED=1
+    fi
+done
+
+if [ "second" != "$(tr -d '\0' < "$WORK/out/same.txt" 2> /dev/null)" ]; then
+    echo "FAIL: same.txt wasn't written from the last source in path order"
+    FAILED=1
+fi
+
+if [ 0 -eq $FAILED ]; then
+    echo "PASS"
+fi
+exit $FAILED
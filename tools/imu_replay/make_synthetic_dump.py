@@ -0,0 +1,126 @@
+#!/usr/bin/env python3
+"""
+Make a synthetic IMU FIFO dump for the emulator's --imu-replay option.
+
+The dump has the same format as a capture from a Swadge built with CONFIG_IMU_FIFO_DUMP: six little endian int16 words
+per sample at 208 Hz, the gyro's XYZ and then the accelerometer's XYZ. A made up motion is integrated, and the gyro
+and accelerometer readings it would cause are written out with a gyro bias, sensor noise, and shaking added.
+
+Usage: make_synthetic_dump.py OUTPUT
+"""
+
+import math
+import random
+import struct
+import sys
+
+SAMPLE_RATE = 208
+# Matches IMU_GYRO_SCALE in imu_fusion.h, radians per sample per count
+GYRO_SCALE = (2000.0 / 32768.0 / 208.0 * 2.0 * 3.14159 / 180.0) * 0.5625
+# Counts per g at 16 g full scale
+ACCEL_ONE_G = 2048
+
+
+def euler_to_quat(e):
+    """The same convention as mathEulerToQuat()"""
+    cr, sr = math.cos(e[0] * 0.5), math.sin(e[0] * 0.5)
+    cp, sp = math.cos(e[1] * 0.5), math.sin(e[1] * 0.5)
+    cy, sy = math.cos(e[2] * 0.5), math.sin(e[2] * 0.5)
+    return [
+        cr * cp * cy + sr * sp * sy,
+        sr * cp * cy - cr * sp * sy,
+        cr * sp * cy + sr * cp * sy,
+        cr * cp * sy - sr * sp * cy,
+    ]
+
+
+def quat_apply(a, b):
+    """The same as mathQuatApply()"""
+    return [
+        a[0] * b[0] - a[1] * b[1] - a[2] * b[2] - a[3] * b[3],
+        a[0] * b[1] + a[1] * b[0] + a[2] * b[3] - a[3] * b[2],
+        a[0] * b[2] - a[1] * b[3] + a[2] * b[0] + a[3] * b[1],
+        a[0] * b[3] + a[1] * b[2] - a[2] * b[1] + a[3] * b[0],
+    ]
+
+
+def quat_normalize(q):
+    mag = math.sqrt(sum(c * c for c in q))
+    return [c / mag for c in q]
+
+
+def cross(a, b):
+    return [a[1] * b[2] - a[2] * b[1], a[2] * b[0] - a[0] * b[2], a[0] * b[1] - a[1] * b[0]]
+
+
+def rotate_by_inverse(q, p):
+    """The same as mathRotateVectorByInverseOfQuaternion()"""
+    iqo = cross(p, q[1:])
+    iqo = [iqo[i] + q[0] * p[i] for i in range(3)]
+    ret = cross(iqo, q[1:])
+    return [ret[i] * 2 + p[i] for i in range(3)]
+
+
+def angular_velocity(t, rng, state):
+    """The made up motion, in radians per second about each axis, and any linear acceleration in g"""
+    shake = [0.0, 0.0, 0.0]
+    if t < 3:
+        # Sitting still
+        w = [0.0, 0.0, 0.0]
+    elif t < 15:
+        # Slow tilting back and forth
+        w = [0.8 * math.sin(t * 1.1), 0.5 * math.sin(t * 0.7 + 1), 0.6 * math.cos(t * 0.9)]
+    elif t < 25:
+        # Spinning flat on a table, about 570 degrees per second
+        w = [0.0, 10.0 * math.sin(math.pi * (t - 15) / 10), 0.0]
+    elif t < 35:
+        # Shaking
+        w = [2.0 * math.sin(t * 31), 1.5 * math.sin(t * 23), 2.5 * math.cos(t * 29)]
+        shake = [1.5 * math.sin(t * 33), 1.0 * math.cos(t * 27), 1.2 * math.sin(t * 35 + 2)]
+    elif t < 50:
+        # Waving around, a smoothed random walk
+        for i in range(3):
+            state[i] = 0.995 * state[i] + rng.gauss(0, 0.15)
+        w = list(state)
+    else:
+        # Sitting still again
+        w = [0.0, 0.0, 0.0]
+    return w, shake
+
+
+def main():
+    if len(sys.argv) != 2:
+        print(__doc__)
+        sys.exit(1)
+
+    rng = random.Random(2025)
+    bias = [1.5e-5, -2.5e-5, 0.8e-5]
+    q = [1.0, 0.0, 0.0, 0.0]
+    state = [0.0, 0.0, 0.0]
+
+    with open(sys.argv[1], "wb") as out:
+        for n in range(60 * SAMPLE_RATE):
+            w, shake = angular_velocity(n / SAMPLE_RATE, rng, state)
+            e = [c / SAMPLE_RATE for c in w]
+            q = quat_normalize(quat_apply(q, euler_to_quat(e)))
+
+            # The fusion computes its euler angles as {-g[0], g[1], -g[2]} * GYRO_SCALE + bias
+            gyro = [
+                -(e[0] - bias[0]) / GYRO_SCALE,
+                (e[1] - bias[1]) / GYRO_SCALE,
+                -(e[2] - bias[2]) / GYRO_SCALE,
+            ]
+            gyro = [g + rng.gauss(0, 2) for g in gyro]
+
+            # The fusion computes "up" as {-a[0], a[1], -a[2]}
+            up = rotate_by_inverse(q, [0, 1, 0])
+            up = [up[i] + shake[i] for i in range(3)]
+            accel = [-up[0] * ACCEL_ONE_G, up[1] * ACCEL_ONE_G, -up[2] * ACCEL_ONE_G]
+            accel = [a + rng.gauss(0, 8) for a in accel]
+
+            words = [max(-32768, min(32767, int(round(v)))) for v in gyro + accel]
+            out.write(struct.pack("<6h", *words))
+
+
+if __name__ == "__main__":
+    main()